@@ -70,4 +70,15 @@ struct oio_cache_s * oio_cache_make_LRU (struct lru_tree_s *lru);
 struct oio_cache_s * oio_cache_make_multilayer (GSList *caches);
 struct oio_cache_s * oio_cache_make_multilayer_var (struct oio_cache_s *first, ...);
 
+/* Returns a cache whose entries live in the memory-mapped file at <path>,
+ * shared by all the processes that open it with the same <nb_slots>. The
+ * entries expire after <ttl> seconds (never if 0) and the oldest are
+ * evicted when there is no room left. Entries whose key and value weight
+ * more than about 500 bytes are refused. The file should be on a tmpfs
+ * (e.g. /dev/shm) so that it does not survive a reboot.
+ * Returns NULL if the file cannot be mapped or was created with another
+ * geometry. */
+struct oio_cache_s * oio_cache_make_shm (const char *path, guint nb_slots,
+		time_t ttl);
+
 #endif /*OIO_SDS__cache__cache_h*/
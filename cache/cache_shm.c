@@ -0,0 +1,365 @@
+/*
+OpenIO SDS cache
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+
+#include <metautils/lib/metautils.h>
+
+#include "cache.h"
+
+/* The file starts with a header, padded to a page, then come the sets.
+ * Each set is a fixed array of slots guarded by a process-shared mutex,
+ * a key may only live in the set its hash points to. When a set is full,
+ * the entry that would expire first is evicted. */
+
+#define SHM_MAGIC 0x4F494F43 /* "OIOC" */
+#define SHM_VERSION 1
+
+#define SHM_HEADER_SIZE 4096
+#define SHM_SLOT_SIZE 512
+#define SHM_WAYS 8
+
+struct shm_header_s
+{
+	guint32 magic;
+	guint32 version;
+	guint32 nb_sets;
+	guint32 slot_size;
+	guint32 ways;
+};
+
+struct shm_slot_s
+{
+	gint64 expire; /* 0 for a free slot */
+	guint32 hash;
+	guint16 klen;
+	guint16 vlen;
+	gchar data[SHM_SLOT_SIZE - 16]; /* key then value, no NUL */
+};
+
+struct shm_set_s
+{
+	union {
+		pthread_mutex_t lock;
+		guint8 pad[64];
+	};
+	struct shm_slot_s slots[SHM_WAYS];
+};
+
+struct oio_cache_shm_s;
+
+static void _shm_destroy (struct oio_cache_s *self);
+static enum oio_cache_status_e _shm_put (struct oio_cache_s *self, const char *k, const char *v);
+static enum oio_cache_status_e _shm_del (struct oio_cache_s *self, const char *k);
+static enum oio_cache_status_e _shm_get (struct oio_cache_s *self, const char *k, gchar **out);
+
+static struct oio_cache_vtable_s vtable_shm =
+{
+	_shm_destroy, _shm_put, _shm_del, _shm_get
+};
+
+struct oio_cache_shm_s
+{
+	const struct oio_cache_vtable_s *vtable;
+	guint8 *base;
+	gsize size;
+	struct shm_set_s *sets;
+	guint32 nb_sets;
+	time_t ttl;
+};
+
+static gsize
+_shm_size (guint32 nb_sets)
+{
+	return SHM_HEADER_SIZE + ((gsize)nb_sets) * sizeof(struct shm_set_s);
+}
+
+static gboolean
+_shm_init (guint8 *base, guint32 nb_sets)
+{
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init (&attr);
+	pthread_mutexattr_setpshared (&attr, PTHREAD_PROCESS_SHARED);
+	pthread_mutexattr_setrobust (&attr, PTHREAD_MUTEX_ROBUST);
+
+	struct shm_set_s *sets = (struct shm_set_s*) (base + SHM_HEADER_SIZE);
+	for (guint32 i = 0; i < nb_sets; ++i) {
+		if (0 != pthread_mutex_init (&sets[i].lock, &attr)) {
+			pthread_mutexattr_destroy (&attr);
+			return FALSE;
+		}
+	}
+	pthread_mutexattr_destroy (&attr);
+
+	/* The header comes last: a file with a valid header is usable */
+	struct shm_header_s *hdr = (struct shm_header_s*) base;
+	hdr->nb_sets = nb_sets;
+	hdr->slot_size = SHM_SLOT_SIZE;
+	hdr->ways = SHM_WAYS;
+	hdr->version = SHM_VERSION;
+	hdr->magic = SHM_MAGIC;
+	return TRUE;
+}
+
+static gboolean
+_shm_check (const guint8 *base, guint32 nb_sets)
+{
+	const struct shm_header_s *hdr = (const struct shm_header_s*) base;
+	return hdr->magic == SHM_MAGIC
+		&& hdr->version == SHM_VERSION
+		&& hdr->nb_sets == nb_sets
+		&& hdr->slot_size == SHM_SLOT_SIZE
+		&& hdr->ways == SHM_WAYS;
+}
+
+/* The first process to come creates and initiates the file, under an
+ * exclusive lock so that the others wait for a usable header. */
+static guint8 *
+_shm_map (const char *path, guint32 nb_sets)
+{
+	const gsize size = _shm_size (nb_sets);
+	guint8 *base = NULL;
+	struct stat st;
+
+	int fd = open (path, O_RDWR|O_CREAT|O_CLOEXEC, 0600);
+	if (fd < 0) {
+		GRID_WARN("SHM cache [%s] open error: (%d) %s", path,
+				errno, strerror(errno));
+		return NULL;
+	}
+	if (0 > flock (fd, LOCK_EX)) {
+		GRID_WARN("SHM cache [%s] lock error: (%d) %s", path,
+				errno, strerror(errno));
+		goto exit;
+	}
+	if (0 > fstat (fd, &st)) {
+		GRID_WARN("SHM cache [%s] stat error: (%d) %s", path,
+				errno, strerror(errno));
+		goto exit;
+	}
+
+	const gboolean fresh = (st.st_size == 0);
+	if (fresh && 0 > ftruncate (fd, size)) {
+		GRID_WARN("SHM cache [%s] truncate error: (%d) %s", path,
+				errno, strerror(errno));
+		goto exit;
+	}
+	if (!fresh && (gsize)st.st_size != size) {
+		GRID_WARN("SHM cache [%s] size mismatch (%"G_GINT64_FORMAT
+				" vs. %"G_GSIZE_FORMAT")", path, (gint64)st.st_size, size);
+		goto exit;
+	}
+
+	base = mmap (NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+		GRID_WARN("SHM cache [%s] mmap error: (%d) %s", path,
+				errno, strerror(errno));
+		base = NULL;
+		goto exit;
+	}
+
+	if (fresh ? !_shm_init (base, nb_sets) : !_shm_check (base, nb_sets)) {
+		GRID_WARN("SHM cache [%s] invalid or incompatible", path);
+		munmap (base, size);
+		base = NULL;
+	}
+
+exit:
+	flock (fd, LOCK_UN);
+	close (fd);
+	return base;
+}
+
+struct oio_cache_s *
+oio_cache_make_shm (const char *path, guint nb_slots, time_t ttl)
+{
+	EXTRA_ASSERT (path != NULL);
+	const guint32 nb_sets = MAX(1, (nb_slots + SHM_WAYS - 1) / SHM_WAYS);
+
+	guint8 *base = _shm_map (path, nb_sets);
+	if (!base)
+		return NULL;
+
+	struct oio_cache_shm_s *self = SLICE_NEW0 (struct oio_cache_shm_s);
+	self->vtable = &vtable_shm;
+	self->base = base;
+	self->size = _shm_size (nb_sets);
+	self->sets = (struct shm_set_s*) (base + SHM_HEADER_SIZE);
+	self->nb_sets = nb_sets;
+	self->ttl = ttl;
+	return (struct oio_cache_s*) self;
+}
+
+/* Interface ---------------------------------------------------------------- */
+
+/* FNV-1a, stable across processes */
+static guint32
+_hash (const char *k, gsize *plen)
+{
+	guint32 h = 2166136261u;
+	const char *p;
+	for (p = k; *p; ++p) {
+		h ^= (guint8) *p;
+		h *= 16777619u;
+	}
+	*plen = p - k;
+	return h;
+}
+
+static struct shm_set_s *
+_lock (struct oio_cache_shm_s *c, guint32 h)
+{
+	struct shm_set_s *set = c->sets + (h % c->nb_sets);
+	int rc = pthread_mutex_lock (&set->lock);
+	if (rc == EOWNERDEAD) {
+		/* The previous owner died with the lock held, the set might be
+		 * half-written */
+		memset (set->slots, 0, sizeof(set->slots));
+		pthread_mutex_consistent (&set->lock);
+		rc = 0;
+	}
+	return rc ? NULL : set;
+}
+
+static struct shm_slot_s *
+_find (struct shm_set_s *set, guint32 h, const char *k, gsize klen,
+		gint64 now)
+{
+	for (guint i = 0; i < SHM_WAYS; ++i) {
+		struct shm_slot_s *slot = set->slots + i;
+		if (!slot->expire)
+			continue;
+		if (slot->expire <= now) {
+			slot->expire = 0;
+			continue;
+		}
+		if (slot->hash == h && slot->klen == klen
+				&& !memcmp (slot->data, k, klen))
+			return slot;
+	}
+	return NULL;
+}
+
+static void
+_shm_destroy (struct oio_cache_s *self)
+{
+	struct oio_cache_shm_s *c = (struct oio_cache_shm_s*) self;
+	if (!c)
+		return;
+	munmap (c->base, c->size);
+	c->base = NULL;
+	c->sets = NULL;
+	SLICE_FREE (struct oio_cache_shm_s, c);
+}
+
+static enum oio_cache_status_e
+_shm_put (struct oio_cache_s *self, const char *k, const char *v)
+{
+	struct oio_cache_shm_s *c = (struct oio_cache_shm_s*) self;
+	const gint64 now = oio_ext_real_seconds ();
+	gsize klen = 0;
+	const guint32 h = _hash (k, &klen);
+	const gsize vlen = strlen (v);
+
+	if (klen + vlen > sizeof(((struct shm_slot_s*)0)->data))
+		return OIO_CACHE_FAIL;
+
+	struct shm_set_s *set = _lock (c, h);
+	if (!set)
+		return OIO_CACHE_FAIL;
+
+	/* The slot already holding the key, else a free slot (_find() frees the
+	 * expired slots it meets), else the slot that expires first. All the
+	 * entries share the same TTL, so that one is the least recently written. */
+	struct shm_slot_s *slot = _find (set, h, k, klen, now);
+	for (guint i = 0; !slot && i < SHM_WAYS; ++i) {
+		if (!set->slots[i].expire)
+			slot = set->slots + i;
+	}
+	if (!slot) {
+		slot = set->slots;
+		for (guint i = 1; i < SHM_WAYS; ++i) {
+			if (set->slots[i].expire < slot->expire)
+				slot = set->slots + i;
+		}
+	}
+
+	/* Without TTL, the entry never expires in practice, but its expiry
+	 * still grows with the time of the write, so that the eviction above
+	 * still picks the least recently written entry. Rewriting a key
+	 * refreshes it. */
+	slot->expire = now + (c->ttl > 0 ? c->ttl : G_MAXINT32);
+	slot->hash = h;
+	slot->klen = klen;
+	slot->vlen = vlen;
+	memcpy (slot->data, k, klen);
+	memcpy (slot->data + klen, v, vlen);
+
+	pthread_mutex_unlock (&set->lock);
+	return OIO_CACHE_OK;
+}
+
+static enum oio_cache_status_e
+_shm_del (struct oio_cache_s *self, const char *k)
+{
+	struct oio_cache_shm_s *c = (struct oio_cache_shm_s*) self;
+	gsize klen = 0;
+	const guint32 h = _hash (k, &klen);
+
+	struct shm_set_s *set = _lock (c, h);
+	if (!set)
+		return OIO_CACHE_FAIL;
+
+	struct shm_slot_s *slot = _find (set, h, k, klen, oio_ext_real_seconds ());
+	if (slot)
+		slot->expire = 0;
+
+	pthread_mutex_unlock (&set->lock);
+	return slot ? OIO_CACHE_OK : OIO_CACHE_NOTFOUND;
+}
+
+static enum oio_cache_status_e
+_shm_get (struct oio_cache_s *self, const char *k, gchar **out)
+{
+	struct oio_cache_shm_s *c = (struct oio_cache_shm_s*) self;
+	gsize klen = 0;
+	const guint32 h = _hash (k, &klen);
+
+	g_assert (out != NULL);
+	*out = NULL;
+
+	struct shm_set_s *set = _lock (c, h);
+	if (!set)
+		return OIO_CACHE_FAIL;
+
+	struct shm_slot_s *slot = _find (set, h, k, klen, oio_ext_real_seconds ());
+	if (slot)
+		*out = g_strndup (slot->data + slot->klen, slot->vlen);
+
+	pthread_mutex_unlock (&set->lock);
+	return slot ? OIO_CACHE_OK : OIO_CACHE_NOTFOUND;
+}
@@ -74,8 +74,10 @@ conscience_srv_destroy(struct conscience_srv_s *service)
 			service->app_data.pointer.cleaner(service->app_data.pointer.value);
 	}
 
-	/*remove from the ring */
+	/*remove from the rings */
 	service_ring_remove(service);
+	service_fresh_ring_remove(service);
+	g_mutex_clear(&(service->lock));
 
 	/*cleans the structure */
 	memset(service, 0x00, sizeof(struct conscience_srv_s));
@@ -52,6 +52,12 @@ struct conscience_srv_s
 	gboolean locked;
 	GPtrArray *tags;
 	time_t  time_last_alert;
+	time_t  time_last_refresh; /**<Position in the freshness ring */
+
+	/* Guards the tags, the score, the lock flag and the app_data, so that
+	 * a service may be refreshed or read while its service type is only
+	 * held with a reader lock. Useless under the writer lock. */
+	GMutex lock;
 
 	/*Allow a user to associate user data*/
 	enum { SAD_NONE=0, SAD_REAL, SAD_UINT, SAD_INT, SAD_PTR } app_data_type;
@@ -68,6 +74,10 @@ struct conscience_srv_s
 	/*a ring by service type */
 	struct conscience_srv_s *next;
 	struct conscience_srv_s *prev;
+
+	/*a ring by service type, the most recently refreshed first */
+	struct conscience_srv_s *fresh_next;
+	struct conscience_srv_s *fresh_prev;
 };
 
 /* ------------------------------------------------------------------------- */
@@ -145,6 +155,33 @@ service_ring_remove(struct conscience_srv_s *service)
 		service->next->prev = service->prev;
 }
 
+/**
+ * @param service
+ */
+static inline void
+service_fresh_ring_remove(struct conscience_srv_s *service)
+{
+	if (service->fresh_prev)
+		service->fresh_prev->fresh_next = service->fresh_next;
+	if (service->fresh_next)
+		service->fresh_next->fresh_prev = service->fresh_prev;
+	service->fresh_next = service->fresh_prev = NULL;
+}
+
+/**
+ * @param service
+ * @param beacon
+ */
+static inline void
+service_fresh_ring_push(struct conscience_srv_s *service,
+    struct conscience_srv_s *beacon)
+{
+	service->fresh_prev = beacon;
+	service->fresh_next = beacon->fresh_next;
+	beacon->fresh_next->fresh_prev = service;
+	beacon->fresh_next = service;
+}
+
 /**
  * @param service
  * @param beacon
@@ -78,6 +78,8 @@ conscience_srvtype_create(struct conscience_s *conscience, const char *type)
 	srvtype->score_variation_bound = 0;
 	srvtype->conscience = conscience;
 	srvtype->services_ring.next = srvtype->services_ring.prev = &(srvtype->services_ring);
+	srvtype->services_ring.fresh_next = srvtype->services_ring.fresh_prev = &(srvtype->services_ring);
+	g_mutex_init(&(srvtype->fresh_lock));
 	return srvtype;
 }
 
@@ -101,6 +103,8 @@ conscience_srvtype_destroy(struct conscience_srvtype_s *srvtype)
 		*(srvtype->score_expr_str) = '\0';
 		g_free(srvtype->score_expr_str);
 	}
+	if (srvtype->services_ring.fresh_next)
+		g_mutex_clear(&(srvtype->fresh_lock));
 
 	memset(srvtype, 0x00, sizeof(struct conscience_srvtype_s));
 	g_free(srvtype);
@@ -214,6 +218,8 @@ conscience_srvtype_register_srv(struct conscience_srvtype_s *srvtype,
 	service->score.timestamp = oio_ext_real_time () / G_TIME_SPAN_SECOND;
 	service->score.value = -1;
 	service->srvtype = srvtype;
+	service->time_last_refresh = service->score.timestamp;
+	g_mutex_init(&(service->lock));
 
 	/*build the service description once for all*/
 	desc_size = g_snprintf(service->description,sizeof(service->description),"%s/%s/",
@@ -231,17 +237,17 @@ conscience_srvtype_register_srv(struct conscience_srvtype_s *srvtype,
 	service->next = srvtype->services_ring.next;
 	srvtype->services_ring.next = service;
 
+	service_fresh_ring_push(service, &(srvtype->services_ring));
 	return service;
 }
 
 gint
 conscience_srvtype_remove_expired(struct conscience_srvtype_s * srvtype,
-    GError ** err, service_callback_f * callback, gpointer u)
+    GError ** err, guint max, service_callback_f * callback, gpointer u)
 {
-	GHashTableIter iter;
-	gpointer key, value;
 	gint how_many;
-	time_t oldest;
+	time_t now, oldest;
+	struct conscience_srv_s *beacon, *srv;
 
 	if (!srvtype) {
 		GSETERROR(err, "Invalid parameter");
@@ -249,19 +255,29 @@ conscience_srvtype_remove_expired(struct conscience_srvtype_s * srvtype,
 	}
 
 	how_many = 0U;
-	oldest = oio_ext_real_time () / G_TIME_SPAN_SECOND - srvtype->score_expiration;
-
-	g_hash_table_iter_init(&iter, srvtype->services_ht);
-	while (g_hash_table_iter_next(&iter, &key, &value)) {
+	now = oio_ext_real_time () / G_TIME_SPAN_SECOND;
+	oldest = now - srvtype->score_expiration;
+	beacon = &(srvtype->services_ring);
 
-		struct conscience_srv_s *pService = value;
+	/* The oldest refreshes are at the tail of the freshness ring, we stop
+	 * at the first service refreshed recently enough. */
+	while ((srv = beacon->fresh_prev) != beacon
+			&& srv->time_last_refresh < oldest) {
+		if (max > 0 && how_many >= (gint)max)
+			break;
 
-		if (!pService->locked && pService->score.timestamp < oldest) {
+		service_fresh_ring_remove(srv);
+		if (!srv->locked && srv->score.timestamp < oldest) {
 			if (callback)
-				callback(pService, u);
-			g_hash_table_iter_steal(&iter);
-			conscience_srv_destroy(pService);
+				callback(srv, u);
+			g_hash_table_remove(srvtype->services_ht, &(srv->id));
+			conscience_srv_destroy(srv);
 			how_many++;
+		} else {
+			/* Locked, or its score has been set ahead: it will be checked
+			 * again after a full expiration period */
+			srv->time_last_refresh = now;
+			service_fresh_ring_push(srv, beacon);
 		}
 	}
 
@@ -323,9 +339,8 @@ conscience_srvtype_count_srv(struct conscience_srvtype_s * srvtype,
 
 		for (srv = beacon->next; srv && srv != beacon;
 		    srv = srv->next) {
-			if (srv->score.timestamp < oldest)
-				break;
-			count++;
+			if (srv->locked || srv->score.timestamp > oldest)
+				count++;
 		}
 	}
 
@@ -433,6 +448,14 @@ conscience_srvtype_refresh(struct conscience_srvtype_s *srvtype,
 			p_srv->score.value = -1;
 	}
 
+	/* Move it ahead of the expiration candidates. Several refreshes may
+	 * run in parallel under the reader lock of the service type. */
+	g_mutex_lock(&(srvtype->fresh_lock));
+	p_srv->time_last_refresh = oio_ext_real_time () / G_TIME_SPAN_SECOND;
+	service_fresh_ring_remove(p_srv);
+	service_fresh_ring_push(p_srv, &(srvtype->services_ring));
+	g_mutex_unlock(&(srvtype->fresh_lock));
+
 	/* refresh the tags: create missing, replace existing
 	 * (but the tags are not flushed before) */
 	if (si->tags) {
@@ -47,7 +47,11 @@ struct conscience_srvtype_s
 	GByteArray *config_serialized;	/**<Preserialized configuration sent to the agents*/
 
 	GHashTable *services_ht;	     /**<Maps (conscience_srvid_s*) to (conscience_srv_s*)*/
-	struct conscience_srv_s services_ring;
+	struct conscience_srv_s services_ring; /**<Beacon of both rings */
+
+	/* Guards the freshness ring, that is reordered by the refreshes run
+	 * under the reader lock */
+	GMutex fresh_lock;
 };
 
 /**
@@ -116,6 +120,13 @@ struct conscience_srv_s *conscience_srvtype_register_srv(struct
     conscience_srvtype_s *srvtype, GError ** err, const struct conscience_srvid_s *srvid);
 
 /**
+ * Refreshes the tags and the score of the service described by <srvinfo>,
+ * registering it if necessary.
+ *
+ * A registration requires the writer lock on the service type. A service
+ * already registered may be refreshed under the reader lock only, as long
+ * as the caller also holds the lock of that service.
+ *
  * @param srvtype
  * @param error
  * @param srvinfo
@@ -127,16 +138,23 @@ gboolean conscience_srvtype_refresh(struct conscience_srvtype_s *srvtype,
 /**
  * Removes the service-type holder all the services which
  * expired.
+ *
+ * Only the services that have not been refreshed for long are checked,
+ * starting from the oldest, so that the cost is proportional to the number
+ * of services expired and not to the size of the service type. The caller
+ * must hold the writer lock on the service type.
  * 
  * @param srvtype a valid service-type holder
  * @param err a double pointer to a GError structure set on failure
+ * @param max the maximum number of services removed, 0 for no limit. When
+ * it is reached, the caller should release its lock and call again.
  * @param callback if supplied, called on each service removed 
  * @param udata arbitrary caller data passed to each callback call,
  * if such a callback has been provided.
  * @return the number of service removed
  */
 gint conscience_srvtype_remove_expired(struct conscience_srvtype_s *srvtype,
-    GError ** err, service_callback_f * callback, gpointer udata);
+    GError ** err, guint max, service_callback_f * callback, gpointer udata);
 
 /**
  * Executes the given callback on all the services registered in the
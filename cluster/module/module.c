@@ -17,8 +17,6 @@ You should have received a copy of the GNU Affero General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#define MODULE_NAME "conscience"
-
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
@@ -31,11 +29,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <metautils/lib/metautils.h>
 
-#include <gridd/main/plugin.h>
-#include <gridd/main/message_handler.h>
-#include <gridd/main/srvalert.h>
-#include <gridd/main/srvtimer.h>
-#include <gridd/main/srvstats.h>
+#include <server/network_server.h>
+#include <server/transport_gridd.h>
 
 #include <cluster/lib/gridcluster.h>
 #include <cluster/conscience/conscience.h>
@@ -45,15 +40,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define SRVID_OF_ADDR(A) ((struct conscience_srvid_s*)(A))
 
-struct conscience_request_counters
-{
-	guint64 info;
-	guint64 get;
-	guint64 list;
-	guint64 remove;
-	guint64 push;
-};
-
 struct srvget_s
 {
 	gboolean full;
@@ -69,15 +55,6 @@ struct srvget_s
 	GSList *response_bodies;
 };
 
-typedef gint(*_cmd_handler_f) (struct request_context_s *);
-
-struct cmd_s
-{
-	char *c;
-	_cmd_handler_f h;
-	guint64 *req_counter;
-};
-
 static void _alert_service_with_zeroed_score(struct conscience_srv_s *srv);
 
 /* ------------------------------------------------------------------------- */
@@ -90,21 +67,8 @@ static time_t time_default_alert_frequency = TIME_DEFAULT_ALERT_LIMIT;
 
 static struct conscience_s *conscience = NULL;
 
-static struct conscience_request_counters stats;
-
-static GRecMutex counters_mutex;
-
-static GRecMutex conscience_nsinfo_mutex;
-
 static gboolean flag_forced_meta0 = FALSE;
 
-static void
-_reply_ctx_set_error(struct reply_context_s *ctx)
-{
-	reply_context_clear(ctx, FALSE);
-	reply_context_set_message(ctx, gerror_get_code(ctx->warning), gerror_get_message(ctx->warning));
-}
-
 static void
 _alert_service_with_zeroed_score(struct conscience_srv_s *srv)
 {
@@ -125,44 +89,20 @@ _alert_service_with_zeroed_score(struct conscience_srv_s *srv)
 			str_id[i] = g_ascii_tolower(c);
 		}
 
-		SRV_SEND_ERROR(str_id,"[NS=%s][%s][SCORE=0] service=%.*s",
+		ERROR("[%s][NS=%s][%s][SCORE=0] service=%.*s", str_id,
 				conscience_get_nsname(conscience), srv->srvtype->type_name,
-				sizeof(srv->description), srv->description);
+				(int) sizeof(srv->description), srv->description);
 		srv->time_last_alert = now;
 	}
 }
 
-static void
-init_reply_ctx_with_request(struct request_context_s *req, struct reply_context_s *rep)
-{
-	if (rep) {
-		memset(rep, 0x00, sizeof(struct reply_context_s));
-		rep->req_ctx = req;
-	}
-}
-
-static void
-save_counters(gpointer u)
-{
-#define CONSCIENCE_COUNTER_PREFIX "counter req.hits."
-#define SAVE_COUNTER(N,F) do { srvstat_set_u64(CONSCIENCE_COUNTER_PREFIX N, stats.F); } while (0)
-	(void)u;
-	guint64 d = oio_ext_real_time () / G_TIME_SPAN_SECOND;
-	srvstat_set_u64(CONSCIENCE_COUNTER_PREFIX "timestamp", d);
-
-	SAVE_COUNTER(NAME_MSGNAME_CS_GET_NSINFO, info);
-	SAVE_COUNTER(NAME_MSGNAME_CS_GET_SRV, get);
-	SAVE_COUNTER(NAME_MSGNAME_CS_GET_SRVNAMES, list);
-	SAVE_COUNTER(NAME_MSGNAME_CS_RM_SRV, remove);
-	SAVE_COUNTER(NAME_MSGNAME_CS_PUSH_SRV, push);
-}
-
 static gboolean
 service_checker( struct conscience_srv_s * srv, gpointer u)
 {
 	if (!u)
 		return FALSE;
 	if (srv) {
+		g_mutex_lock(&(srv->lock));
 		if (!srv->locked) {
 			if (srv->score.value < 0)
 				srv->score.value = 0;
@@ -171,6 +111,7 @@ service_checker( struct conscience_srv_s * srv, gpointer u)
 		}
 		if (srv->score.timestamp > *((time_t*)u))
 			srv->score.timestamp = *((time_t*)u);
+		g_mutex_unlock(&(srv->lock));
 	}
 	return TRUE;
 }
@@ -269,7 +210,7 @@ timer_expire_services(gpointer u)
 	}
 
 	for (l=list_type_names; l ;l=g_slist_next(l)) {
-		gint rc;
+		gint rc = 0;
 		gchar *str_name;
 		struct conscience_srvtype_s *srvtype;
 
@@ -278,16 +219,26 @@ timer_expire_services(gpointer u)
 		str_name = l->data;
 		error_local = NULL;
 
-		/* XXX start of critical section */
-		srvtype = conscience_get_locked_srvtype(cs, NULL, str_name, MODE_STRICT, 'r');
-		if (!srvtype) {
-			WARN("[NS=%s][SRVTYPE=%s] srvtype disappeared very quickly",
-				conscience_get_nsname(cs), str_name);
-			continue;
+		/* The writer lock is released between small batches, so that the
+		 * listings and the refreshes of the type are not held for long */
+		for (gint batch = EXPIRE_BATCH_SIZE; batch == EXPIRE_BATCH_SIZE ;) {
+			/* XXX start of critical section */
+			srvtype = conscience_get_locked_srvtype(cs, NULL, str_name, MODE_STRICT, 'w');
+			if (!srvtype) {
+				WARN("[NS=%s][SRVTYPE=%s] srvtype disappeared very quickly",
+					conscience_get_nsname(cs), str_name);
+				break;
+			}
+			batch = conscience_srvtype_remove_expired(srvtype, &error_local,
+					EXPIRE_BATCH_SIZE, service_expiration_notifier, NULL);
+			conscience_release_locked_srvtype(srvtype);
+			/* XXX end of critical section */
+
+			if (batch < 0)
+				rc = batch;
+			else
+				rc += batch;
 		}
-		rc = conscience_srvtype_remove_expired( srvtype, &error_local, service_expiration_notifier, NULL);
-		conscience_release_locked_srvtype(srvtype);
-		/* XXX end of critical section */
 
 		if (rc<0)
 			ERROR("[NS=%s][SRVTYPE=%s] Failed to remove the expired services : %s",
@@ -310,13 +261,13 @@ timer_expire_services(gpointer u)
 /* ------------------------------------------------------------------------- */
 
 static gboolean
-request_body_matches_namespace(struct request_context_s *req_ctx, GError **err)
+request_body_matches_namespace(MESSAGE request, GError **err)
 {
 	GSList *list_ns = NULL;
 	int rc;
 
 	gsize body_size = 0;
-	void *body = metautils_message_get_BODY(req_ctx->request, &body_size);
+	void *body = metautils_message_get_BODY(request, &body_size);
 	if (!body)
 		return TRUE;
 
@@ -340,52 +291,44 @@ request_body_matches_namespace(struct request_context_s *req_ctx, GError **err)
 	return rc;
 }
 
+/* The errors raised by the conscience internals often carry no code */
+static void
+_reply_error(struct gridd_reply_ctx_s *reply, GError *err)
+{
+	if (!err)
+		err = SYSERR("BUG: error without explanation");
+	else if (!err->code)
+		err->code = CODE_INTERNAL_ERROR;
+	reply->send_error(0, err);
+}
+
 /* ------------------------------------------------------------------------- */
 
-static gint
-handler_get_ns_info(struct request_context_s *req_ctx)
+static gboolean
+handler_get_ns_info(struct gridd_reply_ctx_s *reply, gpointer g, gpointer h)
 {
-	struct reply_context_s ctx;
-	GByteArray* gba = NULL;
-
-	init_reply_ctx_with_request(req_ctx, &ctx);
-
-	if (!request_body_matches_namespace(req_ctx, &(ctx.warning))) {
-		if (!ctx.warning)
-			GSETCODE(&(ctx.warning), CODE_NAMESPACE_NOTMANAGED, "Invalid namespace");
-		reply_context_clear(&ctx, FALSE);
-		reply_context_set_message(&ctx, gerror_get_code(ctx.warning),
-				gerror_get_message(ctx.warning));
-		(void) reply_context_reply(&ctx, &(ctx.warning));
-		reply_context_log_access(&ctx, NULL);
-		reply_context_clear(&ctx, TRUE);
-		return (0);
-	}
-
-	g_rec_mutex_lock(&conscience_nsinfo_mutex);
-	gba = namespace_info_marshall(&(conscience->ns_info), &(ctx.warning));
-	g_rec_mutex_unlock(&conscience_nsinfo_mutex);
-
-	if (gba == NULL) {
-		GSETERROR(&(ctx.warning), "Failed to marshall namespace info");
-		reply_context_log_access(&ctx, NULL);
-		reply_context_clear(&ctx, FALSE);
-		return 0;
-	}
-
-	reply_context_set_body(&ctx, gba->data, gba->len, REPLYCTX_COPY);
-	g_byte_array_free(gba, TRUE);
-	reply_context_set_message(&ctx, CODE_FINAL_OK, "OK");
-	if (!reply_context_reply(&ctx, &(ctx.warning))) {
-		GSETERROR(&(ctx.warning), "Cannot reply the namespace info");
-		reply_context_log_access(&ctx, NULL);
-		reply_context_clear(&ctx, FALSE);
-		return (0);
-	}
-
-	reply_context_log_access(&ctx, NULL);
-	reply_context_clear(&ctx, TRUE);
-	return (1);
+	GError *err = NULL;
+	(void) g, (void) h;
+
+	if (!request_body_matches_namespace(reply->request, &err)) {
+		if (err)
+			reply->send_error(CODE_BAD_REQUEST, err);
+		else
+			reply->send_error(0, NEWERROR(CODE_NAMESPACE_NOTMANAGED,
+					"Invalid namespace"));
+		return TRUE;
+	}
+
+	GByteArray *gba = namespace_info_marshall(&(conscience->ns_info), &err);
+	if (!gba) {
+		g_prefix_error(&err, "Failed to marshall namespace info: ");
+		_reply_error(reply, err);
+		return TRUE;
+	}
+
+	reply->add_body(gba);
+	reply->send_reply(CODE_FINAL_OK, "OK");
+	return TRUE;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -404,17 +347,25 @@ _conscience_srv_clean_udata(struct conscience_srv_s *srv)
 	srv->app_data.pointer.cleaner = NULL;
 }
 
+/* Copies the service under its own lock, the encoding then happens
+ * without it. */
+static struct service_info_s *
+_conscience_srv_snapshot(struct conscience_srv_s *srv)
+{
+	struct service_info_s *si = g_malloc0(sizeof(struct service_info_s));
+	g_mutex_lock(&(srv->lock));
+	conscience_srv_fill_srvinfo(si, srv);
+	g_mutex_unlock(&(srv->lock));
+	return si;
+}
+
+/* Consumes <si> */
 static GByteArray *
-_conscience_srv_serialize(struct conscience_srv_s *srv)
+_srvinfo_serialize(struct service_info_s *si)
 {
 	GError *err = NULL;
 	GByteArray *gba;
 	GPtrArray *tags = NULL;
-	struct service_info_s *si;
-
-	/* prepare the srvinfo */
-	si = g_malloc0(sizeof(struct service_info_s));
-	conscience_srv_fill_srvinfo(si, srv);
 
 	if ((!flag_serialize_srvinfo_stats && !flag_serialize_srvinfo_tags)
 			|| !si->tags || si->tags->len <= 0) {
@@ -453,15 +404,12 @@ _conscience_srv_serialize(struct conscience_srv_s *srv)
 	return gba;
 }
 
+/* Consumes <si> */
 static GByteArray *
-_conscience_srv_serialize_full(struct conscience_srv_s *srv)
+_srvinfo_serialize_full(struct service_info_s *si)
 {
 	GError *err = NULL;
 	GByteArray *gba;
-	struct service_info_s *si;
-
-	si = g_malloc0(sizeof(struct service_info_s));
-	conscience_srv_fill_srvinfo(si, srv);
 
 	if (!(gba = service_info_marshall_1(si, &err))) {
 		WARN("service_info serialization error : %s", gerror_get_message(err));
@@ -472,6 +420,8 @@ _conscience_srv_serialize_full(struct conscience_srv_s *srv)
 	return gba;
 }
 
+/* The caller holds the lock of the service, or the writer lock of its type.
+ * The previous form stays valid for the listings that took a reference. */
 static void
 _conscience_srv_prepare_cache(struct conscience_srv_s *srv)
 {
@@ -480,7 +430,9 @@ _conscience_srv_prepare_cache(struct conscience_srv_s *srv)
 	if (!flag_serialize_srvinfo_cache)
 		return;
 
-	gba = _conscience_srv_serialize(srv);
+	struct service_info_s *si = g_malloc0(sizeof(struct service_info_s));
+	conscience_srv_fill_srvinfo(si, srv);
+	gba = _srvinfo_serialize(si);
 	_conscience_srv_clean_udata(srv);
 	srv->app_data_type = SAD_PTR;
 	srv->app_data.pointer.value = gba;
@@ -493,25 +445,33 @@ _srvinfo_append(struct srvget_s *sg, struct conscience_srv_s *srv)
 	GByteArray *gba;
 
 	if (sg->full) {
-		gba = _conscience_srv_serialize_full(srv);
+		gba = _srvinfo_serialize_full(_conscience_srv_snapshot(srv));
 		if (gba) {
 			g_byte_array_append(sg->gba_body, gba->data, gba->len);
 			g_byte_array_free(gba, TRUE);
 			return TRUE;
 		}
+		return FALSE;
 	}
-	else if (flag_serialize_srvinfo_cache
-		&& srv->app_data_type == SAD_PTR
-		&& NULL != (gba = srv->app_data.pointer.value))
-	{
-		if (gba->len > 0) {
-			g_byte_array_append(sg->gba_body, gba->data, gba->len);
-			return TRUE;
+
+	if (flag_serialize_srvinfo_cache) {
+		/* A push may replace the cached form meanwhile: keep ours alive */
+		g_mutex_lock(&(srv->lock));
+		gba = NULL;
+		if (srv->app_data_type == SAD_PTR && srv->app_data.pointer.value)
+			gba = g_byte_array_ref(srv->app_data.pointer.value);
+		g_mutex_unlock(&(srv->lock));
+		if (gba) {
+			gboolean rc = gba->len > 0;
+			if (rc)
+				g_byte_array_append(sg->gba_body, gba->data, gba->len);
+			g_byte_array_unref(gba);
+			return rc;
 		}
 	}
-	else if (NULL != (gba = _conscience_srv_serialize(srv))) {
+
+	if (NULL != (gba = _srvinfo_serialize(_conscience_srv_snapshot(srv)))) {
 		g_byte_array_append(sg->gba_body, gba->data, gba->len);
-		sg->srv_list_size++;
 		g_byte_array_free(gba, TRUE);
 		return TRUE;
 	}
@@ -576,69 +536,51 @@ prepare_response_bodies(struct conscience_srv_s *srv, gpointer u)
 }
 
 static gboolean
-reply_services(struct reply_context_s *reply_ctx, GSList *response_bodies)
+handler_get_service(struct gridd_reply_ctx_s *reply, gpointer g, gpointer h)
 {
-	for (GSList *l = response_bodies; l; l = l->next) {
-		GByteArray *body = l->data;
-		reply_context_clear(reply_ctx, TRUE);
-		reply_context_set_body(reply_ctx, body->data,
-				body->len, REPLYCTX_DESTROY_ON_CLEAN|REPLYCTX_COPY);
-
-		reply_context_set_message(reply_ctx, CODE_PARTIAL_CONTENT, "Partial content");
-
-		if (!reply_context_reply(reply_ctx, &(reply_ctx->warning))) {
-			return FALSE;
-		}
-	}
-
-	reply_context_clear(reply_ctx, TRUE);
-	reply_context_set_message(reply_ctx, CODE_FINAL_OK, "OK");
-	return BOOL(reply_context_reply(reply_ctx, &(reply_ctx->warning)));
-}
-
-static gint
-handler_get_service(struct request_context_s *req_ctx)
-{
-	gboolean rc = 0;
+	GError *err = NULL;
+	(void) g, (void) h;
 
 	struct srvget_s sg;
 	memset(&sg, 0x00, sizeof(sg));
-	sg.full = metautils_message_extract_flag(req_ctx->request, NAME_MSGKEY_FULL, FALSE);
-
-	struct reply_context_s reply_ctx;
-	init_reply_ctx_with_request(req_ctx, &reply_ctx);
+	sg.full = metautils_message_extract_flag(reply->request, NAME_MSGKEY_FULL, FALSE);
 
-	gsize data_size = 0;
-	void *data = metautils_message_get_field(req_ctx->request, NAME_MSGKEY_TYPENAME, &data_size);
-	if (!data) {
-		GSETCODE(&(reply_ctx.warning), CODE_BAD_REQUEST, "Bad request: no/invalid TYPENAME field");
-	} else {
-		gchar **array_types = buffer_split(data, data_size, ",", 0);
-		g_strlcpy(sg.str_ns, conscience_get_nsname(conscience), sizeof(sg.str_ns));
+	gchar *types = metautils_message_extract_string_copy(reply->request, NAME_MSGKEY_TYPENAME);
+	if (!types) {
+		reply->send_error(0, BADREQ("Bad request: no/invalid TYPENAME field"));
+		return TRUE;
+	}
+	reply->subject("%s", types);
 
-		/* XXX start of critical section */
-		rc = conscience_run_srvtypes(conscience, &(reply_ctx.warning),
-				SRVTYPE_FLAG_ADDITIONAL_CALL|SRVTYPE_FLAG_LOCK_ENABLE,
-				array_types, prepare_response_bodies, &sg);
-		/* XXX end of critical section */
+	gchar **array_types = g_strsplit(types, ",", -1);
+	g_strlcpy(sg.str_ns, conscience_get_nsname(conscience), sizeof(sg.str_ns));
 
-		if (rc)
-			rc = reply_services(&reply_ctx, sg.response_bodies);
-		g_strfreev(array_types);
-	}
+	/* XXX start of critical section */
+	gboolean rc = conscience_run_srvtypes(conscience, &err,
+			SRVTYPE_FLAG_ADDITIONAL_CALL|SRVTYPE_FLAG_LOCK_ENABLE,
+			array_types, prepare_response_bodies, &sg);
+	/* XXX end of critical section */
 
 	if (!rc) {
-		ERROR("An error occured: %s", gerror_get_message(reply_ctx.warning));
-		_reply_ctx_set_error(&(reply_ctx));
-		reply_context_reply(&(reply_ctx),NULL);
+		_reply_error(reply, err);
+	} else {
+		/* the bodies have been prepended, they are sent in their order,
+		 * and taken by the reply */
+		sg.response_bodies = g_slist_reverse(sg.response_bodies);
+		for (GSList *l = sg.response_bodies; l; l = l->next) {
+			reply->add_body(l->data);
+			l->data = NULL;
+			reply->send_reply(CODE_PARTIAL_CONTENT, "Partial content");
+		}
+		reply->send_reply(CODE_FINAL_OK, "OK");
 	}
 
 	if (sg.gba_body)
 		g_byte_array_free(sg.gba_body, TRUE);
-	g_slist_free_full(sg.response_bodies, metautils_gba_unref);
-	reply_context_log_access(&reply_ctx, NULL);
-	reply_context_clear(&(reply_ctx), TRUE);
-	return rc ? 1 : 0;
+	g_slist_free(sg.response_bodies);
+	g_strfreev(array_types);
+	g_free(types);
+	return TRUE;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -654,7 +596,7 @@ static void
 push_service(struct conscience_s *cs, struct service_info_s *si)
 {
 	gchar str_addr[STRLEN_ADDRINFO] = "", str_descr[LIMIT_LENGTH_SRVDESCR] = "";
-	gint32 old_score=0;
+	gint32 old_score=0, new_score=0;
 	GError *error_local=NULL;
 	struct conscience_srvtype_s *srvtype;
 	struct conscience_srv_s *srv;
@@ -672,7 +614,14 @@ push_service(struct conscience_s *cs, struct service_info_s *si)
 	}
 
 	/* XXX start of critical section */
-	srvtype = conscience_get_locked_srvtype(cs, &error_local, si->type, MODE_STRICT, 'w');
+	/* Refreshing a known service only requires the reader lock on its type,
+	 * plus the lock of the service itself: the listings of the type are not
+	 * blocked. Only a registration takes the writer lock. */
+	srvtype = conscience_get_locked_srvtype(cs, &error_local, si->type, MODE_STRICT, 'r');
+	if (srvtype && !conscience_srvtype_get_srv(srvtype, SRVID_OF_ADDR(&(si->addr)))) {
+		conscience_release_locked_srvtype(srvtype);
+		srvtype = conscience_get_locked_srvtype(cs, &error_local, si->type, MODE_STRICT, 'w');
+	}
 	if (!srvtype) {
 		ERROR("Service type [%s/%s] not found : %s", conscience_get_nsname(cs),
 			si->type, gerror_get_message(error_local));
@@ -682,8 +631,9 @@ push_service(struct conscience_s *cs, struct service_info_s *si)
 	}
 
 	/*for alerting purposes, we need to store the previous score*/
-	srv = conscience_srvtype_get_srv(srvtype, (struct conscience_srvid_s*)&(si->addr));
+	srv = conscience_srvtype_get_srv(srvtype, SRVID_OF_ADDR(&(si->addr)));
 	if (srv) {
+		g_mutex_lock(&(srv->lock));
 		old_score = srv->score.value;
 		memcpy(str_descr, srv->description, LIMIT_LENGTH_SRVDESCR);
 	}
@@ -702,25 +652,30 @@ push_service(struct conscience_s *cs, struct service_info_s *si)
 				srv->locked = TRUE;
 			}
 			_conscience_srv_prepare_cache(srv);
+			new_score = srv->score.value;
+			g_mutex_unlock(&(srv->lock));
 		}
-		else { /* first register */
-			srv = conscience_srvtype_get_srv(srvtype, (struct conscience_srvid_s*)&(si->addr));
-			if (srv) {
-				srv->locked = (si->score.value >= 0);
-				_conscience_srv_prepare_cache(srv);
+		else { /* first register, under the writer lock */
+			struct conscience_srv_s *p_srv = conscience_srvtype_get_srv(
+					srvtype, SRVID_OF_ADDR(&(si->addr)));
+			if (p_srv) {
+				p_srv->locked = (si->score.value >= 0);
+				_conscience_srv_prepare_cache(p_srv);
 			}
 		}
 		conscience_release_locked_srvtype(srvtype);
 		/* XXX end of critical section */
 
 		if (srv)
-			DEBUG("Service [%s] refreshed with score=%d", str_descr, srv->score.value);
+			DEBUG("Service [%s] refreshed with score=%d", str_descr, new_score);
 		else {
 			grid_addrinfo_to_string(&(si->addr),str_addr,sizeof(str_addr));
 			NOTICE("Service [%s/%s/%s] registered", conscience_get_nsname(cs), si->type, str_addr);
 		}
 	}
 	else {
+		if (srv)
+			g_mutex_unlock(&(srv->lock));
 		conscience_release_locked_srvtype(srvtype);
 		/* XXX end of critical section */
 
@@ -738,71 +693,63 @@ push_service(struct conscience_s *cs, struct service_info_s *si)
 		g_error_free(error_local);
 }
 
-static gint
-handler_push_service(struct request_context_s *req_ctx)
+static GError *
+_extract_services(MESSAGE request, GSList **out)
 {
-	GSList *list_srvinfo = NULL;
-
-	struct reply_context_s ctx;
-	init_reply_ctx_with_request(req_ctx, &(ctx));
-
+	GError *err = NULL;
 	gsize data_size = 0;
-	void *data = metautils_message_get_BODY(req_ctx->request, &data_size);
-	if (!data) {
-		GSETCODE(&(ctx.warning), CODE_BAD_REQUEST, "Bad requets : no body");
-		goto errorLabel;
-	}
-	if (0 >= service_info_unmarshall(&list_srvinfo, data, data_size, &(ctx.warning))) {
-		GSETCODE(&(ctx.warning), CODE_BAD_REQUEST, "Bad request : failed to deserialize the body");
-		goto errorLabel;
+	void *data = metautils_message_get_BODY(request, &data_size);
+	if (!data)
+		return BADREQ("Bad request: no body");
+	if (0 >= service_info_unmarshall(out, data, data_size, &err)) {
+		g_slist_free_full(*out, (GDestroyNotify)service_info_clean);
+		*out = NULL;
+		if (!err)
+			return BADREQ("Bad request: empty body");
+		err->code = CODE_BAD_REQUEST;
+		g_prefix_error(&err, "Bad request: ");
+		return err;
 	}
+	return NULL;
+}
 
-	if (DEBUG_ENABLED()) {
-	DEBUG("[%d] services to be pushed in namespace [%s]",
-			g_slist_length(list_srvinfo), conscience_get_nsname(conscience));
+static gboolean
+handler_push_service(struct gridd_reply_ctx_s *reply, gpointer g, gpointer h)
+{
+	GSList *list_srvinfo = NULL;
+	(void) g, (void) h;
+
+	GError *err = _extract_services(reply->request, &list_srvinfo);
+	if (err) {
+		reply->send_error(0, err);
+		return TRUE;
 	}
 
-	/*Now push each service and reply the success */
-	gint counter = 0;
+	guint count = g_slist_length(list_srvinfo);
+	reply->subject("%u", count);
+	DEBUG("[%u] services to be pushed in namespace [%s]",
+			count, conscience_get_nsname(conscience));
+
 	for (GSList *l = list_srvinfo; l; l = g_slist_next(l)) {
-		if (l->data) {
+		if (l->data)
 			push_service(conscience, (struct service_info_s *) (l->data));
-			service_info_clean(l->data);
-			l->data = NULL;
-			counter++;
-		}
 	}
-	g_slist_free(list_srvinfo);
-
-	reply_context_set_message(&ctx, CODE_FINAL_OK, "OK");
-	reply_context_reply(&ctx, NULL);
-	reply_context_log_access(&ctx, NULL);
-	reply_context_clear(&ctx, TRUE);
-	return 1;
-errorLabel:
-	ERROR("An error occured : %s", gerror_get_message(ctx.warning));
-	_reply_ctx_set_error(&ctx);
-	reply_context_reply(&ctx, NULL);
-	reply_context_log_access(&ctx, NULL);
-	reply_context_clear(&ctx, TRUE);
-	return 0;
+	g_slist_free_full(list_srvinfo, (GDestroyNotify)service_info_clean);
+
+	reply->send_reply(CODE_FINAL_OK, "OK");
+	return TRUE;
 }
 
 /* ------------------------------------------------------------------------- */
 
-static gint
-handler_get_services_types(struct request_context_s *req_ctx)
+static gboolean
+handler_get_services_types(struct gridd_reply_ctx_s *reply, gpointer g, gpointer h)
 {
-	gint counter;
-	struct reply_context_s ctx;
+	GError *err = NULL;
 	GHashTableIter iterator;
 	gpointer k, v;
-	GSList *list_names;
-	GByteArray *gba_names;
-
-	init_reply_ctx_with_request(req_ctx, &(ctx));
-	counter = 0;
-	list_names = NULL;
+	GSList *list_names = NULL;
+	(void) g, (void) h;
 
 	/* We avoid calling the similar feature from the conscience because
 	 * it makes a deep copy of the list. We do not perform any blocking
@@ -813,35 +760,25 @@ handler_get_services_types(struct request_context_s *req_ctx)
 	conscience_lock_srvtypes(conscience,'r');
 	g_hash_table_iter_init(&iterator, conscience->srvtypes);
 	while (g_hash_table_iter_next(&iterator, &k, &v)) {
-		if (k) {
+		if (k)
 			list_names = g_slist_prepend(list_names, k);
-			counter++;
-		}
 	}
 
-	gba_names = strings_marshall_gba(list_names, &(ctx.warning));
+	GByteArray *gba_names = strings_marshall_gba(list_names, &err);
 	conscience_unlock_srvtypes(conscience);
 	/* XXX end of critical section */
 
 	g_slist_free(list_names);
 
-	/* Now we can manage the potential error and reply */
 	if (!gba_names) {
-		reply_context_set_message(&ctx, CODE_INTERNAL_ERROR, gerror_get_message(ctx.warning));
-		ERROR("Failed to reply the service types : %s", gerror_get_message(ctx.warning));
-		reply_context_reply(&ctx, NULL);
-		reply_context_log_access(&ctx, NULL);
-		reply_context_clear(&ctx, TRUE);
-		return 0;
-	}
-
-	reply_context_set_body(&ctx, gba_names->data, gba_names->len, REPLYCTX_DESTROY_ON_CLEAN|REPLYCTX_COPY);
-	g_byte_array_free(gba_names, TRUE);
-	reply_context_set_message(&ctx, CODE_FINAL_OK, "OK");
-	reply_context_reply(&ctx, NULL);
-	reply_context_log_access(&ctx, NULL);
-	reply_context_clear(&ctx, TRUE);
-	return 1;
+		ERROR("Failed to reply the service types : %s", gerror_get_message(err));
+		_reply_error(reply, err);
+		return TRUE;
+	}
+
+	reply->add_body(gba_names);
+	reply->send_reply(CODE_FINAL_OK, "OK");
+	return TRUE;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -859,11 +796,9 @@ rm_service(struct conscience_s *cs, struct service_info_s *si)
 	struct conscience_srvid_s srvid;
 	struct conscience_srvtype_s *srvtype;
 
-	if (INFO_ENABLED()) {
-		str_desc_len = g_snprintf(str_desc, sizeof(str_desc), "%s/%s/", conscience_get_nsname(cs), si->type);
-		grid_addrinfo_to_string(&(si->addr), str_desc + str_desc_len, sizeof(str_desc) - str_desc_len);
-		memcpy(&(srvid.addr), &(si->addr), sizeof(addr_info_t));
-	}
+	memcpy(&(srvid.addr), &(si->addr), sizeof(addr_info_t));
+	str_desc_len = g_snprintf(str_desc, sizeof(str_desc), "%s/%s/", conscience_get_nsname(cs), si->type);
+	grid_addrinfo_to_string(&(si->addr), str_desc + str_desc_len, sizeof(str_desc) - str_desc_len);
 
 	error_local = NULL;
 	/* XXX start of critical section */
@@ -881,148 +816,78 @@ rm_service(struct conscience_s *cs, struct service_info_s *si)
 	/* XXX end of critical section */
 }
 
-static gint
-handler_rm_service(struct request_context_s *req_ctx)
+static gboolean
+handler_rm_service(struct gridd_reply_ctx_s *reply, gpointer g, gpointer h)
 {
-	gint counter = 0;
-	struct reply_context_s ctx;
-
-	void *data;
-	gsize data_size;
-
-	init_reply_ctx_with_request(req_ctx, &(ctx));
-	data = NULL;
-	data_size = 0;
+	GError *err = NULL;
+	(void) g, (void) h;
 
-	/*Get the body and unpack it as a list of services */
-	if (metautils_message_has_BODY(req_ctx->request)) {
+	/* Get the body and unpack it as a list of services */
+	if (metautils_message_has_BODY(reply->request)) {
 		GSList *list_srvinfo = NULL;
-
- 		data = metautils_message_get_BODY(req_ctx->request, &data_size);
-		if (!data) {
-			GSETCODE(&(ctx.warning), CODE_BAD_REQUEST, "No body");
-			goto errorLabel;
-		}
-		if (0 >= service_info_unmarshall(&list_srvinfo, data, data_size, &(ctx.warning))) {
-			GSETCODE(&(ctx.warning), CODE_BAD_REQUEST, "Invalid body: deserialization error");
-			goto errorLabel;
+		if (NULL != (err = _extract_services(reply->request, &list_srvinfo))) {
+			reply->send_error(0, err);
+			return TRUE;
 		}
 
-		NOTICE("[NS=%s] [%d] services to be removed", conscience_get_nsname(conscience), g_slist_length(list_srvinfo));
+		guint count = g_slist_length(list_srvinfo);
+		reply->subject("%u", count);
+		NOTICE("[NS=%s] [%u] services to be removed",
+				conscience_get_nsname(conscience), count);
 
-		/*Now push each service and reply the success */
 		for (GSList *l = list_srvinfo; l; l = g_slist_next(l)) {
-			if (l->data) {
+			if (l->data)
 				rm_service(conscience, (struct service_info_s *) (l->data));
-				g_free(l->data);
-				l->data = NULL;
-				counter++;
-			}
 		}
-		g_slist_free(list_srvinfo);
-		reply_context_set_message(&ctx, CODE_FINAL_OK, "OK");
+		g_slist_free_full(list_srvinfo, (GDestroyNotify)service_info_clean);
+		reply->send_reply(CODE_FINAL_OK, "OK");
+		return TRUE;
 	}
-	else {
-		/* if a srvtype is present in headers, remove all services of that type. */
-		if (NULL != (data = metautils_message_get_field(req_ctx->request, NAME_MSGKEY_TYPENAME, &data_size))) {
-			gchar str_type[LIMIT_LENGTH_SRVTYPE];
-			struct conscience_srvtype_s *srvtype;
 
-			g_strlcpy(str_type, data, sizeof(str_type));
+	/* if a srvtype is present in headers, remove all services of that type. */
+	gchar *type = metautils_message_extract_string_copy(reply->request, NAME_MSGKEY_TYPENAME);
+	if (!type) {
+		reply->send_error(0, BADREQ("Bad request : no service in the body,"
+				" no service type in the fields"));
+		return TRUE;
+	}
+	reply->subject("%s", type);
 
-			/* XXX start of critical section */
-			srvtype = conscience_get_locked_srvtype(conscience, &(ctx.warning), str_type, MODE_STRICT,'w');
-			if (!srvtype) {
-				GSETCODE(&(ctx.warning), CODE_SRVTYPE_NOTMANAGED,"srvtype=[%s] not found", str_type);
-				goto errorLabel;
-			}
-			counter = conscience_srvtype_count_srv(srvtype,TRUE);
-			conscience_srvtype_flush(srvtype);
-			conscience_release_locked_srvtype(srvtype);
-			/* XXX end ofcritical section */
+	/* XXX start of critical section */
+	struct conscience_srvtype_s *srvtype = conscience_get_locked_srvtype(
+			conscience, &err, type, MODE_STRICT,'w');
+	if (!srvtype) {
+		g_clear_error(&err);
+		reply->send_error(0, NEWERROR(CODE_SRVTYPE_NOTMANAGED,
+					"srvtype=[%s] not found", type));
+	} else {
+		conscience_srvtype_flush(srvtype);
+		conscience_release_locked_srvtype(srvtype);
+		/* XXX end of critical section */
 
-			NOTICE("[NS=%s][SRVTYPE=%s] flush done!", conscience_get_nsname(conscience), srvtype->type_name);
-			reply_context_set_message(&ctx, CODE_FINAL_OK, "OK");
-		}
-		else {
-			counter = 0;
-			GSETCODE(&(ctx.warning), CODE_BAD_REQUEST, "Bad request : no service in the body, no service type in the fields");
-			goto errorLabel;
-		}
+		NOTICE("[NS=%s][SRVTYPE=%s] flush done!", conscience_get_nsname(conscience), type);
+		reply->send_reply(CODE_FINAL_OK, "OK");
 	}
 
-	reply_context_reply(&ctx, NULL);
-	reply_context_log_access(&ctx, NULL);
-	reply_context_clear(&ctx, TRUE);
-	return 1;
-
-errorLabel:
-	ERROR("Failed to remove the service : %s", gerror_get_message(ctx.warning));
-	_reply_ctx_set_error(&ctx);
-	reply_context_reply(&ctx, NULL);
-	reply_context_log_access(&ctx, NULL);
-	reply_context_clear(&ctx, TRUE);
-	return 0;
+	g_free(type);
+	return TRUE;
 }
 
 /* ------------------------------------------------------------------------- */
 
-static struct cmd_s *
-module_find_handler(gchar * n, gsize l)
+static const struct gridd_request_descr_s *
+conscience_get_requests(void)
 {
-	static struct cmd_s CMD[] = {
-		{NAME_MSGNAME_CS_GET_NSINFO, handler_get_ns_info, &(stats.info)},
-		{NAME_MSGNAME_CS_GET_SRV, handler_get_service, &(stats.get)},
-		{NAME_MSGNAME_CS_GET_SRVNAMES, handler_get_services_types, &(stats.list)},
-		{NAME_MSGNAME_CS_PUSH_SRV, handler_push_service, &(stats.push)},
-		{NAME_MSGNAME_CS_RM_SRV, handler_rm_service, &(stats.remove)},
+	static struct gridd_request_descr_s descriptions[] = {
+		{NAME_MSGNAME_CS_GET_NSINFO,   handler_get_ns_info,        NULL},
+		{NAME_MSGNAME_CS_GET_SRV,      handler_get_service,        NULL},
+		{NAME_MSGNAME_CS_GET_SRVNAMES, handler_get_services_types, NULL},
+		{NAME_MSGNAME_CS_PUSH_SRV,     handler_push_service,       NULL},
+		{NAME_MSGNAME_CS_RM_SRV,       handler_rm_service,         NULL},
 		{NULL, NULL, NULL}
 	};
 
-	if (!n || !l)
-		return NULL;
-
-	for (struct cmd_s *c = CMD; c->c; c++) {
-		if (0 == g_ascii_strncasecmp(c->c, n, l))
-			return c;
-	}
-
-	return NULL;
-}
-
-static gint
-plugin_matcher(MESSAGE m, void *param, GError ** err)
-{
-	(void)param, (void)err;
-	EXTRA_ASSERT (m != NULL);
-
-	gsize nameLen = 0;
-	gchar *name = metautils_message_get_NAME(m, &nameLen);
-	struct cmd_s *c = module_find_handler(name, nameLen);
-	return c != NULL;
-}
-
-static gint
-plugin_handler(MESSAGE m, gint cnx, void *param, GError ** err)
-{
-	(void)param, (void) err;
-	EXTRA_ASSERT (m != NULL);
-
-	gsize nameLen = 0;
-	gchar *name = metautils_message_get_NAME(m, &nameLen);
-	struct cmd_s *c = module_find_handler(name, nameLen);
-	EXTRA_ASSERT (c != NULL);
-
-	struct request_context_s ctx = {0};
-	ctx.request = m;
-	ctx.fd = cnx;
-	gettimeofday(&(ctx.tv_start), NULL);
-
-	g_rec_mutex_lock(&counters_mutex);
-	*(c->req_counter) = *(c->req_counter) + 1;
-	g_rec_mutex_unlock(&counters_mutex);
-
-	return c->h(&ctx);
+	return descriptions;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -1379,22 +1244,19 @@ module_init_known_service_types(struct conscience_s *cs, GHashTable * params, GE
 	return TRUE;
 }
 
-static gint
-plugin_init(GHashTable * params, GError ** err)
+static gboolean
+conscience_configure_with_params(GHashTable * params, GError ** err)
 {
 	gchar *str;
 
-	g_rec_mutex_init(&counters_mutex);
-	g_rec_mutex_init(&conscience_nsinfo_mutex);
-
 	/*NAMEPSACE name */
 	if (!(str = g_hash_table_lookup(params, KEY_NAMESPACE))) {
 		GSETERROR(err, "The configuration must contain a '%s' key with the namespace name", KEY_NAMESPACE);
-		return -1;
+		return FALSE;
 	}
 	if (!(conscience = conscience_create_named(str, err))) {
 		GSETERROR(err, "Conscience allocation failure");
-		return -1;
+		return FALSE;
 	}
 	NOTICE("[NS=%s] Configuring a new conscience", conscience->ns_info.name);
 
@@ -1465,124 +1327,259 @@ plugin_init(GHashTable * params, GError ** err)
 		goto error;
 	}
 
-	/* Plugin/server stuff */
-	if (!srvtimer_register_regular("conscience.expire", timer_expire_services, NULL, conscience, 5LL)) {
-		GSETERROR(err, "Failed to register the conscience's dump callback");
-		goto error;
-	}
-	if (!srvtimer_register_regular("conscience.check", timer_check_services, NULL, conscience, 59LL)) {
-		GSETERROR(err, "Failed to register the conscience's dump callback");
-		goto error;
-	}
-
-	if (!srvtimer_register_regular("conscience.stats", save_counters, NULL, NULL, 5LL)) {
-		GSETERROR(err, "Failed to register the server's statistics callback");
-		goto error;
-	}
-	if (!message_handler_add("conscience", plugin_matcher, plugin_handler, err)) {
-		GSETERROR(err, "Failed to add a new server message handler");
-		goto error;
-	}
-
-	return 1;
+	return TRUE;
 error:
 	conscience_destroy(conscience);
 	conscience = NULL;
-	return -1;
+	return FALSE;
 }
 
+/* Daemon ------------------------------------------------------------------ */
+
+/* The daemon reads the configuration file of the former gridd plugin: the
+ * parameters are in the [Plugin.conscience] group (with the 'param_'
+ * prefix) and the addresses to bind to are the 'listen' key of the
+ * [Server.conscience] group, unless -O Endpoint is given. The other groups
+ * only made sense to gridd and are ignored. */
+#define CFG_GROUP_PLUGIN "Plugin.conscience"
+#define CFG_GROUP_SERVER "Server.conscience"
+#define CFG_PARAM_PREFIX "param_"
+#define CFG_KEY_LISTEN   "listen"
+
+static struct network_server_s *server = NULL;
+static struct gridd_request_dispatcher_s *dispatcher = NULL;
+static struct grid_task_queue_s *gtq_admin = NULL;
+static GThread *th_admin = NULL;
+
+static GSList *urls = NULL;
+static guint max_workers = 0;
+static gint64 cnx_backlog = 0;
+
 static void
-_debug_print_hash(gpointer k, gpointer v, gpointer udata)
+_task_expire_services(gpointer p)
 {
-	(void)udata;
-	NOTICE("options k = [%s] | v = [%s]", (gchar*)k,(gchar*) ((GByteArray*)v)->data);
+	(void) p;
+	timer_expire_services(conscience);
 }
 
-static gint
-plugin_reload(GHashTable * params, GError ** err)
+static void
+_task_check_services(gpointer p)
 {
-	(void) err;
-	gchar *str = NULL;
-	gchar **tmp = NULL;
+	(void) p;
+	timer_check_services(conscience);
+}
 
-	INFO("Reloading conscience configuration");
-	/*CHUNK SIZE */
-	if (!(str = g_hash_table_lookup(params, KEY_CHUNK_SIZE))) {
-		GSETERROR(err, "[NS=%s] Missing key '%s' (chunk size in bytes)",
-		    conscience->ns_info.name, KEY_CHUNK_SIZE);
-		goto error;
+/* The pool of workers only exists once the server runs */
+static void
+_task_reconfigure_workers(gpointer p)
+{
+	(void) p;
+	if (max_workers > 0)
+		network_server_set_max_workers(server, max_workers);
+}
+
+static GHashTable *
+_load_params(GKeyFile *kf, GError **err)
+{
+	gchar **keys = g_key_file_get_keys(kf, CFG_GROUP_PLUGIN, NULL, err);
+	if (!keys) {
+		GSETERROR(err, "No '%s' group in configuration", CFG_GROUP_PLUGIN);
+		return NULL;
 	}
-	conscience->ns_info.chunk_size = g_ascii_strtoll(str, NULL, 10);
-	NOTICE("[NS=%s] Chunk size set to %"G_GINT64_FORMAT, conscience->ns_info.name, conscience->ns_info.chunk_size);
 
-	g_rec_mutex_lock(&conscience_nsinfo_mutex);
+	GHashTable *params = g_hash_table_new_full(g_str_hash, g_str_equal,
+			g_free, g_free);
+	for (gchar **pk = keys; *pk; ++pk) {
+		if (g_ascii_strncasecmp(*pk, CFG_PARAM_PREFIX, sizeof(CFG_PARAM_PREFIX)-1))
+			continue;
+		gchar *v = g_key_file_get_value(kf, CFG_GROUP_PLUGIN, *pk, NULL);
+		if (v)
+			g_hash_table_insert(params,
+					g_strdup(*pk + sizeof(CFG_PARAM_PREFIX)-1), v);
+	}
+	g_strfreev(keys);
+	return params;
+}
 
-	/* OPTIONS reload */
-	/* flush old ns_info_options table */
-	g_hash_table_destroy(conscience->ns_info.options);
+static void
+_cs_action(void)
+{
+	GError *err = NULL;
 
-	if (!module_init_options(conscience, params, err)) {
-		GSETERROR(err, "[NS=%s] options init failed", conscience->ns_info.name);
+	if (NULL != (err = network_server_open_servers(server))) {
+		GRID_ERROR("Server opening error: (%d) %s", err->code, err->message);
 		goto error;
 	}
 
-	/* storage conf reload */
-	g_hash_table_destroy(conscience->ns_info.storage_policy);
-	g_hash_table_destroy(conscience->ns_info.data_security);
-	g_hash_table_destroy(conscience->ns_info.data_treatments);
-	g_hash_table_destroy(conscience->ns_info.storage_class);
-	*err = module_init_storage_conf(conscience, namespace_storage_policy(&conscience->ns_info, conscience->ns_info.name),
-			g_hash_table_lookup(params, KEY_STG_CONF));
-	if( NULL != *err ) {
-		g_prefix_error(err, "[NS=%s] storage conf init failed", conscience->ns_info.name);
+	grid_task_queue_fire(gtq_admin);
+	if (!(th_admin = grid_task_queue_run(gtq_admin, &err))) {
+		GRID_ERROR("Admin thread startup error: (%d) %s", err->code, err->message);
 		goto error;
 	}
 
-	NOTICE("[NS=%s] options reloaded", conscience->ns_info.name);
+	if (NULL != (err = network_server_run(server))) {
+		GRID_ERROR("Server run error: (%d) %s", err->code, err->message);
+		goto error;
+	}
+	return;
+error:
+	g_clear_error(&err);
+	grid_main_set_status(1);
+}
+
+static struct grid_main_option_s *
+_cs_get_options(void)
+{
+	static struct grid_main_option_s options[] = {
+		{"Endpoint", OT_LIST, {.lst = &urls},
+			"Bind to this IP:PORT (default: the 'listen' addresses of the "
+			"[" CFG_GROUP_SERVER "] group)"},
+		{"MaxWorkers", OT_UINT, {.u = &max_workers},
+			"Maximum number of worker threads (0 for the server's default)"},
+		{"CnxBacklog", OT_INT64, {.i64 = &cnx_backlog},
+			"Number of connections allowed to wait in the listen queue"},
+		{NULL, 0, {.i = 0}, NULL}
+	};
+	return options;
+}
+
+static void
+_cs_set_defaults(void)
+{
+	urls = NULL;
+	max_workers = 0;
+	cnx_backlog = 0;
+	server = network_server_init();
+	gtq_admin = grid_task_queue_create("admin");
+}
+
+static gboolean
+_cs_configure(int argc, char **argv)
+{
+	GError *err = NULL;
+
+	if (argc != 1) {
+		GRID_ERROR("Missing mandatory parameter");
+		return FALSE;
+	}
 
-	g_hash_table_foreach(conscience->ns_info.options, _debug_print_hash, NULL);
+	GKeyFile *kf = g_key_file_new();
+	if (!g_key_file_load_from_file(kf, argv[0], G_KEY_FILE_NONE, &err)) {
+		GRID_ERROR("Configuration error [%s]: %s", argv[0], err->message);
+		g_clear_error(&err);
+		g_key_file_free(kf);
+		return FALSE;
+	}
 
-	NOTICE("[NS=%s] virtual namespaces reloaded", conscience->ns_info.name);
+	if (!urls) {
+		gchar **listen = g_key_file_get_string_list(kf, CFG_GROUP_SERVER,
+				CFG_KEY_LISTEN, NULL, NULL);
+		for (gchar **pl = listen; pl && *pl; ++pl)
+			urls = g_slist_append(urls, g_strdup(g_strstrip(*pl)));
+		if (listen)
+			g_strfreev(listen);
+	}
+	if (!urls) {
+		GRID_ERROR("No URL configured");
+		g_key_file_free(kf);
+		return FALSE;
+	}
 
-	g_rec_mutex_unlock(&conscience_nsinfo_mutex);
+	GHashTable *params = _load_params(kf, &err);
+	g_key_file_free(kf);
+	if (!params || !conscience_configure_with_params(params, &err)) {
+		GRID_ERROR("Configuration error [%s]: %s", argv[0],
+				gerror_get_message(err));
+		g_clear_error(&err);
+		if (params)
+			g_hash_table_destroy(params);
+		return FALSE;
+	}
+	g_hash_table_destroy(params);
 
-	if(tmp)
-		g_strfreev(tmp);
+	/* the common requests are already there */
+	dispatcher = transport_gridd_build_empty_dispatcher();
+	err = transport_gridd_dispatcher_add_requests(dispatcher,
+			conscience_get_requests(), NULL);
+	if (err) {
+		GRID_ERROR("Requests registration error: (%d) %s",
+				err->code, err->message);
+		g_clear_error(&err);
+		return FALSE;
+	}
 
-	return 1;
+	if (cnx_backlog > 0)
+		network_server_set_cnx_backlog(server, cnx_backlog);
+	for (GSList *l = urls; l; l = l->next) {
+		GRID_NOTICE("Binding to [%s]", (gchar *) l->data);
+		grid_daemon_bind_host(server, l->data, dispatcher);
+	}
 
-error:
-	if(tmp)
-		g_strfreev(tmp);
+	grid_task_queue_register(gtq_admin, 1, _task_reconfigure_workers, NULL, NULL);
+	grid_task_queue_register(gtq_admin, 5, _task_expire_services, NULL, NULL);
+	grid_task_queue_register(gtq_admin, 59, _task_check_services, NULL, NULL);
+	return TRUE;
+}
 
-	return -1;
+static const char *
+_cs_get_usage(void)
+{
+	return "CONFIG_FILE";
+}
 
+static void
+_cs_specific_stop(void)
+{
+	if (gtq_admin)
+		grid_task_queue_stop(gtq_admin);
+	if (server)
+		network_server_stop(server);
 }
 
-static gint
-plugin_close(GError ** err)
+static void
+_cs_specific_fini(void)
 {
-	(void)err;
+	/* stop phase */
+	_cs_specific_stop();
+	if (th_admin) {
+		g_thread_join(th_admin);
+		th_admin = NULL;
+	}
+	if (server)
+		network_server_close_servers(server);
+
+	/* clean phase */
+	if (server) {
+		network_server_clean(server);
+		server = NULL;
+	}
+	if (dispatcher) {
+		gridd_request_dispatcher_clean(dispatcher);
+		dispatcher = NULL;
+	}
+	if (gtq_admin) {
+		grid_task_queue_destroy(gtq_admin);
+		gtq_admin = NULL;
+	}
 	if (conscience) {
-		g_rec_mutex_clear(&counters_mutex);
 		conscience_destroy(conscience);
 		conscience = NULL;
 	}
-	return 1;
+	g_slist_free_full(urls, g_free);
+	urls = NULL;
 }
 
-struct exported_api_s exported_symbol = {
-	MODULE_NAME,
-	plugin_init,
-	plugin_close,
-	NULL,
-	NULL
-};
-
-struct exported_api_s exported_symbol_v2 = {
-	MODULE_NAME,
-	plugin_init,
-	plugin_close,
-	NULL,
-	plugin_reload
-};
+int
+main(int argc, char **argv)
+{
+	struct grid_main_callbacks callbacks = {
+		.options = _cs_get_options,
+		.action = _cs_action,
+		.set_defaults = _cs_set_defaults,
+		.specific_fini = _cs_specific_fini,
+		.configure = _cs_configure,
+		.usage = _cs_get_usage,
+		.specific_stop = _cs_specific_stop,
+	};
+	return grid_main(argc, argv, &callbacks);
+}
@@ -59,6 +59,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 # define TIME_DEFAULT_ALERT_LIMIT 300L
 
+/* Number of expired services removed under a single writer lock */
+# define EXPIRE_BATCH_SIZE 64
+
 # define EXPR_DEFAULT_META0 "100"
 # define EXPR_DEFAULT_META1 "root(2,((num stat.cpu)*(num stat.io)))"
 # define EXPR_DEFAULT_META2 "root(2,((num stat.cpu)*(num stat.io)))"
@@ -0,0 +1,326 @@
+/*
+OpenIO SDS core library
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "oiohash.h"
+#include "oiolog.h"
+#include "oiostr.h"
+
+/* XXH64, after the reference implementation by Yann Collet ----------------- */
+
+#define P64_1 0x9E3779B185EBCA87ULL
+#define P64_2 0xC2B2AE3D27D4EB4FULL
+#define P64_3 0x165667B19E3779F9ULL
+#define P64_4 0x85EBCA77C2B2AE63ULL
+#define P64_5 0x27D4EB2F165667C5ULL
+
+#define ROTL64(x,r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+struct xxh64_s
+{
+	guint64 total;
+	guint64 v[4];
+	guint8 mem[32];
+	guint memsize;
+};
+
+static inline guint64
+_read64 (const guint8 *p)
+{
+	guint64 v;
+	memcpy (&v, p, sizeof(v));
+	return GUINT64_FROM_LE(v);
+}
+
+static inline guint32
+_read32 (const guint8 *p)
+{
+	guint32 v;
+	memcpy (&v, p, sizeof(v));
+	return GUINT32_FROM_LE(v);
+}
+
+static inline guint64
+_xxh64_round (guint64 acc, guint64 input)
+{
+	acc += input * P64_2;
+	acc = ROTL64(acc, 31);
+	return acc * P64_1;
+}
+
+static inline guint64
+_xxh64_merge (guint64 acc, guint64 val)
+{
+	acc ^= _xxh64_round (0, val);
+	return acc * P64_1 + P64_4;
+}
+
+static void
+_xxh64_init (struct xxh64_s *s)
+{
+	memset (s, 0, sizeof(*s));
+	s->v[0] = P64_1 + P64_2;
+	s->v[1] = P64_2;
+	s->v[2] = 0;
+	s->v[3] = -P64_1;
+}
+
+static const guint8 *
+_xxh64_stripes (struct xxh64_s *s, const guint8 *p, const guint8 *end)
+{
+	guint64 v0 = s->v[0], v1 = s->v[1], v2 = s->v[2], v3 = s->v[3];
+	for (; p + 32 <= end ;p += 32) {
+		v0 = _xxh64_round (v0, _read64 (p));
+		v1 = _xxh64_round (v1, _read64 (p + 8));
+		v2 = _xxh64_round (v2, _read64 (p + 16));
+		v3 = _xxh64_round (v3, _read64 (p + 24));
+	}
+	s->v[0] = v0, s->v[1] = v1, s->v[2] = v2, s->v[3] = v3;
+	return p;
+}
+
+static void
+_xxh64_update (struct xxh64_s *s, const guint8 *p, gsize len)
+{
+	const guint8 *end = p + len;
+	s->total += len;
+
+	if (s->memsize + len < 32) {
+		memcpy (s->mem + s->memsize, p, len);
+		s->memsize += len;
+		return;
+	}
+	if (s->memsize) {
+		gsize fill = 32 - s->memsize;
+		memcpy (s->mem + s->memsize, p, fill);
+		_xxh64_stripes (s, s->mem, s->mem + 32);
+		p += fill;
+		s->memsize = 0;
+	}
+	p = _xxh64_stripes (s, p, end);
+	if (p < end) {
+		memcpy (s->mem, p, end - p);
+		s->memsize = end - p;
+	}
+}
+
+static guint64
+_xxh64_digest (const struct xxh64_s *s)
+{
+	guint64 h;
+	if (s->total >= 32) {
+		h = ROTL64(s->v[0], 1) + ROTL64(s->v[1], 7)
+			+ ROTL64(s->v[2], 12) + ROTL64(s->v[3], 18);
+		for (int i=0; i<4 ;++i)
+			h = _xxh64_merge (h, s->v[i]);
+	} else {
+		h = s->v[2] + P64_5;
+	}
+	h += s->total;
+
+	const guint8 *p = s->mem, *end = s->mem + s->memsize;
+	for (; p + 8 <= end ;p += 8) {
+		h ^= _xxh64_round (0, _read64 (p));
+		h = ROTL64(h, 27) * P64_1 + P64_4;
+	}
+	if (p + 4 <= end) {
+		h ^= (guint64)_read32 (p) * P64_1;
+		h = ROTL64(h, 23) * P64_2 + P64_3;
+		p += 4;
+	}
+	for (; p < end ;++p) {
+		h ^= (*p) * P64_5;
+		h = ROTL64(h, 11) * P64_1;
+	}
+
+	h ^= h >> 33;
+	h *= P64_2;
+	h ^= h >> 29;
+	h *= P64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+/* -------------------------------------------------------------------------- */
+
+struct oio_hash_s
+{
+	enum oio_hash_algo_e algo;
+	union {
+		GChecksum *checksum;
+		struct xxh64_s xxh64;
+	} u;
+	gchar str[OIO_HASH_STRLEN];
+};
+
+static const char * const algo_names[OIO_HASH_MAX] = {
+	"md5", "sha256", "xxh64"
+};
+
+const char *
+oio_hash_algo_name (enum oio_hash_algo_e algo)
+{
+	g_assert (algo < OIO_HASH_MAX);
+	return algo_names[algo];
+}
+
+gboolean
+oio_hash_algo_parse (const char *name, enum oio_hash_algo_e *out)
+{
+	g_assert (out != NULL);
+	if (!name)
+		return FALSE;
+	for (guint i=0; i<OIO_HASH_MAX ;++i) {
+		if (!g_ascii_strcasecmp (name, algo_names[i])) {
+			*out = i;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+enum oio_hash_algo_e
+oio_hash_algo_of_chunk_method (const char *method)
+{
+	enum oio_hash_algo_e algo = OIO_HASH_MD5;
+	const char *params;
+	if (!method || !(params = strchr (method, '?')))
+		return algo;
+
+	gchar **tokens = g_strsplit (params + 1, "&", -1);
+	for (gchar **t = tokens; *t ;++t) {
+		gchar *eq = strchr (*t, '=');
+		if (!eq)
+			continue;
+		*eq = '\0';
+		if (!strcmp (*t, OIO_HASH_CHUNK_METHOD_PARAM)) {
+			if (!oio_hash_algo_parse (eq + 1, &algo))
+				GRID_WARN("Unknown chunk hash [%s], MD5 used", eq + 1);
+			break;
+		}
+	}
+	g_strfreev (tokens);
+	return algo;
+}
+
+gsize
+oio_hash_algo_length (enum oio_hash_algo_e algo)
+{
+	switch (algo) {
+		case OIO_HASH_MD5:
+			return g_checksum_type_get_length (G_CHECKSUM_MD5);
+		case OIO_HASH_SHA256:
+			return g_checksum_type_get_length (G_CHECKSUM_SHA256);
+		case OIO_HASH_XXH64:
+			return sizeof(guint64);
+		default:
+			g_assert_not_reached ();
+	}
+	return 0;
+}
+
+struct oio_hash_s *
+oio_hash_new (enum oio_hash_algo_e algo)
+{
+	struct oio_hash_s *h = g_malloc0 (sizeof(*h));
+	h->algo = algo;
+	switch (algo) {
+		case OIO_HASH_MD5:
+			h->u.checksum = g_checksum_new (G_CHECKSUM_MD5);
+			break;
+		case OIO_HASH_SHA256:
+			h->u.checksum = g_checksum_new (G_CHECKSUM_SHA256);
+			break;
+		case OIO_HASH_XXH64:
+			_xxh64_init (&h->u.xxh64);
+			break;
+		default:
+			g_assert_not_reached ();
+	}
+	return h;
+}
+
+struct oio_hash_s *
+oio_hash_copy (const struct oio_hash_s *h)
+{
+	g_assert (h != NULL);
+	struct oio_hash_s *copy = g_memdup (h, sizeof(*h));
+	if (h->algo != OIO_HASH_XXH64)
+		copy->u.checksum = g_checksum_copy (h->u.checksum);
+	return copy;
+}
+
+void
+oio_hash_free (struct oio_hash_s *h)
+{
+	if (!h)
+		return;
+	if (h->algo != OIO_HASH_XXH64 && h->u.checksum)
+		g_checksum_free (h->u.checksum);
+	g_free (h);
+}
+
+enum oio_hash_algo_e
+oio_hash_get_algo (const struct oio_hash_s *h)
+{
+	g_assert (h != NULL);
+	return h->algo;
+}
+
+void
+oio_hash_update (struct oio_hash_s *h, const void *data, gsize len)
+{
+	g_assert (h != NULL);
+	g_assert (!h->str[0]);
+	if (h->algo == OIO_HASH_XXH64)
+		_xxh64_update (&h->u.xxh64, data, len);
+	else
+		g_checksum_update (h->u.checksum, data, len);
+}
+
+const char *
+oio_hash_get_string (struct oio_hash_s *h)
+{
+	g_assert (h != NULL);
+	if (!h->str[0]) {
+		if (h->algo == OIO_HASH_XXH64) {
+			/* the canonical form is big-endian */
+			guint64 v = GUINT64_TO_BE(_xxh64_digest (&h->u.xxh64));
+			oio_str_bin2hex (&v, sizeof(v), h->str, sizeof(h->str));
+		} else {
+			g_strlcpy (h->str, g_checksum_get_string (h->u.checksum),
+					sizeof(h->str));
+			oio_str_upper (h->str);
+		}
+	}
+	return h->str;
+}
+
+gchar *
+oio_hash_compute_for_data (enum oio_hash_algo_e algo,
+		const void *data, gsize len)
+{
+	struct oio_hash_s *h = oio_hash_new (algo);
+	oio_hash_update (h, data, len);
+	gchar *result = g_strdup (oio_hash_get_string (h));
+	oio_hash_free (h);
+	return result;
+}
@@ -107,8 +107,10 @@ GError * oio_proxy_call_container_create (CURL *h, struct oio_url_s *u);
 GError * oio_proxy_call_container_get_properties (CURL *h,
     struct oio_url_s *u, GString **props_str);
 
+/* <out_chunk_method> is optional, it receives the chunk method of the
+ * content when the proxy tells it. */
 GError * oio_proxy_call_content_show (CURL *h, struct oio_url_s *u,
-		GString *out);
+		GString *out, gchar **out_chunk_method);
 
 GError * oio_proxy_call_content_delete (CURL *h, struct oio_url_s *u);
 
@@ -142,6 +144,17 @@ struct oio_proxy_content_create_in_s
 GError * oio_proxy_call_content_create (CURL *h, struct oio_url_s *u,
 		struct oio_proxy_content_create_in_s *in, GString *out);
 
+/* <in> is a JSON array of contents of the container of <u>, each described
+ * as an object. <out> receives a JSON array with the status of each content,
+ * in the same order. */
+GError * oio_proxy_call_content_create_many (CURL *h, struct oio_url_s *u,
+		GString *in, GString *out);
+
+/* <in> is a JSON array of paths in the container of <u>. <out> receives a
+ * JSON array with the status of each path, in the same order. */
+GError * oio_proxy_call_content_delete_many (CURL *h, struct oio_url_s *u,
+		GString *in, GString *out);
+
 GError * oio_proxy_call_content_list (CURL *h, struct oio_url_s *u,
 		GString *out,
 		const char *prefix, const char *marker, const char *end,
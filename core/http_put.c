@@ -20,7 +20,6 @@ License along with this library.
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
-#include <poll.h>
 
 #include <glib.h>
 #include <glib/gstdio.h>
@@ -67,19 +66,33 @@ struct http_put_dest_s
 	/* user data corresponding to this destination */
 	gpointer user_data;
 
+	/* the buffer being sent, and the absolute index of the next one in the
+	 * shared queue of the upload */
 	GBytes *buffer;
+	guint64 next_buffer;
 
 	/* HTTP error code (valid if success == 1) */
 	gint64 bytes_sent;
 	guint http_code;
 	enum http_single_put_e state;
+
+	/* aborted because late, the replica will need a repair */
+	gboolean straggler;
+};
+
+/* The I/O loop, maybe shared by several uploads */
+struct http_put_loop_s
+{
+	CURLM *handle;
+	guint refcount;
 };
 
 struct http_put_s
 {
 	GSList *dests; /* <struct http_put_dest_s*> */
 
-	CURLM *mhandle;
+	struct http_put_loop_s *loop;
+	CURLM *mhandle; /* loop->handle */
 
 	long timeout_cnx;
 	long timeout_op;
@@ -100,7 +113,23 @@ struct http_put_s
 	 * <soft_length> and decreases for each buffer enqueued. */
 	gint64 remaining_length;
 
-	GQueue *buffer_tail; /* <GBytes*> */
+	/* The buffers not yet sent to each destination. Each destination
+	 * consumes them at its own pace, the first one is kept until the slowest
+	 * destination took it. <first_buffer> is the absolute index of the first
+	 * element. */
+	GPtrArray *buffers; /* <GBytes*> */
+	guint64 first_buffer;
+	gsize queued_bytes;
+
+	/* How many buffers the fastest destination may be ahead of the slowest */
+	guint max_lag;
+
+	/* How many destinations must succeed for the upload to complete. The
+	 * others have <straggler_delay> more to complete, then they are aborted.
+	 * 0 means all of them. */
+	guint quorum;
+	gint64 straggler_delay;
+	gint64 quorum_time;
 
 	enum http_whole_put_state_e state;
 };
@@ -139,6 +168,13 @@ destroy_curl(void)
 
 struct http_put_s *
 http_put_create(gint64 content_length, gint64 soft_length)
+{
+	return http_put_create_sibling (NULL, content_length, soft_length);
+}
+
+struct http_put_s *
+http_put_create_sibling(struct http_put_s *sibling,
+		gint64 content_length, gint64 soft_length)
 {
 	/* sanity checks */
 	if (soft_length < 0 && content_length >= 0)
@@ -150,8 +186,20 @@ http_put_create(gint64 content_length, gint64 soft_length)
 
 	struct http_put_s *p = g_try_malloc0(sizeof(struct http_put_s));
 	p->dests = NULL;
-	p->mhandle = curl_multi_init();
-	p->buffer_tail = g_queue_new();
+	if (sibling) {
+		p->loop = sibling->loop;
+	} else {
+		p->loop = g_malloc0 (sizeof(struct http_put_loop_s));
+		p->loop->handle = curl_multi_init();
+	}
+	p->loop->refcount ++;
+	p->mhandle = p->loop->handle;
+	p->buffers = g_ptr_array_new_with_free_func ((GDestroyNotify)g_bytes_unref);
+	p->first_buffer = 0;
+	p->max_lag = HTTP_PUT_DEFAULT_MAX_LAG;
+	p->quorum = 0;
+	p->straggler_delay = HTTP_PUT_DEFAULT_STRAGGLER_DELAY;
+	p->quorum_time = 0;
 	p->timeout_cnx = 60;
 	p->timeout_op = 60;
 	p->content_length = content_length;
@@ -160,6 +208,22 @@ http_put_create(gint64 content_length, gint64 soft_length)
 	return p;
 }
 
+void
+http_put_set_quorum (struct http_put_s *p, guint quorum, gint64 delay)
+{
+	g_assert (p != NULL);
+	g_assert (p->state == HTTP_WHOLE_BEGIN);
+	p->quorum = quorum;
+	p->straggler_delay = MAX(0, delay);
+}
+
+void
+http_put_set_max_lag (struct http_put_s *p, guint max_lag)
+{
+	g_assert (p != NULL);
+	p->max_lag = MAX(1, max_lag);
+}
+
 struct http_put_dest_s *
 http_put_add_dest(struct http_put_s *p, const char *url, gpointer u)
 {
@@ -240,11 +304,13 @@ http_put_destroy(struct http_put_s *p)
 		return;
 	if (p->dests)
 		g_slist_free_full(p->dests, http_put_dest_destroy);
-	if (p->mhandle)
-		curl_multi_cleanup(p->mhandle);
-	if (p->buffer_tail) {
-		g_queue_free_full(p->buffer_tail, (GDestroyNotify)g_bytes_unref);
-		p->buffer_tail = NULL;
+	if (p->loop && !(-- p->loop->refcount)) {
+		curl_multi_cleanup(p->loop->handle);
+		g_free(p->loop);
+	}
+	if (p->buffers) {
+		g_ptr_array_free(p->buffers, TRUE);
+		p->buffers = NULL;
 	}
 	g_free(p);
 }
@@ -267,7 +333,8 @@ http_put_feed (struct http_put_s *p, GBytes *b)
 	GRID_TRACE("%s (%p) <- %"G_GSIZE_FORMAT, __FUNCTION__, p, len);
 	g_assert (len <= 0 || p->remaining_length < 0 || len <= p->remaining_length);
 
-	g_queue_push_tail (p->buffer_tail, b);
+	g_ptr_array_add (p->buffers, b);
+	p->queued_bytes += len;
 
 	if (!len) { /* marker for end of stream */
 		p->remaining_length = 0;
@@ -276,6 +343,13 @@ http_put_feed (struct http_put_s *p, GBytes *b)
 	}
 }
 
+gsize
+http_put_queued_bytes (struct http_put_s *p)
+{
+	g_assert (p != NULL);
+	return p->queued_bytes;
+}
+
 gboolean
 http_put_done (struct http_put_s *p)
 {
@@ -283,6 +357,19 @@ http_put_done (struct http_put_s *p)
 	return p->state == HTTP_WHOLE_FINISHED;
 }
 
+guint
+http_put_get_straggler_number(struct http_put_s *p)
+{
+	g_assert(p != NULL);
+	guint ret = 0;
+	for (GSList *l = p->dests ; NULL != l ; l = l->next) {
+		struct http_put_dest_s *d = l->data;
+		if (d->straggler)
+			ret++;
+	}
+	return ret;
+}
+
 guint
 http_put_get_failure_number(struct http_put_s *p)
 {
@@ -334,6 +421,64 @@ http_put_get_md5(struct http_put_s *p, guint8 *buffer, gsize size)
 
 /* -------------------------------------------------------------------------- */
 
+/* The absolute index of the next buffer wanted by the slowest destination
+ * still running. */
+static guint64
+_slowest_buffer (struct http_put_s *p)
+{
+	guint64 slowest = p->first_buffer + p->buffers->len;
+	for (GSList *l=p->dests; l ;l=l->next) {
+		struct http_put_dest_s *d = l->data;
+		if (d->state < HTTP_SINGLE_FINISHED)
+			slowest = MIN(slowest, d->next_buffer);
+	}
+	return slowest;
+}
+
+static guint64
+_fastest_buffer (struct http_put_s *p)
+{
+	guint64 fastest = p->first_buffer;
+	for (GSList *l=p->dests; l ;l=l->next) {
+		struct http_put_dest_s *d = l->data;
+		if (d->state < HTTP_SINGLE_FINISHED)
+			fastest = MAX(fastest, d->next_buffer);
+	}
+	return fastest;
+}
+
+/* Give the next buffer to <dest>, unless it is already sending one, or
+ * it is too far ahead of the slowest destination. */
+static gboolean
+_dest_take_buffer (struct http_put_dest_s *dest)
+{
+	struct http_put_s *p = dest->http_put;
+	if (dest->buffer)
+		return TRUE;
+	if (dest->next_buffer >= p->first_buffer + p->buffers->len)
+		return FALSE;
+	if (dest->next_buffer - _slowest_buffer (p) >= p->max_lag)
+		return FALSE;
+	dest->buffer = g_bytes_ref (
+			p->buffers->pdata[dest->next_buffer - p->first_buffer]);
+	dest->next_buffer ++;
+	return TRUE;
+}
+
+/* Drop the buffers that every running destination already took */
+static void
+_release_buffers (struct http_put_s *p)
+{
+	const guint64 slowest = _slowest_buffer (p);
+	if (slowest > p->first_buffer) {
+		for (guint64 i = p->first_buffer; i < slowest; ++i)
+			p->queued_bytes -= g_bytes_get_size (
+					p->buffers->pdata[i - p->first_buffer]);
+		g_ptr_array_remove_range (p->buffers, 0, slowest - p->first_buffer);
+		p->first_buffer = slowest;
+	}
+}
+
 static size_t
 _done_reading (struct http_put_dest_s *dest, const char *why)
 {
@@ -359,7 +504,7 @@ cb_read(void *data, size_t s, size_t n, struct http_put_dest_s *dest)
 		if (dest->bytes_sent >= dest->http_put->content_length)
 			return _done_reading (dest, "body done");
 	}
-	if (!dest->buffer) {
+	if (!_dest_take_buffer (dest)) {
 		dest->state = HTTP_SINGLE_PAUSED;
 		return CURL_READFUNC_PAUSE;
 	}
@@ -466,6 +611,7 @@ _start_upload(struct http_put_s *p)
 	}
 }
 
+/* The loop may be shared, the events may concern the siblings of <p> */
 static void
 _manage_curl_events (struct http_put_s *p)
 {
@@ -494,7 +640,8 @@ _manage_curl_events (struct http_put_s *p)
 			GRID_TRACE("DONE [%s] code=%ld strerror=%s",
 					dest->url, http_ret, curl_easy_strerror(curl_ret));
 
-			CURLMcode rc = curl_multi_remove_handle(p->mhandle, dest->handle);
+			CURLMcode rc = curl_multi_remove_handle(dest->http_put->mhandle,
+					dest->handle);
 			g_assert(rc == CURLM_OK);
 			curl_easy_cleanup(dest->handle);
 			dest->handle = NULL;
@@ -516,48 +663,93 @@ _count_up_dests (struct http_put_s *p)
 	return count;
 }
 
-GError *
-http_put_step (struct http_put_s *p)
+static guint
+_count_ok_dests (struct http_put_s *p)
 {
-	int rc;
-	guint count_dests = 0, count_up = 0, count_waiting_for_data = 0;
-
-	g_assert (p != NULL);
-
-	if (!p->dests) {
-		GRID_TRACE("%s Empty upload detected", __FUNCTION__);
-		p->state = HTTP_WHOLE_FINISHED;
-		return NULL;
+	guint count = 0;
+	for (GSList *l=p->dests; l ;l=l->next) {
+		struct http_put_dest_s *d = l->data;
+		if (d->state == HTTP_SINGLE_FINISHED && d->http_code / 100 == 2)
+			count ++;
 	}
-	if (p->state == HTTP_WHOLE_FINISHED) {
-		GRID_TRACE("%s BUG: Stepping on a finished upload", __FUNCTION__);
-		return NULL;
+	return count;
+}
+
+static void
+_abort_straggler (struct http_put_dest_s *d, const char *why)
+{
+	GRID_WARN("Upload to [%s] aborted (%s), the replica needs a repair",
+			d->url, why);
+	CURLMcode rc = curl_multi_remove_handle(d->http_put->mhandle, d->handle);
+	g_assert(rc == CURLM_OK);
+	curl_easy_cleanup(d->handle);
+	d->handle = NULL;
+	if (d->buffer) {
+		g_bytes_unref(d->buffer);
+		d->buffer = NULL;
 	}
+	d->state = HTTP_SINGLE_FINISHED;
+	d->http_code = 0;
+	d->straggler = TRUE;
+}
 
-	count_dests = g_slist_length(p->dests);
-	GRID_TRACE("%s STEP on %u destinations", __FUNCTION__, count_dests);
+/* When a quorum is set, the destinations that lag too much behind the
+ * fastest are aborted, as long as the quorum remains reachable. When the
+ * quorum is reached, the destinations still running have a little delay
+ * to complete. */
+static void
+_manage_stragglers (struct http_put_s *p, guint count_dests)
+{
+	if (!p->quorum || p->quorum >= count_dests)
+		return;
 
-	/* consume the CURL notifications for terminated actions */
-	_manage_curl_events(p);
+	guint ok = _count_ok_dests (p);
+	if (ok >= p->quorum) {
+		const gint64 now = oio_ext_monotonic_time ();
+		if (!p->quorum_time)
+			p->quorum_time = now;
+		if (now - p->quorum_time < p->straggler_delay)
+			return;
+		for (GSList *l=p->dests; l ;l=l->next) {
+			struct http_put_dest_s *d = l->data;
+			if (d->state < HTTP_SINGLE_FINISHED)
+				_abort_straggler (d, "quorum reached");
+		}
+		return;
+	}
 
-	/* Ensure the data-pipe doesn't become empty and maybe call for more */
+	const guint64 fastest = _fastest_buffer (p);
+	guint up = _count_up_dests (p);
 	for (GSList *l=p->dests; l ;l=l->next) {
 		struct http_put_dest_s *d = l->data;
-		if (d->state == HTTP_SINGLE_FINISHED)
+		if (d->state >= HTTP_SINGLE_FINISHED)
 			continue;
-		if (!d->buffer && d->state < HTTP_SINGLE_FINISHED)
-			count_waiting_for_data ++;
-	}
-	if (count_waiting_for_data >= count_dests) {
-		GBytes *buf = g_queue_pop_head (p->buffer_tail);
-		if (buf) {
-			for (GSList *l=p->dests; l ;l=l->next) {
-				struct http_put_dest_s *d = l->data;
-				d->buffer = g_bytes_ref (buf);
-			}
-			g_bytes_unref (buf);
+		if (ok + up <= p->quorum)
+			break;
+		if (fastest - d->next_buffer >= p->max_lag) {
+			_abort_straggler (d, "too late");
+			up --;
 		}
 	}
+}
+
+static gboolean
+_quorum_reached (struct http_put_s *p, guint count_dests)
+{
+	if (!p->quorum || p->quorum >= count_dests)
+		return FALSE;
+	return _count_ok_dests (p) >= p->quorum;
+}
+
+/* Prepares <p> for the next I/O round, and returns how many of its
+ * transfers may progress. */
+static guint
+_step_prepare (struct http_put_s *p)
+{
+	guint count_dests = g_slist_length(p->dests), count_active = 0;
+	GRID_TRACE("%s STEP on %u destinations", __FUNCTION__, count_dests);
+
+	_manage_stragglers(p, count_dests);
 
 	if (p->state == HTTP_WHOLE_BEGIN) {
 		GRID_TRACE("%s Starting %u uploads", __FUNCTION__, count_dests);
@@ -565,64 +757,121 @@ http_put_step (struct http_put_s *p)
 		p->state = HTTP_WHOLE_READY;
 	}
 
-	/* pause CURL actions that have no data to manage immediately,
-	 * and ensure the action with data ready are registered. */
+	/* Each destination takes the next buffer at its own pace, within the
+	 * lag window. Resume the paused ones that now have data to send. */
 	for (GSList *l=p->dests; l ;l=l->next) {
 		struct http_put_dest_s *d = l->data;
 		if (d->state == HTTP_SINGLE_FINISHED)
 			continue;
 		GRID_TRACE("%s %p %d/%s %s", __FUNCTION__, d->buffer,
 				d->state, _single_put_state_to_string(d->state), d->url);
-		if (d->buffer) {
-			if (d->state == HTTP_SINGLE_PAUSED) {
-				curl_easy_pause (d->handle, CURLPAUSE_CONT);
-				d->state = d->bytes_sent ? HTTP_SINGLE_REQUEST : HTTP_SINGLE_BEGIN;
-			}
+		if (d->state == HTTP_SINGLE_PAUSED && _dest_take_buffer (d)) {
+			curl_easy_pause (d->handle, CURLPAUSE_CONT);
+			d->state = d->bytes_sent ? HTTP_SINGLE_REQUEST : HTTP_SINGLE_BEGIN;
 		}
+		if (d->state != HTTP_SINGLE_PAUSED)
+			count_active ++;
 	}
+	_release_buffers (p);
 
-	count_up= _count_up_dests (p);
+	guint count_up = _count_up_dests (p);
 	p->state = count_up ? HTTP_WHOLE_READY : HTTP_WHOLE_PAUSED;
 
-	GRID_TRACE("%s Uploads: %u total, %u up (%u wanted to data)",
-			__FUNCTION__, count_dests, count_up, count_waiting_for_data);
-
-	if (count_up) {
-		fd_set fdread, fdwrite, fdexcep;
-		int maxfd = -1;
-		struct timeval tv = {1,0};
-		FD_ZERO(&fdread);
-		FD_ZERO(&fdwrite);
-		FD_ZERO(&fdexcep);
-
-		long timeout = 0;
-		curl_multi_timeout (p->mhandle, &timeout);
-		if (timeout < 1000) {
-			tv.tv_sec = 0;
-			tv.tv_usec = timeout * 1000;
-		}
-		curl_multi_fdset(p->mhandle, &fdread, &fdwrite, &fdexcep, &maxfd);
+	GRID_TRACE("%s Uploads: %u total, %u up, %u active",
+			__FUNCTION__, count_dests, count_up, count_active);
+	return count_active;
+}
+
+static void
+_step_finish (struct http_put_s *p)
+{
+	guint count_dests = g_slist_length(p->dests);
+	if (_quorum_reached (p, count_dests))
+		_manage_stragglers (p, count_dests);
+	if (!_count_up_dests (p)) {
+		GRID_TRACE("%s uploads finishing", __FUNCTION__);
+		_release_buffers (p);
+		p->state = HTTP_WHOLE_FINISHED;
+	}
+}
 
-retry:
-		rc = select(maxfd+1, &fdread, &fdwrite, &fdexcep, &tv);
-		if (rc < 0) {
-			if (errno == EINTR) goto retry;
-			return SYSERR("select() error: (%d) %s", errno, strerror(errno));
+/* How long (in ms) the I/O may wait before <p> needs a new step */
+static int
+_step_timeout (struct http_put_s *p)
+{
+	if (!p->quorum_time)
+		return 1000;
+	gint64 left = p->straggler_delay -
+		(oio_ext_monotonic_time() - p->quorum_time);
+	return CLAMP(left / G_TIME_SPAN_MILLISECOND, 1, 1000);
+}
+
+GError *
+http_put_step_many (struct http_put_s **puts)
+{
+	CURLM *mhandle = NULL;
+	guint count_active = 0;
+	int timeout = 1000;
+
+	g_assert (puts != NULL);
+
+	for (struct http_put_s **pp=puts; *pp ;++pp) {
+		struct http_put_s *p = *pp;
+		if (!p->dests) {
+			GRID_TRACE("%s Empty upload detected", __FUNCTION__);
+			p->state = HTTP_WHOLE_FINISHED;
+			continue;
+		}
+		if (p->state == HTTP_WHOLE_FINISHED) {
+			GRID_TRACE("%s BUG: Stepping on a finished upload", __FUNCTION__);
+			continue;
 		}
+		g_assert (!mhandle || mhandle == p->mhandle);
+		mhandle = p->mhandle;
+
+		/* consume the CURL notifications for terminated actions */
+		_manage_curl_events(p);
+		count_active += _step_prepare(p);
+		timeout = MIN(timeout, _step_timeout(p));
+	}
+	if (!mhandle)
+		return NULL;
+
+	/* Wait for I/O only when a transfer may progress, the paused ones wait
+	 * for the caller to feed more data. */
+	if (count_active) {
+		int numfds = 0;
+#if LIBCURL_VERSION_NUM >= 0x074200
+		CURLMcode rc = curl_multi_poll (mhandle, NULL, 0, timeout, &numfds);
+#else
+		CURLMcode rc = curl_multi_wait (mhandle, NULL, 0, timeout, &numfds);
+#endif
+		if (rc != CURLM_OK)
+			return SYSERR("curl_multi_poll() error: %s", curl_multi_strerror(rc));
 	}
 
 	/* Do the I/O things now */
-	curl_multi_perform(p->mhandle, &rc);
+	int running = 0;
+	curl_multi_perform(mhandle, &running);
 
-	if (!(count_up = _count_up_dests (p))) {
-		GRID_TRACE("%s uploads finishing", __FUNCTION__);
+	for (struct http_put_s **pp=puts; *pp ;++pp) {
+		struct http_put_s *p = *pp;
+		if (p->state == HTTP_WHOLE_FINISHED)
+			continue;
 		_manage_curl_events(p);
-		p->state = HTTP_WHOLE_FINISHED;
+		_step_finish(p);
 	}
-
 	return NULL;
 }
 
+GError *
+http_put_step (struct http_put_s *p)
+{
+	g_assert (p != NULL);
+	struct http_put_s *puts[2] = {p, NULL};
+	return http_put_step_many (puts);
+}
+
 /* -------------------------------------------------------------------------- */
 
 static int
@@ -28,11 +28,35 @@ extern "C" {
 
 struct http_put_s;
 
+/* How many buffers the fastest destination may be ahead of the slowest */
+#define HTTP_PUT_DEFAULT_MAX_LAG 32
+
+/* How long the late destinations may still run, once the quorum reached */
+#define HTTP_PUT_DEFAULT_STRAGGLER_DELAY (G_TIME_SPAN_SECOND / 2)
+
 /* Create a new http put request. Specifying <content_length> and <soft_length>
  * both equal to -1 means a pure streamed upload. */
 struct http_put_s * http_put_create (gint64 content_length,
 		gint64 soft_length);
 
+/* Same as http_put_create(), but the new upload shares the I/O loop of
+ * <sibling>, so that they may be stepped together with
+ * http_put_step_many(). A NULL <sibling> starts a new loop. */
+struct http_put_s * http_put_create_sibling (struct http_put_s *sibling,
+		gint64 content_length, gint64 soft_length);
+
+/* Let the upload complete as soon as <quorum> destinations succeeded (0
+ * means all of them). The others are still given <delay> microseconds,
+ * then they are aborted and reported as stragglers. While the quorum is
+ * not reached, the destinations too far behind the fastest one are aborted
+ * too, as long as the quorum remains reachable.
+ * To be called before the first step. */
+void http_put_set_quorum (struct http_put_s *p, guint quorum, gint64 delay);
+
+/* Each destination consumes the buffers at its own pace, but it cannot
+ * be more than <max_lag> buffers ahead of the slowest one. */
+void http_put_set_max_lag (struct http_put_s *p, guint max_lag);
+
 /* Add a new destination where to send data.
  * @param p http request handle
  * @param url destination url
@@ -53,13 +77,25 @@ void http_put_feed (struct http_put_s *p, GBytes *b);
 
 GError * http_put_step (struct http_put_s *p);
 
+/* Step at once all the uploads of the NULL-terminated <puts>, that must
+ * share the same I/O loop (cf. http_put_create_sibling()). The finished
+ * ones are skipped. */
+GError * http_put_step_many (struct http_put_s **puts);
+
+/* How many bytes have been fed but not yet taken by every destination */
+gsize http_put_queued_bytes (struct http_put_s *p);
+
 gboolean http_put_done (struct http_put_s *p);
 
 gint64 http_put_expected_bytes (struct http_put_s *p);
 
-/* Get the number of failed requests. */
+/* Get the number of failed requests, stragglers included. */
 guint http_put_get_failure_number(struct http_put_s *p);
 
+/* Get the number of destinations aborted because late. Their HTTP code
+ * is 0, and their replica needs a repair. */
+guint http_put_get_straggler_number(struct http_put_s *p);
+
 /* Compute the md5 of the whole buffer so it must be called after run function.
  * @param p http put handle
  * @param buffer will be filled with the hash
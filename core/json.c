@@ -0,0 +1,770 @@
+/*
+OpenIO SDS core library
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "oiojson.h"
+#include "oiostr.h"
+#include "internals.h"
+
+#define ONES  0x0101010101010101ULL
+#define HIGHS 0x8080808080808080ULL
+
+static const char digit_pairs[] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+static const char hexdigits[] = "0123456789abcdef";
+
+/* Non-zero if any byte of <w> is a control character, a double quote or a
+ * backslash. The bytes above 0x7F (UTF-8 sequences) never match. */
+static inline guint64
+_word_has_special (guint64 w)
+{
+	const guint64 quote = w ^ (ONES * '"');
+	const guint64 bslash = w ^ (ONES * '\\');
+	return ((w - ONES * 0x20) | (quote - ONES) | (bslash - ONES)) & ~w & HIGHS;
+}
+
+static inline gboolean
+_is_special (guint8 c)
+{
+	return c < 0x20 || c == '"' || c == '\\';
+}
+
+static void
+_append_escape (GString *g, guint8 c)
+{
+	switch (c) {
+		case '"':
+			OIO_JSON_LITERAL(g, "\\\"");
+			return;
+		case '\\':
+			OIO_JSON_LITERAL(g, "\\\\");
+			return;
+		case '\b':
+			OIO_JSON_LITERAL(g, "\\b");
+			return;
+		case '\f':
+			OIO_JSON_LITERAL(g, "\\f");
+			return;
+		case '\n':
+			OIO_JSON_LITERAL(g, "\\n");
+			return;
+		case '\r':
+			OIO_JSON_LITERAL(g, "\\r");
+			return;
+		case '\t':
+			OIO_JSON_LITERAL(g, "\\t");
+			return;
+		default: {
+			const gchar u[6] = {
+				'\\', 'u', '0', '0', hexdigits[c >> 4], hexdigits[c & 0x0F]
+			};
+			g_string_append_len (g, u, sizeof(u));
+		}
+	}
+}
+
+/* The runs of bytes that need no escape are skipped a word at a time, then
+ * copied at once. */
+void
+oio_json_append_escaped (GString *g, const char *s, gsize len)
+{
+	const guint8 *p = (const guint8*) s, *run = p, *end = p + len;
+
+	while (p < end) {
+		if (p + sizeof(guint64) <= end) {
+			guint64 w;
+			memcpy (&w, p, sizeof(w));
+			if (!_word_has_special (w)) {
+				p += sizeof(w);
+				continue;
+			}
+		}
+		if (!_is_special (*p)) {
+			++ p;
+			continue;
+		}
+		if (p > run)
+			g_string_append_len (g, (const gchar*) run, p - run);
+		_append_escape (g, *p);
+		run = ++p;
+	}
+	if (p > run)
+		g_string_append_len (g, (const gchar*) run, p - run);
+}
+
+void
+oio_json_append_stringn (GString *g, const char *s, gsize len)
+{
+	if (!s) {
+		OIO_JSON_LITERAL(g, "null");
+		return;
+	}
+	g_string_append_c (g, '"');
+	oio_json_append_escaped (g, s, len);
+	g_string_append_c (g, '"');
+}
+
+void
+oio_json_append_string (GString *g, const char *s)
+{
+	oio_json_append_stringn (g, s, s ? strlen (s) : 0);
+}
+
+/* The digits are produced two by two, from the lowest ones */
+void
+oio_json_append_int (GString *g, gint64 v)
+{
+	gchar buf[24], *p = buf + sizeof(buf);
+	guint64 u = v < 0 ? -(guint64)v : (guint64)v;
+
+	while (u >= 100) {
+		const guint i = (u % 100) * 2;
+		u /= 100;
+		*(--p) = digit_pairs[i + 1];
+		*(--p) = digit_pairs[i];
+	}
+	if (u >= 10) {
+		const guint i = u * 2;
+		*(--p) = digit_pairs[i + 1];
+		*(--p) = digit_pairs[i];
+	} else {
+		*(--p) = '0' + u;
+	}
+	if (v < 0)
+		*(--p) = '-';
+
+	g_string_append_len (g, p, buf + sizeof(buf) - p);
+}
+
+void
+oio_json_append_bool (GString *g, gboolean v)
+{
+	if (v)
+		OIO_JSON_LITERAL(g, "true");
+	else
+		OIO_JSON_LITERAL(g, "false");
+}
+
+void
+oio_json_append_hex (GString *g, const void *bin, gsize len)
+{
+	if (!bin) {
+		OIO_JSON_LITERAL(g, "null");
+		return;
+	}
+	const gsize start = g->len;
+	g_string_set_size (g, start + 2 * len + 2);
+	g->str[start] = '"';
+	oio_str_bin2hex (bin, len, g->str + start + 1, 2 * len + 1);
+	g->str[start + 1 + 2 * len] = '"';
+}
+
+/* Streaming parser --------------------------------------------------------- */
+
+enum json_lex_e
+{
+	LEX_NONE,
+	LEX_STRING,
+	LEX_ESCAPE,
+	LEX_UNICODE,
+	LEX_NUMBER,
+	LEX_LITERAL,
+};
+
+enum json_expect_e
+{
+	EXPECT_VALUE,
+	EXPECT_VALUE_OR_END,  /* just after [ */
+	EXPECT_KEY,
+	EXPECT_KEY_OR_END,    /* just after { */
+	EXPECT_COLON,
+	EXPECT_COMMA_OR_END,
+	EXPECT_NOTHING,       /* after the top-level value */
+};
+
+struct oio_json_parser_s
+{
+	oio_json_hook_f hook;
+	gpointer udata;
+
+	GString *token;
+	gsize offset;
+	GError *error;
+
+	enum json_lex_e lex;
+	enum json_expect_e expect;
+	gboolean in_key;
+
+	/* \uXXXX sequences, and the pending high surrogate of a pair */
+	guint32 ucode;
+	guint ucount;
+	guint32 surrogate;
+
+	const char *literal;
+	enum oio_json_type_e literal_type;
+	guint literal_pos;
+
+	guint depth;
+	guint8 stack[OIO_JSON_MAX_DEPTH];
+};
+
+struct oio_json_parser_s *
+oio_json_parser_create (oio_json_hook_f hook, gpointer udata)
+{
+	g_assert (hook != NULL);
+	struct oio_json_parser_s *p = g_malloc0 (sizeof(*p));
+	p->hook = hook;
+	p->udata = udata;
+	p->token = g_string_sized_new (64);
+	p->lex = LEX_NONE;
+	p->expect = EXPECT_VALUE;
+	return p;
+}
+
+void
+oio_json_parser_destroy (struct oio_json_parser_s *p)
+{
+	if (!p)
+		return;
+	g_string_free (p->token, TRUE);
+	if (p->error)
+		g_clear_error (&p->error);
+	g_free (p);
+}
+
+static GError *
+_syntax (struct oio_json_parser_s *p, const char *what)
+{
+	return BADREQ("JSON: %s at offset %"G_GSIZE_FORMAT, what, p->offset);
+}
+
+static inline gboolean
+_expects_value (struct oio_json_parser_s *p)
+{
+	return p->expect == EXPECT_VALUE || p->expect == EXPECT_VALUE_OR_END;
+}
+
+static inline void
+_after_value (struct oio_json_parser_s *p)
+{
+	p->expect = p->depth ? EXPECT_COMMA_OR_END : EXPECT_NOTHING;
+}
+
+static GError *
+_on_scalar (struct oio_json_parser_s *p, enum oio_json_type_e type,
+		const gchar *text, gsize len)
+{
+	_after_value (p);
+	return p->hook (p->udata, OIO_JSON_EVT_SCALAR, type, text, len);
+}
+
+static GError *
+_on_string (struct oio_json_parser_s *p)
+{
+	if (p->in_key) {
+		p->expect = EXPECT_COLON;
+		return p->hook (p->udata, OIO_JSON_EVT_KEY, OIO_JSON_TYPE_STRING,
+				p->token->str, p->token->len);
+	}
+	return _on_scalar (p, OIO_JSON_TYPE_STRING, p->token->str, p->token->len);
+}
+
+/* -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)? */
+static GError *
+_on_number (struct oio_json_parser_s *p)
+{
+	const gchar *s = p->token->str;
+	gboolean integer = TRUE;
+
+	if (*s == '-')
+		++ s;
+	if (*s == '0')
+		++ s;
+	else if (g_ascii_isdigit (*s)) {
+		while (g_ascii_isdigit (*s))
+			++ s;
+	} else
+		return _syntax (p, "invalid number");
+
+	if (*s == '.') {
+		integer = FALSE;
+		++ s;
+		if (!g_ascii_isdigit (*s))
+			return _syntax (p, "invalid number");
+		while (g_ascii_isdigit (*s))
+			++ s;
+	}
+	if (*s == 'e' || *s == 'E') {
+		integer = FALSE;
+		++ s;
+		if (*s == '+' || *s == '-')
+			++ s;
+		if (!g_ascii_isdigit (*s))
+			return _syntax (p, "invalid number");
+		while (g_ascii_isdigit (*s))
+			++ s;
+	}
+	if (*s)
+		return _syntax (p, "invalid number");
+
+	return _on_scalar (p, integer ? OIO_JSON_TYPE_INT : OIO_JSON_TYPE_DOUBLE,
+			p->token->str, p->token->len);
+}
+
+static GError *
+_on_codepoint (struct oio_json_parser_s *p)
+{
+	guint32 u = p->ucode;
+	if (p->surrogate) {
+		if (u < 0xDC00 || u > 0xDFFF)
+			return _syntax (p, "invalid surrogate pair");
+		u = 0x10000 + ((p->surrogate - 0xD800) << 10) + (u - 0xDC00);
+		p->surrogate = 0;
+	} else if (u >= 0xD800 && u <= 0xDBFF) {
+		p->surrogate = u;
+		return NULL;
+	} else if (u >= 0xDC00 && u <= 0xDFFF) {
+		return _syntax (p, "invalid surrogate pair");
+	}
+	g_string_append_unichar (p->token, u);
+	return NULL;
+}
+
+static GError *
+_on_open (struct oio_json_parser_s *p, guint8 c)
+{
+	if (!_expects_value (p))
+		return _syntax (p, "unexpected character");
+	if (p->depth >= OIO_JSON_MAX_DEPTH)
+		return _syntax (p, "too deep");
+	p->stack[p->depth++] = c;
+	p->expect = (c == '{') ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END;
+	return p->hook (p->udata, OIO_JSON_EVT_START,
+			c == '{' ? OIO_JSON_TYPE_OBJECT : OIO_JSON_TYPE_ARRAY, NULL, 0);
+}
+
+static GError *
+_on_close (struct oio_json_parser_s *p, guint8 c)
+{
+	const guint8 open = (c == '}') ? '{' : '[';
+	if (!p->depth || p->stack[p->depth - 1] != open)
+		return _syntax (p, "unexpected character");
+	if (p->expect != EXPECT_COMMA_OR_END
+			&& p->expect != (c == '}' ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END))
+		return _syntax (p, "unexpected character");
+	-- p->depth;
+	_after_value (p);
+	return p->hook (p->udata, OIO_JSON_EVT_END,
+			c == '}' ? OIO_JSON_TYPE_OBJECT : OIO_JSON_TYPE_ARRAY, NULL, 0);
+}
+
+static GError *
+_feed_byte (struct oio_json_parser_s *p, guint8 c)
+{
+	GError *err = NULL;
+
+	switch (p->lex) {
+		case LEX_STRING:
+			if (p->surrogate && c != '\\')
+				return _syntax (p, "invalid surrogate pair");
+			if (c == '"') {
+				p->lex = LEX_NONE;
+				return _on_string (p);
+			}
+			if (c == '\\') {
+				p->lex = LEX_ESCAPE;
+				return NULL;
+			}
+			if (c < 0x20)
+				return _syntax (p, "control character in string");
+			g_string_append_c (p->token, c);
+			return NULL;
+
+		case LEX_ESCAPE:
+			if (p->surrogate && c != 'u')
+				return _syntax (p, "invalid surrogate pair");
+			p->lex = LEX_STRING;
+			switch (c) {
+				case '"':
+				case '\\':
+				case '/':
+					g_string_append_c (p->token, c);
+					return NULL;
+				case 'b':
+					g_string_append_c (p->token, '\b');
+					return NULL;
+				case 'f':
+					g_string_append_c (p->token, '\f');
+					return NULL;
+				case 'n':
+					g_string_append_c (p->token, '\n');
+					return NULL;
+				case 'r':
+					g_string_append_c (p->token, '\r');
+					return NULL;
+				case 't':
+					g_string_append_c (p->token, '\t');
+					return NULL;
+				case 'u':
+					p->lex = LEX_UNICODE;
+					p->ucode = p->ucount = 0;
+					return NULL;
+			}
+			return _syntax (p, "invalid escape");
+
+		case LEX_UNICODE:
+			if (!g_ascii_isxdigit (c))
+				return _syntax (p, "invalid escape");
+			p->ucode = (p->ucode << 4) | g_ascii_xdigit_value (c);
+			if (++p->ucount < 4)
+				return NULL;
+			p->lex = LEX_STRING;
+			return _on_codepoint (p);
+
+		case LEX_NUMBER:
+			if (g_ascii_isdigit (c) || c == '-' || c == '+' || c == '.'
+					|| c == 'e' || c == 'E') {
+				g_string_append_c (p->token, c);
+				return NULL;
+			}
+			p->lex = LEX_NONE;
+			if (NULL != (err = _on_number (p)))
+				return err;
+			break; /* <c> ends the number and must be managed */
+
+		case LEX_LITERAL:
+			if (c != (guint8) p->literal[p->literal_pos])
+				return _syntax (p, "invalid literal");
+			if (p->literal[++p->literal_pos])
+				return NULL;
+			p->lex = LEX_NONE;
+			return _on_scalar (p, p->literal_type,
+					p->literal, p->literal_pos);
+
+		case LEX_NONE:
+			break;
+	}
+
+	switch (c) {
+		case ' ':
+		case '\t':
+		case '\n':
+		case '\r':
+			return NULL;
+		case '{':
+		case '[':
+			return _on_open (p, c);
+		case '}':
+		case ']':
+			return _on_close (p, c);
+		case ':':
+			if (p->expect != EXPECT_COLON)
+				return _syntax (p, "unexpected colon");
+			p->expect = EXPECT_VALUE;
+			return NULL;
+		case ',':
+			if (p->expect != EXPECT_COMMA_OR_END)
+				return _syntax (p, "unexpected comma");
+			p->expect = (p->stack[p->depth - 1] == '{') ? EXPECT_KEY : EXPECT_VALUE;
+			return NULL;
+		case '"':
+			if (p->expect == EXPECT_KEY || p->expect == EXPECT_KEY_OR_END)
+				p->in_key = TRUE;
+			else if (_expects_value (p))
+				p->in_key = FALSE;
+			else
+				return _syntax (p, "unexpected string");
+			g_string_truncate (p->token, 0);
+			p->surrogate = 0;
+			p->lex = LEX_STRING;
+			return NULL;
+		case 't':
+		case 'f':
+		case 'n':
+			if (!_expects_value (p))
+				return _syntax (p, "unexpected literal");
+			if (c == 't') {
+				p->literal = "true";
+				p->literal_type = OIO_JSON_TYPE_BOOLEAN;
+			} else if (c == 'f') {
+				p->literal = "false";
+				p->literal_type = OIO_JSON_TYPE_BOOLEAN;
+			} else {
+				p->literal = "null";
+				p->literal_type = OIO_JSON_TYPE_NULL;
+			}
+			p->literal_pos = 1;
+			p->lex = LEX_LITERAL;
+			return NULL;
+		default:
+			if (c != '-' && !g_ascii_isdigit (c))
+				return _syntax (p, "unexpected character");
+			if (!_expects_value (p))
+				return _syntax (p, "unexpected number");
+			g_string_truncate (p->token, 0);
+			g_string_append_c (p->token, c);
+			p->lex = LEX_NUMBER;
+			return NULL;
+	}
+}
+
+static GError *
+_fail (struct oio_json_parser_s *p, GError *err)
+{
+	p->error = g_error_copy (err);
+	return err;
+}
+
+GError *
+oio_json_parser_feed (struct oio_json_parser_s *p, const void *data, gsize len)
+{
+	g_assert (p != NULL);
+	if (p->error)
+		return g_error_copy (p->error);
+
+	const guint8 *b = data, *end = b + len;
+	while (b < end) {
+		/* the plain parts of the strings are copied at once */
+		if (p->lex == LEX_STRING && !p->surrogate) {
+			const guint8 *run = b;
+			while (b < end && !_is_special (*b))
+				++ b;
+			if (b > run) {
+				g_string_append_len (p->token, (const gchar*) run, b - run);
+				p->offset += b - run;
+				if (b >= end)
+					break;
+			}
+		}
+		GError *err = _feed_byte (p, *b);
+		if (err)
+			return _fail (p, err);
+		++ b;
+		++ p->offset;
+	}
+	return NULL;
+}
+
+GError *
+oio_json_parser_end (struct oio_json_parser_s *p)
+{
+	g_assert (p != NULL);
+	if (p->error)
+		return g_error_copy (p->error);
+
+	GError *err = NULL;
+	if (p->lex == LEX_NUMBER) {
+		p->lex = LEX_NONE;
+		err = _on_number (p);
+	}
+	if (!err && (p->lex != LEX_NONE || p->expect != EXPECT_NOTHING))
+		err = _syntax (p, "truncated input");
+	return err ? _fail (p, err) : NULL;
+}
+
+/* Arrays of records -------------------------------------------------------- */
+
+struct json_member_s
+{
+	gsize name;
+	gsize value;
+	enum oio_json_type_e type;
+};
+
+struct oio_json_record_s
+{
+	enum oio_json_type_e type;
+	GArray *members;
+	/* the names and the values of the members, NUL-terminated */
+	GString *strings;
+};
+
+struct oio_json_records_s
+{
+	oio_json_record_hook_f hook;
+	gpointer udata;
+	struct oio_json_parser_s *parser;
+	struct oio_json_record_s record;
+	guint depth;
+	gsize key;
+};
+
+enum oio_json_type_e
+oio_json_record_get_type (const struct oio_json_record_s *r)
+{
+	g_assert (r != NULL);
+	return r->type;
+}
+
+GError *
+oio_json_record_extract (const struct oio_json_record_s *r,
+		struct oio_json_record_mapping_s *tab)
+{
+	g_assert (r != NULL);
+	g_assert (tab != NULL);
+	for (struct oio_json_record_mapping_s *p=tab; p->out ;p++)
+		*(p->out) = NULL;
+	if (r->type != OIO_JSON_TYPE_OBJECT)
+		return BADREQ("Not an object");
+	for (struct oio_json_record_mapping_s *p=tab; p->out ;p++) {
+		const struct json_member_s *found = NULL;
+		for (guint i=r->members->len; i>0 && !found ;i--) {
+			const struct json_member_s *m =
+				&g_array_index (r->members, struct json_member_s, i-1);
+			if (!strcmp (r->strings->str + m->name, p->name))
+				found = m;
+		}
+		if (!found || found->type == OIO_JSON_TYPE_NULL) {
+			if (!p->mandatory)
+				continue;
+			return BADREQ("Missing field [%s]", p->name);
+		}
+		if (found->type != p->type)
+			return BADREQ("Invalid type for field [%s]", p->name);
+		*(p->out) = r->strings->str + found->value;
+	}
+	return NULL;
+}
+
+static gsize
+_record_add_string (struct oio_json_record_s *r, const gchar *s, gsize len)
+{
+	const gsize off = r->strings->len;
+	g_string_append_len (r->strings, s, len);
+	g_string_append_c (r->strings, '\0');
+	return off;
+}
+
+static void
+_record_reset (struct oio_json_record_s *r, enum oio_json_type_e type)
+{
+	r->type = type;
+	g_array_set_size (r->members, 0);
+	g_string_truncate (r->strings, 0);
+}
+
+/* depth 0 is outside the array, 1 is in the array, 2 in a record */
+static GError *
+_records_hook (gpointer u, enum oio_json_event_e evt,
+		enum oio_json_type_e type, const gchar *text, gsize len)
+{
+	struct oio_json_records_s *rr = u;
+	struct oio_json_record_s *r = &rr->record;
+
+	if (rr->depth == 0) {
+		if (evt != OIO_JSON_EVT_START || type != OIO_JSON_TYPE_ARRAY)
+			return BADREQ("JSON: Not an array");
+		rr->depth ++;
+		return NULL;
+	}
+
+	if (rr->depth == 1) {
+		switch (evt) {
+			case OIO_JSON_EVT_START:
+				_record_reset (r, type);
+				rr->depth ++;
+				return NULL;
+			case OIO_JSON_EVT_END:
+				rr->depth --;
+				return NULL;
+			default:
+				_record_reset (r, type);
+				return rr->hook (rr->udata, r);
+		}
+	}
+
+	if (rr->depth == 2 && r->type == OIO_JSON_TYPE_OBJECT) {
+		struct json_member_s m = {0};
+		switch (evt) {
+			case OIO_JSON_EVT_KEY:
+				rr->key = _record_add_string (r, text, len);
+				return NULL;
+			case OIO_JSON_EVT_END:
+				rr->depth --;
+				return rr->hook (rr->udata, r);
+			case OIO_JSON_EVT_START:
+				rr->depth ++;
+				text = "";
+				len = 0;
+				/* FALLTHROUGH */
+			case OIO_JSON_EVT_SCALAR:
+				m.name = rr->key;
+				m.type = type;
+				m.value = _record_add_string (r, text, len);
+				g_array_append_vals (r->members, &m, 1);
+				return NULL;
+		}
+	}
+
+	/* skipping a nested value */
+	if (evt == OIO_JSON_EVT_START)
+		rr->depth ++;
+	else if (evt == OIO_JSON_EVT_END) {
+		rr->depth --;
+		if (rr->depth == 1)
+			return rr->hook (rr->udata, r);
+	}
+	return NULL;
+}
+
+struct oio_json_records_s *
+oio_json_records_create (oio_json_record_hook_f hook, gpointer udata)
+{
+	g_assert (hook != NULL);
+	struct oio_json_records_s *rr = g_malloc0 (sizeof(*rr));
+	rr->hook = hook;
+	rr->udata = udata;
+	rr->parser = oio_json_parser_create (_records_hook, rr);
+	rr->record.members = g_array_new (FALSE, FALSE, sizeof(struct json_member_s));
+	rr->record.strings = g_string_sized_new (256);
+	return rr;
+}
+
+void
+oio_json_records_destroy (struct oio_json_records_s *rr)
+{
+	if (!rr)
+		return;
+	oio_json_parser_destroy (rr->parser);
+	g_array_free (rr->record.members, TRUE);
+	g_string_free (rr->record.strings, TRUE);
+	g_free (rr);
+}
+
+GError *
+oio_json_records_feed (struct oio_json_records_s *rr,
+		const void *data, gsize len)
+{
+	g_assert (rr != NULL);
+	return oio_json_parser_feed (rr->parser, data, len);
+}
+
+GError *
+oio_json_records_end (struct oio_json_records_s *rr)
+{
+	g_assert (rr != NULL);
+	return oio_json_parser_end (rr->parser);
+}
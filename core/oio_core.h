@@ -22,6 +22,8 @@ License along with this library.
 
 # include "core/oiocfg.h"
 # include "core/oioext.h"
+# include "core/oiohash.h"
+# include "core/oiojson.h"
 # include "core/oiolog.h"
 # include "core/oiostr.h"
 # include "core/oiourl.h"
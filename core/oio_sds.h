@@ -37,6 +37,24 @@ enum oio_sds_config_e
 
 	/* expects an <int> used for its boolean value */
 	OIOSDS_CFG_FLAG_SYNCATDOWNLOAD,
+
+	/* expects an <int> as the number of replicas of a chunk that must be
+	 * written before the upload goes on. The late ones are aborted and
+	 * left for a later repair. 0 (the default) waits for all of them. */
+	OIOSDS_CFG_PUT_QUORUM,
+
+	/* expects an <int> as the number of metachunks that may be uploaded at
+	 * the same time, when the whole data is available (files and buffers).
+	 * Defaults to 1. */
+	OIOSDS_CFG_UPLOAD_PARALLELISM,
+
+	/* expects an <int> as the number of ranges of a content that may be
+	 * downloaded at the same time, into files and buffers. Defaults to 1. */
+	OIOSDS_CFG_DOWNLOAD_PARALLELISM,
+
+	/* expects an <int> as the number of bytes a reader fetches in the
+	 * background, past each sequential read. 0 (the default) disables it. */
+	OIOSDS_CFG_READAHEAD,
 };
 
 /* API-global --------------------------------------------------------------- */
@@ -168,6 +186,31 @@ struct oio_error_s* oio_sds_download (struct oio_sds_s *sds,
 struct oio_error_s* oio_sds_download_to_file (struct oio_sds_s *sds,
 		struct oio_url_s *u, const char *local);
 
+/* "Pull" download API
+ * The content is located once, at the opening, then the data is read by
+ * pieces straight into the buffers provided by the caller. */
+
+struct oio_sds_reader_s;
+
+struct oio_error_s* oio_sds_reader_open (struct oio_sds_s *sds,
+		struct oio_url_s *url, struct oio_sds_reader_s **out);
+
+/* The size of the whole content */
+size_t oio_sds_reader_get_size (struct oio_sds_reader_s *r);
+
+/* Reads at most <len> bytes at the current position, then moves it past
+ * the data read. <out_len> is set to 0 at the end of the content. */
+struct oio_error_s* oio_sds_reader_read (struct oio_sds_reader_s *r,
+		unsigned char *buf, size_t len, size_t *out_len);
+
+/* Reads at most <len> bytes at <offset> in the content, without moving the
+ * current position. <out_len> is set to 0 past the end of the content.
+ * Several positioned reads may run at once on the same reader. */
+struct oio_error_s* oio_sds_reader_pread (struct oio_sds_reader_s *r,
+		unsigned char *buf, size_t len, size_t offset, size_t *out_len);
+
+void oio_sds_reader_close (struct oio_sds_reader_s *r);
+
 /* --------------------------------------------------------------------------
  * Upload
  * -------------------------------------------------------------------------- */
@@ -205,6 +248,13 @@ struct oio_error_s * oio_sds_upload_step (struct oio_sds_ul_s *ul);
 
 struct oio_error_s * oio_sds_upload_commit (struct oio_sds_ul_s *ul);
 
+/* Commits several uploads into the same container, at once. <uls> is
+ * NULL-terminated, <errors> must have room for one error per upload, and
+ * receives the error of each upload that failed (NULL for the others).
+ * The returned error only tells if the batch itself could be run. */
+struct oio_error_s * oio_sds_upload_commit_many (struct oio_sds_ul_s **uls,
+		struct oio_error_s **errors);
+
 struct oio_error_s * oio_sds_upload_abort (struct oio_sds_ul_s *ul);
 
 /* Tells if the upload is ready to be accept data */
@@ -326,6 +376,12 @@ struct oio_error_s* oio_sds_get_usage (struct oio_sds_s *sds,
 /* works with fully qualified urls (content) */
 struct oio_error_s* oio_sds_delete (struct oio_sds_s *sds, struct oio_url_s *u);
 
+/* Deletes several contents of the same container at once. <urls> is
+ * NULL-terminated, <errors> receives the error of each content, as in
+ * oio_sds_upload_commit_many(). */
+struct oio_error_s* oio_sds_delete_many (struct oio_sds_s *sds,
+		struct oio_url_s **urls, struct oio_error_s **errors);
+
 /* currently works with fully qualified urls (content) */
 struct oio_error_s* oio_sds_has (struct oio_sds_s *sds, struct oio_url_s *url,
 		int *phas);
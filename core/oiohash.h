@@ -0,0 +1,82 @@
+/*
+OpenIO SDS core library
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#ifndef OIO_SDS__core__oiohash_h
+# define OIO_SDS__core__oiohash_h 1
+# include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Name of the parameter of a chunk method that carries the algorithm used
+ * to hash the chunks, e.g. "plain/bytes?hash=xxh64". When absent, the
+ * chunks are hashed with MD5. */
+#define OIO_HASH_CHUNK_METHOD_PARAM "hash"
+
+/* Enough room for the hexadecimal form of any hash, plus the final '\0' */
+#define OIO_HASH_STRLEN 65
+
+enum oio_hash_algo_e
+{
+	OIO_HASH_MD5 = 0,
+	OIO_HASH_SHA256,
+	/* Not a cryptographic hash, but an order of magnitude faster than MD5
+	 * and enough to detect the corruptions of the chunks. */
+	OIO_HASH_XXH64,
+	OIO_HASH_MAX
+};
+
+/* The lowercase name of <algo>, as it appears in the chunk methods */
+const char * oio_hash_algo_name (enum oio_hash_algo_e algo);
+
+/* Returns FALSE if <name> is not the name of a known algorithm */
+gboolean oio_hash_algo_parse (const char *name, enum oio_hash_algo_e *out);
+
+/* Returns the algorithm named in the parameters of <method>, MD5 when
+ * <method> is NULL, has no such parameter or names an unknown algorithm. */
+enum oio_hash_algo_e oio_hash_algo_of_chunk_method (const char *method);
+
+/* Size of the binary digest produced by <algo> */
+gsize oio_hash_algo_length (enum oio_hash_algo_e algo);
+
+struct oio_hash_s;
+
+struct oio_hash_s * oio_hash_new (enum oio_hash_algo_e algo);
+
+/* Copies the current state of <h>, that may be updated further */
+struct oio_hash_s * oio_hash_copy (const struct oio_hash_s *h);
+
+void oio_hash_free (struct oio_hash_s *h);
+
+enum oio_hash_algo_e oio_hash_get_algo (const struct oio_hash_s *h);
+
+void oio_hash_update (struct oio_hash_s *h, const void *data, gsize len);
+
+/* Returns the uppercase hexadecimal form of the digest, owned by <h>.
+ * <h> cannot be updated anymore. */
+const char * oio_hash_get_string (struct oio_hash_s *h);
+
+/* One-shot variant, the result has to be freed with g_free() */
+gchar * oio_hash_compute_for_data (enum oio_hash_algo_e algo,
+		const void *data, gsize len);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*OIO_SDS__core__oiohash_h*/
@@ -0,0 +1,157 @@
+/*
+OpenIO SDS core library
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#ifndef OIO_SDS__core__oiojson_h
+# define OIO_SDS__core__oiojson_h 1
+# include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Writing JSON into a GString, without any format string to parse. The
+ * separators are the caller's business, the names of the members are
+ * constant fragments whose length is known at compile time:
+ *
+ *   g_string_append_c (g, '{');
+ *   OIO_JSON_KEY (g, "name");
+ *   oio_json_append_string (g, name);
+ *   OIO_JSON_NEXT_KEY (g, "size");
+ *   oio_json_append_int (g, size);
+ *   g_string_append_c (g, '}');
+ */
+
+/* Appends a string literal */
+#define OIO_JSON_LITERAL(g,s) g_string_append_len ((g), s, sizeof(s) - 1)
+
+/* Appends "<k>": */
+#define OIO_JSON_KEY(g,k) OIO_JSON_LITERAL(g, "\"" k "\":")
+
+/* Appends ,"<k>": */
+#define OIO_JSON_NEXT_KEY(g,k) OIO_JSON_LITERAL(g, ",\"" k "\":")
+
+/* Appends the <len> bytes of <s> escaped as the content of a JSON string,
+ * without the quotes. Only the double quote, the backslash and the control
+ * characters are escaped, the other bytes are expected to be valid UTF-8. */
+void oio_json_append_escaped (GString *g, const char *s, gsize len);
+
+/* Appends <s> as a quoted JSON string, or null when <s> is NULL */
+void oio_json_append_string (GString *g, const char *s);
+
+void oio_json_append_stringn (GString *g, const char *s, gsize len);
+
+/* Appends <v> in decimal, as printf()'s %"G_GINT64_FORMAT would */
+void oio_json_append_int (GString *g, gint64 v);
+
+void oio_json_append_bool (GString *g, gboolean v);
+
+/* Appends the uppercase hexadecimal form of the <len> bytes of <bin>,
+ * quoted, or null when <bin> is NULL */
+void oio_json_append_hex (GString *g, const void *bin, gsize len);
+
+/* Streaming parser ---------------------------------------------------------
+ * The input is fed by pieces of any size, and the events are notified as
+ * soon as the tokens are complete. The syntax is the strict one of RFC 8259,
+ * the bytes above 0x7F are passed as is. */
+
+enum oio_json_type_e
+{
+	OIO_JSON_TYPE_NULL,
+	OIO_JSON_TYPE_BOOLEAN,
+	OIO_JSON_TYPE_INT,
+	OIO_JSON_TYPE_DOUBLE,
+	OIO_JSON_TYPE_STRING,
+	OIO_JSON_TYPE_OBJECT,
+	OIO_JSON_TYPE_ARRAY,
+};
+
+enum oio_json_event_e
+{
+	OIO_JSON_EVT_START,  /* an object or an array begins */
+	OIO_JSON_EVT_END,    /* an object or an array ends */
+	OIO_JSON_EVT_KEY,    /* the name of a member */
+	OIO_JSON_EVT_SCALAR, /* any other value */
+};
+
+/* <text> is the unescaped content of a string (it may contain NUL bytes),
+ * the literal form of a number, "true", "false" or "null". It is
+ * NUL-terminated, and NULL for the START and END events. A returned error
+ * stops the parsing. */
+typedef GError* (*oio_json_hook_f) (gpointer udata, enum oio_json_event_e evt,
+		enum oio_json_type_e type, const gchar *text, gsize len);
+
+#define OIO_JSON_MAX_DEPTH 64
+
+struct oio_json_parser_s;
+
+struct oio_json_parser_s * oio_json_parser_create (oio_json_hook_f hook,
+		gpointer udata);
+
+void oio_json_parser_destroy (struct oio_json_parser_s *p);
+
+/* Once an error has been returned, the next calls fail too */
+GError * oio_json_parser_feed (struct oio_json_parser_s *p,
+		const void *data, gsize len);
+
+/* Tells the input is over, fails if it did not hold exactly one value */
+GError * oio_json_parser_end (struct oio_json_parser_s *p);
+
+/* Arrays of records --------------------------------------------------------
+ * A common special case: the input is an array of flat objects, each
+ * element is notified as a record once complete, then forgotten. Only the
+ * first level of the members is kept, the nested objects and arrays are
+ * skipped. */
+
+struct oio_json_record_s;
+
+typedef GError* (*oio_json_record_hook_f) (gpointer udata,
+		const struct oio_json_record_s *r);
+
+struct oio_json_record_mapping_s
+{
+	const char *name;
+	const gchar **out;
+	enum oio_json_type_e type;
+	gboolean mandatory;
+};
+
+/* The type of the element of the array */
+enum oio_json_type_e oio_json_record_get_type (const struct oio_json_record_s *r);
+
+/* Works like oio_ext_extract_json(): the null members are missing, the
+ * last of duplicated members wins. The text of the scalars is returned,
+ * an empty string for the nested objects and arrays. */
+GError * oio_json_record_extract (const struct oio_json_record_s *r,
+		struct oio_json_record_mapping_s *tab);
+
+struct oio_json_records_s;
+
+struct oio_json_records_s * oio_json_records_create (
+		oio_json_record_hook_f hook, gpointer udata);
+
+void oio_json_records_destroy (struct oio_json_records_s *r);
+
+GError * oio_json_records_feed (struct oio_json_records_s *r,
+		const void *data, gsize len);
+
+GError * oio_json_records_end (struct oio_json_records_s *r);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*OIO_SDS__core__oiojson_h*/
@@ -96,7 +96,8 @@ void oio_str_upper(register gchar *s);
 void oio_str_lower(register gchar *s);
 
 /* appends to 'base' the JSON acceptable version of 's', i.e. 's' with its
- * double quotes escaped and other characters are valid UTF-8 */
+ * double quotes, backslashes and control characters escaped, the other
+ * characters are expected to be valid UTF-8 (cf. oio_json_append_escaped) */
 void oio_str_gstring_append_json_string (GString *base, const char *s);
 
 /* appends "<k>":"<v>" where k and v are added with
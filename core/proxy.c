@@ -134,8 +134,9 @@ _curl_container_url (struct oio_url_s *u, const char *action)
 	return hu;
 }
 
+/* For the actions on several contents of the same container */
 static GString *
-_curl_content_url (struct oio_url_s *u, const char *action)
+_curl_contents_url (struct oio_url_s *u, const char *action)
 {
 	GString *hu = _curl_url_prefix_containers (u);
 	g_string_append_printf (hu, "/%s/%s/content/%s", PROXYD_PREFIX,
@@ -143,6 +144,13 @@ _curl_content_url (struct oio_url_s *u, const char *action)
 	_append (hu, '?', "acct", oio_url_get (u, OIOURL_ACCOUNT));
 	_append (hu, '&', "ref",  oio_url_get (u, OIOURL_USER));
 	_append_type (u, hu);
+	return hu;
+}
+
+static GString *
+_curl_content_url (struct oio_url_s *u, const char *action)
+{
+	GString *hu = _curl_contents_url (u, action);
 	_append (hu, '&', "path", oio_url_get (u, OIOURL_PATH));
 	return hu;
 }
@@ -397,12 +405,24 @@ oio_proxy_call_container_get_properties (CURL *h, struct oio_url_s *u,
 }
 
 GError *
-oio_proxy_call_content_show (CURL *h, struct oio_url_s *u, GString *out)
+oio_proxy_call_content_show (CURL *h, struct oio_url_s *u, GString *out,
+		gchar **out_chunk_method)
 {
 	GString *http_url = _curl_content_url (u, "show");
-	struct http_ctx_s o = { .headers = NULL, .body = out };
+	struct http_ctx_s o = {
+		.headers = out_chunk_method ? g_malloc0(sizeof(void*)) : NULL,
+		.body = out
+	};
 	GError *err = _proxy_call (h, "GET", http_url->str, NULL, &o);
+	if (!err && out_chunk_method && o.headers) {
+		for (gchar **p=o.headers; *p && *(p+1) ;p+=2) {
+			if (!g_ascii_strcasecmp(*p, "content-meta-chunk-method"))
+				oio_str_replace (out_chunk_method, *(p+1));
+		}
+	}
 	g_string_free (http_url, TRUE);
+	if (o.headers)
+		g_strfreev (o.headers);
 	return err;
 }
 
@@ -499,6 +519,32 @@ oio_proxy_call_content_create (CURL *h, struct oio_url_s *u,
 	return err;
 }
 
+static GError *
+_proxy_call_contents (CURL *h, struct oio_url_s *u, const char *action,
+		GString *in, GString *out)
+{
+	struct http_ctx_s i = { .headers = NULL, .body = in };
+	struct http_ctx_s o = { .headers = NULL, .body = out };
+	GString *http_url = _curl_contents_url (u, action);
+	GError *err = _proxy_call (h, "POST", http_url->str, &i, &o);
+	g_string_free (http_url, TRUE);
+	return err;
+}
+
+GError *
+oio_proxy_call_content_create_many (CURL *h, struct oio_url_s *u,
+		GString *in, GString *out)
+{
+	return _proxy_call_contents (h, u, "create_many", in, out);
+}
+
+GError *
+oio_proxy_call_content_delete_many (CURL *h, struct oio_url_s *u,
+		GString *in, GString *out)
+{
+	return _proxy_call_contents (h, u, "delete_many", in, out);
+}
+
 GError *
 oio_proxy_call_content_list (CURL *h, struct oio_url_s *u, GString *out,
 		const char *prefix, const char *marker, const char *end,
@@ -37,6 +37,10 @@ License along with this library.
 
 #include <metautils/lib/metautils.h>
 
+#ifdef HAVE_LIBRAIN
+# include <librain.h>
+#endif
+
 struct oio_sds_s
 {
 	gchar *session_id;
@@ -48,6 +52,10 @@ struct oio_sds_s
 		int rawx;
 	} timeout;
 	gboolean sync_after_download;
+	guint put_quorum;
+	guint upload_parallelism;
+	guint download_parallelism;
+	gsize readahead;
 	CURL *h;
 };
 
@@ -81,11 +89,20 @@ struct chunk_s
 		gboolean ec : 8; /* composite position ? */
 		gboolean parity : 8;
 	} position;
-	gchar hexhash[STRLEN_CHUNKHASH];
+	gchar hexhash[OIO_HASH_STRLEN];
 	guint32 score;
 	gchar url[1];
 };
 
+/* The erasure coding of a content, as told by its chunk method, e.g.
+ * "plain/rain?algo=liber8tion&k=6&m=2". k==0 when unknown. */
+struct ec_params_s
+{
+	guint k;
+	guint m;
+	gchar algo[32];
+};
+
 struct metachunk_s
 {
 	guint meta;
@@ -95,6 +112,7 @@ struct metachunk_s
 	gsize offset;
 	/* TRUE==rain, FALSE==replication */
 	gboolean ec;
+	struct ec_params_s ec_params;
 	GSList *chunks;
 };
 
@@ -154,6 +172,17 @@ _load_one_chunk (struct json_object *jurl, struct json_object *jsize,
 	return result;
 }
 
+/* The chunks are hashed with any of the known algorithms */
+static gboolean
+_is_chunk_hash (const char *h)
+{
+	for (enum oio_hash_algo_e algo = 0; algo < OIO_HASH_MAX ;++algo) {
+		if (oio_str_ishexa (h, 2 * oio_hash_algo_length (algo)))
+			return TRUE;
+	}
+	return FALSE;
+}
+
 static const char *
 _chunk_pack_position (struct chunk_s *c, gchar *buf, gsize len)
 {
@@ -209,9 +238,8 @@ _chunks_load (GSList **out, struct json_object *jtab)
 		if (err) continue;
 
 		const char *h = json_object_get_string(jhash);
-		if (!oio_str_ishexa(h, 2*sizeof(chunk_hash_t)))
-			err = NEWERROR(0, "JSON: invalid chunk hash: not hexa of %"G_GSIZE_FORMAT,
-					2*sizeof(chunk_hash_t));
+		if (!_is_chunk_hash(h))
+			err = NEWERROR(0, "JSON: invalid chunk hash [%s]", h);
 		else {
 			struct chunk_s *c = _load_one_chunk(jurl, jsize, jpos, jscore);
 			g_strlcpy (c->hexhash, h, sizeof(c->hexhash));
@@ -315,6 +343,41 @@ _organize_chunks (GSList *lchunks, struct metachunk_s ***result)
 	return NULL;
 }
 
+/* Same constraints as the rainx: k>=m>=1 */
+static GError *
+_ec_params_load (const char *method, struct ec_params_s *out)
+{
+	memset (out, 0, sizeof(*out));
+	const char *params = method ? strchr (method, '?') : NULL;
+	if (!params)
+		return BADREQ("No erasure coding parameter in [%s]", method);
+
+	gint64 k = 0, m = 0;
+	gchar **tokens = g_strsplit (params + 1, "&", -1);
+	for (gchar **t = tokens; *t ;++t) {
+		gchar *eq = strchr (*t, '=');
+		if (!eq)
+			continue;
+		*eq = '\0';
+		if (!strcmp (*t, "k"))
+			k = g_ascii_strtoll (eq + 1, NULL, 10);
+		else if (!strcmp (*t, "m"))
+			m = g_ascii_strtoll (eq + 1, NULL, 10);
+		else if (!strcmp (*t, "algo"))
+			g_strlcpy (out->algo, eq + 1, sizeof(out->algo));
+	}
+	g_strfreev (tokens);
+
+	if (k < 1 || m < 1 || k < m || k > 255 || !out->algo[0]) {
+		out->algo[0] = '\0';
+		return BADREQ("Invalid erasure coding k=%"G_GINT64_FORMAT
+				" m=%"G_GINT64_FORMAT" in [%s]", k, m, method);
+	}
+	out->k = k;
+	out->m = m;
+	return NULL;
+}
+
 /* Logging helpers ---------------------------------------------------------- */
 
 void
@@ -392,6 +455,8 @@ oio_sds_init (struct oio_sds_s **out, const char *ns)
 	(*out)->proxy_local = oio_cfg_get_proxylocal (ns);
 	(*out)->proxy = oio_cfg_get_proxy_containers (ns);
 	(*out)->sync_after_download = TRUE;
+	(*out)->upload_parallelism = 1;
+	(*out)->download_parallelism = 1;
 	(*out)->h = _curl_get_handle_proxy (*out);
 	return NULL;
 }
@@ -439,6 +504,34 @@ oio_sds_configure (struct oio_sds_s *sds, enum oio_sds_config_e what,
 				return EINVAL;
 			sds->sync_after_download = BOOL(*(int*)pv);
 			return 0;
+		case OIOSDS_CFG_PUT_QUORUM:
+			if (vlen != sizeof(int))
+				return EINVAL;
+			if (*(int*)pv < 0)
+				return ERANGE;
+			sds->put_quorum = *(int*)pv;
+			return 0;
+		case OIOSDS_CFG_UPLOAD_PARALLELISM:
+			if (vlen != sizeof(int))
+				return EINVAL;
+			if (*(int*)pv <= 0)
+				return ERANGE;
+			sds->upload_parallelism = *(int*)pv;
+			return 0;
+		case OIOSDS_CFG_DOWNLOAD_PARALLELISM:
+			if (vlen != sizeof(int))
+				return EINVAL;
+			if (*(int*)pv <= 0)
+				return ERANGE;
+			sds->download_parallelism = *(int*)pv;
+			return 0;
+		case OIOSDS_CFG_READAHEAD:
+			if (vlen != sizeof(int))
+				return EINVAL;
+			if (*(int*)pv < 0)
+				return ERANGE;
+			sds->readahead = *(int*)pv;
+			return 0;
 		default:
 			return EBADSLT;
 	}
@@ -590,20 +683,240 @@ _download_range_from_metachunk_replicated (struct _download_ctx_s *dl,
 	return NULL;
 }
 
+/* Where the data of a range goes: pwrite() into <fd> when it is valid,
+ * memcpy() into <base> otherwise. <offset> is in the destination, and no
+ * byte may be written past <end>. */
+struct _dl_cursor_s
+{
+	int fd;
+	guint8 *base;
+	gsize offset;
+	gsize end;
+};
+
+static int
+_write_cursor (gpointer ctx, const guint8 *buf, gsize len)
+{
+	struct _dl_cursor_s *cur = ctx;
+	if (cur->offset + len > cur->end) {
+		GRID_WARN("Too many bytes received");
+		return -1;
+	}
+	if (cur->fd < 0) {
+		memcpy (cur->base + cur->offset, buf, len);
+	} else {
+		for (gsize total = 0; total < len ;) {
+			ssize_t w = pwrite (cur->fd, buf + total, len - total,
+					cur->offset + total);
+			if (w < 0) {
+				if (errno == EINTR)
+					continue;
+				GRID_WARN("pwrite() error: (%d) %s", errno, strerror(errno));
+				return -1;
+			}
+			total += w;
+		}
+	}
+	cur->offset += len;
+	return 0;
+}
+
+#ifdef HAVE_LIBRAIN
+static void * _rain_malloc (size_t size) { return g_malloc (size); }
+static void * _rain_calloc (size_t n, size_t size) { return g_malloc0_n (n, size); }
+static void _rain_free (void *p) { g_free (p); }
+
+static struct rain_env_s rain_env = { _rain_malloc, _rain_calloc, _rain_free };
+
+static GError *
+_ec_encoding_init (struct rain_encoding_s *enc, gsize size,
+		const struct ec_params_s *params)
+{
+	if (!params->k)
+		return NEWERROR(CODE_INTERNAL_ERROR, "Unknown erasure coding");
+	memset (enc, 0, sizeof(*enc));
+	if (!rain_get_encoding (enc, size, params->k, params->m, params->algo))
+		return NEWERROR(CODE_INTERNAL_ERROR, "Invalid erasure coding"
+				" k=%u m=%u algo=%s", params->k, params->m, params->algo);
+	return NULL;
+}
+
+/* How many bytes of the stripe the fragment of <c> holds. The data
+ * fragments are not padded, so the last ones may be short or even empty. */
+static gsize
+_ec_fragment_size (const struct rain_encoding_s *enc, gsize size,
+		const struct chunk_s *c)
+{
+	if (c->position.parity)
+		return enc->block_size;
+	const gsize start = (gsize)c->position.intra * enc->block_size;
+	if (start >= size)
+		return 0;
+	return MIN((gsize)enc->block_size, size - start);
+}
+
+/* One fragment of a stripe being rebuilt, fetched as a whole into a buffer
+ * of the size of a block, padding included. */
+struct _ec_fetch_s
+{
+	struct oio_sds_s *sds;
+	struct chunk_s *chunk;
+	guint8 *block;
+	gsize size;
+	GError *err;
+};
+
+static void
+_ec_fetch (struct _ec_fetch_s *f)
+{
+	struct _dl_cursor_s cur = {
+		.fd = -1, .base = f->block, .offset = 0, .end = f->size
+	};
+	struct oio_sds_dl_dst_s dst = {
+		.out_size = 0,
+		.type = OIO_DL_DST_HOOK_SEQUENTIAL,
+		.data = { .hook = {
+			.cb = _write_cursor, .ctx = &cur, .length = f->size,
+		} }
+	};
+	struct _download_ctx_s dl = {
+		.sds = f->sds, .dst = &dst, .src = NULL, .chunks = NULL,
+		.metachunks = NULL
+	};
+	struct oio_sds_dl_range_s range = {.offset = 0, .size = f->size};
+	size_t nbread = 0;
+	f->err = _download_range_from_chunk (&dl, &range, f->chunk, &nbread);
+	if (!f->err && cur.offset != f->size)
+		f->err = NEWERROR(CODE_PLATFORM_ERROR, "Short read: %"G_GSIZE_FORMAT
+				"/%"G_GSIZE_FORMAT, cur.offset, f->size);
+}
+
+struct _ec_fetches_s
+{
+	GPtrArray *todo;
+	gint next; /* the next fetch to be run */
+};
+
+static gpointer
+_ec_fetches_worker (struct _ec_fetches_s *ctx)
+{
+	for (;;) {
+		guint i = g_atomic_int_add (&ctx->next, 1);
+		if (i >= ctx->todo->len)
+			break;
+		_ec_fetch (ctx->todo->pdata[i]);
+	}
+	return ctx;
+}
+
+/* A data fragment is missing: every fragment still available is fetched,
+ * by as many threads as the download parallelism allows (the caller's one
+ * included), then the lost ones are computed from any k of them. The range
+ * is relative to the metachunk. */
+static GError *
+_download_range_from_metachunk_rebuilt (struct _download_ctx_s *dl,
+		const struct oio_sds_dl_range_s *range, struct metachunk_s *meta)
+{
+	const struct ec_params_s *params = &meta->ec_params;
+	struct rain_encoding_s enc;
+	GError *err = _ec_encoding_init (&enc, meta->size, params);
+	if (err)
+		return err;
+
+	const guint total = params->k + params->m;
+	struct _ec_fetch_s *fetches = g_malloc0 (total * sizeof(*fetches));
+	struct _ec_fetches_s ctx = {.todo = g_ptr_array_new (), .next = 0};
+
+	for (GSList *l=meta->chunks; l ;l=l->next) {
+		struct chunk_s *c = l->data;
+		const guint max = c->position.parity ? params->m : params->k;
+		if (c->position.intra >= max) {
+			GRID_WARN("Fragment out of the stripe: %s", c->url);
+			continue;
+		}
+		struct _ec_fetch_s *f = fetches + c->position.intra
+			+ (c->position.parity ? params->k : 0);
+		if (f->chunk)
+			continue;
+		f->sds = dl->sds;
+		f->chunk = c;
+		f->size = _ec_fragment_size (&enc, meta->size, c);
+		f->block = g_malloc0 (enc.block_size);
+		if (f->size > 0)
+			g_ptr_array_add (ctx.todo, f);
+	}
+
+	const guint nb = MIN(dl->sds->download_parallelism, ctx.todo->len);
+	GPtrArray *threads = g_ptr_array_new ();
+	for (guint i=1; i<nb ;++i)
+		g_ptr_array_add (threads, g_thread_new ("ec-fetch",
+					(GThreadFunc)_ec_fetches_worker, &ctx));
+	_ec_fetches_worker (&ctx);
+	for (guint i=0; i<threads->len ;++i)
+		g_thread_join (threads->pdata[i]);
+	g_ptr_array_free (threads, TRUE);
+	g_ptr_array_free (ctx.todo, TRUE);
+
+	/* Only the padding of the stripe needs no fetch */
+	guint8 **blocks = g_malloc0 (total * sizeof(guint8*));
+	guint lost = 0;
+	for (guint i=0; i<total ;++i) {
+		struct _ec_fetch_s *f = fetches + i;
+		if (!f->chunk && i < params->k
+				&& (gsize)i * enc.block_size >= meta->size) {
+			blocks[i] = g_malloc0 (enc.block_size);
+		} else if (!f->chunk || f->err) {
+			if (f->err)
+				GRID_WARN("Fragment lost [%s]: (%d) %s", f->chunk->url,
+						f->err->code, f->err->message);
+			g_clear_error (&f->err);
+			g_free (f->block);
+			++ lost;
+		} else {
+			blocks[i] = f->block;
+		}
+	}
+	g_free (fetches);
+
+	if (lost > params->m)
+		err = NEWERROR(CODE_PLATFORM_ERROR, "Too many fragments lost (%u/%u)",
+				lost, total);
+	else if (lost > 0 && !rain_rehydrate (blocks, blocks + params->k,
+				&enc, &rain_env))
+		err = NEWERROR(CODE_PLATFORM_ERROR, "Failed to rebuild the stripe");
+
+	/* The data of the stripe is the concatenation of the data blocks */
+	for (gsize off = range->offset, end = range->offset + range->size;
+			!err && off < end ;) {
+		const gsize i = off / enc.block_size, o = off % enc.block_size;
+		const gsize len = MIN(end - off, enc.block_size - o);
+		if (0 != dl->dst->data.hook.cb (dl->dst->data.hook.ctx,
+					blocks[i] + o, len))
+			err = NEWERROR(CODE_INTERNAL_ERROR, "user callback failed");
+		off += len;
+	}
+
+	for (guint i=0; i<total ;++i)
+		g_free (blocks[i]);
+	g_free (blocks);
+	return err;
+}
+#endif
+
+/* The data fragments cover the metachunk in the order of their position,
+ * a range is then read straight from them and the parity fragments are
+ * only necessary when a data fragment is lost. */
 static GError *
 _download_range_from_metachunk_rained (struct _download_ctx_s *dl,
 		struct oio_sds_dl_range_s *range, struct metachunk_s *meta)
 {
 	GRID_TRACE("%s", __FUNCTION__);
 	struct oio_sds_dl_range_s r0 = *range;
-	GSList *tail_chunks = meta->chunks;
-
-	while (r0.size > 0) {
+	gsize pos = 0; /* where the current fragment starts in the metachunk */
+	GError *err = NULL;
 
-		if (!tail_chunks)
-			return NEWERROR (CODE_PLATFORM_ERROR, "Range not satisfiable");
-		struct chunk_s *chunk = tail_chunks->data;
-		tail_chunks = tail_chunks->next;
+	for (GSList *l=meta->chunks; !err && l && r0.size > 0 ;l=l->next) {
+		struct chunk_s *chunk = l->data;
 
 #ifdef HAVE_EXTRA_DEBUG
 		gchar strpos[32];
@@ -619,25 +932,40 @@ _download_range_from_metachunk_rained (struct _download_ctx_s *dl,
 			continue;
 		}
 
-		if (r0.offset >= chunk->size) {
+		if (r0.offset >= pos + chunk->size) {
 			GRID_TRACE2("Skipped: out of range");
-			r0.offset -= chunk->size;
+			pos += chunk->size;
 			continue;
 		}
 
 		/* adjust the range to the chunk's boundaries */
-		struct oio_sds_dl_range_s r1 = r0;
-		r1.size = MIN(r1.size, chunk->size);
+		struct oio_sds_dl_range_s r1;
+		r1.offset = r0.offset - pos;
+		r1.size = MIN(r0.size, chunk->size - r1.offset);
 
 		size_t nbread = 0;
-		GError *err = _download_range_from_chunk (dl, &r1, chunk, &nbread);
-		g_assert (nbread <= r0.size);
-		if (err)
-			return err;
+		err = _download_range_from_chunk (dl, &r1, chunk, &nbread);
+		g_assert (nbread <= r1.size);
+		if (!err && nbread < r1.size)
+			err = NEWERROR (CODE_PLATFORM_ERROR, "Short read: %"G_GSIZE_FORMAT
+					"/%"G_GSIZE_FORMAT, nbread, r1.size);
+		r0.offset += nbread;
 		r0.size -= nbread;
+		pos += chunk->size;
 	}
 
-	return NULL;
+	if (!err && r0.size > 0)
+		err = NEWERROR (CODE_PLATFORM_ERROR, "Range not satisfiable");
+
+#ifdef HAVE_LIBRAIN
+	if (err) {
+		GRID_WARN("EC read failed at %"G_GSIZE_FORMAT", rebuilding: (%d) %s",
+				r0.offset, err->code, err->message);
+		g_clear_error (&err);
+		err = _download_range_from_metachunk_rebuilt (dl, &r0, meta);
+	}
+#endif
+	return err;
 }
 
 /* The range is relative to the metachunk, not the whole content */
@@ -690,6 +1018,30 @@ _download_range (struct _download_ctx_s *dl, struct oio_sds_dl_range_s *range)
 	return NULL;
 }
 
+static gsize
+_metachunks_total_size (struct metachunk_s **metachunks)
+{
+	gsize total = 0;
+	for (struct metachunk_s **p=metachunks; *p ;++p)
+		total += (*p)->size;
+	return total;
+}
+
+/* validate the ranges do not point out of the content */
+static GError *
+_check_ranges (struct oio_sds_dl_range_s **ranges, gsize total)
+{
+	for (struct oio_sds_dl_range_s **p=ranges; *p ;++p) {
+		if ((*p)->offset >= total)
+			return NEWERROR (CODE_BAD_REQUEST, "Range not satisfiable");
+		if ((*p)->size > total)
+			return NEWERROR (CODE_BAD_REQUEST, "Range not satisfiable");
+		if ((*p)->offset + (*p)->size > total)
+			return NEWERROR (CODE_BAD_REQUEST, "Range not satisfiable");
+	}
+	return NULL;
+}
+
 static GError *
 _download (struct _download_ctx_s *dl)
 {
@@ -700,22 +1052,15 @@ _download (struct _download_ctx_s *dl)
 
 	/* Compute the total number of bytes in the content. We will need it for
 	 * subsequent checks. */
-	size_t total = 0;
-	for (struct metachunk_s **p=dl->metachunks; *p ;++p)
-		total += (*p)->size;
+	size_t total = _metachunks_total_size (dl->metachunks);
 	GRID_TRACE2("computed size = %"G_GSIZE_FORMAT, total);
 
 	/* validate the ranges do not point out of the content, or ensure at least
 	 * a range is none is set. */
 	if (dl->src->ranges && dl->src->ranges[0]) {
-		for (struct oio_sds_dl_range_s **p=dl->src->ranges; *p ;++p) {
-			if ((*p)->offset >= total)
-				return NEWERROR (CODE_BAD_REQUEST, "Range not satisfiable");
-			if ((*p)->size > total)
-				return NEWERROR (CODE_BAD_REQUEST, "Range not satisfiable");
-			if ((*p)->offset + (*p)->size > total)
-				return NEWERROR (CODE_BAD_REQUEST, "Range not satisfiable");
-		}
+		GError *err = _check_ranges (dl->src->ranges, total);
+		if (err)
+			return err;
 	} else {
 		if (dl->dst->data.hook.length == (size_t)-1) {
 			range_auto.size = total;
@@ -737,38 +1082,18 @@ _download (struct _download_ctx_s *dl)
 	return err;
 }
 
-static int
-_write_FILE (gpointer ctx, const guint8 *buf, gsize len)
-{
-	FILE *out = ctx;
-	gsize total = 0;
-	while (total < len) {
-		if (ferror(out))
-			return -1;
-		size_t w = fwrite (buf, 1, len-total, out);
-		total += w;
-	}
-	return 0;
-}
-
-static struct oio_error_s*
-_download_to_hook (struct oio_sds_s *sds, struct oio_sds_dl_src_s *src,
-		struct oio_sds_dl_dst_s *dst)
+/* Locate the content, then organize its chunks in metachunks */
+static GError *
+_download_load (struct oio_sds_s *sds, struct oio_url_s *url,
+		GSList **out_chunks, struct metachunk_s ***out_metachunks)
 {
-	g_assert (dst->type == OIO_DL_DST_HOOK_SEQUENTIAL);
-	dst->out_size = 0;
-	if (!dst->data.hook.cb)
-		return (struct oio_error_s*) NEWERROR (CODE_BAD_REQUEST, "Missing callback");
-	_dl_debug (__FUNCTION__, src, dst);
-
-	GError *err = NULL;
-
 	GSList *chunks = NULL;
 	GString *reply_body = g_string_new("");
 
 	/* Get the beans */
-	if (!err)
-		err = oio_proxy_call_content_show (sds->h, src->url, reply_body);
+	gchar *chunk_method = NULL;
+	GError *err = oio_proxy_call_content_show (sds->h, url, reply_body,
+			&chunk_method);
 
 	/* Parse the beans */
 	if (!err) {
@@ -789,71 +1114,251 @@ _download_to_hook (struct oio_sds_s *sds, struct oio_sds_dl_src_s *src,
 		json_object_put (jbody);
 	}
 
+	if (!err) {
+		if (!(err = _organize_chunks (chunks, out_metachunks)))
+			g_assert (*out_metachunks != NULL);
+	}
+
+	/* Without them, the EC metachunks can still be read, but not rebuilt */
+	if (!err) {
+		struct ec_params_s params;
+		GError *e = _ec_params_load (chunk_method, &params);
+		for (struct metachunk_s **p=*out_metachunks; !e && *p ;++p) {
+			if ((*p)->ec)
+				(*p)->ec_params = params;
+		}
+		g_clear_error (&e);
+	}
+
+	oio_str_clean (&chunk_method);
+	g_string_free (reply_body, TRUE);
+	if (err)
+		g_slist_free_full (chunks, g_free);
+	else
+		*out_chunks = chunks;
+	return err;
+}
+
+static struct oio_error_s*
+_download_to_hook (struct oio_sds_s *sds, struct oio_sds_dl_src_s *src,
+		struct oio_sds_dl_dst_s *dst)
+{
+	g_assert (dst->type == OIO_DL_DST_HOOK_SEQUENTIAL);
+	dst->out_size = 0;
+	if (!dst->data.hook.cb)
+		return (struct oio_error_s*) NEWERROR (CODE_BAD_REQUEST, "Missing callback");
+	_dl_debug (__FUNCTION__, src, dst);
+
+	GSList *chunks = NULL;
+	struct metachunk_s **metachunks = NULL;
+	GError *err = _download_load (sds, src->url, &chunks, &metachunks);
 	if (!err) {
 		struct _download_ctx_s dl = {
 			.sds = sds, .dst = dst, .src = src, .chunks = chunks,
-			.metachunks = NULL
+			.metachunks = metachunks
+		};
+		err = _download (&dl);
+		_metachunk_cleanv (metachunks);
+		g_slist_free_full (chunks, g_free);
+	}
+	return (struct oio_error_s*) err;
+}
+
+/* The data of the <range> of the content is written straight from the
+ * buffers of CURL to its destination, that must then be exactly filled. */
+static GError *
+_download_range_to_cursor (struct oio_sds_s *sds,
+		struct metachunk_s **metachunks, struct oio_sds_dl_range_s *range,
+		struct _dl_cursor_s *cur)
+{
+	struct oio_sds_dl_dst_s dst = {
+		.out_size = 0,
+		.type = OIO_DL_DST_HOOK_SEQUENTIAL,
+		.data = { .hook = {
+			.cb = _write_cursor,
+			.ctx = cur,
+			.length = range->size,
+		} }
+	};
+	struct _download_ctx_s dl = {
+		.sds = sds, .dst = &dst, .src = NULL, .chunks = NULL,
+		.metachunks = metachunks
+	};
+	const gsize start = cur->offset;
+	GError *err = _download_range (&dl, range);
+	if (!err && cur->offset - start != range->size)
+		err = NEWERROR(CODE_PLATFORM_ERROR, "Short read: %"G_GSIZE_FORMAT
+				"/%"G_GSIZE_FORMAT, cur->offset - start, range->size);
+	return err;
+}
+
+/* A piece of a range, within one metachunk, and the position of its data
+ * in the destination */
+struct _dl_job_s
+{
+	struct oio_sds_dl_range_s range;
+	gsize out_offset;
+};
+
+struct _dl_jobs_s
+{
+	struct oio_sds_s *sds;
+	struct metachunk_s **metachunks;
+	GArray *jobs;
+	int fd;
+	guint8 *base;
+
+	gint next; /* the next job to be run */
+	GMutex lock;
+	GError *err; /* the first failure */
+};
+
+/* Cut the ranges at the boundaries of the metachunks. In the destination,
+ * the data of each range follows the data of the previous one. */
+static GArray *
+_build_jobs (struct metachunk_s **metachunks, struct oio_sds_dl_range_s **ranges)
+{
+	GArray *jobs = g_array_new (FALSE, FALSE, sizeof(struct _dl_job_s));
+	gsize out = 0;
+	for (struct oio_sds_dl_range_s **pr=ranges; *pr ;++pr) {
+		const gsize r_end = (*pr)->offset + (*pr)->size;
+		for (struct metachunk_s **p=metachunks; *p ;++p) {
+			const gsize start = MAX((*pr)->offset, (*p)->offset);
+			const gsize end = MIN(r_end, (*p)->offset + (*p)->size);
+			if (start >= end)
+				continue;
+			struct _dl_job_s job = {
+				.range = {.offset = start, .size = end - start},
+				.out_offset = out,
+			};
+			g_array_append_val (jobs, job);
+			out += end - start;
+		}
+	}
+	return jobs;
+}
+
+static gpointer
+_jobs_worker (struct _dl_jobs_s *ctx)
+{
+	for (;;) {
+		guint i = g_atomic_int_add (&ctx->next, 1);
+		if (i >= ctx->jobs->len)
+			break;
+
+		g_mutex_lock (&ctx->lock);
+		gboolean failed = (ctx->err != NULL);
+		g_mutex_unlock (&ctx->lock);
+		if (failed)
+			break;
+
+		struct _dl_job_s *job = &g_array_index (ctx->jobs, struct _dl_job_s, i);
+		struct _dl_cursor_s cur = {
+			.fd = ctx->fd,
+			.base = ctx->base,
+			.offset = job->out_offset,
+			.end = job->out_offset + job->range.size,
 		};
-		if (!(err = _organize_chunks(chunks, &dl.metachunks))) {
-			g_assert (dl.metachunks != NULL);
-			err = _download (&dl);
-			_metachunk_cleanv (dl.metachunks);
+		GError *err = _download_range_to_cursor (ctx->sds, ctx->metachunks,
+				&job->range, &cur);
+		if (err) {
+			g_mutex_lock (&ctx->lock);
+			if (!ctx->err)
+				ctx->err = err;
+			else
+				g_clear_error (&err);
+			g_mutex_unlock (&ctx->lock);
 		}
 	}
+	return ctx;
+}
 
-	/* cleanup and exit */
-	g_string_free (reply_body, TRUE);
+/* The caller's thread runs the jobs too, along with the extra threads
+ * allowed by the download parallelism. */
+static GError *
+_run_jobs (struct _dl_jobs_s *ctx)
+{
+	const guint nb = MIN(ctx->sds->download_parallelism, ctx->jobs->len);
+	GRID_DEBUG("%s %u jobs, %u at once", __FUNCTION__, ctx->jobs->len, nb);
+
+	GPtrArray *threads = g_ptr_array_new ();
+	for (guint i=1; i<nb ;++i)
+		g_ptr_array_add (threads,
+				g_thread_new ("download", (GThreadFunc)_jobs_worker, ctx));
+	_jobs_worker (ctx);
+	for (guint i=0; i<threads->len ;++i)
+		g_thread_join (threads->pdata[i]);
+	g_ptr_array_free (threads, TRUE);
+	return ctx->err;
+}
+
+/* Download the ranges of <src> (by default, the first <max> bytes of the
+ * content) at their position in <fd>, or in <base> if <fd> is not valid. */
+static GError *
+_download_positioned (struct oio_sds_s *sds, struct oio_sds_dl_src_s *src,
+		gsize max, int fd, guint8 *base, size_t *out_size)
+{
+	GSList *chunks = NULL;
+	struct metachunk_s **metachunks = NULL;
+	GError *err = _download_load (sds, src->url, &chunks, &metachunks);
+	if (err)
+		return err;
+
+	const gsize total = _metachunks_total_size (metachunks);
+	struct oio_sds_dl_range_s range_auto = {0, MIN(max, total)};
+	struct oio_sds_dl_range_s *range_autov[2] = {&range_auto, NULL};
+	struct oio_sds_dl_range_s **ranges = range_autov;
+	if (src->ranges && src->ranges[0]) {
+		ranges = src->ranges;
+		err = _check_ranges (ranges, total);
+	}
+
+	if (!err) {
+		struct _dl_jobs_s ctx = {
+			.sds = sds, .metachunks = metachunks,
+			.jobs = _build_jobs (metachunks, ranges),
+			.fd = fd, .base = base, .next = 0, .err = NULL,
+		};
+		g_mutex_init (&ctx.lock);
+		if (!(err = _run_jobs (&ctx))) {
+			for (guint i=0; i<ctx.jobs->len ;++i)
+				*out_size += g_array_index (ctx.jobs, struct _dl_job_s, i).range.size;
+		}
+		g_mutex_clear (&ctx.lock);
+		g_array_free (ctx.jobs, TRUE);
+	}
+
+	_metachunk_cleanv (metachunks);
 	g_slist_free_full (chunks, g_free);
-	return (struct oio_error_s*) err;
+	return err;
 }
 
 static struct oio_error_s*
 _download_to_file (struct oio_sds_s *sds, struct oio_sds_dl_src_s *src,
 		struct oio_sds_dl_dst_s *dst)
 {
-	int fd = -1;
-	FILE *out = NULL;
-	struct oio_error_s *err = NULL;
-
 	_dl_debug (__FUNCTION__, src, dst);
 
-	fd = open (dst->data.file.path, O_CREAT|O_EXCL|O_WRONLY, 0644);
-	if (fd < 0) {
-		err = (struct oio_error_s*) NEWERROR (CODE_INTERNAL_ERROR,
+	int fd = open (dst->data.file.path, O_CREAT|O_EXCL|O_WRONLY, 0644);
+	if (fd < 0)
+		return (struct oio_error_s*) NEWERROR (CODE_INTERNAL_ERROR,
 				"open() error: (%d) %s", errno, strerror(errno));
-	} else {
-		out = fdopen(fd, "a");
-		if (out) {
-			struct oio_sds_dl_dst_s snk0 = {
-				.out_size = 0,
-				.type = OIO_DL_DST_HOOK_SEQUENTIAL,
-				.data = { .hook = {
-					.cb = _write_FILE,
-					.ctx = out,
-					.length = (size_t)-1,
-				} }
-			};
-			err = _download_to_hook (sds, src, &snk0);
-			dst->out_size = snk0.out_size;
-			fclose (out);
-		}
-		if (!err) {
-			posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
-			if (sds->sync_after_download)
-				fsync(fd);
-		}
-		close(fd);
+
+	GError *err = _download_positioned (sds, src, (gsize)-1, fd, NULL,
+			&dst->out_size);
+	if (!err) {
+		posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+		if (sds->sync_after_download)
+			fsync(fd);
 	}
-	return err;
+	close(fd);
+	return (struct oio_error_s*) err;
 }
 
 static struct oio_error_s*
 _download_to_buffer (struct oio_sds_s *sds, struct oio_sds_dl_src_s *src,
 		struct oio_sds_dl_dst_s *dst)
 {
-	FILE *out = NULL;
-	struct oio_error_s *err = NULL;
-
 	_dl_debug (__FUNCTION__, src, dst);
 
 	if (src->ranges != NULL && src->ranges[0] != NULL) {
@@ -864,31 +1369,12 @@ _download_to_buffer (struct oio_sds_s *sds, struct oio_sds_dl_src_s *src,
 		if (total > dst->data.buffer.length)
 			return (struct oio_error_s*) NEWERROR (CODE_BAD_REQUEST,
 					"Buffer too small for the specified ranges");
-	} else {
-		/* No range specified: we need more information to fake a range, e.g.
-		 * the first 'dst->data.buffer.length' of the content. */
 	}
 
-	out = fmemopen(dst->data.buffer.ptr, dst->data.buffer.length, "w");
-	if (!out) {
-		err = (struct oio_error_s*) NEWERROR (CODE_INTERNAL_ERROR,
-				"fmemopen() error: (%d) %s", errno, strerror(errno));
-	} else {
-		struct oio_sds_dl_dst_s dst0 = {
-			.out_size = 0,
-			.type = OIO_DL_DST_HOOK_SEQUENTIAL,
-			.data = { .hook = {
-				.cb = _write_FILE,
-				.ctx = out,
-				.length = dst->data.buffer.length,
-			} }
-		};
-		err = _download_to_hook (sds, src, &dst0);
-		if (out)
-			fclose (out);
-		dst->out_size = dst0.out_size;
-	}
-	return err;
+	/* No range specified: the first 'dst->data.buffer.length' bytes of the
+	 * content are read. */
+	return (struct oio_error_s*) _download_positioned (sds, src,
+			dst->data.buffer.length, -1, dst->data.buffer.ptr, &dst->out_size);
 }
 
 struct oio_error_s*
@@ -928,12 +1414,202 @@ oio_sds_download_to_file (struct oio_sds_s *sds, struct oio_url_s *url,
 	return oio_sds_download (sds, &dl, &snk);
 }
 
-/* Upload ------------------------------------------------------------------- */
+/* Reader ------------------------------------------------------------------- */
 
-struct oio_sds_ul_s
+struct oio_sds_reader_s
 {
-	gboolean started;
-	gboolean finished;
+	struct oio_sds_s *sds;
+	GSList *chunks;
+	struct metachunk_s **metachunks;
+	gsize size;
+	gsize position;
+
+	/* The data that follows the last sequential read, fetched in the
+	 * background meanwhile the caller consumes the previous one. */
+	struct {
+		GThread *th;
+		guint8 *data;
+		gsize offset;
+		gsize size;
+		gsize consumed;
+		GError *err;
+	} ahead;
+};
+
+static GError *
+_reader_fetch (struct oio_sds_reader_s *r, guint8 *buf, gsize offset,
+		gsize len)
+{
+	struct oio_sds_dl_range_s range = {.offset = offset, .size = len};
+	struct _dl_cursor_s cur = {.fd = -1, .base = buf, .offset = 0, .end = len};
+	return _download_range_to_cursor (r->sds, r->metachunks, &range, &cur);
+}
+
+static gpointer
+_reader_ahead_worker (struct oio_sds_reader_s *r)
+{
+	r->ahead.err = _reader_fetch (r, r->ahead.data, r->ahead.offset,
+			r->ahead.size);
+	return r;
+}
+
+static void
+_reader_ahead_start (struct oio_sds_reader_s *r)
+{
+	g_assert (NULL == r->ahead.th);
+	g_assert (NULL == r->ahead.data);
+	if (!r->sds->readahead || r->position >= r->size)
+		return;
+	r->ahead.offset = r->position;
+	r->ahead.size = MIN(r->sds->readahead, r->size - r->position);
+	r->ahead.consumed = 0;
+	r->ahead.data = g_malloc (r->ahead.size);
+	r->ahead.th = g_thread_new ("readahead",
+			(GThreadFunc)_reader_ahead_worker, r);
+}
+
+static void
+_reader_ahead_join (struct oio_sds_reader_s *r)
+{
+	if (r->ahead.th) {
+		g_thread_join (r->ahead.th);
+		r->ahead.th = NULL;
+	}
+}
+
+static void
+_reader_ahead_drop (struct oio_sds_reader_s *r)
+{
+	_reader_ahead_join (r);
+	g_clear_error (&r->ahead.err);
+	g_free (r->ahead.data);
+	r->ahead.data = NULL;
+	r->ahead.size = r->ahead.consumed = 0;
+}
+
+/* Copy into <buf> what the readahead holds at the current position. A
+ * failed readahead is forgotten, the data is then fetched again. */
+static gsize
+_reader_ahead_consume (struct oio_sds_reader_s *r, guint8 *buf, gsize len)
+{
+	if (!r->ahead.data)
+		return 0;
+	_reader_ahead_join (r);
+	if (r->ahead.err) {
+		GRID_DEBUG("Readahead failed: (%d) %s",
+				r->ahead.err->code, r->ahead.err->message);
+		_reader_ahead_drop (r);
+		return 0;
+	}
+	g_assert (r->ahead.offset + r->ahead.consumed == r->position);
+
+	gsize n = MIN(len, r->ahead.size - r->ahead.consumed);
+	memcpy (buf, r->ahead.data + r->ahead.consumed, n);
+	r->ahead.consumed += n;
+	if (r->ahead.consumed >= r->ahead.size)
+		_reader_ahead_drop (r);
+	return n;
+}
+
+struct oio_error_s*
+oio_sds_reader_open (struct oio_sds_s *sds, struct oio_url_s *url,
+		struct oio_sds_reader_s **out)
+{
+	if (!sds || !url || !out)
+		return (struct oio_error_s*) BADREQ("Missing argument");
+	oio_ext_set_reqid (sds->session_id);
+	*out = NULL;
+
+	GSList *chunks = NULL;
+	struct metachunk_s **metachunks = NULL;
+	GError *err = _download_load (sds, url, &chunks, &metachunks);
+	if (err)
+		return (struct oio_error_s*) err;
+
+	struct oio_sds_reader_s *r = g_malloc0 (sizeof(*r));
+	r->sds = sds;
+	r->chunks = chunks;
+	r->metachunks = metachunks;
+	r->size = _metachunks_total_size (metachunks);
+	*out = r;
+	return NULL;
+}
+
+size_t
+oio_sds_reader_get_size (struct oio_sds_reader_s *r)
+{
+	return r ? r->size : 0;
+}
+
+struct oio_error_s*
+oio_sds_reader_read (struct oio_sds_reader_s *r, unsigned char *buf,
+		size_t len, size_t *out_len)
+{
+	if (!r || !buf || !out_len)
+		return (struct oio_error_s*) BADREQ("Missing argument");
+	*out_len = 0;
+	len = MIN(len, r->size - r->position);
+	if (!len)
+		return NULL;
+
+	gsize done = _reader_ahead_consume (r, buf, len);
+	r->position += done;
+	if (done < len) {
+		GError *err = _reader_fetch (r, buf + done, r->position, len - done);
+		if (err) {
+			/* What has been consumed is returned, the failure will occur
+			 * again at the next read */
+			*out_len = done;
+			if (!done)
+				return (struct oio_error_s*) err;
+			g_clear_error (&err);
+			return NULL;
+		}
+		r->position += len - done;
+	}
+	*out_len = len;
+
+	if (!r->ahead.data)
+		_reader_ahead_start (r);
+	return NULL;
+}
+
+struct oio_error_s*
+oio_sds_reader_pread (struct oio_sds_reader_s *r, unsigned char *buf,
+		size_t len, size_t offset, size_t *out_len)
+{
+	if (!r || !buf || !out_len)
+		return (struct oio_error_s*) BADREQ("Missing argument");
+	*out_len = 0;
+	if (offset >= r->size)
+		return NULL;
+	len = MIN(len, r->size - offset);
+	if (!len)
+		return NULL;
+
+	GError *err = _reader_fetch (r, buf, offset, len);
+	if (!err)
+		*out_len = len;
+	return (struct oio_error_s*) err;
+}
+
+void
+oio_sds_reader_close (struct oio_sds_reader_s *r)
+{
+	if (!r)
+		return;
+	_reader_ahead_drop (r);
+	_metachunk_cleanv (r->metachunks);
+	g_slist_free_full (r->chunks, g_free);
+	g_free (r);
+}
+
+/* Upload ------------------------------------------------------------------- */
+
+struct oio_sds_ul_s
+{
+	gboolean started;
+	gboolean finished;
 	gboolean ready_for_data;
 
 	/* set at _init() */
@@ -960,7 +1636,9 @@ struct oio_sds_ul_s
 	struct http_put_s *put;
 	GSList *http_dests;
 	size_t local_done;
-	GChecksum *checksum_chunk;
+	struct oio_hash_s *checksum_chunk;
+	/* replaces <put> for an EC metachunk, its data until it is encoded */
+	GByteArray *ec_data;
 };
 
 static void
@@ -972,14 +1650,14 @@ _assert_no_upload (struct oio_sds_ul_s *ul)
 	g_assert (NULL == ul->put);
 	g_assert (NULL == ul->http_dests);
 	g_assert (NULL == ul->checksum_chunk);
+	g_assert (NULL == ul->ec_data);
 	g_assert (0 == ul->local_done);
 }
 
 static void
 _sds_upload_reset (struct oio_sds_ul_s *ul)
 {
-	if (ul->checksum_chunk)
-		g_checksum_free (ul->checksum_chunk);
+	oio_hash_free (ul->checksum_chunk);
 	ul->checksum_chunk = NULL;
 	_metachunk_clean (ul->mc);
 	ul->mc = NULL;
@@ -989,6 +1667,10 @@ _sds_upload_reset (struct oio_sds_ul_s *ul)
 	ul->put = NULL;
 	g_slist_free (ul->http_dests);
 	ul->http_dests = NULL;
+	if (ul->ec_data) {
+		g_byte_array_free (ul->ec_data, TRUE);
+		ul->ec_data = NULL;
+	}
 	ul->local_done = 0;
 }
 
@@ -1164,37 +1846,343 @@ oio_sds_upload_feed (struct oio_sds_ul_s *ul,
 	return NULL;
 }
 
-static GError *
-_sds_upload_finish (struct oio_sds_ul_s *ul)
+/* The chunks are hashed with the algorithm named in the chunk method. With
+ * MD5, the first metachunk has no hash of its own: it starts the content, so
+ * its hash is taken from the checksum of the content and each byte is hashed
+ * once. */
+static struct oio_hash_s *
+_metachunk_hash_new (struct oio_sds_ul_s *ul, guint meta)
 {
-	GRID_TRACE("%s (%p)", __FUNCTION__, ul);
-	g_assert (ul->mc != NULL);
-	GError *err = NULL;
+	enum oio_hash_algo_e algo = oio_hash_algo_of_chunk_method (ul->chunk_method);
+	if (!meta && algo == OIO_HASH_MD5)
+		return NULL;
+	return oio_hash_new (algo);
+}
 
-	guint failures = http_put_get_failure_number (ul->put);
-	guint total = g_slist_length (ul->http_dests);
+/* Check enough chunks of <mc> have been written by <put>, then patch them
+ * with their final size and hash. <checksum> is NULL when the hash of <mc>
+ * is the checksum of the content. */
+static GError *
+_metachunk_close (struct oio_sds_ul_s *ul, struct metachunk_s *mc,
+		struct http_put_s *put, struct oio_hash_s *checksum)
+{
+	guint failures = http_put_get_failure_number (put);
+	guint total = g_slist_length (mc->chunks);
 	GRID_TRACE("%s uploads %u/%u failed", __FUNCTION__, failures, total);
 
-	if (failures >= total) {
-		err = NEWERROR(CODE_PLATFORM_ERROR, "No upload succeeded");
-	} else {
-		/* patch the chunk sizes and positions */
-		ul->mc->size = ul->local_done;
-		for (GSList *l=ul->mc->chunks; l ;l=l->next) {
+	if (failures > 0) {
+		for (GSList *l=mc->chunks; l ;l=l->next) {
 			struct chunk_s *c = l->data;
-			c->size = ul->mc->size;
-			g_assert (c->position.meta == ul->mc->meta);
+			guint code = http_put_get_http_code (put, c);
+			if (code / 100 != 2)
+				GRID_WARN("Chunk [%s] not written (%u), needs a repair",
+						c->url, code);
 		}
+	}
 
-		if (ul->checksum_chunk) {
-			const char *h = g_checksum_get_string (ul->checksum_chunk);
-			for (GSList *l=ul->mc->chunks; l ;l=l->next) {
-				struct chunk_s *c = l->data;
-				g_strlcpy (c->hexhash, h, sizeof(c->hexhash));
-				oio_str_upper (c->hexhash);
-			}
+	if (failures >= total)
+		return NEWERROR(CODE_PLATFORM_ERROR, "No upload succeeded");
+	if (ul->sds->put_quorum > 0
+			&& total - failures < MIN(ul->sds->put_quorum, total))
+		return NEWERROR(CODE_PLATFORM_ERROR, "Quorum not reached (%u/%u)",
+				total - failures, MIN(ul->sds->put_quorum, total));
+
+	/* patch the chunk sizes and positions */
+	for (GSList *l=mc->chunks; l ;l=l->next) {
+		struct chunk_s *c = l->data;
+		c->size = mc->size;
+		g_assert (c->position.meta == mc->meta);
+	}
+
+	gchar h[OIO_HASH_STRLEN];
+	if (checksum) {
+		g_strlcpy (h, oio_hash_get_string (checksum), sizeof(h));
+	} else {
+		GChecksum *copy = g_checksum_copy (ul->checksum_content);
+		g_strlcpy (h, g_checksum_get_string (copy), sizeof(h));
+		g_checksum_free (copy);
+		oio_str_upper (h);
+	}
+	for (GSList *l=mc->chunks; l ;l=l->next) {
+		struct chunk_s *c = l->data;
+		g_strlcpy (c->hexhash, h, sizeof(c->hexhash));
+	}
+	return NULL;
+}
+
+/* Add the chunk <c> as a destination of <put>, with all the headers the
+ * rawx expects. */
+static struct http_put_dest_s *
+_sds_upload_dest_add (struct oio_sds_ul_s *ul, struct http_put_s *put,
+		struct chunk_s *c)
+{
+	struct http_put_dest_s *dest = http_put_add_dest (put, c->url, c);
+
+	http_put_dest_add_header (dest, PROXYD_HEADER_REQID,
+			"%s", oio_ext_get_reqid());
+
+	http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "container-id",
+			"%s", oio_url_get (ul->dst->url, OIOURL_HEXID));
+
+	gchar *escaped = g_uri_escape_string (oio_url_get (
+				ul->dst->url, OIOURL_PATH), NULL, TRUE);
+	http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "content-path",
+			"%s", escaped);
+	g_free (escaped);
+
+	http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "content-version",
+			"%" G_GINT64_FORMAT, ul->version);
+	http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "content-id",
+			"%s", ul->hexid);
+
+	http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "content-storage-policy",
+			"%s", ul->stgpol);
+	http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "content-chunk-method",
+			"%s", ul->chunk_method);
+	http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "content-mime-type",
+			"%s", ul->mime_type);
+
+	http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "chunk-id",
+			"%s", strrchr(c->url, '/')+1);
+
+	gchar strpos[32];
+	_chunk_pack_position (c, strpos, sizeof(strpos));
+	http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "chunk-pos",
+			"%s", strpos);
+	return dest;
+}
+
+/* Initiate the PolyPut (c) of <mc> with all its targets. When <dests> is
+ * set, it receives the destinations in the order of the chunks. */
+static struct http_put_s *
+_sds_upload_put_create (struct oio_sds_ul_s *ul, struct metachunk_s *mc,
+		struct http_put_s *sibling, gint64 content_length,
+		gint64 soft_length, GSList **dests)
+{
+	struct http_put_s *put = http_put_create_sibling (sibling,
+			content_length, soft_length);
+	for (GSList *l=mc->chunks; l ;l=l->next) {
+		struct http_put_dest_s *dest = _sds_upload_dest_add (ul, put, l->data);
+		if (dests)
+			*dests = g_slist_append (*dests, dest);
+	}
+
+	/* The quorum only makes sense among replicas of the same data */
+	struct chunk_s *first = mc->chunks ? mc->chunks->data : NULL;
+	if (ul->sds->put_quorum > 0 && first && !first->position.ec)
+		http_put_set_quorum (put, ul->sds->put_quorum,
+				HTTP_PUT_DEFAULT_STRAGGLER_DELAY);
+	return put;
+}
+
+/* Erasure coding ----------------------------------------------------------- */
+
+static GError *
+_ec_check_support (void)
+{
+#ifdef HAVE_LIBRAIN
+	return NULL;
+#else
+	return NEWERROR(CODE_NOT_IMPLEMENTED,
+			"Erasure coding not supported by this build");
+#endif
+}
+
+struct ec_fragment_s
+{
+	struct chunk_s *chunk;
+	struct http_put_s *put;
+	gsize size;
+	gchar *hash;
+};
+
+/* A metachunk of an EC content, encoded at once. The data fragments point
+ * into the padded copy of the data, the parity ones are allocated apart. */
+struct ec_stripe_s
+{
+	gsize size;
+	guint k;
+	guint m;
+	guint8 *data;
+	guint8 **coding;
+	GArray *fragments; /* in the order of the chunks */
+};
+
+static void
+_ec_stripe_free (struct ec_stripe_s *st)
+{
+	if (!st)
+		return;
+	for (guint i=0; i<st->fragments->len ;++i) {
+		struct ec_fragment_s *f =
+			&g_array_index (st->fragments, struct ec_fragment_s, i);
+		http_put_destroy (f->put);
+		g_free (f->hash);
+	}
+	g_array_free (st->fragments, TRUE);
+	for (guint i=0; i<st->m ;++i)
+		g_free (st->coding[i]);
+	g_free (st->coding);
+	g_free (st->data);
+	g_free (st);
+}
+
+/* Encode the <len> bytes at <data>, then start the upload of each fragment
+ * to its chunk of <mc>. The uploads share the I/O loop of <sibling>. */
+static GError *
+_ec_stripe_create (struct oio_sds_ul_s *ul, struct metachunk_s *mc,
+		const guint8 *data, gsize len, struct http_put_s *sibling,
+		struct ec_stripe_s **out)
+{
+#ifndef HAVE_LIBRAIN
+	(void) ul, (void) mc, (void) data, (void) len, (void) sibling, (void) out;
+	return _ec_check_support ();
+#else
+	struct ec_params_s params;
+	struct rain_encoding_s enc;
+	memset (&enc, 0, sizeof(enc));
+	GError *err = _ec_params_load (ul->chunk_method, &params);
+	if (!err && len > 0)
+		err = _ec_encoding_init (&enc, len, &params);
+	if (err)
+		return err;
+
+	struct ec_stripe_s *st = g_malloc0 (sizeof(*st));
+	st->size = len;
+	st->k = params.k;
+	st->m = params.m;
+	st->coding = g_malloc0 (params.m * sizeof(guint8*));
+	st->fragments = g_array_new (FALSE, TRUE, sizeof(struct ec_fragment_s));
+
+	/* An empty stripe needs no encoding, all its fragments are empty */
+	if (len > 0) {
+		st->data = g_malloc0 (enc.data_size);
+		memcpy (st->data, data, len);
+		if (!rain_encode (st->data, enc.data_size, &enc, &rain_env, st->coding))
+			err = NEWERROR(CODE_INTERNAL_ERROR, "Failed to encode the stripe");
+	}
+
+	const enum oio_hash_algo_e algo =
+		oio_hash_algo_of_chunk_method (ul->chunk_method);
+	for (GSList *l=mc->chunks; !err && l ;l=l->next) {
+		struct chunk_s *c = l->data;
+		if (c->position.intra >= (c->position.parity ? st->m : st->k)) {
+			err = NEWERROR(CODE_INTERNAL_ERROR,
+					"Fragment out of the stripe: %s", c->url);
+			break;
 		}
+		struct ec_fragment_s f = {.chunk = c, .put = NULL, .size = 0};
+		const guint8 *b = (const guint8*) "";
+		if (len > 0) {
+			f.size = _ec_fragment_size (&enc, len, c);
+			b = c->position.parity ? st->coding[c->position.intra]
+				: st->data + (gsize)c->position.intra * enc.block_size;
+		}
+		f.hash = oio_hash_compute_for_data (algo, b, f.size);
+		f.put = http_put_create_sibling (sibling, f.size, f.size);
+		sibling = f.put;
+		_sds_upload_dest_add (ul, f.put, c);
+		if (f.size > 0)
+			http_put_feed (f.put, g_bytes_new_static (b, f.size));
+		g_array_append_val (st->fragments, f);
+	}
+
+	if (err) {
+		_ec_stripe_free (st);
+		return err;
+	}
+	*out = st;
+	return NULL;
+#endif
+}
+
+static void
+_ec_stripe_add_puts (struct ec_stripe_s *st, GPtrArray *puts)
+{
+	for (guint i=0; i<st->fragments->len ;++i)
+		g_ptr_array_add (puts,
+				g_array_index (st->fragments, struct ec_fragment_s, i).put);
+}
+
+static gboolean
+_ec_stripe_done (struct ec_stripe_s *st)
+{
+	for (guint i=0; i<st->fragments->len ;++i) {
+		if (!http_put_done (g_array_index (st->fragments,
+						struct ec_fragment_s, i).put))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static GError *
+_ec_stripe_step (struct ec_stripe_s *st)
+{
+	GPtrArray *puts = g_ptr_array_new ();
+	_ec_stripe_add_puts (st, puts);
+	g_ptr_array_add (puts, NULL);
+	GError *err = http_put_step_many ((struct http_put_s **) puts->pdata);
+	g_ptr_array_free (puts, TRUE);
+	return err;
+}
+
+/* Any k fragments are enough to read the stripe, the missing ones are left
+ * to the rebuild. Each chunk is patched with the size and the hash of its
+ * own fragment. */
+static GError *
+_ec_stripe_close (struct metachunk_s *mc, struct ec_stripe_s *st)
+{
+	guint written = 0;
+	for (guint i=0; i<st->fragments->len ;++i) {
+		struct ec_fragment_s *f =
+			&g_array_index (st->fragments, struct ec_fragment_s, i);
+		guint code = http_put_get_http_code (f->put, f->chunk);
+		if (code / 100 == 2)
+			++ written;
+		else
+			GRID_WARN("Chunk [%s] not written (%u), needs a repair",
+					f->chunk->url, code);
+	}
+	if (written < st->k)
+		return NEWERROR(CODE_PLATFORM_ERROR,
+				"Too few fragments written (%u/%u)", written, st->k);
+
+	for (guint i=0; i<st->fragments->len ;++i) {
+		struct ec_fragment_s *f =
+			&g_array_index (st->fragments, struct ec_fragment_s, i);
+		g_assert (f->chunk->position.meta == mc->meta);
+		f->chunk->size = f->size;
+		g_strlcpy (f->chunk->hexhash, f->hash, sizeof(f->chunk->hexhash));
+	}
+	mc->size = st->size;
+	return NULL;
+}
+
+/* Encode and upload the data accumulated for the current metachunk */
+static GError *
+_sds_upload_close_ec (struct oio_sds_ul_s *ul)
+{
+	struct ec_stripe_s *st = NULL;
+	GError *err = _ec_stripe_create (ul, ul->mc, ul->ec_data->data,
+			ul->ec_data->len, NULL, &st);
+	while (!err && !_ec_stripe_done (st))
+		err = _ec_stripe_step (st);
+	if (!err)
+		err = _ec_stripe_close (ul->mc, st);
+	_ec_stripe_free (st);
+	return err;
+}
 
+static GError *
+_sds_upload_finish (struct oio_sds_ul_s *ul)
+{
+	GRID_TRACE("%s (%p)", __FUNCTION__, ul);
+	g_assert (ul->mc != NULL);
+
+	ul->mc->size = ul->local_done;
+	GError *err = ul->ec_data ? _sds_upload_close_ec (ul)
+		: _metachunk_close (ul, ul->mc, ul->put, ul->checksum_chunk);
+	if (!err) {
 		/* store the structure in holders for further commit/abort */
 		ul->chunks_done = g_slist_concat (ul->chunks_done, ul->chunks);
 		GRID_TRACE("%s > chunks +%u -> %u", __FUNCTION__,
@@ -1251,50 +2239,51 @@ _sds_upload_renew (struct oio_sds_ul_s *ul)
 		c->position.meta = ul->mc->meta;
 	}
 
-	/* Initiate the PolyPut (c) with all its targets */
-	ul->put = http_put_create (-1, ul->chunk_size);
-	for (GSList *l=ul->mc->chunks; l ;l=l->next) {
-		struct chunk_s *c = l->data;
-		struct http_put_dest_s *dest = http_put_add_dest (ul->put, c->url, c);
-
-		http_put_dest_add_header (dest, PROXYD_HEADER_REQID,
-				"%s", oio_ext_get_reqid());
-
-		http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "container-id",
-				"%s", oio_url_get (ul->dst->url, OIOURL_HEXID));
-
-		gchar *escaped = g_uri_escape_string (oio_url_get (
-					ul->dst->url, OIOURL_PATH), NULL, TRUE);
-		http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "content-path",
-				"%s", escaped);
-		g_free (escaped);
-
-		http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "content-version",
-				"%" G_GINT64_FORMAT, ul->version);
-		http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "content-id",
-				"%s", ul->hexid);
+	/* The data of an EC metachunk is encoded at once, when complete */
+	if (ul->mc->ec) {
+		GError *e = _ec_check_support ();
+		if (!e && ul->chunk_size <= 0)
+			e = NEWERROR(CODE_INTERNAL_ERROR, "No chunk size");
+		if (!e)
+			ul->ec_data = g_byte_array_new ();
+		return e;
+	}
 
-		http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "content-storage-policy",
-				"%s", ul->stgpol);
-		http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "content-chunk-method",
-				"%s", ul->chunk_method);
-		http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "content-mime-type",
-				"%s", ul->mime_type);
+	ul->put = _sds_upload_put_create (ul, ul->mc, NULL, -1, ul->chunk_size,
+			&ul->http_dests);
 
-		http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "chunk-id",
-				"%s", strrchr(c->url, '/')+1);
+	ul->checksum_chunk = _metachunk_hash_new (ul, ul->mc->meta);
+	GRID_TRACE("%s (%p) upload ready!", __FUNCTION__, ul);
+	return NULL;
+}
 
-		gchar strpos[32];
-		_chunk_pack_position (c, strpos, sizeof(strpos));
-		http_put_dest_add_header (dest, RAWX_HEADER_PREFIX "chunk-pos",
-				"%s", strpos);
+/* The EC metachunk is filled until it is full or the data ends */
+static GError *
+_sds_upload_step_ec (struct oio_sds_ul_s *ul)
+{
+	if (g_queue_is_empty (ul->buffer_tail))
+		return NULL;
 
-		ul->http_dests = g_slist_append (ul->http_dests, dest);
+	GBytes *buf = g_queue_pop_head (ul->buffer_tail);
+	gsize len = g_bytes_get_size (buf);
+	const gsize max = ul->chunk_size - ul->ec_data->len;
+	if (len > max) {
+		g_queue_push_head (ul->buffer_tail,
+				g_bytes_new_from_bytes (buf, max, len-max));
+		len = max;
+	}
+	if (len) {
+		const guint8 *b = g_bytes_get_data (buf, NULL);
+		g_byte_array_append (ul->ec_data, b, len);
+		g_checksum_update (ul->checksum_content, b, len);
+		ul->local_done += len;
 	}
+	g_bytes_unref (buf);
 
-	ul->checksum_chunk = g_checksum_new (G_CHECKSUM_MD5);
-	GRID_TRACE("%s (%p) upload ready!", __FUNCTION__, ul);
-	return NULL;
+	/* an empty buffer tells the end of the data */
+	if (len && ul->ec_data->len < (gsize)ul->chunk_size)
+		return NULL;
+	return _sds_upload_finish (ul);
 }
 
 struct oio_error_s *
@@ -1309,6 +2298,9 @@ oio_sds_upload_step (struct oio_sds_ul_s *ul)
 		return NULL;
 	}
 
+	if (ul->ec_data)
+		return (struct oio_error_s*) _sds_upload_step_ec (ul);
+
 	if (ul->put) {
 		/* maybe finish the previous upload */
 		gsize max = http_put_expected_bytes (ul->put);
@@ -1398,7 +2390,7 @@ oio_sds_upload_step (struct oio_sds_ul_s *ul)
 		const void *b = g_bytes_get_data (buf, &l);
 		if (l) {
 			if (ul->checksum_chunk)
-				g_checksum_update (ul->checksum_chunk, b, l);
+				oio_hash_update (ul->checksum_chunk, b, l);
 			g_checksum_update (ul->checksum_content, b, l);
 			ul->local_done += l;
 		}
@@ -1422,6 +2414,22 @@ _chunks_remove (CURL *h, GSList *chunks)
 	/* TODO JFS */
 }
 
+static gint64
+_ul_size (struct oio_sds_ul_s *ul)
+{
+	gint64 size = 0;
+	for (GList *l=g_list_first(ul->metachunk_done); l ;l=g_list_next(l))
+		size += ((struct metachunk_s*) l->data)->size;
+	return size;
+}
+
+static void
+_ul_hash (struct oio_sds_ul_s *ul, gchar *hash, gsize len)
+{
+	g_strlcpy (hash, g_checksum_get_string (ul->checksum_content), len);
+	oio_str_upper (hash);
+}
+
 struct oio_error_s *
 oio_sds_upload_commit (struct oio_sds_ul_s *ul)
 {
@@ -1431,17 +2439,14 @@ oio_sds_upload_commit (struct oio_sds_ul_s *ul)
 	if (ul->put && !http_put_done (ul->put))
 		return (struct oio_error_s *) SYSERR("RAWX upload not completed");
 
-	gint64 size = 0;
-	for (GList *l=g_list_first(ul->metachunk_done); l ;l=g_list_next(l))
-		size += ((struct metachunk_s*) l->data)->size;
+	gint64 size = _ul_size (ul);
 
 	GString *request_body = g_string_new("");
 	GString *reply_body = g_string_new ("");
 	_chunks_pack (request_body, ul->chunks_done);
 
 	gchar hash[STRLEN_CHUNKHASH];
-	g_strlcpy (hash, g_checksum_get_string (ul->checksum_content), sizeof(hash));
-	oio_str_upper (hash);
+	_ul_hash (ul, hash, sizeof(hash));
 	struct oio_proxy_content_create_in_s in = {
 		.size = size,
 		.version = ul->version,
@@ -1462,6 +2467,120 @@ oio_sds_upload_commit (struct oio_sds_ul_s *ul)
 	return (struct oio_error_s*) err;
 }
 
+/* Fills <errors> with the status of each content of a batch, as replied
+ * by the proxy in a JSON array, in the order of the request. Upon a global
+ * error, <errors> is left empty. */
+static GError *
+_batch_load_statuses (GString *reply, guint count, struct oio_error_s **errors)
+{
+	GError *err = NULL;
+	struct json_tokener *tok = json_tokener_new ();
+	struct json_object *jbody = json_tokener_parse_ex (tok,
+			reply->str, reply->len);
+	if (!json_object_is_type(jbody, json_type_array)
+			|| (guint) json_object_array_length(jbody) != count)
+		err = NEWERROR(0, "Invalid JSON from the OIO proxy");
+	for (guint i=0; !err && i<count ;i++) {
+		struct json_object *jstatus = NULL, *jmsg = NULL;
+		struct oio_ext_json_mapping_s m[] = {
+			{"status",  &jstatus, json_type_int,    1},
+			{"message", &jmsg,    json_type_string, 1},
+			{NULL, NULL, 0, 0}
+		};
+		if (NULL != (err = oio_ext_extract_json (
+						json_object_array_get_idx (jbody, i), m)))
+			g_prefix_error (&err, "Parsing: ");
+		else {
+			int code = json_object_get_int (jstatus);
+			if (!CODE_IS_OK(code))
+				errors[i] = (struct oio_error_s*) NEWERROR(code, "%s",
+						json_object_get_string (jmsg));
+		}
+	}
+	if (err) {
+		for (guint i=0; i<count ;i++)
+			g_clear_error ((GError**) &errors[i]);
+	}
+	json_object_put (jbody);
+	json_tokener_free (tok);
+	return err;
+}
+
+static gboolean
+_same_container (struct oio_url_s *u0, struct oio_url_s *u1)
+{
+	return !g_strcmp0 (oio_url_get (u0, OIOURL_NS), oio_url_get (u1, OIOURL_NS))
+		&& !g_strcmp0 (oio_url_get (u0, OIOURL_ACCOUNT), oio_url_get (u1, OIOURL_ACCOUNT))
+		&& !g_strcmp0 (oio_url_get (u0, OIOURL_USER), oio_url_get (u1, OIOURL_USER));
+}
+
+struct oio_error_s *
+oio_sds_upload_commit_many (struct oio_sds_ul_s **uls,
+		struct oio_error_s **errors)
+{
+	g_assert (uls != NULL);
+	g_assert (errors != NULL);
+
+	guint count = 0;
+	for (struct oio_sds_ul_s **pul=uls; *pul ;++pul, ++count) {
+		struct oio_sds_ul_s *ul = *pul;
+		errors[count] = NULL;
+		if (ul->put && !http_put_done (ul->put))
+			return (struct oio_error_s *) SYSERR("RAWX upload not completed");
+		if (ul->sds != uls[0]->sds
+				|| !_same_container (ul->dst->url, uls[0]->dst->url))
+			return (struct oio_error_s *) BADREQ("Contents in several containers");
+	}
+	if (!count)
+		return NULL;
+
+	GString *request_body = g_string_new("[");
+	for (guint i=0; i<count ;i++) {
+		struct oio_sds_ul_s *ul = uls[i];
+		gchar hash[STRLEN_CHUNKHASH];
+		_ul_hash (ul, hash, sizeof(hash));
+		if (i)
+			g_string_append_c (request_body, ',');
+		g_string_append_c (request_body, '{');
+		oio_str_gstring_append_json_pair (request_body, "path",
+				oio_url_get (ul->dst->url, OIOURL_PATH));
+		if (ul->hexid) {
+			g_string_append_c (request_body, ',');
+			oio_str_gstring_append_json_pair (request_body, "id", ul->hexid);
+		}
+		if (ul->stgpol) {
+			g_string_append_c (request_body, ',');
+			oio_str_gstring_append_json_pair (request_body, "policy", ul->stgpol);
+		}
+		g_string_append_printf (request_body,
+				",\"version\":%"G_GINT64_FORMAT
+				",\"size\":%"G_GINT64_FORMAT
+				",\"hash\":\"%s\""
+				",\"chunks\":",
+				ul->version, _ul_size (ul), hash);
+		_chunks_pack (request_body, ul->chunks_done);
+		g_string_append_c (request_body, '}');
+	}
+	g_string_append_c (request_body, ']');
+
+	struct oio_sds_s *sds = uls[0]->sds;
+	GString *reply_body = g_string_new ("");
+	oio_ext_set_reqid (sds->session_id);
+	GError *err = oio_proxy_call_content_create_many (sds->h,
+			uls[0]->dst->url, request_body, reply_body);
+	if (!err)
+		err = _batch_load_statuses (reply_body, count, errors);
+
+	for (guint i=0; i<count ;i++) {
+		if (uls[i]->chunks_failed)
+			_chunks_remove (sds->h, uls[i]->chunks_failed);
+	}
+
+	g_string_free (request_body, TRUE);
+	g_string_free (reply_body, TRUE);
+	return (struct oio_error_s*) err;
+}
+
 struct oio_error_s *
 oio_sds_upload_abort (struct oio_sds_ul_s *ul)
 {
@@ -1556,6 +2675,260 @@ _upload_sequential (struct oio_sds_s *sds, struct oio_sds_ul_dst_s *dst,
 	return (GError*) err;
 }
 
+/* Parallel uploads ---------------------------------------------------------
+ * When the whole data is available at once (a file or a buffer), several
+ * metachunks may be uploaded at the same time, each from its own range of
+ * the data. All the uploads share the same I/O loop. */
+
+#define UL_PARALLEL_BUFFER (1024 * 1024)
+#define UL_PARALLEL_WINDOW (4 * UL_PARALLEL_BUFFER)
+
+struct ul_range_src_s
+{
+	int fd; /* used when <base> is NULL */
+	const guint8 *base;
+	gsize offset;
+	gsize size;
+};
+
+struct ul_running_s
+{
+	struct metachunk_s *mc;
+	struct http_put_s *put;
+	struct oio_hash_s *checksum;
+	struct ec_stripe_s *stripe; /* instead of <put> for an EC metachunk */
+	gsize fed;
+};
+
+static GError *
+_range_read (struct ul_range_src_s *src, gsize off, gsize len, GBytes **out)
+{
+	if (src->base) {
+		*out = g_bytes_new_static (src->base + src->offset + off, len);
+		return NULL;
+	}
+	guint8 *buf = g_malloc (len);
+	for (gsize total = 0; total < len ;) {
+		ssize_t r = pread (src->fd, buf + total, len - total,
+				src->offset + off + total);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0) {
+			g_free (buf);
+			return r < 0
+				? SYSERR("pread() error: (%d) %s", errno, strerror(errno))
+				: SYSERR("pread() error: unexpected EOF");
+		}
+		total += r;
+	}
+	*out = g_bytes_new_take (buf, len);
+	return NULL;
+}
+
+static void
+_running_free (struct ul_running_s *r)
+{
+	if (!r)
+		return;
+	_metachunk_clean (r->mc);
+	http_put_destroy (r->put);
+	oio_hash_free (r->checksum);
+	_ec_stripe_free (r->stripe);
+	g_free (r);
+}
+
+/* Any upload of <r>, to share its I/O loop */
+static struct http_put_s *
+_running_put (struct ul_running_s *r)
+{
+	if (r->stripe)
+		return g_array_index (r->stripe->fragments, struct ec_fragment_s, 0).put;
+	return r->put;
+}
+
+/* Feed <r> within the input window, each metachunk has its own checksum.
+ * The data of the metachunk that continues the content already hashed also
+ * feeds the checksum of the content, that is then not read again. */
+static GError *
+_running_feed (struct oio_sds_ul_s *ul, struct ul_range_src_s *src,
+		struct ul_running_s *r, gsize *content_hashed)
+{
+	/* An EC stripe has been fed as a whole at its start */
+	if (r->stripe) {
+		if (!r->fed && r->mc->offset == *content_hashed && r->stripe->size) {
+			g_checksum_update (ul->checksum_content, r->stripe->data,
+					r->stripe->size);
+			*content_hashed += r->stripe->size;
+		}
+		r->fed = r->mc->size;
+		return NULL;
+	}
+
+	while (r->fed < r->mc->size
+			&& http_put_queued_bytes (r->put) < UL_PARALLEL_WINDOW) {
+		GBytes *buf = NULL;
+		gsize len = MIN(UL_PARALLEL_BUFFER, r->mc->size - r->fed);
+		GError *err = _range_read (src, r->mc->offset + r->fed, len, &buf);
+		if (err)
+			return err;
+		const void *b = g_bytes_get_data (buf, NULL);
+		if (r->checksum)
+			oio_hash_update (r->checksum, b, len);
+		if (r->mc->offset + r->fed == *content_hashed) {
+			g_checksum_update (ul->checksum_content, b, len);
+			*content_hashed += len;
+		}
+		http_put_feed (r->put, buf);
+		r->fed += len;
+	}
+	return NULL;
+}
+
+/* Start the next metachunk, at <offset> in the content */
+static GError *
+_running_start (struct oio_sds_ul_s *ul, struct ul_range_src_s *src,
+		guint meta, gsize offset, struct http_put_s *sibling,
+		struct ul_running_s **out)
+{
+	if (g_queue_is_empty (ul->metachunk_ready)) {
+		/* The chunks of the previous prepare are already organized */
+		ul->chunks_done = g_slist_concat (ul->chunks_done, ul->chunks);
+		ul->chunks = NULL;
+		GError *err = (GError*) oio_sds_upload_prepare (ul, src->size - offset);
+		if (err)
+			return err;
+	}
+
+	struct ul_running_s *r = g_malloc0 (sizeof(*r));
+	r->mc = g_queue_pop_head (ul->metachunk_ready);
+	r->mc->meta = meta;
+	r->mc->offset = offset;
+	r->mc->size = MIN((gsize)ul->chunk_size, src->size - offset);
+	for (GSList *l=r->mc->chunks; l ;l=l->next)
+		((struct chunk_s*)l->data)->position.meta = meta;
+
+	if (r->mc->ec) {
+		GBytes *buf = NULL;
+		GError *err = _ec_check_support ();
+		if (!err)
+			err = _range_read (src, offset, r->mc->size, &buf);
+		if (!err)
+			err = _ec_stripe_create (ul, r->mc, g_bytes_get_data (buf, NULL),
+					r->mc->size, sibling, &r->stripe);
+		if (buf)
+			g_bytes_unref (buf);
+		if (err) {
+			_running_free (r);
+			return err;
+		}
+	} else {
+		r->put = _sds_upload_put_create (ul, r->mc, sibling,
+				r->mc->size, r->mc->size, NULL);
+		r->checksum = oio_hash_new (oio_hash_algo_of_chunk_method (ul->chunk_method));
+	}
+	*out = r;
+	return NULL;
+}
+
+static GError *
+_upload_parallel (struct oio_sds_s *sds, struct oio_sds_ul_dst_s *dst,
+		struct ul_range_src_s *src)
+{
+	GRID_DEBUG("%s %"G_GSIZE_FORMAT" bytes, %u metachunks at once",
+			__FUNCTION__, src->size, sds->upload_parallelism);
+
+	struct oio_sds_ul_s *ul = oio_sds_upload_init (sds, dst);
+	if (!ul)
+		return SYSERR("Resource allocation failure");
+
+	GError *err = (GError*) oio_sds_upload_prepare (ul, src->size);
+	if (!err && ul->chunk_size <= 0)
+		err = NEWERROR(CODE_INTERNAL_ERROR, "No chunk size");
+
+	GPtrArray *running = g_ptr_array_new ();
+	GPtrArray *done = g_ptr_array_new (); /* indexed by metachunk */
+	gsize next_offset = 0, content_hashed = 0;
+
+	while (!err && (next_offset < src->size || running->len > 0)) {
+
+		while (!err && next_offset < src->size
+				&& running->len < sds->upload_parallelism) {
+			struct ul_running_s *r = NULL;
+			struct http_put_s *sibling = running->len
+				? _running_put (running->pdata[0]) : NULL;
+			err = _running_start (ul, src, done->len, next_offset, sibling, &r);
+			if (!err) {
+				next_offset += r->mc->size;
+				g_ptr_array_add (running, r);
+				g_ptr_array_add (done, NULL);
+			}
+		}
+
+		GPtrArray *puts = g_ptr_array_sized_new (running->len + 1);
+		for (guint i=0; !err && i<running->len ;i++) {
+			struct ul_running_s *r = running->pdata[i];
+			err = _running_feed (ul, src, r, &content_hashed);
+			if (r->stripe)
+				_ec_stripe_add_puts (r->stripe, puts);
+			else
+				g_ptr_array_add (puts, r->put);
+		}
+		g_ptr_array_add (puts, NULL);
+		if (!err)
+			err = http_put_step_many ((struct http_put_s **) puts->pdata);
+		g_ptr_array_free (puts, TRUE);
+		if (err)
+			break;
+
+		for (guint i=running->len; !err && i>0 ;i--) {
+			struct ul_running_s *r = running->pdata[i-1];
+			if (r->stripe ? !_ec_stripe_done (r->stripe) : !http_put_done (r->put))
+				continue;
+			g_ptr_array_remove_index (running, i-1);
+			err = r->stripe ? _ec_stripe_close (r->mc, r->stripe)
+				: _metachunk_close (ul, r->mc, r->put, r->checksum);
+			if (!err) {
+				done->pdata[r->mc->meta] = r->mc;
+				r->mc = NULL;
+			}
+			_running_free (r);
+		}
+	}
+
+	/* Keep the metachunks in the order of the content */
+	for (guint i=0; i<done->len ;i++) {
+		if (done->pdata[i])
+			ul->metachunk_done = g_list_append (ul->metachunk_done, done->pdata[i]);
+	}
+	ul->chunks_done = g_slist_concat (ul->chunks_done, ul->chunks);
+	ul->chunks = NULL;
+
+	/* The checksum of the rest of the content, in a final pass */
+	for (gsize off=content_hashed; !err && off < src->size ;) {
+		GBytes *buf = NULL;
+		gsize len = MIN(UL_PARALLEL_BUFFER, src->size - off);
+		if (!(err = _range_read (src, off, len, &buf))) {
+			g_checksum_update (ul->checksum_content,
+					g_bytes_get_data (buf, NULL), len);
+			g_bytes_unref (buf);
+			off += len;
+		}
+	}
+
+	if (!err) {
+		ul->finished = TRUE;
+		ul->ready_for_data = FALSE;
+		dst->out_size = src->size;
+		err = (GError*) oio_sds_upload_commit (ul);
+	}
+
+	g_ptr_array_free (done, TRUE);
+	g_ptr_array_set_free_func (running, (GDestroyNotify)_running_free);
+	g_ptr_array_free (running, TRUE);
+	oio_sds_upload_clean (ul);
+	return err;
+}
+
 struct oio_error_s*
 oio_sds_upload (struct oio_sds_s *sds, struct oio_sds_ul_src_s *src,
 		struct oio_sds_ul_dst_s *dst)
@@ -1601,6 +2974,16 @@ oio_sds_upload_from_file (struct oio_sds_s *sds, struct oio_sds_ul_dst_s *dst,
 		err = SYSERR("fstat() error: (%d) %s", errno, strerror(errno));
 	else if (!(in = fdopen(fd, "r")))
 		err = SYSERR("fdopen() error: (%d) %s", errno, strerror(errno));
+	else if (sds->upload_parallelism > 1 && st.st_size > 0
+			&& (off_t)off < st.st_size) {
+		if (len == 0 || len == (size_t)-1)
+			len = st.st_size - off;
+		struct ul_range_src_s src0 = {
+			.fd = fd, .base = NULL, .offset = off,
+			.size = MIN(len, (size_t)(st.st_size - off))
+		};
+		err = _upload_parallel (sds, dst, &src0);
+	}
 	else {
 		lseek (fd, off, SEEK_SET);
 		if (len == 0 || len == (size_t)-1)
@@ -1633,7 +3016,13 @@ oio_sds_upload_from_buffer (struct oio_sds_s *sds,
 	FILE *in = NULL;
 	GError *err = NULL;
 
-	if (!(in = fmemopen (base, len, "r")))
+	if (sds->upload_parallelism > 1 && len > 0) {
+		struct ul_range_src_s src0 = {
+			.fd = -1, .base = base, .offset = 0, .size = len
+		};
+		err = _upload_parallel (sds, dst, &src0);
+	}
+	else if (!(in = fmemopen (base, len, "r")))
 		err = SYSERR("fmemopen() error: (%d) %s", errno, strerror(errno));
 	else {
 		struct oio_sds_ul_src_s src0 = {
@@ -1926,13 +3315,51 @@ oio_sds_delete (struct oio_sds_s *sds, struct oio_url_s *url)
 	return (struct oio_error_s*) oio_proxy_call_content_delete (sds->h, url);
 }
 
+struct oio_error_s*
+oio_sds_delete_many (struct oio_sds_s *sds, struct oio_url_s **urls,
+		struct oio_error_s **errors)
+{
+	if (!sds || !urls || !errors)
+		return (struct oio_error_s*) BADREQ("Missing argument");
+	if (!*urls)
+		return NULL;
+
+	guint count = 0;
+	GString *request_body = g_string_new("[");
+	for (struct oio_url_s **pu=urls; *pu ;++pu, ++count) {
+		errors[count] = NULL;
+		if (!_same_container (*pu, urls[0])) {
+			g_string_free (request_body, TRUE);
+			return (struct oio_error_s*) BADREQ("Contents in several containers");
+		}
+		if (count)
+			g_string_append_c (request_body, ',');
+		g_string_append_c (request_body, '"');
+		oio_str_gstring_append_json_string (request_body,
+				oio_url_get (*pu, OIOURL_PATH));
+		g_string_append_c (request_body, '"');
+	}
+	g_string_append_c (request_body, ']');
+
+	GString *reply_body = g_string_new ("");
+	oio_ext_set_reqid (sds->session_id);
+	GError *err = oio_proxy_call_content_delete_many (sds->h, urls[0],
+			request_body, reply_body);
+	if (!err)
+		err = _batch_load_statuses (reply_body, count, errors);
+
+	g_string_free (request_body, TRUE);
+	g_string_free (reply_body, TRUE);
+	return (struct oio_error_s*) err;
+}
+
 struct oio_error_s*
 oio_sds_has (struct oio_sds_s *sds, struct oio_url_s *url, int *phas)
 {
 	if (!sds || !url || !phas)
 		return (struct oio_error_s*) BADREQ("Missing argument");
 	oio_ext_set_reqid (sds->session_id);
-	GError *err = oio_proxy_call_content_show (sds->h, url, NULL);
+	GError *err = oio_proxy_call_content_show (sds->h, url, NULL, NULL);
 	*phas = (err == NULL);
 	if (err && (CODE_IS_NOTFOUND(err->code) || err->code == CODE_NOT_FOUND))
 		g_clear_error(&err);
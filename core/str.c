@@ -21,6 +21,7 @@ License along with this library.
 #include <glib.h>
 
 #include "oiostr.h"
+#include "oiojson.h"
 #include "oiourl.h"
 #include "internals.h"
 
@@ -331,11 +332,7 @@ oio_str_lower(register gchar *s)
 void
 oio_str_gstring_append_json_string (GString *base, const char *s)
 {
-	while (*s) {
-		if (*s == '"')
-			g_string_append_c (base, '\\');
-		g_string_append_c (base, *(s++));
-	}
+	oio_json_append_escaped (base, s, strlen(s));
 }
 
 void
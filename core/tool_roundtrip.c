@@ -77,6 +77,42 @@ _checksum_file (const char *path, struct file_info_s *fi)
 	return NULL;
 }
 
+static GError *
+_check_reader (struct oio_sds_s *client, struct oio_url_s *url,
+		const char *path)
+{
+	GError *err = NULL;
+	gchar *expected = NULL;
+	gsize expected_size = 0;
+	if (!g_file_get_contents (path, &expected, &expected_size, &err))
+		return err;
+
+	struct oio_sds_reader_s *reader = NULL;
+	err = (GError*) oio_sds_reader_open (client, url, &reader);
+	if (!err && oio_sds_reader_get_size (reader) != expected_size)
+		err = NEWERROR(0, "Reader size mismatch");
+
+	guint8 *copy = g_malloc0 (expected_size + 1);
+	for (gsize total = 0, r = 1; !err && r > 0 ;total += r) {
+		err = (GError*) oio_sds_reader_read (reader, copy + total, 1000, &r);
+		if (!err && total + r > expected_size)
+			err = NEWERROR(0, "Too many bytes read");
+	}
+	if (!err && 0 != memcmp (copy, expected, expected_size))
+		err = NEWERROR(0, "Sequential read mismatch");
+
+	gsize r = 0, off = expected_size / 3, len = expected_size / 2;
+	if (!err)
+		err = (GError*) oio_sds_reader_pread (reader, copy, len, off, &r);
+	if (!err && (r != len || 0 != memcmp (copy, expected + off, len)))
+		err = NEWERROR(0, "Positioned read mismatch");
+
+	oio_sds_reader_close (reader);
+	g_free (copy);
+	g_free (expected);
+	return err;
+}
+
 static void
 _append_random_chars (gchar *d, const char *chars, guint n)
 {
@@ -158,6 +194,11 @@ _roundtrip_common (struct oio_sds_s *client, struct oio_url_s *url,
 	MAYBERETURN(err, "Download error");
 	GRID_INFO("Content downloaded to a buffer");
 
+	/* Read it by pieces, then at a given position */
+	err = (struct oio_error_s*) _check_reader (client, url, path);
+	MAYBERETURN(err, "Reader error");
+	GRID_INFO("Content read sequentially and at random positions");
+
 	/* link the container */
 	struct oio_url_s *url1 = oio_url_dup (url);
 	oio_url_set (url1, OIOURL_PATH, tmppath);
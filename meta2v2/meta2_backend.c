@@ -690,7 +690,8 @@ meta2_backend_purge_container(struct meta2_backend_s *m2, struct oio_url_s *url)
 GError*
 meta2_backend_list_aliases(struct meta2_backend_s *m2b, struct oio_url_s *url,
 		struct list_params_s *lp, GSList *headers,
-		m2_onbean_cb cb, gpointer u0, gchar ***out_properties)
+		m2_onbean_cb cb, m2_onprefix_cb prefix_cb, gpointer u0,
+		gchar ***out_properties)
 {
 	GError *err = NULL;
 	struct sqlx_sqlite3_s *sq3 = NULL;
@@ -702,7 +703,7 @@ meta2_backend_list_aliases(struct meta2_backend_s *m2b, struct oio_url_s *url,
 	err = m2b_open(m2b, url, M2V2_OPEN_MASTERSLAVE
 			|M2V2_OPEN_ENABLED|M2V2_OPEN_FROZEN, &sq3);
 	if (!err) {
-		err = m2db_list_aliases(sq3, lp, headers, cb, u0);
+		err = m2db_list_aliases(sq3, lp, headers, cb, prefix_cb, u0);
 		if (!err && out_properties)
 			*out_properties = sqlx_admin_get_keyvalues (sq3);
 		m2b_close(sq3);
@@ -871,6 +872,156 @@ meta2_backend_put_alias(struct meta2_backend_s *m2b, struct oio_url_s *url,
 	return err;
 }
 
+void
+meta2_batch_item_free(struct meta2_batch_item_s *item)
+{
+	if (!item)
+		return;
+	oio_url_pclean(&item->url);
+	_bean_cleanl2(item->beans);
+	_bean_cleanl2(item->added);
+	_bean_cleanl2(item->deleted);
+	if (item->err)
+		g_clear_error(&item->err);
+	g_free(item);
+}
+
+static GError*
+_batch_exec(struct sqlx_sqlite3_s *sq3, const char *sql)
+{
+	int rc = sqlx_exec(sq3->db, sql);
+	if (!sqlx_code_good(rc))
+		return SQLITE_GERROR(sq3->db, rc);
+	return NULL;
+}
+
+/* Runs <op> on each item in a savepoint of its own. Fails only on errors
+ * that leave the transaction unusable. */
+static GError*
+_batch_run(struct sqlx_sqlite3_s *sq3, GPtrArray *items,
+		GError* (*op) (struct meta2_batch_item_s *item, gpointer u), gpointer u)
+{
+	GError *err = NULL;
+	guint done = 0;
+
+	for (guint i=0; !err && i<items->len ;i++) {
+		struct meta2_batch_item_s *item = items->pdata[i];
+		if (item->err)
+			continue;
+		if ((err = _batch_exec(sq3, "SAVEPOINT m2batch")))
+			break;
+		if (!(item->err = op(item, u))) {
+			err = _batch_exec(sq3, "RELEASE m2batch");
+			done ++;
+		} else {
+			_bean_cleanl2(item->added);
+			_bean_cleanl2(item->deleted);
+			item->added = item->deleted = NULL;
+			if (!(err = _batch_exec(sq3, "ROLLBACK TO m2batch")))
+				err = _batch_exec(sq3, "RELEASE m2batch");
+		}
+	}
+
+	if (!err && done > 0)
+		m2db_increment_version(sq3);
+	return err;
+}
+
+static void
+_batch_forget(GPtrArray *items)
+{
+	for (guint i=0; i<items->len ;i++) {
+		struct meta2_batch_item_s *item = items->pdata[i];
+		_bean_cleanl2(item->added);
+		_bean_cleanl2(item->deleted);
+		item->added = item->deleted = NULL;
+	}
+}
+
+GError*
+meta2_backend_put_aliases(struct meta2_backend_s *m2b, struct oio_url_s *url,
+		GPtrArray *items)
+{
+	GError *err = NULL;
+	struct sqlx_sqlite3_s *sq3 = NULL;
+	struct sqlx_repctx_s *repctx = NULL;
+
+	EXTRA_ASSERT(m2b != NULL);
+	EXTRA_ASSERT(url != NULL);
+	if (!items || !items->len)
+		return NEWERROR(CODE_BAD_REQUEST, "No content");
+
+	GError *_put(struct meta2_batch_item_s *item, gpointer u) {
+		struct m2db_put_args_s *args = u;
+		if (!item->beans)
+			return NEWERROR(CODE_BAD_REQUEST, "No bean");
+		args->url = item->url;
+		return m2db_put_alias(args, item->beans, &item->deleted, &item->added);
+	}
+
+	err = m2b_open(m2b, url, M2V2_OPEN_MASTERONLY|M2V2_OPEN_ENABLED, &sq3);
+	if (!err) {
+		struct m2db_put_args_s args;
+		memset(&args, 0, sizeof(args));
+		args.sq3 = sq3;
+		args.url = url;
+		args.max_versions = _maxvers(sq3, m2b);
+		args.nsinfo = meta2_backend_get_nsinfo(m2b);
+		args.lbpool = m2b->lb;
+
+		if (!(err = _transaction_begin(sq3, url, &repctx))) {
+			err = _batch_run(sq3, items, _put, &args);
+			err = sqlx_transaction_end(repctx, err);
+			if (!err)
+				meta2_backend_add_modified_container(m2b, sq3);
+		}
+		m2b_close(sq3);
+
+		namespace_info_free(args.nsinfo);
+	}
+
+	if (err)
+		_batch_forget(items);
+	return err;
+}
+
+GError*
+meta2_backend_delete_aliases(struct meta2_backend_s *m2b,
+		struct oio_url_s *url, GPtrArray *items)
+{
+	GError *err = NULL;
+	struct sqlx_sqlite3_s *sq3 = NULL;
+	struct sqlx_repctx_s *repctx = NULL;
+	gint64 max_versions = 0;
+
+	EXTRA_ASSERT(m2b != NULL);
+	EXTRA_ASSERT(url != NULL);
+	if (!items || !items->len)
+		return NEWERROR(CODE_BAD_REQUEST, "No content");
+
+	GError *_delete(struct meta2_batch_item_s *item, gpointer u) {
+		(void) u;
+		return m2db_delete_alias(sq3, max_versions, item->url,
+				_bean_list_cb, &item->deleted);
+	}
+
+	err = m2b_open(m2b, url, M2V2_OPEN_MASTERONLY|M2V2_OPEN_ENABLED, &sq3);
+	if (!err) {
+		max_versions = _maxvers(sq3, m2b);
+		if (!(err = _transaction_begin(sq3, url, &repctx))) {
+			err = _batch_run(sq3, items, _delete, NULL);
+			err = sqlx_transaction_end(repctx, err);
+		}
+		if (!err)
+			meta2_backend_add_modified_container(m2b, sq3);
+		m2b_close(sq3);
+	}
+
+	if (err)
+		_batch_forget(items);
+	return err;
+}
+
 GError*
 meta2_backend_copy_alias(struct meta2_backend_s *m2b, struct oio_url_s *url,
 		const char *src)
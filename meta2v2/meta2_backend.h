@@ -88,7 +88,8 @@ GError* meta2_backend_dedup_contents(struct meta2_backend_s *m2b,
 
 GError* meta2_backend_list_aliases(struct meta2_backend_s *m2b, struct oio_url_s *url,
 		struct list_params_s *lp, GSList *headers,
-		m2_onbean_cb cb, gpointer u0, gchar ***out_properties);
+		m2_onbean_cb cb, m2_onprefix_cb prefix_cb, gpointer u0,
+		gchar ***out_properties);
 
 /**
  * @param flags 0 or a combination (ORed) of M2V2_FLAG_ALLVERSION
@@ -144,6 +145,33 @@ GError* meta2_backend_link_content (struct meta2_backend_s *m2b,
 GError* meta2_backend_delete_alias(struct meta2_backend_s *m2b,
 		struct oio_url_s *url, m2_onbean_cb cb, gpointer u0);
 
+/* Batches ----------------------------------------------------------------- */
+
+/* One content of a batch: its own URL (with the path, and the content ID
+ * for a put), its beans for a put, then the outcome of its operation. */
+struct meta2_batch_item_s
+{
+	struct oio_url_s *url;
+	GSList *beans;
+	GError *err;
+	GSList *added;
+	GSList *deleted;
+};
+
+void meta2_batch_item_free(struct meta2_batch_item_s *item);
+
+/* Put the contents of <items> (of meta2_batch_item_s) in the container of
+ * <url>, in one replicated transaction. Each item runs in its own savepoint,
+ * so that a failed item is rolled back alone and the others are kept. The
+ * error returned concerns the whole batch, then no item has been saved. */
+GError* meta2_backend_put_aliases(struct meta2_backend_s *m2b,
+		struct oio_url_s *url, GPtrArray *items);
+
+/* Same as meta2_backend_put_aliases(), the deleted beans of each item are
+ * collected in its <deleted> field. */
+GError* meta2_backend_delete_aliases(struct meta2_backend_s *m2b,
+		struct oio_url_s *url, GPtrArray *items);
+
 /* Properties -------------------------------------------------------------- */
 
 GError* meta2_backend_get_properties(struct meta2_backend_s *m2b,
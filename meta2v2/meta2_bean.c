@@ -18,6 +18,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <errno.h>
+#include <string.h>
+
+#include <metautils/lib/metautils.h>
 
 #include <meta2v2/meta2_bean.h>
 #include <meta2v2/autogen.h>
@@ -127,11 +130,50 @@ _generate_api_prop(const M2V2Bean_t * asn)
 	return result;
 }
 
+/* The ASN.1 forms of the beans only live for the time of their encoding:
+ * their nodes come from an arena, and their strings are borrowed from the
+ * beans. */
+
+static void
+_os_borrow(OCTET_STRING_t *os, const void *b, gsize l)
+{
+	os->buf = (uint8_t*) b;
+	os->size = l;
+}
+
+static OCTET_STRING_t *
+_os_borrow_new(struct oio_arena_s *arena, const void *b, gsize l)
+{
+	OCTET_STRING_t *os = oio_arena_alloc0(arena, sizeof(OCTET_STRING_t));
+	_os_borrow(os, b, l);
+	return os;
+}
+
+/* Minimal big-endian two's complement, as DER wants it */
+static void
+_int64_to_INTEGER(struct oio_arena_s *arena, INTEGER_t *i, gint64 v)
+{
+	guint8 tmp[sizeof(gint64)];
+	for (guint k = 0; k < sizeof(tmp) ;++k)
+		tmp[sizeof(tmp) - 1 - k] = ((guint64)v >> (8 * k)) & 0xFF;
+
+	guint skip = 0;
+	while (skip < sizeof(tmp) - 1
+			&& ((tmp[skip] == 0x00 && !(tmp[skip+1] & 0x80))
+				|| (tmp[skip] == 0xFF && (tmp[skip+1] & 0x80))))
+		++ skip;
+
+	const gsize len = sizeof(tmp) - skip;
+	i->buf = oio_arena_alloc(arena, len);
+	memcpy(i->buf, tmp + skip, len);
+	i->size = len;
+}
+
 static gboolean
-_header_to_asn(gpointer api, M2V2Bean_t *asn)
+_header_to_asn(gpointer api, M2V2Bean_t *asn, struct oio_arena_s *arena)
 {
 	struct bean_CONTENTS_HEADERS_s *header = (struct bean_CONTENTS_HEADERS_s*) api;
-	asn->header = calloc(1, sizeof(M2V2ContentHeader_t));
+	asn->header = oio_arena_alloc0(arena, sizeof(M2V2ContentHeader_t));
 
 	GByteArray *id = CONTENTS_HEADERS_get_id(header);
 	GByteArray *hash = CONTENTS_HEADERS_get_hash(header);
@@ -139,86 +181,84 @@ _header_to_asn(gpointer api, M2V2Bean_t *asn)
 	GString *type = CONTENTS_HEADERS_get_mime_type(header);
 	GString *method = CONTENTS_HEADERS_get_chunk_method(header);
 
-	OCTET_STRING_fromBuf(&(asn->header->id), (const char *)id->data, id->len);
+	_os_borrow(&(asn->header->id), id->data, id->len);
 
 	if (NULL != hash)
-		asn->header->hash = OCTET_STRING_new_fromBuf(&asn_DEF_OCTET_STRING,
-				(const char *)hash->data, hash->len);
+		asn->header->hash = _os_borrow_new(arena, hash->data, hash->len);
 
-	asn_int64_to_INTEGER(&(asn->header->size), CONTENTS_HEADERS_get_size(header));
-	asn_int64_to_INTEGER(&(asn->header->ctime), CONTENTS_HEADERS_get_ctime(header));
-	asn_int64_to_INTEGER(&(asn->header->mtime), CONTENTS_HEADERS_get_mtime(header));
+	_int64_to_INTEGER(arena, &(asn->header->size), CONTENTS_HEADERS_get_size(header));
+	_int64_to_INTEGER(arena, &(asn->header->ctime), CONTENTS_HEADERS_get_ctime(header));
+	_int64_to_INTEGER(arena, &(asn->header->mtime), CONTENTS_HEADERS_get_mtime(header));
 
-	OCTET_STRING_fromBuf(&(asn->header->chunkMethod), method->str, method->len);
-	OCTET_STRING_fromBuf(&(asn->header->mimeType), type->str, type->len);
+	_os_borrow(&(asn->header->chunkMethod), method->str, method->len);
+	_os_borrow(&(asn->header->mimeType), type->str, type->len);
 
 	if(NULL != pol)
-		asn->header->policy = OCTET_STRING_new_fromBuf(&asn_DEF_OCTET_STRING,
-				(const char *)pol->str, pol->len);
+		asn->header->policy = _os_borrow_new(arena, pol->str, pol->len);
 
 	return TRUE;
 }
 
 static gboolean
-_chunk_to_asn(gpointer api, M2V2Bean_t *asn)
+_chunk_to_asn(gpointer api, M2V2Bean_t *asn, struct oio_arena_s *arena)
 {
 	struct bean_CHUNKS_s *chunk = (struct bean_CHUNKS_s *) api;
-	asn->chunk = calloc(1, sizeof(M2V2Chunk_t));
+	asn->chunk = oio_arena_alloc0(arena, sizeof(M2V2Chunk_t));
 
 	GByteArray *hash = CHUNKS_get_hash(chunk);
 	GString *chunk_id = CHUNKS_get_id(chunk);
 	GByteArray *content = CHUNKS_get_content(chunk);
 	GString *position = CHUNKS_get_position(chunk);
 
-	OCTET_STRING_fromBuf(&(asn->chunk->hash), (const char *)hash->data, hash->len);
-	OCTET_STRING_fromBuf(&(asn->chunk->id), chunk_id->str, chunk_id->len);
-	OCTET_STRING_fromBuf(&(asn->chunk->position), position->str, position->len); 
-	OCTET_STRING_fromBuf(&(asn->chunk->content), (const char *)content->data, content->len);
-	asn_int64_to_INTEGER(&(asn->chunk->size), CHUNKS_get_size(chunk));
-	asn_int64_to_INTEGER(&(asn->chunk->ctime), CHUNKS_get_ctime(chunk));
+	_os_borrow(&(asn->chunk->hash), hash->data, hash->len);
+	_os_borrow(&(asn->chunk->id), chunk_id->str, chunk_id->len);
+	_os_borrow(&(asn->chunk->position), position->str, position->len);
+	_os_borrow(&(asn->chunk->content), content->data, content->len);
+	_int64_to_INTEGER(arena, &(asn->chunk->size), CHUNKS_get_size(chunk));
+	_int64_to_INTEGER(arena, &(asn->chunk->ctime), CHUNKS_get_ctime(chunk));
 
 	return TRUE;
 }
 
 static gboolean
-_property_to_asn(gpointer api, M2V2Bean_t *asn)
+_property_to_asn(gpointer api, M2V2Bean_t *asn, struct oio_arena_s *arena)
 {
 	struct bean_PROPERTIES_s *prop = (struct bean_PROPERTIES_s *) api;
-	asn->prop = calloc(1, sizeof(M2V2Property_t));
+	asn->prop = oio_arena_alloc0(arena, sizeof(M2V2Property_t));
 
 	GString *alias_name = PROPERTIES_get_alias(prop);
-	OCTET_STRING_fromBuf(&(asn->prop->alias), alias_name->str, alias_name->len);
+	_os_borrow(&(asn->prop->alias), alias_name->str, alias_name->len);
 
-	asn_int64_to_INTEGER(&(asn->prop->version), PROPERTIES_get_version(prop));
+	_int64_to_INTEGER(arena, &(asn->prop->version), PROPERTIES_get_version(prop));
 
 	GString *key = PROPERTIES_get_key(prop);
-	OCTET_STRING_fromBuf(&(asn->prop->key), key->str, key->len);
+	_os_borrow(&(asn->prop->key), key->str, key->len);
 
 	GByteArray *val = PROPERTIES_get_value(prop);
-	OCTET_STRING_fromBuf(&(asn->prop->value), (const char *)val->data, val->len);
+	_os_borrow(&(asn->prop->value), val->data, val->len);
 
 	return TRUE;
 }
 
 static gboolean
-_alias_to_asn(gpointer api, M2V2Bean_t *asn)
+_alias_to_asn(gpointer api, M2V2Bean_t *asn, struct oio_arena_s *arena)
 {
 	struct bean_ALIASES_s *alias = (struct bean_ALIASES_s *) api;
-	asn->alias = calloc(1, sizeof(M2V2Alias_t));
+	asn->alias = oio_arena_alloc0(arena, sizeof(M2V2Alias_t));
 
 	GString *name = ALIASES_get_alias(alias);
-	OCTET_STRING_fromBuf(&(asn->alias->name), name->str, name->len);
+	_os_borrow(&(asn->alias->name), name->str, name->len);
 
-	asn_int64_to_INTEGER(&(asn->alias->version), ALIASES_get_version(alias));
+	_int64_to_INTEGER(arena, &(asn->alias->version), ALIASES_get_version(alias));
 
 	GByteArray *id = ALIASES_get_content(alias);
-	OCTET_STRING_fromBuf(&(asn->alias->content), (const char *)id->data, id->len);
+	_os_borrow(&(asn->alias->content), id->data, id->len);
 
 	asn->alias->deleted = ALIASES_get_deleted(alias);
 
-	asn_int64_to_INTEGER(&(asn->alias->ctime), ALIASES_get_ctime(alias));
+	_int64_to_INTEGER(arena, &(asn->alias->ctime), ALIASES_get_ctime(alias));
 
-	asn_int64_to_INTEGER(&(asn->alias->mtime), ALIASES_get_mtime(alias));
+	_int64_to_INTEGER(arena, &(asn->alias->mtime), ALIASES_get_mtime(alias));
 
 	return TRUE;
 }
@@ -242,20 +282,20 @@ bean_ASN2API(const M2V2Bean_t * asn)
 }
 
 gboolean
-bean_API2ASN(gpointer * api, M2V2Bean_t * asn)
+bean_API2ASN(gpointer * api, M2V2Bean_t * asn, struct oio_arena_s *arena)
 {
 	/* find bean type and fill matching item in M2V2Bean */
-	if (!api || !asn)
+	if (!api || !asn || !arena)
 		return FALSE;
 
 	if (DESCR(api) == &descr_struct_ALIASES)
-		return _alias_to_asn(api, asn);
+		return _alias_to_asn(api, asn, arena);
 	if (DESCR(api) == &descr_struct_CONTENTS_HEADERS)
-		return _header_to_asn(api, asn);
+		return _header_to_asn(api, asn, arena);
 	if (DESCR(api) == &descr_struct_CHUNKS)
-		return _chunk_to_asn(api, asn);
+		return _chunk_to_asn(api, asn, arena);
 	if (DESCR(api) == &descr_struct_PROPERTIES)
-		return _property_to_asn(api, asn);
+		return _property_to_asn(api, asn, arena);
 	return FALSE;
 }
 
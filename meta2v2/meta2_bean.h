@@ -28,12 +28,18 @@ struct M2V2Alias;
 struct M2V2Content;
 struct M2V2ContentHeader;
 
+struct oio_arena_s;
+
 /**
  *
  */
 gpointer bean_ASN2API(const struct M2V2Bean *asn);
 
-gboolean bean_API2ASN(gpointer * api, struct M2V2Bean * asn);
+/* Fills <asn> with nodes allocated in <arena> and strings borrowed from
+ * <api>: it is only valid as long as both, and must not be cleaned with
+ * bean_cleanASN(). */
+gboolean bean_API2ASN(gpointer * api, struct M2V2Bean * asn,
+		struct oio_arena_s *arena);
 
 void bean_cleanASN(struct M2V2Bean * asn, gboolean only_content);
 
@@ -42,11 +42,13 @@ static void bean_gclean(gpointer bean, gpointer ignored)
 	_bean_clean(bean);
 }
 
+/* Per bean, a bit more than the ASN.1 nodes of the biggest one */
+#define BEANS_ARENA_UNIT 512
+#define BEANS_ARENA_MAX (256 * 1024)
+
 GByteArray *
 bean_sequence_marshall(GSList *beans)
 {
-	gboolean error_occured = FALSE;
-	gsize probable_size;
 	asn_enc_rval_t encRet;
 	struct anonymous_sequence_s asnSeq;
 	GByteArray *gba = NULL;
@@ -57,66 +59,40 @@ bean_sequence_marshall(GSList *beans)
 		return g_byte_array_append(gba, (guint8 *) b, bSize) ? 0 : -1;
 	}
 
-	void func_free(void *d)
-	{
-		if (!d)
-			return;
-		bean_cleanASN(d, FALSE);
-	}
-
-	void func_fill(gpointer d, gpointer u)
-	{
-		asn_anonymous_set_ *p_set;
-		M2V2Bean_t *asn1;
+	const guint count = g_slist_length(beans);
+	GRID_TRACE("Serializing a list of %u elements", count);
 
-		if (error_occured || !d)
-			return;
-		asn1 = g_malloc0(sizeof(M2V2Bean_t));
-		if (!bean_API2ASN(d, asn1)) {
-			g_free(asn1);
+	/* fills the ASN.1 structure, all its nodes come from the arena */
+	struct oio_arena_s *arena = oio_arena_create(
+			MIN(count * BEANS_ARENA_UNIT, BEANS_ARENA_MAX));
+	memset(&asnSeq, 0x00, sizeof(asnSeq));
+	asnSeq.list.array = oio_arena_alloc(arena, MAX(count, 1) * sizeof(void*));
+	asnSeq.list.size = count;
+	for (GSList *l = beans; l ;l = l->next) {
+		if (!l->data)
+			continue;
+		M2V2Bean_t *asn1 = oio_arena_alloc0(arena, sizeof(M2V2Bean_t));
+		if (!bean_API2ASN(l->data, asn1, arena)) {
 			GRID_ERROR("Element of type [M2V2Bean] serialization failed!");
-			error_occured = TRUE;
-		} else {
-			p_set = &(((struct anonymous_sequence_s *) u)->list);
-			asn_set_add(_A_SET_FROM_VOID(p_set), asn1);
+			oio_arena_destroy(arena);
+			return NULL;
 		}
+		asnSeq.list.array[asnSeq.list.count ++] = asn1;
 	}
 
-	GRID_TRACE("Serializing a list of %d elements", g_slist_length(beans));
-
-	probable_size = g_slist_length(beans) * (sizeof(M2V2Bean_t) + 6) + 64;
-	probable_size = MIN(probable_size, 4096);
-
-	gba = g_byte_array_sized_new(probable_size);
-	if (!gba) {
-		GRID_ERROR("Memory allocation failure");
-		return NULL;
-	}
-
-	/*fills the ASN.1 structure */
-	memset(&asnSeq, 0x00, sizeof(asnSeq));
-	g_slist_foreach(beans, &func_fill, &asnSeq);
-	if (error_occured) {
-		g_byte_array_free(gba, TRUE);
-		GRID_ERROR("list serialisation error");
-		return NULL;
-	}
+	gsize probable_size = count * (sizeof(M2V2Bean_t) + 6) + 64;
+	gba = g_byte_array_sized_new(MIN(probable_size, 4096));
 
 	/*serializes the structure */
 	encRet = der_encode(&asn_DEF_M2V2BeanSequence, &asnSeq, func_write, NULL);
+	oio_arena_destroy(arena);
 	if (encRet.encoded == -1) {
 		GRID_ERROR("Cannot encode the ASN.1 sequence (error on %s)", encRet.failed_type->name);
 		g_byte_array_free(gba, TRUE);
-		asnSeq.list.free = &func_free;
-		asn_set_empty(&(asnSeq.list));
 		return NULL;
 	}
 
 	GRID_TRACE("marshalling done (%p size=%i/%u)", gba->data, gba->len, gba->len);
-
-	/*free the ASN.1 structure and the working buffer */
-	asnSeq.list.free = &func_free;
-	asn_set_empty(&asnSeq);
 	return gba;
 }
 
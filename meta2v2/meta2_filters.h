@@ -90,6 +90,8 @@ M2V2_DECLARE_FILTER(meta2_filter_action_put_content);
 M2V2_DECLARE_FILTER(meta2_filter_action_append_content);
 M2V2_DECLARE_FILTER(meta2_filter_action_get_content);
 M2V2_DECLARE_FILTER(meta2_filter_action_delete_content);
+M2V2_DECLARE_FILTER(meta2_filter_action_put_contents);
+M2V2_DECLARE_FILTER(meta2_filter_action_delete_contents);
 M2V2_DECLARE_FILTER(meta2_filter_action_link);
 M2V2_DECLARE_FILTER(meta2_filter_action_set_content_properties);
 M2V2_DECLARE_FILTER(meta2_filter_action_get_content_properties);
@@ -212,9 +212,10 @@ _list_S3(struct gridd_filter_ctx_s *ctx, struct gridd_reply_ctx_s *reply,
 	if (lp->maxkeys <= 0)
 		lp->maxkeys = OIO_M2V2_LISTRESULT_BATCH;
 
-	GRID_DEBUG("LP H:%d A:%d D:%d prefix:%s marker:%s end:%s max:%"G_GINT64_FORMAT,
+	GRID_DEBUG("LP H:%d A:%d D:%d prefix:%s delim:%c marker:%s end:%s max:%"G_GINT64_FORMAT,
 			lp->flag_headers, lp->flag_allversion, lp->flag_nodeleted,
-			lp->prefix, lp->marker_start, lp->marker_end, lp->maxkeys);
+			lp->prefix, lp->delimiter ? lp->delimiter : ' ',
+			lp->marker_start, lp->marker_end, lp->maxkeys);
 
 	// XXX the underlying meta2_backend_list_aliases() function MUST
 	// return headers before the associated alias.
@@ -235,16 +236,28 @@ _list_S3(struct gridd_filter_ctx_s *ctx, struct gridd_reply_ctx_s *reply,
 			_bean_clean(bean);
 		}
 	}
+	GPtrArray *prefixes = g_ptr_array_new_with_free_func(g_free);
+	void s3_prefix_cb(gpointer ignored, const gchar *prefix) {
+		(void) ignored;
+		if (max > 0) {
+			g_ptr_array_add(prefixes, g_strdup(prefix));
+			if (0 == --max)
+				next_marker = g_strdup(prefix);
+		} else {
+			truncated = TRUE;
+		}
+	}
 
 	lp->maxkeys ++;
-	e = meta2_backend_list_aliases(m2b, url, lp, headers, s3_list_cb, NULL,
-			&properties);
+	e = meta2_backend_list_aliases(m2b, url, lp, headers, s3_list_cb,
+			s3_prefix_cb, NULL, &properties);
 
 	if (NULL != e) {
 		GRID_DEBUG("Fail to return alias for url: %s", oio_url_get(url, OIOURL_WHOLE));
 		_on_bean_ctx_clean(obc);
 		meta2_filter_ctx_set_error(ctx, e);
 		if (properties) g_strfreev (properties);
+		g_ptr_array_free(prefixes, TRUE);
 		return FILTER_KO;
 	}
 
@@ -269,10 +282,17 @@ _list_S3(struct gridd_filter_ctx_s *ctx, struct gridd_reply_ctx_s *reply,
 		}
 	}
 
+	for (guint i = 0; i < prefixes->len ;++i) {
+		gchar *k = g_strconcat (NAME_MSGKEY_PREFIX_COMMON, prefixes->pdata[i], NULL);
+		reply->add_header(k, metautils_gba_from_string(prefixes->pdata[i]));
+		g_free (k);
+	}
+
 	_on_bean_ctx_send_list(obc);
 	_on_bean_ctx_clean(obc);
 	g_free0(next_marker);
 	if (properties) g_strfreev (properties);
+	g_ptr_array_free(prefixes, TRUE);
 	return FILTER_OK;
 }
 
@@ -292,6 +312,9 @@ _load_list_params (struct list_params_s *lp, struct gridd_filter_ctx_s *ctx)
 	lp->prefix = meta2_filter_ctx_get_param(ctx, NAME_MSGKEY_PREFIX);
 	lp->marker_start = meta2_filter_ctx_get_param(ctx, NAME_MSGKEY_MARKER);
 	lp->marker_end = meta2_filter_ctx_get_param(ctx, NAME_MSGKEY_MARKER_END);
+	const char *delimiter = meta2_filter_ctx_get_param(ctx, NAME_MSGKEY_DELIMITER);
+	if (NULL != delimiter)
+		lp->delimiter = *delimiter;
 	const char *maxkeys_str = meta2_filter_ctx_get_param(ctx, NAME_MSGKEY_MAX_KEYS);
 	if (NULL != maxkeys_str)
 		lp->maxkeys = g_ascii_strtoll(maxkeys_str, NULL, 10);
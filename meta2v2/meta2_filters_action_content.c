@@ -306,6 +306,179 @@ meta2_filter_action_delete_content(struct gridd_filter_ctx_s *ctx,
 	return FILTER_OK;
 }
 
+/* Batches ----------------------------------------------------------------- */
+
+/* Split the beans of a batch into contents: one per alias, with the header,
+ * the chunks and the properties that refer to it. The content IDs must be
+ * set and unique in the batch, as the paths. */
+static GError *
+_batch_split(struct oio_url_s *url, GSList *beans, GPtrArray *items)
+{
+	GError *err = NULL;
+	GHashTable *by_id = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	GHashTable *by_path = g_hash_table_new(g_str_hash, g_str_equal);
+
+	gchar *_hex(GByteArray *gba) {
+		if (!gba || !gba->len)
+			return NULL;
+		gchar *hex = g_malloc0(gba->len * 2 + 1);
+		oio_str_bin2hex(gba->data, gba->len, hex, gba->len * 2 + 1);
+		return hex;
+	}
+
+	for (GSList *l=beans; !err && l ;l=l->next) {
+		if (DESCR(l->data) != &descr_struct_ALIASES)
+			continue;
+		struct bean_ALIASES_s *alias = l->data;
+		const gchar *path = ALIASES_get_alias(alias)->str;
+		if (g_hash_table_lookup(by_path, path)) {
+			err = BADREQ("Duplicated path [%s]", path);
+			break;
+		}
+
+		struct meta2_batch_item_s *item = g_malloc0(sizeof(*item));
+		item->url = oio_url_dup(url);
+		oio_url_set(item->url, OIOURL_PATH, path);
+		if (ALIASES_get_version(alias) > 0) {
+			gchar v[24];
+			g_snprintf(v, sizeof(v), "%"G_GINT64_FORMAT, ALIASES_get_version(alias));
+			oio_url_set(item->url, OIOURL_VERSION, v);
+		}
+		g_ptr_array_add(items, item);
+		g_hash_table_insert(by_path, (gpointer)oio_url_get(item->url, OIOURL_PATH), item);
+
+		gchar *id = _hex(ALIASES_get_content(alias));
+		if (id) {
+			if (g_hash_table_lookup(by_id, id)) {
+				err = BADREQ("Duplicated content ID [%s]", id);
+				g_free(id);
+				break;
+			}
+			g_hash_table_insert(by_id, id, item);
+		}
+	}
+
+	for (GSList *l=beans; !err && l ;l=l->next) {
+		struct meta2_batch_item_s *item = NULL;
+		gchar *id = NULL;
+		if (DESCR(l->data) == &descr_struct_ALIASES)
+			item = g_hash_table_lookup(by_path, ALIASES_get_alias(l->data)->str);
+		else if (DESCR(l->data) == &descr_struct_PROPERTIES)
+			item = g_hash_table_lookup(by_path, PROPERTIES_get_alias(l->data)->str);
+		else if (DESCR(l->data) == &descr_struct_CONTENTS_HEADERS)
+			item = g_hash_table_lookup(by_id, (id = _hex(CONTENTS_HEADERS_get_id(l->data))));
+		else if (DESCR(l->data) == &descr_struct_CHUNKS)
+			item = g_hash_table_lookup(by_id, (id = _hex(CHUNKS_get_content(l->data))));
+		g_free(id);
+		if (!item)
+			err = BADREQ("Bean with no content in the batch");
+		else
+			item->beans = g_slist_prepend(item->beans, _bean_dup(l->data));
+	}
+
+	/* The content ID is given by the client, it is not generated */
+	for (guint i=0; !err && i<items->len ;i++) {
+		struct meta2_batch_item_s *item = items->pdata[i];
+		for (GSList *l=item->beans; l ;l=l->next) {
+			if (DESCR(l->data) != &descr_struct_ALIASES)
+				continue;
+			gchar *id = _hex(ALIASES_get_content(l->data));
+			if (id)
+				oio_url_set(item->url, OIOURL_CONTENTID, id);
+			g_free(id);
+		}
+	}
+
+	g_hash_table_destroy(by_path);
+	g_hash_table_destroy(by_id);
+	if (!err && !items->len)
+		err = BADREQ("No content");
+	return err;
+}
+
+static void
+_batch_reply(struct gridd_reply_ctx_s *reply, GPtrArray *items)
+{
+	for (guint i=0; i<items->len ;i++) {
+		struct meta2_batch_item_s *item = items->pdata[i];
+		gchar *k = g_strconcat(NAME_MSGKEY_PREFIX_STATUS,
+				oio_url_get(item->url, OIOURL_PATH), NULL);
+		gchar *v = item->err
+			? g_strdup_printf("%d %s", item->err->code, item->err->message)
+			: g_strdup_printf("%d OK", CODE_FINAL_OK);
+		reply->add_header(k, metautils_gba_from_string(v));
+		g_free(v);
+		g_free(k);
+	}
+	reply->send_reply(CODE_FINAL_OK, "OK");
+}
+
+int
+meta2_filter_action_put_contents(struct gridd_filter_ctx_s *ctx,
+		struct gridd_reply_ctx_s *reply)
+{
+	TRACE_FILTER();
+	struct meta2_backend_s *m2b = meta2_filter_ctx_get_backend(ctx);
+	struct oio_url_s *url = meta2_filter_ctx_get_url(ctx);
+	GSList *beans = meta2_filter_ctx_get_input_udata(ctx);
+	GPtrArray *items = g_ptr_array_new_with_free_func(
+			(GDestroyNotify)meta2_batch_item_free);
+
+	GError *e = _batch_split(url, beans, items);
+	if (!e)
+		e = meta2_backend_put_aliases(m2b, url, items);
+	if (e) {
+		GRID_DEBUG("Fail to put %u aliases in [%s]", items->len,
+				oio_url_get(url, OIOURL_WHOLE));
+		meta2_filter_ctx_set_error(ctx, e);
+		g_ptr_array_free(items, TRUE);
+		return FILTER_KO;
+	}
+
+	for (guint i=0; i<items->len ;i++) {
+		struct meta2_batch_item_s *item = items->pdata[i];
+		if (item->added)
+			_notify_beans(m2b, item->url, item->added, "content.new");
+		if (item->deleted)
+			_notify_beans(m2b, item->url, item->deleted, "content.deleted");
+	}
+	_batch_reply(reply, items);
+	g_ptr_array_free(items, TRUE);
+	return FILTER_OK;
+}
+
+int
+meta2_filter_action_delete_contents(struct gridd_filter_ctx_s *ctx,
+		struct gridd_reply_ctx_s *reply)
+{
+	TRACE_FILTER();
+	struct meta2_backend_s *m2b = meta2_filter_ctx_get_backend(ctx);
+	struct oio_url_s *url = meta2_filter_ctx_get_url(ctx);
+	GSList *beans = meta2_filter_ctx_get_input_udata(ctx);
+	GPtrArray *items = g_ptr_array_new_with_free_func(
+			(GDestroyNotify)meta2_batch_item_free);
+
+	GError *e = _batch_split(url, beans, items);
+	if (!e)
+		e = meta2_backend_delete_aliases(m2b, url, items);
+	if (e) {
+		GRID_DEBUG("Fail to delete %u aliases in [%s]", items->len,
+				oio_url_get(url, OIOURL_WHOLE));
+		meta2_filter_ctx_set_error(ctx, e);
+		g_ptr_array_free(items, TRUE);
+		return FILTER_KO;
+	}
+
+	for (guint i=0; i<items->len ;i++) {
+		struct meta2_batch_item_s *item = items->pdata[i];
+		if (item->deleted)
+			_notify_beans(m2b, item->url, item->deleted, "content.deleted");
+	}
+	_batch_reply(reply, items);
+	g_ptr_array_free(items, TRUE);
+	return FILTER_OK;
+}
+
 int
 meta2_filter_action_set_content_properties(struct gridd_filter_ctx_s *ctx,
 		struct gridd_reply_ctx_s *reply)
@@ -292,6 +292,7 @@ meta2_filter_extract_list_params(struct gridd_filter_ctx_s *ctx,
 	EXTRACT_OPT(NAME_MSGKEY_MARKER);
 	EXTRACT_OPT(NAME_MSGKEY_MARKER_END);
 	EXTRACT_OPT(NAME_MSGKEY_MAX_KEYS);
+	EXTRACT_OPT(NAME_MSGKEY_DELIMITER);
 	return FILTER_OK;
 }
 
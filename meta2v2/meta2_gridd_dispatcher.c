@@ -315,6 +315,35 @@ static gridd_filter M2V2_DELETE_FILTERS[] =
 	NULL
 };
 
+static gridd_filter M2V2_PUT_MANY_FILTERS[] =
+{
+	meta2_filter_extract_header_url,
+	meta2_filter_extract_header_localflag,
+	meta2_filter_fill_subject,
+	meta2_filter_check_url_cid,
+	meta2_filter_check_backend,
+	meta2_filter_check_ns_name,
+	meta2_filter_check_ns_is_master,
+	meta2_filter_extract_body_beans,
+	meta2_filter_action_put_contents,
+	NULL
+};
+
+static gridd_filter M2V2_DEL_MANY_FILTERS[] =
+{
+	meta2_filter_extract_header_url,
+	meta2_filter_extract_header_localflag,
+	meta2_filter_fill_subject,
+	meta2_filter_check_url_cid,
+	meta2_filter_check_backend,
+	meta2_filter_check_ns_name,
+	meta2_filter_check_ns_is_master,
+	meta2_filter_check_ns_not_wormed,
+	meta2_filter_extract_body_beans,
+	meta2_filter_action_delete_contents,
+	NULL
+};
+
 static gridd_filter M2V2_PROPSET_FILTERS[] =
 {
 	meta2_filter_extract_header_url,
@@ -458,6 +487,8 @@ meta2_gridd_get_v2_requests(void)
 		{NAME_MSGNAME_M2V2_LINK,    (hook) meta2_dispatch_all, M2V2_LINK_FILTERS},
 		{NAME_MSGNAME_M2V2_APPEND,  (hook) meta2_dispatch_all, M2V2_APPEND_FILTERS},
 		{NAME_MSGNAME_M2V2_DEL,     (hook) meta2_dispatch_all, M2V2_DELETE_FILTERS},
+		{NAME_MSGNAME_M2V2_PUT_MANY, (hook) meta2_dispatch_all, M2V2_PUT_MANY_FILTERS},
+		{NAME_MSGNAME_M2V2_DEL_MANY, (hook) meta2_dispatch_all, M2V2_DEL_MANY_FILTERS},
 
 		{NAME_MSGNAME_M2V2_LIST,    (hook) meta2_dispatch_all, M2V2_LIST_FILTERS},
 		{NAME_MSGNAME_M2V2_LCHUNK,  (hook) meta2_dispatch_all, M2V2_LCHUNK_FILTERS},
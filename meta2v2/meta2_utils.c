@@ -476,16 +476,66 @@ m2db_get_versioned_alias(struct sqlx_sqlite3_s *sq3, struct oio_url_s *url,
 
 /* LIST --------------------------------------------------------------------- */
 
+/* Where the next page of a listing starts. <seek> is an inclusive lower
+ * bound on the name (the first name beyond a common prefix), otherwise the
+ * page starts right after the (<alias>,<version>) row. */
+struct list_cursor_s
+{
+	gchar *seek;
+	gchar *alias;
+	gint64 version;
+};
+
+/* The smallest string greater than all the strings starting with <s>, or
+ * NULL. Only ASCII bytes are incremented so that the result remains valid
+ * UTF-8, thus the result may be looser than strictly necessary. */
+static gchar *
+_str_successor(const char *s)
+{
+	gchar *out = g_strdup(s);
+	for (gsize i = strlen(out); i > 0 ;--i) {
+		if ((guint8)out[i-1] < 0x7F) {
+			out[i-1] ++;
+			out[i] = '\0';
+			return out;
+		}
+	}
+	g_free(out);
+	return NULL;
+}
+
+/* The first name beyond all the names under the common prefix <cp>, that
+ * ends with <delimiter>, or NULL. The delimiter itself must be incremented:
+ * for a delimiter >= 0x7F, _str_successor() would increment an earlier byte
+ * and jump over names that are not under <cp>. */
+static gchar *
+_prefix_successor(const char *cp, gchar delimiter)
+{
+	if ((guint8)delimiter >= 0x7F)
+		return NULL;
+	return _str_successor(cp);
+}
+
 static GVariant **
-_list_params_to_sql_clause(struct list_params_s *lp, GString *clause,
-		GSList *headers)
+_list_params_to_sql_clause(struct list_params_s *lp,
+		struct list_cursor_s *cursor, GString *clause, GSList *headers)
 {
 	void lazy_and () {
 		if (clause->len > 0) g_string_append(clause, " AND");
 	}
 	GPtrArray *params = g_ptr_array_new ();
 
-	if (lp->marker_start) {
+	if (cursor && cursor->seek) {
+		lazy_and();
+		g_string_append (clause, " alias >= ?");
+		g_ptr_array_add (params, g_variant_new_string (cursor->seek));
+	} else if (cursor && cursor->alias) {
+		lazy_and();
+		g_string_append (clause, " (alias > ? OR (alias = ? AND version > ?))");
+		g_ptr_array_add (params, g_variant_new_string (cursor->alias));
+		g_ptr_array_add (params, g_variant_new_string (cursor->alias));
+		g_ptr_array_add (params, g_variant_new_int64 (cursor->version));
+	} else if (lp->marker_start) {
 		lazy_and();
 		g_string_append (clause, " alias > ?");
 		g_ptr_array_add (params, g_variant_new_string (lp->marker_start));
@@ -501,6 +551,15 @@ _list_params_to_sql_clause(struct list_params_s *lp, GString *clause,
 		g_ptr_array_add (params, g_variant_new_string (lp->marker_end));
 	}
 
+	/* Keep the scan of the index within the prefix */
+	gchar *prefix_end = lp->prefix ? _str_successor (lp->prefix) : NULL;
+	if (prefix_end) {
+		lazy_and();
+		g_string_append (clause, " alias < ?");
+		g_ptr_array_add (params, g_variant_new_string (prefix_end));
+		g_free (prefix_end);
+	}
+
 	if (headers) {
 		lazy_and();
 		if (headers->next) {
@@ -523,7 +582,8 @@ _list_params_to_sql_clause(struct list_params_s *lp, GString *clause,
 	if (clause->len == 0)
 		clause = g_string_append(clause, " 1");
 
-	if (!lp->flag_allversion || lp->maxkeys>0 || lp->marker_start || lp->marker_end)
+	if (!lp->flag_allversion || lp->maxkeys>0 || lp->marker_start
+			|| lp->marker_end || lp->delimiter || cursor)
 		g_string_append(clause, " ORDER BY alias ASC, version ASC");
 
 	if (lp->maxkeys > 0)
@@ -533,94 +593,250 @@ _list_params_to_sql_clause(struct list_params_s *lp, GString *clause,
 	return (GVariant**) g_ptr_array_free (params, FALSE);
 }
 
+/* How many content IDs are bound in a single query, safely below the
+ * SQLITE_MAX_VARIABLE_NUMBER of the oldest SQLite versions */
+#define LIST_HEADERS_BATCH 256
+
+/* A header loaded for a page of aliases, and how many of those aliases
+ * still have to be sent with it */
+struct header_ref_s
+{
+	struct bean_CONTENTS_HEADERS_s *header;
+	guint refs;
+};
+
+static guint
+_gba_hash(gconstpointer k)
+{
+	const GByteArray *gba = k;
+	guint h = 5381;
+	for (guint i = 0; i < gba->len ;++i)
+		h = ((h << 5) + h) ^ gba->data[i];
+	return h;
+}
+
+static void
+_header_ref_free(struct header_ref_s *ref)
+{
+	if (ref->header)
+		_bean_clean(ref->header);
+	g_free(ref);
+}
+
+/* Load the headers of all the <aliases> with one query per batch of
+ * content IDs. */
+static GError *
+_load_headers_of_aliases(sqlite3 *db, GSList *aliases, GHashTable *refs)
+{
+	GPtrArray *ids = g_ptr_array_new();
+	for (GSList *l = aliases; l ;l = l->next) {
+		GByteArray *id = ALIASES_get_content(l->data);
+		struct header_ref_s *ref = g_hash_table_lookup(refs, id);
+		if (!ref) {
+			ref = g_malloc0(sizeof(struct header_ref_s));
+			id = metautils_gba_dup(id);
+			g_hash_table_insert(refs, id, ref);
+			g_ptr_array_add(ids, id);
+		}
+		ref->refs ++;
+	}
+
+	void _on_header(gpointer u, gpointer bean) {
+		(void) u;
+		struct header_ref_s *ref = g_hash_table_lookup(refs,
+				CONTENTS_HEADERS_get_id(bean));
+		if (ref && !ref->header)
+			ref->header = bean;
+		else
+			_bean_clean(bean);
+	}
+
+	GError *err = NULL;
+	for (guint i = 0; !err && i < ids->len ;i += LIST_HEADERS_BATCH) {
+		const guint max = MIN(ids->len - i, LIST_HEADERS_BATCH);
+		GString *clause = g_string_new(" id IN (");
+		GVariant **params = g_malloc0((max + 1) * sizeof(GVariant*));
+		for (guint j = 0; j < max ;++j) {
+			if (j)
+				g_string_append_c(clause, ',');
+			g_string_append_c(clause, '?');
+			params[j] = _gba_to_gvariant(ids->pdata[i + j]);
+		}
+		g_string_append_c(clause, ')');
+		err = CONTENTS_HEADERS_load(db, clause->str, params, _on_header, NULL);
+		metautils_gvariant_unrefv(params);
+		g_free(params);
+		g_string_free(clause, TRUE);
+	}
+
+	g_ptr_array_free(ids, TRUE);
+	return err;
+}
+
+/* The names beyond the prefix that contain the delimiter are collapsed
+ * into their common prefix. Once a common prefix has been sent, the next
+ * page seeks right beyond it, so that the index entries under the prefix
+ * are never scanned. */
 GError*
 m2db_list_aliases(struct sqlx_sqlite3_s *sq3, struct list_params_s *lp0,
-		GSList *headers, m2_onbean_cb cb, gpointer u)
+		GSList *headers, m2_onbean_cb cb, m2_onprefix_cb prefix_cb, gpointer u)
 {
 	GError *err = NULL;
-	GSList *aliases = NULL;
-	guint count_aliases = 0;
+	GSList *aliases = NULL, *prefixes = NULL;
+	gint64 count = 0;
 	struct list_params_s lp = *lp0;
-	gboolean done = FALSE;
-
-	while (!done && (lp.maxkeys <= 0 || count_aliases < lp.maxkeys)) {
-		GPtrArray *tmp = g_ptr_array_new();
-		void cleanup (void) {
-			g_ptr_array_set_free_func (tmp, _bean_clean);
-			g_ptr_array_free (tmp, TRUE);
-			tmp = NULL;
+	struct list_cursor_s cursor = {NULL, NULL, 0};
+	gboolean first = TRUE, done = FALSE;
+	const gint64 max = lp0->maxkeys;
+	const gsize prefix_len = lp.prefix ? strlen(lp.prefix) : 0;
+	const gchar *collapsed = NULL;
+	gchar *marker_prefix = NULL;
+
+	/* A marker in a common prefix means the whole prefix has been sent */
+	if (lp.delimiter && lp.marker_start
+			&& (!lp.prefix || g_str_has_prefix(lp.marker_start, lp.prefix))) {
+		const char *d = strchr(lp.marker_start + prefix_len, lp.delimiter);
+		if (d) {
+			collapsed = marker_prefix = g_strndup(lp.marker_start,
+					(d - lp.marker_start) + 1);
+			cursor.seek = _prefix_successor(marker_prefix, lp.delimiter);
+			first = cursor.seek == NULL;
 		}
+	}
+
+	while (!done) {
+		GPtrArray *tmp = g_ptr_array_new_with_free_func(_bean_clean);
+		gchar *seek = NULL;
 
-		if (aliases)
-			lp.marker_start = ALIASES_get_alias(aliases->data)->str;
-		if (lp.maxkeys > 0)
-			lp.maxkeys -= count_aliases;
+		/* One more row than needed tells if the next entry is a new one */
+		if (max > 0)
+			lp.maxkeys = max - count + 1;
 
 		// List the next items
 		GString *clause = g_string_new("");
-		GVariant **params = _list_params_to_sql_clause (&lp, clause, headers);
+		GVariant **params = _list_params_to_sql_clause (&lp,
+				first ? NULL : &cursor, clause, headers);
 		err = ALIASES_load(sq3->db, clause->str, params, _bean_buffer_cb, tmp);
 		metautils_gvariant_unrefv (params);
 		g_free (params), params = NULL;
 		g_string_free (clause, TRUE);
-		if (err) { cleanup (); goto label_error; }
-		if (!tmp->len) { cleanup (); goto label_ok; }
-
-		metautils_gpa_reverse (tmp);
+		first = FALSE;
+		if (err) { g_ptr_array_free (tmp, TRUE); goto label_error; }
+
+		const guint nb = tmp->len;
+		if (nb > 0) {
+			struct bean_ALIASES_s *last = tmp->pdata[nb-1];
+			oio_str_replace(&cursor.alias, ALIASES_get_alias(last)->str);
+			cursor.version = ALIASES_get_version(last);
+		}
 
-		for (guint i=tmp->len; i>0 ;i--) {
-			struct bean_ALIASES_s *alias = tmp->pdata[i-1];
+		for (guint i=0; !done && !seek && i<nb ;i++) {
+			struct bean_ALIASES_s *alias = tmp->pdata[i];
 			const gchar *name = ALIASES_get_alias(alias)->str;
 
-			if ((lp.prefix && !g_str_has_prefix(name, lp.prefix)) ||
-					(lp.maxkeys > 0 && count_aliases > lp.maxkeys)) {
-				cleanup (); goto label_ok;
+			if (lp.prefix && !g_str_has_prefix(name, lp.prefix)) {
+				done = TRUE;
+				break;
 			}
+			if (collapsed && g_str_has_prefix(name, collapsed))
+				continue;
 
-			g_ptr_array_remove_index_fast (tmp, i-1);
+			const char *d = lp.delimiter
+				? strchr(name + prefix_len, lp.delimiter) : NULL;
+			if (d) {
+				if (max > 0 && count >= max) {
+					done = TRUE;
+					break;
+				}
+				gchar *cp = g_strndup(name, (d - name) + 1);
+				prefixes = g_slist_prepend(prefixes, cp);
+				collapsed = cp;
+				++ count;
+				/* Without successor, the rows under the prefix are skipped
+				 * one by one */
+				seek = _prefix_successor(cp, lp.delimiter);
+				continue;
+			}
 
-			if (!aliases || lp.flag_allversion) {
-				aliases = g_slist_prepend(aliases, alias);
-				++ count_aliases;
+			if (aliases && !lp.flag_allversion && !strcmp(name,
+						ALIASES_get_alias(aliases->data)->str)) {
+				/* The versions come in ascending order, keep the latest */
+				_bean_clean (aliases->data);
+				aliases->data = alias;
 			} else {
-				const gchar *last_name = ALIASES_get_alias(aliases->data)->str;
-				if (!strcmp(last_name, name)) {
-					_bean_clean (aliases->data);
-					aliases->data = alias;
-				} else {
-					aliases = g_slist_prepend(aliases, alias);
-					++ count_aliases;
+				if (max > 0 && count >= max) {
+					done = TRUE;
+					break;
 				}
+				aliases = g_slist_prepend(aliases, alias);
+				++ count;
 			}
+			tmp->pdata[i] = NULL;
 		}
 
-		done = (lp.maxkeys <= 0) || (lp.maxkeys > tmp->len);
-		cleanup();
+		g_ptr_array_free (tmp, TRUE);
+		g_free (cursor.seek);
+		cursor.seek = seek;
+		if (!seek && (max <= 0 || (gint64)nb < lp.maxkeys))
+			done = TRUE;
 	}
 
-label_ok:
 	aliases = g_slist_reverse (aliases);
+
+	/* The headers of the whole page are loaded at once, then each one is
+	 * sent right before its alias. Several aliases may share a header. */
+	GHashTable *headers_by_id = NULL;
+	if (lp.flag_headers && aliases) {
+		headers_by_id = g_hash_table_new_full(_gba_hash,
+				(GEqualFunc)metautils_gba_equal, metautils_gba_unref,
+				(GDestroyNotify)_header_ref_free);
+		GError *e = _load_headers_of_aliases(sq3->db, aliases, headers_by_id);
+		if (e) {
+			GRID_DEBUG("No header for the listed aliases: (%d) %s",
+					e->code, e->message);
+			g_clear_error (&e);
+		}
+	}
+
+	prefixes = g_slist_reverse (prefixes);
+	GSList *pnext = prefixes;
 	for (GSList *l=aliases; l ;l=l->next) {
 		struct bean_ALIASES_s *alias = l->data;
-		if (lp.flag_headers) {
-			GPtrArray *t0 = g_ptr_array_new();
-			GError *e = _db_get_FK_by_name_buffered(alias, "image", sq3->db, t0);
-			if (e) {
-				GRID_DEBUG("No header for [%s] : (%d) %s",
-						ALIASES_get_alias(alias)->str,
-						err->code, err->message);
-				g_clear_error (&e);
+		/* Both lists are sorted, and a common prefix sorts before all the
+		 * names it collapses */
+		for (; pnext && 0 > strcmp(pnext->data,
+					ALIASES_get_alias(alias)->str) ;pnext=pnext->next) {
+			if (prefix_cb)
+				prefix_cb(u, pnext->data);
+		}
+		if (headers_by_id) {
+			struct header_ref_s *ref = g_hash_table_lookup(headers_by_id,
+					ALIASES_get_content(alias));
+			if (ref && ref->header) {
+				if (-- ref->refs > 0)
+					cb(u, _bean_dup(ref->header));
+				else {
+					cb(u, ref->header);
+					ref->header = NULL;
+				}
 			}
-			for (guint i=0; i<t0->len ;i++)
-				cb(u, t0->pdata[i]);
-			g_ptr_array_free (t0, TRUE);
 		}
 		cb(u, alias);
 		l->data = NULL;
 	}
+	for (; pnext ;pnext=pnext->next) {
+		if (prefix_cb)
+			prefix_cb(u, pnext->data);
+	}
+	if (headers_by_id)
+		g_hash_table_destroy(headers_by_id);
 
 label_error:
 	g_slist_free_full (aliases, _bean_clean);
+	g_slist_free_full (prefixes, g_free);
+	g_free (cursor.seek);
+	g_free (cursor.alias);
+	g_free (marker_prefix);
 	return err;
 }
 
@@ -47,6 +47,7 @@ struct list_params_s
 	const char *prefix;
 	const char *marker_start;
 	const char *marker_end;
+	char delimiter;
 	guint8 flag_nodeleted :1;
 	guint8 flag_allversion :1;
 	guint8 flag_headers:1;
@@ -57,6 +58,7 @@ struct list_result_s
 	GSList *beans;
 	gchar *next_marker;
 	gboolean truncated;
+	GSList *prefixes;
 };
 
 struct dup_alias_params_s
@@ -86,6 +88,8 @@ void m2v2_position_encode (GString *out, struct m2v2_position_s *p);
 
 typedef void (*m2_onbean_cb) (gpointer u, gpointer bean);
 
+typedef void (*m2_onprefix_cb) (gpointer u, const gchar *prefix);
+
 typedef gboolean (*m2_onprop_cb) (gpointer u, const gchar *k,
 		const guint8 *v, gsize vlen);
 
@@ -148,8 +152,10 @@ GError* m2db_latest_alias(struct sqlx_sqlite3_s *sq3, struct oio_url_s *url,
 GError* m2db_get_versioned_alias(struct sqlx_sqlite3_s *sq3, struct oio_url_s *url,
 		struct bean_ALIASES_s **out);
 
+/* With a delimiter, the common prefixes are sent to <prefix_cb>, in order
+ * with the aliases, and count in <maxkeys> as the aliases do. */
 GError* m2db_list_aliases(struct sqlx_sqlite3_s *sq3, struct list_params_s *lp,
-		GSList *headers, m2_onbean_cb cb, gpointer u);
+		GSList *headers, m2_onbean_cb cb, m2_onprefix_cb prefix_cb, gpointer u);
 
 GError* m2db_get_properties(struct sqlx_sqlite3_s *sq3, struct oio_url_s *url,
 		m2_onbean_cb cb, gpointer u);
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <glib.h>
 #include <json-c/json.h>
+#include <core/oiojson.h>
 
 GError* m2v2_json_load_single_alias (struct json_object *j, gpointer *pbean);
 GError* m2v2_json_load_single_header (struct json_object *j, gpointer *pbean);
@@ -38,6 +39,29 @@ GError * meta2_json_load_setof_beans(struct json_object *j, GSList **out);
 /**  */
 GError * m2v2_json_load_setof_xbean (struct json_object *j, GSList **out);
 
+/* Incremental loading of an array of beans, as the bytes arrive. The
+ * beans are checked as m2v2_json_load_setof_xbean() does, and built as
+ * soon as their object is complete. */
+struct m2v2_json_xbeans_parser_s;
+
+struct m2v2_json_xbeans_parser_s * m2v2_json_xbeans_parser_create (void);
+
+void m2v2_json_xbeans_parser_destroy (struct m2v2_json_xbeans_parser_s *p);
+
+GError * m2v2_json_xbeans_parser_feed (struct m2v2_json_xbeans_parser_s *p,
+		const void *data, gsize len);
+
+/* On success, <out> receives the beans in the order of the input */
+GError * m2v2_json_xbeans_parser_end (struct m2v2_json_xbeans_parser_s *p,
+		GSList **out);
+
+/* One-shot form of the parser above */
+GError * m2v2_json_parse_setof_xbean (const void *data, gsize len, GSList **out);
+
+/* The type is discovered in the record */
+GError * m2v2_json_record_to_xbean (const struct oio_json_record_s *r,
+		gpointer *pbean);
+
 /** Convert alias beans to their JSON representation.
  * Ignores beans of other types. */
 void meta2_json_alias_only(GString *gstr, GSList *l, gboolean extend);
@@ -30,12 +30,136 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 typedef GError* (*jbean_mapper) (struct json_object*, gpointer*);
 
+/* The beans are built from the decoded fields, whatever the way the JSON
+ * has been parsed: into a json-c tree or as a stream of records. */
+
+struct alias_fields_s
+{
+	const char *name;
+	const char *header;
+	gint64 version;
+	gint64 ctime;
+	gint64 mtime;
+	gboolean deleted;
+};
+
+struct header_fields_s
+{
+	const char *id;
+	const char *hash;
+	const char *method;
+	const char *mime;
+	gint64 size;
+	gint64 ctime;
+	gint64 mtime;
+	gboolean has_ctime;
+	gboolean has_mtime;
+};
+
+struct chunk_fields_s
+{
+	const char *id;
+	const char *content;
+	const char *hash;
+	const char *pos;
+	gint64 size;
+	gint64 ctime;
+	gboolean has_ctime;
+};
+
+static GError *
+_build_alias (const struct alias_fields_s *f, gpointer *pbean)
+{
+	GByteArray *hid = metautils_gba_from_hexstring(f->header);
+	if (!hid)
+		return NEWERROR(CODE_BAD_REQUEST, "Invalid alias, not hexadecimal header_id");
+
+	struct bean_ALIASES_s *alias = _bean_create (&descr_struct_ALIASES);
+	ALIASES_set2_alias (alias, f->name);
+	ALIASES_set_version (alias, f->version);
+	ALIASES_set2_content (alias, hid->data, hid->len);
+	ALIASES_set_deleted (alias, f->deleted);
+	ALIASES_set_mtime (alias, f->mtime);
+	ALIASES_set_ctime (alias, f->ctime);
+	*pbean = alias;
+
+	metautils_gba_unref (hid);
+	return NULL;
+}
+
+static GError *
+_build_header (const struct header_fields_s *f, gpointer *pbean)
+{
+	GError *err = NULL;
+	GByteArray *id = NULL, *hash = NULL;
+	struct bean_CONTENTS_HEADERS_s *header = NULL;
+
+	id = metautils_gba_from_hexstring(f->id);
+	if (!id) {
+		err = NEWERROR(CODE_BAD_REQUEST, "Invalid header, not hexa id");
+		goto exit;
+	}
+	hash = metautils_gba_from_hexstring(f->hash);
+	if (!hash || hash->len != 16) {
+		err = NEWERROR(CODE_BAD_REQUEST, "Invalid header, not hexa16 hash");
+		goto exit;
+	}
+
+	header = _bean_create (&descr_struct_CONTENTS_HEADERS);
+	CONTENTS_HEADERS_set2_id (header, id->data, id->len);
+	CONTENTS_HEADERS_set2_hash (header, hash->data, hash->len);
+	CONTENTS_HEADERS_set_size (header, f->size);
+	if (f->has_ctime)
+		CONTENTS_HEADERS_set_ctime (header, f->ctime);
+	if (f->has_mtime)
+		CONTENTS_HEADERS_set_mtime (header, f->mtime);
+	CONTENTS_HEADERS_set2_chunk_method (header, f->method);
+	CONTENTS_HEADERS_set2_mime_type (header, f->mime);
+	*pbean = header;
+
+exit:
+	metautils_gba_unref (id);
+	metautils_gba_unref (hash);
+	return err;
+}
+
+static GError *
+_build_chunk (const struct chunk_fields_s *f, gpointer *pbean)
+{
+	GError *err = NULL;
+	GByteArray *hid = NULL, *hash = NULL;
+	struct bean_CHUNKS_s *chunk = NULL;
+
+	hid = metautils_gba_from_hexstring(f->content);
+	if (!hid) {
+		err = NEWERROR(CODE_BAD_REQUEST, "Invalid header, not hexa id");
+		goto exit;
+	}
+	hash = metautils_gba_from_hexstring(f->hash);
+	if (!hash) {
+		err = NEWERROR(CODE_BAD_REQUEST, "Invalid chunk, not hexa header id");
+		goto exit;
+	}
+
+	chunk = _bean_create (&descr_struct_CHUNKS);
+	CHUNKS_set2_id (chunk, f->id);
+	CHUNKS_set_hash (chunk, hash);
+	CHUNKS_set_size (chunk, f->size);
+	CHUNKS_set_ctime (chunk, f->has_ctime ? f->ctime : oio_ext_real_time() / G_TIME_SPAN_SECOND);
+	CHUNKS_set_content (chunk, hid);
+	CHUNKS_set2_position (chunk, f->pos);
+	*pbean = chunk;
+
+exit:
+	metautils_gba_unref (hid);
+	metautils_gba_unref (hash);
+	return err;
+}
+
 GError*
 m2v2_json_load_single_alias (struct json_object *j, gpointer *pbean)
 {
 	GError *err = NULL;
-	GByteArray *hid = NULL;
-	struct bean_ALIASES_s *alias = NULL;
 	struct json_object *jname, *jversion, *jctime, *jmtime, *jheader, *jdel;
 	struct oio_ext_json_mapping_s m[] = {
 		{"name",    &jname,    json_type_string,  1},
@@ -49,36 +173,23 @@ m2v2_json_load_single_alias (struct json_object *j, gpointer *pbean)
 
 	*pbean = NULL;
 	if (NULL != (err = oio_ext_extract_json(j, m)))
-		goto exit;
-
-	hid = metautils_gba_from_hexstring(json_object_get_string(jheader));
-	if (!hid) {
-		err = NEWERROR(CODE_BAD_REQUEST, "Invalid alias, not hexadecimal header_id");
-		goto exit;
-	}
-
-	alias = _bean_create (&descr_struct_ALIASES);
-	ALIASES_set2_alias (alias, json_object_get_string(jname));
-	ALIASES_set_version (alias, json_object_get_int64(jversion));
-	ALIASES_set2_content (alias, hid->data, hid->len);
-	ALIASES_set_deleted (alias, json_object_get_boolean(jdel));
-	ALIASES_set_mtime (alias, json_object_get_int64(jmtime));
-	ALIASES_set_ctime (alias, json_object_get_int64(jctime));
-	*pbean = alias;
-	alias = NULL;
+		return err;
 
-exit:
-	metautils_gba_unref (hid);
-	_bean_clean (alias);
-	return err;
+	struct alias_fields_s f = {
+		.name = json_object_get_string(jname),
+		.header = json_object_get_string(jheader),
+		.version = json_object_get_int64(jversion),
+		.ctime = json_object_get_int64(jctime),
+		.mtime = json_object_get_int64(jmtime),
+		.deleted = json_object_get_boolean(jdel),
+	};
+	return _build_alias (&f, pbean);
 }
 
 GError*
 m2v2_json_load_single_header (struct json_object *j, gpointer *pbean)
 {
 	GError *err = NULL;
-	GByteArray *id = NULL, *hash = NULL;
-	struct bean_CONTENTS_HEADERS_s *header = NULL;
 	struct json_object *jid, *jhash, *jsize, *jctime, *jmtime, *jmethod, *jtype;
 	struct oio_ext_json_mapping_s mapping[] = {
 		{"id",     &jid,    json_type_string, 1},
@@ -95,44 +206,24 @@ m2v2_json_load_single_header (struct json_object *j, gpointer *pbean)
 	if (NULL != (err = oio_ext_extract_json (j, mapping)))
 		return err;
 
-	id = metautils_gba_from_hexstring(json_object_get_string(jid));
-	if (!id) {
-		err = NEWERROR(CODE_BAD_REQUEST, "Invalid header, not hexa id");
-		goto exit;
-	}
-	hash = metautils_gba_from_hexstring(json_object_get_string(jhash));
-	if (!hash || hash->len != 16) {
-		err = NEWERROR(CODE_BAD_REQUEST, "Invalid header, not hexa16 hash");
-		goto exit;
-	}
-
-	header = _bean_create (&descr_struct_CONTENTS_HEADERS);
-	CONTENTS_HEADERS_set2_id (header, id->data, id->len);
-	CONTENTS_HEADERS_set2_hash (header, hash->data, hash->len);
-	CONTENTS_HEADERS_set_size (header, json_object_get_int64(jsize));
-	if (jctime)
-		CONTENTS_HEADERS_set_ctime (header, json_object_get_int64(jctime));
-	if (jmtime)
-		CONTENTS_HEADERS_set_mtime (header, json_object_get_int64(jmtime));
-	CONTENTS_HEADERS_set2_chunk_method (header, json_object_get_string(jmethod));
-	CONTENTS_HEADERS_set2_mime_type (header, json_object_get_string(jtype));
-
-	*pbean = header;
-	header = NULL;
-
-exit:
-	metautils_gba_unref (id);
-	metautils_gba_unref (hash);
-	_bean_clean (header);
-	return err;
+	struct header_fields_s f = {
+		.id = json_object_get_string(jid),
+		.hash = json_object_get_string(jhash),
+		.method = json_object_get_string(jmethod),
+		.mime = json_object_get_string(jtype),
+		.size = json_object_get_int64(jsize),
+		.ctime = json_object_get_int64(jctime),
+		.mtime = json_object_get_int64(jmtime),
+		.has_ctime = jctime != NULL,
+		.has_mtime = jmtime != NULL,
+	};
+	return _build_header (&f, pbean);
 }
 
 GError*
 m2v2_json_load_single_chunk (struct json_object *j, gpointer *pbean)
 {
 	GError *err = NULL;
-	GByteArray *hid = NULL, *hash = NULL;
-	struct bean_CHUNKS_s *chunk = NULL;
 	struct json_object *jid, *jcontent, *jhash, *jsize, *jctime, *jpos;
 	struct oio_ext_json_mapping_s mapping[] = {
 		{"id",      &jid,      json_type_string, 1},
@@ -148,32 +239,16 @@ m2v2_json_load_single_chunk (struct json_object *j, gpointer *pbean)
 	if (NULL != (err = oio_ext_extract_json (j, mapping)))
 		return err;
 
-	hid = metautils_gba_from_hexstring(json_object_get_string(jcontent));
-	if (!hid) {
-		err = NEWERROR(CODE_BAD_REQUEST, "Invalid header, not hexa id");
-		goto exit;
-	}
-	hash = metautils_gba_from_hexstring(json_object_get_string(jhash));
-	if (!hash) {
-		err = NEWERROR(CODE_BAD_REQUEST, "Invalid chunk, not hexa header id");
-		goto exit;
-	}
-
-	chunk = _bean_create (&descr_struct_CHUNKS);
-	CHUNKS_set2_id (chunk, json_object_get_string(jid));
-	CHUNKS_set_hash (chunk, hash);
-	CHUNKS_set_size (chunk, json_object_get_int64(jsize));
-	CHUNKS_set_ctime (chunk, !jctime ? oio_ext_real_time() / G_TIME_SPAN_SECOND : json_object_get_int64(jctime));
-	CHUNKS_set_content (chunk, hid);
-	CHUNKS_set2_position (chunk, json_object_get_string (jpos));
-	*pbean = chunk;
-	chunk = NULL;
-
-exit:
-	metautils_gba_unref (hid);
-	metautils_gba_unref (hash);
-	_bean_clean (chunk);
-	return err;
+	struct chunk_fields_s f = {
+		.id = json_object_get_string(jid),
+		.content = json_object_get_string(jcontent),
+		.hash = json_object_get_string(jhash),
+		.pos = json_object_get_string(jpos),
+		.size = json_object_get_int64(jsize),
+		.ctime = json_object_get_int64(jctime),
+		.has_ctime = jctime != NULL,
+	};
+	return _build_chunk (&f, pbean);
 }
 
 static GError *
@@ -276,3 +351,195 @@ meta2_json_load_setof_beans(struct json_object *jbeans, GSList **beans)
 
 }
 
+/* Streamed records --------------------------------------------------------- */
+
+static gint64
+_record_int (const gchar *s)
+{
+	return s ? g_ascii_strtoll (s, NULL, 10) : 0;
+}
+
+static GError *
+_record_load_alias (const struct oio_json_record_s *r, gpointer *pbean)
+{
+	GError *err = NULL;
+	const gchar *name, *version, *header, *ctime, *mtime, *del;
+	struct oio_json_record_mapping_s m[] = {
+		{"name",    &name,    OIO_JSON_TYPE_STRING,  1},
+		{"ver",     &version, OIO_JSON_TYPE_INT,     1},
+		{"header",  &header,  OIO_JSON_TYPE_STRING,  1},
+		{"ctime",   &ctime,   OIO_JSON_TYPE_INT,     0},
+		{"mtime",   &mtime,   OIO_JSON_TYPE_INT,     0},
+		{"deleted", &del,     OIO_JSON_TYPE_BOOLEAN, 0},
+		{NULL, NULL, 0, 0}
+	};
+
+	if (NULL != (err = oio_json_record_extract (r, m)))
+		return err;
+
+	struct alias_fields_s f = {
+		.name = name,
+		.header = header,
+		.version = _record_int (version),
+		.ctime = _record_int (ctime),
+		.mtime = _record_int (mtime),
+		.deleted = del && *del == 't',
+	};
+	return _build_alias (&f, pbean);
+}
+
+static GError *
+_record_load_header (const struct oio_json_record_s *r, gpointer *pbean)
+{
+	GError *err = NULL;
+	const gchar *id, *hash, *size, *ctime, *mtime, *method, *mime;
+	struct oio_json_record_mapping_s m[] = {
+		{"id",     &id,    OIO_JSON_TYPE_STRING, 1},
+		{"hash",   &hash,  OIO_JSON_TYPE_STRING, 1},
+		{"size",   &size,  OIO_JSON_TYPE_INT, 1},
+		{"ctime",  &ctime, OIO_JSON_TYPE_INT, 0},
+		{"mtime",  &mtime, OIO_JSON_TYPE_INT, 0},
+		{"chunk-method", &method, OIO_JSON_TYPE_STRING, 1},
+		{"mime-type",    &mime,   OIO_JSON_TYPE_STRING, 1},
+		{NULL, NULL, 0, 0}
+	};
+
+	if (NULL != (err = oio_json_record_extract (r, m)))
+		return err;
+
+	struct header_fields_s f = {
+		.id = id,
+		.hash = hash,
+		.method = method,
+		.mime = mime,
+		.size = _record_int (size),
+		.ctime = _record_int (ctime),
+		.mtime = _record_int (mtime),
+		.has_ctime = ctime != NULL,
+		.has_mtime = mtime != NULL,
+	};
+	return _build_header (&f, pbean);
+}
+
+static GError *
+_record_load_chunk (const struct oio_json_record_s *r, gpointer *pbean)
+{
+	GError *err = NULL;
+	const gchar *id, *content, *hash, *size, *ctime, *pos;
+	struct oio_json_record_mapping_s m[] = {
+		{"id",      &id,      OIO_JSON_TYPE_STRING, 1},
+		{"hash",    &hash,    OIO_JSON_TYPE_STRING, 1},
+		{"size",    &size,    OIO_JSON_TYPE_INT, 1},
+		{"ctime",   &ctime,   OIO_JSON_TYPE_INT, 0},
+		{"content", &content, OIO_JSON_TYPE_STRING, 1},
+		{"pos",     &pos,     OIO_JSON_TYPE_STRING, 1},
+		{NULL, NULL, 0, 0}
+	};
+
+	if (NULL != (err = oio_json_record_extract (r, m)))
+		return err;
+
+	struct chunk_fields_s f = {
+		.id = id,
+		.content = content,
+		.hash = hash,
+		.pos = pos,
+		.size = _record_int (size),
+		.ctime = _record_int (ctime),
+		.has_ctime = ctime != NULL,
+	};
+	return _build_chunk (&f, pbean);
+}
+
+GError *
+m2v2_json_record_to_xbean (const struct oio_json_record_s *r, gpointer *pbean)
+{
+	*pbean = NULL;
+	if (oio_json_record_get_type (r) != OIO_JSON_TYPE_OBJECT)
+		return NEWERROR(CODE_BAD_REQUEST, "Invalid object type");
+
+	GError *err = NULL;
+	const gchar *stype = NULL;
+	struct oio_json_record_mapping_s m[] = {
+		{"type", &stype, OIO_JSON_TYPE_STRING, 1},
+		{NULL, NULL, 0, 0}
+	};
+	if (NULL != (err = oio_json_record_extract (r, m))) {
+		g_clear_error (&err);
+		return NEWERROR(CODE_BAD_REQUEST, "Missing or invalid 'type' field");
+	}
+
+	if (!g_ascii_strcasecmp(stype, "alias"))
+		return _record_load_alias (r, pbean);
+	if (!g_ascii_strcasecmp(stype, "header"))
+		return _record_load_header (r, pbean);
+	if (!g_ascii_strcasecmp(stype, "chunk"))
+		return _record_load_chunk (r, pbean);
+
+	return NEWERROR(CODE_BAD_REQUEST, "Unexpected 'type' field");
+}
+
+static GError *
+_on_xbean_record (gpointer u, const struct oio_json_record_s *r)
+{
+	GSList **pl = u;
+	gpointer bean = NULL;
+	GError *err = m2v2_json_record_to_xbean (r, &bean);
+	EXTRA_ASSERT((bean != NULL) ^ (err != NULL));
+	if (!err)
+		*pl = g_slist_prepend (*pl, bean);
+	return err;
+}
+
+struct m2v2_json_xbeans_parser_s
+{
+	struct oio_json_records_s *records;
+	GSList *beans;
+};
+
+struct m2v2_json_xbeans_parser_s *
+m2v2_json_xbeans_parser_create (void)
+{
+	struct m2v2_json_xbeans_parser_s *p = g_malloc0 (sizeof(*p));
+	p->records = oio_json_records_create (_on_xbean_record, &p->beans);
+	return p;
+}
+
+void
+m2v2_json_xbeans_parser_destroy (struct m2v2_json_xbeans_parser_s *p)
+{
+	if (!p)
+		return;
+	oio_json_records_destroy (p->records);
+	_bean_cleanl2 (p->beans);
+	g_free (p);
+}
+
+GError *
+m2v2_json_xbeans_parser_feed (struct m2v2_json_xbeans_parser_s *p,
+		const void *data, gsize len)
+{
+	return oio_json_records_feed (p->records, data, len);
+}
+
+GError *
+m2v2_json_xbeans_parser_end (struct m2v2_json_xbeans_parser_s *p, GSList **out)
+{
+	GError *err = oio_json_records_end (p->records);
+	if (!err) {
+		*out = g_slist_reverse (p->beans);
+		p->beans = NULL;
+	}
+	return err;
+}
+
+GError *
+m2v2_json_parse_setof_xbean (const void *data, gsize len, GSList **out)
+{
+	struct m2v2_json_xbeans_parser_s *p = m2v2_json_xbeans_parser_create ();
+	GError *err = m2v2_json_xbeans_parser_feed (p, data, len);
+	if (!err)
+		err = m2v2_json_xbeans_parser_end (p, out);
+	m2v2_json_xbeans_parser_destroy (p);
+	return err;
+}
@@ -29,58 +29,63 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 static void
 encode_alias (GString *g, gpointer bean)
 {
-	oio_str_gstring_append_json_pair (g, "name", ALIASES_get_alias(bean)->str);
-	g_string_append_printf(g,
-			",\"ver\":%"G_GINT64_FORMAT
-			",\"ctime\":%"G_GINT64_FORMAT
-			",\"mtime\":%"G_GINT64_FORMAT
-			",\"deleted\":%s"
-			",\"header\":\"",
-			ALIASES_get_version(bean),
-			ALIASES_get_ctime(bean),
-			ALIASES_get_mtime(bean),
-			ALIASES_get_deleted(bean) ? "true" : "false");
-	metautils_gba_to_hexgstr(g, ALIASES_get_content(bean));
-	g_string_append_c(g, '"');
+	OIO_JSON_KEY(g, "name");
+	oio_json_append_string (g, ALIASES_get_alias(bean)->str);
+	OIO_JSON_NEXT_KEY(g, "ver");
+	oio_json_append_int (g, ALIASES_get_version(bean));
+	OIO_JSON_NEXT_KEY(g, "ctime");
+	oio_json_append_int (g, ALIASES_get_ctime(bean));
+	OIO_JSON_NEXT_KEY(g, "mtime");
+	oio_json_append_int (g, ALIASES_get_mtime(bean));
+	OIO_JSON_NEXT_KEY(g, "deleted");
+	oio_json_append_bool (g, ALIASES_get_deleted(bean));
+	OIO_JSON_NEXT_KEY(g, "header");
+	metautils_gba_to_json (g, ALIASES_get_content(bean));
 }
 
 static void
 encode_header (GString *g, gpointer bean)
 {
-	g_string_append(g, "\"id\":\"");
-	metautils_gba_to_hexgstr(g, CONTENTS_HEADERS_get_id(bean));
-	g_string_append_printf(g, "\",\"hash\":\"");
-	metautils_gba_to_hexgstr(g, CONTENTS_HEADERS_get_hash(bean));
-	g_string_append_printf(g, "\",\"size\":%"G_GINT64_FORMAT,
-			CONTENTS_HEADERS_get_size(bean));
-	g_string_append_printf(g, ",\"policy\":\"%s\"",
-			CONTENTS_HEADERS_get_policy(bean)->str);
-	g_string_append_printf(g, ",\"chunk-method\":\"%s\"",
-			CONTENTS_HEADERS_get_chunk_method(bean)->str);
-	g_string_append_printf(g, ",\"mime-type\":\"%s\"",
-			CONTENTS_HEADERS_get_mime_type(bean)->str);
+	OIO_JSON_KEY(g, "id");
+	metautils_gba_to_json (g, CONTENTS_HEADERS_get_id(bean));
+	OIO_JSON_NEXT_KEY(g, "hash");
+	metautils_gba_to_json (g, CONTENTS_HEADERS_get_hash(bean));
+	OIO_JSON_NEXT_KEY(g, "size");
+	oio_json_append_int (g, CONTENTS_HEADERS_get_size(bean));
+	OIO_JSON_NEXT_KEY(g, "policy");
+	oio_json_append_string (g, CONTENTS_HEADERS_get_policy(bean)->str);
+	OIO_JSON_NEXT_KEY(g, "chunk-method");
+	oio_json_append_string (g, CONTENTS_HEADERS_get_chunk_method(bean)->str);
+	OIO_JSON_NEXT_KEY(g, "mime-type");
+	oio_json_append_string (g, CONTENTS_HEADERS_get_mime_type(bean)->str);
 }
 
 static void
 encode_chunk (GString *g, gpointer bean)
 {
-	g_string_append_printf(g, "\"id\":\"%s\",\"pos\":\"%s\",\"hash\":\"",
-			CHUNKS_get_id(bean)->str,
-			CHUNKS_get_position(bean)->str);
-	metautils_gba_to_hexgstr(g, CHUNKS_get_hash(bean));
-	g_string_append_printf(g, "\",\"size\":%"G_GINT64_FORMAT,
-			CHUNKS_get_size(bean));
+	OIO_JSON_KEY(g, "id");
+	oio_json_append_string (g, CHUNKS_get_id(bean)->str);
+	OIO_JSON_NEXT_KEY(g, "pos");
+	oio_json_append_string (g, CHUNKS_get_position(bean)->str);
+	OIO_JSON_NEXT_KEY(g, "hash");
+	metautils_gba_to_json (g, CHUNKS_get_hash(bean));
+	OIO_JSON_NEXT_KEY(g, "size");
+	oio_json_append_int (g, CHUNKS_get_size(bean));
 }
 
 static void
 encode_property (GString *g, gpointer bean)
 {
-	oio_str_gstring_append_json_pair(g, "alias", PROPERTIES_get_alias(bean)->str);
-	g_string_append_printf(g, ",\"version\":%"G_GINT64_FORMAT",", PROPERTIES_get_version(bean));
-	oio_str_gstring_append_json_pair(g, "key", PROPERTIES_get_key(bean)->str);
-	g_string_append_printf(g, ",\"value\":\"%.*s\"",
-			PROPERTIES_get_value(bean)->len,
-			(gchar*) PROPERTIES_get_value(bean)->data);
+	GByteArray *value = PROPERTIES_get_value(bean);
+	OIO_JSON_KEY(g, "alias");
+	oio_json_append_string (g, PROPERTIES_get_alias(bean)->str);
+	OIO_JSON_NEXT_KEY(g, "version");
+	oio_json_append_int (g, PROPERTIES_get_version(bean));
+	OIO_JSON_NEXT_KEY(g, "key");
+	oio_json_append_string (g, PROPERTIES_get_key(bean)->str);
+	OIO_JSON_NEXT_KEY(g, "value");
+	oio_json_append_stringn (g, value->len ? (gchar*) value->data : "",
+			value->len);
 }
 
 static void
@@ -112,9 +117,11 @@ _json_BEAN_only(GString *gstr, GSList *l, gconstpointer selector,
 			g_string_append_c(gstr, ',');
 		first = FALSE;
 		g_string_append_c (gstr, '{');
-		if (extend)
-			g_string_append_printf (gstr, "\"type\":\"%s\",",
-					DESCR(l->data)->name);
+		if (extend) {
+			OIO_JSON_KEY(gstr, "type");
+			oio_json_append_string (gstr, DESCR(l->data)->name);
+			g_string_append_c (gstr, ',');
+		}
 		encoder(gstr, l->data);
 		g_string_append_c (gstr, '}');
 	}
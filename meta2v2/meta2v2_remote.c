@@ -69,6 +69,8 @@ m2v2_list_result_clean (struct list_result_s *p)
 	p->beans = NULL;
 	oio_str_clean(&p->next_marker);
 	p->truncated = FALSE;
+	g_slist_free_full(p->prefixes, g_free);
+	p->prefixes = NULL;
 }
 
 static GByteArray*
@@ -160,12 +162,33 @@ m2v2_remote_pack_COPY(struct oio_url_s *url, const char *src)
 	return message_marshall_gba_and_clean(msg);
 }
 
-static GByteArray*
+GByteArray*
 m2v2_remote_pack_DEL(struct oio_url_s *url)
 {
 	return _m2v2_pack_request_with_flags(NAME_MSGNAME_M2V2_DEL, url, NULL, 0);
 }
 
+static GByteArray*
+m2v2_remote_pack_PUT_MANY(struct oio_url_s *url, GSList *beans)
+{
+	GByteArray *body = bean_sequence_marshall(beans);
+	return _m2v2_pack_request(NAME_MSGNAME_M2V2_PUT_MANY, url, body);
+}
+
+static GByteArray*
+m2v2_remote_pack_DEL_MANY(struct oio_url_s *url, gchar **paths)
+{
+	GSList *beans = NULL;
+	for (gchar **p=paths; p && *p ;p++) {
+		struct bean_ALIASES_s *alias = _bean_create(&descr_struct_ALIASES);
+		ALIASES_set2_alias(alias, *p);
+		beans = g_slist_prepend(beans, alias);
+	}
+	GByteArray *body = bean_sequence_marshall(beans);
+	_bean_cleanl2(beans);
+	return _m2v2_pack_request(NAME_MSGNAME_M2V2_DEL_MANY, url, body);
+}
+
 static GByteArray*
 m2v2_remote_pack_RAW_DEL(struct oio_url_s *url, GSList *beans)
 {
@@ -194,7 +217,7 @@ m2v2_remote_pack_RAW_SUBST(struct oio_url_s *url,
 	return message_marshall_gba_and_clean(msg);
 }
 
-static GByteArray*
+GByteArray*
 m2v2_remote_pack_GET(struct oio_url_s *url, guint32 flags)
 {
 	return _m2v2_pack_request_with_flags(NAME_MSGNAME_M2V2_GET, url, NULL, flags);
@@ -216,6 +239,10 @@ _pack_list_params (MESSAGE msg, struct list_params_s *p)
 	metautils_message_add_field_str(msg, NAME_MSGKEY_PREFIX, p->prefix);
 	metautils_message_add_field_str(msg, NAME_MSGKEY_MARKER, p->marker_start);
 	metautils_message_add_field_str(msg, NAME_MSGKEY_MARKER_END, p->marker_end);
+	if (p->delimiter) {
+		const char delimiter[2] = {p->delimiter, 0};
+		metautils_message_add_field_str(msg, NAME_MSGKEY_DELIMITER, delimiter);
+	}
 	if (p->maxkeys > 0)
 		metautils_message_add_field_strint64(msg, NAME_MSGKEY_MAX_KEYS, p->maxkeys);
 }
@@ -260,14 +287,14 @@ m2v2_remote_pack_LIST_BY_HEADERID(struct oio_url_s *url, struct list_params_s *p
 	return message_marshall_gba_and_clean(msg);
 }
 
-static GByteArray*
+GByteArray*
 m2v2_remote_pack_PROP_DEL(struct oio_url_s *url, GSList *names)
 {
 	GByteArray *body = strings_marshall_gba(names, NULL);
 	return _m2v2_pack_request(NAME_MSGNAME_M2V2_PROP_DEL, url, body);
 }
 
-static GByteArray*
+GByteArray*
 m2v2_remote_pack_PROP_SET(struct oio_url_s *url, guint32 flags,
 		GSList *beans)
 {
@@ -275,7 +302,7 @@ m2v2_remote_pack_PROP_SET(struct oio_url_s *url, guint32 flags,
 	return _m2v2_pack_request_with_flags(NAME_MSGNAME_M2V2_PROP_SET, url, body, flags);
 }
 
-static GByteArray*
+GByteArray*
 m2v2_remote_pack_PROP_GET(struct oio_url_s *url, guint32 flags)
 {
 	return _m2v2_pack_request_with_flags(NAME_MSGNAME_M2V2_PROP_GET, url, NULL, flags);
@@ -341,7 +368,7 @@ m2v2_remote_pack_EXITELECTION(struct oio_url_s *url)
 	return _m2v2_pack_request(NAME_MSGNAME_M2V2_EXITELECTION, url, NULL);
 }
 
-static GByteArray*
+GByteArray*
 m2v2_remote_pack_TOUCH_content(struct oio_url_s *url)
 {
 	return _m2v2_pack_request(NAME_MSGNAME_M2V1_TOUCH_CONTENT, url, NULL);
@@ -360,7 +387,7 @@ m2v2_remote_pack_ISEMPTY (struct oio_url_s *url)
 			(NAME_MSGNAME_M2V2_ISEMPTY, url, NULL));
 }
 
-static GByteArray*
+GByteArray*
 m2v2_remote_pack_LINK(struct oio_url_s *url)
 {
 	return message_marshall_gba_and_clean(_m2v2_build_request(NAME_MSGNAME_M2V2_LINK, url, NULL));
@@ -368,11 +395,119 @@ m2v2_remote_pack_LINK(struct oio_url_s *url)
 
 /* ------------------------------------------------------------------------- */
 
+/* The requests are multiplexed in the shared client pool. Its single thread
+ * only keeps the bodies of the replies, they are decoded by the consumer. */
+struct m2v2_reply_s
+{
+	GError *err;
+	GPtrArray *bodies;
+
+	m2v2_done_f done;
+	gpointer udata;
+};
+
+static struct m2v2_reply_s *
+_reply_create (void)
+{
+	struct m2v2_reply_s *reply = g_malloc0 (sizeof (struct m2v2_reply_s));
+	reply->bodies = g_ptr_array_new_with_free_func (metautils_gba_unref);
+	return reply;
+}
+
+static gboolean
+_reply_keep_body (struct m2v2_reply_s *reply, MESSAGE msg)
+{
+	GByteArray *body = NULL;
+	GError *e = metautils_message_extract_body_gba (msg, &body);
+	if (e)
+		g_clear_error (&e);
+	else if (!body->len)
+		g_byte_array_unref (body);
+	else
+		g_ptr_array_add (reply->bodies, body);
+	return TRUE;
+}
+
+static void
+_reply_done (struct m2v2_reply_s *reply, GError *err)
+{
+	if (err)
+		reply->err = g_error_copy (err);
+	reply->done (reply->udata, reply);
+}
+
+void
+m2v2_reply_free (struct m2v2_reply_s *reply)
+{
+	if (!reply)
+		return;
+	if (reply->err)
+		g_clear_error (&reply->err);
+	g_ptr_array_free (reply->bodies, TRUE);
+	g_free (reply);
+}
+
+const GError *
+m2v2_reply_error (struct m2v2_reply_s *reply)
+{
+	EXTRA_ASSERT (reply != NULL);
+	return reply->err;
+}
+
+GError *
+m2v2_reply_decode_beans (struct m2v2_reply_s *reply, GSList **out)
+{
+	EXTRA_ASSERT (reply != NULL);
+	EXTRA_ASSERT (out != NULL);
+
+	GSList *items = NULL;
+	for (guint i = 0; i < reply->bodies->len ;++i) {
+		GByteArray *body = reply->bodies->pdata[i];
+		GSList *l = NULL;
+		GError *e = NULL;
+		if (0 >= bean_sequence_decoder (&l, body->data, body->len, &e)) {
+			if (!e)
+				e = NEWERROR (CODE_BAD_REQUEST, "Decoder error");
+			e->code = CODE_BAD_REQUEST;
+			g_prefix_error (&e, "Decoding error: Invalid body: ");
+			_bean_cleanl2 (items);
+			return e;
+		}
+		items = metautils_gslist_precat (items, l);
+	}
+
+	*out = items;
+	return NULL;
+}
+
+void
+m2v2_remote_submit (const char *target, GByteArray *req, gdouble timeout,
+		m2v2_done_f done, gpointer udata)
+{
+	EXTRA_ASSERT (req != NULL);
+	EXTRA_ASSERT (done != NULL);
+
+	struct m2v2_reply_s *reply = _reply_create ();
+	reply->done = done;
+	reply->udata = udata;
+	gridd_client_pool_submit (gridd_client_pool_shared (), target, req,
+			timeout, reply, (client_on_reply) _reply_keep_body,
+			(gridd_client_done_f) _reply_done, reply);
+}
+
 static GError*
 _m2v2_request_ex(const char *url, GByteArray *req, gdouble timeout, GSList **out)
 {
 	EXTRA_ASSERT (req != NULL);
-	return gridd_client_exec_and_decode (url, timeout, req, out, bean_sequence_decoder);
+
+	struct m2v2_reply_s *reply = _reply_create ();
+	GError *err = gridd_client_pool_exec (url, req, timeout, reply,
+			out ? (client_on_reply) _reply_keep_body : NULL);
+	g_byte_array_unref (req);
+	if (!err && out)
+		err = m2v2_reply_decode_beans (reply, out);
+	m2v2_reply_free (reply);
+	return err;
 }
 
 static GError*
@@ -400,28 +535,27 @@ m2v2_remote_execute_DESTROY_many(gchar **targets, struct oio_url_s *url, guint32
 		return NEWERROR(CODE_INTERNAL_ERROR, "invalid target array (NULL)");
 
 	// TODO: factorize with sqlx_remote_execute_DESTROY_many
+	const guint count = g_strv_length(targets);
+	GError **errv = g_malloc0((count + 1) * sizeof(GError*));
 	GByteArray *req = m2v2_remote_pack_DESTROY(url, flags);
-	struct gridd_client_s **clients = gridd_client_create_many(targets, req, NULL, NULL);
+	gridd_client_pool_exec_many(targets, req, M2V2_CLIENT_TIMEOUT, NULL, NULL, errv);
 	metautils_gba_unref(req);
 	req = NULL;
 
-	if (clients == NULL)
-		return NEWERROR(0, "Failed to create gridd clients");
-
-	gridd_clients_start(clients);
-	GError *err = gridd_clients_loop(clients);
-	for (struct gridd_client_s **p = clients; !err && p && *p ;p++) {
-		if (!(err = gridd_client_error(*p)))
+	GError *err = NULL;
+	for (guint i = 0; i < count ;i++) {
+		if (!errv[i])
 			continue;
 		GRID_DEBUG("Database destruction attempts failed: (%d) %s",
-				err->code, err->message);
-		if (err->code == CODE_CONTAINER_NOTFOUND || err->code == CODE_NOT_FOUND) {
-			g_clear_error(&err);
-			continue;
-		}
+				errv[i]->code, errv[i]->message);
+		if (!err && errv[i]->code != CODE_CONTAINER_NOTFOUND
+				&& errv[i]->code != CODE_NOT_FOUND)
+			err = errv[i];
+		else
+			g_clear_error(errv + i);
 	}
 
-	gridd_clients_free(clients);
+	g_free(errv);
 	return err;
 }
 
@@ -514,6 +648,64 @@ m2v2_remote_execute_DEL(const char *target, struct oio_url_s *url)
 	return _m2v2_request(target, m2v2_remote_pack_DEL(url), NULL);
 }
 
+/* Collects the per-path statuses of a batch, as "<code> <message>" */
+static GError*
+_m2v2_request_batch(const char *target, GByteArray *req,
+		GHashTable **out_errors)
+{
+	GHashTable *errors = g_hash_table_new_full(g_str_hash, g_str_equal,
+			g_free, (GDestroyNotify)g_error_free);
+
+	gboolean _cb(gpointer ctx, MESSAGE reply) {
+		(void) ctx;
+		gchar **names = metautils_message_get_field_names (reply);
+		for (gchar **n=names ; n && *n ;++n) {
+			if (!g_str_has_prefix (*n, NAME_MSGKEY_PREFIX_STATUS))
+				continue;
+			gchar *v = metautils_message_extract_string_copy (reply, *n);
+			if (!v)
+				continue;
+			gchar *end = NULL;
+			gint64 code = g_ascii_strtoll (v, &end, 10);
+			if (code != CODE_FINAL_OK) {
+				if (end && *end == ' ')
+					end ++;
+				g_hash_table_replace (errors,
+						g_strdup((*n) + sizeof(NAME_MSGKEY_PREFIX_STATUS) - 1),
+						NEWERROR(code, "%s", end ? end : v));
+			}
+			g_free (v);
+		}
+		if (names) g_strfreev (names);
+		return TRUE;
+	}
+
+	GError *err = gridd_client_pool_exec (target, req, M2V2_CLIENT_TIMEOUT,
+			NULL, _cb);
+	g_byte_array_unref (req);
+	if (!err && out_errors)
+		*out_errors = errors;
+	else
+		g_hash_table_destroy (errors);
+	return err;
+}
+
+GError*
+m2v2_remote_execute_PUT_MANY(const char *target, struct oio_url_s *url,
+		GSList *in, GHashTable **out_errors)
+{
+	return _m2v2_request_batch(target, m2v2_remote_pack_PUT_MANY(url, in),
+			out_errors);
+}
+
+GError*
+m2v2_remote_execute_DEL_MANY(const char *target, struct oio_url_s *url,
+		gchar **paths, GHashTable **out_errors)
+{
+	return _m2v2_request_batch(target, m2v2_remote_pack_DEL_MANY(url, paths),
+			out_errors);
+}
+
 GError*
 m2v2_remote_execute_RAW_ADD(const char *target, struct oio_url_s *url,
 		GSList *beans)
@@ -583,78 +775,89 @@ m2v2_remote_execute_LINK(const char *target, struct oio_url_s *url)
 	return _m2v2_request(target, m2v2_remote_pack_LINK(url), NULL);
 }
 
+/* The replies of a listing: the beans are decoded out of the pool's thread,
+ * the other fields are cheap enough to be collected as they come. */
+struct list_reply_s
+{
+	struct m2v2_reply_s *raw;
+	struct list_result_s *out;
+	GTree *props;
+};
+
+static gboolean
+_list_keep_reply (struct list_reply_s *ctx, MESSAGE reply)
+{
+	struct list_result_s *out = ctx->out;
+
+	_reply_keep_body (ctx->raw, reply);
+
+	/* Extract list flags */
+	GError *e = metautils_message_extract_boolean (reply,
+			NAME_MSGKEY_TRUNCATED, FALSE, &out->truncated);
+	if (e)
+		g_clear_error (&e);
+	gchar *tok = NULL;
+	tok = metautils_message_extract_string_copy (reply, NAME_MSGKEY_NEXTMARKER);
+	oio_str_reuse (&out->next_marker, tok);
+
+	/* Extract properties and merge them into the temporary TreeSet,
+	 * and the common prefixes. */
+	gchar **names = metautils_message_get_field_names (reply);
+	for (gchar **n=names ; n && *n ;++n) {
+		if (g_str_has_prefix (*n, NAME_MSGKEY_PREFIX_COMMON)) {
+			out->prefixes = g_slist_prepend (out->prefixes,
+					g_strdup((*n) + sizeof(NAME_MSGKEY_PREFIX_COMMON) - 1));
+		} else if (ctx->props
+				&& g_str_has_prefix (*n, NAME_MSGKEY_PREFIX_PROPERTY)) {
+			g_tree_replace (ctx->props,
+					g_strdup((*n) + sizeof(NAME_MSGKEY_PREFIX_PROPERTY) - 1),
+					metautils_message_extract_string_copy(reply, *n));
+		}
+	}
+	if (names) g_strfreev (names);
+
+	return TRUE;
+}
+
 static GError*
 _list (const char *target, GByteArray *request,
 		struct list_result_s *out, gchar ***out_properties)
 {
-	GError *err = NULL;
-	GTree *props = NULL;
-	gboolean _cb(gpointer ctx, MESSAGE reply) {
-		(void) ctx;
+	EXTRA_ASSERT(target != NULL);
 
-		/* Extract replied aliases */
-		GSList *l = NULL;
-		GError *e = metautils_message_extract_body_encoded(reply, FALSE, &l, bean_sequence_decoder);
-		if (e) {
-			GRID_DEBUG("Callback error : %s", e->message);
-			err = e;
-			return FALSE;
-		}
+	struct list_reply_s ctx = {NULL, NULL, NULL};
+	ctx.raw = _reply_create ();
+	ctx.out = out;
+	if (out_properties)
+		ctx.props = g_tree_new_full (metautils_strcmp3, NULL, g_free, g_free);
 
-		out->beans = metautils_gslist_precat (out->beans, l);
-
-		/* Extract list flags */
-		e = metautils_message_extract_boolean (reply,
-				NAME_MSGKEY_TRUNCATED, FALSE, &out->truncated);
-		if (e)
-			g_clear_error (&e);
-		gchar *tok = NULL;
-		tok = metautils_message_extract_string_copy (reply, NAME_MSGKEY_NEXTMARKER);
-		oio_str_reuse (&out->next_marker, tok);
-
-		/* Extract properties and merge them into the temporary TreeSet. */
-		if (out_properties) {
-			gchar **names = metautils_message_get_field_names (reply);
-			for (gchar **n=names ; n && *n ;++n) {
-				if (!g_str_has_prefix (*n, NAME_MSGKEY_PREFIX_PROPERTY))
-					continue;
-				g_tree_replace (props,
-						g_strdup((*n) + sizeof(NAME_MSGKEY_PREFIX_PROPERTY) - 1),
-						metautils_message_extract_string_copy(reply, *n));
-			}
-			if (names) g_strfreev (names);
-		}
+	GError *err = gridd_client_pool_exec (target, request, 0.0, &ctx,
+			out ? (client_on_reply) _list_keep_reply : NULL);
 
-		return TRUE;
+	/* Extract replied aliases */
+	if (!err && out) {
+		GSList *l = NULL;
+		if (!(err = m2v2_reply_decode_beans (ctx.raw, &l)))
+			out->beans = metautils_gslist_precat (out->beans, l);
+		else
+			GRID_DEBUG("Callback error : %s", err->message);
 	}
 
-	EXTRA_ASSERT(target != NULL);
-
-	struct gridd_client_s *client = gridd_client_create_idle(target);
-	if (!client)
-		err = NEWERROR(2, "errno=%d %s", errno, strerror(errno));
-	if (!err)
-		err = gridd_client_request(client, request, props, out ? _cb : NULL);
-	if (!err) {
-		if (out_properties)
-			props = g_tree_new_full (metautils_strcmp3, NULL, g_free, g_free);
-		err = gridd_client_run (client);
-	}
-	if (!err && out_properties && props) {
+	if (!err && out_properties && ctx.props) {
 		gboolean _run (gchar *k, gchar *v, GPtrArray *tmp) {
 			g_ptr_array_add (tmp, g_strdup(k));
 			g_ptr_array_add (tmp, g_strdup(v));
 			return FALSE;
 		}
 		GPtrArray *tmp = g_ptr_array_new ();
-		g_tree_foreach (props, (GTraverseFunc)_run, tmp);
+		g_tree_foreach (ctx.props, (GTraverseFunc)_run, tmp);
 		*out_properties = (gchar**) metautils_gpa_to_array (tmp, TRUE);
 		tmp = NULL;
 	}
 
-	gridd_client_free(client);
-	g_byte_array_free(request, TRUE);
-	if (props) g_tree_unref (props);
+	g_byte_array_unref(request);
+	if (ctx.props) g_tree_unref (ctx.props);
+	m2v2_reply_free (ctx.raw);
 	return err;
 }
 
@@ -136,6 +136,18 @@ GError* m2v2_remote_execute_GET(const char *target, struct oio_url_s *url,
 
 GError* m2v2_remote_execute_DEL(const char *target, struct oio_url_s *url);
 
+/* Put several contents of the container in one request, i.e. in one
+ * transaction on the meta2. The beans of each content must carry its content
+ * ID. On success, <out_errors> maps each failed path to its error (the
+ * missing paths succeeded). */
+GError* m2v2_remote_execute_PUT_MANY(const char *target, struct oio_url_s *url,
+		GSList *in, GHashTable **out_errors);
+
+/* Delete the latest version of each of <paths> in one request, the
+ * outcome is reported as with m2v2_remote_execute_PUT_MANY(). */
+GError* m2v2_remote_execute_DEL_MANY(const char *target, struct oio_url_s *url,
+		gchar **paths, GHashTable **out_errors);
+
 GError* m2v2_remote_execute_RAW_ADD(const char *target, struct oio_url_s *url,
 		GSList *beans);
 
@@ -190,4 +202,39 @@ GError* m2v2_remote_touch_content(const char *target, struct oio_url_s *url);
 
 GError* m2v2_remote_touch_container_ex(const char *target, struct oio_url_s *url, guint32 flags);
 
+/* Asynchronous requests ---------------------------------------------------- */
+
+/* What a request replied. The bodies are kept as they come, the consumer
+ * decodes them out of the thread of the shared client pool. */
+struct m2v2_reply_s;
+
+/* Called once per request, in the thread of the shared client pool, that it
+ * must not hold: it hands <reply> over to another thread, that decodes then
+ * frees it with m2v2_reply_free(). */
+typedef void (*m2v2_done_f) (gpointer udata, struct m2v2_reply_s *reply);
+
+/* Sends <req> (not consumed) to <target> through the shared client pool,
+ * without waiting for the reply. <done> may be called before the function
+ * returns. */
+void m2v2_remote_submit (const char *target, GByteArray *req,
+		gdouble timeout, m2v2_done_f done, gpointer udata);
+
+/* The error of the request, or NULL if it succeeded */
+const GError * m2v2_reply_error (struct m2v2_reply_s *reply);
+
+/* Decodes the beans of all the replies */
+GError * m2v2_reply_decode_beans (struct m2v2_reply_s *reply, GSList **out);
+
+void m2v2_reply_free (struct m2v2_reply_s *reply);
+
+/* The requests that may be submitted */
+GByteArray* m2v2_remote_pack_GET(struct oio_url_s *url, guint32 flags);
+GByteArray* m2v2_remote_pack_DEL(struct oio_url_s *url);
+GByteArray* m2v2_remote_pack_LINK(struct oio_url_s *url);
+GByteArray* m2v2_remote_pack_TOUCH_content(struct oio_url_s *url);
+GByteArray* m2v2_remote_pack_PROP_GET(struct oio_url_s *url, guint32 flags);
+GByteArray* m2v2_remote_pack_PROP_SET(struct oio_url_s *url, guint32 flags,
+		GSList *beans);
+GByteArray* m2v2_remote_pack_PROP_DEL(struct oio_url_s *url, GSList *names);
+
 #endif /*OIO_SDS__meta2v2__meta2v2_remote_h*/
@@ -29,12 +29,70 @@ License along with this library.
 
 enum message_param_e { MP_ID, MP_NAME, MP_VERSION, MP_BODY };
 
+/* All the parts of a message live in an arena, released at once with the
+ * message. The ASN.1 structure comes first, so that a MESSAGE points to
+ * both. Nothing in the message may be freed or reallocated on its own:
+ * replaced fields stay in the arena until the message is destroyed. */
+struct message_s
+{
+	Message_t asn;
+	struct oio_arena_s *arena;
+};
+
+#define MESSAGE_ARENA_BLOCK 2048
+
+static MESSAGE
+_message_new(gsize hint)
+{
+	struct oio_arena_s *arena = oio_arena_create(MAX(hint, MESSAGE_ARENA_BLOCK));
+	struct message_s *m = oio_arena_alloc0(arena, sizeof(struct message_s));
+	m->arena = arena;
+	return &m->asn;
+}
+
+static struct oio_arena_s *
+_arena(MESSAGE m)
+{
+	return ((struct message_s*)m)->arena;
+}
+
 static void
-_free_Parameter(Parameter_t * p)
+_os_fill(MESSAGE m, OCTET_STRING_t *os, const void *b, gsize l)
 {
-	if (!p)
-		return;
-	ASN_STRUCT_FREE(asn_DEF_Parameter, p);
+	os->buf = oio_arena_memdup0(_arena(m), b, l);
+	os->size = l;
+}
+
+static OCTET_STRING_t *
+_os_new(MESSAGE m, const void *b, gsize l)
+{
+	OCTET_STRING_t *os = oio_arena_alloc0(_arena(m), sizeof(OCTET_STRING_t));
+	_os_fill(m, os, b, l);
+	return os;
+}
+
+static void
+_add_parameter(MESSAGE m, Parameter_t *p)
+{
+	if (m->content.list.count >= m->content.list.size) {
+		const int size = MAX(8, m->content.list.size * 2);
+		Parameter_t **array = oio_arena_alloc(_arena(m), size * sizeof(void*));
+		if (m->content.list.count > 0)
+			memcpy(array, m->content.list.array,
+					m->content.list.count * sizeof(void*));
+		m->content.list.array = array;
+		m->content.list.size = size;
+	}
+	m->content.list.array[m->content.list.count ++] = p;
+}
+
+static Parameter_t *
+_parameter_new(MESSAGE m, const void *n, gsize nl, const void *v, gsize vl)
+{
+	Parameter_t *p = oio_arena_alloc0(_arena(m), sizeof(Parameter_t));
+	_os_fill(m, &p->name, n, nl);
+	_os_fill(m, &p->value, v, vl);
+	return p;
 }
 
 static OCTET_STRING_t *
@@ -59,7 +117,7 @@ MESSAGE
 metautils_message_create(void)
 {
 	const char *id = oio_ext_get_reqid ();
-	MESSAGE result = calloc(1, sizeof(Message_t));
+	MESSAGE result = _message_new(0);
 	if (id)
 		metautils_message_set_ID (result, id, strlen(id));
 	return result;
@@ -79,19 +137,7 @@ metautils_message_destroy(MESSAGE m)
 {
 	if (!m)
 		return ;
-
-	if (m->id != NULL)
-		ASN_STRUCT_FREE(asn_DEF_OCTET_STRING, m->id);
-	if (m->body != NULL)
-		ASN_STRUCT_FREE(asn_DEF_OCTET_STRING, m->body);
-	if (m->version != NULL)
-		ASN_STRUCT_FREE(asn_DEF_OCTET_STRING, m->version);
-	if (m->name != NULL)
-		ASN_STRUCT_FREE(asn_DEF_OCTET_STRING, m->name);
-
-	m->content.list.free = _free_Parameter;
-	asn_set_empty(&(m->content.list));
-	free(m);
+	oio_arena_destroy(_arena(m));
 }
 
 int
@@ -151,6 +197,217 @@ message_marshall_gba_and_clean(MESSAGE m)
 	return result;
 }
 
+/* DER tag of the body: context-specific, primitive, [4] */
+#define DER_TAG_BODY 0x84
+#define DER_TAG_SEQUENCE 0x30
+
+static void
+_der_append_length(GByteArray *gba, gsize len)
+{
+	if (len < 0x80) {
+		guint8 b = len;
+		g_byte_array_append(gba, &b, 1);
+		return;
+	}
+	guint8 buf[1 + sizeof(gsize)];
+	guint n = 0;
+	for (gsize l = len; l ;l >>= 8)
+		++ n;
+	buf[0] = 0x80 | n;
+	for (guint i = 0; i < n ;++i)
+		buf[n - i] = (len >> (8 * i)) & 0xFF;
+	g_byte_array_append(gba, buf, 1 + n);
+}
+
+GByteArray*
+message_marshall_gba_envelope(MESSAGE m, gsize body_len, GError **err)
+{
+	EXTRA_ASSERT(!metautils_message_has_BODY(m));
+
+	GByteArray *encoded = message_marshall_gba(m, err);
+	if (!encoded || !body_len)
+		return encoded;
+
+	/* Locate the content of the outer SEQUENCE */
+	const guint8 *p = encoded->data + 4, *end = encoded->data + encoded->len;
+	if (end - p < 2 || p[0] != DER_TAG_SEQUENCE) {
+		g_byte_array_free(encoded, TRUE);
+		GSETERROR(err, "Encoding error (envelope)");
+		return NULL;
+	}
+	gsize content_len = p[1];
+	p += 2;
+	if (content_len & 0x80) {
+		const guint n = content_len & 0x7F;
+		if (!n || n > sizeof(gsize) || (gsize)(end - p) < n) {
+			g_byte_array_free(encoded, TRUE);
+			GSETERROR(err, "Encoding error (envelope)");
+			return NULL;
+		}
+		content_len = 0;
+		for (guint i = 0; i < n ;++i)
+			content_len = (content_len << 8) | *(p++);
+	}
+	if ((gsize)(end - p) != content_len) {
+		g_byte_array_free(encoded, TRUE);
+		GSETERROR(err, "Encoding error (envelope)");
+		return NULL;
+	}
+
+	/* Then the header of the body, appended to the content */
+	GByteArray *body_hdr = g_byte_array_sized_new(16);
+	guint8 tag = DER_TAG_BODY;
+	g_byte_array_append(body_hdr, &tag, 1);
+	_der_append_length(body_hdr, body_len);
+
+	GByteArray *result = g_byte_array_sized_new(content_len + 32);
+	guint32 u32 = 0;
+	g_byte_array_append(result, (guint8*)&u32, sizeof(u32));
+	tag = DER_TAG_SEQUENCE;
+	g_byte_array_append(result, &tag, 1);
+	_der_append_length(result, content_len + body_hdr->len + body_len);
+	g_byte_array_append(result, p, content_len);
+	g_byte_array_append(result, body_hdr->data, body_hdr->len);
+	g_byte_array_free(body_hdr, TRUE);
+	g_byte_array_free(encoded, TRUE);
+
+	u32 = g_htonl(result->len - 4 + body_len);
+	memcpy(result->data, &u32, sizeof(u32));
+	return result;
+}
+
+/* DER decoding of the Message -------------------------------------------- */
+
+/* The generic BER decoder of asn1c allocates each part on its own. This
+ * one only knows the DER form of a Message, and copies it in the arena of
+ * the message. Whatever it does not expect (indefinite lengths, constructed
+ * strings, unknown or misordered tags) makes it give up, so that the
+ * message is decoded by asn1c. */
+
+#define DER_TAG_ID 0x80
+#define DER_TAG_NAME 0x81
+#define DER_TAG_VERSION 0x82
+#define DER_TAG_CONTENT 0xA3
+#define DER_TAG_PARAM_NAME 0x80
+#define DER_TAG_PARAM_VALUE 0x81
+
+struct der_s
+{
+	const guint8 *p;
+	const guint8 *end;
+};
+
+static gboolean
+_der_next(struct der_s *d, guint8 *tag, struct der_s *value)
+{
+	if (d->end - d->p < 2)
+		return FALSE;
+	*tag = *(d->p++);
+	if ((*tag & 0x1F) == 0x1F)
+		return FALSE;
+
+	gsize len = *(d->p++);
+	if (len & 0x80) {
+		guint n = len & 0x7F;
+		if (!n || n > sizeof(guint32) || (gsize)(d->end - d->p) < n)
+			return FALSE;
+		for (len = 0; n ;--n)
+			len = (len << 8) | *(d->p++);
+	}
+	if ((gsize)(d->end - d->p) < len)
+		return FALSE;
+
+	value->p = d->p;
+	value->end = d->p + len;
+	d->p += len;
+	return TRUE;
+}
+
+static gboolean
+_der_decode_content(MESSAGE m, struct der_s *content)
+{
+	while (content->p < content->end) {
+		struct der_s seq, name, value;
+		guint8 tag;
+		if (!_der_next(content, &tag, &seq) || tag != DER_TAG_SEQUENCE)
+			return FALSE;
+		if (!_der_next(&seq, &tag, &name) || tag != DER_TAG_PARAM_NAME)
+			return FALSE;
+		if (!_der_next(&seq, &tag, &value) || tag != DER_TAG_PARAM_VALUE)
+			return FALSE;
+		if (seq.p != seq.end)
+			return FALSE;
+		_add_parameter(m, _parameter_new(m,
+					name.p, name.end - name.p, value.p, value.end - value.p));
+	}
+	return TRUE;
+}
+
+static MESSAGE
+_der_decode_message(const guint8 *buf, gsize len)
+{
+	struct der_s all = {buf, buf + len}, seq, v;
+	guint8 tag, last = 0;
+
+	if (!_der_next(&all, &tag, &seq) || tag != DER_TAG_SEQUENCE)
+		return NULL;
+
+	/* The arena is sized to receive the whole message in its first block */
+	MESSAGE m = _message_new(len + MESSAGE_ARENA_BLOCK);
+	while (seq.p < seq.end) {
+		if (!_der_next(&seq, &tag, &v) || (tag & 0x1F) < last)
+			goto fail;
+		last = (tag & 0x1F) + 1;
+		switch (tag) {
+			case DER_TAG_ID:
+				m->id = _os_new(m, v.p, v.end - v.p);
+				break;
+			case DER_TAG_NAME:
+				m->name = _os_new(m, v.p, v.end - v.p);
+				break;
+			case DER_TAG_VERSION:
+				m->version = _os_new(m, v.p, v.end - v.p);
+				break;
+			case DER_TAG_CONTENT:
+				if (!_der_decode_content(m, &v))
+					goto fail;
+				break;
+			case DER_TAG_BODY:
+				m->body = _os_new(m, v.p, v.end - v.p);
+				break;
+			default:
+				goto fail;
+		}
+	}
+	return m;
+fail:
+	metautils_message_destroy(m);
+	return NULL;
+}
+
+/* Copies a Message decoded by asn1c in a new message, then frees it */
+static MESSAGE
+_import_message(Message_t *asn)
+{
+	MESSAGE m = _message_new(0);
+	if (asn->id)
+		m->id = _os_new(m, asn->id->buf, asn->id->size);
+	if (asn->name)
+		m->name = _os_new(m, asn->name->buf, asn->name->size);
+	if (asn->version)
+		m->version = _os_new(m, asn->version->buf, asn->version->size);
+	if (asn->body)
+		m->body = _os_new(m, asn->body->buf, asn->body->size);
+	for (int i = 0; i < asn->content.list.count ;++i) {
+		Parameter_t *p = asn->content.list.array[i];
+		if (p)
+			_add_parameter(m, _parameter_new(m, p->name.buf, p->name.size,
+						p->value.buf, p->value.size));
+	}
+	ASN_STRUCT_FREE(asn_DEF_Message, asn);
+	return m;
+}
+
 MESSAGE
 message_unmarshall(const guint8 *buf, gsize len, GError ** error)
 {
@@ -167,21 +424,26 @@ message_unmarshall(const guint8 *buf, gsize len, GError ** error)
 		return NULL;
 	}
 
-	MESSAGE m = NULL;
+	MESSAGE m = _der_decode_message(buf+4, l0);
+	if (m)
+		return m;
+
+	Message_t *asn = NULL;
 	asn_codec_ctx_t codec_ctx;
 	codec_ctx.max_stack_size = ASN1C_MAX_STACK;
 	size_t s = l0;
-	asn_dec_rval_t rc = ber_decode(&codec_ctx, &asn_DEF_Message, (void**)&m, buf+4, s);
+	asn_dec_rval_t rc = ber_decode(&codec_ctx, &asn_DEF_Message, (void**)&asn, buf+4, s);
 
 	if (rc.code == RC_OK)
-		return m;
+		return _import_message(asn);
 
 	if (rc.code == RC_WMORE)
 		GSETERROR(error, "%s (%"G_GSIZE_FORMAT" bytes consumed)", "uncomplete content", rc.consumed);
 	else
 		GSETERROR(error, "%s (%"G_GSIZE_FORMAT" bytes consumed)", "invalid content", rc.consumed);
 
-	metautils_message_destroy (m);
+	if (asn)
+		ASN_STRUCT_FREE(asn_DEF_Message, asn);
 	return NULL;
 }
 
@@ -201,12 +463,12 @@ message_get_param(MESSAGE m, enum message_param_e mp, gsize *sSize)
 }
 
 static void
-_os_set (OCTET_STRING_t **pos, const void *s, gsize sSize)
+_os_set (MESSAGE m, OCTET_STRING_t **pos, const void *s, gsize sSize)
 {
 	if (*pos)
-		OCTET_STRING_fromBuf(*pos, s, sSize);
+		_os_fill(m, *pos, s, sSize);
 	else
-		*pos = OCTET_STRING_new_fromBuf(&asn_DEF_OCTET_STRING, s, sSize);
+		*pos = _os_new(m, s, sSize);
 }
 
 static void
@@ -217,16 +479,16 @@ message_set_param(MESSAGE m, enum message_param_e mp, const void *s, gsize sSize
 
 	switch (mp) {
 		case MP_ID:
-			_os_set(&m->id, s, sSize);
+			_os_set(m, &m->id, s, sSize);
 			return;
 		case MP_NAME:
-			_os_set(&m->name, s, sSize);
+			_os_set(m, &m->name, s, sSize);
 			return;
 		case MP_VERSION:
-			_os_set(&m->version, s, sSize);
+			_os_set(m, &m->version, s, sSize);
 			return;
 		case MP_BODY:
-			_os_set(&m->body, s, sSize);
+			_os_set(m, &m->body, s, sSize);
 			return;
 		default:
 			g_assert_not_reached();
@@ -358,10 +620,7 @@ metautils_message_add_field(MESSAGE m, const char *n, const void *v, gsize vs)
 	EXTRA_ASSERT (n!=NULL);
 	if (!v || !vs)
 		return ;
-	Parameter_t *pMember = calloc(1, sizeof(Parameter_t));
-	OCTET_STRING_fromBuf(&(pMember->name), n, strlen(n));
-	OCTET_STRING_fromBuf(&(pMember->value), v, vs);
-	asn_set_add(&(m->content.list), pMember);
+	_add_parameter(m, _parameter_new(m, n, strlen(n), v, vs));
 }
 
 void
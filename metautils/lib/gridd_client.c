@@ -24,6 +24,7 @@ License along with this library.
 #include <string.h>
 #include <strings.h>
 #include <errno.h>
+#include <poll.h>
 #include <sys/types.h>
 
 #include "metautils.h"
@@ -36,6 +37,21 @@ License along with this library.
 # define EVENT_BUFFER_SIZE 2048
 #endif
 
+/* How many idle connections are kept for each target, and overall */
+#ifndef GRIDC_CNX_MAX_PER_TARGET
+# define GRIDC_CNX_MAX_PER_TARGET 8
+#endif
+
+#ifndef GRIDC_CNX_MAX
+# define GRIDC_CNX_MAX 256
+#endif
+
+/* How long (in microseconds) a connection may stay idle in the pool. The
+ * services close theirs after 5 minutes, this must remain below. */
+#ifndef GRIDC_CNX_IDLE_MAX
+# define GRIDC_CNX_IDLE_MAX (30 * G_TIME_SPAN_SECOND)
+#endif
+
 enum client_step_e
 {
 	NONE = 0,
@@ -76,6 +92,7 @@ struct gridd_client_s
 	enum client_step_e step : 16;
 	gboolean keepalive : 8;
 	gboolean forbid_redirect : 8;
+	gboolean reused : 8;
 
 	gchar orig_url[URL_MAXLEN];
 	gchar url[URL_MAXLEN];
@@ -86,6 +103,7 @@ static GError* _client_connect_url(struct gridd_client_s *client, const gchar *u
 static GError* _client_request(struct gridd_client_s *client, GByteArray *req,
 		gpointer ctx, client_on_reply cb);
 static gboolean _client_expired(struct gridd_client_s *client, gint64 now);
+static gint64 _client_deadline(struct gridd_client_s *client);
 static gboolean _client_finished(struct gridd_client_s *c);
 static const gchar* _client_url(struct gridd_client_s *client);
 static int _client_get_fd(struct gridd_client_s *client);
@@ -122,6 +140,7 @@ struct gridd_client_vtable_s VTABLE_CLIENT =
 	_client_set_keepalive,
 	_client_set_timeout,
 	_client_expired,
+	_client_deadline,
 	_client_finished,
 	_client_start,
 	_client_react,
@@ -163,11 +182,152 @@ _connect(const gchar *url, GError **err)
 	return fd;
 }
 
+/* Idle connections --------------------------------------------------------- */
+
+/* The connections left open after a complete reply are kept, per target,
+ * for the next client that connects to the same target. The most recent
+ * are reused first, the oldest are closed when the pool is full. */
+
+struct cnx_idle_s
+{
+	int fd;
+	gint64 since;
+};
+
+static GMutex cnx_lock;
+static GHashTable *cnx_idle = NULL;
+static guint cnx_idle_count = 0;
+static struct gridd_client_cnx_stats_s cnx_stats = {0};
+
+static void
+_cnx_queue_free(GQueue *q)
+{
+	struct cnx_idle_s *c;
+	while (NULL != (c = g_queue_pop_head(q))) {
+		metautils_pclose(&c->fd);
+		g_free(c);
+	}
+	g_queue_free(q);
+}
+
+/* An idle connection has nothing to read: if readable, it is either closed
+ * by the peer or out of sync. */
+static gboolean
+_cnx_alive(int fd)
+{
+	struct pollfd pfd = {fd, POLLIN, 0};
+	return 0 == metautils_syscall_poll(&pfd, 1, 0);
+}
+
+static int
+_cnx_take(const gchar *url)
+{
+	GArray *dead = g_array_new(FALSE, FALSE, sizeof(int));
+	const gint64 now = oio_ext_monotonic_time();
+	int fd = -1;
+
+	g_mutex_lock(&cnx_lock);
+	GQueue *q = cnx_idle ? g_hash_table_lookup(cnx_idle, url) : NULL;
+	while (q && fd < 0 && !g_queue_is_empty(q)) {
+		struct cnx_idle_s *c = g_queue_pop_head(q);
+		-- cnx_idle_count;
+		if (now - c->since < GRIDC_CNX_IDLE_MAX && _cnx_alive(c->fd))
+			fd = c->fd;
+		else {
+			g_array_append_val(dead, c->fd);
+			++ cnx_stats.dropped;
+		}
+		g_free(c);
+	}
+	if (fd >= 0)
+		++ cnx_stats.reused;
+	else
+		++ cnx_stats.connected;
+	g_mutex_unlock(&cnx_lock);
+
+	for (guint i = 0; i < dead->len ;++i)
+		metautils_pclose(&g_array_index(dead, int, i));
+	g_array_free(dead, TRUE);
+	return fd;
+}
+
+static void
+_cnx_give(const gchar *url, int fd)
+{
+	GArray *dead = g_array_new(FALSE, FALSE, sizeof(int));
+	const gint64 now = oio_ext_monotonic_time();
+
+	g_mutex_lock(&cnx_lock);
+	if (!cnx_idle)
+		cnx_idle = g_hash_table_new_full(g_str_hash, g_str_equal,
+				g_free, (GDestroyNotify)_cnx_queue_free);
+	GQueue *q = g_hash_table_lookup(cnx_idle, url);
+	if (!q) {
+		q = g_queue_new();
+		g_hash_table_insert(cnx_idle, g_strdup(url), q);
+	}
+
+	/* Purge the expired connections, and make room for the new one */
+	for (struct cnx_idle_s *c; NULL != (c = g_queue_peek_tail(q)) ;) {
+		if (q->length < GRIDC_CNX_MAX_PER_TARGET
+				&& now - c->since < GRIDC_CNX_IDLE_MAX)
+			break;
+		g_queue_pop_tail(q);
+		-- cnx_idle_count;
+		g_array_append_val(dead, c->fd);
+		++ cnx_stats.dropped;
+		g_free(c);
+	}
+
+	if (cnx_idle_count < GRIDC_CNX_MAX) {
+		struct cnx_idle_s *c = g_malloc(sizeof(struct cnx_idle_s));
+		c->fd = fd;
+		c->since = now;
+		g_queue_push_head(q, c);
+		++ cnx_idle_count;
+	} else {
+		g_array_append_val(dead, fd);
+		++ cnx_stats.dropped;
+	}
+	g_mutex_unlock(&cnx_lock);
+
+	for (guint i = 0; i < dead->len ;++i)
+		metautils_pclose(&g_array_index(dead, int, i));
+	g_array_free(dead, TRUE);
+}
+
+void
+gridd_client_cnx_stats(struct gridd_client_cnx_stats_s *out)
+{
+	EXTRA_ASSERT(out != NULL);
+	g_mutex_lock(&cnx_lock);
+	*out = cnx_stats;
+	out->idle = cnx_idle_count;
+	g_mutex_unlock(&cnx_lock);
+}
+
+void
+gridd_client_cnx_flush(void)
+{
+	g_mutex_lock(&cnx_lock);
+	GHashTable *idle = cnx_idle;
+	cnx_idle = NULL;
+	cnx_idle_count = 0;
+	g_mutex_unlock(&cnx_lock);
+	if (idle)
+		g_hash_table_destroy(idle);
+}
+
+/* ------------------------------------------------------------------------- */
+
 static GError*
 _client_connect(struct gridd_client_s *client)
 {
 	GError *err = NULL;
-	client->fd = _connect(client->url, &err);
+	client->fd = _cnx_take(client->url);
+	client->reused = BOOL(client->fd >= 0);
+	if (client->fd < 0)
+		client->fd = _connect(client->url, &err);
 
 	if (client->fd < 0) {
 		EXTRA_ASSERT(err != NULL);
@@ -211,6 +371,20 @@ _client_reset_cnx(struct gridd_client_s *client)
 	client->step = NONE;
 }
 
+/* The reply has been entirely read, the connection may serve another
+ * request */
+static void
+_client_release_cnx(struct gridd_client_s *client)
+{
+	if (client->fd >= 0) {
+		if (client->url[0])
+			_cnx_give(client->url, client->fd);
+		else
+			metautils_pclose(&(client->fd));
+		client->fd = -1;
+	}
+}
+
 static void
 _client_reset_target(struct gridd_client_s *client)
 {
@@ -254,7 +428,7 @@ _client_manage_reply(struct gridd_client_s *client, MESSAGE reply)
 		client->step = (status==CODE_FINAL_OK) ? STATUS_OK : REP_READING_SIZE;
 		if (client->step == STATUS_OK) {
 			if (!client->keepalive)
-				metautils_pclose(&(client->fd));
+				_client_release_cnx(client);
 		}
 		if (client->on_reply) {
 			if (!client->on_reply(client->ctx, reply))
@@ -266,7 +440,8 @@ _client_manage_reply(struct gridd_client_s *client, MESSAGE reply)
 	if (status == CODE_REDIRECT && !client->forbid_redirect) {
 		/* Reset the context */
 		_client_reset_reply(client);
-		_client_reset_cnx(client);
+		_client_release_cnx(client);
+		client->step = NONE;
 		client->sent_bytes = 0;
 
 		if ((++ client->nb_redirects) > 3)
@@ -285,8 +460,10 @@ _client_manage_reply(struct gridd_client_s *client, MESSAGE reply)
 	else
 		err = NEWERROR(status, "%s", message);
 
-	if (!client->keepalive)
-		_client_reset_cnx(client);
+	if (!client->keepalive) {
+		_client_release_cnx(client);
+		client->step = NONE;
+	}
 	_client_reset_reply(client);
 	return err;
 }
@@ -331,9 +508,18 @@ _client_manage_event_in_buffer(struct gridd_client_s *client, guint8 *d, gsize d
 					client->request->data + client->sent_bytes,
 					client->request->len - client->sent_bytes);
 
-			if (rc < 0)
-				return (errno == EINTR || errno == EAGAIN) ? NULL :
-					NEWERROR(errno, "write error (%s)", strerror(errno));
+			if (rc < 0) {
+				if (errno == EINTR || errno == EAGAIN)
+					return NULL;
+				/* The peer closed the idle connection while it was reused,
+				 * nothing has reached it yet, try on a new connection */
+				if (client->reused && !client->sent_bytes
+						&& (errno == EPIPE || errno == ECONNRESET)) {
+					metautils_pclose(&(client->fd));
+					return _client_connect(client);
+				}
+				return NEWERROR(errno, "write error (%s)", strerror(errno));
+			}
 			if (rc > 0)
 				client->sent_bytes += rc;
 
@@ -521,6 +707,8 @@ _client_free(struct gridd_client_s *client)
 	EXTRA_ASSERT(client != NULL);
 	EXTRA_ASSERT(client->abstract.vtable == &VTABLE_CLIENT);
 
+	if (client->step == STATUS_OK)
+		_client_release_cnx(client);
 	_client_reset_reply(client);
 	_client_reset_request(client);
 	_client_reset_cnx(client);
@@ -688,6 +876,38 @@ _client_expired(struct gridd_client_s *client, gint64 now)
 	return FALSE;
 }
 
+static gint64
+_client_deadline(struct gridd_client_s *client)
+{
+	EXTRA_ASSERT(client != NULL);
+	EXTRA_ASSERT(client->abstract.vtable == &VTABLE_CLIENT);
+	gint64 deadline = 0;
+	switch (client->step) {
+		case NONE:
+			return 0;
+		case CONNECTING:
+			return client->tv_start + G_TIME_SPAN_SECOND + 1;
+		case REQ_SENDING:
+		case REP_READING_SIZE:
+		case REP_READING_DATA:
+			/* the first instant _client_expired() is TRUE */
+			if (client->delay_step > 0)
+				deadline = client->tv_step + client->delay_step + 1;
+			if (client->delay_overall > 0) {
+				gint64 d = client->tv_start + client->delay_overall + 1;
+				if (!deadline || d < deadline)
+					deadline = d;
+			}
+			return deadline;
+		case STATUS_OK:
+		case STATUS_FAILED:
+			return 0;
+	}
+
+	g_assert_not_reached();
+	return 0;
+}
+
 static gboolean
 _client_expire(struct gridd_client_s *client, gint64 now)
 {
@@ -894,6 +1114,12 @@ gridd_client_expired(struct gridd_client_s *self, gint64 now)
 	GRIDD_CALL(self,expired)(self,now);
 }
 
+gint64
+gridd_client_deadline(struct gridd_client_s *self)
+{
+	GRIDD_CALL(self,deadline)(self);
+}
+
 gboolean
 gridd_client_finished (struct gridd_client_s *self)
 {
@@ -82,6 +82,10 @@ struct gridd_client_vtable_s
 	// Returns if the client's last change is older than 'now'
 	gboolean (*expired) (struct gridd_client_s *c, gint64 now);
 
+	// Returns the monotonic time (in microseconds) at which expired() turns
+	// TRUE, or 0 if the client cannot expire.
+	gint64 (*deadline) (struct gridd_client_s *c);
+
 	// Returns FALSE if the client is still expecting events.
 	gboolean (*finished) (struct gridd_client_s *c);
 
@@ -117,6 +121,7 @@ GError * gridd_client_set_fd(struct gridd_client_s *self, int fd);
 void gridd_client_set_keepalive(struct gridd_client_s *self, gboolean on);
 void gridd_client_set_timeout (struct gridd_client_s *self, gdouble seconds);
 gboolean gridd_client_expired(struct gridd_client_s *self, gint64 now);
+gint64 gridd_client_deadline(struct gridd_client_s *self);
 gboolean gridd_client_finished (struct gridd_client_s *self);
 gboolean gridd_client_start (struct gridd_client_s *self);
 gboolean gridd_client_expire (struct gridd_client_s *self, gint64 now);
@@ -129,6 +134,23 @@ struct gridd_client_s * gridd_client_create_empty(void);
 /* Only works with clients of the default type */
 void gridd_client_no_redirect (struct gridd_client_s *c);
 
+/* The clients of the default type share a process-wide pool of idle
+ * connections, per target, bounded in size and in idle time. A connection
+ * goes back to the pool once a reply has been entirely read, and is checked
+ * before it is reused. */
+struct gridd_client_cnx_stats_s
+{
+	guint64 connected; /* new connections */
+	guint64 reused;    /* connections taken from the pool */
+	guint64 dropped;   /* idle connections closed (dead, expired, pool full) */
+	guint idle;        /* connections currently in the pool */
+};
+
+void gridd_client_cnx_stats (struct gridd_client_cnx_stats_s *out);
+
+/* Close all the idle connections */
+void gridd_client_cnx_flush (void);
+
 /* ------------------------------------------------------------------------- */
 
 struct gridd_client_factory_vtable_s
@@ -37,7 +37,8 @@ struct gridd_client_pool_s
 	struct event_client_s **active_clients;
 	GAsyncQueue *pending_clients;
 
-	gint64 last_timeout_check;
+	/* monotonic time (µs) before which no active client expires, or 0 */
+	gint64 next_deadline;
 
 	int fdmon;
 	/* notifications */
@@ -138,6 +139,14 @@ fd_consume_input(int fd)
 	(void) metautils_syscall_read(fd, data, sizeof(data));
 }
 
+static void
+_pool_track_deadline(struct gridd_client_pool_s *pool, struct gridd_client_s *c)
+{
+	gint64 deadline = gridd_client_deadline(c);
+	if (deadline > 0 && (!pool->next_deadline || deadline < pool->next_deadline))
+		pool->next_deadline = deadline;
+}
+
 static int
 event_client_monitor(struct gridd_client_pool_s *pool, struct event_client_s *mc)
 {
@@ -168,6 +177,7 @@ event_client_monitor(struct gridd_client_pool_s *pool, struct event_client_s *mc
 
 	pool->active_count ++;
 	pool->active_clients[fd] = mc;
+	_pool_track_deadline(pool, mc->client);
 	return 1;
 }
 
@@ -183,6 +193,21 @@ event_client_free(struct event_client_s *ec)
 	g_free (ec);
 }
 
+/* Free a client that won't run to its end, with an error set so that its
+ * on_end hook doesn't mistake it for a success. */
+static void
+event_client_abort(struct event_client_s *ec, int code, const char *msg)
+{
+	if (!ec)
+		return;
+	if (ec->client) {
+		GError *err = NEWERROR(code, "%s", msg);
+		gridd_client_fail(ec->client, err);
+		g_error_free(err);
+	}
+	event_client_free(ec);
+}
+
 static void
 _destroy(struct gridd_client_pool_s *pool)
 {
@@ -202,7 +227,7 @@ _destroy(struct gridd_client_pool_s *pool)
 	if (pool->pending_clients) {
 		struct event_client_s *ec;
 		while (NULL != (ec = g_async_queue_try_pop(pool->pending_clients)))
-			event_client_free(ec);
+			event_client_abort(ec, CODE_UNAVAILABLE, "Pool closed");
 		g_async_queue_unref(pool->pending_clients);
 		pool->pending_clients = NULL;
 	}
@@ -212,7 +237,7 @@ _destroy(struct gridd_client_pool_s *pool)
 			struct event_client_s *ec = pool->active_clients[i];
 			pool->active_clients[i] = NULL;
 			if (ec)
-				event_client_free(ec);
+				event_client_abort(ec, CODE_UNAVAILABLE, "Pool closed");
 		}
 		g_free(pool->active_clients);
 		pool->active_clients = NULL;
@@ -231,16 +256,21 @@ _pool_unmonitor(struct gridd_client_pool_s *pool, int fd)
 	pool->active_clients[fd] = NULL;
 }
 
+/* Only runs when the earliest deadline met at the last check (or since, when
+ * monitoring a client) is reached. The deadlines only move forward when the
+ * clients progress, so that bound is never late. */
 static void
 _manage_timeouts(struct gridd_client_pool_s *pool)
 {
-	if (pool->active_count <= 0)
+	if (pool->active_count <= 0) {
+		pool->next_deadline = 0;
 		return;
+	}
 
 	gint64 now = oio_ext_monotonic_time ();
-	if (now - pool->last_timeout_check > G_TIME_SPAN_SECOND)
+	if (!pool->next_deadline || now < pool->next_deadline)
 		return;
-	pool->last_timeout_check = now;
+	pool->next_deadline = 0;
 
 	for (int i=0; i<pool->active_clients_size ;i++) {
 		struct event_client_s *ec;
@@ -250,10 +280,14 @@ _manage_timeouts(struct gridd_client_pool_s *pool)
 		EXTRA_ASSERT(ec->client != NULL);
 		EXTRA_ASSERT(i == gridd_client_fd(ec->client));
 
-		if (gridd_client_expire (ec->client, now)) {
+		/* expire() marks the client as failed but always returns FALSE */
+		gridd_client_expire (ec->client, now);
+		if (gridd_client_finished (ec->client)) {
 			GRID_INFO("EXPIRED Client fd=%d [%s]", i, gridd_client_url(ec->client));
 			_pool_unmonitor(pool, i);
 			event_client_free(ec);
+		} else {
+			_pool_track_deadline(pool, ec->client);
 		}
 	}
 
@@ -296,7 +330,7 @@ _manage_requests(struct gridd_client_pool_s *pool)
 			event_client_free(ec);
 		}
 		else if (!event_client_monitor(pool, ec))
-			event_client_free(ec);
+			event_client_abort(ec, CODE_NETWORK_ERROR, "Monitoring error");
 	}
 }
 
@@ -311,17 +345,19 @@ _manage_one_event(struct gridd_client_pool_s *pool, int fd, int evt)
 	EXTRA_ASSERT(ec->client != NULL);
 	EXTRA_ASSERT(fd == gridd_client_fd(ec->client));
 
-	if ((evt & EPOLLERR) || (evt & EPOLLHUP)) {
+	/* A peer that replied then closed raises HUP along with IN: the reply
+	 * must still be read. */
+	if ((evt & EPOLLERR) || ((evt & EPOLLHUP) && !(evt & EPOLLIN))) {
 		GRID_DEBUG("%s CLIENT [%s] fd=%d cnx error", __FUNCTION__,
 				gridd_client_url(ec->client), gridd_client_fd(ec->client));
-		event_client_free(ec);
+		event_client_abort(ec, ERRCODE_CONN_RESET, "Connection error");
 	}
 	else {
 		gridd_client_react(ec->client);
 		if (gridd_client_finished(ec->client))
 			event_client_free(ec);
 		else if (!event_client_monitor(pool, ec))
-			event_client_free(ec);
+			event_client_abort(ec, CODE_NETWORK_ERROR, "Monitoring error");
 	}
 }
 
@@ -344,8 +380,19 @@ _round(struct gridd_client_pool_s *pool, time_t sec)
 	EXTRA_ASSERT(pool->vtable == &VTABLE);
 	EXTRA_ASSERT(pool->fdmon >= 0);
 
+	/* Wake up in time for the earliest deadline, rounded up to the next
+	 * millisecond so that the wait doesn't end just before it. */
+	gint64 ms = sec * 1000L;
+	if (pool->next_deadline) {
+		gint64 wait = pool->next_deadline - oio_ext_monotonic_time ();
+		if (wait <= 0)
+			ms = 0;
+		else
+			ms = MIN(ms, (wait + G_TIME_SPAN_MILLISECOND - 1) / G_TIME_SPAN_MILLISECOND);
+	}
+
 	struct epoll_event ev[MAX_ROUND];
-	int rc = epoll_wait(pool->fdmon, ev, MAX_ROUND, sec * 1000L);
+	int rc = epoll_wait(pool->fdmon, ev, MAX_ROUND, ms);
 
 	if (rc < 0 && errno != EINTR)
 		return NEWERROR(errno, "epoll_wait error: %s", strerror(errno));
@@ -368,7 +415,7 @@ _defer(struct gridd_client_pool_s *pool, struct event_client_s *ev)
 
 	if (pool->closed) {
 		GRID_INFO("Request dropped");
-		event_client_free(ev);
+		event_client_abort(ev, CODE_UNAVAILABLE, "Pool closed");
 	}
 	else {
 		guint8 c = 0;
@@ -396,3 +443,157 @@ _set_max(struct gridd_client_pool_s *pool, guint max)
 	pool->active_max = max - 3;
 }
 
+
+/* Asynchronous requests ---------------------------------------------------- */
+
+struct async_client_s
+{
+	struct event_client_s ec;
+	gridd_client_done_f done;
+	gpointer udata;
+};
+
+static void
+_async_on_end(struct async_client_s *ac)
+{
+	GError *err = gridd_client_error(ac->ec.client);
+	if (ac->done)
+		ac->done(ac->udata, err);
+	if (err)
+		g_error_free(err);
+}
+
+void
+gridd_client_pool_submit(struct gridd_client_pool_s *pool,
+		const char *target, GByteArray *req, gdouble timeout,
+		gpointer ctx, client_on_reply on_reply,
+		gridd_client_done_f done, gpointer udata)
+{
+	EXTRA_ASSERT(pool != NULL);
+	EXTRA_ASSERT(req != NULL);
+
+	struct async_client_s *ac = g_malloc0(sizeof(struct async_client_s));
+	ac->ec.client = gridd_client_create_empty();
+	ac->ec.on_end = (gridd_client_end_f) _async_on_end;
+	ac->done = done;
+	ac->udata = udata;
+
+	GError *err = NULL;
+	if (!target)
+		err = NEWERROR(CODE_INTERNAL_ERROR, "No target");
+	if (!err)
+		err = gridd_client_connect_url(ac->ec.client, target);
+	if (!err)
+		err = gridd_client_request(ac->ec.client, req, ctx, on_reply);
+	if (err) {
+		gridd_client_fail(ac->ec.client, err);
+		g_error_free(err);
+		event_client_free(&ac->ec);
+		return;
+	}
+
+	if (timeout > 0.0)
+		gridd_client_set_timeout(ac->ec.client, timeout);
+	gridd_client_pool_defer(pool, &ac->ec);
+}
+
+static gpointer
+_shared_worker(gpointer p)
+{
+	for (;;) {
+		GError *err = gridd_client_pool_round(p, 1);
+		if (err) {
+			GRID_WARN("Shared client pool error: (%d) %s", err->code, err->message);
+			g_clear_error(&err);
+			g_usleep(100 * G_TIME_SPAN_MILLISECOND);
+		}
+	}
+	return NULL;
+}
+
+struct gridd_client_pool_s *
+gridd_client_pool_shared(void)
+{
+	static volatile gsize inited = 0;
+	static struct gridd_client_pool_s *shared = NULL;
+	if (g_once_init_enter(&inited)) {
+		shared = gridd_client_pool_create();
+		g_assert(shared != NULL);
+		g_thread_unref(g_thread_new("clients", _shared_worker, shared));
+		g_once_init_leave(&inited, 1);
+	}
+	return shared;
+}
+
+struct pool_waiter_s
+{
+	GMutex lock;
+	GCond cond;
+	guint pending;
+};
+
+struct pool_call_s
+{
+	struct pool_waiter_s *waiter;
+	GError *err;
+};
+
+static void
+_call_done(struct pool_call_s *call, GError *err)
+{
+	struct pool_waiter_s *w = call->waiter;
+	g_mutex_lock(&w->lock);
+	if (err)
+		call->err = g_error_copy(err);
+	if (!--w->pending)
+		g_cond_signal(&w->cond);
+	g_mutex_unlock(&w->lock);
+}
+
+void
+gridd_client_pool_exec_many(gchar **targets, GByteArray *req,
+		gdouble timeout, gpointer ctx, client_on_reply on_reply, GError **errv)
+{
+	EXTRA_ASSERT(targets != NULL);
+	EXTRA_ASSERT(errv != NULL);
+
+	const guint count = g_strv_length(targets);
+	if (!count)
+		return;
+
+	struct gridd_client_pool_s *pool = gridd_client_pool_shared();
+	struct pool_waiter_s w;
+	struct pool_call_s *calls = g_malloc0(count * sizeof(struct pool_call_s));
+	g_mutex_init(&w.lock);
+	g_cond_init(&w.cond);
+	w.pending = count;
+
+	for (guint i = 0; i < count; ++i) {
+		calls[i].waiter = &w;
+		gridd_client_pool_submit(pool, targets[i], req, timeout, ctx, on_reply,
+				(gridd_client_done_f) _call_done, calls + i);
+	}
+
+	g_mutex_lock(&w.lock);
+	while (w.pending > 0)
+		g_cond_wait(&w.cond, &w.lock);
+	g_mutex_unlock(&w.lock);
+
+	for (guint i = 0; i < count; ++i)
+		errv[i] = calls[i].err;
+	g_free(calls);
+	g_cond_clear(&w.cond);
+	g_mutex_clear(&w.lock);
+}
+
+GError *
+gridd_client_pool_exec(const char *target, GByteArray *req, gdouble timeout,
+		gpointer ctx, client_on_reply on_reply)
+{
+	GError *err = NULL;
+	gchar *targets[2] = {(gchar*)target, NULL};
+	if (!target)
+		return NEWERROR(CODE_INTERNAL_ERROR, "No target");
+	gridd_client_pool_exec_many(targets, req, timeout, ctx, on_reply, &err);
+	return err;
+}
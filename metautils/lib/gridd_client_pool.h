@@ -21,6 +21,7 @@ License along with this library.
 # define OIO_SDS__metautils__lib__gridd_client_pool_h 1
 
 # include <glib.h>
+# include "gridd_client.h"
 
 struct gridd_client_s;
 struct election_manager_s;
@@ -82,4 +83,35 @@ struct abstract_client_pool_s
 
 struct gridd_client_pool_s * gridd_client_pool_create(void);
 
+/* Asynchronous requests ---------------------------------------------------- */
+
+/* Called once per request, in the pool's thread, with the final error of the
+ * request (NULL on success). The error belongs to the caller of the hook. */
+typedef void (*gridd_client_done_f) (gpointer udata, GError *err);
+
+/* Start sending <req> (not consumed) to <target> through <pool>. <on_reply>
+ * is called in the pool's thread for each reply, then <done>. On immediate
+ * errors (bad target...), <done> is called before the function returns. */
+void gridd_client_pool_submit(struct gridd_client_pool_s *pool,
+		const char *target, GByteArray *req, gdouble timeout,
+		gpointer ctx, client_on_reply on_reply,
+		gridd_client_done_f done, gpointer udata);
+
+/* A process-wide pool, lazily created and run by its own thread. All the
+ * requests submitted to it share a single event loop, whatever the number
+ * of the calling threads. */
+struct gridd_client_pool_s * gridd_client_pool_shared(void);
+
+/* Run <req> (not consumed) on each of <targets> in parallel through the
+ * shared pool, and wait for them all. <errv> must have room for as many
+ * errors as targets, it is filled with the error of each request. The reply
+ * callbacks are all run in the pool's thread, never concurrently. Must not
+ * be called from a reply callback. */
+void gridd_client_pool_exec_many(gchar **targets, GByteArray *req,
+		gdouble timeout, gpointer ctx, client_on_reply on_reply, GError **errv);
+
+/* Single-target variant of gridd_client_pool_exec_many() */
+GError * gridd_client_pool_exec(const char *target, GByteArray *req,
+		gdouble timeout, gpointer ctx, client_on_reply on_reply);
+
 #endif /*OIO_SDS__metautils__lib__gridd_client_pool_h*/
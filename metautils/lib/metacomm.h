@@ -84,6 +84,13 @@ MESSAGE message_unmarshall(const guint8 *buf, gsize len, GError ** error);
 /** Calls message_marshall_gba() then metautils_message_destroy() on 'm'. */
 GByteArray* message_marshall_gba_and_clean(MESSAGE m);
 
+/** Serializes the message as if it had a body of 'body_len' bytes, but
+ * without the body itself, that must be sent right after the result. This
+ * works because the body is the last field of the message. 'm' must have
+ * no body. */
+GByteArray* message_marshall_gba_envelope(MESSAGE m, gsize body_len,
+		GError **err);
+
 typedef gint (body_decoder_f)(GSList **r, const void *b, gsize l, GError **e);
 
 /** Adds a new custom field in the list of the message. Now check is made to
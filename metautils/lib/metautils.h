@@ -39,6 +39,7 @@ License along with this library.
 # include <metautils/lib/metautils_sockets.h>
 # include <metautils/lib/metautils_containers.h>
 # include <metautils/lib/metautils_gba.h>
+# include <metautils/lib/metautils_arena.h>
 # include <metautils/lib/metautils_resolv.h>
 # include <metautils/lib/metautils_hashstr.h>
 # include <metautils/lib/metautils_task.h>
@@ -65,5 +66,6 @@ License along with this library.
 # include <metautils/lib/metacomm.h>
 # include <metautils/lib/gridd_client.h>
 # include <metautils/lib/gridd_client_ext.h>
+# include <metautils/lib/gridd_client_pool.h>
 
 #endif /*OIO_SDS__metautils__lib__metautils_h*/
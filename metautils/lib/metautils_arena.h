@@ -0,0 +1,51 @@
+/*
+OpenIO SDS metautils
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#ifndef OIO_SDS__metautils__lib__metautils_arena_h
+# define OIO_SDS__metautils__lib__metautils_arena_h 1
+
+#include <glib.h>
+
+/* A bump allocator for the many small and short-lived allocations of a
+ * single task (e.g. the parts of a decoded message). Nothing is freed on
+ * its own, everything is released at once with the arena. Not
+ * thread-safe. */
+
+struct oio_arena_s;
+
+/* The arena and its first block of <block_size> bytes come from a single
+ * allocation. */
+struct oio_arena_s * oio_arena_create(gsize block_size);
+
+void oio_arena_destroy(struct oio_arena_s *arena);
+
+/* Aligned as malloc() would. An allocation that does not fit in the
+ * current block gets a new block, or a block of its own if it is bigger
+ * than a quarter of the usual block size. */
+gpointer oio_arena_alloc(struct oio_arena_s *arena, gsize size);
+
+gpointer oio_arena_alloc0(struct oio_arena_s *arena, gsize size);
+
+/* Copies <len> bytes and appends a trailing NUL */
+gpointer oio_arena_memdup0(struct oio_arena_s *arena, gconstpointer src,
+		gsize len);
+
+/* How many blocks have been allocated, the first included */
+guint oio_arena_count_blocks(struct oio_arena_s *arena);
+
+#endif /*OIO_SDS__metautils__lib__metautils_arena_h*/
@@ -56,6 +56,10 @@ void metautils_gba_unref(gpointer p);
 /** Convert the content to its hexadecimal representation */
 GString* metautils_gba_to_hexgstr(GString *gstr, GByteArray *gba);
 
+/** Appends the hexadecimal representation of the content as a JSON string,
+ * or null when <gba> is NULL */
+void metautils_gba_to_json(GString *gstr, GByteArray *gba);
+
 void gba_pool_clean(GSList **pool);
 
 GByteArray * gba_poolify(GSList **pool, GByteArray *gba);
@@ -58,6 +58,7 @@ License along with this library.
 
 #define NAME_MSGNAME_METAREPLY         "RP"
 
+#define NAME_MSGKEY_ACCEPT_ENCODING    "ACCEPT_ENCODING"
 #define NAME_MSGKEY_ACCOUNT            "ACCT"
 #define NAME_MSGKEY_ACTION             "ACTION"
 #define NAME_MSGKEY_ALLOWUPDATE        "ALLOW_UPDATE"
@@ -76,9 +77,11 @@ License along with this library.
 #define NAME_MSGKEY_CONTENTID          "CI"
 #define NAME_MSGKEY_COPY               "COPY"
 #define NAME_MSGKEY_COUNT              "COUNT"
+#define NAME_MSGKEY_DELIMITER          "DELIM"
 #define NAME_MSGKEY_DISTANCE           "DIST"
 #define NAME_MSGKEY_DRYRUN             "DRYRUN"
 #define NAME_MSGKEY_DST                "DST"
+#define NAME_MSGKEY_ENCODING           "ENCODING"
 #define NAME_MSGKEY_EVENT              "E"
 #define NAME_MSGKEY_FLAGS              "FLAGS"
 #define NAME_MSGKEY_FLUSH              "FLUSH"
@@ -121,6 +124,8 @@ License along with this library.
 #define NAME_MSGKEY_VERSION            "VER"
 
 #define NAME_MSGKEY_PREFIX_PROPERTY    "P:"
+#define NAME_MSGKEY_PREFIX_COMMON      "CP:"
+#define NAME_MSGKEY_PREFIX_STATUS      "S:"
 
 enum {
 	SCORE_UNSET = -2,
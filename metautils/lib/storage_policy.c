@@ -538,6 +538,24 @@ storage_class_is_satisfied2(const struct storage_class_s *wsc,
 	return FALSE;
 }
 
+/* The default algorithm is not mentioned, so that the chunk methods of the
+ * existing contents do not change */
+static void
+_append_chunk_hash(GString *method, const struct data_security_s *datasec,
+		char sep)
+{
+	enum oio_hash_algo_e algo = OIO_HASH_MD5;
+	const char *name = data_security_get_param(datasec, DS_KEY_HASH);
+	if (!name)
+		return;
+	if (!oio_hash_algo_parse(name, &algo))
+		GRID_WARN("Unknown chunk hash [%s] in data security [%s], MD5 used",
+				name, data_security_get_name(datasec));
+	if (algo != OIO_HASH_MD5)
+		g_string_append_printf(method, "%c%s=%s", sep, DS_KEY_HASH,
+				oio_hash_algo_name(algo));
+}
+
 static GString *
 _rain_policy_to_chunk_method(const struct data_security_s *datasec) {
 	GString *result = g_string_new("plain/rain?");
@@ -548,6 +566,7 @@ _rain_policy_to_chunk_method(const struct data_security_s *datasec) {
 
 	g_string_append_printf(result, "algo=%s&k=%" G_GINT64_FORMAT
 			"&m=%" G_GINT64_FORMAT, algo, k, m);
+	_append_chunk_hash(result, datasec, '&');
 
 	return result;
 }
@@ -555,6 +574,7 @@ _rain_policy_to_chunk_method(const struct data_security_s *datasec) {
 GString *
 storage_policy_to_chunk_method(const struct storage_policy_s *sp)
 {
+	GString *result;
 	const struct data_security_s *datasec = storage_policy_get_data_security(sp);
 
 	switch (data_security_get_type(datasec)) {
@@ -562,7 +582,9 @@ storage_policy_to_chunk_method(const struct storage_policy_s *sp)
 			return _rain_policy_to_chunk_method(datasec);
 		case DS_NONE:
 		case DUPLI:
-			return g_string_new("plain/bytes");
+			result = g_string_new("plain/bytes");
+			_append_chunk_hash(result, datasec, '?');
+			return result;
 		default:
 			g_assert_not_reached();
 	}
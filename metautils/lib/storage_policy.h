@@ -26,6 +26,8 @@ License along with this library.
 #define DS_KEY_K "k"
 #define DS_KEY_M "m"
 #define DS_KEY_ALGO "algo"
+/* Algorithm of the chunk hashes (md5, sha256, xxh64), MD5 when absent */
+#define DS_KEY_HASH "hash"
 
 /* DATA TREATMENTS KEYS */
 #define DT_KEY_BLOCKSIZE "blocksize"
@@ -0,0 +1,142 @@
+/*
+OpenIO SDS metautils
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <string.h>
+
+#include "metautils.h"
+
+#define ARENA_ALIGN (2 * sizeof(void*))
+#define ARENA_ROUND(s) (((s) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+struct arena_block_s
+{
+	struct arena_block_s *next;
+	gsize size;
+	gsize used;
+};
+
+struct oio_arena_s
+{
+	struct arena_block_s *current; /* where the small allocations go */
+	struct arena_block_s *full;    /* the others, to be freed */
+	gsize block_size;
+	guint blocks;
+};
+
+#define ARENA_HEADER ARENA_ROUND(sizeof(struct oio_arena_s))
+#define BLOCK_HEADER ARENA_ROUND(sizeof(struct arena_block_s))
+#define BLOCK_DATA(b) (((guint8*)(b)) + BLOCK_HEADER)
+
+static struct arena_block_s *
+_block_init(guint8 *base, gsize size)
+{
+	struct arena_block_s *b = (struct arena_block_s*) base;
+	b->next = NULL;
+	b->size = size;
+	b->used = 0;
+	return b;
+}
+
+static struct arena_block_s *
+_block_new(struct oio_arena_s *arena, gsize size)
+{
+	arena->blocks ++;
+	return _block_init(g_malloc(BLOCK_HEADER + size), size);
+}
+
+static gboolean
+_block_is_first(struct oio_arena_s *arena, struct arena_block_s *b)
+{
+	return ((guint8*)b) == ((guint8*)arena) + ARENA_HEADER;
+}
+
+struct oio_arena_s *
+oio_arena_create(gsize block_size)
+{
+	block_size = ARENA_ROUND(MAX(block_size, 256));
+	guint8 *base = g_malloc(ARENA_HEADER + BLOCK_HEADER + block_size);
+	struct oio_arena_s *arena = (struct oio_arena_s*) base;
+	arena->current = _block_init(base + ARENA_HEADER, block_size);
+	arena->full = NULL;
+	arena->block_size = block_size;
+	arena->blocks = 1;
+	return arena;
+}
+
+void
+oio_arena_destroy(struct oio_arena_s *arena)
+{
+	if (!arena)
+		return;
+	if (!_block_is_first(arena, arena->current))
+		g_free(arena->current);
+	for (struct arena_block_s *b = arena->full, *next; b ;b = next) {
+		next = b->next;
+		if (!_block_is_first(arena, b))
+			g_free(b);
+	}
+	g_free(arena);
+}
+
+gpointer
+oio_arena_alloc(struct oio_arena_s *arena, gsize size)
+{
+	EXTRA_ASSERT(arena != NULL);
+	size = ARENA_ROUND(MAX(size, 1));
+
+	struct arena_block_s *b = arena->current;
+	if (b->size - b->used < size) {
+		if (size > arena->block_size / 4) {
+			b = _block_new(arena, size);
+			b->next = arena->full;
+			arena->full = b;
+		} else {
+			b->next = arena->full;
+			arena->full = b;
+			b = arena->current = _block_new(arena, arena->block_size);
+		}
+	}
+
+	guint8 *p = BLOCK_DATA(b) + b->used;
+	b->used += size;
+	return p;
+}
+
+gpointer
+oio_arena_alloc0(struct oio_arena_s *arena, gsize size)
+{
+	gpointer p = oio_arena_alloc(arena, size);
+	memset(p, 0, size);
+	return p;
+}
+
+gpointer
+oio_arena_memdup0(struct oio_arena_s *arena, gconstpointer src, gsize len)
+{
+	guint8 *p = oio_arena_alloc(arena, len + 1);
+	if (len)
+		memcpy(p, src, len);
+	p[len] = 0;
+	return p;
+}
+
+guint
+oio_arena_count_blocks(struct oio_arena_s *arena)
+{
+	return arena ? arena->blocks : 0;
+}
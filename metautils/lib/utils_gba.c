@@ -168,6 +168,15 @@ metautils_gba_to_hexgstr(GString *gstr, GByteArray *gba)
 	return gstr;
 }
 
+void
+metautils_gba_to_json(GString *gstr, GByteArray *gba)
+{
+	if (!gba)
+		oio_json_append_hex(gstr, NULL, 0);
+	else
+		oio_json_append_hex(gstr, gba->len ? gba->data : (guint8*)"", gba->len);
+}
+
 void
 gba_pool_clean(GSList **pool)
 {
@@ -207,8 +207,12 @@ action_cache_status (struct req_args_s *args)
 		"\"count\":%" G_GINT64_FORMAT ",\"max\":%u,\"ttl\":%lu},",
 		s.csm0.count, s.csm0.max, s.csm0.ttl);
 	g_string_append_printf (gstr, " \"meta1\":{"
-		"\"count\":%" G_GINT64_FORMAT ",\"max\":%u,\"ttl\":%lu}",
+		"\"count\":%" G_GINT64_FORMAT ",\"max\":%u,\"ttl\":%lu},",
 		s.services.count, s.services.max, s.services.ttl);
+	g_string_append_printf (gstr, " \"m1map\":{"
+		"\"version\":\"%016" G_GINT64_MODIFIER "x\",\"prefixes\":%u,"
+		"\"sets\":%u,\"loaded\":%lu}",
+		s.m1map.version, s.m1map.assigned, s.m1map.sets, s.m1map.loaded);
 	g_string_append_c (gstr, '}');
 	return _reply_success_json (args, gstr);
 }
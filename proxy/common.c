@@ -159,12 +159,10 @@ _qualify_service_url (gconstpointer p)
 }
 
 GError *
-_resolve_service_and_do (const char *t, gint64 seq, struct oio_url_s *u,
-		GError * (*hook) (struct meta1_service_url_s *m1u, gboolean *next))
+_resolve_service (const char *t, struct oio_url_s *u, gchar ***out)
 {
 	gchar **uv = NULL;
 	GError *err = NULL;
-	guint failures = 0;
 
 	if (*t == '#')
 		err = hc_resolve_reference_directory (resolver, u, &uv);
@@ -178,50 +176,65 @@ _resolve_service_and_do (const char *t, gint64 seq, struct oio_url_s *u,
 		return err;
 	}
 
-	if (!*uv)
-		err = NEWERROR (CODE_CONTAINER_NOTFOUND, "No service located");
-	else {
-		/* just consider the URL part. The resolver already pre-shuffled it. */
+	if (!*uv) {
+		g_strfreev (uv);
+		return NEWERROR (CODE_CONTAINER_NOTFOUND, "No service located");
+	}
 
-		gsize pivot = oio_ext_array_partition ((void**)uv, g_strv_length(uv),
-				_qualify_service_url);
-		if (pivot > 0 && !oio_dir_no_shuffle)
-			oio_ext_array_shuffle ((void**)uv, pivot);
+	/* just consider the URL part. The resolver already pre-shuffled it. */
+	gsize pivot = oio_ext_array_partition ((void**)uv, g_strv_length(uv),
+			_qualify_service_url);
+	if (pivot > 0 && !oio_dir_no_shuffle)
+		oio_ext_array_shuffle ((void**)uv, pivot);
 
-		for (gchar **pm2 = uv; *pm2; ++pm2) {
-			struct meta1_service_url_s *m1u = meta1_unpack_url (*pm2);
+	*out = uv;
+	return NULL;
+}
 
-			if (seq > 0 && seq != m1u->seq) {
-				meta1_service_url_clean (m1u);
-				continue;
-			}
-			if (*t == '#' && strcmp(t+1, m1u->srvtype)) {
-				meta1_service_url_clean (m1u);
-				continue;
-			}
+GError *
+_resolve_service_and_do (const char *t, gint64 seq, struct oio_url_s *u,
+		GError * (*hook) (struct meta1_service_url_s *m1u, gboolean *next))
+{
+	gchar **uv = NULL;
+	guint failures = 0;
 
-			gboolean next = FALSE;
-			err = hook (m1u, &next);
-			if (err && CODE_IS_NETWORK_ERROR(err->code))
-				service_invalidate (m1u->host);
+	GError *err = _resolve_service (t, u, &uv);
+	if (NULL != err)
+		return err;
+
+	for (gchar **pm2 = uv; *pm2; ++pm2) {
+		struct meta1_service_url_s *m1u = meta1_unpack_url (*pm2);
+
+		if (seq > 0 && seq != m1u->seq) {
 			meta1_service_url_clean (m1u);
+			continue;
+		}
+		if (*t == '#' && strcmp(t+1, m1u->srvtype)) {
+			meta1_service_url_clean (m1u);
+			continue;
+		}
 
-			if (!err) {
-				if (!next)
-					goto exit;
-			} else {
-				++ failures;
-				GRID_DEBUG ("HOOK error : (%d) %s", err->code, err->message);
-				if (!next && !CODE_IS_NETWORK_ERROR(err->code)) {
-					g_prefix_error (&err, "HOOK error: ");
-					goto exit;
-				}
-				g_clear_error (&err);
+		gboolean next = FALSE;
+		err = hook (m1u, &next);
+		if (err && CODE_IS_NETWORK_ERROR(err->code))
+			service_invalidate (m1u->host);
+		meta1_service_url_clean (m1u);
+
+		if (!err) {
+			if (!next)
+				goto exit;
+		} else {
+			++ failures;
+			GRID_DEBUG ("HOOK error : (%d) %s", err->code, err->message);
+			if (!next && !CODE_IS_NETWORK_ERROR(err->code)) {
+				g_prefix_error (&err, "HOOK error: ");
+				goto exit;
 			}
+			g_clear_error (&err);
 		}
-		if (!err && failures == g_strv_length(uv))
-			err = NEWERROR (CODE_PLATFORM_ERROR, "No reply");
 	}
+	if (!err && failures == g_strv_length(uv))
+		err = NEWERROR (CODE_PLATFORM_ERROR, "No reply");
 exit:
 	g_strfreev (uv);
 	return err;
@@ -297,6 +310,79 @@ _gbav_request (const char *t, gint64 seq, struct oio_url_s *u,
 	return e;
 }
 
+struct req_deferred_s
+{
+	req_resume_f resume;
+	gpointer udata;
+	struct http_deferred_s *http;
+
+	struct oio_url_s *url;
+	guint32 flags;
+	gchar *reqid;
+	gint64 tv_start;
+	GQuark gq_count;
+	GQuark gq_time;
+};
+
+/* Accounted as handler_action() does for the actions replied at once */
+static enum http_rc_e
+_deferred_action_resume (struct req_deferred_s *d,
+		struct http_request_s *rq, struct http_reply_ctx_s *rp)
+{
+	oio_ext_set_reqid (d->reqid);
+
+	struct oio_requri_s ruri = {NULL, NULL, NULL, NULL};
+	oio_requri_parse (rq->req_uri, &ruri);
+
+	struct req_args_s args = {NULL,NULL,NULL, NULL,NULL, 0};
+	args.req_uri = &ruri;
+	args.url = d->url;
+	args.rq = rq;
+	args.rp = rp;
+	args.flags = d->flags;
+	enum http_rc_e rc = d->resume (&args, d->udata);
+	EXTRA_ASSERT(rc != HTTPRC_DEFERRED);
+	oio_requri_clear (&ruri);
+
+	gint64 spent = oio_ext_monotonic_time () - d->tv_start;
+	network_server_stat_request (rq->client->server,
+			d->gq_count, d->gq_time, spent);
+
+	oio_url_pclean (&d->url);
+	oio_str_clean (&d->reqid);
+	g_free (d);
+	oio_ext_set_reqid (NULL);
+	return rc;
+}
+
+enum http_rc_e
+_defer_action (struct req_args_s *args, req_resume_f resume, gpointer udata,
+		struct req_deferred_s **out)
+{
+	EXTRA_ASSERT(resume != NULL);
+	EXTRA_ASSERT(out != NULL);
+
+	struct req_deferred_s *d = g_malloc0 (sizeof (struct req_deferred_s));
+	d->resume = resume;
+	d->udata = udata;
+	d->url = oio_url_dup (args->url);
+	d->flags = args->flags;
+	d->reqid = g_strdup (oio_ext_get_reqid ());
+	d->tv_start = args->rq->client->time.evt_in;
+	d->gq_count = (*args->matchings)->last->gq_count;
+	d->gq_time = (*args->matchings)->last->gq_time;
+	d->http = args->rp->defer ((http_resume_f) _deferred_action_resume, d);
+	*out = d;
+	return HTTPRC_DEFERRED;
+}
+
+void
+_resume_action (struct req_deferred_s *d)
+{
+	EXTRA_ASSERT(d != NULL);
+	http_deferred_resume (d->http);
+}
+
 gboolean
 _request_has_flag (struct req_args_s *args, const char *header,
 		const char *flag)
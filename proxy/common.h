@@ -36,6 +36,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cluster/lib/gridcluster.h>
 #include <server/network_server.h>
 #include <server/stats_holder.h>
+#include <cache/cache.h>
 #include <resolver/hc_resolver.h>
 #include <meta1v2/meta1_remote.h>
 #include <meta2v2/meta2_macros.h>
@@ -135,6 +136,20 @@ struct sub_action_s {
 
 typedef enum http_rc_e (*req_handler_f) (struct req_args_s *);
 
+/* Replies a deferred action, in a worker thread. Of its <args>, all but the
+ * path matchings remain (so OPT() works, TOK() doesn't). */
+typedef enum http_rc_e (*req_resume_f) (struct req_args_s *args, gpointer udata);
+
+struct req_deferred_s;
+
+/* Lets the action reply later, without holding its worker: it returns the
+ * value of this call, then <resume> is called with <udata> once
+ * _resume_action() has been called (from any thread) on what it returned. */
+enum http_rc_e _defer_action (struct req_args_s *args,
+		req_resume_f resume, gpointer udata, struct req_deferred_s **out);
+
+void _resume_action (struct req_deferred_s *d);
+
 gchar * proxy_get_csurl (void);
 
 gboolean validate_namespace (const char * ns);
@@ -151,6 +166,10 @@ enum http_rc_e abstract_action (const char *tag, struct req_args_s*args, struct
 enum http_rc_e rest_action (struct req_args_s *args,
         enum http_rc_e (*handler) (struct req_args_s *, json_object *));
 
+/* The services of type <t> linked to <u>, in the order they should be
+ * tried. */
+GError * _resolve_service (const char *t, struct oio_url_s *u, gchar ***out);
+
 GError * _resolve_service_and_do (const char *t, gint64 seq, struct oio_url_s *u,
         GError * (*hook) (struct meta1_service_url_s *m1u, gboolean *next));
 
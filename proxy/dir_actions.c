@@ -55,7 +55,9 @@ _pack_and_freev_pairs (gchar ** pairs)
 		gchar *k = *pp;
 		gchar *sep = strchr (k, '=');
 		gchar *v = sep + 1;
-		g_string_append_printf (out, "\"%.*s\":\"%s\"", (int) (sep - k), k, v);
+		oio_json_append_stringn (out, k, sep - k);
+		g_string_append_c (out, ':');
+		oio_json_append_string (out, v);
 	}
 	g_string_append_c (out, '}');
 	g_strfreev (pairs);
@@ -103,6 +105,10 @@ _m1_action (struct oio_url_s *url, gchar ** m1v,
 		}
 		meta1_service_url_clean (m1);
 
+		if (err && (err->code == CODE_REDIRECT
+					|| err->code == CODE_RANGE_NOTFOUND))
+			hc_decache_prefix (resolver, url);
+
 		if (!err)
 			return NULL;
 		if (CODE_IS_NETWORK_ERROR (err->code) || err->code == CODE_REDIRECT)
@@ -131,41 +137,64 @@ _m1_locate_and_action (struct oio_url_s *url, GError * (*hook) ())
 	return err;
 }
 
+struct string_array_s
+{
+	GPtrArray *keys;
+	gboolean in_array;
+};
+
 static GError *
-decode_json_string_array (gchar *** pkeys, struct json_object *j)
+_on_string_array (gpointer u, enum oio_json_event_e evt,
+		enum oio_json_type_e type, const gchar *text, gsize len)
 {
-	gchar **keys = NULL;
-	GError *err = NULL;
+	struct string_array_s *ctx = u;
 
-	if (json_object_is_type (j, json_type_null)) {
-		*pkeys = g_malloc0(sizeof(void*));
+	if (!ctx->in_array) {
+		if (evt == OIO_JSON_EVT_SCALAR && type == OIO_JSON_TYPE_NULL)
+			return NULL;
+		if (evt != OIO_JSON_EVT_START || type != OIO_JSON_TYPE_ARRAY)
+			return BADREQ ("Invalid/Unexpected JSON");
+		ctx->in_array = TRUE;
 		return NULL;
 	}
 
-	// Parse the keys
-	if (!json_object_is_type (j, json_type_array))
-		return BADREQ ("Invalid/Unexpected JSON");
+	if (evt == OIO_JSON_EVT_END) {
+		ctx->in_array = FALSE;
+		return NULL;
+	}
+	if (evt != OIO_JSON_EVT_SCALAR || type != OIO_JSON_TYPE_STRING)
+		return BADREQ ("Invalid string at [%u]", ctx->keys->len + 1);
+	g_ptr_array_add (ctx->keys, g_strndup (text, len));
+	return NULL;
+}
 
-	GPtrArray *v = g_ptr_array_new ();
-	guint count = 0;
-	for (gint i = json_object_array_length (j); i > 0; --i) {
-		++count;
-		struct json_object *item =
-			json_object_array_get_idx (j, i - 1);
-		if (!json_object_is_type (item, json_type_string)) {
-			err = BADREQ ("Invalid string at [%u]", count);
-			break;
-		}
-		g_ptr_array_add (v, g_strdup (json_object_get_string (item)));
+/* Decodes the request body, a JSON array of strings, into a NULL-terminated
+ * array. An empty body and a null both give an empty array. */
+static GError *
+decode_json_string_array (gchar *** pkeys, GByteArray *body)
+{
+	GError *err = NULL;
+	struct string_array_s ctx = {
+		.keys = g_ptr_array_new_with_free_func (g_free),
+		.in_array = FALSE,
+	};
+
+	if (body && body->len > 0) {
+		struct oio_json_parser_s *p =
+			oio_json_parser_create (_on_string_array, &ctx);
+		err = oio_json_parser_feed (p, body->data, body->len);
+		if (!err)
+			err = oio_json_parser_end (p);
+		oio_json_parser_destroy (p);
 	}
-	if (!err) {
-		g_ptr_array_add (v, NULL);
-		keys = (gchar **) g_ptr_array_free (v, FALSE);
+
+	if (err) {
+		g_ptr_array_free (ctx.keys, TRUE);
+		*pkeys = NULL;
 	} else {
-		g_ptr_array_free (v, TRUE);
+		g_ptr_array_add (ctx.keys, NULL);
+		*pkeys = (gchar **) g_ptr_array_free (ctx.keys, FALSE);
 	}
-
-	*pkeys = keys;
 	return err;
 }
 
@@ -339,10 +368,10 @@ action_dir_srv_relink (struct req_args_s *args, struct json_object *jargs)
 /* -------------------------------------------------------------------------- */
 
 static enum http_rc_e
-action_dir_prop_get (struct req_args_s *args, struct json_object *jargs)
+action_dir_prop_get (struct req_args_s *args)
 {
 	gchar **keys = NULL;
-	GError *err = decode_json_string_array (&keys, jargs);
+	GError *err = decode_json_string_array (&keys, args->rq->body);
 
 	// Execute the request
 	gchar **pairs = NULL;
@@ -406,10 +435,10 @@ action_dir_prop_set (struct req_args_s *args, struct json_object *jargs)
 }
 
 static enum http_rc_e
-action_dir_prop_del (struct req_args_s *args, struct json_object *jargs)
+action_dir_prop_del (struct req_args_s *args)
 {
 	gchar **keys = NULL;
-	GError *err = decode_json_string_array (&keys, jargs);
+	GError *err = decode_json_string_array (&keys, args->rq->body);
 
 	GError *hook (const char *m1) {
 		return meta1v2_remote_reference_del_property (m1, args->url, keys);
@@ -555,7 +584,7 @@ action_ref_force (struct req_args_s *args)
 enum http_rc_e
 action_ref_prop_get (struct req_args_s *args)
 {
-    return rest_action (args, action_dir_prop_get);
+    return action_dir_prop_get (args);
 }
 
 enum http_rc_e
@@ -567,5 +596,5 @@ action_ref_prop_set (struct req_args_s *args)
 enum http_rc_e
 action_ref_prop_del (struct req_args_s *args)
 {
-    return rest_action (args, action_dir_prop_del);
+    return action_dir_prop_del (args);
 }
@@ -0,0 +1,260 @@
+/*
+OpenIO SDS proxy
+Copyright (C) 2014 Worldine, original work as part of Redcurrant
+Copyright (C) 2015 OpenIO, modified as part of OpenIO Software Defined Storage
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include <metautils/lib/metautils.h>
+
+#include "http_parser.h"
+
+/* Returns the length of the head ending with the first empty line of <s>,
+ * or 0 if there is none yet. The newlines before <from> have already been
+ * checked, but the bytes before may end the CRLF CRLF sequence. memchr()
+ * is much faster than a loop over each byte. */
+static gsize
+_head_length (const gchar *s, gsize len, gsize from)
+{
+	const gchar *end = s + len;
+	for (const gchar *p = s + from; p < end ;) {
+		const gchar *nl = memchr (p, '\n', end - p);
+		if (!nl)
+			return 0;
+		if (nl - s >= 3 && nl[-1] == '\r' && nl[-2] == '\n' && nl[-3] == '\r')
+			return nl - s + 1;
+		p = nl + 1;
+	}
+	return 0;
+}
+
+static gboolean
+_parse_command (struct http_parser_s *parser, const gchar *s, gsize len)
+{
+	const gchar *end = s + len;
+
+	/* the URI may contain spaces, the method and the version cannot */
+	const gchar *sp0 = memchr (s, ' ', len);
+	if (!sp0 || sp0 == s)
+		return FALSE;
+	const gchar *sp1 = end - 1;
+	while (sp1 > sp0 && *sp1 != ' ')
+		-- sp1;
+	if (sp1 == sp0 || sp1 == sp0 + 1 || sp1 == end - 1)
+		return FALSE;
+
+	if (parser->command_provider)
+		parser->command_provider (s, sp0 - s,
+				sp0 + 1, sp1 - sp0 - 1, sp1 + 1, end - sp1 - 1);
+	return TRUE;
+}
+
+static gboolean
+_parse_length (const gchar *s, gsize len, gint64 *out)
+{
+	/* 18 digits cannot overflow */
+	if (!len || len > 18)
+		return FALSE;
+	gint64 v = 0;
+	for (const gchar *end = s + len; s < end ;++s) {
+		if (!g_ascii_isdigit (*s))
+			return FALSE;
+		v = v * 10 + (*s - '0');
+	}
+	*out = v;
+	return TRUE;
+}
+
+static inline gboolean
+_is_blank (gchar c)
+{
+	return c == ' ' || c == '\t';
+}
+
+static gboolean
+_parse_header (struct http_parser_s *parser, const gchar *s, gsize len)
+{
+	const gchar *end = s + len;
+
+	/* no space before the colon, and no folded line */
+	const gchar *colon = memchr (s, ':', len);
+	if (!colon || colon == s || _is_blank (*s) || _is_blank (colon[-1]))
+		return FALSE;
+	const gsize name_len = colon - s;
+
+	const gchar *v = colon + 1;
+	while (v < end && _is_blank (*v))
+		++ v;
+	while (end > v && _is_blank (end[-1]))
+		-- end;
+
+	/* the body is only delimited by one Content-Length: any other framing
+	 * could be read differently by an intermediate */
+	if (name_len == sizeof("Content-Length") - 1
+			&& !g_ascii_strncasecmp (s, "Content-Length", name_len)) {
+		if (parser->content_length >= 0)
+			return FALSE;
+		if (!_parse_length (v, end - v, &parser->content_length))
+			return FALSE;
+	}
+	if (name_len == sizeof("Transfer-Encoding") - 1
+			&& !g_ascii_strncasecmp (s, "Transfer-Encoding", name_len))
+		return FALSE;
+
+	if (parser->header_provider)
+		parser->header_provider (s, name_len, v, end - v);
+	return TRUE;
+}
+
+/* <s> holds the whole head, each line ends with a CRLF */
+static gboolean
+_parse_head (struct http_parser_s *parser, const gchar *s, gsize len)
+{
+	const gchar *end = s + len;
+	gboolean first = TRUE;
+
+	while (s < end) {
+		const gchar *nl = memchr (s, '\n', end - s);
+		EXTRA_ASSERT (nl != NULL);
+		if (nl == s || nl[-1] != '\r')
+			return FALSE;
+		const gsize l = nl - s - 1;
+		if (first) {
+			if (!_parse_command (parser, s, l))
+				return FALSE;
+			first = FALSE;
+		} else if (l > 0) {
+			if (!_parse_header (parser, s, l))
+				return FALSE;
+		}
+		s = nl + 1;
+	}
+
+	return TRUE;
+}
+
+struct http_parsing_result_s
+http_parse (struct http_parser_s *parser, const guint8 *data, gsize available)
+{
+	struct http_parsing_result_s rc = {0, HPRC_MORE};
+	const gchar *s = (const gchar*) data;
+
+	if (parser->error) {
+		rc.status = HPRC_ERROR;
+		return rc;
+	}
+
+	if (parser->step == STEP_HEAD) {
+		const gchar *head = NULL;
+		gsize len;
+
+		if (!parser->buf->len) {
+			/* Ignore the empty lines before a request, some clients send
+			 * a CRLF after the body of a POST. */
+			while (rc.consumed < available
+					&& (s[rc.consumed] == '\r' || s[rc.consumed] == '\n'))
+				++ rc.consumed;
+			len = _head_length (s + rc.consumed, available - rc.consumed, 0);
+			if (len) {
+				head = s + rc.consumed;
+				rc.consumed += len;
+			} else {
+				g_string_append_len (parser->buf,
+						s + rc.consumed, available - rc.consumed);
+				rc.consumed = available;
+			}
+		} else {
+			const gsize before = parser->buf->len;
+			g_string_append_len (parser->buf, s, available);
+			len = _head_length (parser->buf->str, parser->buf->len, before);
+			if (len) {
+				g_string_truncate (parser->buf, len);
+				head = parser->buf->str;
+				rc.consumed = len - before;
+			} else {
+				rc.consumed = available;
+			}
+		}
+
+		if (!head) {
+			if (parser->buf->len > HTTP_HEAD_MAXLEN) {
+				parser->error = BADREQ("HDR too long");
+				rc.status = HPRC_ERROR;
+			}
+			return rc;
+		}
+
+		if (len > HTTP_HEAD_MAXLEN) {
+			parser->error = BADREQ("HDR too long");
+			rc.status = HPRC_ERROR;
+			return rc;
+		}
+		if (!_parse_head (parser, head, len)) {
+			parser->error = BADREQ("HDR parsing error");
+			rc.status = HPRC_ERROR;
+			return rc;
+		}
+		g_string_set_size (parser->buf, 0);
+		parser->step = STEP_BODY;
+	}
+
+	EXTRA_ASSERT (parser->step == STEP_BODY);
+	if (parser->content_read < parser->content_length) {
+		gint64 max = available - rc.consumed;
+		if (max > parser->content_length - parser->content_read)
+			max = parser->content_length - parser->content_read;
+		if (max > 0 && parser->body_provider)
+			parser->body_provider (data + rc.consumed, max);
+		rc.consumed += max;
+		parser->content_read += max;
+	}
+
+	if (parser->content_read >= parser->content_length)
+		rc.status = HPRC_SUCCESS;
+	return rc;
+}
+
+void
+http_parser_reset (struct http_parser_s *parser)
+{
+	parser->step = STEP_HEAD;
+	g_string_set_size (parser->buf, 0);
+	parser->content_read = 0;
+	parser->content_length = -1;
+	if (parser->error)
+		g_clear_error (&parser->error);
+}
+
+struct http_parser_s *
+http_parser_create (void)
+{
+	struct http_parser_s *parser = g_malloc0 (sizeof(struct http_parser_s));
+	parser->buf = g_string_sized_new (1024);
+	http_parser_reset (parser);
+	return parser;
+}
+
+void
+http_parser_destroy (struct http_parser_s *parser)
+{
+	if (!parser)
+		return;
+	if (parser->error)
+		g_clear_error (&parser->error);
+	g_string_free (parser->buf, TRUE);
+	g_free (parser);
+}
@@ -0,0 +1,70 @@
+/*
+OpenIO SDS proxy
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OIO_SDS__proxy__http_parser_h
+# define OIO_SDS__proxy__http_parser_h 1
+
+# include <glib.h>
+
+/* Past this size, a head without its empty line is an error */
+# ifndef HTTP_HEAD_MAXLEN
+#  define HTTP_HEAD_MAXLEN 65536
+# endif
+
+/* Incremental parser of HTTP/1.x requests. The head is parsed at once when
+ * its empty line has been received, directly over the input when it came
+ * in one piece. The providers receive slices of that input, valid only
+ * during the call. */
+struct http_parser_s
+{
+	enum { STEP_HEAD, STEP_BODY } step;
+	GError *error;
+
+	/* the beginning of a head received in several pieces */
+	GString *buf;
+
+	gint64 content_read;
+	gint64 content_length;
+
+	void (*command_provider) (const gchar *cmd, gsize cmd_len,
+			const gchar *uri, gsize uri_len,
+			const gchar *ver, gsize ver_len);
+	void (*header_provider) (const gchar *name, gsize name_len,
+			const gchar *value, gsize value_len);
+	void (*body_provider) (const guint8 *data, gsize data_len);
+};
+
+struct http_parsing_result_s
+{
+	gsize consumed;
+	enum { HPRC_SUCCESS = 0, HPRC_MORE, HPRC_ERROR } status;
+};
+
+struct http_parser_s * http_parser_create (void);
+
+void http_parser_destroy (struct http_parser_s *parser);
+
+/* To be called between two requests */
+void http_parser_reset (struct http_parser_s *parser);
+
+/* Consumes at most one request: upon HPRC_SUCCESS, the bytes after
+ * <consumed> belong to the next request pipelined on the connection. */
+struct http_parsing_result_s http_parse (struct http_parser_s *parser,
+		const guint8 *data, gsize available);
+
+#endif /*OIO_SDS__proxy__http_parser_h*/
@@ -47,6 +47,98 @@ _resolve_meta2 (struct req_args_s *args,
 	return _resolve_service_and_do (realtype, 0, args->url, hook);
 }
 
+/* The actions made of a single meta2 request don't wait for it in their
+ * worker: they are deferred, the request goes through the shared client
+ * pool, failing over the meta2 replicas as _resolve_meta2() does, and the
+ * <hook> replies (decoding the beans) in a worker again. */
+typedef enum http_rc_e (*m2_reply_f) (struct req_args_s *args, GError *err,
+		struct m2v2_reply_s *reply);
+
+struct m2_async_s
+{
+	struct req_deferred_s *deferred;
+	GByteArray *req;
+	m2_reply_f hook;
+
+	gchar **urls;
+	guint next;
+
+	struct m2v2_reply_s *reply;
+	GError *err;
+};
+
+static void _m2_async_submit (struct m2_async_s *a);
+
+/* In the thread of the client pool: no decoding, no waiting */
+static void
+_m2_async_done (struct m2_async_s *a, struct m2v2_reply_s *reply)
+{
+	const GError *e = m2v2_reply_error (reply);
+	if (!e) {
+		a->reply = reply;
+	} else if (CODE_IS_NETWORK_ERROR(e->code)) {
+		struct meta1_service_url_s *m1u = meta1_unpack_url (a->urls[a->next-1]);
+		service_invalidate (m1u->host);
+		meta1_service_url_clean (m1u);
+		GRID_DEBUG ("HOOK error : (%d) %s", e->code, e->message);
+		m2v2_reply_free (reply);
+		if (a->urls[a->next]) {
+			_m2_async_submit (a);
+			return;
+		}
+		a->err = NEWERROR (CODE_PLATFORM_ERROR, "No reply");
+	} else {
+		GRID_DEBUG ("HOOK error : (%d) %s", e->code, e->message);
+		a->err = g_error_copy (e);
+		g_prefix_error (&a->err, "HOOK error: ");
+		m2v2_reply_free (reply);
+	}
+	_resume_action (a->deferred);
+}
+
+static void
+_m2_async_submit (struct m2_async_s *a)
+{
+	struct meta1_service_url_s *m1u = meta1_unpack_url (a->urls[a->next++]);
+	m2v2_remote_submit (m1u->host, a->req, M2V2_CLIENT_TIMEOUT,
+			(m2v2_done_f) _m2_async_done, a);
+	meta1_service_url_clean (m1u);
+}
+
+static enum http_rc_e
+_m2_async_resume (struct req_args_s *args, struct m2_async_s *a)
+{
+	enum http_rc_e rc = a->hook (args, a->err, a->reply);
+	m2v2_reply_free (a->reply);
+	g_byte_array_unref (a->req);
+	g_strfreev (a->urls);
+	g_free (a);
+	return rc;
+}
+
+/* <req> is consumed, <hook> owns the error it receives */
+static enum http_rc_e
+_resolve_meta2_async (struct req_args_s *args, GByteArray *req, m2_reply_f hook)
+{
+	gchar realtype[64];
+	gchar **urls = NULL;
+	_get_meta2_realtype (args, realtype, sizeof(realtype), "");
+	GError *err = _resolve_service (realtype, args->url, &urls);
+	if (err) {
+		g_byte_array_unref (req);
+		return hook (args, err, NULL);
+	}
+
+	struct m2_async_s *a = g_malloc0 (sizeof (struct m2_async_s));
+	a->req = req;
+	a->hook = hook;
+	a->urls = urls;
+	enum http_rc_e rc = _defer_action (args,
+			(req_resume_f) _m2_async_resume, a, &a->deferred);
+	_m2_async_submit (a);
+	return rc;
+}
+
 static void
 _json_dump_all_beans (GString * gstr, GSList * beans)
 {
@@ -167,7 +259,7 @@ _reply_aliases (struct req_args_s *args, GError * err, GSList * beans,
 			if (!first)
 				g_string_append_c(gstr, ',');
 			first = FALSE;
-			g_string_append_printf (gstr, "\"%s\"", *pp);
+			oio_json_append_string (gstr, *pp);
 		}
 		g_string_append (gstr, "],");
 	}
@@ -193,43 +285,30 @@ _reply_aliases (struct req_args_s *args, GError * err, GSList * beans,
 			}
 		}
 
-		g_string_append_printf(gstr,
-				"{\"name\":\"%s\""
-				",\"ver\":%"G_GINT64_FORMAT
-				",\"ctime\":%"G_GINT64_FORMAT
-				",\"mtime\":%"G_GINT64_FORMAT
-				",\"deleted\":%s"
-				",\"content\":\"",
-				ALIASES_get_alias(a)->str,
-				ALIASES_get_version(a),
-				ALIASES_get_ctime(a),
-				ALIASES_get_mtime(a),
-				ALIASES_get_deleted(a) ? "true" : "false");
-
-		metautils_gba_to_hexgstr(gstr, ALIASES_get_content(a));
-		g_string_append_c (gstr, '"');
+		g_string_append_c (gstr, '{');
+		OIO_JSON_KEY(gstr, "name");
+		oio_json_append_string (gstr, ALIASES_get_alias(a)->str);
+		OIO_JSON_NEXT_KEY(gstr, "ver");
+		oio_json_append_int (gstr, ALIASES_get_version(a));
+		OIO_JSON_NEXT_KEY(gstr, "ctime");
+		oio_json_append_int (gstr, ALIASES_get_ctime(a));
+		OIO_JSON_NEXT_KEY(gstr, "mtime");
+		oio_json_append_int (gstr, ALIASES_get_mtime(a));
+		OIO_JSON_NEXT_KEY(gstr, "deleted");
+		oio_json_append_bool (gstr, ALIASES_get_deleted(a));
+		OIO_JSON_NEXT_KEY(gstr, "content");
+		metautils_gba_to_json (gstr, ALIASES_get_content(a));
 
 		if (h) {
-			g_string_append_c (gstr, ',');
 			GString *pol = CONTENTS_HEADERS_get_policy(h);
-			GByteArray *hh = CONTENTS_HEADERS_get_hash(h);
-
-			if (pol)
-				g_string_append_printf(gstr, "\"policy\":\"%s\",\"hash\":", pol->str);
-			else
-				g_string_append_printf(gstr, "\"policy\":null,\"hash\":");
-			if (hh) {
-				g_string_append_c (gstr, '"');
-				metautils_gba_to_hexgstr(gstr, hh);
-				g_string_append_c (gstr, '"');
-			} else {
-				g_string_append(gstr, "null");
-			}
-
-			g_string_append_printf(gstr, ",\"size\":%"G_GINT64_FORMAT,
-					CONTENTS_HEADERS_get_size(h));
-			g_string_append_printf(gstr, ",\"mime-type\":\"%s\"",
-					CONTENTS_HEADERS_get_mime_type(h)->str);
+			OIO_JSON_NEXT_KEY(gstr, "policy");
+			oio_json_append_string (gstr, pol ? pol->str : NULL);
+			OIO_JSON_NEXT_KEY(gstr, "hash");
+			metautils_gba_to_json (gstr, CONTENTS_HEADERS_get_hash(h));
+			OIO_JSON_NEXT_KEY(gstr, "size");
+			oio_json_append_int (gstr, CONTENTS_HEADERS_get_size(h));
+			OIO_JSON_NEXT_KEY(gstr, "mime-type");
+			oio_json_append_string (gstr, CONTENTS_HEADERS_get_mime_type(h)->str);
 		}
 		g_string_append_c(gstr, '}');
 	}
@@ -355,12 +434,18 @@ _reply_simplified_beans (struct req_args_s *args, GError *err,
 			// Serialize the chunk
 			struct bean_CHUNKS_s *chunk = l0->data;
 			gint32 score = _score_from_chunk_id(lbpool, CHUNKS_get_id(chunk)->str);
-			g_string_append_printf (gstr, "{\"url\":\"%s\"", CHUNKS_get_id (chunk)->str);
-			g_string_append_printf (gstr, ",\"pos\":\"%s\"", CHUNKS_get_position (chunk)->str);
-			g_string_append_printf (gstr, ",\"size\":%"G_GINT64_FORMAT, CHUNKS_get_size (chunk));
-			g_string_append (gstr, ",\"hash\":\"");
-			metautils_gba_to_hexgstr (gstr, CHUNKS_get_hash (chunk));
-			g_string_append_printf(gstr, "\",\"score\":%d}", score);
+			g_string_append_c (gstr, '{');
+			OIO_JSON_KEY(gstr, "url");
+			oio_json_append_string (gstr, CHUNKS_get_id (chunk)->str);
+			OIO_JSON_NEXT_KEY(gstr, "pos");
+			oio_json_append_string (gstr, CHUNKS_get_position (chunk)->str);
+			OIO_JSON_NEXT_KEY(gstr, "size");
+			oio_json_append_int (gstr, CHUNKS_get_size (chunk));
+			OIO_JSON_NEXT_KEY(gstr, "hash");
+			metautils_gba_to_json (gstr, CHUNKS_get_hash (chunk));
+			OIO_JSON_NEXT_KEY(gstr, "score");
+			oio_json_append_int (gstr, score);
+			g_string_append_c (gstr, '}');
 		}
 		else if (&descr_struct_ALIASES == DESCR(l0->data)) {
 			alias = l0->data;
@@ -411,7 +496,8 @@ _get_hash (const char *s, GByteArray **out)
 	if (len != g_checksum_type_get_length(G_CHECKSUM_MD5)
 			&& len != g_checksum_type_get_length(G_CHECKSUM_SHA256)
 			&& len != g_checksum_type_get_length(G_CHECKSUM_SHA512)
-			&& len != g_checksum_type_get_length(G_CHECKSUM_SHA1)) {
+			&& len != g_checksum_type_get_length(G_CHECKSUM_SHA1)
+			&& len != (gssize) oio_hash_algo_length(OIO_HASH_XXH64)) {
 		g_byte_array_free (h, TRUE);
 		return BADREQ("JSON: invalid hash: invalid length");
 	}
@@ -420,6 +506,31 @@ _get_hash (const char *s, GByteArray **out)
 	return NULL;
 }
 
+static GError *
+_build_simplified_chunk (const char *url, const char *pos, gint64 size,
+		const char *hash, gint64 now, GSList **pbeans)
+{
+	GByteArray *h = NULL;
+	GError *err = _get_hash (hash, &h);
+	if (!err) {
+		struct bean_CHUNKS_s *chunk = _bean_create(&descr_struct_CHUNKS);
+		CHUNKS_set2_id (chunk, url);
+		CHUNKS_set_hash (chunk, h);
+		CHUNKS_set_size (chunk, size);
+		CHUNKS_set_ctime (chunk, now);
+		CHUNKS_set2_position (chunk, pos);
+		CHUNKS_set2_content (chunk, (guint8*)"0", 1);
+		*pbeans = g_slist_prepend(*pbeans, chunk);
+	}
+	metautils_gba_clean (h);
+	return err;
+}
+
+/* Kept for the arrays nested in a larger document, i.e. the "notin" and
+ * "broken" members of a spare request and the "chunks" of each content of
+ * a batch: the json-c tree is needed anyway for their siblings, so there
+ * is no raw body left to stream. The plain lists of chunks go through
+ * _parse_simplified_chunks(). */
 static GError *
 _load_simplified_chunks (struct json_object *jbody, GSList **out)
 {
@@ -445,18 +556,9 @@ _load_simplified_chunks (struct json_object *jbody, GSList **out)
 		err = oio_ext_extract_json (json_object_array_get_idx (jbody, i-1), m);
 		if (err) break;
 
-		GByteArray *h = NULL;
-		if (!(err = _get_hash (json_object_get_string(jhash), &h))) {
-			struct bean_CHUNKS_s *chunk = _bean_create(&descr_struct_CHUNKS);
-			CHUNKS_set2_id (chunk, json_object_get_string(jurl));
-			CHUNKS_set_hash (chunk, h);
-			CHUNKS_set_size (chunk, json_object_get_int64(jsize));
-			CHUNKS_set_ctime (chunk, now);
-			CHUNKS_set2_position (chunk, json_object_get_string(jpos));
-			CHUNKS_set2_content (chunk, (guint8*)"0", 1);
-			beans = g_slist_prepend(beans, chunk);
-		}
-		metautils_gba_clean (h);
+		err = _build_simplified_chunk (json_object_get_string(jurl),
+				json_object_get_string(jpos), json_object_get_int64(jsize),
+				json_object_get_string(jhash), now, &beans);
 	}
 
 	if (err)
@@ -467,18 +569,63 @@ _load_simplified_chunks (struct json_object *jbody, GSList **out)
 	return err;
 }
 
+struct simplified_chunks_s
+{
+	GSList *beans;
+	gint64 now;
+};
+
+static GError *
+_on_simplified_chunk (gpointer u, const struct oio_json_record_s *r)
+{
+	struct simplified_chunks_s *ctx = u;
+	const gchar *url, *pos, *size, *hash;
+	struct oio_json_record_mapping_s m[] = {
+		{"url",  &url,  OIO_JSON_TYPE_STRING, 1},
+		{"pos",  &pos,  OIO_JSON_TYPE_STRING, 1},
+		{"size", &size, OIO_JSON_TYPE_INT,    1},
+		{"hash", &hash, OIO_JSON_TYPE_STRING, 1},
+		{NULL, NULL, 0, 0}
+	};
+	GError *err = oio_json_record_extract (r, m);
+	if (!err)
+		err = _build_simplified_chunk (url, pos, g_ascii_strtoll (size, NULL, 10),
+				hash, ctx->now, &ctx->beans);
+	return err;
+}
+
+/* Same as _load_simplified_chunks(), but the chunks are decoded from the raw
+ * body, record by record, without any intermediate json-c tree. */
 static GError *
-_load_simplified_content (struct req_args_s *args, struct json_object *jbody, GSList **out)
+_parse_simplified_chunks (GByteArray *body, GSList **out)
+{
+	struct simplified_chunks_s ctx = {
+		.beans = NULL,
+		.now = oio_ext_real_time () / G_TIME_SPAN_SECOND,
+	};
+	struct oio_json_records_s *records =
+		oio_json_records_create (_on_simplified_chunk, &ctx);
+	GError *err = oio_json_records_feed (records, body->data, body->len);
+	if (!err)
+		err = oio_json_records_end (records);
+	oio_json_records_destroy (records);
+
+	if (!err && !ctx.beans)
+		err = BADREQ ("JSON: Empty array");
+	if (err)
+		_bean_cleanl2 (ctx.beans);
+	else
+		*out = g_slist_reverse (ctx.beans);
+	return err;
+}
+
+static GError *
+_load_simplified_content (struct req_args_s *args, GSList **out)
 {
 	GError *err = NULL;
 	GSList *beans = NULL;
 
-	if (!json_object_is_type(jbody, json_type_array))
-		return BADREQ ("JSON: Not an array");
-	if (json_object_array_length(jbody) <= 0)
-		return BADREQ ("JSON: Empty array");
-
-	err = _load_simplified_chunks (jbody, &beans);
+	err = _parse_simplified_chunks (args->rq->body, &beans);
 
 	struct bean_CONTENTS_HEADERS_s *header = NULL;
 
@@ -659,9 +806,10 @@ _reply_properties (struct req_args_s *args, GError * err, GSList * beans)
 			g_string_append_c(gs, ',');
 		first = FALSE;
 		struct bean_PROPERTIES_s *bean = l->data;
-		g_string_append_printf(gs, "\"%s\":\"%.*s\"",
-				PROPERTIES_get_key(bean)->str,
-				PROPERTIES_get_value(bean)->len, PROPERTIES_get_value(bean)->data);
+		GByteArray *v = PROPERTIES_get_value(bean);
+		oio_json_append_string (gs, PROPERTIES_get_key(bean)->str);
+		g_string_append_c (gs, ':');
+		oio_json_append_stringn (gs, v->len ? (gchar*) v->data : "", v->len);
 	}
 	g_string_append_c(gs, '}');
 
@@ -992,41 +1140,45 @@ action_m2_container_touch (struct req_args_s *args, struct json_object *jargs)
 	return _reply_success_json (args, NULL);
 }
 
+/* The body is a bare array of beans, decoded as a stream of records */
 static enum http_rc_e
-action_m2_container_raw_insert (struct req_args_s *args, struct json_object *jargs)
+_xbeans_action (struct req_args_s *args,
+		enum http_rc_e (*handler) (struct req_args_s *, GSList *))
 {
 	GSList *beans = NULL;
-	GError *err = m2v2_json_load_setof_xbean (jargs, &beans);
+	GError *err = m2v2_json_parse_setof_xbean (
+			args->rq->body->data, args->rq->body->len, &beans);
 	if (err)
 		return _reply_format_error (args, err);
 	if (!beans)
 		return _reply_format_error (args, BADREQ("Empty beans list"));
 
+	enum http_rc_e rc = handler (args, beans);
+	_bean_cleanl2 (beans);
+	return rc;
+}
+
+static enum http_rc_e
+action_m2_container_raw_insert (struct req_args_s *args, GSList *beans)
+{
 	GError * hook (struct meta1_service_url_s *m2, gboolean *next) {
 		(void) next;
 		return m2v2_remote_execute_RAW_ADD (m2->host, args->url, beans);
 	}
-	err = _resolve_meta2 (args, hook);
+	GError *err = _resolve_meta2 (args, hook);
 	if (NULL != err)
 		return _reply_m2_error (args, err);
 	return _reply_success_json (args, NULL);
 }
 
 static enum http_rc_e
-action_m2_container_raw_delete (struct req_args_s *args, struct json_object *jargs)
+action_m2_container_raw_delete (struct req_args_s *args, GSList *beans)
 {
-	GSList *beans = NULL;
-	GError *err = m2v2_json_load_setof_xbean (jargs, &beans);
-	if (err)
-		return _reply_format_error (args, err);
-	if (!beans)
-		return _reply_format_error (args, BADREQ("Empty beans list"));
-
 	GError * hook (struct meta1_service_url_s *m2, gboolean *next) {
 		(void) next;
 		return m2v2_remote_execute_RAW_DEL (m2->host, args->url, beans);
 	}
-	err = _resolve_meta2 (args, hook);
+	GError *err = _resolve_meta2 (args, hook);
 	if (NULL != err)
 		return _reply_m2_error (args, err);
 	return _reply_success_json (args, NULL);
@@ -1176,7 +1328,7 @@ action_container_list (struct req_args_s *args)
 		(void) next;
 		GError *e = NULL;
 		struct list_params_s in = list_in;
-		struct list_result_s out = {NULL,NULL,FALSE};
+		struct list_result_s out = {NULL,NULL,FALSE,NULL};
 		while (grid_main_is_running()) {
 
 			// patch the input parameters
@@ -1207,6 +1359,10 @@ action_container_list (struct req_args_s *args)
 			// transmit the output
 			oio_str_reuse (&list_out.next_marker, out.next_marker);
 			out.next_marker = NULL;
+			for (GSList *l=out.prefixes; l ;l=l->next)
+				g_tree_replace (tree_prefixes, l->data, GINT_TO_POINTER(1));
+			g_slist_free (out.prefixes);
+			out.prefixes = NULL;
 			if (out.beans) {
 				struct filter_ctx_s ctx;
 				ctx.beans = list_out.beans;
@@ -1245,6 +1401,7 @@ action_container_list (struct req_args_s *args)
 	list_in.marker_start = OPT("marker");
 	list_in.marker_end = OPT("marker_end");
 	delimiter = _delimiter (args);
+	list_in.delimiter = delimiter;
 	if (OPT("deleted"))
 		list_in.flag_nodeleted = 0;
 	if (OPT("all"))
@@ -1362,7 +1519,7 @@ action_container_prop_del (struct req_args_s *args)
 enum http_rc_e
 action_container_raw_insert (struct req_args_s *args)
 {
-    return rest_action (args, action_m2_container_raw_insert);
+    return _xbeans_action (args, action_m2_container_raw_insert);
 }
 
 enum http_rc_e
@@ -1374,12 +1531,33 @@ action_container_raw_update (struct req_args_s *args)
 enum http_rc_e
 action_container_raw_delete (struct req_args_s *args)
 {
-    return rest_action (args, action_m2_container_raw_delete);
+    return _xbeans_action (args, action_m2_container_raw_delete);
 }
 
 
 /* CONTENT action resource -------------------------------------------------- */
 
+/* A missing alias makes the action forbidden */
+static enum http_rc_e
+_reply_m2_alias_error (struct req_args_s *args, GError *err,
+		struct m2v2_reply_s *reply)
+{
+	(void) reply;
+	if (err && CODE_IS_NOTFOUND(err->code))
+		return _reply_forbidden_error (args, err);
+	return _reply_m2_error (args, err);
+}
+
+static enum http_rc_e
+_reply_m2_properties (struct req_args_s *args, GError *err,
+		struct m2v2_reply_s *reply)
+{
+	GSList *beans = NULL;
+	if (!err)
+		err = m2v2_reply_decode_beans (reply, &beans);
+	return _reply_properties (args, err, beans);
+}
+
 
 static enum http_rc_e
 action_m2_content_beans (struct req_args_s *args, struct json_object *jargs)
@@ -1494,14 +1672,8 @@ static enum http_rc_e
 action_m2_content_touch (struct req_args_s *args, struct json_object *jargs)
 {
 	(void) jargs;
-	GError *hook (struct meta1_service_url_s *m2, gboolean *next) {
-		(void) next;
-		return m2v2_remote_touch_content (m2->host, args->url);
-	}
-	GError *err = _resolve_meta2 (args, hook);
-	if (err && CODE_IS_NOTFOUND(err->code))
-		return _reply_forbidden_error (args, err);
-	return _reply_m2_error (args, err);
+	return _resolve_meta2_async (args, m2v2_remote_pack_TOUCH_content (args->url),
+			_reply_m2_alias_error);
 }
 
 static enum http_rc_e
@@ -1526,14 +1698,8 @@ action_m2_content_link (struct req_args_s *args, struct json_object *jargs)
 	if (!oio_url_set (args->url, OIOURL_CONTENTID, id))
 		return _reply_m2_error (args, BADREQ("Expected: id (hexa string)"));
 
-	GError *hook (struct meta1_service_url_s *m2, gboolean *next) {
-		(void) next;
-		return m2v2_remote_execute_LINK (m2->host, args->url);
-	}
-	err = _resolve_meta2 (args, hook);
-	if (err && CODE_IS_NOTFOUND(err->code))
-		return _reply_forbidden_error (args, err);
-	return _reply_m2_error (args, err);
+	return _resolve_meta2_async (args, m2v2_remote_pack_LINK (args->url),
+			_reply_m2_alias_error);
 }
 
 static enum http_rc_e
@@ -1568,15 +1734,9 @@ action_m2_content_propset (struct req_args_s *args, struct json_object *jargs)
 	if (OPT("flush"))
 		flags |= M2V2_FLAG_FLUSH;
 
-	GError *hook (struct meta1_service_url_s *m2, gboolean *next) {
-		(void) next;
-		return m2v2_remote_execute_PROP_SET (m2->host, args->url, flags, beans);
-	}
-	GError *err = _resolve_meta2 (args, hook);
+	GByteArray *req = m2v2_remote_pack_PROP_SET (args->url, flags, beans);
 	_bean_cleanl2 (beans);
-	if (err && CODE_IS_NOTFOUND(err->code))
-		return _reply_forbidden_error (args, err);
-	return _reply_m2_error (args, err);
+	return _resolve_meta2_async (args, req, _reply_m2_alias_error);
 }
 
 static enum http_rc_e
@@ -1601,15 +1761,9 @@ action_m2_content_propdel (struct req_args_s *args, struct json_object *jargs)
 		names = g_slist_prepend (names, g_strdup(json_object_get_string(item)));
 	}
 
-	GError *hook (struct meta1_service_url_s *m2, gboolean *next) {
-		(void) next;
-		return m2v2_remote_execute_PROP_DEL (m2->host, args->url, names);
-	}
-	GError *err = _resolve_meta2 (args, hook);
+	GByteArray *req = m2v2_remote_pack_PROP_DEL (args->url, names);
 	g_slist_free_full (names, g_free0);
-	if (err && CODE_IS_NOTFOUND(err->code))
-		return _reply_forbidden_error (args, err);
-	return _reply_m2_error (args, err);
+	return _resolve_meta2_async (args, req, _reply_m2_alias_error);
 }
 
 static enum http_rc_e
@@ -1620,30 +1774,21 @@ action_m2_content_propget (struct req_args_s *args, struct json_object *jargs)
 	gint64 version = 0;
 	(void) version;
 
-	GSList *beans = NULL;
-	GError *hook (struct meta1_service_url_s *m2, gboolean *next) {
-		(void) next;
-		return m2v2_remote_execute_PROP_GET (m2->host, args->url,
-				M2V2_FLAG_ALLPROPS|M2V2_FLAG_NOFORMATCHECK, &beans);
-	}
-	GError *err = _resolve_meta2 (args, hook);
-	return _reply_properties (args, err, beans);
+	return _resolve_meta2_async (args, m2v2_remote_pack_PROP_GET (args->url,
+				M2V2_FLAG_ALLPROPS|M2V2_FLAG_NOFORMATCHECK), _reply_m2_properties);
 }
 
 /* CONTENT resources ------------------------------------------------------- */
 
 static GError *
-_m2_json_put (struct req_args_s *args, struct json_object *jbody)
+_m2_json_put (struct req_args_s *args)
 {
-	if (!jbody)
-		return BADREQ("Invalid JSON body");
-
 	gboolean append = _request_has_flag (args, PROXYD_HEADER_MODE, "append");
 	gboolean force = _request_has_flag (args, PROXYD_HEADER_MODE, "force");
 	GSList *ibeans = NULL;
 	GError *err;
 
-	if (NULL != (err = _load_simplified_content (args, jbody, &ibeans))) {
+	if (NULL != (err = _load_simplified_content (args, &ibeans))) {
 		_bean_cleanl2 (ibeans);
 		return err;
 	}
@@ -1666,37 +1811,228 @@ _m2_json_put (struct req_args_s *args, struct json_object *jbody)
 	return err;
 }
 
+/* Batches ----------------------------------------------------------------- */
+
+/* Loads one content of a batch, described as a JSON object with the fields
+ * of the "content-meta-*" headers of a single put. A content ID is generated
+ * when none is given, the meta2 needs it to sort the beans of the batch. */
+static GError *
+_load_batch_content (struct json_object *jitem, GSList **out)
+{
+	struct json_object *jpath = NULL, *jid = NULL, *jsize = NULL,
+		*jhash = NULL, *jversion = NULL, *jpolicy = NULL, *jmime = NULL,
+		*jmethod = NULL, *jchunks = NULL, *jprops = NULL;
+	struct oio_ext_json_mapping_s m[] = {
+		{"path",         &jpath,    json_type_string, 1},
+		{"id",           &jid,      json_type_string, 0},
+		{"size",         &jsize,    json_type_int,    1},
+		{"hash",         &jhash,    json_type_string, 0},
+		{"version",      &jversion, json_type_int,    0},
+		{"policy",       &jpolicy,  json_type_string, 0},
+		{"mime-type",    &jmime,    json_type_string, 0},
+		{"chunk-method", &jmethod,  json_type_string, 0},
+		{"chunks",       &jchunks,  json_type_array,  1},
+		{"properties",   &jprops,   json_type_object, 0},
+		{NULL, NULL, 0, 0}
+	};
+	GError *err = oio_ext_extract_json (jitem, m);
+	if (err)
+		return err;
+	if (json_object_get_int64 (jsize) < 0)
+		return BADREQ("JSON: negative content length");
+
+	GByteArray *id = NULL;
+	if (jid) {
+		if (!(id = metautils_gba_from_hexstring (json_object_get_string (jid))))
+			return BADREQ("JSON: invalid content ID (not hexa)");
+	} else {
+		id = g_byte_array_new ();
+		g_byte_array_set_size (id, 16);
+		oio_str_randomize (id->data, id->len);
+	}
+
+	GSList *beans = NULL;
+	if (!(err = _load_simplified_chunks (jchunks, &beans))) {
+		for (GSList *l=beans; l ;l=l->next)
+			CHUNKS_set_content (l->data, id);
+
+		struct bean_CONTENTS_HEADERS_s *header =
+			_bean_create (&descr_struct_CONTENTS_HEADERS);
+		beans = g_slist_prepend (beans, header);
+		CONTENTS_HEADERS_set_id (header, id);
+		CONTENTS_HEADERS_set_size (header, json_object_get_int64 (jsize));
+		if (jpolicy)
+			CONTENTS_HEADERS_set2_policy (header, json_object_get_string (jpolicy));
+		if (jmime)
+			CONTENTS_HEADERS_set2_mime_type (header, json_object_get_string (jmime));
+		if (jmethod)
+			CONTENTS_HEADERS_set2_chunk_method (header, json_object_get_string (jmethod));
+		if (jhash) {
+			GByteArray *h = NULL;
+			if (!(err = _get_hash (json_object_get_string (jhash), &h)))
+				CONTENTS_HEADERS_set_hash (header, h);
+			metautils_gba_clean (h);
+		}
+
+		struct bean_ALIASES_s *alias = _bean_create (&descr_struct_ALIASES);
+		beans = g_slist_prepend (beans, alias);
+		ALIASES_set2_alias (alias, json_object_get_string (jpath));
+		ALIASES_set_content (alias, id);
+		if (jversion)
+			ALIASES_set_version (alias, json_object_get_int64 (jversion));
+
+		if (jprops) {
+			json_object_object_foreach (jprops, k, jv) {
+				if (!json_object_is_type (jv, json_type_string)) {
+					err = BADREQ("JSON: invalid property value");
+					break;
+				}
+				const char *v = json_object_get_string (jv);
+				struct bean_PROPERTIES_s *prop = _bean_create (&descr_struct_PROPERTIES);
+				PROPERTIES_set_alias (prop, ALIASES_get_alias (alias));
+				PROPERTIES_set_version (prop, 0); // still unknown
+				PROPERTIES_set2_key (prop, k);
+				PROPERTIES_set2_value (prop, (guint8*)v, strlen(v));
+				beans = g_slist_prepend (beans, prop);
+			}
+		}
+	}
+	g_byte_array_free (id, TRUE);
+
+	if (err)
+		_bean_cleanl2 (beans);
+	else
+		*out = metautils_gslist_precat (*out, beans);
+	return err;
+}
+
+/* Replies the status of each path of the batch, in the order of <paths> */
+static enum http_rc_e
+_reply_batch (struct req_args_s *args, GError *err, GPtrArray *paths,
+		GHashTable *errors)
+{
+	if (err)
+		return _reply_m2_error (args, err);
+
+	GString *gs = g_string_new ("[");
+	for (guint i=0; i<paths->len ;i++) {
+		const char *path = paths->pdata[i];
+		GError *e = errors ? g_hash_table_lookup (errors, path) : NULL;
+		if (i) g_string_append_c (gs, ',');
+		g_string_append_c (gs, '{');
+		OIO_JSON_KEY(gs, "path");
+		oio_json_append_string (gs, path);
+		OIO_JSON_NEXT_KEY(gs, "status");
+		oio_json_append_int (gs, e ? e->code : CODE_FINAL_OK);
+		OIO_JSON_NEXT_KEY(gs, "message");
+		oio_json_append_string (gs, e ? e->message : "OK");
+		g_string_append_c (gs, '}');
+	}
+	g_string_append_c (gs, ']');
+	return _reply_success_json (args, gs);
+}
+
+static enum http_rc_e
+action_m2_content_create_many (struct req_args_s *args, struct json_object *jargs)
+{
+	if (!json_object_is_type (jargs, json_type_array))
+		return _reply_format_error (args, BADREQ("JSON: Not an array"));
+	if (json_object_array_length (jargs) <= 0)
+		return _reply_format_error (args, BADREQ("JSON: Empty array"));
+
+	GError *err = NULL;
+	GSList *beans = NULL;
+	GPtrArray *paths = g_ptr_array_new ();
+	for (int i=0; !err && i<json_object_array_length (jargs) ;i++) {
+		struct json_object *jitem = json_object_array_get_idx (jargs, i);
+		if (!(err = _load_batch_content (jitem, &beans))) {
+			struct json_object *jpath = NULL;
+			json_object_object_get_ex (jitem, "path", &jpath);
+			g_ptr_array_add (paths, (gpointer) json_object_get_string (jpath));
+		}
+	}
+	if (err) {
+		_bean_cleanl2 (beans);
+		g_ptr_array_free (paths, TRUE);
+		return _reply_format_error (args, err);
+	}
+
+	GHashTable *errors = NULL;
+	GError *hook (struct meta1_service_url_s *m2, gboolean *next) {
+		(void) next;
+		if (errors) {
+			g_hash_table_destroy (errors);
+			errors = NULL;
+		}
+		return m2v2_remote_execute_PUT_MANY (m2->host, args->url, beans, &errors);
+	}
+	err = _resolve_meta2 (args, hook);
+
+	enum http_rc_e rc = _reply_batch (args, err, paths, errors);
+	if (errors)
+		g_hash_table_destroy (errors);
+	g_ptr_array_free (paths, TRUE);
+	_bean_cleanl2 (beans);
+	return rc;
+}
+
+static enum http_rc_e
+action_m2_content_delete_many (struct req_args_s *args, struct json_object *jargs)
+{
+	if (!json_object_is_type (jargs, json_type_array))
+		return _reply_format_error (args, BADREQ("JSON: Not an array"));
+	if (json_object_array_length (jargs) <= 0)
+		return _reply_format_error (args, BADREQ("JSON: Empty array"));
+
+	GPtrArray *paths = g_ptr_array_new ();
+	for (int i=0; i<json_object_array_length (jargs) ;i++) {
+		struct json_object *jpath = json_object_array_get_idx (jargs, i);
+		if (!json_object_is_type (jpath, json_type_string)) {
+			g_ptr_array_free (paths, TRUE);
+			return _reply_format_error (args, BADREQ("JSON: path not a string"));
+		}
+		g_ptr_array_add (paths, (gpointer) json_object_get_string (jpath));
+	}
+	g_ptr_array_add (paths, NULL);
+
+	GHashTable *errors = NULL;
+	GError *hook (struct meta1_service_url_s *m2, gboolean *next) {
+		(void) next;
+		if (errors) {
+			g_hash_table_destroy (errors);
+			errors = NULL;
+		}
+		return m2v2_remote_execute_DEL_MANY (m2->host, args->url,
+				(gchar**) paths->pdata, &errors);
+	}
+	GError *err = _resolve_meta2 (args, hook);
+
+	g_ptr_array_set_size (paths, paths->len - 1);
+	enum http_rc_e rc = _reply_batch (args, err, paths, errors);
+	if (errors)
+		g_hash_table_destroy (errors);
+	g_ptr_array_free (paths, TRUE);
+	return rc;
+}
+
 enum http_rc_e
 action_content_put (struct req_args_s *args)
 {
 	GError *err = NULL;
-	json_tokener *parser = json_tokener_new ();
-	json_object *jbody = NULL;
-	if (args->rq->body->len)
-		jbody = json_tokener_parse_ex (parser,
-				(char *) args->rq->body->data, args->rq->body->len);
-
-	if (json_tokener_success != json_tokener_get_error (parser))
-		err = BADREQ("Invalid JSON");
-	else {
-		gboolean autocreate = _request_has_flag (args,
-				PROXYD_HEADER_MODE, "autocreate");
+	gboolean autocreate = _request_has_flag (args,
+			PROXYD_HEADER_MODE, "autocreate");
 retry:
-		err = _m2_json_put (args, jbody);
-		if (err && CODE_IS_NOTFOUND(err->code)) {
-			if (autocreate) {
-				GRID_DEBUG("Resource not found, autocreation");
-				autocreate = FALSE;
-				g_clear_error (&err);
-				if (!(err = _m2_container_create (args)))
-					goto retry;
-			}
+	err = _m2_json_put (args);
+	if (err && CODE_IS_NOTFOUND(err->code)) {
+		if (autocreate) {
+			GRID_DEBUG("Resource not found, autocreation");
+			autocreate = FALSE;
+			g_clear_error (&err);
+			if (!(err = _m2_container_create (args)))
+				goto retry;
 		}
 	}
 
-	if (jbody)
-		json_object_put (jbody);
-	json_tokener_free (parser);
 	return _reply_m2_error (args, err);
 }
 
@@ -1706,29 +2042,50 @@ action_content_prepare (struct req_args_s *args)
     return rest_action (args, action_m2_content_beans);
 }
 
-enum http_rc_e
-action_content_show (struct req_args_s *args)
+static enum http_rc_e
+_reply_content_show (struct req_args_s *args, GError *err,
+		struct m2v2_reply_s *reply)
 {
 	GSList *beans = NULL;
-	GError *hook (struct meta1_service_url_s *m2, gboolean *next) {
-		(void) next;
-		return m2v2_remote_execute_GET (m2->host, args->url, 0, &beans);
-	}
-	GError *err = _resolve_meta2 (args, hook);
+	if (!err)
+		err = m2v2_reply_decode_beans (reply, &beans);
 	return _reply_simplified_beans (args, err, beans, TRUE);
 }
 
 enum http_rc_e
-action_content_delete (struct req_args_s *args)
+action_content_show (struct req_args_s *args)
 {
-	GError *hook (struct meta1_service_url_s *m2, gboolean *next) {
-		(void) next;
-		return m2v2_remote_execute_DEL (m2->host, args->url);
-	}
-	GError *err = _resolve_meta2 (args, hook);
+	return _resolve_meta2_async (args, m2v2_remote_pack_GET (args->url, 0),
+			_reply_content_show);
+}
+
+static enum http_rc_e
+_reply_content_delete (struct req_args_s *args, GError *err,
+		struct m2v2_reply_s *reply)
+{
+	(void) reply;
 	return _reply_m2_error (args, err);
 }
 
+enum http_rc_e
+action_content_delete (struct req_args_s *args)
+{
+	return _resolve_meta2_async (args, m2v2_remote_pack_DEL (args->url),
+			_reply_content_delete);
+}
+
+enum http_rc_e
+action_content_create_many (struct req_args_s *args)
+{
+	return rest_action (args, action_m2_content_create_many);
+}
+
+enum http_rc_e
+action_content_delete_many (struct req_args_s *args)
+{
+	return rest_action (args, action_m2_content_delete_many);
+}
+
 enum http_rc_e
 action_content_touch (struct req_args_s *args)
 {
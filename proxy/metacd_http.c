@@ -46,6 +46,8 @@ static guint dir_low_ttl = PROXYD_DEFAULT_TTL_SERVICES;
 static guint dir_low_max = PROXYD_DEFAULT_MAX_SERVICES;
 static guint dir_high_ttl = PROXYD_DEFAULT_TTL_CSM0;
 static guint dir_high_max = PROXYD_DEFAULT_MAX_CSM0;
+static GString *dir_shared_path = NULL;
+static guint dir_shared_max = PROXYD_DEFAULT_MAX_SERVICES;
 gboolean flag_cache_enabled = TRUE;
 
 struct grid_lbpool_s *lbpool = NULL;
@@ -101,6 +103,17 @@ action_status(struct req_args_s *args)
 	g_string_append_printf(gstr, "gauge cache.srv.ttl = %lu\n", s.services.ttl);
 	g_string_append_printf(gstr, "gauge cache.srv.clock = %lu\n", s.clock);
 
+	g_string_append_printf(gstr, "gauge cache.m1map.prefixes = %u\n", s.m1map.assigned);
+	g_string_append_printf(gstr, "gauge cache.m1map.sets = %u\n", s.m1map.sets);
+	g_string_append_printf(gstr, "gauge cache.m1map.loaded = %lu\n", s.m1map.loaded);
+
+	struct gridd_client_cnx_stats_s cs = {0};
+	gridd_client_cnx_stats (&cs);
+	g_string_append_printf(gstr, "counter client.cnx.connected = %"G_GUINT64_FORMAT"\n", cs.connected);
+	g_string_append_printf(gstr, "counter client.cnx.reused = %"G_GUINT64_FORMAT"\n", cs.reused);
+	g_string_append_printf(gstr, "counter client.cnx.dropped = %"G_GUINT64_FORMAT"\n", cs.dropped);
+	g_string_append_printf(gstr, "gauge client.cnx.idle = %u\n", cs.idle);
+
 	gint64 count_down = 0;
 	SRV_DO(count_down = lru_tree_count(srv_down));
 	g_string_append_printf(gstr, "gauge down.srv = %"G_GINT64_FORMAT"\n",
@@ -113,48 +126,6 @@ action_status(struct req_args_s *args)
 	return HTTPRC_DONE;
 }
 
-static struct path_matching_s **
-_metacd_match (const gchar *method, const gchar *path)
-{
-	gsize lp = strlen(path), lm = strlen(method);
-	if (lp > PROXYD_PATH_MAXLEN || lm > 64)
-		return g_malloc0(sizeof(struct path_matching_s*));
-
-	gchar *key = g_alloca (lp + 2 + lm + 1);
-	gchar *pk = key;
-
-	// Copy and purify the path
-	register int slash = 1;
-	for (register const gchar *p = path; *p ;++p) {
-		if (slash && *p == '/')
-			continue;
-		slash = 0;
-		*(pk++) = *p;
-	}
-
-	// add a separator
-	if (*(pk-1) != '/')
-		*(pk++) = '/';
-	*(pk++) = '#';
-
-	// copy the method without slashes
-	for (register const gchar *p = method; *p ;++p) {
-		if (*p != '/')
-			*(pk++) = *p;
-	}
-	*pk = '\0';
-
-	GRID_TRACE2("matching [%s]", key);
-	gchar **tokens = g_strsplit (key, "/", -1);
-	for (gchar **p=tokens; *p ;++p) {
-		gchar *unescaped = g_uri_unescape_string(*p,NULL);
-		oio_str_reuse(p, unescaped);
-	}
-	struct path_matching_s **result = path_parser_match (path_parser, tokens);
-	g_strfreev (tokens);
-	return result;
-}
-
 static struct oio_url_s *
 _metacd_load_url (struct req_args_s *args)
 {
@@ -208,7 +179,8 @@ handler_action (struct http_request_s *rq, struct http_reply_ctx_s *rp)
 	struct oio_requri_s ruri = {NULL, NULL, NULL, NULL};
 	oio_requri_parse (rq->req_uri, &ruri);
 
-	struct path_matching_s **matchings = _metacd_match (rq->cmd, ruri.path);
+	struct path_matching_s **matchings =
+		path_parser_match_request (path_parser, rq->cmd, ruri.path);
 
 	GRID_TRACE2("URI path[%s] query[%s] fragment[%s] matches[%u]",
 			ruri.path, ruri.query, ruri.fragment,
@@ -243,11 +215,11 @@ handler_action (struct http_request_s *rq, struct http_reply_ctx_s *rp)
 		rc = (*handler) (&args);
 	}
 
-	gint64 spent = oio_ext_monotonic_time () - rq->client->time.evt_in;
-
-	network_server_stat_push4 (rq->client->server, TRUE,
-			gq_count, 1, gq_count_all, 1,
-			gq_time, spent, gq_time_all, spent);
+	/* a deferred action is accounted once replied */
+	if (rc != HTTPRC_DEFERRED) {
+		gint64 spent = oio_ext_monotonic_time () - rq->client->time.evt_in;
+		network_server_stat_request (rq->client->server, gq_count, gq_time, spent);
+	}
 
 	path_matching_cleanv (matchings);
 	oio_requri_clear (&ruri);
@@ -559,6 +531,11 @@ grid_main_get_options (void)
 			"Directory 'high' (cs+meta0) TTL for cache elements"},
 		{"DirHighMax", OT_UINT, {.u = &dir_high_max},
 			"Directory 'high' (cs+meta0) MAX cached elements"},
+		{"DirShared", OT_STRING, {.str = &dir_shared_path},
+			"Path to a file (on a tmpfs) holding a directory cache shared\n"
+			"\t\tby the processes of the host, behind the local cache"},
+		{"DirSharedMax", OT_UINT, {.u = &dir_shared_max},
+			"Directory shared cache MAX elements"},
 		{NULL, 0, {.i = 0}, NULL}
 	};
 
@@ -631,6 +608,10 @@ grid_main_specific_fini (void)
 
 	g_slist_free_full (config_urlv, g_free);
 	config_urlv = NULL;
+	if (dir_shared_path) {
+		g_string_free (dir_shared_path, TRUE);
+		dir_shared_path = NULL;
+	}
 }
 
 static void
@@ -701,6 +682,8 @@ configure_request_handlers (void)
     SET("/$NS/content/create/#POST", action_content_put);
     SET("/$NS/content/link/#POST", action_content_link);
     SET("/$NS/content/delete/#POST", action_content_delete);
+    SET("/$NS/content/create_many/#POST", action_content_create_many);
+    SET("/$NS/content/delete_many/#POST", action_content_delete_many);
     SET("/$NS/content/show/#GET", action_content_show);
     SET("/$NS/content/prepare/#POST", action_content_prepare);
     SET("/$NS/content/get_properties/#POST", action_content_prop_get);
@@ -780,6 +763,18 @@ grid_main_configure (int argc, char **argv)
 	hc_resolver_set_max_services (resolver, dir_low_max);
 	GRID_INFO ("RESOLVER limits HIGH[%u/%u] LOW[%u/%u]",
 		dir_high_max, dir_high_ttl, dir_low_max, dir_low_ttl);
+	if (flag_cache_enabled && dir_shared_path && dir_shared_path->len) {
+		struct oio_cache_s *shared = oio_cache_make_shm (dir_shared_path->str,
+				dir_shared_max, dir_low_ttl);
+		if (!shared) {
+			GRID_ERROR ("Failed to map the shared directory cache [%s]",
+					dir_shared_path->str);
+			return FALSE;
+		}
+		hc_resolver_set_shared (resolver, shared);
+		GRID_INFO ("RESOLVER shared cache [%s] MAX[%u]",
+				dir_shared_path->str, dir_shared_max);
+	}
 
 	srv_registered = _push_queue_create ();
 
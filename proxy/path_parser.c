@@ -46,10 +46,10 @@ static struct trie_node_s ** _trie_insert (const struct trie_node_s *,
 		struct trie_node_s **, gchar **, const char*, gpointer);
 
 /* Recursively run the tree */
-static GSList * _trie_explore (struct trie_node_s **, gchar **,
-		const struct path_matching_s *);
+static GSList * _trie_explore (struct trie_node_s **, gchar **);
 
-static struct path_matching_s * _match_dup (const struct path_matching_s *m0);
+static struct path_matching_s * _match_build (const struct trie_node_s *last,
+		gchar **needle);
 
 static void _match_free (struct path_matching_s *);
 
@@ -75,8 +75,7 @@ path_parser_clean (struct path_parser_s *self)
 struct path_matching_s **
 path_parser_match (struct path_parser_s *self, gchar **tokens)
 {
-	struct path_matching_s nomatch = {NULL,NULL};
-	GSList *lmatch = _trie_explore (self->roots, tokens, &nomatch);
+	GSList *lmatch = _trie_explore (self->roots, tokens);
 
 	struct path_matching_s **p, **result;
 	p = result = g_try_malloc0 ((1 + g_slist_length(lmatch)) * sizeof (struct path_matching_s*));
@@ -86,6 +85,61 @@ path_parser_match (struct path_parser_s *self, gchar **tokens)
 	return result;
 }
 
+struct path_matching_s **
+path_parser_match_request (struct path_parser_s *self,
+		const char *method, const char *path)
+{
+	EXTRA_ASSERT (self != NULL);
+	EXTRA_ASSERT (method != NULL);
+	EXTRA_ASSERT (path != NULL);
+
+	const gsize lp = strlen (path), lm = strlen (method);
+	if (lp > PROXYD_PATH_MAXLEN || lm > 64)
+		return g_malloc0 (sizeof(struct path_matching_s*));
+
+	/* All the tokens are written in the same buffer, with a separate
+	 * token for the method */
+	gchar *buf = g_alloca (lp + lm + 3);
+	gchar **tokens = g_alloca ((lp + 3) * sizeof(gchar*));
+	gchar *pk = buf;
+	guint count = 0;
+
+	while (*path == '/')
+		++ path;
+	tokens[count++] = pk;
+	for (const gchar *p = path; *p ;++p) {
+		if (*p == '/') {
+			*(pk++) = '\0';
+			tokens[count++] = pk;
+		} else if (*p != '%') {
+			*(pk++) = *p;
+		} else {
+			/* Unescaped in place, as g_uri_unescape_string() would do.
+			 * Like it, the NUL character is refused. */
+			const gint h = g_ascii_xdigit_value (p[1]);
+			const gint l = h < 0 ? -1 : g_ascii_xdigit_value (p[2]);
+			if (l < 0 || !(h|l))
+				return g_malloc0 (sizeof(struct path_matching_s*));
+			*(pk++) = (h << 4) | l;
+			p += 2;
+		}
+	}
+
+	if (pk != tokens[count-1]) {
+		*(pk++) = '\0';
+		tokens[count++] = pk;
+	}
+	*(pk++) = '#';
+	for (const gchar *p = method; *p ;++p) {
+		if (*p != '/')
+			*(pk++) = *p;
+	}
+	*pk = '\0';
+	tokens[count] = NULL;
+
+	return path_parser_match (self, tokens);
+}
+
 void
 path_parser_configure (struct path_parser_s *self, const char *descr, void *u)
 {
@@ -129,11 +183,23 @@ path_matching_get_variable (struct path_matching_s *self, const char *name)
 /* ------------------------------------------------------------------------- */
 
 struct path_matching_s *
-_match_dup (const struct path_matching_s *m0)
+_match_build (const struct trie_node_s *last, gchar **needle)
 {
+	guint count = 0;
+	for (const struct trie_node_s *n = last; n ;n = n->parent)
+		count += (n->var != NULL);
+
 	struct path_matching_s *m = SLICE_NEW (struct path_matching_s);
-	m->last = m0->last;
-	m->vars = m0->vars ? g_strdupv (m0->vars) : g_try_malloc0 (sizeof(gchar*));
+	m->last = last;
+	m->vars = g_malloc0 ((count + 1) * sizeof(gchar*));
+
+	/* <needle> was consumed by <last>, the previous by its parent, etc */
+	for (const struct trie_node_s *n = last; ;--needle) {
+		if (n->var)
+			m->vars[--count] = g_strconcat (n->var, "=", *needle, NULL);
+		if (!(n = n->parent))
+			break;
+	}
 	return m;
 }
 
@@ -286,42 +352,27 @@ _trie_insert (const struct trie_node_s *parent, struct trie_node_s **tab,
 }
 
 GSList *
-_trie_explore (struct trie_node_s **tab, gchar **needles,
-		const struct path_matching_s *current_match)
+_trie_explore (struct trie_node_s **tab, gchar **needles)
 {
 	GSList *matches = NULL;
 
-	void step (struct path_matching_s *m) {
+	EXTRA_ASSERT (needles && *needles);
+
+	/* Nothing is allocated until a final match is found */
+	for (; *tab ;++tab) {
+		const struct trie_node_s *n = *tab;
+		if (n->word && 0 != strcmp (*needles, n->word))
+			continue;
 		if (!needles[1]) { // potential final match
-			if (!(*tab)->u) // we matched nothing
-				_match_free (m);
-			else // final match found
-				matches = g_slist_prepend (matches, m);
+			if (n->u)
+				matches = g_slist_prepend (matches, _match_build (n, needles));
 		} else { // only a partial match, so we recurse
-			GSList *local_matches = _trie_explore ((*tab)->next, needles+1, m);
-			_match_free (m);
+			GSList *local_matches = _trie_explore (n->next, needles+1);
 			if (local_matches)
 				matches = metautils_gslist_precat (matches, local_matches);
 		}
 	}
 
-	EXTRA_ASSERT (needles && *needles);
-
-	for (; *tab ;++tab) {
-		if ((*tab)->word) { // Explicit word
-			if (0 != strcmp (*needles, (*tab)->word))
-				continue;
-			struct path_matching_s *m = _match_dup (current_match);
-			m->last = *tab;
-			step (m);
-		} else { // Wildcard
-			struct path_matching_s *m = _match_dup (current_match);
-			m->last = *tab;
-			m->vars = oio_strv_append (m->vars, g_strdup_printf("%s=%s", (*tab)->var, *needles));
-			step (m);
-		}
-	}
-
 	return matches;
 }
 
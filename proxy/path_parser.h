@@ -60,6 +60,12 @@ void path_parser_configure (struct path_parser_s *self,
 struct path_matching_s ** path_parser_match (struct path_parser_s *self,
 		gchar **tokens);
 
+/* Splits the <path> of a request in URI-unescaped tokens, appends the
+ * <method> as a last "#<method>" token, then matches them. The leading
+ * slashes are ignored. */
+struct path_matching_s ** path_parser_match_request (struct path_parser_s *self,
+		const char *method, const char *path);
+
 void path_parser_foreach (struct path_parser_s *self,
 		void (*hook) (const struct trie_node_s *n));
 
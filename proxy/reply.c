@@ -24,7 +24,10 @@ _create_status (gint code, const gchar * msg)
 {
 	GString *gstr = g_string_sized_new (256);
 	g_string_append_c (gstr, '{');
-	g_string_append_printf (gstr, "\"status\":%d,\"message\":\"%s\"", code, msg);
+	OIO_JSON_KEY(gstr, "status");
+	oio_json_append_int (gstr, code);
+	OIO_JSON_NEXT_KEY(gstr, "message");
+	oio_json_append_string (gstr, msg);
 	g_string_append_c (gstr, '}');
 	return gstr;
 }
@@ -69,6 +69,26 @@ _abstract_sqlx_action (struct req_args_s *args, gboolean next,
 	return err;
 }
 
+/* "<host>":"OK" */
+static void
+_append_host_ok (GString *out, const char *host)
+{
+	oio_json_append_string (out, host);
+	OIO_JSON_LITERAL(out, ":\"OK\"");
+}
+
+/* "<host>":{"code":"<code>","msg":"<message>"}, the code is a string */
+static void
+_append_host_error (GString *out, const char *host, GError *e)
+{
+	oio_json_append_string (out, host);
+	OIO_JSON_LITERAL(out, ":{\"code\":\"");
+	oio_json_append_int (out, e->code);
+	OIO_JSON_LITERAL(out, "\",\"msg\":");
+	oio_json_append_string (out, e->message);
+	g_string_append_c (out, '}');
+}
+
 #define SQLX_NEXT    0x01
 #define SQLX_NOREDIR 0x02
 
@@ -101,11 +121,9 @@ _sqlx_action_noreturn (struct req_args_s *args, guint32 flags,
 			g_string_append (out, ",\n");
 		first = FALSE;
 		if (!e)
-			g_string_append_printf (out, "\"%s\":\"%s\"", m1u->host, "OK");
+			_append_host_ok (out, m1u->host);
 		else {
-			g_string_append_printf (out,
-					"\"%s\":{\"code\":\"%u\",\"msg\":\"%s\"}",
-					m1u->host, e->code, e->message);
+			_append_host_error (out, m1u->host, e);
 		}
 		g_free0(msg);
 		return e;
@@ -135,13 +153,13 @@ _sqlx_action_flatbody (struct req_args_s *args, guint32 flags,
 		if (!first)
 			g_string_append (out, ",\n");
 		first = FALSE;
-		if (!e)
-			g_string_append_printf (out, "\"%s\":\"%.*s\"", m1u->host,
-					body->len, (gchar*) body->data);
-		else {
-			g_string_append_printf (out,
-					"\"%s\":{\"code\":\"%u\",\"msg\":\"%s\"}",
-					m1u->host, e->code, e->message);
+		if (!e) {
+			oio_json_append_string (out, m1u->host);
+			g_string_append_c (out, ':');
+			oio_json_append_stringn (out,
+					body->len ? (gchar*) body->data : "", body->len);
+		} else {
+			_append_host_error (out, m1u->host, e);
 			g_clear_error (&e);
 		}
 		if (body)
@@ -249,11 +267,9 @@ action_sqlx_copyto (struct req_args_s *args, struct json_object *jargs)
 			g_string_append_c (out, ',');
 		first = FALSE;
 		if (!e)
-			g_string_append_printf (out, "\"%s\":\"%s\"", m1u->host, "OK");
+			_append_host_ok (out, m1u->host);
 		else {
-			g_string_append_printf (out,
-					"\"%s\":{\"code\":\"%u\",\"msg\":\"%s\"}",
-					m1u->host, e->code, e->message);
+			_append_host_error (out, m1u->host, e);
 			g_clear_error (&e);
 		}
 		return NULL;
@@ -338,11 +354,13 @@ action_sqlx_propget (struct req_args_s *args, struct json_object *jargs)
 		struct key_value_pair_s *kv = l->data;
 		if (!kv)
 			continue;
+		oio_json_append_string (out, kv->key);
+		g_string_append_c (out, ':');
 		if (!kv->value)
-			g_string_append_printf (out, "\"%s\":null", kv->key);
+			OIO_JSON_LITERAL(out, "null");
 		else
-			g_string_append_printf (out, "\"%s\":\"%.*s\"",
-					kv->key, kv->value->len, (gchar*) kv->value->data);
+			oio_json_append_stringn (out, kv->value->len
+					? (gchar*) kv->value->data : "", kv->value->len);
 	}
 	g_string_append_c (out, '}');
 
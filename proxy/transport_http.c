@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <server/network_server.h>
 #include <server/stats_holder.h>
 
+#include "http_parser.h"
 #include "transport_http.h"
 
 struct transport_client_context_s
@@ -33,6 +34,21 @@ struct transport_client_context_s
 	struct http_parser_s *parser;
 	struct http_request_s *request;
 	http_handler_f handler;
+
+	/* set while the current request waits for its deferred reply */
+	struct http_deferred_s *deferred;
+};
+
+struct http_deferred_s
+{
+	struct network_client_s *client;
+	http_resume_f resume;
+	gpointer udata;
+
+	/* what the access log needs to know of the deferred request */
+	gint64 tv_start, tv_parsed;
+	gchar *uid;
+	gboolean access_disabled;
 };
 
 struct req_ctx_s
@@ -52,221 +68,9 @@ struct req_ctx_s
 
 static int http_notify_input(struct network_client_s *clt);
 
-//------------------------------------------------------------------------------
-
-enum http_parser_step_e
-{
-	STEP_FIRST_R0, STEP_FIRST_N0,
-	STEP_SEP_R0, STEP_SEP_N0,
-	STEP_HEADERS_R0, STEP_HEADERS_N0,
-	STEP_BODY_ASIS
-};
-
-struct http_parser_s
-{
-	enum http_parser_step_e step;
-	GError *error;
-	GString *buf;
-
-	gint64 content_read;
-	gint64 content_length;
-	void (*command_provider)(const gchar *req, const gchar *sel, const gchar *ver);
-	void (*header_provider)(const gchar *name, const gchar *value);
-	void (*body_provider)(const guint8 *data, gsize data_len);
-};
-
-struct http_parsing_result_s
-{
-	gsize consumed;
-	enum { HPRC_SUCCESS = 0, HPRC_MORE, HPRC_ERROR } status;
-};
-
-static void
-gstr_chomp(GString *gstr)
-{
-	if (!gstr)
-		return;
-	gchar *start, *end;
-	start = gstr->str;
-	end = start + gstr->len;
-	while (end > start && (*(end-1) == '\n' || *(end-1) == '\r'))
-		*(--end) = '\0';
-}
-
-static gboolean
-_manage_and_renew_command(struct http_parser_s *parser, GString *buf)
-{
-	gchar *cmd, *selector, *version;
-
-	if (!buf->len)
-		return FALSE;
-
-	gstr_chomp(buf);
-	cmd = buf->str;
-	selector = strchr(cmd, ' ');
-	if (!selector)
-		return FALSE;
-	*(selector++) = '\0';
-	version = strrchr(selector, ' ');
-	if (!version)
-		return FALSE;
-	*(version++) = '\0';
-
-	if (parser->command_provider)
-		parser->command_provider(cmd, selector, version);
-
-	g_string_set_size(buf, 0);
-	return TRUE;
-}
+static void http_notify_resume(struct network_client_s *clt);
 
-static gboolean
-_manage_and_renew_header(struct http_parser_s *parser, GString *buf)
-{
-	if (!buf->len)
-		return TRUE;
-
-	gstr_chomp(buf);
-	gchar *header = buf->str;
-	gchar *sep = strchr(header, ':');
-	if (!sep)
-		return FALSE;
-	*(sep++) = '\0';
-	if (*(sep++) != ' ')
-		return FALSE;
-
-	if (!g_ascii_strcasecmp(header, "Content-Length"))
-		parser->content_length = g_ascii_strtoll(sep, NULL, 10);
-
-	if (parser->header_provider)
-		parser->header_provider(header, sep);
-
-	g_string_set_size(buf, 0);
-	return TRUE;
-}
-
-static struct http_parsing_result_s
-http_parse(struct http_parser_s *parser, const guint8 *data, gsize available)
-{
-	gsize consumed = 0;
-
-	struct http_parsing_result_s _build_rc(int status, const gchar *msg) {
-		struct http_parsing_result_s rc;
-		if (msg)
-			parser->error = NEWERROR(0, "%s", msg);
-		rc.status = status;
-		rc.consumed = consumed;
-		return rc;
-	}
-
-	while (consumed < available) {
-		guint8 d = data[consumed];
-		gint64 max;
-		switch (parser->step) {
-
-			case STEP_FIRST_R0:
-				if (d == '\r')
-					parser->step = STEP_FIRST_N0;
-				else
-					g_string_append_c(parser->buf, d);
-				++ consumed;
-				continue;
-
-			case STEP_FIRST_N0:
-				if (d == '\n') {
-					if (!_manage_and_renew_command(parser, parser->buf))
-						return _build_rc(HPRC_ERROR, "CMD parsing error");
-					parser->step = STEP_SEP_R0;
-					++ consumed;
-					continue;
-				}
-				return _build_rc(HPRC_ERROR, "CMD parsing error");
-
-			case STEP_SEP_R0:
-				if (d == '\r')
-					parser->step = STEP_SEP_N0;
-				else {
-					if (!_manage_and_renew_header(parser, parser->buf))
-						return _build_rc(HPRC_ERROR, "HDR parsing error");
-					g_string_append_c(parser->buf, d);
-					parser->step = STEP_HEADERS_R0;
-				}
-				++ consumed;
-				continue;
-
-			case STEP_SEP_N0:
-				if (d == '\n') {
-					++ consumed;
-					if (!_manage_and_renew_header(parser, parser->buf))
-						return _build_rc(HPRC_ERROR, "HDR parsing error");
-					parser->step = STEP_BODY_ASIS;
-					if (parser->content_read >= parser->content_length)
-						return _build_rc(HPRC_SUCCESS, NULL);
-					continue;
-				}
-				return _build_rc(HPRC_ERROR, "SEP parsing error");
-
-			case STEP_HEADERS_R0:
-				if (d == '\r')
-					parser->step = STEP_HEADERS_N0;
-				else
-					g_string_append_c(parser->buf, d);
-				++ consumed;
-				continue;
-
-			case STEP_HEADERS_N0:
-				if (d == '\n') {
-					parser->step = STEP_SEP_R0;
-					++ consumed;
-					continue;
-				}
-				return _build_rc(HPRC_ERROR, "HDR parsing error");
-
-			case STEP_BODY_ASIS:
-				max = available - consumed;
-				if (max > (parser->content_length - parser->content_read))
-					max = parser->content_length - parser->content_read;
-				if (parser->body_provider)
-					parser->body_provider(data+consumed, max);
-				consumed += max;
-				parser->content_read += max;
-
-				if (parser->content_read >= parser->content_length)
-					return _build_rc(HPRC_SUCCESS, NULL);
-				continue;
-		}
-	}
-
-	return _build_rc(HPRC_MORE, NULL);
-}
-
-static void
-http_parser_reset(struct http_parser_s *parser)
-{
-	parser->step = STEP_FIRST_R0;
-	g_string_set_size(parser->buf, 0);
-	parser->content_read = 0;
-	parser->content_length = -1;
-	if (parser->error)
-		g_clear_error(&parser->error);
-}
-
-static struct http_parser_s*
-http_parser_create(void)
-{
-	struct http_parser_s *parser = g_malloc0(sizeof(struct http_parser_s));
-	parser->buf = g_string_sized_new(1024);
-	http_parser_reset(parser);
-	return parser;
-}
-
-static void
-http_parser_destroy(struct http_parser_s *parser)
-{
-	if (!parser)
-		return;
-	g_string_free(parser->buf, TRUE);
-	g_free(parser);
-}
+//------------------------------------------------------------------------------
 
 static gint
 _cmp (gconstpointer p0, gconstpointer p1, gpointer p2)
@@ -315,6 +119,10 @@ http_context_clean(struct transport_client_context_s *ctx)
 		http_parser_destroy(ctx->parser);
 	if (ctx->request)
 		http_request_clean(ctx->request);
+	if (ctx->deferred) {
+		oio_str_clean(&ctx->deferred->uid);
+		g_free(ctx->deferred);
+	}
 	g_free(ctx);
 }
 
@@ -334,6 +142,7 @@ transport_http_factory0(http_handler_f hdl, struct network_client_s *client)
 	transport->clean_context = http_context_clean;
 	transport->notify_input = http_notify_input;
 	transport->notify_error = NULL;
+	transport->notify_resume = http_notify_resume;
 
 	network_client_allow_input(client, TRUE);
 }
@@ -391,8 +200,10 @@ _access_log(struct req_ctx_s *r, gint status, gsize out_len, const gchar *tail)
 	g_string_free(gstr, TRUE);
 }
 
+/* Runs the handler on the request of <r>, or the hook of the <resumed>
+ * request. */
 static GError *
-http_manage_request(struct req_ctx_s *r)
+http_manage_request(struct req_ctx_s *r, struct http_deferred_s *resumed)
 {
 	gboolean finalized = 0;
 	int code = HTTP_CODE_INTERNAL_ERROR;
@@ -517,6 +328,18 @@ http_manage_request(struct req_ctx_s *r)
 		r->access_disabled = TRUE;
 	}
 
+	struct http_deferred_s * defer (http_resume_f resume, gpointer udata) {
+		EXTRA_ASSERT(!finalized);
+		EXTRA_ASSERT(r->context->deferred == NULL);
+		struct http_deferred_s *d = g_malloc0(sizeof(struct http_deferred_s));
+		d->client = r->client;
+		d->resume = resume;
+		d->udata = udata;
+		r->context->deferred = d;
+		network_client_defer(r->client);
+		return d;
+	}
+
 	void final_error(int c_, const char *m_) {
 		if (!finalized) {
 			set_body(NULL, 0);
@@ -541,6 +364,7 @@ http_manage_request(struct req_ctx_s *r)
 		.finalize = finalize,
 		.access_tail = access_tail,
 		.no_access = no_access,
+		.defer = defer,
 	};
 
 	finalized = FALSE;
@@ -553,13 +377,21 @@ http_manage_request(struct req_ctx_s *r)
 		return NULL;
 	}
 
-	enum http_rc_e rc = r->context->handler (r->request, &reply);
+	enum http_rc_e rc = resumed
+		? resumed->resume (resumed->udata, r->request, &reply)
+		: r->context->handler (r->request, &reply);
 	switch (rc) {
 		case HTTPRC_DONE:
 			EXTRA_ASSERT(finalized != FALSE);
 			cleanup();
 			oio_ext_set_reqid (NULL);
 			return NULL;
+		case HTTPRC_DEFERRED:
+			EXTRA_ASSERT(!finalized);
+			EXTRA_ASSERT(r->context->deferred != NULL);
+			cleanup();
+			oio_ext_set_reqid (NULL);
+			return NULL;
 		case HTTPRC_ABORT:
 			final_error(HTTP_CODE_INTERNAL_ERROR, "Internal error");
 			oio_ext_set_reqid (NULL);
@@ -574,11 +406,66 @@ http_manage_request(struct req_ctx_s *r)
 
 //------------------------------------------------------------------------------
 
+/* Once the request of <r> has been replied, prepares the next one. Returns
+ * TRUE when the connection won't serve any other request. */
+static gboolean
+http_request_done(struct req_ctx_s *r, GError *err)
+{
+	struct network_client_s *clt = r->client;
+
+	http_parser_reset(r->context->parser);
+	http_request_clean(r->request);
+	r->request = r->context->request = http_request_create(clt);
+
+	if (err) {
+		GRID_INFO("Request management error : %d %s", err->code, err->message);
+		g_clear_error(&err);
+		network_client_allow_input(clt, FALSE);
+		network_client_close_output(clt, 0);
+		return TRUE;
+	}
+	if (r->close_after_request) {
+		GRID_DEBUG("No connection keep-alive, closing.");
+		network_client_allow_input(clt, FALSE);
+		network_client_close_output(clt, 0);
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/* Answers a request whose head could not be parsed. The connection is not
+ * reused, the end of that request is unknown. */
+static void
+http_request_malformed(struct req_ctx_s *r)
+{
+	GString *buf = g_string_sized_new(128);
+	g_string_append(buf, "HTTP/1.1 400 Bad request\r\n");
+	g_string_append_printf(buf, "Server: oio-proxy/%s\r\n", OIOSDS_API_VERSION);
+	g_string_append(buf, "Connection: Close\r\n");
+	g_string_append(buf, "Content-Length: 0\r\n\r\n");
+	network_client_send_slab(r->client, data_slab_make_gstr(buf));
+	_access_log(r, HTTP_CODE_BAD_REQUEST, 0, NULL);
+}
+
+/* Keeps in the deferred reply what it needs of the request of <r> */
 static void
-_lower(gchar *s)
+http_request_deferred(struct req_ctx_s *r)
 {
-	for (; *s ;++s)
-		*s = g_ascii_tolower(*s);
+	struct http_deferred_s *d = r->context->deferred;
+	d->tv_start = r->tv_start;
+	d->tv_parsed = r->tv_parsed;
+	d->access_disabled = r->access_disabled;
+	oio_str_reuse(&d->uid, r->uid);
+	r->uid = NULL;
+}
+
+/* The bytes of a slab given by data_slab_consume() but not parsed yet */
+static void
+_slab_unconsume(struct data_slab_s *slab, gsize len)
+{
+	EXTRA_ASSERT(slab->type == STYPE_BUFFER || slab->type == STYPE_BUFFER_STATIC);
+	EXTRA_ASSERT(slab->data.buffer.start >= len);
+	slab->data.buffer.start -= len;
 }
 
 static int
@@ -586,15 +473,19 @@ http_notify_input(struct network_client_s *clt)
 {
 	struct req_ctx_s r = {0};
 
-	void command_provider(const gchar *c, const gchar *s, const gchar *v) {
-		r.request->cmd = g_strdup(c);
-		r.request->req_uri = g_strdup(s);
-		r.request->version = g_strdup(v);
+	/* The input waits for the reply of the current request */
+	if (clt->transport.client_context->deferred)
+		return RC_NOTREADY;
+
+	void command_provider(const gchar *c, gsize cl, const gchar *s, gsize sl,
+			const gchar *v, gsize vl) {
+		r.request->cmd = g_strndup(c, cl);
+		r.request->req_uri = g_strndup(s, sl);
+		r.request->version = g_strndup(v, vl);
 	}
-	void header_provider(const gchar *k0, const gchar *v) {
-		gchar *k = g_strdup(k0);
-		_lower(k);
-		g_tree_replace(r.request->tree_headers, k, g_strdup(v));
+	void header_provider(const gchar *k, gsize kl, const gchar *v, gsize vl) {
+		g_tree_replace(r.request->tree_headers,
+				g_ascii_strdown(k, kl), g_strndup(v, vl));
 	}
 	void body_provider(const guint8 *data, gsize data_len) {
 		g_byte_array_append(r.request->body, data, data_len);
@@ -636,44 +527,44 @@ http_notify_input(struct network_client_s *clt)
 			continue;
 		}
 
-		oio_str_clean (&r.uid);
-
-		struct http_parsing_result_s rc = http_parse(parser, data, data_size);
+		// Several requests may have been pipelined in the same slab
+		gsize offset = 0;
+		while (!done && offset < data_size) {
+			oio_str_clean (&r.uid);
 
-		if (rc.status == HPRC_SUCCESS) {
+			struct http_parsing_result_s rc =
+				http_parse(parser, data + offset, data_size - offset);
+			offset += rc.consumed;
 
-			// Important times are now known.$
-			// First, the last chunk of data received
-			// Second, the moment the real treatment start ... i.e. now!
-			r.tv_start = clt->time.evt_in;
-			r.tv_parsed = oio_ext_monotonic_time ();
+			if (rc.status == HPRC_SUCCESS) {
 
-			GError *err = http_manage_request(&r);
+				// Important times are now known.$
+				// First, the last chunk of data received
+				// Second, the moment the real treatment start ... i.e. now!
+				r.tv_start = clt->time.evt_in;
+				r.tv_parsed = oio_ext_monotonic_time ();
 
-			http_parser_reset(parser);
-			http_request_clean(r.request);
-			r.request = r.context->request = http_request_create(r.client);
+				GError *err = http_manage_request(&r, NULL);
 
-			if (err) {
-				GRID_INFO("Request management error : %d %s", err->code, err->message);
-				g_clear_error(&err);
-				network_client_allow_input(clt, FALSE);
-				network_client_close_output(clt, 0);
-				done = TRUE;
+				if (r.context->deferred && !err) {
+					/* Replied later, the pipelined requests wait for it */
+					http_request_deferred(&r);
+					_slab_unconsume(slab, data_size - offset);
+					done = TRUE;
+				} else {
+					done = http_request_done(&r, err);
+				}
 			}
-			else if (r.close_after_request) {
-				GRID_DEBUG("No connection keep-alive, closing.");
+			else if (rc.status == HPRC_ERROR) {
+				GRID_DEBUG("Request parsing error");
+				r.tv_start = clt->time.evt_in;
+				r.tv_parsed = oio_ext_monotonic_time ();
+				http_request_malformed(&r);
 				network_client_allow_input(clt, FALSE);
 				network_client_close_output(clt, 0);
 				done = TRUE;
 			}
 		}
-		else if (rc.status == HPRC_ERROR) {
-			GRID_DEBUG("Request parsing error");
-			network_client_allow_input(clt, FALSE);
-			network_client_close_output(clt, 0);
-			done = TRUE;
-		}
 
 		data_slab_sequence_unshift(&clt->input, slab);
 	}
@@ -682,6 +573,44 @@ http_notify_input(struct network_client_s *clt)
 	parser->body_provider = NULL;
 	parser->header_provider = NULL;
 	oio_str_clean (&r.uid);
+	if (r.context->deferred)
+		return RC_NOTREADY;
 	return clt->transport.waiting_for_close ? RC_NODATA : RC_PROCESSED;
 }
 
+static void
+http_notify_resume(struct network_client_s *clt)
+{
+	struct req_ctx_s r = {0};
+	r.close_after_request = TRUE;
+	r.client = clt;
+	r.transport = &(clt->transport);
+	r.context = r.transport->client_context;
+	r.request = r.context->request;
+
+	struct http_deferred_s *d = r.context->deferred;
+	EXTRA_ASSERT(d != NULL);
+	r.context->deferred = NULL;
+	r.tv_start = d->tv_start;
+	r.tv_parsed = d->tv_parsed;
+	r.access_disabled = d->access_disabled;
+	r.uid = d->uid;
+	d->uid = NULL;
+
+	GError *err = http_manage_request(&r, d);
+	g_free(d);
+
+	/* Deferred again, else the pipelined requests can go on */
+	if (r.context->deferred && !err)
+		http_request_deferred(&r);
+	else if (!http_request_done(&r, err))
+		http_notify_input(clt);
+	oio_str_clean (&r.uid);
+}
+
+void
+http_deferred_resume(struct http_deferred_s *d)
+{
+	EXTRA_ASSERT(d != NULL);
+	network_client_resume(d->client);
+}
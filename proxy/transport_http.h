@@ -40,6 +40,17 @@ struct http_request_s
 	GByteArray *body;
 };
 
+enum http_rc_e { HTTPRC_DONE, HTTPRC_ABORT, HTTPRC_DEFERRED };
+
+struct http_reply_ctx_s;
+
+/* Replies a deferred request, in a worker thread, as a handler does. It
+ * owns <udata>. */
+typedef enum http_rc_e (*http_resume_f) (gpointer udata,
+		struct http_request_s *request, struct http_reply_ctx_s *reply);
+
+struct http_deferred_s;
+
 struct http_reply_ctx_s
 {
 	void (*set_status) (int code, const gchar *msg);
@@ -54,9 +65,13 @@ struct http_reply_ctx_s
 	void (*finalize) (void);
 	void (*access_tail) (const char *fmt, ...);
 	void (*no_access) (void);
-};
 
-enum http_rc_e { HTTPRC_DONE, HTTPRC_ABORT };
+	/* Reply later, without holding the worker: the handler returns
+	 * HTTPRC_DEFERRED without replying, then <resume> replies once
+	 * http_deferred_resume() is called. The next requests pipelined on the
+	 * connection wait until then. */
+	struct http_deferred_s * (*defer) (http_resume_f resume, gpointer udata);
+};
 
 typedef enum http_rc_e (*http_handler_f) (struct http_request_s *request,
 			struct http_reply_ctx_s *reply);
@@ -78,4 +93,7 @@ void transport_http_factory0 (http_handler_f handler,
 const gchar * http_request_get_header(struct http_request_s *req,
 		const gchar *n);
 
+/* Callable from any thread, once per deferred request */
+void http_deferred_resume(struct http_deferred_s *d);
+
 #endif /*OIO_SDS__proxy__transport_http_h*/
@@ -2,6 +2,11 @@ from contextlib import closing
 import hashlib
 import time
 
+try:
+    import xxhash
+except ImportError:
+    xxhash = None
+
 from oio.blob.utils import check_volume, read_chunk_metadata
 from oio.container.client import ContainerClient
 from oio.common.daemon import Daemon
@@ -23,6 +28,7 @@ class BlobAuditorWorker(object):
         self.orphan_chunks = 0
         self.faulty_chunks = 0
         self.corrupted_chunks = 0
+        self.unverified_chunks = 0
         self.last_reported = 0
         self.chunks_run_time = 0
         self.bytes_running_time = 0
@@ -46,6 +52,7 @@ class BlobAuditorWorker(object):
         total_corrupted = 0
         total_orphans = 0
         total_faulty = 0
+        total_unverified = 0
         audit_time = 0
 
         paths = paths_gen(self.volume)
@@ -67,6 +74,7 @@ class BlobAuditorWorker(object):
                     '%(corrupted)d '
                     '%(faulty)d '
                     '%(orphans)d '
+                    '%(unverified)d '
                     '%(errors)d '
                     '%(c_rate).2f '
                     '%(b_rate).2f '
@@ -78,6 +86,7 @@ class BlobAuditorWorker(object):
                         'corrupted': self.corrupted_chunks,
                         'faulty': self.faulty_chunks,
                         'orphans': self.orphan_chunks,
+                        'unverified': self.unverified_chunks,
                         'errors': self.errors,
                         'c_rate': self.passes / (now - report_time),
                         'b_rate': self.bytes_processed / (now - report_time),
@@ -90,11 +99,13 @@ class BlobAuditorWorker(object):
                 total_corrupted += self.corrupted_chunks
                 total_orphans += self.orphan_chunks
                 total_faulty += self.faulty_chunks
+                total_unverified += self.unverified_chunks
                 total_errors += self.errors
                 self.passes = 0
                 self.corrupted_chunks = 0
                 self.orphan_chunks = 0
                 self.faulty_chunks = 0
+                self.unverified_chunks = 0
                 self.errors = 0
                 self.bytes_processed = 0
                 self.last_reported = now
@@ -105,6 +116,7 @@ class BlobAuditorWorker(object):
             '%(corrupted)d '
             '%(faulty)d '
             '%(orphans)d '
+            '%(unverified)d '
             '%(errors)d '
             '%(chunk_rate).2f '
             '%(bytes_rate).2f '
@@ -114,6 +126,7 @@ class BlobAuditorWorker(object):
                 'corrupted': total_corrupted + self.corrupted_chunks,
                 'faulty': total_faulty + self.faulty_chunks,
                 'orphans': total_orphans + self.orphan_chunks,
+                'unverified': total_unverified + self.unverified_chunks,
                 'errors': total_errors + self.errors,
                 'chunk_rate': self.total_chunks_processed / elapsed,
                 'bytes_rate': self.total_bytes_processed / elapsed,
@@ -148,8 +161,13 @@ class BlobAuditorWorker(object):
                 raise exc.FaultyChunk(
                     'Missing extended attribute %s' % e)
             size = int(meta['chunk_size'])
-            md5_checksum = meta['chunk_hash'].lower()
-            reader = ChunkReader(f, size, md5_checksum)
+            checksum = meta['chunk_hash'].lower()
+            hash_method = chunk_hash_method(meta.get('content_chunkmethod'))
+            reader = ChunkReader(f, size, checksum, hash_method)
+            if not reader.verified:
+                self.unverified_chunks += 1
+                self.logger.warn('Unverified chunk %s: no %s checksum',
+                                 path, hash_method)
             with closing(reader):
                 for buf in reader:
                     buf_len = len(buf)
@@ -220,20 +238,48 @@ class BlobAuditor(Daemon):
         time.sleep(SLEEP_TIME)
 
 
+def chunk_hash_method(chunk_method):
+    """The algorithm hashing the chunks, named in the chunk method
+    (e.g. "plain/bytes?hash=xxh64"), md5 by default."""
+    if chunk_method and '?' in chunk_method:
+        for param in chunk_method.split('?', 1)[1].split('&'):
+            key, _, value = param.partition('=')
+            if key == 'hash' and value:
+                return value.lower()
+    return 'md5'
+
+
+def chunk_hasher(hash_method):
+    """A new hash object for the chunk hash algorithm, or None when the
+    algorithm is not available."""
+    if hash_method == 'xxh64':
+        return xxhash.xxh64() if xxhash else None
+    try:
+        return hashlib.new(hash_method)
+    except ValueError:
+        return None
+
+
 class ChunkReader(object):
-    def __init__(self, fp, size, md5_checksum):
+    def __init__(self, fp, size, checksum, hash_method='md5'):
         self.fp = fp
         self.size = size
-        self.md5_checksum = md5_checksum
+        self.checksum = checksum
+        self.hash_method = hash_method
         self.bytes_read = 0
-        self.iter_md5 = None
+        self.iter_hash = chunk_hasher(hash_method)
+
+    @property
+    def verified(self):
+        """False when only the size of the chunk can be checked"""
+        return self.iter_hash is not None
 
     def __iter__(self):
-        self.iter_md5 = hashlib.md5()
         while True:
             buf = self.fp.read()
             if buf:
-                self.iter_md5.update(buf)
+                if self.iter_hash:
+                    self.iter_hash.update(buf)
                 self.bytes_read += len(buf)
                 yield buf
             else:
@@ -241,11 +287,12 @@ class ChunkReader(object):
 
     def close(self):
         if self.fp:
-            self.md5_read = self.iter_md5.hexdigest()
             if self.bytes_read != self.size:
                 raise exc.FaultyChunk('Invalid size for chunk')
 
-            if self.md5_read != self.md5_checksum:
-                raise exc.CorruptedChunk(
-                    'checksum does not match %s != %s'
-                    % (self.md5_read, self.md5_checksum))
+            if self.iter_hash:
+                checksum_read = self.iter_hash.hexdigest()
+                if checksum_read != self.checksum:
+                    raise exc.CorruptedChunk(
+                        'checksum does not match %s != %s'
+                        % (checksum_read, self.checksum))
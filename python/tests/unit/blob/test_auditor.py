@@ -0,0 +1,60 @@
+import unittest
+from cStringIO import StringIO
+
+from mock import patch
+
+from oio.blob import auditor
+from oio.blob.auditor import ChunkReader, chunk_hash_method
+from oio.common import exceptions as exc
+
+
+DATA = 'abc'
+MD5 = '900150983cd24fb0d6963f7d28e17f72'
+XXH64 = '44bc2cf5ad770999'
+
+
+def _read(reader):
+    for _ in reader:
+        pass
+    reader.close()
+
+
+class TestChunkReader(unittest.TestCase):
+    def test_hash_method(self):
+        self.assertEqual(chunk_hash_method(None), 'md5')
+        self.assertEqual(chunk_hash_method('plain/bytes'), 'md5')
+        self.assertEqual(chunk_hash_method('plain/bytes?hash=XXH64'), 'xxh64')
+        self.assertEqual(
+            chunk_hash_method('plain/rain?k=6&m=2&hash=sha256'), 'sha256')
+
+    def test_md5(self):
+        reader = ChunkReader(StringIO(DATA), len(DATA), MD5)
+        self.assertTrue(reader.verified)
+        _read(reader)
+        reader = ChunkReader(StringIO('abd'), len(DATA), MD5)
+        self.assertRaises(exc.CorruptedChunk, _read, reader)
+
+    def test_size(self):
+        reader = ChunkReader(StringIO(DATA), len(DATA) + 1, MD5)
+        self.assertRaises(exc.FaultyChunk, _read, reader)
+
+    def test_xxh64(self):
+        if auditor.xxhash is None:
+            self.skipTest('xxhash not installed')
+        reader = ChunkReader(StringIO(DATA), len(DATA), XXH64, 'xxh64')
+        self.assertTrue(reader.verified)
+        _read(reader)
+        reader = ChunkReader(StringIO('abd'), len(DATA), XXH64, 'xxh64')
+        self.assertRaises(exc.CorruptedChunk, _read, reader)
+
+    def test_unverified(self):
+        # without the module, xxh64 chunks are only checked for their size
+        with patch('oio.blob.auditor.xxhash', None):
+            reader = ChunkReader(StringIO('abd'), len(DATA), XXH64, 'xxh64')
+            self.assertFalse(reader.verified)
+            _read(reader)
+        reader = ChunkReader(StringIO('abd'), len(DATA), 'x', 'crc1')
+        self.assertFalse(reader.verified)
+        _read(reader)
+        reader = ChunkReader(StringIO(DATA), len(DATA) + 1, 'x', 'crc1')
+        self.assertRaises(exc.FaultyChunk, _read, reader)
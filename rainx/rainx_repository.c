@@ -492,6 +492,13 @@ end:
 	void __rain_free(void *ptr) { (void)ptr; }\
 	ENV = (struct rain_env_s){ __rain_malloc, __rain_calloc, __rain_free };
 
+/* Algorithm of the hashes sent to the rawx, taken from the chunk method */
+static enum oio_hash_algo_e
+_chunk_hash_algo(const dav_resource *resource)
+{
+	return oio_hash_algo_of_chunk_method(resource->info->content.chunk_method);
+}
+
 static dav_error *
 rainx_repo_stream_create(const dav_resource *resource, dav_stream **result)
 {
@@ -556,11 +563,7 @@ rainx_repo_stream_create(const dav_resource *resource, dav_stream **result)
 
 	resource->info->response_chunk_list = NULL;
 
-	ds->md5 = g_checksum_new(G_CHECKSUM_MD5);
-	if (ds->md5 == NULL) {
-		return server_create_and_stat_error(conf, pool, HTTP_INTERNAL_SERVER_ERROR,
-				0, "Failed to initialize md5 checksum");
-	}
+	ds->hash = oio_hash_new(_chunk_hash_algo(resource));
 
 	*result = ds;
 
@@ -736,7 +739,7 @@ dav_rainx_close_stream(dav_stream *stream, int commit)
 			"%s.%d", temp_chunk.position, stream->r->info->current_rawx);
 	custom_chunksize = apr_itoa(stream->r->info->request->pool,
 			subchunk_size - stream->r->info->current_chunk_remaining);
-	custom_chunkhash = g_compute_checksum_for_data(G_CHECKSUM_MD5,
+	custom_chunkhash = oio_hash_compute_for_data(_chunk_hash_algo(stream->r),
 			(const guchar*)stream->chunk_start_ptr,
 			subchunk_size - stream->r->info->current_chunk_remaining);
 
@@ -884,7 +887,7 @@ dav_rainx_close_stream(dav_stream *stream, int commit)
 						stream->r->info->current_rawx - rain_params->k);
 				custom_chunksize = apr_itoa(stream->r->info->request->pool,
 						subchunk_size);
-				custom_chunkhash = g_compute_checksum_for_data(G_CHECKSUM_MD5,
+				custom_chunkhash = oio_hash_compute_for_data(_chunk_hash_algo(stream->r),
 						(const guchar*)coding_metachunks[i], subchunk_size);
 				apr_pool_create(&(coding_subpools[i]), stream->pool);
 
@@ -990,9 +993,9 @@ close_stream_error_label:
 	}
 	apr_pool_destroy(subpool);
 	apr_pool_destroy(stream->pool);
-	if (stream->md5) {
-		g_checksum_free (stream->md5);
-		stream->md5 = NULL;
+	if (stream->hash) {
+		oio_hash_free (stream->hash);
+		stream->hash = NULL;
 	}
 	return e;
 }
@@ -1068,7 +1071,7 @@ dav_rainx_write_stream(dav_stream *stream, const void *buf, apr_size_t bufsize)
 					"%s.%d", temp_chunk.position, stream->r->info->current_rawx);
 			char* custom_chunksize = apr_itoa(stream->r->info->request->pool,
 					subchunk_size);
-			char* custom_chunkhash = g_compute_checksum_for_data(G_CHECKSUM_MD5,
+			char* custom_chunkhash = oio_hash_compute_for_data(_chunk_hash_algo(stream->r),
 					(const guchar*)stream->chunk_start_ptr,
 					subchunk_size);
 
@@ -1149,7 +1152,7 @@ dav_rainx_write_stream(dav_stream *stream, const void *buf, apr_size_t bufsize)
 		}
 	}
 
-	g_checksum_update(stream->md5, buf, bufsize);
+	oio_hash_update(stream->hash, buf, bufsize);
 	server_add_stat(resource_get_server_config(stream->r),
 			RAWX_STATNAME_REP_BWRITTEN, bufsize, 0);
 	return NULL;
@@ -1292,8 +1295,8 @@ check_reconstructed_data(const dav_resource *resource, gboolean* failure_array,
 			if (data_to_hash_size < 0)
 				data_to_hash_size = 0;
 
-			char* custom_chunkhash = g_compute_checksum_for_data(
-					G_CHECKSUM_MD5, (const guchar*)datachunks[i],
+			char* custom_chunkhash = oio_hash_compute_for_data(
+					_chunk_hash_algo(resource), (const guchar*)datachunks[i],
 					data_to_hash_size);
 
 			if (custom_chunkhash) {
@@ -1311,8 +1314,8 @@ check_reconstructed_data(const dav_resource *resource, gboolean* failure_array,
 	/* Coding strips */
 	for (int i = 0; i < m; i++) {
 		if (failure_array[k + i]) {
-			char* custom_chunkhash = g_compute_checksum_for_data(
-					G_CHECKSUM_MD5, (const guchar*)codingchunks[i],
+			char* custom_chunkhash = oio_hash_compute_for_data(
+					_chunk_hash_algo(resource), (const guchar*)codingchunks[i],
 					subchunk_size);
 
 			// FIXME: if md5 has special value "?", don't do this check, but
@@ -1414,8 +1417,8 @@ upload_to_rawx(const dav_resource *resource, gboolean* failure_array,
 					"%s.%d", temp_chunk.position, i);
 			char* custom_chunksize = apr_itoa(resource->info->request->pool,
 					byte_count_to_send);
-			char* custom_chunkhash = g_compute_checksum_for_data(
-					G_CHECKSUM_MD5, (const guchar*)datachunks[i],
+			char* custom_chunkhash = oio_hash_compute_for_data(
+					_chunk_hash_algo(resource), (const guchar*)datachunks[i],
 					byte_count_to_send);
 			char* custom_header2 = apr_psprintf(resource->info->request->pool,
 					"%s\n"
@@ -1487,8 +1490,8 @@ upload_to_rawx(const dav_resource *resource, gboolean* failure_array,
 					"%s.p%d", temp_chunk.position, i);
 			char* custom_chunksize = apr_itoa(
 					resource->info->request->pool, subchunk_size);
-			char* custom_chunkhash = g_compute_checksum_for_data(
-					G_CHECKSUM_MD5, (const guchar*)codingchunks[i],
+			char* custom_chunkhash = oio_hash_compute_for_data(
+					_chunk_hash_algo(resource), (const guchar*)codingchunks[i],
 					subchunk_size);
 			char* custom_header2 = apr_psprintf(resource->info->request->pool,
 					"%s\n"
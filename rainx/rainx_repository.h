@@ -104,7 +104,7 @@ struct dav_stream {
 
 	struct req_params_store** data_put_params; /* List of thread references for data */
 
-	GChecksum *md5;
+	struct oio_hash_s *hash;
 };
 
 #endif /*OIO_SDS__rainx__rainx_repository_h*/
@@ -67,10 +67,16 @@ _set_chunk_extended_attributes(dav_stream *stream)
 	GError *ge = NULL;
 	dav_error *e = NULL;
 
+	/* When the client told the hash of the chunk, it must match the data */
+	const char *hex = oio_hash_get_string(stream->hash);
+	const char *expected = stream->r->info->chunk.hash;
+	if (expected && expected[0] && 0 != strcmp(expected, hex))
+		return server_create_and_stat_error(resource_get_server_config(stream->r), stream->p,
+				HTTP_BAD_REQUEST, 0, apr_pstrcat(stream->p,
+					"Chunk hash mismatch, expected ", expected, " got ", hex, NULL));
+
 	/* Save the new Chunk's hash in the XATTR, in upppercase! */
-	gchar *hex = g_ascii_strup (g_checksum_get_string(stream->md5), -1);
 	stream->r->info->chunk.hash = apr_pstrdup(stream->p, hex);
-	g_free (hex);
 
 	stream->r->info->chunk.size = apr_psprintf(stream->r->pool, "%d", (int)stream->total_size);
 
@@ -637,6 +643,10 @@ rawx_repo_commit_upload(dav_stream *stream)
 	e = _set_chunk_extended_attributes(stream);
 	if( NULL != e) {
 		DAV_DEBUG_REQ(stream->r->info->request, 0, "Failed to set chunk extended attributes : %s", e->desc);
+		/* the busy file is not kept, the chunk has to be uploaded again */
+		dav_error *e_tmp = rawx_repo_rollback_upload(stream);
+		if (NULL != e_tmp)
+			DAV_ERROR_REQ(stream->r->info->request, 0, "Error while rolling back upload : %s", e_tmp->desc);
 		return e;
 	}
 
@@ -795,7 +805,9 @@ rawx_repo_stream_create(const dav_resource *resource, dav_stream **result)
 		ds->compress_checksum = checksum;
 	}
 
-	ds->md5 = g_checksum_new (G_CHECKSUM_MD5);
+	/* the algorithm is named in the chunk method, MD5 by default */
+	ds->hash = oio_hash_new (oio_hash_algo_of_chunk_method (
+				resource->info->content.chunk_method));
 
 	*result = ds;
 
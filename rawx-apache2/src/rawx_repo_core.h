@@ -79,7 +79,7 @@ struct dav_stream {
 	char *metadata_compress;
 	struct compression_ctx_s comp_ctx;
 
-	GChecksum *md5;
+	struct oio_hash_s *hash;
 	apr_size_t total_size;
 };
 
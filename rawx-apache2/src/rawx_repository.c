@@ -356,9 +356,9 @@ dav_rawx_close_stream(dav_stream *stream, int commit)
 	/* stats update */
 	server_inc_request_stat(resource_get_server_config(stream->r),
 			RAWX_STATNAME_REQ_CHUNKPUT, request_get_duration(stream->r->info->request));
-	if (stream->md5) {
-		g_checksum_free (stream->md5);
-		stream->md5 = NULL;
+	if (stream->hash) {
+		oio_hash_free (stream->hash);
+		stream->hash = NULL;
 	}
 	return e;
 }
@@ -423,7 +423,7 @@ dav_rawx_write_stream(dav_stream *stream, const void *buf, apr_size_t bufsize)
 	stream->compress_checksum = checksum;
 
 	/* update the hash and the stats */
-	g_checksum_update(stream->md5, buf, bufsize);
+	oio_hash_update(stream->hash, buf, bufsize);
 	/* update total_size */
 	stream->total_size += bufsize;
 	server_add_stat(resource_get_server_config(stream->r), RAWX_STATNAME_REP_BWRITTEN, bufsize, 0);
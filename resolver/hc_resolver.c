@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cluster/lib/gridcluster.h>
 #include <meta0v2/meta0_remote.h>
 #include <meta1v2/meta1_remote.h>
+#include <cache/cache.h>
 #include <resolver/hc_resolver_internals.h>
 
 #include <glib.h>
@@ -90,6 +91,9 @@ hc_resolver_element_create (const char * const *value)
 
 /* Public API -------------------------------------------------------------- */
 
+static GError * _m1map_fetch (struct hc_resolver_s *r, const char *ns,
+		GSList **out);
+
 struct hc_resolver_s*
 hc_resolver_create1(time_t now)
 {
@@ -107,6 +111,8 @@ hc_resolver_create1(time_t now)
 
 	resolver->bogonow = now;
 	g_mutex_init(&resolver->lock);
+	g_mutex_init(&resolver->m1map_lock);
+	resolver->m1map_fetch = _m1map_fetch;
 	return resolver;
 }
 
@@ -135,11 +141,27 @@ hc_resolver_notify (struct hc_resolver_s *r,
 	r->service_notifier = notify;
 }
 
+void
+hc_resolver_set_shared (struct hc_resolver_s *r, struct oio_cache_s *l2)
+{
+	g_assert (r != NULL);
+	if (r->shared)
+		oio_cache_destroy (r->shared);
+	r->shared = l2;
+}
+
+static void _m1map_free (struct hc_m1map_s *m);
+
 void
 hc_resolver_destroy(struct hc_resolver_s *r)
 {
 	if (!r)
 		return;
+	_m1map_free(r->m1map);
+	g_slist_free_full(r->m1map_retired, (GDestroyNotify)_m1map_free);
+	g_mutex_clear(&r->m1map_lock);
+	if (r->shared)
+		oio_cache_destroy(r->shared);
 	if (r->csm0.cache)
 		lru_tree_destroy(r->csm0.cache);
 	if (r->services.cache)
@@ -163,6 +185,21 @@ hc_resolver_get_cached(struct hc_resolver_s *r, struct lru_tree_s *lru,
 	}
 	g_mutex_unlock(&r->lock);
 
+	/* Then try the shared cache, and promote the hit in the LRU */
+	if (!result && r->shared && !(r->flags & HC_RESOLVER_NOCACHE)) {
+		gchar *packed = NULL;
+		if (OIO_CACHE_OK == oio_cache_get(r->shared, hashstr_str(k), &packed)) {
+			result = g_strsplit(packed, "\n", -1);
+			g_free(packed);
+			elt = hc_resolver_element_create((const char * const *) result);
+			struct hashstr_s *k1 = hashstr_dup(k);
+			g_mutex_lock(&r->lock);
+			elt->use = r->bogonow;
+			lru_tree_insert(lru, k1, elt);
+			g_mutex_unlock(&r->lock);
+		}
+	}
+
 	return result;
 }
 
@@ -182,6 +219,12 @@ hc_resolver_store(struct hc_resolver_s *r, struct lru_tree_s *lru,
 	elt->use = r->bogonow;
 	lru_tree_insert(lru, k, elt);
 	g_mutex_unlock(&r->lock);
+
+	if (r->shared) {
+		gchar *packed = g_strjoinv("\n", (gchar**) v);
+		oio_cache_put(r->shared, hashstr_str(key), packed);
+		g_free(packed);
+	}
 }
 
 static void
@@ -193,6 +236,8 @@ hc_resolver_forget(struct hc_resolver_s *r, struct lru_tree_s *lru,
 		lru_tree_remove(lru, k);
 		g_mutex_unlock(&r->lock);
 	}
+	if (r->shared)
+		oio_cache_del(r->shared, hashstr_str(k));
 }
 
 /* ------------------------------------------------------------------------- */
@@ -290,6 +335,24 @@ _m0list_to_urlv(GSList *l)
 	return (gchar **) g_ptr_array_free(tmp, FALSE);
 }
 
+/* Move the qualified meta0 first, and shuffle them */
+static void
+_m0_prefer(struct hc_resolver_s *r, const char * const *urlv)
+{
+	if (urlv && *urlv) {
+		gsize len = oio_strv_length(urlv);
+		if (r->service_qualifier) {
+			/* url already contains ip:port, and not meta1_service_url_s */
+			gboolean _wrap (gconstpointer p) {
+				return r->service_qualifier ((const char*)p);
+			}
+			len = oio_ext_array_partition ((void**)urlv, len, _wrap);
+		}
+		if (len > 0 && !oio_dir_no_shuffle)
+			oio_ext_array_shuffle ((void**)urlv, len);
+	}
+}
+
 static GError *
 _resolve_m1_through_one_m0(const char *m0, const guint8 *prefix, gchar ***result)
 {
@@ -318,18 +381,7 @@ _resolve_m1_through_many_m0(struct hc_resolver_s *r, const char * const *urlv,
 {
 	GRID_TRACE2("%s(%02X%02X)", __FUNCTION__, prefix[0], prefix[1]);
 
-	if (urlv && *urlv) {
-		gsize len = oio_strv_length(urlv);
-		if (r->service_qualifier) {
-			/* url already contains ip:port, and not meta1_service_url_s */
-			gboolean _wrap (gconstpointer p) {
-				return r->service_qualifier ((const char*)p);
-			}
-			len = oio_ext_array_partition ((void**)urlv, len, _wrap);
-		}
-		if (len > 0 && !oio_dir_no_shuffle)
-			oio_ext_array_shuffle ((void**)urlv, len);
-	}
+	_m0_prefer(r, urlv);
 
 	for (const char * const *purl=urlv; *purl ;++purl) {
 		GError *err = _resolve_m1_through_one_m0(*purl, prefix, result);
@@ -346,6 +398,292 @@ _resolve_m1_through_many_m0(struct hc_resolver_s *r, const char * const *urlv,
 	return NEWERROR(CODE_INTERNAL_ERROR, "No META0 answered");
 }
 
+/* Flat meta0 map ---------------------------------------------------------- */
+
+struct m1map_entry_s
+{
+	gchar *url;
+	const struct meta0_info_s *m0i;
+};
+
+static int
+_m1map_entry_cmp(const void *p0, const void *p1)
+{
+	const struct m1map_entry_s *e0 = p0, *e1 = p1;
+	return strcmp(e0->url, e1->url);
+}
+
+/* Same convention as meta0_utils_bytes_to_prefix() */
+static guint16
+_m1map_index(const guint8 *prefix)
+{
+	guint16 idx;
+	memcpy(&idx, prefix, sizeof(idx));
+	return idx;
+}
+
+static guint64
+_fnv1a(guint64 h, const void *p, gsize len)
+{
+	for (const guint8 *b = p; len-- ;++b) {
+		h ^= *b;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+static void
+_m1map_free(struct hc_m1map_s *m)
+{
+	if (!m)
+		return;
+	g_ptr_array_free(m->sets, TRUE);
+	g_free(m->ns);
+	g_free(m);
+}
+
+/* Turn the per-meta1 lists of prefixes into the per-prefix sets of meta1.
+ * The meta1 are sorted, so that the same mapping always gives the same
+ * sets and the same version. */
+static struct hc_m1map_s *
+_m1map_build(const char *ns, GSList *l)
+{
+	const guint n = g_slist_length(l);
+	struct m1map_entry_s *entries = g_new0(struct m1map_entry_s, n + 1);
+	for (guint i = 0; l ;l=l->next,++i) {
+		gchar str[STRLEN_ADDRINFO];
+		entries[i].m0i = l->data;
+		grid_addrinfo_to_string(&(entries[i].m0i->addr), str, sizeof(str));
+		entries[i].url = g_strdup_printf("1|%s|%s|", NAME_SRVTYPE_META1, str);
+	}
+	qsort(entries, n, sizeof(struct m1map_entry_s), _m1map_entry_cmp);
+
+	/* Group the meta1 by prefix, in a single array */
+	guint *offsets = g_new0(guint, HC_RESOLVER_M1MAP_SLOTS + 1);
+	for (guint i = 0; i < n ;++i) {
+		const struct meta0_info_s *m0i = entries[i].m0i;
+		for (gsize j = 0; j + 1 < m0i->prefixes_size ;j += 2)
+			offsets[_m1map_index(m0i->prefixes + j) + 1] ++;
+	}
+	for (guint idx = 0; idx < HC_RESOLVER_M1MAP_SLOTS ;++idx)
+		offsets[idx + 1] += offsets[idx];
+	guint *cursor = g_memdup(offsets, HC_RESOLVER_M1MAP_SLOTS * sizeof(guint));
+	guint *members = g_new0(guint, offsets[HC_RESOLVER_M1MAP_SLOTS] + 1);
+	for (guint i = 0; i < n ;++i) {
+		const struct meta0_info_s *m0i = entries[i].m0i;
+		for (gsize j = 0; j + 1 < m0i->prefixes_size ;j += 2)
+			members[cursor[_m1map_index(m0i->prefixes + j)] ++] = i;
+	}
+	g_free(cursor);
+
+	/* Intern the sets */
+	struct hc_m1map_s *m = g_malloc0(sizeof(struct hc_m1map_s));
+	m->ns = g_strdup(ns);
+	m->sets = g_ptr_array_new_with_free_func((GDestroyNotify)g_strfreev);
+	m->version = 14695981039346656037ULL;
+
+	GHashTable *interned = g_hash_table_new_full(g_str_hash, g_str_equal,
+			g_free, NULL);
+	GString *key = g_string_sized_new(256);
+	for (guint idx = 0; idx < HC_RESOLVER_M1MAP_SLOTS ;++idx) {
+		const guint first = offsets[idx], last = offsets[idx + 1];
+		if (first == last)
+			continue;
+
+		g_string_truncate(key, 0);
+		for (guint j = first; j < last ;++j) {
+			g_string_append(key, entries[members[j]].url);
+			g_string_append_c(key, '\n');
+		}
+
+		gchar **set = g_hash_table_lookup(interned, key->str);
+		if (!set) {
+			set = g_new0(gchar*, last - first + 1);
+			for (guint j = first; j < last ;++j)
+				set[j - first] = g_strdup(entries[members[j]].url);
+			g_ptr_array_add(m->sets, set);
+			g_hash_table_insert(interned, g_strdup(key->str), set);
+		}
+		m->slots[idx] = (const char * const *) set;
+		m->assigned ++;
+
+		const guint16 idx16 = idx;
+		m->version = _fnv1a(m->version, &idx16, sizeof(idx16));
+		m->version = _fnv1a(m->version, key->str, key->len);
+	}
+	g_string_free(key, TRUE);
+	g_hash_table_destroy(interned);
+
+	g_free(members);
+	g_free(offsets);
+	for (guint i = 0; i < n ;++i)
+		g_free(entries[i].url);
+	g_free(entries);
+	return m;
+}
+
+static GError *
+_m1map_fetch(struct hc_resolver_s *r, const char *ns, GSList **out)
+{
+	gchar **m0urlv = NULL;
+	GError *err = _resolve_meta0(r, ns, &m0urlv);
+	if (err) {
+		g_prefix_error(&err, "M0 resolution error: ");
+		return err;
+	}
+
+	_m0_prefer(r, (const char * const *) m0urlv);
+
+	for (gchar **purl = m0urlv; *purl ;++purl) {
+		gchar *url = meta1_strurl_get_address(*purl);
+		err = meta0_remote_get_meta1_all(url, out);
+		if (err && CODE_IS_NETWORK_ERROR(err->code)) {
+			if (r->service_notifier)
+				r->service_notifier (*purl);
+			g_clear_error(&err);
+			g_free(url);
+			continue;
+		}
+		g_free(url);
+		g_strfreev(m0urlv);
+		return err;
+	}
+
+	g_strfreev(m0urlv);
+	return NEWERROR(CODE_INTERNAL_ERROR, "No META0 answered");
+}
+
+/* Called by the single loader, without the m1map_lock: the meta0 may be
+ * slow, and the readers go on with the current map (or the per-prefix
+ * resolution) meanwhile. Only the swap happens under the lock. */
+static void
+_m1map_reload(struct hc_resolver_s *r, const char *ns, guint generation)
+{
+	GSList *l = NULL;
+	struct hc_m1map_s *fresh = NULL;
+	GError *err = r->m1map_fetch(r, ns, &l);
+	if (err) {
+		GRID_WARN("META0 map load failed for [%s]: (%d) %s",
+				ns, err->code, err->message);
+		g_clear_error(&err);
+	} else {
+		fresh = _m1map_build(ns, l);
+		g_slist_free_full(l, (GDestroyNotify)meta0_info_clean);
+	}
+
+	g_mutex_lock(&r->m1map_lock);
+	r->m1map_loading = FALSE;
+	if (fresh && generation != r->m1map_generation) {
+		/* Flushed while loading, the map may be outdated */
+		_m1map_free(fresh);
+	} else if (fresh) {
+		struct hc_m1map_s *old = r->m1map;
+		if (old && old->version == fresh->version && !strcmp(old->ns, ns)) {
+			/* Unchanged, keep the map the readers already use */
+			_m1map_free(fresh);
+		} else {
+			g_atomic_pointer_set(&r->m1map, fresh);
+			if (old) {
+				old->retired = oio_ext_monotonic_time();
+				r->m1map_retired = g_slist_prepend(r->m1map_retired, old);
+			}
+			GRID_INFO("META0 map loaded for [%s]: %u prefixes, %u sets",
+					ns, fresh->assigned, fresh->sets->len);
+		}
+		r->m1map_loaded = oio_ext_monotonic_time();
+		g_atomic_int_set(&r->m1map_stale, 0);
+	}
+	g_mutex_unlock(&r->m1map_lock);
+}
+
+static void
+_m1map_refresh(struct hc_resolver_s *r, const char *ns)
+{
+	struct hc_m1map_s *m = g_atomic_pointer_get(&r->m1map);
+	if (m && !g_atomic_int_get(&r->m1map_stale))
+		return;
+
+	/* One loader at once. The others go on with the current map, or
+	 * resolve the prefix on their own when there is none yet. */
+	gboolean load = FALSE;
+	guint generation = 0;
+	const gint64 now = oio_ext_monotonic_time();
+	g_mutex_lock(&r->m1map_lock);
+	if (!r->m1map_loading
+			&& (!r->m1map || g_atomic_int_get(&r->m1map_stale))
+			&& (!r->m1map_attempt
+				|| now - r->m1map_attempt >= HC_RESOLVER_M1MAP_PERIOD)) {
+		r->m1map_attempt = now;
+		r->m1map_loading = load = TRUE;
+		generation = r->m1map_generation;
+	}
+	g_mutex_unlock(&r->m1map_lock);
+
+	if (load)
+		_m1map_reload(r, ns, generation);
+}
+
+/* The meta1 set of the prefix of <u>, without lock nor allocation on the
+ * regular path. NULL when the map cannot be used, then the prefix has to
+ * be resolved on its own. */
+static const char * const *
+_m1map_get(struct hc_resolver_s *r, struct oio_url_s *u)
+{
+	if (r->flags & HC_RESOLVER_NOCACHE)
+		return NULL;
+
+	const char *ns = oio_url_get(u, OIOURL_NS);
+	_m1map_refresh(r, ns);
+
+	struct hc_m1map_s *m = g_atomic_pointer_get(&r->m1map);
+	if (!m || strcmp(m->ns, ns))
+		return NULL;
+	return m->slots[_m1map_index(oio_url_get_id(u))];
+}
+
+static void
+_m1map_retire(struct hc_resolver_s *r)
+{
+	struct hc_m1map_s *old = r->m1map;
+	g_atomic_pointer_set(&r->m1map, NULL);
+	if (old) {
+		old->retired = oio_ext_monotonic_time();
+		r->m1map_retired = g_slist_prepend(r->m1map_retired, old);
+	}
+	r->m1map_attempt = 0;
+	r->m1map_generation ++;
+}
+
+static guint
+_m1map_expire(struct hc_resolver_s *r)
+{
+	guint count = 0;
+	const gint64 now = oio_ext_monotonic_time();
+
+	g_mutex_lock(&r->m1map_lock);
+	if (r->m1map && r->csm0.ttl > 0
+			&& now - r->m1map_loaded > r->csm0.ttl * G_TIME_SPAN_SECOND)
+		g_atomic_int_set(&r->m1map_stale, 1);
+
+	GSList *kept = NULL;
+	for (GSList *l = r->m1map_retired; l ;l=l->next) {
+		struct hc_m1map_s *m = l->data;
+		if (now - m->retired > HC_RESOLVER_M1MAP_GRACE) {
+			_m1map_free(m);
+			++ count;
+		} else {
+			kept = g_slist_prepend(kept, m);
+		}
+	}
+	g_slist_free(r->m1map_retired);
+	r->m1map_retired = kept;
+	g_mutex_unlock(&r->m1map_lock);
+
+	return count;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static GError *
 _resolve_meta1(struct hc_resolver_s *r, struct oio_url_s *u, gchar ***result)
 {
@@ -354,6 +692,12 @@ _resolve_meta1(struct hc_resolver_s *r, struct oio_url_s *u, gchar ***result)
 
 	GRID_TRACE2("%s(%s)", __FUNCTION__, oio_url_get(u, OIOURL_WHOLE));
 
+	const char * const *m1v = _m1map_get(r, u);
+	if (m1v) {
+		*result = g_strdupv((gchar**) m1v);
+		return NULL;
+	}
+
 	hk = _m1_key (u);
 
 	/* Try to hit the cache */
@@ -410,6 +754,11 @@ _resolve_service_through_many_meta1(struct hc_resolver_s *r,
 			r->service_notifier (m1);
 		g_free0(m1);
 
+		/* The meta1 does not serve the prefix anymore, the map is outdated */
+		if (err && (err->code == CODE_RANGE_NOTFOUND
+					|| err->code == CODE_REDIRECT))
+			g_atomic_int_set(&r->m1map_stale, 1);
+
 		if (!err)
 			return NULL;
 		if (!CODE_IS_NETWORK_ERROR(err->code))
@@ -437,13 +786,21 @@ _resolve_reference_service(struct hc_resolver_s *r, struct hashstr_s *hk,
 	}
 
 	/* now attempt a real resolution */
-	err = _resolve_meta1(r, u, &m1urlv);
-	EXTRA_ASSERT((err!=NULL) ^ (m1urlv!=NULL));
-	if (NULL != err)
-		return err;
-
-	err = _resolve_service_through_many_meta1(r, (const char * const *)m1urlv,
-			u, s, result);
+	const char * const *m1v = _m1map_get(r, u);
+	if (m1v) {
+		/* The set is shared, and it will be partitioned and shuffled */
+		const gsize len = oio_strv_length(m1v);
+		const char *urlv[len + 1];
+		memcpy(urlv, m1v, sizeof(urlv));
+		err = _resolve_service_through_many_meta1(r, urlv, u, s, result);
+	} else {
+		err = _resolve_meta1(r, u, &m1urlv);
+		EXTRA_ASSERT((err!=NULL) ^ (m1urlv!=NULL));
+		if (NULL != err)
+			return err;
+		err = _resolve_service_through_many_meta1(r,
+				(const char * const *)m1urlv, u, s, result);
+	}
 	EXTRA_ASSERT((err!=NULL) ^ (*result!=NULL));
 	if (!err) {
 		/* fill the cache */
@@ -539,6 +896,22 @@ hc_decache_reference(struct hc_resolver_s *r, struct oio_url_s *url)
 	g_free(hk);
 }
 
+void
+hc_decache_prefix(struct hc_resolver_s *r, struct oio_url_s *url)
+{
+	GRID_TRACE2("%s(%s)", __FUNCTION__, oio_url_get(url, OIOURL_WHOLE));
+	EXTRA_ASSERT(r != NULL);
+	EXTRA_ASSERT(url != NULL);
+
+	if (r->flags & HC_RESOLVER_NOCACHE)
+		return;
+
+	hc_decache_reference(r, url);
+
+	/* The prefix moved, reload the whole map (not too often) */
+	g_atomic_int_set(&r->m1map_stale, 1);
+}
+
 void
 hc_decache_reference_service(struct hc_resolver_s *r, struct oio_url_s *url,
 		const char *srvtype)
@@ -603,7 +976,8 @@ guint
 hc_resolver_expire(struct hc_resolver_s *r)
 {
 	EXTRA_ASSERT(r != NULL);
-	return _LRU_expire(r, &r->csm0) + _LRU_expire(r, &r->services);
+	return _LRU_expire(r, &r->csm0) + _LRU_expire(r, &r->services)
+		+ _m1map_expire(r);
 }
 
 void
@@ -677,6 +1051,10 @@ hc_resolver_flush_csm0(struct hc_resolver_s *r)
 	g_mutex_lock(&r->lock);
 	_lru_flush(r->csm0.cache);
 	g_mutex_unlock(&r->lock);
+
+	g_mutex_lock(&r->m1map_lock);
+	_m1map_retire(r);
+	g_mutex_unlock(&r->m1map_lock);
 }
 
 void
@@ -736,5 +1114,16 @@ hc_resolver_info(struct hc_resolver_s *r, struct hc_resolver_stats_s *s)
 	s->services.ttl = r->services.ttl;
 	s->services.count = lru_tree_count(r->services.cache);
 	g_mutex_unlock(&r->lock);
+
+	g_mutex_lock(&r->m1map_lock);
+	if (r->m1map) {
+		s->m1map.version = r->m1map->version;
+		s->m1map.assigned = r->m1map->assigned;
+		s->m1map.sets = r->m1map->sets->len;
+		/* the load is dated with the monotonic clock, for the expiry */
+		s->m1map.loaded = oio_ext_real_seconds()
+			- (oio_ext_monotonic_time() - r->m1map_loaded) / G_TIME_SPAN_SECOND;
+	}
+	g_mutex_unlock(&r->m1map_lock);
 }
 
@@ -61,6 +61,15 @@ void hc_resolver_qualify (struct hc_resolver_s *r,
 void hc_resolver_notify (struct hc_resolver_s *r,
 		void (*notify) (gconstpointer));
 
+struct oio_cache_s;
+
+/* Use <l2> as a second-level cache behind the in-process LRU, typically a
+ * cache shared by all the processes of the host (see oio_cache_make_shm()),
+ * so that a restarted process does not resolve everything again. The
+ * resolver takes the ownership of <l2>. The flushes only apply to the LRU,
+ * the shared entries expire on their own. */
+void hc_resolver_set_shared (struct hc_resolver_s *r, struct oio_cache_s *l2);
+
 /* Cleanup all the internal structures. */
 void hc_resolver_destroy(struct hc_resolver_s *r);
 
@@ -112,9 +121,15 @@ void hc_decache_reference_service(struct hc_resolver_s *r,
 		struct oio_url_s *url, const gchar *srvtype);
 
 /* Removes from the cache the directory services for the given references.
- * It doesn't touche the cache entries for the directory content. */
+ * It doesn't touche the cache entries for the directory content, nor the
+ * meta0 map. */
 void hc_decache_reference(struct hc_resolver_s *r, struct oio_url_s *url);
 
+/* To be called when a meta1 tells it doesn't manage the prefix of <url>:
+ * decaches the reference, and the whole meta0 map will be reloaded at the
+ * next resolution. */
+void hc_decache_prefix(struct hc_resolver_s *r, struct oio_url_s *url);
+
 struct hc_resolver_stats_s
 {
 	time_t clock;
@@ -130,6 +145,14 @@ struct hc_resolver_stats_s
 		guint max;
 		time_t ttl;
 	} services;
+
+	/* The flat meta0 map, all zeroes when not loaded */
+	struct {
+		guint64 version;
+		guint assigned;
+		guint sets;
+		time_t loaded; /* wall-clock time of the last load, in seconds */
+	} m1map;
 };
 
 void hc_resolver_info(struct hc_resolver_s *r, struct hc_resolver_stats_s *s);
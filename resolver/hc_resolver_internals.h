@@ -40,7 +40,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 # define HC_RESOLVER_DEFAULT_TTL_CSM0 0
 #endif
 
+/* Minimal delay between two loads of the whole meta0 map */
+#ifndef  HC_RESOLVER_M1MAP_PERIOD
+# define HC_RESOLVER_M1MAP_PERIOD (5 * G_TIME_SPAN_SECOND)
+#endif
+
+/* How long a replaced map is kept alive for the readers still using it */
+#ifndef  HC_RESOLVER_M1MAP_GRACE
+# define HC_RESOLVER_M1MAP_GRACE (300 * G_TIME_SPAN_SECOND)
+#endif
+
+#define HC_RESOLVER_M1MAP_SLOTS 65536
+
 struct lru_tree_s;
+struct oio_cache_s;
 
 struct cached_element_s
 {
@@ -49,6 +62,21 @@ struct cached_element_s
 	gchar s[]; /* Must be the last! */
 };
 
+/* The whole prefix -> meta1 mapping of a namespace, loaded at once from
+ * a meta0. Each slot points to an interned NULL-terminated array of packed
+ * meta1 URL, shared by all the prefixes held by the same set of meta1. A
+ * map is never modified once published, and it is only freed after a grace
+ * delay once replaced, so that the readers need no lock. */
+struct hc_m1map_s
+{
+	guint64 version; /* checksum of the mapping */
+	guint assigned;
+	gint64 retired;
+	gchar *ns;
+	GPtrArray *sets; /* <gchar**>, the interned sets */
+	const char * const *slots[HC_RESOLVER_M1MAP_SLOTS];
+};
+
 struct lru_ext_s
 {
 	struct lru_tree_s *cache;
@@ -69,6 +97,26 @@ struct hc_resolver_s
 
 	/* called with the IP:PORT string */
 	void (*service_notifier) (gconstpointer);
+
+	/* Second-level cache, queried when the LRU misses, e.g. shared by the
+	 * processes of the host. Optional. */
+	struct oio_cache_s *shared;
+
+	/* The flat meta0 map, read with atomic operations. The lock protects
+	 * the fields below and the swap of the map, never the load itself. */
+	struct hc_m1map_s *m1map;
+	gint m1map_stale;
+	GMutex m1map_lock;
+	gboolean m1map_loading;
+	guint m1map_generation; /* bumped by each flush */
+	gint64 m1map_attempt;
+	gint64 m1map_loaded; /* monotonic */
+	GSList *m1map_retired;
+
+	/* Fetches the whole mapping of the namespace, as a list of
+	 * <struct meta0_info_s*>. Queries the meta0 unless overridden. */
+	GError* (*m1map_fetch) (struct hc_resolver_s *r, const char *ns,
+			GSList **out);
 };
 
 #endif /*OIO_SDS__resolver__hc_resolver_internals_h*/
@@ -49,6 +49,11 @@ License along with this library.
 # define SERVER_DEFAULT_CNX_INACTIVE  (30 * G_TIME_SPAN_SECOND)
 #endif
 
+/* How many buffer slabs may be gathered in a single writev() */
+#ifndef  SLAB_IOV_MAX
+# define SLAB_IOV_MAX 16
+#endif
+
 enum {
 	NETSERVER_THROUGHPUT = 0x0001,
 	NETSERVER_LATENCY    = 0x0002,
@@ -73,6 +78,33 @@ struct endpoint_s
 	gchar url[1];
 };
 
+/* Number of distinct request series a thread may count, beyond that the
+ * requests are counted through the stats thread. Power of 2. */
+#ifndef  SERVER_STAT_SERIES
+# define SERVER_STAT_SERIES 128
+#endif
+
+/* The counters of one request series in one thread. Only the owner thread
+ * writes them, the readers sum them over the threads. */
+struct server_stat_series_s
+{
+	GQuark which; /* the count, 0 for a free slot. Set once. */
+	GQuark time;
+	guint64 count;
+	guint64 total;
+	guint64 *histogram; /* GRID_HISTOGRAM_BUCKETS, allocated at 1st use */
+};
+
+/* One block per worker thread. A block outlives its thread and is then
+ * reused by the next one, so that the counters are never lost. */
+struct server_stat_block_s
+{
+	struct server_stat_block_s *next; /* immutable once linked */
+	struct network_server_s *srv;
+	gint owned; /* 0 free, 1 owned by a thread, 2 orphaned by the server */
+	struct server_stat_series_s series[SERVER_STAT_SERIES];
+};
+
 struct network_server_s
 {
 	struct endpoint_s **endpointv;
@@ -87,6 +119,7 @@ struct network_server_s
 
 	GMutex lock_stats;
 	GArray *stats; /* <struct server_stat_s> */
+	struct server_stat_block_s *stat_blocks; /* read with atomic operations */
 
 	GMutex lock_threads;
 
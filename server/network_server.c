@@ -82,6 +82,8 @@ static void _cb_worker(struct network_client_s *clt,
 static void _cb_stats(struct server_stat_msg_s *msg,
 		struct network_server_s *srv);
 
+static void _stat_blocks_collect (struct network_server_s *srv, GArray *out);
+
 /* Returns the number of max file descriptors for this process */
 static guint _server_get_maxfd(void);
 
@@ -189,6 +191,18 @@ network_server_stat_getone (struct network_server_s *srv, GQuark which)
 	if (NULL != (p = _stat_locate (srv, which)))
 		value = *p;
 	g_mutex_unlock (&srv->lock_stats);
+
+	for (struct server_stat_block_s *b = g_atomic_pointer_get (&srv->stat_blocks);
+			b ;b=b->next) {
+		for (guint i=0; i<SERVER_STAT_SERIES ;++i) {
+			struct server_stat_series_s *s = b->series + i;
+			const GQuark w = __atomic_load_n (&s->which, __ATOMIC_ACQUIRE);
+			if (w && w == which)
+				value += __atomic_load_n (&s->count, __ATOMIC_RELAXED);
+			else if (w && s->time == which)
+				value += __atomic_load_n (&s->total, __ATOMIC_RELAXED);
+		}
+	}
 	return value;
 }
 
@@ -200,9 +214,229 @@ network_server_stat_getall (struct network_server_s *srv)
 	g_mutex_lock (&srv->lock_stats);
 	g_array_append_vals (out, srv->stats->data, srv->stats->len);
 	g_mutex_unlock (&srv->lock_stats);
+	_stat_blocks_collect (srv, out);
 	return out;
 }
 
+/* Per-thread request counters ---------------------------------------------- */
+
+static void
+_stat_block_free (struct server_stat_block_s *b)
+{
+	for (guint i=0; i<SERVER_STAT_SERIES ;++i)
+		g_free (b->series[i].histogram);
+	g_free (b);
+}
+
+static void
+_stat_block_release (struct server_stat_block_s *b)
+{
+	if (!b)
+		return;
+	/* Orphaned by a cleaned server, its last owner frees it */
+	if (!g_atomic_int_compare_and_exchange (&b->owned, 1, 0))
+		_stat_block_free (b);
+}
+
+static GPrivate th_stat_block = G_PRIVATE_INIT ((GDestroyNotify)_stat_block_release);
+
+static struct server_stat_block_s *
+_stat_block_acquire (struct network_server_s *srv)
+{
+	struct server_stat_block_s *b = g_private_get (&th_stat_block);
+	if (b) {
+		_stat_block_release (b);
+		g_private_set (&th_stat_block, NULL);
+	}
+
+	/* Reuse the block of a dead thread, or make a new one */
+	for (b = g_atomic_pointer_get (&srv->stat_blocks); b ;b=b->next) {
+		if (g_atomic_int_compare_and_exchange (&b->owned, 0, 1))
+			break;
+	}
+	if (!b) {
+		b = g_malloc0 (sizeof(struct server_stat_block_s));
+		b->srv = srv;
+		b->owned = 1;
+		g_mutex_lock (&srv->lock_stats);
+		b->next = srv->stat_blocks;
+		g_atomic_pointer_set (&srv->stat_blocks, b);
+		g_mutex_unlock (&srv->lock_stats);
+	}
+
+	g_private_set (&th_stat_block, b);
+	return b;
+}
+
+static void
+_stat_blocks_orphan (struct network_server_s *srv)
+{
+	struct server_stat_block_s *next = NULL;
+	for (struct server_stat_block_s *b = srv->stat_blocks; b ;b=next) {
+		next = b->next;
+		for (;;) {
+			if (g_atomic_int_compare_and_exchange (&b->owned, 0, 2)) {
+				_stat_block_free (b);
+				break;
+			}
+			if (g_atomic_int_compare_and_exchange (&b->owned, 1, 2))
+				break;
+		}
+	}
+	srv->stat_blocks = NULL;
+}
+
+/* Only called by the owner of the block */
+static struct server_stat_series_s *
+_stat_series (struct server_stat_block_s *b, GQuark which, GQuark gq_time)
+{
+	const guint mask = SERVER_STAT_SERIES - 1;
+	guint i = (which * 2654435761u) & mask;
+	for (guint n=0; n<SERVER_STAT_SERIES ;++n, i=(i+1)&mask) {
+		struct server_stat_series_s *s = b->series + i;
+		if (s->which == which)
+			return s;
+		if (!s->which) {
+			s->time = gq_time;
+			__atomic_store_n (&s->which, which, __ATOMIC_RELEASE);
+			return s;
+		}
+	}
+	return NULL;
+}
+
+/* Only called by the owner of the block: plain increments, but stored
+ * atomically so that the readers never see torn values */
+static void
+_stat_series_add (struct server_stat_series_s *s, guint64 duration)
+{
+	__atomic_store_n (&s->count, s->count + 1, __ATOMIC_RELAXED);
+	__atomic_store_n (&s->total, s->total + duration, __ATOMIC_RELAXED);
+	if (G_UNLIKELY (!s->histogram)) {
+		guint64 *h = g_malloc0 (GRID_HISTOGRAM_BUCKETS * sizeof(guint64));
+		__atomic_store_n (&s->histogram, h, __ATOMIC_RELEASE);
+	}
+	guint64 *p = s->histogram + grid_histogram_bucket (duration);
+	__atomic_store_n (p, *p + 1, __ATOMIC_RELAXED);
+}
+
+void
+network_server_stat_request (struct network_server_s *srv,
+		GQuark gq_count, GQuark gq_time, gint64 duration)
+{
+	EXTRA_ASSERT (srv != NULL);
+	const guint64 d = MAX(0, duration);
+
+	struct server_stat_block_s *b = g_private_get (&th_stat_block);
+	if (G_UNLIKELY (!b || b->srv != srv || g_atomic_int_get (&b->owned) != 1))
+		b = _stat_block_acquire (srv);
+
+	struct server_stat_series_s *s0 = _stat_series (b, gq_count, gq_time);
+	struct server_stat_series_s *s1 = _stat_series (b, gq_count_all, gq_time_all);
+	if (G_UNLIKELY (!s0 || !s1)) {
+		network_server_stat_push4 (srv, TRUE,
+				gq_count, 1, gq_count_all, 1,
+				gq_time, d, gq_time_all, d);
+		return;
+	}
+
+	_stat_series_add (s0, d);
+	_stat_series_add (s1, d);
+}
+
+struct stat_sum_s
+{
+	GQuark which;
+	GQuark time;
+	guint64 count;
+	guint64 total;
+	guint64 histogram[GRID_HISTOGRAM_BUCKETS];
+};
+
+/* Sum the series over all the threads, <sums> is a <GQuark,struct stat_sum_s*> */
+static void
+_stat_blocks_sum (struct network_server_s *srv, GHashTable *sums)
+{
+	for (struct server_stat_block_s *b = g_atomic_pointer_get (&srv->stat_blocks);
+			b ;b=b->next) {
+		for (guint i=0; i<SERVER_STAT_SERIES ;++i) {
+			struct server_stat_series_s *s = b->series + i;
+			const GQuark which = __atomic_load_n (&s->which, __ATOMIC_ACQUIRE);
+			if (!which)
+				continue;
+
+			struct stat_sum_s *sum = g_hash_table_lookup (sums,
+					GUINT_TO_POINTER(which));
+			if (!sum) {
+				sum = g_malloc0 (sizeof(struct stat_sum_s));
+				sum->which = which;
+				sum->time = s->time;
+				g_hash_table_insert (sums, GUINT_TO_POINTER(which), sum);
+			}
+			sum->count += __atomic_load_n (&s->count, __ATOMIC_RELAXED);
+			sum->total += __atomic_load_n (&s->total, __ATOMIC_RELAXED);
+			guint64 *h = __atomic_load_n (&s->histogram, __ATOMIC_ACQUIRE);
+			if (h) {
+				for (guint j=0; j<GRID_HISTOGRAM_BUCKETS ;++j)
+					sum->histogram[j] += __atomic_load_n (h + j, __ATOMIC_RELAXED);
+			}
+		}
+	}
+}
+
+static void
+_stat_add (GArray *out, GQuark which, guint64 value)
+{
+	for (guint i=0; i<out->len ;++i) {
+		struct server_stat_s *st = &g_array_index (out, struct server_stat_s, i);
+		if (st->which == which) {
+			st->value += value;
+			return;
+		}
+	}
+	struct server_stat_s st = {.value=value, .which=which};
+	g_array_append_vals (out, &st, 1);
+}
+
+/* "counter req.time.X" gives "gauge req.time.X.p99" */
+static GQuark
+_stat_quantile_name (GQuark gq_time, const char *suffix)
+{
+	const char *name = g_quark_to_string (gq_time);
+	if (g_str_has_prefix (name, "counter "))
+		name += sizeof("counter ") - 1;
+	gchar tmp[256];
+	g_snprintf (tmp, sizeof(tmp), "gauge %s.%s", name, suffix);
+	return g_quark_from_string (tmp);
+}
+
+static void
+_stat_blocks_collect (struct network_server_s *srv, GArray *out)
+{
+	static const struct { const char *name; gdouble q; } quantiles[] = {
+		{"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999},
+	};
+
+	GHashTable *sums = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+			NULL, g_free);
+	_stat_blocks_sum (srv, sums);
+
+	GHashTableIter iter;
+	gpointer k, v;
+	g_hash_table_iter_init (&iter, sums);
+	while (g_hash_table_iter_next (&iter, &k, &v)) {
+		struct stat_sum_s *sum = v;
+		_stat_add (out, sum->which, sum->count);
+		_stat_add (out, sum->time, sum->total);
+		if (!sum->count)
+			continue;
+		for (guint i=0; i<G_N_ELEMENTS(quantiles) ;++i)
+			_stat_add (out, _stat_quantile_name (sum->time, quantiles[i].name),
+					grid_histogram_quantile (sum->histogram, quantiles[i].q));
+	}
+	g_hash_table_destroy (sums);
+}
+
 struct network_server_s *
 network_server_init(void)
 {
@@ -295,6 +529,7 @@ network_server_clean(struct network_server_s *srv)
 
 	if (srv->stats)
 		g_array_free (srv->stats, TRUE);
+	_stat_blocks_orphan (srv);
 
 	metautils_pclose(&(srv->wakeup[0]));
 	metautils_pclose(&(srv->wakeup[1]));
@@ -892,18 +1127,40 @@ _cb_stats(struct server_stat_msg_s *msg, struct network_server_s *srv)
 	SLICE_FREE(struct server_stat_msg_s, msg);
 }
 
+/* How a client deferred by its transport is shared between the worker that
+ * manages it and the thread that resumes it. */
+enum {
+	DEFER_NONE = 0,
+	DEFER_PENDING, /* deferred, still held by its worker */
+	DEFER_RESUMED, /* resumed before its worker released it */
+	DEFER_PARKED,  /* released by its worker, waiting to be resumed */
+};
+
 static void
 _cb_worker(struct network_client_s *clt, struct network_server_s *srv)
 {
 	EXTRA_ASSERT(clt != NULL);
 	EXTRA_ASSERT(clt->server == srv);
 
-	if ((clt->events & CLT_ERROR) || !clt->events) {
+	/* A resumed client always reaches its transport, that owns a pending
+	 * reply. */
+	if (!(clt->events & CLT_RESUME)
+			&& ((clt->events & CLT_ERROR) || !clt->events)) {
 		_client_clean(srv, clt);
 		return;
 	}
 
-	_client_manage_event(clt, clt->events);
+	for (;;) {
+		_client_manage_event(clt, clt->events);
+
+		if (g_atomic_int_compare_and_exchange(&clt->deferred,
+					DEFER_PENDING, DEFER_PARKED))
+			return;
+		if (!g_atomic_int_compare_and_exchange(&clt->deferred,
+					DEFER_RESUMED, DEFER_NONE))
+			break;
+		clt->events = CLT_RESUME | (clt->events & CLT_ERROR);
+	}
 
 	/* re Monitor the socket */
 	if (_client_ready_for_output(clt) && _client_has_pending_output(clt))
@@ -1134,6 +1391,12 @@ _client_manage_event(struct network_client_s *clt, int events)
 	int rcI, rcO;
 
 	clt->events = 0;
+	if (events & CLT_RESUME) {
+		if (clt->transport.notify_resume)
+			clt->transport.notify_resume(clt);
+		events |= MACRO_COND(clt->flags & (NETCLIENT_IN_CLOSED|NETCLIENT_IN_PAUSED),
+				0, CLT_READ);
+	}
 	rcO = _client_has_pending_output(clt);
 	rcI = events & CLT_READ ;
 
@@ -1211,6 +1474,44 @@ network_client_send_slab(struct network_client_s *client, struct data_slab_s *ds
 	return 0;
 }
 
+int
+network_client_send_slabs(struct network_client_s *client,
+		struct data_slab_s *first)
+{
+	EXTRA_ASSERT(client != NULL);
+	EXTRA_ASSERT(first != NULL);
+
+	if (!first->next)
+		return network_client_send_slab(client, first);
+
+	client->time.evt_out = oio_ext_monotonic_time ();
+
+	if (!_client_ready_for_output(client)) {
+		GRID_DEBUG("fd=%d Discarding data, output closed", client->fd);
+		for (struct data_slab_s *next = NULL; first ;first=next) {
+			next = first->next;
+			data_slab_free(first);
+		}
+		return -1;
+	}
+
+	const gboolean pending = _client_has_pending_output(client);
+	for (struct data_slab_s *next = NULL; first ;first=next) {
+		next = first->next;
+		data_slab_sequence_append(&(client->output), first);
+	}
+
+	/* Try to send the slabs now, if allowed, in as few calls as possible */
+	if (!pending) {
+		if (!_client_send_pending_output(client) && errno != EAGAIN)
+			return -1;
+	}
+
+	/* Drop what has been sent, the rest is managed with the events */
+	_client_has_pending_output(client);
+	return 0;
+}
+
 void
 network_client_close_output(struct network_client_s *clt, int now)
 {
@@ -1253,3 +1554,30 @@ network_client_allow_input(struct network_client_s *clt, gboolean v)
 	}
 }
 
+void
+network_client_defer(struct network_client_s *clt)
+{
+	EXTRA_ASSERT(clt != NULL);
+	EXTRA_ASSERT(g_atomic_int_get(&clt->deferred) == DEFER_NONE);
+	g_atomic_int_set(&clt->deferred, DEFER_PENDING);
+}
+
+void
+network_client_resume(struct network_client_s *clt)
+{
+	EXTRA_ASSERT(clt != NULL);
+
+	/* Still in its worker, that will loop on it */
+	if (g_atomic_int_compare_and_exchange(&clt->deferred,
+				DEFER_PENDING, DEFER_RESUMED))
+		return;
+
+	if (g_atomic_int_compare_and_exchange(&clt->deferred,
+				DEFER_PARKED, DEFER_NONE)) {
+		clt->events = CLT_RESUME | (clt->events & CLT_ERROR);
+		g_thread_pool_push(clt->server->pool_workers, clt, NULL);
+		return;
+	}
+
+	g_assert_not_reached();
+}
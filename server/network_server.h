@@ -70,13 +70,15 @@ struct network_transport_s
 	/* Be notified that a piece of data is ready */
 	int (*notify_input)  (struct network_client_s *);
 	void (*notify_error)  (struct network_client_s *);
+	/* Be notified, in a worker, that a deferred client has been resumed */
+	void (*notify_resume) (struct network_client_s *);
 	gboolean waiting_for_close;
 };
 
 struct network_client_s
 {
 	int fd;
-	enum { CLT_READ=0X01, CLT_WRITE=0X02, CLT_ERROR=0X04 } events;
+	enum { CLT_READ=0X01, CLT_WRITE=0X02, CLT_ERROR=0X04, CLT_RESUME=0x08 } events;
 	struct network_server_s *server;
 
 	int flags;
@@ -96,6 +98,7 @@ struct network_client_s
 
 	struct network_client_s *prev; /*!< XXX DO NOT USE */
 	struct network_client_s *next; /*!< XXX DO NOT USE */
+	volatile gint deferred; /*!< XXX DO NOT USE */
 
 	gchar local_name[128];
 	gchar peer_name[128];
@@ -147,9 +150,19 @@ void network_server_stat_push4 (struct network_server_s *srv, gboolean inc,
 		GQuark k1, guint64 v1, GQuark k2, guint64 v2,
 		GQuark k3, guint64 v3, GQuark k4, guint64 v4);
 
+/* Count a request of the series <gq_count> (and of the overall series)
+ * that lasted <duration> microseconds, summed under <gq_time>. The counters
+ * live in a block per thread, so that it takes no lock nor allocation once
+ * the thread has already met the series. */
+void network_server_stat_request (struct network_server_s *srv,
+		GQuark gq_count, GQuark gq_time, gint64 duration);
+
 /* Synchronosly get the current value of the stat named <which> */
 guint64 network_server_stat_getone (struct network_server_s *srv, GQuark which);
 
+/* All the stats, the request counters being summed over the threads. For
+ * each request series, the p50/p90/p99/p999 of its latency come as gauges
+ * named after its time counter (e.g. "gauge req.time.REQ_PING.p99"). */
 GArray* network_server_stat_getall (struct network_server_s *srv);
 
 /* -------------------------------------------------------------------------- */
@@ -158,7 +171,24 @@ void network_client_allow_input(struct network_client_s *clt, gboolean v);
 
 void network_client_close_output(struct network_client_s *clt, int now);
 
+/* To be called by the transport, in its notify_input hook, when it will
+ * reply later: once the hook returns, the client is neither monitored nor
+ * read until network_client_resume() is called, and the unconsumed input is
+ * kept. */
+void network_client_defer(struct network_client_s *clt);
+
+/* Callable from any thread, once per network_client_defer(). A worker then
+ * calls the notify_resume hook of the transport, and the client is managed
+ * as usual again. */
+void network_client_resume(struct network_client_s *clt);
+
 int network_client_send_slab(struct network_client_s *client,
 		struct data_slab_s *slab);
 
+/* Like network_client_send_slab() for a chain of slabs (linked with their
+ * <next> field), the consecutive buffers being sent with a single writev()
+ * and the files with sendfile(). */
+int network_client_send_slabs(struct network_client_s *client,
+		struct data_slab_s *first);
+
 #endif /*OIO_SDS__server__network_server_h*/
@@ -25,6 +25,7 @@ License along with this library.
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include "slab.h"
 #include "internals.h"
@@ -105,11 +106,14 @@ data_slab_free(struct data_slab_s *ds)
 {
 	switch (ds->type) {
 		case STYPE_BUFFER:
-			if (ds->data.buffer.buff) {
+			if (ds->data.buffer.gba) {
+				g_byte_array_unref(ds->data.buffer.gba);
+				ds->data.buffer.gba = NULL;
+			} else if (ds->data.buffer.buff) {
 				g_free(ds->data.buffer.buff);
-				ds->data.buffer.buff = NULL;
-				ds->data.buffer.start = ds->data.buffer.end = 0;
 			}
+			ds->data.buffer.buff = NULL;
+			ds->data.buffer.start = ds->data.buffer.end = 0;
 			break;
 		case STYPE_BUFFER_STATIC:
 			break;
@@ -279,6 +283,12 @@ data_slab_consume(struct data_slab_s *ds, guint8 **p_data, gsize *p_size)
 	return FALSE;
 }
 
+static gboolean
+_slab_is_buffer(struct data_slab_s *ds)
+{
+	return ds->type == STYPE_BUFFER || ds->type == STYPE_BUFFER_STATIC;
+}
+
 gboolean
 data_slab_sequence_send(struct data_slab_sequence_s *dss, int fd)
 {
@@ -287,7 +297,37 @@ data_slab_sequence_send(struct data_slab_sequence_s *dss, int fd)
 		return TRUE;
 	}
 
-	return data_slab_send(dss->first, fd);
+	if (!_slab_is_buffer(dss->first) || !dss->first->next)
+		return data_slab_send(dss->first, fd);
+
+	/* Gather the consecutive buffers, e.g. the envelope of a message
+	 * followed by its body */
+	struct iovec iov[SLAB_IOV_MAX];
+	guint count = 0;
+	for (struct data_slab_s *ds = dss->first;
+			ds && count < SLAB_IOV_MAX && _slab_is_buffer(ds); ds = ds->next) {
+		if (!data_slab_has_data(ds))
+			continue;
+		iov[count].iov_base = ds->data.buffer.buff + ds->data.buffer.start;
+		iov[count].iov_len = ds->data.buffer.end - ds->data.buffer.start;
+		++ count;
+	}
+	if (count <= 1)
+		return data_slab_send(dss->first, fd);
+
+	errno = 0;
+	ssize_t w = writev(fd, iov, count);
+	if (w < 0)
+		return FALSE;
+
+	for (struct data_slab_s *ds = dss->first;
+			w > 0 && ds && _slab_is_buffer(ds); ds = ds->next) {
+		const guint avail = ds->data.buffer.end - ds->data.buffer.start;
+		const guint done = MIN((gsize)w, avail);
+		ds->data.buffer.start += done;
+		w -= done;
+	}
+	return TRUE;
 }
 
 void
@@ -482,6 +522,21 @@ data_slab_make_tempfile(const gchar *path)
 	return data_slab_make_path(path, TRUE);
 }
 
+struct data_slab_s *
+data_slab_make_gba_ref(GByteArray *gba)
+{
+	EXTRA_ASSERT(gba != NULL);
+	struct data_slab_s *ds = _slab();
+	ds->type = STYPE_BUFFER;
+	ds->data.buffer.start = 0;
+	ds->data.buffer.end = gba->len;
+	ds->data.buffer.alloc = gba->len;
+	ds->data.buffer.buff = gba->data;
+	ds->data.buffer.gba = g_byte_array_ref(gba);
+	ds->next = NULL;
+	return ds;
+}
+
 struct data_slab_s *
 data_slab_make_buffer2(guint8 *buff, gboolean tobefreed, gsize start,
 		gsize end, gsize alloc)
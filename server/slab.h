@@ -48,6 +48,7 @@ struct data_slab_s
 			guint end;
 			guint alloc;
 			guint8 *buff;
+			GByteArray *gba; /* if set, holds <buff> instead of being freed */
 		} buffer;
 		struct {
 			off_t start;
@@ -103,6 +104,8 @@ gboolean data_slab_sequence_ready_for_data(struct data_slab_sequence_s *dss);
 
 gboolean data_slab_sequence_has_data(struct data_slab_sequence_s *dss);
 
+/* Sends the first slab of the sequence, or gather the first consecutive
+ * buffer slabs in a single writev(). */
 gboolean data_slab_sequence_send(struct data_slab_sequence_s *dss, int fd);
 
 void data_slab_sequence_append(struct data_slab_sequence_s *dss,
@@ -163,6 +166,10 @@ data_slab_make_gba(GByteArray *gba)
 	return data_slab_make_buffer2(g_byte_array_free(gba, FALSE), TRUE, 0, l, l);
 }
 
+/* Takes a reference on <gba> and sends its content without copy. The array
+ * must not be modified until the slab is freed. */
+struct data_slab_s * data_slab_make_gba_ref(GByteArray *gba);
+
 static inline struct data_slab_s *
 data_slab_make_string(const gchar *s)
 {
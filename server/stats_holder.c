@@ -162,3 +162,53 @@ grid_single_rrd_get_allmax(struct grid_single_rrd_s *gsr,
 	}
 }
 
+
+/* ------------------------------------------------------------------------- */
+
+guint
+grid_histogram_bucket(guint64 v)
+{
+	if (v < 2 * GRID_HISTOGRAM_SUB)
+		return v;
+	if (v >> GRID_HISTOGRAM_MAXPOW)
+		return GRID_HISTOGRAM_BUCKETS - 1;
+	const guint e = 63 - __builtin_clzll(v); /* >= 4 */
+	const guint sub = (v >> (e - 3)) & (GRID_HISTOGRAM_SUB - 1);
+	return 2 * GRID_HISTOGRAM_SUB + (e - 4) * GRID_HISTOGRAM_SUB + sub;
+}
+
+guint64
+grid_histogram_value(guint b)
+{
+	if (b < 2 * GRID_HISTOGRAM_SUB)
+		return b;
+	if (b >= GRID_HISTOGRAM_BUCKETS - 1)
+		return G_MAXUINT64;
+	b -= 2 * GRID_HISTOGRAM_SUB;
+	const guint e = 4 + b / GRID_HISTOGRAM_SUB;
+	const guint64 sub = GRID_HISTOGRAM_SUB + b % GRID_HISTOGRAM_SUB;
+	return ((sub + 1) << (e - 3)) - 1;
+}
+
+guint64
+grid_histogram_quantile(const guint64 *buckets, gdouble q)
+{
+	guint64 total = 0;
+	for (guint b = 0; b < GRID_HISTOGRAM_BUCKETS ;++b)
+		total += buckets[b];
+	if (!total)
+		return 0;
+
+	guint64 rank = (guint64) (q * total);
+	if (rank < 1)
+		rank = 1;
+	if (rank > total)
+		rank = total;
+
+	guint64 seen = 0;
+	for (guint b = 0; b < GRID_HISTOGRAM_BUCKETS ;++b) {
+		if ((seen += buckets[b]) >= rank)
+			return grid_histogram_value(b);
+	}
+	return grid_histogram_value(GRID_HISTOGRAM_BUCKETS - 1);
+}
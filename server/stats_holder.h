@@ -60,4 +60,24 @@ guint64 grid_single_rrd_get_max(struct grid_single_rrd_s *gsr,
 void grid_single_rrd_get_allmax(struct grid_single_rrd_s *gsr,
 		time_t at, time_t period, guint64 *out);
 
+/* Log-linear histograms ---------------------------------------------------- */
+
+/* The values below 16 have their own bucket, then each power of two is
+ * split in 8 buckets, so that a bucket is at most 12.5% wide. The values
+ * from 2^40 share an extra last bucket. */
+#define GRID_HISTOGRAM_SUB 8
+#define GRID_HISTOGRAM_MAXPOW 40
+#define GRID_HISTOGRAM_BUCKETS \
+	(2 * GRID_HISTOGRAM_SUB + (GRID_HISTOGRAM_MAXPOW - 4) * GRID_HISTOGRAM_SUB + 1)
+
+/*! Index of the bucket <v> falls into */
+guint grid_histogram_bucket(guint64 v);
+
+/*! Highest value that falls into the bucket <b> */
+guint64 grid_histogram_value(guint b);
+
+/*! Value under which the fraction <q> (in [0,1]) of the samples falls, out
+ * of the GRID_HISTOGRAM_BUCKETS counters at <buckets>. */
+guint64 grid_histogram_quantile(const guint64 *buckets, gdouble q);
+
 #endif /*OIO_SDS__server__stats_holder_h*/
@@ -517,9 +517,7 @@ _notify_request(struct req_ctx_s *ctx, GQuark gq_count, GQuark gq_time)
 
 	gint64 diff = ctx->tv_end - ctx->tv_start;
 
-	network_server_stat_push4 (ctx->client->server, TRUE,
-			gq_count, 1, gq_count_all, 1,
-			gq_time, diff, gq_time_all, diff);
+	network_server_stat_request (ctx->client->server, gq_count, gq_time, diff);
 }
 
 static gboolean
@@ -605,11 +603,17 @@ _client_call_handler(struct req_ctx_s *req_ctx)
 		EXTRA_ASSERT(!req_ctx->final_sent);
 		GRID_DEBUG("fd=%d REPLY code=%d message=%s", req_ctx->client->fd, code, msg);
 
-		MESSAGE answer = metaXServer_reply_simple(req_ctx->request, code, msg);
+		/* The body is not copied in the message: only the envelope is
+		 * encoded, then the body follows in its own slab */
+		struct data_slab_s *payload = NULL;
 		if (body) {
-			metautils_message_add_body_unref(answer, body);
+			if (body->len)
+				payload = data_slab_make_gba_ref(body);
+			metautils_gba_unref(body);
 			body = NULL;
 		}
+
+		MESSAGE answer = metaXServer_reply_simple(req_ctx->request, code, msg);
 		if (headers) {
 			GHashTableIter iter;
 			gpointer n, v;
@@ -629,7 +633,25 @@ _client_call_handler(struct req_ctx_s *req_ctx)
 			item.out_len = 0;
 			network_client_log_access(&item);
 		}
-		_reply_message(req_ctx->client, answer);
+		if (!payload) {
+			_reply_message(req_ctx->client, answer);
+			return;
+		}
+
+		GError *err = NULL;
+		GByteArray *envelope = message_marshall_gba_envelope(answer,
+				data_slab_size(payload), &err);
+		metautils_message_destroy(answer);
+		if (!envelope) {
+			GRID_ERROR("fd=%d Reply encoding error: (%d) %s",
+					req_ctx->client->fd, err->code, err->message);
+			g_clear_error(&err);
+			data_slab_free(payload);
+			return;
+		}
+		struct data_slab_s *first = data_slab_make_gba(envelope);
+		first->next = payload;
+		network_client_send_slabs(req_ctx->client, first);
 	}
 	void _send_error(gint code, GError *e) {
 		EXTRA_ASSERT(!req_ctx->final_sent);
@@ -902,6 +924,17 @@ dispatch_STATS(struct gridd_reply_ctx_s *reply,
 	}
 	g_array_free (array, TRUE);
 
+	struct gridd_client_cnx_stats_s cs = {0};
+	gridd_client_cnx_stats (&cs);
+	gchar tmp[256];
+	gsize len = g_snprintf (tmp, sizeof(tmp),
+			"counter client.cnx.connected=%"G_GUINT64_FORMAT"\n"
+			"counter client.cnx.reused=%"G_GUINT64_FORMAT"\n"
+			"counter client.cnx.dropped=%"G_GUINT64_FORMAT"\n"
+			"gauge client.cnx.idle=%u\n",
+			cs.connected, cs.reused, cs.dropped, cs.idle);
+	g_byte_array_append (body, (guint8*)tmp, len);
+
 	if (oio_server_volume) {
 		g_byte_array_append (body,
 				(guint8*)VOLPREFIX, sizeof(VOLPREFIX)-1);
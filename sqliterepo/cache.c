@@ -31,19 +31,34 @@ License along with this library.
 
 #define GET(R,I) ((R)->bases + (I))
 
-#define BEACON_RESET(B) do { (B)->first = (B)->last = -1; } while (0)
+#define BEACON_RESET(B) do { (B)->first = (B)->last = -1; (B)->count = 0; } while (0)
+
+/* Count-min sketch of the recent uses of the bases, used to decide if a
+ * base is worth being kept open once released (TinyLFU-like admission).
+ * The counters are halved every SKETCH_PERIOD_FACTOR * max_bases uses, so
+ * that the past popularity fades out. */
+#define SKETCH_DEPTH 4
+#define SKETCH_WIDTH 8192
+#define SKETCH_MAX 15
+#define SKETCH_PERIOD_FACTOR 10
+
+/* Percentage of the bases allowed in the protected (IDLE_HOT) segment */
+#define PROTECTED_RATIO 80
 
 struct beacon_s
 {
 	gint first;
 	gint last;
+	guint count;
 };
 
 enum sqlx_base_status_e
 {
 	SQLX_BASE_FREE=1,
-	SQLX_BASE_IDLE,	  /*!< without user */
-	SQLX_BASE_IDLE_HOT,	  /*!< without user */
+	SQLX_BASE_IDLE,	  /*!< without user, probationary segment */
+	SQLX_BASE_IDLE_HOT,	  /*!< without user, protected segment: reused
+							   * at least heat_threshold times since it
+							   * has been opened */
 	SQLX_BASE_USED,	  /*!< with users. count_open then
 						 * tells how many threads have marked the base
 						 * to be kept open, and owner tells if the lock
@@ -57,7 +72,8 @@ struct sqlx_base_s
 
 	GThread *owner; /*!< The current owner of the database. Changed under the
 					  global lock */
-	GCond *cond;
+	GCond cond; /*!< Only the threads waiting for this base wait on it */
+	guint32 waiters; /*!< Changed under the global lock */
 
 	gpointer handle;
 
@@ -68,7 +84,9 @@ struct sqlx_base_s
 		gint next;
 	} link; /*< Used to build a doubly-linked list */
 
-	guint32 heat;
+	guint32 heat; /*!< Hits since the base has been opened */
+
+	gint64 mem; /*!< Memory used by the handle, as of its last release */
 
 	guint32 count_open; /*!< Counts the number of times this base has been
 						  explicitely opened and locked by the user. */
@@ -88,10 +106,11 @@ struct sqlx_cache_s
 	GTree *bases_by_name;
 	guint bases_count;
 	sqlx_base_t *bases;
-	GCond *cond_array;
-	gsize cond_count;
 
 	guint32 heat_threshold;
+	guint protected_max;
+	gint64 mem_max; /* 0 for no budget */
+	gint64 mem_used;
 	gint64 cool_grace_delay; // same precision as oio_ext_monotonic_time()
 	gint64 hot_grace_delay;  // idem
 	gint64 open_timeout;     // idem
@@ -103,6 +122,23 @@ struct sqlx_cache_s
 	struct beacon_s beacon_used;
 
 	sqlx_cache_close_hook close_hook;
+	sqlx_cache_size_hook size_hook;
+
+	struct {
+		guint8 counters[SKETCH_DEPTH][SKETCH_WIDTH];
+		guint32 additions;
+	} sketch;
+
+	struct cache_counts_s stats; /* only the cumulated counters */
+};
+
+enum sqlx_eviction_e
+{
+	SQLX_EVICT_IDLE,
+	SQLX_EVICT_PRESSURE,
+	SQLX_EVICT_MEMORY,
+	SQLX_EVICT_REJECTED,
+	SQLX_EVICT_FORCED,
 };
 
 gint64 oio_cache_period_cond_wait = G_TIME_SPAN_SECOND;
@@ -115,6 +151,62 @@ base_id_out(sqlx_cache_t *cache, gint bd)
 	return (bd < 0) || ((guint)bd) >= cache->bases_count;
 }
 
+static guint
+_sketch_slot(guint32 h, guint row)
+{
+	h += row * 0x9E3779B9u;
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	return h % SKETCH_WIDTH;
+}
+
+static guint
+_sketch_get(sqlx_cache_t *cache, const hashstr_t *hs)
+{
+	const guint32 h = hashstr_hash(hs);
+	guint f = SKETCH_MAX;
+	for (guint row = 0; row < SKETCH_DEPTH; ++row)
+		f = MIN(f, cache->sketch.counters[row][_sketch_slot(h, row)]);
+	return f;
+}
+
+static void
+_sketch_add(sqlx_cache_t *cache, const hashstr_t *hs)
+{
+	const guint32 h = hashstr_hash(hs);
+	for (guint row = 0; row < SKETCH_DEPTH; ++row) {
+		guint8 *pc = &cache->sketch.counters[row][_sketch_slot(h, row)];
+		if (*pc < SKETCH_MAX)
+			++ *pc;
+	}
+
+	if (++ cache->sketch.additions >= SKETCH_PERIOD_FACTOR * cache->bases_count) {
+		for (guint row = 0; row < SKETCH_DEPTH; ++row) {
+			for (guint i = 0; i < SKETCH_WIDTH; ++i)
+				cache->sketch.counters[row][i] >>= 1;
+		}
+		cache->sketch.additions = 0;
+	}
+}
+
+static void
+_base_wait(sqlx_cache_t *cache, sqlx_base_t *base)
+{
+	/* XXX(jfs): do not use 'now' because it can be a fake clock */
+	base->waiters ++;
+	g_cond_wait_until(&base->cond, &cache->lock,
+			g_get_monotonic_time() + oio_cache_period_cond_wait);
+	base->waiters --;
+}
+
+static void
+_base_notify(sqlx_base_t *base)
+{
+	if (base->waiters)
+		g_cond_broadcast(&base->cond);
+}
+
 #ifdef HAVE_EXTRA_DEBUG
 static const gchar *
 sqlx_status_to_str(enum sqlx_base_status_e status)
@@ -215,6 +307,7 @@ SQLX_REMOVE(sqlx_cache_t *cache, sqlx_base_t *base,
 	base->status = 0;
 	base->link.prev = -1;
 	base->link.next = -1;
+	beacon->count --;
 }
 
 static void
@@ -233,6 +326,7 @@ SQLX_UNSHIFT(sqlx_cache_t *cache, sqlx_base_t *base,
 
 	if (beacon->last < 0)
 		beacon->last = base->index;
+	beacon->count ++;
 
 	base->status = status;
 	base->last_update = oio_ext_monotonic_time ();
@@ -346,6 +440,8 @@ sqlx_base_reserve(sqlx_cache_t *cache, const hashstr_t *hs,
 	g_free0 (base->name);
 	base->name = hashstr_dup(hs);
 	base->count_open = 1;
+	base->heat = 0;
+	base->mem = 0;
 	base->handle = NULL;
 	base->owner = g_thread_self();
 	sqlx_base_move_to_list(cache, base, SQLX_BASE_USED);
@@ -368,10 +464,28 @@ sqlx_base_reserve(sqlx_cache_t *cache, const hashstr_t *hs,
  * - The cache-wide lock is still owned
  */
 static void
-_expire_base(sqlx_cache_t *cache, sqlx_base_t *b)
+_expire_base(sqlx_cache_t *cache, sqlx_base_t *b, enum sqlx_eviction_e why)
 {
 	gpointer handle = b->handle;
 
+	switch (why) {
+		case SQLX_EVICT_IDLE:
+			cache->stats.evicted.idle ++;
+			break;
+		case SQLX_EVICT_PRESSURE:
+			cache->stats.evicted.pressure ++;
+			break;
+		case SQLX_EVICT_MEMORY:
+			cache->stats.evicted.memory ++;
+			break;
+		case SQLX_EVICT_REJECTED:
+			cache->stats.evicted.rejected ++;
+			break;
+		case SQLX_EVICT_FORCED:
+			cache->stats.evicted.forced ++;
+			break;
+	}
+
 	sqlx_base_debug("FREEING", b);
 	EXTRA_ASSERT(b->owner != NULL);
 	EXTRA_ASSERT(b->count_open == 0);
@@ -382,7 +496,7 @@ _expire_base(sqlx_cache_t *cache, sqlx_base_t *b)
 	/* the base is for the given thread, it is time to REALLY close it.
 	 * But this can take a lot of time. So we can release the pool,
 	 * free the handle and unlock the cache */
-	g_cond_signal(b->cond);
+	_base_notify(b);
 	g_mutex_unlock(&cache->lock);
 	if (cache->close_hook)
 		cache->close_hook(handle);
@@ -395,6 +509,9 @@ _expire_base(sqlx_cache_t *cache, sqlx_base_t *b)
 	b->name = NULL;
 	b->count_open = 0;
 	b->last_update = 0;
+	b->heat = 0;
+	cache->mem_used -= b->mem;
+	b->mem = 0;
 	sqlx_base_move_to_list(cache, b, SQLX_BASE_FREE);
 
 	g_tree_remove(cache->bases_by_name, n);
@@ -403,7 +520,7 @@ _expire_base(sqlx_cache_t *cache, sqlx_base_t *b)
 
 static gint
 _expire_specific_base(sqlx_cache_t *cache, sqlx_base_t *b, gint64 now,
-		gint64 grace_delay)
+		gint64 grace_delay, enum sqlx_eviction_e why)
 {
 	if (now) {
 		now = (now > grace_delay) ? (now - grace_delay) : 0;
@@ -424,33 +541,81 @@ _expire_specific_base(sqlx_cache_t *cache, sqlx_base_t *b, gint64 now,
 	b->owner = g_thread_self();
 	sqlx_base_move_to_list(cache, b, SQLX_BASE_USED);
 
-	_expire_base(cache, b);
+	_expire_base(cache, b, why);
 
 	/* If someone is waiting on the base while it is being closed
 	 * (this arrives when someone tries to read it again after
 	 * waiting exactly the grace delay), we must notify him so it can
 	 * retry (and open it in another file descriptor). */
-	g_cond_signal(b->cond);
+	_base_notify(b);
 
 	return 1;
 }
 
+/* With a zero <now>, the grace delays are ignored */
 static gint
-sqlx_expire_first_idle_base(sqlx_cache_t *cache, gint64 now)
+sqlx_expire_first_idle_base(sqlx_cache_t *cache, gint64 now,
+		enum sqlx_eviction_e why)
 {
 	gint rc = 0, bd_idle;
 
-	/* Poll the next idle base, and respect the increasing order of the 'heat' */
+	/* Poll the next idle base: the probationary segment first, so that
+	 * a scan through many bases does not flush the protected ones */
 	if (0 <= (bd_idle = cache->beacon_idle.last))
 		rc = _expire_specific_base(cache, GET(cache, bd_idle), now,
-				cache->cool_grace_delay);
+				cache->cool_grace_delay, why);
 	if (!rc && 0 <= (bd_idle = cache->beacon_idle_hot.last))
 		rc = _expire_specific_base(cache, GET(cache, bd_idle), now,
-				cache->hot_grace_delay);
+				cache->hot_grace_delay, why);
 
 	return rc;
 }
 
+static gboolean
+_over_budget(sqlx_cache_t *cache)
+{
+	return cache->mem_max > 0 && cache->mem_used > cache->mem_max;
+}
+
+/* Keep the protected segment within its quota, the extra bases go back
+ * to the head of the probationary segment. */
+static void
+_protected_trim(sqlx_cache_t *cache)
+{
+	while (cache->beacon_idle_hot.count > cache->protected_max) {
+		sqlx_base_t *b = GET(cache, cache->beacon_idle_hot.last);
+		b->heat = 0;
+		sqlx_base_move_to_list(cache, b, SQLX_BASE_IDLE);
+	}
+}
+
+/* Called when the last user of <base> releases it: keep the base open in
+ * the right segment, or close it right now if it is not worth the room it
+ * takes. The base is still owned by the current thread. */
+static void
+_release_base(sqlx_cache_t *cache, sqlx_base_t *base)
+{
+	if (base->heat >= cache->heat_threshold) {
+		base->owner = NULL;
+		sqlx_base_move_to_list(cache, base, SQLX_BASE_IDLE_HOT);
+		_protected_trim(cache);
+		return;
+	}
+
+	/* Admission: when the cache is full, a base used once won't evict a
+	 * base that has been more popular recently */
+	if (cache->beacon_free.first < 0 && cache->beacon_idle.last >= 0) {
+		sqlx_base_t *victim = GET(cache, cache->beacon_idle.last);
+		if (_sketch_get(cache, base->name) <= _sketch_get(cache, victim->name)) {
+			_expire_base(cache, base, SQLX_EVICT_REJECTED);
+			return;
+		}
+	}
+
+	base->owner = NULL;
+	sqlx_base_move_to_list(cache, base, SQLX_BASE_IDLE);
+}
+
 static void
 sqlx_cache_reset_bases(sqlx_cache_t *cache, guint max)
 {
@@ -467,19 +632,24 @@ sqlx_cache_reset_bases(sqlx_cache_t *cache, guint max)
 		BEACON_RESET(&(cache->beacon_idle_hot));
 		BEACON_RESET(&(cache->beacon_used));
 
-		if (cache->bases)
+		if (cache->bases) {
+			for (i = 0; i < cache->bases_count ;i++)
+				g_cond_clear(&cache->bases[i].cond);
 			g_free(cache->bases);
+		}
 
 		old = cache->bases_count;
 		cache->bases_count = max;
 		cache->bases = g_malloc0(cache->bases_count * sizeof(sqlx_base_t));
+		cache->protected_max = MAX(1, (max * PROTECTED_RATIO) / 100);
 
+		for (i = 0; i < cache->bases_count ;i++)
+			g_cond_init(&cache->bases[i].cond);
 		for (i = cache->bases_count - 1; i!=0 ;i--) {
 			sqlx_base_t *base = cache->bases + i;
 			base->index = i;
 			base->link.prev = base->link.next = -1;
 			SQLX_UNSHIFT(cache, base, &(cache->beacon_free), SQLX_BASE_FREE);
-			base->cond = cache->cond_array + (i % cache->cond_count);
 		}
 
 		GRID_INFO("SQLX cache size change from %u to %u", old,
@@ -514,10 +684,25 @@ sqlx_cache_set_open_timeout(sqlx_cache_t *cache, gint64 timeout)
 	cache->open_timeout = timeout;
 }
 
+void
+sqlx_cache_set_size_hook(sqlx_cache_t *cache, sqlx_cache_size_hook hook)
+{
+	EXTRA_ASSERT(cache != NULL);
+	cache->size_hook = hook;
+}
+
+void
+sqlx_cache_set_max_memory(sqlx_cache_t *cache, gint64 max)
+{
+	EXTRA_ASSERT(cache != NULL);
+	g_mutex_lock(&cache->lock);
+	cache->mem_max = MAX(0, max);
+	g_mutex_unlock(&cache->lock);
+}
+
 sqlx_cache_t *
 sqlx_cache_init(void)
 {
-	guint i;
 	sqlx_cache_t *cache;
 
 	cache = g_malloc0(sizeof(*cache));
@@ -529,17 +714,12 @@ sqlx_cache_init(void)
 	cache->bases_by_name = g_tree_new_full(hashstr_quick_cmpdata,
 			NULL, NULL, NULL);
 	cache->bases_count = SQLX_MAX_BASES;
-	cache->cond_count = SQLX_MAX_COND;
-	cache->cond_array = g_malloc0(cache->cond_count * sizeof(GCond));
 	cache->open_timeout = 0;
 	BEACON_RESET(&(cache->beacon_free));
 	BEACON_RESET(&(cache->beacon_idle));
 	BEACON_RESET(&(cache->beacon_idle_hot));
 	BEACON_RESET(&(cache->beacon_used));
 
-	for (i=0; i<cache->cond_count ;i++)
-		g_cond_init(cache->cond_array + i);
-
 	sqlx_cache_reset_bases(cache, cache->bases_count);
 	return cache;
 }
@@ -571,16 +751,12 @@ sqlx_cache_clean(sqlx_cache_t *cache)
 
 			g_free0 (base->name);
 			base->name = NULL;
+			g_cond_clear(&base->cond);
 		}
 		g_free(cache->bases);
 	}
 
 	g_mutex_clear(&cache->lock);
-	if (cache->cond_array) {
-		for (guint i=0; i<cache->cond_count ;i++)
-			g_cond_clear(cache->cond_array + i);
-		g_free(cache->cond_array);
-	}
 	if (cache->bases_by_name)
 		g_tree_destroy(cache->bases_by_name);
 
@@ -614,15 +790,21 @@ retry:
 
 	bd = sqlx_lookup_id(cache, hname);
 	if (bd < 0) {
+		/* Make room in the memory budget before opening another base */
+		if (_over_budget(cache)
+				&& sqlx_expire_first_idle_base(cache, 0, SQLX_EVICT_MEMORY) > 0)
+			goto retry;
 		if (!(err = sqlx_base_reserve(cache, hname, &base))) {
 			bd = base->index;
 			*result = base->index;
+			cache->stats.misses ++;
+			_sketch_add(cache, hname);
 			sqlx_base_debug("OPEN", base);
 		}
 		else {
 			GRID_DEBUG("No base available for [%s] (%d %s)",
 					hashstr_str(hname), err->code, err->message);
-			if (sqlx_expire_first_idle_base(cache, 0) >= 0) {
+			if (sqlx_expire_first_idle_base(cache, 0, SQLX_EVICT_PRESSURE) > 0) {
 				g_clear_error(&err);
 				goto retry;
 			}
@@ -652,6 +834,9 @@ retry:
 				sqlx_base_move_to_list(cache, base, SQLX_BASE_USED);
 				base->count_open ++;
 				base->owner = g_thread_self();
+				base->heat ++;
+				cache->stats.hits ++;
+				_sketch_add(cache, hname);
 				*result = base->index;
 				break;
 
@@ -661,10 +846,8 @@ retry:
 				if (base->owner != g_thread_self()) {
 					GRID_DEBUG("Base [%s] in use by another thread (%X), waiting...",
 							hashstr_str(hname), oio_log_thread_id(base->owner));
-					/* The lock is held by another thread/request.
-					   XXX(jfs): do not use 'now' because it can be a fake clock */
-					g_cond_wait_until(base->cond, &cache->lock,
-							g_get_monotonic_time() + oio_cache_period_cond_wait);
+					/* The lock is held by another thread/request. */
+					_base_wait(cache, base);
 					goto retry;
 				}
 				base->owner = g_thread_self();
@@ -674,10 +857,8 @@ retry:
 
 			case SQLX_BASE_CLOSING:
 				EXTRA_ASSERT(base->owner != NULL);
-				/* Just wait for a notification then retry
-				   XXX(jfs): do not use 'now' because it can be a fake clock */
-				g_cond_wait_until(base->cond, &cache->lock,
-						g_get_monotonic_time() + oio_cache_period_cond_wait);
+				/* Just wait for a notification then retry */
+				_base_wait(cache, base);
 				goto retry;
 		}
 	}
@@ -688,7 +869,7 @@ retry:
 			EXTRA_ASSERT(base->owner == g_thread_self());
 			EXTRA_ASSERT(base->count_open > 0);
 		}
-		g_cond_signal(base->cond);
+		_base_notify(base);
 	}
 	g_mutex_unlock(&cache->lock);
 	return err;
@@ -705,10 +886,17 @@ sqlx_cache_unlock_and_close_base(sqlx_cache_t *cache, gint bd, gboolean force)
 	if (base_id_out(cache, bd))
 		return NEWERROR(CODE_INTERNAL_ERROR, "invalid base id=%d", bd);
 
+	sqlx_base_t *base; base = GET(cache,bd);
+
+	/* The current thread owns the base, its handle may be inspected
+	 * without the global lock */
+	gint64 mem = -1;
+	if (cache->size_hook && base->handle && base->owner == g_thread_self())
+		mem = cache->size_hook(base->handle);
+
 	g_mutex_lock(&cache->lock);
 	cache->used = TRUE;
 
-	sqlx_base_t *base; base = GET(cache,bd);
 	switch (base->status) {
 
 		case SQLX_BASE_FREE:
@@ -727,16 +915,16 @@ sqlx_cache_unlock_and_close_base(sqlx_cache_t *cache, gint bd, gboolean force)
 		case SQLX_BASE_USED:
 			EXTRA_ASSERT(base->count_open > 0);
 			// held by the current thread
+			if (mem >= 0) {
+				cache->mem_used += mem - base->mem;
+				base->mem = mem;
+			}
 			if (!(-- base->count_open)) { // to be closed
 				if (force) {
-					_expire_base(cache, base);
+					_expire_base(cache, base, SQLX_EVICT_FORCED);
 				} else {
 					sqlx_base_debug("CLOSING", base);
-					base->owner = NULL;
-					if (base->heat >= cache->heat_threshold)
-						sqlx_base_move_to_list(cache, base, SQLX_BASE_IDLE_HOT);
-					else
-						sqlx_base_move_to_list(cache, base, SQLX_BASE_IDLE);
+					_release_base(cache, base);
 				}
 			}
 			break;
@@ -750,7 +938,7 @@ sqlx_cache_unlock_and_close_base(sqlx_cache_t *cache, gint bd, gboolean force)
 
 	if (base && !err)
 		sqlx_base_debug(__FUNCTION__, base);
-	g_cond_signal(base->cond);
+	_base_notify(base);
 	g_mutex_unlock(&cache->lock);
 	return err;
 }
@@ -795,7 +983,7 @@ sqlx_cache_expire_all(sqlx_cache_t *cache)
 
 	g_mutex_lock(&cache->lock);
 	cache->used = TRUE;
-	for (nb=0; sqlx_expire_first_idle_base(cache, 0) ;nb++) { }
+	for (nb=0; sqlx_expire_first_idle_base(cache, 0, SQLX_EVICT_FORCED) ;nb++) { }
 	g_mutex_unlock(&cache->lock);
 
 	return nb;
@@ -812,9 +1000,17 @@ sqlx_cache_expire(sqlx_cache_t *cache, guint max, gint64 duration)
 	g_mutex_lock(&cache->lock);
 	cache->used = TRUE;
 
-	for (nb=0; !max || nb < max ; nb++) {
+	/* First honor the memory budget, whatever the grace delays */
+	for (; (!max || nb < max) && _over_budget(cache) ; nb++) {
+		if (oio_ext_monotonic_time () > pivot
+				|| !sqlx_expire_first_idle_base(cache, 0, SQLX_EVICT_MEMORY))
+			break;
+	}
+
+	for (; !max || nb < max ; nb++) {
 		gint64 now = oio_ext_monotonic_time ();
-		if (now > pivot || !sqlx_expire_first_idle_base(cache, now))
+		if (now > pivot
+				|| !sqlx_expire_first_idle_base(cache, now, SQLX_EVICT_IDLE))
 			break;
 	}
 
@@ -845,19 +1041,6 @@ sqlx_cache_set_handle(sqlx_cache_t *cache, gint bd, gpointer sq3)
 	base->handle = sq3;
 }
 
-static guint
-_count_beacon(sqlx_cache_t *cache, struct beacon_s *beacon)
-{
-	guint count = 0;
-	g_mutex_lock(&cache->lock);
-	for (gint idx = beacon->first; idx != -1 ;) {
-		++ count;
-		idx = GET(cache, idx)->link.next;
-	}
-	g_mutex_unlock(&cache->lock);
-	return count;
-}
-
 struct cache_counts_s
 sqlx_cache_count(sqlx_cache_t *cache)
 {
@@ -865,10 +1048,15 @@ sqlx_cache_count(sqlx_cache_t *cache)
 
 	memset(&count, 0, sizeof(count));
 	if (cache) {
+		g_mutex_lock(&cache->lock);
+		count = cache->stats;
 		count.max = cache->bases_count;
-		count.cold = _count_beacon(cache, &cache->beacon_idle);
-		count.hot = _count_beacon(cache, &cache->beacon_idle_hot);
-		count.used = _count_beacon(cache, &cache->beacon_used);
+		count.cold = cache->beacon_idle.count;
+		count.hot = cache->beacon_idle_hot.count;
+		count.used = cache->beacon_used.count;
+		count.mem_max = cache->mem_max;
+		count.mem_used = cache->mem_used;
+		g_mutex_unlock(&cache->lock);
 	}
 
 	return count;
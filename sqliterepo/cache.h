@@ -31,6 +31,9 @@ struct hashstr_s;
 
 typedef void (*sqlx_cache_close_hook)(gpointer);
 
+/* Returns the memory (in bytes) used by the handle */
+typedef gint64 (*sqlx_cache_size_hook)(gpointer);
+
 typedef struct sqlx_cache_s sqlx_cache_t;
 
 gpointer sqlx_cache_get_handle(sqlx_cache_t *cache, gint bd);
@@ -47,6 +50,14 @@ void sqlx_cache_set_max_bases(sqlx_cache_t *cache, guint max);
 /* timeout in the precision of oio_ext_monotonic_time() */
 void sqlx_cache_set_open_timeout(sqlx_cache_t *cache, gint64 timeout);
 
+/* The hook is called each time a base is released, to account the memory
+ * it uses (mostly its page cache) in the budget. */
+void sqlx_cache_set_size_hook(sqlx_cache_t *cache, sqlx_cache_size_hook hook);
+
+/* Idle bases are closed as long as the memory used by the open bases
+ * exceeds <max> bytes (0 for no limit). */
+void sqlx_cache_set_max_memory(sqlx_cache_t *cache, gint64 max);
+
 void sqlx_cache_clean(sqlx_cache_t *cache);
 
 void sqlx_cache_debug(sqlx_cache_t *cache);
@@ -65,13 +76,29 @@ guint sqlx_cache_expire_all(sqlx_cache_t *cache);
 /** Check for expired bases, then close them */
 guint sqlx_cache_expire(sqlx_cache_t *cache, guint max, gint64 duration);
 
-/** One statistics for each possible base's status */
+/** One statistics for each possible base's status, then the cumulated
+ * activity of the cache */
 struct cache_counts_s
 {
 	guint max;
 	guint cold;
 	guint hot;
 	guint used;
+
+	gint64 mem_max;
+	gint64 mem_used;
+
+	guint64 hits;
+	guint64 misses;
+
+	/* Why the bases have been closed */
+	struct {
+		guint64 idle;     /* grace delay elapsed */
+		guint64 pressure; /* room needed for another base */
+		guint64 memory;   /* memory budget exceeded */
+		guint64 rejected; /* not worth being kept open after its use */
+		guint64 forced;   /* explicitly closed */
+	} evicted;
 };
 
 /** Returns several statistics about the current cache. Returns zeroed
@@ -32,7 +32,6 @@ License along with this library.
 #include "version.h"
 #include "sqlx_remote.h"
 #include "synchro.h"
-#include "gridd_client_pool.h"
 #include "internals.h"
 
 #define EVENTLOG_SIZE 16
@@ -82,6 +82,18 @@ License along with this library.
 /* Size of chunks sent to client when doing chunked SQLX_DUMP */
 #define SQLX_DUMP_CHUNK_SIZE (8*1024*1024)
 
+/* Above that size, the dumps are written in temporary files instead of
+ * the memory VFS */
+#define SQLX_DUMP_MEMORY_MAX (256*1024*1024)
+
+/* How many pages are covered by one checksum, when computing the diff
+ * of two dumps (i.e. 64kiB with the default page size) */
+#define SQLX_DIFF_PAGES_PER_RANGE 16
+
+/* Above that percentage of the whole base, the diff is abandoned and the
+ * peer performs a full dump */
+#define SQLX_DIFF_MAX_RATIO 50
+
 /* Page size at database creation (should be multiple of storage block size) */
 #define SQLX_DEFAULT_PAGE_SIZE "4096"
 
@@ -181,4 +193,8 @@ extern gint64 oio_cache_period_cond_wait;
  * current thread should wait for the condition in the cache of bases. */
 extern gint64 oio_election_period_cond_wait;
 
+/* The maximum size of a base dumped or restored in memory, in bytes.
+ * Bigger bases go through temporary files. */
+extern gint64 oio_sqlx_dump_max_memory;
+
 #endif /*OIO_SDS__sqliterepo__internals_h*/
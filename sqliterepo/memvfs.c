@@ -0,0 +1,448 @@
+/*
+OpenIO SDS sqliterepo
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <string.h>
+
+#include <sqlite3.h>
+
+#include <metautils/lib/metautils.h>
+
+#include "memvfs.h"
+
+struct memvfs_buffer_s
+{
+	gchar *name;      /* NULL for anonymous files */
+	GByteArray *gba;  /* NULL for static buffers */
+	const guint8 *ro; /* borrowed, for static buffers */
+	gsize ro_len;
+	gsize max;
+	guint refcount;
+};
+
+struct memvfs_file_s
+{
+	sqlite3_file base;
+	struct memvfs_buffer_s *buf;
+	gboolean delete_on_close;
+};
+
+static GMutex memvfs_lock = {0};
+
+/* <gchar*,struct memvfs_buffer_s*>, under memvfs_lock */
+static GHashTable *memvfs_buffers = NULL;
+
+static sqlite3_vfs *memvfs_parent = NULL;
+
+static struct memvfs_buffer_s *
+_buffer_create(const gchar *name, GByteArray *gba,
+		const guint8 *ro, gsize ro_len, gsize max)
+{
+	struct memvfs_buffer_s *buf = g_malloc0(sizeof(*buf));
+	buf->name = name ? g_strdup(name) : NULL;
+	buf->gba = gba;
+	buf->ro = ro;
+	buf->ro_len = ro_len;
+	buf->max = max;
+	buf->refcount = 1;
+	return buf;
+}
+
+static void
+_buffer_unref(struct memvfs_buffer_s *buf)
+{
+	if (!buf || --buf->refcount > 0)
+		return;
+	if (buf->gba)
+		g_byte_array_free(buf->gba, TRUE);
+	g_free(buf->name);
+	g_free(buf);
+}
+
+static gsize
+_buffer_len(struct memvfs_buffer_s *buf)
+{
+	return buf->gba ? buf->gba->len : buf->ro_len;
+}
+
+static const guint8 *
+_buffer_data(struct memvfs_buffer_s *buf)
+{
+	return buf->gba ? buf->gba->data : buf->ro;
+}
+
+/* Must be called under the lock */
+static void
+_buffers_insert(struct memvfs_buffer_s *buf)
+{
+	struct memvfs_buffer_s *old = g_hash_table_lookup(memvfs_buffers, buf->name);
+	g_hash_table_replace(memvfs_buffers, buf->name, buf);
+	_buffer_unref(old);
+}
+
+/* Must be called under the lock, returns the reference of the table */
+static struct memvfs_buffer_s *
+_buffers_pop(const gchar *name)
+{
+	struct memvfs_buffer_s *buf = g_hash_table_lookup(memvfs_buffers, name);
+	if (buf)
+		g_hash_table_remove(memvfs_buffers, name);
+	return buf;
+}
+
+/* I/O methods -------------------------------------------------------------- */
+
+#define BUF(F) (((struct memvfs_file_s*)(F))->buf)
+
+static int
+_file_close(sqlite3_file *file)
+{
+	struct memvfs_file_s *f = (struct memvfs_file_s*) file;
+	g_mutex_lock(&memvfs_lock);
+	if (f->delete_on_close && f->buf->name
+			&& f->buf == g_hash_table_lookup(memvfs_buffers, f->buf->name))
+		_buffer_unref(_buffers_pop(f->buf->name));
+	_buffer_unref(f->buf);
+	g_mutex_unlock(&memvfs_lock);
+	f->buf = NULL;
+	return SQLITE_OK;
+}
+
+static int
+_file_read(sqlite3_file *file, void *p, int amount, sqlite3_int64 offset)
+{
+	struct memvfs_buffer_s *buf = BUF(file);
+	const gsize len = _buffer_len(buf);
+	gsize n = 0;
+
+	if ((gsize)offset < len) {
+		n = MIN((gsize)amount, len - offset);
+		memcpy(p, _buffer_data(buf) + offset, n);
+	}
+	if (n < (gsize)amount) {
+		memset(((guint8*)p) + n, 0, amount - n);
+		return SQLITE_IOERR_SHORT_READ;
+	}
+	return SQLITE_OK;
+}
+
+static int
+_file_write(sqlite3_file *file, const void *p, int amount, sqlite3_int64 offset)
+{
+	struct memvfs_buffer_s *buf = BUF(file);
+	if (!buf->gba)
+		return SQLITE_READONLY;
+
+	const gsize end = offset + amount;
+	if (buf->max > 0 && end > buf->max)
+		return SQLITE_FULL;
+	if (end > buf->gba->len) {
+		const guint old = buf->gba->len;
+		g_byte_array_set_size(buf->gba, end);
+		if ((gsize)offset > old)
+			memset(buf->gba->data + old, 0, offset - old);
+	}
+	memcpy(buf->gba->data + offset, p, amount);
+	return SQLITE_OK;
+}
+
+static int
+_file_truncate(sqlite3_file *file, sqlite3_int64 size)
+{
+	struct memvfs_buffer_s *buf = BUF(file);
+	if (!buf->gba)
+		return SQLITE_READONLY;
+	if ((gsize)size < buf->gba->len)
+		g_byte_array_set_size(buf->gba, size);
+	return SQLITE_OK;
+}
+
+static int
+_file_sync(sqlite3_file *file, int flags)
+{
+	(void) file, (void) flags;
+	return SQLITE_OK;
+}
+
+static int
+_file_size(sqlite3_file *file, sqlite3_int64 *psize)
+{
+	*psize = _buffer_len(BUF(file));
+	return SQLITE_OK;
+}
+
+/* A buffer is only used by one connection at once */
+static int
+_file_lock(sqlite3_file *file, int lock)
+{
+	(void) file, (void) lock;
+	return SQLITE_OK;
+}
+
+static int
+_file_check_reserved_lock(sqlite3_file *file, int *pres)
+{
+	(void) file;
+	*pres = 0;
+	return SQLITE_OK;
+}
+
+static int
+_file_control(sqlite3_file *file, int op, void *arg)
+{
+	(void) file, (void) op, (void) arg;
+	return SQLITE_NOTFOUND;
+}
+
+static int
+_file_sector_size(sqlite3_file *file)
+{
+	(void) file;
+	return 512;
+}
+
+static int
+_file_device_characteristics(sqlite3_file *file)
+{
+	(void) file;
+	return 0;
+}
+
+static const sqlite3_io_methods memvfs_io =
+{
+	1,
+	_file_close,
+	_file_read,
+	_file_write,
+	_file_truncate,
+	_file_sync,
+	_file_size,
+	_file_lock,
+	_file_lock,
+	_file_check_reserved_lock,
+	_file_control,
+	_file_sector_size,
+	_file_device_characteristics
+};
+
+/* VFS methods -------------------------------------------------------------- */
+
+static int
+_vfs_open(sqlite3_vfs *vfs, const char *name, sqlite3_file *file,
+		int flags, int *pout)
+{
+	struct memvfs_file_s *f = (struct memvfs_file_s*) file;
+	struct memvfs_buffer_s *buf = NULL;
+
+	(void) vfs;
+	memset(f, 0, sizeof(*f));
+
+	g_mutex_lock(&memvfs_lock);
+	if (name)
+		buf = g_hash_table_lookup(memvfs_buffers, name);
+	if (!buf) {
+		if (!(flags & SQLITE_OPEN_CREATE)) {
+			g_mutex_unlock(&memvfs_lock);
+			return SQLITE_CANTOPEN;
+		}
+		buf = _buffer_create(name, g_byte_array_new(), NULL, 0, 0);
+		if (name) {
+			_buffers_insert(buf);
+			buf->refcount ++;
+		}
+	} else {
+		buf->refcount ++;
+	}
+	g_mutex_unlock(&memvfs_lock);
+
+	f->buf = buf;
+	f->delete_on_close = BOOL(flags & SQLITE_OPEN_DELETEONCLOSE);
+	f->base.pMethods = &memvfs_io;
+	if (pout)
+		*pout = flags;
+	return SQLITE_OK;
+}
+
+static int
+_vfs_delete(sqlite3_vfs *vfs, const char *name, int sync_dir)
+{
+	(void) vfs, (void) sync_dir;
+	memvfs_remove(name);
+	return SQLITE_OK;
+}
+
+static int
+_vfs_access(sqlite3_vfs *vfs, const char *name, int flags, int *pres)
+{
+	(void) vfs;
+	g_mutex_lock(&memvfs_lock);
+	struct memvfs_buffer_s *buf = g_hash_table_lookup(memvfs_buffers, name);
+	if (flags == SQLITE_ACCESS_READWRITE)
+		*pres = buf && buf->gba;
+	else
+		*pres = buf && _buffer_len(buf) > 0;
+	g_mutex_unlock(&memvfs_lock);
+	return SQLITE_OK;
+}
+
+static int
+_vfs_full_pathname(sqlite3_vfs *vfs, const char *name, int nout, char *out)
+{
+	(void) vfs;
+	g_strlcpy(out, name, nout);
+	return SQLITE_OK;
+}
+
+static void *
+_vfs_dlopen(sqlite3_vfs *vfs, const char *path)
+{
+	(void) vfs;
+	return memvfs_parent->xDlOpen(memvfs_parent, path);
+}
+
+static void
+_vfs_dlerror(sqlite3_vfs *vfs, int n, char *msg)
+{
+	(void) vfs;
+	memvfs_parent->xDlError(memvfs_parent, n, msg);
+}
+
+static void
+(*_vfs_dlsym(sqlite3_vfs *vfs, void *handle, const char *sym))(void)
+{
+	(void) vfs;
+	return memvfs_parent->xDlSym(memvfs_parent, handle, sym);
+}
+
+static void
+_vfs_dlclose(sqlite3_vfs *vfs, void *handle)
+{
+	(void) vfs;
+	memvfs_parent->xDlClose(memvfs_parent, handle);
+}
+
+static int
+_vfs_randomness(sqlite3_vfs *vfs, int n, char *out)
+{
+	(void) vfs;
+	return memvfs_parent->xRandomness(memvfs_parent, n, out);
+}
+
+static int
+_vfs_sleep(sqlite3_vfs *vfs, int micros)
+{
+	(void) vfs;
+	return memvfs_parent->xSleep(memvfs_parent, micros);
+}
+
+static int
+_vfs_current_time(sqlite3_vfs *vfs, double *pnow)
+{
+	(void) vfs;
+	return memvfs_parent->xCurrentTime(memvfs_parent, pnow);
+}
+
+static int
+_vfs_get_last_error(sqlite3_vfs *vfs, int n, char *out)
+{
+	(void) vfs;
+	return memvfs_parent->xGetLastError(memvfs_parent, n, out);
+}
+
+static sqlite3_vfs memvfs =
+{
+	1,
+	sizeof(struct memvfs_file_s),
+	512,
+	NULL,
+	MEMVFS_NAME,
+	NULL,
+	_vfs_open,
+	_vfs_delete,
+	_vfs_access,
+	_vfs_full_pathname,
+	_vfs_dlopen,
+	_vfs_dlerror,
+	_vfs_dlsym,
+	_vfs_dlclose,
+	_vfs_randomness,
+	_vfs_sleep,
+	_vfs_current_time,
+	_vfs_get_last_error
+};
+
+/* Public API --------------------------------------------------------------- */
+
+void
+memvfs_register(void)
+{
+	static volatile gsize registered = 0;
+	if (g_once_init_enter(&registered)) {
+		memvfs_buffers = g_hash_table_new(g_str_hash, g_str_equal);
+		memvfs_parent = sqlite3_vfs_find(NULL);
+		int rc = sqlite3_vfs_register(&memvfs, 0);
+		if (rc != SQLITE_OK)
+			GRID_WARN("Failed to register the memory VFS: (%d)", rc);
+		g_once_init_leave(&registered, 1);
+	}
+}
+
+void
+memvfs_publish(const gchar *name, GByteArray *gba, gsize max)
+{
+	EXTRA_ASSERT(name != NULL);
+	EXTRA_ASSERT(gba != NULL);
+	memvfs_register();
+	g_mutex_lock(&memvfs_lock);
+	_buffers_insert(_buffer_create(name, gba, NULL, 0, max));
+	g_mutex_unlock(&memvfs_lock);
+}
+
+void
+memvfs_publish_static(const gchar *name, const guint8 *data, gsize len)
+{
+	EXTRA_ASSERT(name != NULL);
+	EXTRA_ASSERT(data != NULL);
+	memvfs_register();
+	g_mutex_lock(&memvfs_lock);
+	_buffers_insert(_buffer_create(name, NULL, data, len, 0));
+	g_mutex_unlock(&memvfs_lock);
+}
+
+GByteArray*
+memvfs_steal(const gchar *name)
+{
+	GByteArray *gba = NULL;
+	g_mutex_lock(&memvfs_lock);
+	struct memvfs_buffer_s *buf = _buffers_pop(name);
+	if (buf) {
+		EXTRA_ASSERT(buf->refcount == 1);
+		gba = buf->gba;
+		buf->gba = NULL;
+		_buffer_unref(buf);
+	}
+	g_mutex_unlock(&memvfs_lock);
+	return gba;
+}
+
+void
+memvfs_remove(const gchar *name)
+{
+	g_mutex_lock(&memvfs_lock);
+	_buffer_unref(_buffers_pop(name));
+	g_mutex_unlock(&memvfs_lock);
+}
@@ -0,0 +1,50 @@
+/*
+OpenIO SDS sqliterepo
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#ifndef OIO_SDS__sqliterepo__memvfs_h
+# define OIO_SDS__sqliterepo__memvfs_h 1
+
+#include <glib.h>
+
+/* A SQLite VFS whose files are memory buffers, looked up by name. It is
+ * used to dump and restore the bases without temporary files: publish a
+ * buffer under a name, open the name with the MEMVFS_NAME VFS, then take
+ * the buffer back. The files that SQLite creates on its own (journals,
+ * temporary files) are kept in memory too. */
+
+#define MEMVFS_NAME "oio-mem"
+
+/* Idempotent and thread-safe */
+void memvfs_register(void);
+
+/* Publish <gba> (the VFS takes it) under <name>, <max> bytes at most may
+ * be written in it (0 for no limit). Writes beyond fail with SQLITE_FULL. */
+void memvfs_publish(const gchar *name, GByteArray *gba, gsize max);
+
+/* Publish a read-only view on <data>, that must stay valid until the name
+ * is removed. */
+void memvfs_publish_static(const gchar *name, const guint8 *data, gsize len);
+
+/* Unpublish <name> and return its buffer (or NULL if unknown or static).
+ * No SQLite handle may still use it. */
+GByteArray* memvfs_steal(const gchar *name);
+
+/* Unpublish <name> and drop its buffer */
+void memvfs_remove(const gchar *name);
+
+#endif /*OIO_SDS__sqliterepo__memvfs_h*/
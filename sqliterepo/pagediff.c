@@ -0,0 +1,322 @@
+/*
+OpenIO SDS sqliterepo
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <metautils/lib/metautils.h>
+
+#include "pagediff.h"
+
+#define PAGESUMS_MAGIC 0x53514C53 /* "SQLS" */
+#define PAGEDIFF_MAGIC 0x53514C44 /* "SQLD" */
+
+/* magic, page size, page count, pages per range */
+#define PAGEDIFF_HEADER_SIZE 16
+
+/* MD5 digest */
+#define PAGESUM_SIZE 16
+
+/* Offset of the page size in the header of a SQLite file */
+#define SQLITE_HEADER_PAGESIZE 16
+
+struct pagediff_geometry_s
+{
+	guint32 page_size;
+	guint32 page_count;
+	guint32 pages_per_range;
+};
+
+static void
+_append_u32(GByteArray *gba, guint32 u)
+{
+	u = g_htonl(u);
+	g_byte_array_append(gba, (guint8*)&u, sizeof(u));
+}
+
+static guint32
+_read_u32(const guint8 *p)
+{
+	guint32 u;
+	memcpy(&u, p, sizeof(u));
+	return g_ntohl(u);
+}
+
+static GError*
+_pread_full(int fd, guint8 *buf, gsize len, guint64 offset)
+{
+	for (gsize total = 0; total < len ;) {
+		ssize_t r = pread(fd, buf + total, len - total, offset + total);
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			return NEWERROR(errno, "read error: %s", strerror(errno));
+		}
+		if (r == 0)
+			return NEWERROR(CODE_INTERNAL_ERROR, "short read at %"G_GUINT64_FORMAT,
+					offset + total);
+		total += r;
+	}
+	return NULL;
+}
+
+static GError*
+_pwrite_full(int fd, const guint8 *buf, gsize len, guint64 offset)
+{
+	for (gsize total = 0; total < len ;) {
+		ssize_t w = pwrite(fd, buf + total, len - total, offset + total);
+		if (w < 0) {
+			if (errno == EINTR)
+				continue;
+			return NEWERROR(errno, "write error: %s", strerror(errno));
+		}
+		total += w;
+	}
+	return NULL;
+}
+
+static GError*
+_load_geometry(int fd, struct pagediff_geometry_s *geo)
+{
+	struct stat st;
+	guint8 hdr[2];
+	GError *err;
+
+	if (0 > fstat(fd, &st))
+		return NEWERROR(errno, "stat error: %s", strerror(errno));
+	if (st.st_size < 100)
+		return NEWERROR(CODE_PIPEFROM, "Not a SQLite base");
+	if (NULL != (err = _pread_full(fd, hdr, 2, SQLITE_HEADER_PAGESIZE)))
+		return err;
+
+	guint32 page_size = (((guint32)hdr[0]) << 8) | hdr[1];
+	if (page_size == 1)
+		page_size = 65536;
+	if (page_size < 512 || (page_size & (page_size - 1)))
+		return NEWERROR(CODE_PIPEFROM, "Invalid page size %u", page_size);
+
+	geo->page_size = page_size;
+	geo->page_count = st.st_size / page_size;
+	return NULL;
+}
+
+static void
+_append_geometry(GByteArray *gba, guint32 magic,
+		const struct pagediff_geometry_s *geo)
+{
+	_append_u32(gba, magic);
+	_append_u32(gba, geo->page_size);
+	_append_u32(gba, geo->page_count);
+	_append_u32(gba, geo->pages_per_range);
+}
+
+static GError*
+_parse_geometry(const guint8 *b, gsize len, guint32 magic,
+		struct pagediff_geometry_s *geo)
+{
+	if (!b || len < PAGEDIFF_HEADER_SIZE)
+		return BADREQ("Truncated header");
+	if (_read_u32(b) != magic)
+		return BADREQ("Invalid magic");
+	geo->page_size = _read_u32(b + 4);
+	geo->page_count = _read_u32(b + 8);
+	geo->pages_per_range = _read_u32(b + 12);
+	if (!geo->page_size || !geo->pages_per_range)
+		return BADREQ("Invalid geometry");
+	return NULL;
+}
+
+static guint32
+_range_count(const struct pagediff_geometry_s *geo)
+{
+	return (geo->page_count / geo->pages_per_range)
+		+ ((geo->page_count % geo->pages_per_range) ? 1 : 0);
+}
+
+static guint32
+_range_pages(const struct pagediff_geometry_s *geo, guint32 r)
+{
+	return MIN(geo->pages_per_range,
+			geo->page_count - r * geo->pages_per_range);
+}
+
+static guint64
+_range_offset(const struct pagediff_geometry_s *geo, guint32 r)
+{
+	return ((guint64)r) * geo->pages_per_range * geo->page_size;
+}
+
+static void
+_range_sum(GChecksum *cs, const guint8 *data, gsize len, guint8 *out)
+{
+	gsize l = PAGESUM_SIZE;
+	g_checksum_reset(cs);
+	g_checksum_update(cs, data, len);
+	g_checksum_get_digest(cs, out, &l);
+}
+
+GError*
+pagesums_compute(int fd, guint32 pages_per_range, GByteArray **out)
+{
+	struct pagediff_geometry_s geo = {0};
+	GError *err = NULL;
+
+	EXTRA_ASSERT(out != NULL);
+	EXTRA_ASSERT(pages_per_range > 0);
+
+	if (NULL != (err = _load_geometry(fd, &geo)))
+		return err;
+	geo.pages_per_range = pages_per_range;
+
+	const guint32 nb = _range_count(&geo);
+	GByteArray *gba = g_byte_array_sized_new(
+			PAGEDIFF_HEADER_SIZE + nb * PAGESUM_SIZE);
+	_append_geometry(gba, PAGESUMS_MAGIC, &geo);
+
+	GChecksum *cs = g_checksum_new(G_CHECKSUM_MD5);
+	guint8 *buf = g_malloc(geo.page_size * pages_per_range);
+	for (guint32 r = 0; !err && r < nb ;++r) {
+		const gsize len = ((gsize)_range_pages(&geo, r)) * geo.page_size;
+		if (!(err = _pread_full(fd, buf, len, _range_offset(&geo, r)))) {
+			guint8 sum[PAGESUM_SIZE];
+			_range_sum(cs, buf, len, sum);
+			g_byte_array_append(gba, sum, PAGESUM_SIZE);
+		}
+	}
+	g_free(buf);
+	g_checksum_free(cs);
+
+	if (err) {
+		g_byte_array_free(gba, TRUE);
+		return err;
+	}
+	*out = gba;
+	return NULL;
+}
+
+GError*
+pagediff_compute(int fd, const guint8 *sums, gsize sums_len,
+		gsize block_size, guint max_ratio, pagediff_cb cb, gpointer arg)
+{
+	struct pagediff_geometry_s remote = {0}, local = {0};
+	GError *err = NULL;
+
+	EXTRA_ASSERT(cb != NULL);
+
+	if (NULL != (err = _parse_geometry(sums, sums_len, PAGESUMS_MAGIC, &remote)))
+		return err;
+	const guint32 nb_remote = _range_count(&remote);
+	if (sums_len != PAGEDIFF_HEADER_SIZE + ((gsize)nb_remote) * PAGESUM_SIZE)
+		return BADREQ("Malformed checksums");
+
+	if (NULL != (err = _load_geometry(fd, &local)))
+		return err;
+	if (local.page_size != remote.page_size)
+		return NEWERROR(CODE_PIPEFROM, "Page size mismatch (%u vs. %u)",
+				local.page_size, remote.page_size);
+	local.pages_per_range = remote.pages_per_range;
+
+	/* First pass: spot the ranges that differ */
+	const guint32 nb_local = _range_count(&local);
+	GArray *differ = g_array_new(FALSE, FALSE, sizeof(guint32));
+	GChecksum *cs = g_checksum_new(G_CHECKSUM_MD5);
+	guint8 *buf = g_malloc(local.page_size * local.pages_per_range);
+	guint64 total = 0;
+	for (guint32 r = 0; !err && r < nb_local ;++r) {
+		const gsize len = ((gsize)_range_pages(&local, r)) * local.page_size;
+		if (!(err = _pread_full(fd, buf, len, _range_offset(&local, r)))) {
+			guint8 sum[PAGESUM_SIZE];
+			_range_sum(cs, buf, len, sum);
+			if (r >= nb_remote || memcmp(sum,
+						sums + PAGEDIFF_HEADER_SIZE + r * PAGESUM_SIZE,
+						PAGESUM_SIZE)) {
+				g_array_append_val(differ, r);
+				total += len;
+			}
+		}
+	}
+	g_free(buf);
+	g_checksum_free(cs);
+
+	const guint64 whole = ((guint64)local.page_count) * local.page_size;
+	if (!err && total * 100 > whole * max_ratio)
+		err = NEWERROR(CODE_PIPEFROM, "Diff too large (%"G_GUINT64_FORMAT
+				"/%"G_GUINT64_FORMAT")", total, whole);
+
+	/* Second pass: send the differing ranges, in blocks. The last block is
+	 * always sent, even empty, so that the peer learns the page count. */
+	GByteArray *block = NULL;
+	guint64 sent = 0;
+	for (guint i = 0; !err && i <= differ->len ;++i) {
+		if (!block) {
+			block = g_byte_array_sized_new(block_size + PAGEDIFF_HEADER_SIZE);
+			_append_geometry(block, PAGEDIFF_MAGIC, &local);
+		}
+		if (i < differ->len) {
+			const guint32 r = g_array_index(differ, guint32, i);
+			const guint32 pages = _range_pages(&local, r);
+			const gsize len = ((gsize)pages) * local.page_size;
+			_append_u32(block, r * local.pages_per_range);
+			_append_u32(block, pages);
+			const guint off = block->len;
+			g_byte_array_set_size(block, off + len);
+			if (NULL != (err = _pread_full(fd, block->data + off, len,
+							_range_offset(&local, r))))
+				break;
+			sent += len;
+		}
+		if (block->len >= block_size || i == differ->len) {
+			err = cb(block, total - sent, arg);
+			block = NULL;
+		}
+	}
+	if (block)
+		g_byte_array_free(block, TRUE);
+	g_array_free(differ, TRUE);
+	return err;
+}
+
+GError*
+pagediff_apply(int fd, const guint8 *block, gsize block_len)
+{
+	struct pagediff_geometry_s geo = {0};
+	GError *err = NULL;
+
+	if (NULL != (err = _parse_geometry(block, block_len, PAGEDIFF_MAGIC, &geo)))
+		return err;
+
+	const guint8 *p = block + PAGEDIFF_HEADER_SIZE, *end = block + block_len;
+	while (!err && p < end) {
+		if (end - p < 8)
+			return BADREQ("Truncated diff");
+		const guint32 first = _read_u32(p), count = _read_u32(p + 4);
+		const gsize len = ((gsize)count) * geo.page_size;
+		p += 8;
+		if (((guint64)first) + count > geo.page_count || (gsize)(end - p) < len)
+			return BADREQ("Malformed diff");
+		err = _pwrite_full(fd, p, len, ((guint64)first) * geo.page_size);
+		p += len;
+	}
+
+	if (!err && 0 > ftruncate(fd, ((off_t)geo.page_count) * geo.page_size))
+		err = NEWERROR(errno, "truncate error: %s", strerror(errno));
+	return err;
+}
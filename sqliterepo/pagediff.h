@@ -0,0 +1,53 @@
+/*
+OpenIO SDS sqliterepo
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#ifndef OIO_SDS__sqliterepo__pagediff_h
+# define OIO_SDS__sqliterepo__pagediff_h 1
+
+#include <glib.h>
+
+/* Page-level differences between two dumps of the same base.
+ *
+ * The slave computes a checksum for each range of pages of its local dump
+ * (pagesums_compute()), the master compares them with its own dump and only
+ * sends the ranges that differ (pagediff_compute()), then the slave patches
+ * its local dump with them (pagediff_apply()). Every block of diff carries
+ * the geometry of the master's dump, so that each block may be applied on
+ * its own, in any order. */
+
+/* Called with each block of diff, the block must be freed by the callee. */
+typedef GError* (*pagediff_cb) (GByteArray *block, gint64 remaining,
+		gpointer arg);
+
+/* Checksum each range of <pages_per_range> pages of the SQLite file open
+ * at <fd>. */
+GError* pagesums_compute(int fd, guint32 pages_per_range, GByteArray **out);
+
+/* Compare the SQLite file open at <fd> with the remote checksums, and send
+ * the differing ranges to <cb>, in blocks of about <block_size> bytes.
+ * Fails with CODE_PIPEFROM when the diff would weight more than
+ * <max_ratio> percents of the whole file, or when the geometries do not
+ * match, so that the caller may fall back to a full dump. */
+GError* pagediff_compute(int fd, const guint8 *sums, gsize sums_len,
+		gsize block_size, guint max_ratio, pagediff_cb cb, gpointer arg);
+
+/* Patch the SQLite file open at <fd> with one block of diff, and truncate
+ * it to the page count of the origin. */
+GError* pagediff_apply(int fd, const guint8 *block, gsize block_len);
+
+#endif /*OIO_SDS__sqliterepo__pagediff_h*/
@@ -260,10 +260,12 @@ context_pending_to_rowset(sqlite3 *db, struct sqlx_repctx_s *ctx)
 			GRID_TRACE2("%s(%s,%"G_GINT64_FORMAT",%d)", __FUNCTION__,
 					hashstr_str(name), rowid, deleted);
 
+			/* The row is reloaded even when a delete has been seen: the
+			 * delete might have been rolled back to a savepoint. A row that
+			 * isn't found is sent without fields, i.e. as a delete. */
 			struct Row *row = calloc(1, sizeof(*row));
 			asn_int64_to_INTEGER(&(row->rowid), rowid);
-			if (!deleted)
-				load_table_row(db, name, rowid, row, table);
+			load_table_row(db, name, rowid, row, table);
 
 			asn_sequence_add(&(table->rows.list), row);
 			return FALSE;
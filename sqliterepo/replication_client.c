@@ -37,6 +37,7 @@ License along with this library.
 
 #include "sqliterepo.h"
 #include "sqlx_remote.h"
+#include "sqlx_compress.h"
 #include "internals.h"
 
 static GByteArray*
@@ -101,12 +102,11 @@ peers_restore(gchar **targets, struct sqlx_name_s *name,
 	}
 }
 
-GError *
-peer_dump(const gchar *target, struct sqlx_name_s *name, gboolean chunked,
+static GError *
+_peer_dump(const gchar *target, GByteArray *encoded,
 		peer_dump_cb callback, gpointer cb_arg)
 {
 	struct gridd_client_s *client;
-	GByteArray *encoded;
 	GError *err = NULL;
 
 	gboolean on_reply(gpointer ctx, MESSAGE reply) {
@@ -120,9 +120,24 @@ peer_dump(const gchar *target, struct sqlx_name_s *name, gboolean chunked,
 
 		void *b = metautils_message_get_BODY(reply, &bsize);
 		if (b && bsize) {
-			GByteArray *dump = g_byte_array_new();
-			g_byte_array_append(dump, b, bsize);
-			err2 = callback(dump, remaining, cb_arg);
+			GByteArray *dump = NULL;
+			gchar encoding[32] = {0};
+			err2 = metautils_message_extract_string(reply, NAME_MSGKEY_ENCODING,
+					encoding, sizeof(encoding));
+			g_clear_error(&err2);
+			if (!strcmp(encoding, SQLX_ENCODING_ZLIB)) {
+				err2 = sqlx_compress_decode(b, bsize, &dump);
+			} else if (*encoding) {
+				err2 = NEWERROR(CODE_NOT_IMPLEMENTED,
+						"Unexpected encoding [%s]", encoding);
+			} else {
+				dump = g_byte_array_new();
+				g_byte_array_append(dump, b, bsize);
+			}
+			if (!err2) {
+				sqlx_wire_count_in(dump->len, bsize);
+				err2 = callback(dump, remaining, cb_arg);
+			}
 		}
 		if (err2 != NULL) {
 			GRID_ERROR("Failed to use result of dump: (%d) %s",
@@ -133,13 +148,6 @@ peer_dump(const gchar *target, struct sqlx_name_s *name, gboolean chunked,
 		return TRUE;
 	}
 
-	GRID_TRACE2("%s(%s,%p,%d,%p,%p)", __FUNCTION__, target, name, chunked,
-			callback, cb_arg);
-
-	if (!target)
-		return NEWERROR(CODE_INTERNAL_ERROR, "No target URL");
-
-	encoded = sqlx_pack_DUMP(name, chunked);
 	client = gridd_client_create(target, encoded, NULL, on_reply);
 	g_byte_array_unref(encoded);
 
@@ -158,6 +166,33 @@ peer_dump(const gchar *target, struct sqlx_name_s *name, gboolean chunked,
 	return err;
 }
 
+GError *
+peer_dump(const gchar *target, struct sqlx_name_s *name, gboolean chunked,
+		peer_dump_cb callback, gpointer cb_arg)
+{
+	GRID_TRACE2("%s(%s,%p,%d,%p,%p)", __FUNCTION__, target, name, chunked,
+			callback, cb_arg);
+
+	if (!target)
+		return NEWERROR(CODE_INTERNAL_ERROR, "No target URL");
+
+	return _peer_dump(target, sqlx_pack_DUMP(name, chunked), callback, cb_arg);
+}
+
+GError *
+peer_dump_diff(const gchar *target, struct sqlx_name_s *name,
+		GByteArray *sums, peer_dump_cb callback, gpointer cb_arg)
+{
+	GRID_TRACE2("%s(%s,%p,%p,%p,%p)", __FUNCTION__, target, name, sums,
+			callback, cb_arg);
+
+	if (!target)
+		return NEWERROR(CODE_INTERNAL_ERROR, "No target URL");
+
+	return _peer_dump(target, sqlx_pack_DIFF(name, sums->data, sums->len),
+			callback, cb_arg);
+}
+
 GError *
 peer_dump_gba(const gchar *target, struct sqlx_name_s *name, GByteArray **result)
 {
@@ -44,9 +44,11 @@ License along with this library.
 #include "sqlx_macros.h"
 #include "sqlx_remote.h"
 #include "sqlx_remote_ex.h"
+#include "sqlx_compress.h"
 #include "replication_dispatcher.h"
 #include "internals.h"
 #include "restoration.h"
+#include "pagediff.h"
 
 #define EXTRACT_STRING(Name,Dst) do { \
 	err = metautils_message_extract_string(reply->request, Name, Dst, sizeof(Dst)); \
@@ -492,6 +494,77 @@ _dump_chunked(struct sqlx_repository_s *repo, struct sqlx_name_s *name,
 	return err;
 }
 
+static GError *
+_dump_diff(struct sqlx_repository_s *repo, struct sqlx_name_s *name,
+		const guint8 *sums, gsize sums_len,
+		void (*_send_chunk)(GByteArray *chunk, gint64 remaining))
+{
+	struct sqlx_sqlite3_s *sq3 = NULL;
+
+	GRID_TRACE2("%s(%p,%s,%s,%p)", __FUNCTION__,
+			repo, name->base, name->type, _send_chunk);
+
+	GError *err = sqlx_repository_open_and_lock(repo, name,
+			SQLX_OPEN_LOCAL|SQLX_OPEN_NOREFCHECK, &sq3, NULL);
+	if (NULL != err)
+		return err;
+
+	GError *_dump_diff_cb(GByteArray *gba, gint64 remaining, gpointer arg) {
+		(void) arg;
+		_send_chunk(gba, remaining);
+		return NULL;
+	}
+
+	err = sqlx_repository_dump_base_diff(sq3, sums, sums_len,
+			SQLX_DUMP_CHUNK_SIZE, _dump_diff_cb, NULL);
+
+	sqlx_repository_unlock_and_close_noerror(sq3);
+	return err;
+}
+
+/* Dumps the local base into the restoration context, then asks the source
+ * for the pages that differ and patches the dump with them. */
+static GError *
+_pipe_from_diff(const gchar *source, struct sqlx_repository_s *repo,
+		struct sqlx_name_s *name, struct restore_ctx_s *ctx)
+{
+	GError *err;
+	GByteArray *sums = NULL;
+	struct sqlx_sqlite3_s *sq3 = NULL;
+	guint64 received = 0;
+
+	err = sqlx_repository_open_and_lock(repo, name,
+			SQLX_OPEN_LOCAL|SQLX_OPEN_NOREFCHECK, &sq3, NULL);
+	if (NULL != err)
+		return err;
+	err = sqlx_repository_dump_base_path(sq3, ctx->path);
+	sqlx_repository_unlock_and_close_noerror(sq3);
+	if (NULL != err)
+		return err;
+
+	if (NULL != (err = pagesums_compute(ctx->fd,
+					SQLX_DIFF_PAGES_PER_RANGE, &sums)))
+		return err;
+
+	GError *_pipe_from_diff_cb(GByteArray *part, gint64 remaining, gpointer arg) {
+		(void) arg;
+		GRID_DEBUG("PIPEFROM received diff block of %u bytes, %"
+				G_GINT64_FORMAT" bytes remaining", part->len, remaining);
+		received += part->len;
+		GError *err2 = pagediff_apply(ctx->fd, part->data, part->len);
+		metautils_gba_unref(part);
+		return err2;
+	}
+
+	err = peer_dump_diff(source, name, sums, _pipe_from_diff_cb, NULL);
+	if (!err)
+		GRID_INFO("PIPEFROM [%s][%s] incremental: %u bytes sent, %"
+				G_GUINT64_FORMAT" bytes received",
+				name->base, name->type, sums->len, received);
+	g_byte_array_free(sums, TRUE);
+	return err;
+}
+
 static GError *
 _pipe_from(const gchar *source, struct sqlx_repository_s *repo,
 		struct sqlx_name_s *name)
@@ -509,19 +582,52 @@ _pipe_from(const gchar *source, struct sqlx_repository_s *repo,
 	if (err != NULL)
 		goto end;
 
+	/* First try to only transfer the pages that differ, then fall back
+	 * to a full dump (e.g. no local base, or the source is too old) */
+	if (!(err = _pipe_from_diff(source, repo, name, ctx))) {
+		err = _restore2(repo, name, ctx->path);
+		goto end;
+	}
+	GRID_INFO("PIPEFROM [%s][%s] incremental failed, full dump: (%d) %s",
+			name->base, name->type, err->code, err->message);
+	g_clear_error(&err);
+	restore_ctx_clear(&ctx);
+
+	/* The full dump is kept in memory, and only spilled into a temporary
+	 * file when it exceeds oio_sqlx_dump_max_memory */
+	GByteArray *whole = g_byte_array_new();
+
 	GError *_pipe_from_cb(GByteArray *part, gint64 remaining, gpointer arg) {
 		(void) arg;
 		GError *err2 = NULL;
 		GRID_DEBUG("PIPEFROM received block of %u bytes, %"
 				G_GINT64_FORMAT" bytes remaining", part->len, remaining);
-		err2 = restore_ctx_append(ctx, part->data, part->len);
+		if (!ctx && whole->len + part->len + MAX(remaining, 0)
+				> oio_sqlx_dump_max_memory) {
+			if (!(err2 = restore_ctx_create(path, &ctx)))
+				err2 = restore_ctx_append(ctx, whole->data, whole->len);
+			g_byte_array_set_size(whole, 0);
+		}
+		if (!err2) {
+			if (ctx)
+				err2 = restore_ctx_append(ctx, part->data, part->len);
+			else
+				g_byte_array_append(whole, part->data, part->len);
+		}
 		metautils_gba_unref(part);
 		return err2;
 	}
 
 	err = peer_dump(source, name, TRUE, _pipe_from_cb, NULL);
-	if (!err)
-		err = _restore2(repo, name, ctx->path);
+	if (!err) {
+		if (ctx)
+			err = _restore2(repo, name, ctx->path);
+		else if (whole->len > 0)
+			err = _restore(repo, name, whole->data, whole->len);
+		else
+			err = NEWERROR(CODE_PIPEFROM, "Empty dump");
+	}
+	g_byte_array_free(whole, TRUE);
 
 end:
 	restore_ctx_clear(&ctx);
@@ -1389,6 +1495,72 @@ _handler_GETVERS(struct gridd_reply_ctx_s *reply,
 	return TRUE;
 }
 
+/* Get the body of the request, decoded if the peer encoded it. <holder>
+ * keeps the decoded body and must be freed by the caller. */
+static GError *
+_extract_body(struct gridd_reply_ctx_s *reply, GByteArray **holder,
+		guint8 **pbody, gsize *pbody_size)
+{
+	gsize bsize = 0;
+	guint8 *b = metautils_message_get_BODY(reply->request, &bsize);
+	*holder = NULL;
+	*pbody = b;
+	*pbody_size = bsize;
+	if (!b)
+		return NULL;
+
+	gchar encoding[32] = {0};
+	GError *err = metautils_message_extract_string(reply->request,
+			NAME_MSGKEY_ENCODING, encoding, sizeof(encoding));
+	if (err) {
+		g_clear_error(&err);
+		sqlx_wire_count_in(bsize, bsize);
+		return NULL;
+	}
+	if (strcmp(encoding, SQLX_ENCODING_ZLIB))
+		return NEWERROR(CODE_NOT_IMPLEMENTED, "Unexpected encoding [%s]",
+				encoding);
+
+	if (NULL != (err = sqlx_compress_decode(b, bsize, holder)))
+		return err;
+	sqlx_wire_count_in((*holder)->len, bsize);
+	*pbody = (*holder)->data;
+	*pbody_size = (*holder)->len;
+	return NULL;
+}
+
+static gboolean
+_accepts_encoding(struct gridd_reply_ctx_s *reply)
+{
+	gchar encoding[32] = {0};
+	GError *err = metautils_message_extract_string(reply->request,
+			NAME_MSGKEY_ACCEPT_ENCODING, encoding, sizeof(encoding));
+	if (err) {
+		g_clear_error(&err);
+		return FALSE;
+	}
+	return !strcmp(encoding, SQLX_ENCODING_ZLIB);
+}
+
+/* Add <part> (that it takes) as the body of the next reply, encoded if the
+ * peer accepts it */
+static void
+_add_body_encoded(struct gridd_reply_ctx_s *reply, GByteArray *part,
+		gboolean encode)
+{
+	if (!encode) {
+		sqlx_wire_count_out(part->len, part->len);
+		reply->add_body(part);
+		return;
+	}
+
+	GByteArray *encoded = sqlx_compress_encode(part->data, part->len);
+	sqlx_wire_count_out(part->len, encoded->len);
+	g_byte_array_unref(part);
+	reply->add_body(encoded);
+	reply->add_header(NAME_MSGKEY_ENCODING, metautils_gba_from_string(SQLX_ENCODING_ZLIB));
+}
+
 static gboolean
 _handler_REPLICATE(struct gridd_reply_ctx_s *reply,
 		struct sqlx_repository_s *repo, gpointer ignored)
@@ -1405,7 +1577,12 @@ _handler_REPLICATE(struct gridd_reply_ctx_s *reply,
 	SQLXNAME_STACKIFY(name);
 
 	gsize bsize = 0;
-	void *b = metautils_message_get_BODY(reply->request, &bsize);
+	guint8 *b = NULL;
+	GByteArray *decoded = NULL;
+	if (NULL != (err = _extract_body(reply, &decoded, &b, &bsize))) {
+		reply->send_error(0, err);
+		return TRUE;
+	}
 	if (!b) {
 		reply->send_error(CODE_BAD_REQUEST, NEWERROR(CODE_BAD_REQUEST, "missing body"));
 		return TRUE;
@@ -1419,6 +1596,7 @@ _handler_REPLICATE(struct gridd_reply_ctx_s *reply,
 	err = sqlx_repository_use_base(repo, CONST(&name));
 	if (NULL != err) {
 		reply->send_error(0, err);
+		metautils_gba_unref(decoded);
 		return TRUE;
 	}
 
@@ -1426,6 +1604,7 @@ _handler_REPLICATE(struct gridd_reply_ctx_s *reply,
 			SQLX_OPEN_LOCAL|SQLX_OPEN_CREATE, &sq3, NULL);
 	if (NULL != err) {
 		reply->send_error(0, err);
+		metautils_gba_unref(decoded);
 		return TRUE;
 	}
 
@@ -1437,6 +1616,7 @@ _handler_REPLICATE(struct gridd_reply_ctx_s *reply,
 		reply->send_reply(CODE_FINAL_OK, "OK");
 
 	sqlx_repository_unlock_and_close_noerror(sq3);
+	metautils_gba_unref(decoded);
 
 	return TRUE;
 }
@@ -1636,6 +1816,7 @@ _handler_DUMP(struct gridd_reply_ctx_s *reply,
 		return TRUE;
 	}
 	SQLXNAME_STACKIFY(name);
+	const gboolean encode = _accepts_encoding(reply);
 
 	void _send_part(GByteArray *part, gint64 remaining)
 	{
@@ -1644,7 +1825,7 @@ _handler_DUMP(struct gridd_reply_ctx_s *reply,
 		GRID_DEBUG("DUMP sending block of %u bytes, %"
 				G_GINT64_FORMAT" bytes remaining",
 				part->len, remaining);
-		reply->add_body(part);
+		_add_body_encoded(reply, part, encode);
 		reply->add_header("remaining", metautils_gba_from_string(tmp));
 		reply->send_reply(CODE_PARTIAL_CONTENT, "Partial content");
 	}
@@ -1656,7 +1837,7 @@ _handler_DUMP(struct gridd_reply_ctx_s *reply,
 		/* Open and lock the base */
 		err = _dump(repo, CONST(&name), &dump);
 		if (!err) {
-			reply->add_body(dump);
+			_add_body_encoded(reply, dump, encode);
 		}
 	}
 
@@ -1669,6 +1850,51 @@ _handler_DUMP(struct gridd_reply_ctx_s *reply,
 	return TRUE;
 }
 
+static gboolean
+_handler_DIFF(struct gridd_reply_ctx_s *reply,
+		struct sqlx_repository_s *repo, gpointer ignored)
+{
+	GError *err = NULL;
+	struct sqlx_name_mutable_s name = {0};
+
+	(void) ignored;
+	if (NULL != (err = _load_sqlx_name(reply, &name, NULL))) {
+		reply->send_error(0, err);
+		return TRUE;
+	}
+	SQLXNAME_STACKIFY(name);
+
+	/* The body holds the checksums of the pages of the peer */
+	gsize sums_size = 0;
+	guint8 *sums = metautils_message_get_BODY(reply->request, &sums_size);
+	if (!sums) {
+		reply->send_error(0, NEWERROR(CODE_BAD_REQUEST, "Missing body"));
+		return TRUE;
+	}
+	const gboolean encode = _accepts_encoding(reply);
+
+	void _send_part(GByteArray *part, gint64 remaining)
+	{
+		gchar tmp[32] = {0};
+		g_snprintf(tmp, 32, "%"G_GINT64_FORMAT, remaining);
+		GRID_DEBUG("DIFF sending block of %u bytes, %"
+				G_GINT64_FORMAT" bytes remaining",
+				part->len, remaining);
+		_add_body_encoded(reply, part, encode);
+		reply->add_header("remaining", metautils_gba_from_string(tmp));
+		reply->send_reply(CODE_PARTIAL_CONTENT, "Partial content");
+	}
+
+	err = _dump_diff(repo, CONST(&name), sums, sums_size, _send_part);
+	if (NULL != err) {
+		reply->send_error(0, err);
+	} else {
+		reply->add_header("format", metautils_gba_from_string("sqlite3-diff"));
+		reply->send_reply(CODE_FINAL_OK, "OK");
+	}
+	return TRUE;
+}
+
 static gboolean
 _handler_RESTORE(struct gridd_reply_ctx_s *reply,
 		struct sqlx_repository_s *repo, gpointer ignored)
@@ -1685,13 +1911,19 @@ _handler_RESTORE(struct gridd_reply_ctx_s *reply,
 
 	/* The body is the raw base */
 	gsize dump_size = 0;
-	guint8 *dump = metautils_message_get_BODY(reply->request, &dump_size);
+	guint8 *dump = NULL;
+	GByteArray *decoded = NULL;
+	if (NULL != (err = _extract_body(reply, &decoded, &dump, &dump_size))) {
+		reply->send_error(0, err);
+		return TRUE;
+	}
 	if (!dump) {
 		reply->send_error(0, NEWERROR(CODE_BAD_REQUEST, "Missing body"));
 		return TRUE;
 	}
 	if (dump_size < 1024) {
 		reply->send_error(0, NEWERROR(CODE_BAD_REQUEST, "Body too short"));
+		metautils_gba_unref(decoded);
 		return TRUE;
 	}
 
@@ -1701,6 +1933,7 @@ _handler_RESTORE(struct gridd_reply_ctx_s *reply,
 	else
 		reply->send_reply(CODE_FINAL_OK, "OK");
 
+	metautils_gba_unref(decoded);
 	return TRUE;
 }
 
@@ -2261,6 +2494,15 @@ _info_cache(struct sqlx_repository_s *repo, GString *gstr)
 	g_string_append_printf(gstr, "\thot: %u\n", count.hot);
 	g_string_append_printf(gstr, "\tcold: %u\n", count.cold);
 	g_string_append_printf(gstr, "\tused: %u\n", count.used);
+	g_string_append_printf(gstr, "\tmem_max: %"G_GINT64_FORMAT"\n", count.mem_max);
+	g_string_append_printf(gstr, "\tmem_used: %"G_GINT64_FORMAT"\n", count.mem_used);
+	g_string_append_printf(gstr, "\thits: %"G_GUINT64_FORMAT"\n", count.hits);
+	g_string_append_printf(gstr, "\tmisses: %"G_GUINT64_FORMAT"\n", count.misses);
+	g_string_append_printf(gstr, "\tevicted.idle: %"G_GUINT64_FORMAT"\n", count.evicted.idle);
+	g_string_append_printf(gstr, "\tevicted.pressure: %"G_GUINT64_FORMAT"\n", count.evicted.pressure);
+	g_string_append_printf(gstr, "\tevicted.memory: %"G_GUINT64_FORMAT"\n", count.evicted.memory);
+	g_string_append_printf(gstr, "\tevicted.rejected: %"G_GUINT64_FORMAT"\n", count.evicted.rejected);
+	g_string_append_printf(gstr, "\tevicted.forced: %"G_GUINT64_FORMAT"\n", count.evicted.forced);
 }
 
 static gboolean
@@ -2431,6 +2673,7 @@ sqlx_repli_gridd_get_requests(void)
 		{NAME_MSGNAME_SQLX_PIPETO,       (hook) _handler_PIPETO,    NULL},
 		{NAME_MSGNAME_SQLX_PIPEFROM,     (hook) _handler_PIPEFROM,  NULL},
 		{NAME_MSGNAME_SQLX_DUMP,         (hook) _handler_DUMP,      NULL},
+		{NAME_MSGNAME_SQLX_DIFF,         (hook) _handler_DIFF,      NULL},
 		{NAME_MSGNAME_SQLX_RESTORE,      (hook) _handler_RESTORE,   NULL},
 		{NAME_MSGNAME_SQLX_REPLICATE,    (hook) _handler_REPLICATE, NULL},
 		{NAME_MSGNAME_SQLX_GETVERS,      (hook) _handler_GETVERS,   NULL},
@@ -38,8 +38,12 @@ License along with this library.
 #include "sqlite_utils.h"
 #include "internals.h"
 #include "restoration.h"
+#include "pagediff.h"
+#include "memvfs.h"
 #include "sqlx_remote.h"
 
+gint64 oio_sqlx_dump_max_memory = SQLX_DUMP_MEMORY_MAX;
+
 #define GSTR_APPEND_SEP(S) do { \
 	if ((S)->str[(S)->len-1]!=G_DIR_SEPARATOR) \
 			g_string_append_c((S), G_DIR_SEPARATOR); \
@@ -131,6 +135,18 @@ __delete_base(struct sqlx_sqlite3_s *sq3)
 	sq3->deleted = 0;
 }
 
+static gint64
+__base_memory(struct sqlx_sqlite3_s *sq3)
+{
+	int cur = 0, hi = 0;
+	if (!sq3 || !sq3->db)
+		return 0;
+	if (SQLITE_OK != sqlite3_db_status(sq3->db, SQLITE_DBSTATUS_CACHE_USED,
+				&cur, &hi, 0))
+		return 0;
+	return cur;
+}
+
 static void
 __close_base(struct sqlx_sqlite3_s *sq3)
 {
@@ -326,6 +342,8 @@ sqlx_repository_init(const gchar *vol, const struct sqlx_repo_config_s *cfg,
 		repo->cache = sqlx_cache_init();
 		sqlx_cache_set_close_hook(repo->cache,
 				(sqlx_cache_close_hook)__close_base);
+		sqlx_cache_set_size_hook(repo->cache,
+				(sqlx_cache_size_hook)__base_memory);
 	}
 
 	if (cfg) {
@@ -434,6 +452,17 @@ sqlx_repository_configure_type(sqlx_repository_t *repo,
 	return NULL;
 }
 
+void
+sqlx_repository_configure_max_memory(sqlx_repository_t *repo, gint64 max)
+{
+	struct sqlx_cache_s *cache = sqlx_repository_get_cache(repo);
+	if (cache) {
+		sqlx_cache_set_max_memory(cache, max);
+	} else {
+		GRID_INFO("Not setting the memory limit since there is no cache");
+	}
+}
+
 void
 sqlx_repository_configure_open_timeout(sqlx_repository_t *repo,
 		gint64 timeout)
@@ -1269,6 +1298,92 @@ _read_file(int fd, GByteArray *gba)
 	return err;
 }
 
+static GError*
+_backup_to_path(sqlite3 *src, const gchar *path)
+{
+	sqlite3 *dst = NULL;
+	GError *err = NULL;
+
+	int rc = sqlite3_open_v2(path, &dst, SQLITE_OPEN_PRIVATECACHE
+			|SQLITE_OPEN_CREATE|SQLITE_OPEN_READWRITE, NULL);
+	if (rc != SQLITE_OK) {
+		err = NEWERROR(rc,
+				"sqlite3_open error: (%s) (errno=%d) %s",
+				sqlite_strerror(rc), errno, strerror(errno));
+	} else {
+		err = _backup_main(src, dst);
+	}
+	_close_handle(&dst);
+	return err;
+}
+
+static void
+_memvfs_make_name(gchar *dst, gsize dstlen, const gchar *what)
+{
+	static gint counter = 0;
+	g_snprintf(dst, dstlen, "/sqlx-%s-%d-%d", what, getpid(),
+			g_atomic_int_add(&counter, 1));
+}
+
+static gint64
+_base_size(sqlite3 *db)
+{
+	gint64 page_size = 0, page_count = 0;
+	sqlite3_stmt *stmt = NULL;
+	int rc;
+
+	sqlite3_prepare_debug(rc, db, "PRAGMA page_size", -1, &stmt, NULL);
+	if (rc == SQLITE_OK && SQLITE_ROW == sqlite3_step(stmt))
+		page_size = sqlite3_column_int64(stmt, 0);
+	sqlite3_finalize_debug(rc, stmt);
+
+	sqlite3_prepare_debug(rc, db, "PRAGMA page_count", -1, &stmt, NULL);
+	if (rc == SQLITE_OK && SQLITE_ROW == sqlite3_step(stmt))
+		page_count = sqlite3_column_int64(stmt, 0);
+	sqlite3_finalize_debug(rc, stmt);
+
+	return page_size * page_count;
+}
+
+/* Dumps the base in a buffer of the memory VFS, without any disk I/O.
+ * Fails if the dump would exceed oio_sqlx_dump_max_memory. */
+static GError*
+_backup_to_memory(sqlite3 *src, GByteArray **out)
+{
+	gchar name[64];
+	sqlite3 *dst = NULL;
+	GError *err = NULL;
+
+	const gint64 size = _base_size(src);
+	if (size <= 0 || size > oio_sqlx_dump_max_memory)
+		return NEWERROR(CODE_UNAVAILABLE, "Base too large for a dump in"
+				" memory (%"G_GINT64_FORMAT" bytes)", size);
+
+	_memvfs_make_name(name, sizeof(name), "dump");
+	memvfs_publish(name, g_byte_array_sized_new(size),
+			oio_sqlx_dump_max_memory);
+
+	int rc = sqlite3_open_v2(name, &dst, SQLITE_OPEN_PRIVATECACHE
+			|SQLITE_OPEN_CREATE|SQLITE_OPEN_READWRITE, MEMVFS_NAME);
+	if (rc != SQLITE_OK) {
+		err = NEWERROR(rc, "sqlite3_open error: (%s)", sqlite_strerror(rc));
+	} else {
+		/* No journal: a failed dump is simply dropped */
+		(void) sqlx_exec(dst, "PRAGMA journal_mode = OFF");
+		err = _backup_main(src, dst);
+	}
+	_close_handle(&dst);
+
+	GByteArray *gba = memvfs_steal(name);
+	if (err) {
+		if (gba)
+			g_byte_array_free(gba, TRUE);
+		return err;
+	}
+	*out = gba;
+	return NULL;
+}
+
 GError*
 sqlx_repository_backup_base(struct sqlx_sqlite3_s *src_sq3,
 		struct sqlx_sqlite3_s *dst_sq3)
@@ -1284,8 +1399,7 @@ sqlx_repository_dump_base_fd(struct sqlx_sqlite3_s *sq3,
 {
 	gchar path[LIMIT_LENGTH_VOLUMENAME+32] = {0};
 	gboolean try_slash_tmp = FALSE;
-	int rc, fd;
-	sqlite3 *dst = NULL;
+	int fd;
 	GError *err = NULL;
 
 	GRID_TRACE2("%s(%p,%p,%p)", __FUNCTION__, sq3, read_file_cb, cb_arg);
@@ -1304,18 +1418,7 @@ sqlx_repository_dump_base_fd(struct sqlx_sqlite3_s *sq3,
 			GRID_TRACE("DUMP to [%s] fd=%d from bd=[%s][%s]", path, fd,
 					sq3->name.base, sq3->name.type);
 
-			/* TODO : provides a VFS dumping everything in memory */
-			rc = sqlite3_open_v2(path, &dst, SQLITE_OPEN_PRIVATECACHE
-					|SQLITE_OPEN_CREATE|SQLITE_OPEN_READWRITE, NULL);
-
-			if (rc != SQLITE_OK) {
-				err = NEWERROR(rc,
-						"sqlite3_open error: (%s) (errno=%d) %s",
-						sqlite_strerror(rc), errno, strerror(errno));
-			} else {
-				err = _backup_main(sq3->db, dst);
-			}
-			_close_handle(&dst);
+			err = _backup_to_path(sq3->db, path);
 			unlink(path);
 		}
 
@@ -1340,6 +1443,13 @@ sqlx_repository_dump_base_fd(struct sqlx_sqlite3_s *sq3,
 GError*
 sqlx_repository_dump_base_gba(struct sqlx_sqlite3_s *sq3, GByteArray **dump)
 {
+	GError *err = _backup_to_memory(sq3->db, dump);
+	if (!err)
+		return NULL;
+	GRID_DEBUG("DUMP [%s][%s] in memory failed, using a file: (%d) %s",
+			sq3->name.base, sq3->name.type, err->code, err->message);
+	g_clear_error(&err);
+
 	GError *_monolytic_dump_cb(int fd, gpointer arg)
 	{
 		GError *_err = NULL;
@@ -1380,12 +1490,54 @@ sqlx_repository_dump_base_chunked(struct sqlx_sqlite3_s *sq3,
 		} while (!err && bytes_read < st.st_size);
 		return err;
 	}
+
+	GByteArray *whole = NULL;
+	GError *err = _backup_to_memory(sq3->db, &whole);
+	if (!err) {
+		for (guint offset = 0; !err && offset < whole->len ;) {
+			const guint len = MIN((guint)chunk_size, whole->len - offset);
+			GByteArray *gba = g_byte_array_sized_new(len);
+			g_byte_array_append(gba, whole->data + offset, len);
+			offset += len;
+			err = callback(gba, whole->len - offset, callback_arg);
+		}
+		g_byte_array_free(whole, TRUE);
+		return err;
+	}
+	GRID_DEBUG("DUMP [%s][%s] in memory failed, using a file: (%d) %s",
+			sq3->name.base, sq3->name.type, err->code, err->message);
+	g_clear_error(&err);
+
 	return sqlx_repository_dump_base_fd(sq3, _chunked_dump_cb, NULL);
 }
 
 GError*
-sqlx_repository_restore_from_file(struct sqlx_sqlite3_s *sq3,
-		const gchar *path)
+sqlx_repository_dump_base_path(struct sqlx_sqlite3_s *sq3, const gchar *path)
+{
+	EXTRA_ASSERT(sq3 != NULL);
+	EXTRA_ASSERT(path != NULL);
+	GRID_TRACE("DUMP to [%s] from bd=[%s][%s]", path,
+			sq3->name.base, sq3->name.type);
+	return _backup_to_path(sq3->db, path);
+}
+
+GError*
+sqlx_repository_dump_base_diff(struct sqlx_sqlite3_s *sq3,
+		const guint8 *sums, gsize sums_len, gint chunk_size,
+		dump_base_chunked_cb callback, gpointer callback_arg)
+{
+	GError *_diff_dump_cb(int fd, gpointer arg)
+	{
+		(void) arg;
+		return pagediff_compute(fd, sums, sums_len, chunk_size,
+				SQLX_DIFF_MAX_RATIO, callback, callback_arg);
+	}
+	return sqlx_repository_dump_base_fd(sq3, _diff_dump_cb, NULL);
+}
+
+static GError*
+_restore_from_path(struct sqlx_sqlite3_s *sq3, const gchar *path,
+		const gchar *vfs)
 {
 	int rc;
 	sqlite3 *src = NULL;
@@ -1393,7 +1545,7 @@ sqlx_repository_restore_from_file(struct sqlx_sqlite3_s *sq3,
 
 	/* Tries to open the temporary file as a SQLite3 DB */
 	rc = sqlite3_open_v2(path, &src,
-			SQLITE_OPEN_READONLY, NULL);
+			SQLITE_OPEN_READONLY, vfs);
 	if (rc != SQLITE_OK && rc != SQLITE_DONE) {
 		_close_handle(&src);
 		err = NEWERROR(rc,
@@ -1409,6 +1561,24 @@ sqlx_repository_restore_from_file(struct sqlx_sqlite3_s *sq3,
 	return err;
 }
 
+GError*
+sqlx_repository_restore_from_file(struct sqlx_sqlite3_s *sq3,
+		const gchar *path)
+{
+	return _restore_from_path(sq3, path, NULL);
+}
+
+static GError*
+_restore_from_memory(struct sqlx_sqlite3_s *sq3, guint8 *raw, gsize rawsize)
+{
+	gchar name[64];
+	_memvfs_make_name(name, sizeof(name), "restore");
+	memvfs_publish_static(name, raw, rawsize);
+	GError *err = _restore_from_path(sq3, name, MEMVFS_NAME);
+	memvfs_remove(name);
+	return err;
+}
+
 GError*
 sqlx_repository_restore_base(struct sqlx_sqlite3_s *sq3, guint8 *raw, gsize rawsize)
 {
@@ -1423,6 +1593,15 @@ sqlx_repository_restore_base(struct sqlx_sqlite3_s *sq3, guint8 *raw, gsize raws
 	EXTRA_ASSERT(raw != NULL);
 	EXTRA_ASSERT(rawsize > 0);
 
+	/* The raw base is already in memory, no need to copy it on disk */
+	if (NULL != (err = _restore_from_memory(sq3, raw, rawsize))) {
+		GRID_WARN("RESTORE [%s][%s] from memory failed, using a file: (%d) %s",
+				sq3->name.base, sq3->name.type, err->code, err->message);
+		g_clear_error(&err);
+	} else {
+		return NULL;
+	}
+
 	do {
 		g_snprintf(path, sizeof(path), "%s/tmp/restore.sqlite3.XXXXXX",
 				try_slash_tmp? "" : sq3->repo->basedir);
@@ -195,6 +195,11 @@ GError* sqlx_repository_configure_type(sqlx_repository_t *repo,
 void sqlx_repository_configure_open_timeout(sqlx_repository_t *repo,
 		gint64 timeout);
 
+/* Limit the memory used by the idle bases kept open (mostly their page
+ * cache), in bytes. 0 for no limit. */
+void sqlx_repository_configure_max_memory(sqlx_repository_t *repo,
+		gint64 max);
+
 void sqlx_repository_configure_close_callback(sqlx_repository_t *repo,
 		sqlx_repo_close_hook cb, gpointer cb_data);
 
@@ -284,6 +289,18 @@ typedef GError*(*dump_base_chunked_cb)(GByteArray *gba, gint64 remaining_bytes,
 GError* sqlx_repository_dump_base_chunked(struct sqlx_sqlite3_s *sq3,
 		gint chunk_size, dump_base_chunked_cb callback, gpointer callback_arg);
 
+/** Dump the base (with only the meaningful pages) into the file at <path>,
+ *  that must exist and be empty. */
+GError* sqlx_repository_dump_base_path(struct sqlx_sqlite3_s *sq3,
+		const gchar *path);
+
+/** Open a dump of the base, compare it with the checksums of the pages of
+ *  a peer's dump (as computed by pagesums_compute()), and send to the
+ *  callback the blocks of pages that differ (see pagediff_apply()). */
+GError* sqlx_repository_dump_base_diff(struct sqlx_sqlite3_s *sq3,
+		const guint8 *sums, gsize sums_len, gint chunk_size,
+		dump_base_chunked_cb callback, gpointer callback_arg);
+
 /** Perform a SQLite backup on the sqlite handles underlying two sqliterepo
  * bases. */
 GError* sqlx_repository_backup_base(struct sqlx_sqlite3_s *src_sq3,
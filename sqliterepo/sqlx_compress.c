@@ -0,0 +1,169 @@
+/*
+OpenIO SDS sqliterepo
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <string.h>
+
+#include <zlib.h>
+
+#include <metautils/lib/metautils.h>
+
+#include "sqlx_compress.h"
+
+#define SQLX_COMPRESS_MAGIC 0x53514C5A /* "SQLZ" */
+
+/* method, raw length, wire length, CRC32 of the raw data */
+#define SQLX_BLOCK_HEADER 13
+
+#define SQLX_METHOD_STORED 0
+#define SQLX_METHOD_ZLIB   1
+
+gboolean oio_sqlx_wire_compression = FALSE;
+
+/* Only accessed with atomic operations, no lock on the replication path */
+static struct sqlx_wire_counts_s counts = {0};
+
+static void
+_write_u32(guint8 *p, guint32 u)
+{
+	u = g_htonl(u);
+	memcpy(p, &u, sizeof(u));
+}
+
+static guint32
+_read_u32(const guint8 *p)
+{
+	guint32 u;
+	memcpy(&u, p, sizeof(u));
+	return g_ntohl(u);
+}
+
+GByteArray*
+sqlx_compress_encode(const guint8 *raw, gsize len)
+{
+	EXTRA_ASSERT(raw != NULL || len == 0);
+
+	GByteArray *out = g_byte_array_sized_new(4 + SQLX_BLOCK_HEADER + len / 2);
+	g_byte_array_set_size(out, 4);
+	_write_u32(out->data, SQLX_COMPRESS_MAGIC);
+
+	for (gsize off = 0; off < len ;) {
+		const gsize rlen = MIN(SQLX_COMPRESS_BLOCK, len - off);
+		const guint hdr = out->len;
+		uLongf wlen = compressBound(rlen);
+		guint8 method = SQLX_METHOD_ZLIB;
+
+		g_byte_array_set_size(out, hdr + SQLX_BLOCK_HEADER + wlen);
+		guint8 *dst = out->data + hdr + SQLX_BLOCK_HEADER;
+		int rc = compress2(dst, &wlen, raw + off, rlen, Z_BEST_SPEED);
+		if (rc != Z_OK || wlen >= rlen) {
+			method = SQLX_METHOD_STORED;
+			wlen = rlen;
+			memcpy(dst, raw + off, rlen);
+		}
+
+		out->data[hdr] = method;
+		_write_u32(out->data + hdr + 1, rlen);
+		_write_u32(out->data + hdr + 5, wlen);
+		_write_u32(out->data + hdr + 9, crc32(0L, raw + off, rlen));
+		g_byte_array_set_size(out, hdr + SQLX_BLOCK_HEADER + wlen);
+		off += rlen;
+	}
+
+	return out;
+}
+
+GError*
+sqlx_compress_decode(const guint8 *wire, gsize len, GByteArray **out)
+{
+	EXTRA_ASSERT(out != NULL);
+
+	if (!wire || len < 4 || _read_u32(wire) != SQLX_COMPRESS_MAGIC)
+		return BADREQ("Invalid encoded payload");
+
+	GError *err = NULL;
+	GByteArray *raw = g_byte_array_sized_new(len * 2);
+	const guint8 *p = wire + 4, *end = wire + len;
+
+	while (!err && p < end) {
+		if (end - p < SQLX_BLOCK_HEADER) {
+			err = BADREQ("Truncated block header");
+			break;
+		}
+		const guint8 method = p[0];
+		const guint32 rlen = _read_u32(p + 1);
+		const guint32 wlen = _read_u32(p + 5);
+		const guint32 crc = _read_u32(p + 9);
+		p += SQLX_BLOCK_HEADER;
+
+		if (rlen > SQLX_COMPRESS_BLOCK || (gsize)(end - p) < wlen) {
+			err = BADREQ("Truncated block");
+			break;
+		}
+
+		const guint off = raw->len;
+		g_byte_array_set_size(raw, off + rlen);
+		if (method == SQLX_METHOD_STORED) {
+			if (wlen != rlen)
+				err = BADREQ("Malformed stored block");
+			else
+				memcpy(raw->data + off, p, rlen);
+		} else if (method == SQLX_METHOD_ZLIB) {
+			uLongf dlen = rlen;
+			int rc = uncompress(raw->data + off, &dlen, p, wlen);
+			if (rc != Z_OK || dlen != rlen)
+				err = BADREQ("Corrupted block (zlib %d)", rc);
+		} else {
+			err = BADREQ("Unknown block method %u", method);
+		}
+
+		if (!err && crc != crc32(0L, raw->data + off, rlen))
+			err = BADREQ("Block checksum mismatch");
+		p += wlen;
+	}
+
+	if (err) {
+		g_byte_array_free(raw, TRUE);
+		return err;
+	}
+	*out = raw;
+	return NULL;
+}
+
+void
+sqlx_wire_count_in(gsize raw, gsize wire)
+{
+	__atomic_fetch_add(&counts.raw_in, raw, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&counts.wire_in, wire, __ATOMIC_RELAXED);
+}
+
+void
+sqlx_wire_count_out(gsize raw, gsize wire)
+{
+	__atomic_fetch_add(&counts.raw_out, raw, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&counts.wire_out, wire, __ATOMIC_RELAXED);
+}
+
+void
+sqlx_wire_count_get(struct sqlx_wire_counts_s *out)
+{
+	EXTRA_ASSERT(out != NULL);
+	out->raw_in = __atomic_load_n(&counts.raw_in, __ATOMIC_RELAXED);
+	out->wire_in = __atomic_load_n(&counts.wire_in, __ATOMIC_RELAXED);
+	out->raw_out = __atomic_load_n(&counts.raw_out, __ATOMIC_RELAXED);
+	out->wire_out = __atomic_load_n(&counts.wire_out, __ATOMIC_RELAXED);
+}
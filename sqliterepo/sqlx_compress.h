@@ -0,0 +1,67 @@
+/*
+OpenIO SDS sqliterepo
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#ifndef OIO_SDS__sqliterepo__sqlx_compress_h
+# define OIO_SDS__sqliterepo__sqlx_compress_h 1
+
+#include <glib.h>
+
+/* Wire encoding of the bulky payloads exchanged between the sqliterepo
+ * peers (DUMP, DIFF, RESTORE, REPLICATE). The payload is cut in blocks of
+ * at most SQLX_COMPRESS_BLOCK bytes, each block is deflated (or stored when
+ * deflating does not help) and carries the CRC32 of its raw content.
+ *
+ * The requester of a DUMP or a DIFF always tells it accepts the encoding
+ * (NAME_MSGKEY_ACCEPT_ENCODING), and the replies come encoded when the
+ * server knows about it (the ENCODING header). The requests that carry
+ * a payload (RESTORE, REPLICATE) are only encoded when
+ * oio_sqlx_wire_compression is set, because an old peer would not decode
+ * them. */
+
+#define SQLX_ENCODING_ZLIB "zlib"
+
+#define SQLX_COMPRESS_BLOCK (1024 * 1024)
+
+/* Set it when all the peers know how to decode the encoded requests */
+extern gboolean oio_sqlx_wire_compression;
+
+struct sqlx_wire_counts_s
+{
+	guint64 raw_in;
+	guint64 wire_in;
+	guint64 raw_out;
+	guint64 wire_out;
+};
+
+/* Never fails, but the output may be slightly larger than the input when
+ * nothing can be deflated. */
+GByteArray* sqlx_compress_encode(const guint8 *raw, gsize len);
+
+/* Fails with CODE_BAD_REQUEST on any corruption (truncated block, checksum
+ * mismatch, unknown method). */
+GError* sqlx_compress_decode(const guint8 *wire, gsize len, GByteArray **out);
+
+/* Account the sizes of what has been received and sent, before and after
+ * the encoding. Thread-safe and lock-free. */
+void sqlx_wire_count_in(gsize raw, gsize wire);
+void sqlx_wire_count_out(gsize raw, gsize wire);
+
+/* Each counter is read atomically, not the four at once */
+void sqlx_wire_count_get(struct sqlx_wire_counts_s *out);
+
+#endif /*OIO_SDS__sqliterepo__sqlx_compress_h*/
@@ -41,6 +41,7 @@ License along with this library.
 #define NAME_MSGNAME_SQLX_PIPEFROM           "DB_PIPEFROM"
 #define NAME_MSGNAME_SQLX_DUMP               "DB_DUMP"
 #define NAME_MSGNAME_SQLX_RESTORE            "DB_RESTORE"
+#define NAME_MSGNAME_SQLX_DIFF               "DB_DIFF"
 #define NAME_MSGNAME_SQLX_RESYNC             "DB_RESYNC"
 
 /* repository-wide */
@@ -36,6 +36,7 @@ License along with this library.
 #include "sqliterepo.h"
 #include "sqlx_macros.h"
 #include "sqlx_remote.h"
+#include "sqlx_compress.h"
 #include "version.h"
 #include "internals.h"
 
@@ -167,11 +168,39 @@ sqlx_pack_PIPETO(const struct sqlx_name_s *name, const gchar *target)
 	return message_marshall_gba_and_clean(req);
 }
 
+static void
+_set_body_encoded(MESSAGE req, const guint8 *raw, gsize rawsize)
+{
+	if (!oio_sqlx_wire_compression) {
+		sqlx_wire_count_out(rawsize, rawsize);
+		metautils_message_set_BODY(req, raw, rawsize);
+		return;
+	}
+
+	GByteArray *encoded = sqlx_compress_encode(raw, rawsize);
+	sqlx_wire_count_out(rawsize, encoded->len);
+	metautils_message_add_field_str(req, NAME_MSGKEY_ENCODING,
+			SQLX_ENCODING_ZLIB);
+	metautils_message_add_body_unref(req, encoded);
+}
+
 GByteArray*
 sqlx_pack_DUMP(const struct sqlx_name_s *name, gboolean chunked)
 {
 	MESSAGE req = make_request(NAME_MSGNAME_SQLX_DUMP, name);
 	metautils_message_add_field(req, NAME_MSGKEY_CHUNKED, &chunked, 1);
+	metautils_message_add_field_str(req, NAME_MSGKEY_ACCEPT_ENCODING,
+			SQLX_ENCODING_ZLIB);
+	return message_marshall_gba_and_clean(req);
+}
+
+GByteArray*
+sqlx_pack_DIFF(const struct sqlx_name_s *name, const guint8 *sums, gsize sums_len)
+{
+	MESSAGE req = make_request(NAME_MSGNAME_SQLX_DIFF, name);
+	metautils_message_set_BODY(req, sums, sums_len);
+	metautils_message_add_field_str(req, NAME_MSGKEY_ACCEPT_ENCODING,
+			SQLX_ENCODING_ZLIB);
 	return message_marshall_gba_and_clean(req);
 }
 
@@ -179,7 +208,7 @@ GByteArray*
 sqlx_pack_RESTORE(const struct sqlx_name_s *name, const guint8 *raw, gsize rawsize)
 {
 	MESSAGE req = make_request(NAME_MSGNAME_SQLX_RESTORE, name);
-	metautils_message_set_BODY(req, raw, rawsize);
+	_set_body_encoded(req, raw, rawsize);
 	return message_marshall_gba_and_clean(req);
 }
 
@@ -190,7 +219,11 @@ sqlx_pack_REPLICATE(const struct sqlx_name_s *name, struct TableSequence *tabseq
 	EXTRA_ASSERT(tabseq != NULL);
 
 	MESSAGE req = make_request(NAME_MSGNAME_SQLX_REPLICATE, name);
-	metautils_message_add_body_unref(req, sqlx_encode_TableSequence(tabseq, NULL));
+	GByteArray *body = sqlx_encode_TableSequence(tabseq, NULL);
+	if (body) {
+		_set_body_encoded(req, body->data, body->len);
+		g_byte_array_unref(body);
+	}
 	return message_marshall_gba_and_clean(req);
 }
 
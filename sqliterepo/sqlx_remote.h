@@ -114,6 +114,7 @@ GByteArray* sqlx_pack_PIPETO(const struct sqlx_name_s *name, const gchar *target
 GByteArray* sqlx_pack_RESYNC(const struct sqlx_name_s *name);
 
 GByteArray* sqlx_pack_DUMP(const struct sqlx_name_s *name, gboolean chunked);
+GByteArray* sqlx_pack_DIFF(const struct sqlx_name_s *name, const guint8 *sums, gsize sums_len);
 GByteArray* sqlx_pack_RESTORE(const struct sqlx_name_s *name, const guint8 *raw, gsize rawsize);
 
 GByteArray* sqlx_pack_REPLICATE(const struct sqlx_name_s *name, struct TableSequence *tabseq);
@@ -158,4 +159,9 @@ typedef GError* (*peer_dump_cb)(GByteArray *part, gint64 remaining, gpointer arg
 GError * peer_dump(const gchar *target, struct sqlx_name_s *name, gboolean chunked,
 		peer_dump_cb, gpointer cb_arg);
 
+/* Sends the checksums of the pages of a local dump to the target, and
+ * passes each block of differing pages to the callback. */
+GError * peer_dump_diff(const gchar *target, struct sqlx_name_s *name,
+		GByteArray *sums, peer_dump_cb callback, gpointer cb_arg);
+
 #endif /*OIO_SDS__sqliterepo__sqlx_remote_h*/
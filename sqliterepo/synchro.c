@@ -25,7 +25,6 @@ License along with this library.
 #include "version.h"
 #include "synchro.h"
 #include "sqlx_remote.h"
-#include "gridd_client_pool.h"
 
 struct sqlx_sync_s
 {
@@ -32,12 +32,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <server/transport_gridd.h>
 #include <sqliterepo/sqlx_macros.h>
 #include <sqliterepo/sqliterepo.h>
+#include <sqliterepo/sqlx_compress.h>
 #include <sqliterepo/cache.h>
 #include <sqliterepo/election.h>
 #include <sqliterepo/synchro.h>
 #include <sqliterepo/replication_dispatcher.h>
-#include <sqliterepo/gridd_client_pool.h>
 #include <resolver/hc_resolver.h>
+#include <cache/cache.h>
 
 #include <glib.h>
 
@@ -60,6 +61,7 @@ static void _task_expire_resolver(gpointer p);
 static void _task_react_elections(gpointer p);
 static void _task_reload_nsinfo(gpointer p);
 static void _task_reload_workers(gpointer p);
+static void _task_push_wire_stats(gpointer p);
 
 static gpointer _worker_queue (gpointer p);
 static gpointer _worker_clients (gpointer p);
@@ -116,12 +118,23 @@ static struct grid_main_option_s common_options[] =
 		"Limits the number of concurrent active connections" },
 	{"MaxWorkers", OT_UINT, {.u=&SRV.cfg_max_workers},
 		"Limits the number of worker threads" },
+	{"MaxMemory", OT_INT64, {.i64=&SRV.max_memory},
+		"Limits the memory used by the bases kept open (bytes), "
+			"0 means no limit" },
 
 	{"CacheEnabled", OT_BOOL, {.b = &SRV.flag_cached_bases},
 		"If set, each base will be cached in a way it won't be accessed"
 			" by several requests in the same time."},
 	{"DeleteEnabled", OT_BOOL, {.b = &SRV.flag_delete_on},
 		"If not set, prevents deleting database files from disk"},
+	{"ResolverShared", OT_STRING, {.str = &SRV.cfg_resolver_shared},
+		"Path to a file (on a tmpfs) holding a directory cache shared by "
+			"the processes of the host, behind the local cache"},
+	{"ResolverSharedMax", OT_UINT, {.u = &SRV.cfg_resolver_shared_max},
+		"Limits the number of entries in the shared directory cache"},
+	{"Sqlx.Wire.Compress", OT_BOOL, {.b = &oio_sqlx_wire_compression},
+		"If set, the RESTORE and REPLICATE requests are sent compressed. "
+			"Only set it when all the peers are able to decode them."},
 
 	{NULL, 0, {.i=0}, NULL}
 };
@@ -257,6 +270,26 @@ _init_configless_structures(struct sqlx_service_s *ss)
 	return TRUE;
 }
 
+static gboolean
+_configure_resolver (struct sqlx_service_s *ss)
+{
+	if (!ss->cfg_resolver_shared || !ss->cfg_resolver_shared->len)
+		return TRUE;
+
+	struct hc_resolver_stats_s stats = {0};
+	hc_resolver_info(ss->resolver, &stats);
+	struct oio_cache_s *shared = oio_cache_make_shm(
+			ss->cfg_resolver_shared->str, ss->cfg_resolver_shared_max,
+			stats.services.ttl);
+	if (!shared) {
+		GRID_WARN("Failed to map the shared directory cache [%s]",
+				ss->cfg_resolver_shared->str);
+		return FALSE;
+	}
+	hc_resolver_set_shared(ss->resolver, shared);
+	return TRUE;
+}
+
 static gboolean
 _configure_peering (struct sqlx_service_s *ss)
 {
@@ -369,6 +402,7 @@ _configure_tasks(struct sqlx_service_s *ss)
 	grid_task_queue_register(ss->gtq_admin, 1, _task_expire_resolver, NULL, ss);
 	grid_task_queue_register(ss->gtq_admin, 1, _task_react_elections, NULL, ss);
 	grid_task_queue_register(ss->gtq_admin, 3600, _task_malloc_trim, NULL, ss);
+	grid_task_queue_register(ss->gtq_admin, 1, _task_push_wire_stats, NULL, ss);
 
 	return TRUE;
 }
@@ -439,6 +473,7 @@ sqlx_service_action(void)
 	network_server_set_maxcnx(SRV.server, SRV.max_passive);
 	network_server_set_cnx_backlog(SRV.server, SRV.cnx_backlog);
 	sqlx_repository_configure_maxbases(SRV.repository, SRV.max_bases);
+	sqlx_repository_configure_max_memory(SRV.repository, SRV.max_memory);
 
 	election_manager_set_peering(SRV.election_manager, SRV.peering);
 	if (SRV.sync)
@@ -500,6 +535,7 @@ sqlx_service_configure(int argc, char **argv)
 	return _configure_limits(&SRV)
 	    && _init_configless_structures(&SRV)
 	    && _configure_with_arguments(&SRV, argc, argv)
+	    && _configure_resolver(&SRV)
 		&& _configure_synchronism(&SRV)
 	    && _configure_peering(&SRV)
 	    && _configure_replication(&SRV)
@@ -521,6 +557,7 @@ sqlx_service_set_defaults(void)
 	SRV.cfg_max_passive = 0;
 	SRV.cfg_max_active = 0;
 	SRV.cfg_max_workers = 200;
+	SRV.cfg_resolver_shared_max = 65536;
 	SRV.flag_replicable = TRUE;
 	SRV.flag_autocreate = TRUE;
 	SRV.flag_delete_on = TRUE;
@@ -604,6 +641,10 @@ sqlx_service_specific_fini(void)
 		g_string_free(SRV.announce, TRUE);
 		SRV.announce = NULL;
 	}
+	if (SRV.cfg_resolver_shared) {
+		g_string_free(SRV.cfg_resolver_shared, TRUE);
+		SRV.cfg_resolver_shared = NULL;
+	}
 	if (SRV.url) {
 		g_string_free(SRV.url, TRUE);
 		SRV.url = NULL;
@@ -772,6 +813,24 @@ _task_react_elections(gpointer p)
 		GRID_DEBUG("Reacted %u elections", count);
 }
 
+static void
+_task_push_wire_stats(gpointer p)
+{
+	static GQuark gq_raw_in = 0, gq_wire_in = 0, gq_raw_out = 0, gq_wire_out = 0;
+	if (!gq_raw_in) {
+		gq_raw_in = g_quark_from_static_string("counter sqlx.bytes.raw_in");
+		gq_wire_in = g_quark_from_static_string("counter sqlx.bytes.wire_in");
+		gq_raw_out = g_quark_from_static_string("counter sqlx.bytes.raw_out");
+		gq_wire_out = g_quark_from_static_string("counter sqlx.bytes.wire_out");
+	}
+
+	struct sqlx_wire_counts_s counts = {0};
+	sqlx_wire_count_get(&counts);
+	network_server_stat_push4(PSRV(p)->server, FALSE,
+			gq_raw_in, counts.raw_in, gq_wire_in, counts.wire_in,
+			gq_raw_out, counts.raw_out, gq_wire_out, counts.wire_out);
+}
+
 static void
 _task_reload_nsinfo(gpointer p)
 {
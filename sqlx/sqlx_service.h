@@ -113,6 +113,7 @@ struct sqlx_service_s
 	guint max_bases;
 	guint max_passive;
 	guint max_active;
+	gint64 max_memory;
 
 	//-------------------------------------------------------------------
 	// Variables used during the startup time of the server, but not used
@@ -124,6 +125,11 @@ struct sqlx_service_s
 	guint cfg_max_active;
 	guint cfg_max_workers;
 
+	/* Optional path to the directory cache shared by the processes of
+	 * the host, and its capacity */
+	GString *cfg_resolver_shared;
+	guint cfg_resolver_shared_max;
+
 	guint sync_mode_repli;
 	guint sync_mode_solo;
 
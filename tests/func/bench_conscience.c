@@ -0,0 +1,258 @@
+/*
+OpenIO SDS cluster
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Loads a running conscience the way a large deployment does: <pushers>
+ * fake services are registered then refreshed round after round, all the
+ * pushes of a round being in flight at once (one connection each), while
+ * <getters> clients load the services list. The latency of each request is
+ * kept to report percentiles. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include <metautils/lib/metautils.h>
+#include <metautils/lib/common_main.h>
+#include <cluster/lib/gridcluster.h>
+
+static gint opt_pushers = 2000;
+static gint opt_rounds = 10;
+static gint opt_getters = 10;
+static gchar *opt_type = NULL;
+static gdouble opt_timeout = 30.0;
+
+static GOptionEntry entries[] = {
+	{"pushers", 'n', 0, G_OPTION_ARG_INT, &opt_pushers,
+		"Number of services pushed concurrently", "N"},
+	{"rounds", 'r', 0, G_OPTION_ARG_INT, &opt_rounds,
+		"Number of times each service is pushed", "N"},
+	{"getters", 'g', 0, G_OPTION_ARG_INT, &opt_getters,
+		"Number of services listings per round", "N"},
+	{"type", 't', 0, G_OPTION_ARG_STRING, &opt_type,
+		"Type of the fake services (default: rawx)", "TYPE"},
+	{"timeout", 'T', 0, G_OPTION_ARG_DOUBLE, &opt_timeout,
+		"Timeout of each request, in seconds", "SECONDS"},
+	{NULL, 0, 0, 0, NULL, NULL, NULL}
+};
+
+enum bench_op_e { OP_PUSH, OP_GET, OP_MAX };
+
+static const char * const op_names[OP_MAX] = { "push", "get" };
+
+struct bench_stat_s
+{
+	GArray *latencies; /* gint64, in microseconds */
+	guint errors;
+};
+
+static struct bench_stat_s stats[OP_MAX];
+
+/* The hooks run in the thread of the client pool, the main thread waits
+ * for the end of each round */
+static GMutex lock;
+static GCond cond;
+static guint pending = 0;
+
+struct bench_call_s
+{
+	enum bench_op_e op;
+	gint64 start;
+};
+
+static void
+_on_done(struct bench_call_s *call, GError *err)
+{
+	gint64 lat = g_get_monotonic_time() - call->start;
+	g_mutex_lock(&lock);
+	if (err) {
+		if (!stats[call->op].errors)
+			g_printerr("%s failed: (%d) %s\n", op_names[call->op],
+					err->code, err->message);
+		stats[call->op].errors ++;
+	} else {
+		g_array_append_val(stats[call->op].latencies, lat);
+	}
+	if (!--pending)
+		g_cond_signal(&cond);
+	g_mutex_unlock(&lock);
+}
+
+static gboolean
+_on_reply(gpointer ctx, MESSAGE reply)
+{
+	(void) ctx, (void) reply;
+	return TRUE;
+}
+
+static gint
+_cmp_gint64 (gconstpointer p0, gconstpointer p1)
+{
+	return CMP(*(const gint64*)p0, *(const gint64*)p1);
+}
+
+static gint64
+_percentile (GArray *sorted, guint pct)
+{
+	if (!sorted->len)
+		return 0;
+	guint i = (sorted->len * pct) / 100;
+	return g_array_index(sorted, gint64, MIN(i, sorted->len - 1));
+}
+
+static void
+_report (gint64 elapsed)
+{
+	g_print("%-8s %10s %8s %12s %10s %10s %10s %10s\n", "op", "count",
+			"errors", "req/s", "p50(us)", "p90(us)", "p99(us)", "max(us)");
+	for (guint op = 0; op < OP_MAX; ++op) {
+		GArray *lat = stats[op].latencies;
+		g_array_sort(lat, _cmp_gint64);
+		gdouble rate = elapsed > 0
+			? (lat->len * (gdouble)G_TIME_SPAN_SECOND) / elapsed : 0.0;
+		g_print("%-8s %10u %8u %12.1f %10"G_GINT64_FORMAT" %10"G_GINT64_FORMAT
+				" %10"G_GINT64_FORMAT" %10"G_GINT64_FORMAT"\n",
+				op_names[op], lat->len, stats[op].errors, rate,
+				_percentile(lat, 50), _percentile(lat, 90),
+				_percentile(lat, 99), _percentile(lat, 100));
+	}
+}
+
+/* Each fake service has its own port, so that they are all distinct */
+static GByteArray *
+_make_push(const gchar *ns, guint idx)
+{
+	struct service_info_s *si = g_malloc0(sizeof(*si));
+	g_strlcpy(si->ns_name, ns, sizeof(si->ns_name));
+	g_strlcpy(si->type, opt_type, sizeof(si->type));
+	gchar url[64];
+	g_snprintf(url, sizeof(url), "127.%u.%u.1:%u", 1 + idx / (256 * 60000),
+			(idx / 60000) % 256, 1024 + idx % 60000);
+	grid_string_to_addrinfo(url, &si->addr);
+	si->score.value = SCORE_UNSET;
+	si->tags = g_ptr_array_new();
+	service_tag_set_value_boolean(service_info_ensure_tag(si->tags, "tag.up"), TRUE);
+	service_tag_set_value_i64(service_info_ensure_tag(si->tags, "stat.cpu"), 100);
+	service_tag_set_value_i64(service_info_ensure_tag(si->tags, "stat.io"), 100);
+	service_tag_set_value_i64(service_info_ensure_tag(si->tags, "stat.space"), 100);
+
+	GSList *l = g_slist_prepend(NULL, si);
+	MESSAGE req = metautils_message_create_named(NAME_MSGNAME_CS_PUSH_SRV);
+	metautils_message_add_body_unref(req, service_info_marshall_gba(l, NULL));
+	g_slist_free_full(l, (GDestroyNotify)service_info_clean);
+	return message_marshall_gba_and_clean(req);
+}
+
+static GByteArray *
+_make_get(void)
+{
+	MESSAGE req = metautils_message_create_named(NAME_MSGNAME_CS_GET_SRV);
+	metautils_message_add_field_str(req, NAME_MSGKEY_TYPENAME, opt_type);
+	return message_marshall_gba_and_clean(req);
+}
+
+static void
+_submit(const gchar *cs, GByteArray *req, struct bench_call_s *call,
+		enum bench_op_e op)
+{
+	call->op = op;
+	call->start = g_get_monotonic_time();
+	gridd_client_pool_submit(gridd_client_pool_shared(), cs, req,
+			opt_timeout, NULL, _on_reply, (gridd_client_done_f)_on_done, call);
+}
+
+int
+main(int argc, char **argv)
+{
+	HC_PROC_INIT(argv, GRID_LOGLVL_WARN);
+
+	GError *err = NULL;
+	GOptionContext *ctx = g_option_context_new("IP:PORT NS - conscience load test");
+	g_option_context_add_main_entries(ctx, entries, NULL);
+	if (!g_option_context_parse(ctx, &argc, &argv, &err)) {
+		g_printerr("%s\n", err->message);
+		return 2;
+	}
+	g_option_context_free(ctx);
+	if (argc != 3 || opt_pushers <= 0 || opt_rounds <= 0 || opt_getters < 0) {
+		g_printerr("Invalid parameters\n");
+		return 2;
+	}
+	if (!opt_type)
+		opt_type = g_strdup(NAME_SRVTYPE_RAWX);
+
+	const gchar *cs = argv[1], *ns = argv[2];
+	const guint total = opt_pushers + opt_getters;
+
+	GPtrArray *pushes = g_ptr_array_new_with_free_func(
+			(GDestroyNotify)metautils_gba_unref);
+	for (gint i = 0; i < opt_pushers; ++i)
+		g_ptr_array_add(pushes, _make_push(ns, i));
+	GByteArray *get = _make_get();
+	struct bench_call_s *calls = g_malloc0(total * sizeof(struct bench_call_s));
+
+	for (guint op = 0; op < OP_MAX; ++op)
+		stats[op].latencies = g_array_new(FALSE, FALSE, sizeof(gint64));
+	g_mutex_init(&lock);
+	g_cond_init(&cond);
+
+	g_print("conscience=%s ns=%s type=%s pushers=%d rounds=%d getters=%d\n",
+			cs, ns, opt_type, opt_pushers, opt_rounds, opt_getters);
+
+	gint64 pre = g_get_monotonic_time();
+	for (gint r = 0; r < opt_rounds; ++r) {
+		g_mutex_lock(&lock);
+		pending = total;
+		g_mutex_unlock(&lock);
+
+		/* The listings are interleaved with the pushes */
+		guint c = 0, step = opt_getters ? MAX(1, opt_pushers / opt_getters) : 0;
+		for (gint i = 0; i < opt_pushers; ++i) {
+			_submit(cs, pushes->pdata[i], calls + (c++), OP_PUSH);
+			if (step && !(i % step) && c < total)
+				_submit(cs, get, calls + (c++), OP_GET);
+		}
+		while (c < total)
+			_submit(cs, get, calls + (c++), OP_GET);
+
+		g_mutex_lock(&lock);
+		while (pending > 0)
+			g_cond_wait(&cond, &lock);
+		g_mutex_unlock(&lock);
+	}
+	gint64 elapsed = g_get_monotonic_time() - pre;
+	_report(elapsed);
+
+	/* Check the services have all been registered */
+	GSList *services = NULL;
+	if (NULL != (err = conscience_remote_get_services(cs, opt_type, FALSE, &services))) {
+		g_printerr("listing failed: (%d) %s\n", err->code, err->message);
+		g_clear_error(&err);
+	} else {
+		g_print("%u services of type %s registered\n",
+				g_slist_length(services), opt_type);
+		g_slist_free_full(services, (GDestroyNotify)service_info_clean);
+	}
+
+	for (guint op = 0; op < OP_MAX; ++op)
+		g_array_free(stats[op].latencies, TRUE);
+	g_ptr_array_free(pushes, TRUE);
+	metautils_gba_unref(get);
+	g_free(calls);
+	g_free(opt_type);
+	return (stats[OP_PUSH].errors || stats[OP_GET].errors) ? 1 : 0;
+}
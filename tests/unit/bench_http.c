@@ -0,0 +1,560 @@
+/*
+OpenIO SDS proxy
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Parses and routes a stream of pipelined requests, as the proxy does
+ * before running the handlers, with the byte-per-byte parser and the
+ * matching the proxy used to have, then with the current ones. Both must
+ * find the same requests and the same handlers. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include <core/url_ext.h>
+#include <metautils/lib/metautils.h>
+#include <proxy/http_parser.h>
+#include <proxy/path_parser.h>
+
+static gint opt_requests = 10000;
+static gint opt_rounds = 20;
+static gint opt_slab = 8192;
+
+static GOptionEntry entries[] = {
+	{"requests", 'n', 0, G_OPTION_ARG_INT, &opt_requests,
+		"Number of pipelined requests per round", "N"},
+	{"rounds", 'r', 0, G_OPTION_ARG_INT, &opt_rounds,
+		"Number of rounds", "N"},
+	{"slab", 's', 0, G_OPTION_ARG_INT, &opt_slab,
+		"Size of the pieces of input, as read from the network", "N"},
+	{NULL, 0, 0, 0, NULL, NULL, NULL}
+};
+
+static const char * const routes[] = {
+	"/status/#GET",
+	"/forward/$ACTION/#POST",
+	"/cache/status/#GET",
+	"/cache/flush/local/#POST",
+	"/cache/ttl/low/$COUNT/#POST",
+	"/$NS/lb/choose/#GET",
+	"/$NS/conscience/info/#GET",
+	"/$NS/conscience/list/#GET",
+	"/$NS/conscience/register/#POST",
+	"/$NS/reference/create/#POST",
+	"/$NS/reference/destroy/#POST",
+	"/$NS/reference/show/#GET",
+	"/$NS/reference/link/#POST",
+	"/$NS/container/create/#POST",
+	"/$NS/container/destroy/#POST",
+	"/$NS/container/show/#GET",
+	"/$NS/container/list/#GET",
+	"/$NS/container/get_properties/#POST",
+	"/$NS/container/set_properties/#POST",
+	"/$NS/container/raw_insert/#POST",
+	"/$NS/content/create/#POST",
+	"/$NS/content/delete/#POST",
+	"/$NS/content/show/#GET",
+	"/$NS/content/prepare/#POST",
+	"/$NS/content/get_properties/#POST",
+	"/$NS/admin/ping/#POST",
+	"/$NS/admin/info/#POST",
+	NULL
+};
+
+/* The handled requests, summarized for the comparison */
+static GString *summary = NULL;
+
+static struct path_parser_s *path_parser = NULL;
+
+/* What the proxy does with each request ----------------------------------- */
+
+struct request_s
+{
+	gchar *cmd, *req_uri, *version;
+	GTree *headers;
+	GByteArray *body;
+};
+
+static gint
+_cmp (gconstpointer p0, gconstpointer p1, gpointer p2)
+{
+	(void) p2;
+	return g_ascii_strcasecmp (p0, p1);
+}
+
+static void
+_request_init (struct request_s *r)
+{
+	memset (r, 0, sizeof(*r));
+	r->headers = g_tree_new_full (_cmp, NULL, g_free, g_free);
+	r->body = g_byte_array_new ();
+}
+
+static void
+_request_clean (struct request_s *r)
+{
+	g_free (r->cmd);
+	g_free (r->req_uri);
+	g_free (r->version);
+	g_tree_destroy (r->headers);
+	g_byte_array_free (r->body, TRUE);
+}
+
+static void
+_request_handle (struct request_s *r,
+		struct path_matching_s ** (*match) (const char*, const char*))
+{
+	struct oio_requri_s ruri = {NULL, NULL, NULL, NULL};
+	oio_requri_parse (r->req_uri, &ruri);
+	struct path_matching_s **m = match (r->cmd, ruri.path);
+	const gchar *ns = *m ? path_matching_get_variable (*m, "NS") : NULL;
+	g_string_append_printf (summary, "%s %s %d %u %s\n", r->cmd,
+			ns ? ns : "-", *m ? GPOINTER_TO_INT ((*m)->last->u) : -1,
+			g_tree_nnodes (r->headers), (gchar*) r->body->data);
+	path_matching_cleanv (m);
+	oio_requri_clear (&ruri);
+}
+
+/* The former implementation ----------------------------------------------- */
+
+enum old_step_e
+{
+	STEP_FIRST_R0, STEP_FIRST_N0,
+	STEP_SEP_R0, STEP_SEP_N0,
+	STEP_HEADERS_R0, STEP_HEADERS_N0,
+	STEP_BODY_ASIS
+};
+
+struct old_parser_s
+{
+	enum old_step_e step;
+	GString *buf;
+	gint64 content_read;
+	gint64 content_length;
+	struct request_s *rq;
+};
+
+static void
+_old_chomp (GString *gstr)
+{
+	gchar *start = gstr->str, *end = start + gstr->len;
+	while (end > start && (*(end-1) == '\n' || *(end-1) == '\r'))
+		*(--end) = '\0';
+}
+
+static void
+_old_lower (gchar *s)
+{
+	for (; *s ;++s)
+		*s = g_ascii_tolower (*s);
+}
+
+static gboolean
+_old_command (struct old_parser_s *parser, GString *buf)
+{
+	if (!buf->len)
+		return FALSE;
+	_old_chomp (buf);
+	gchar *cmd = buf->str, *selector, *version;
+	if (!(selector = strchr (cmd, ' ')))
+		return FALSE;
+	*(selector++) = '\0';
+	if (!(version = strrchr (selector, ' ')))
+		return FALSE;
+	*(version++) = '\0';
+	parser->rq->cmd = g_strdup (cmd);
+	parser->rq->req_uri = g_strdup (selector);
+	parser->rq->version = g_strdup (version);
+	g_string_set_size (buf, 0);
+	return TRUE;
+}
+
+static gboolean
+_old_header (struct old_parser_s *parser, GString *buf)
+{
+	if (!buf->len)
+		return TRUE;
+	_old_chomp (buf);
+	gchar *header = buf->str;
+	gchar *sep = strchr (header, ':');
+	if (!sep)
+		return FALSE;
+	*(sep++) = '\0';
+	if (*(sep++) != ' ')
+		return FALSE;
+	if (!g_ascii_strcasecmp (header, "Content-Length"))
+		parser->content_length = g_ascii_strtoll (sep, NULL, 10);
+	gchar *k = g_strdup (header);
+	_old_lower (k);
+	g_tree_replace (parser->rq->headers, k, g_strdup (sep));
+	g_string_set_size (buf, 0);
+	return TRUE;
+}
+
+static struct http_parsing_result_s
+_old_parse (struct old_parser_s *parser, const guint8 *data, gsize available)
+{
+	struct http_parsing_result_s rc = {0, HPRC_MORE};
+
+	while (rc.consumed < available) {
+		guint8 d = data[rc.consumed];
+		gint64 max;
+		switch (parser->step) {
+			case STEP_FIRST_R0:
+				if (d == '\r')
+					parser->step = STEP_FIRST_N0;
+				else
+					g_string_append_c (parser->buf, d);
+				++ rc.consumed;
+				continue;
+			case STEP_FIRST_N0:
+				if (d != '\n' || !_old_command (parser, parser->buf))
+					goto error;
+				parser->step = STEP_SEP_R0;
+				++ rc.consumed;
+				continue;
+			case STEP_SEP_R0:
+				if (d == '\r')
+					parser->step = STEP_SEP_N0;
+				else {
+					if (!_old_header (parser, parser->buf))
+						goto error;
+					g_string_append_c (parser->buf, d);
+					parser->step = STEP_HEADERS_R0;
+				}
+				++ rc.consumed;
+				continue;
+			case STEP_SEP_N0:
+				if (d != '\n')
+					goto error;
+				++ rc.consumed;
+				if (!_old_header (parser, parser->buf))
+					goto error;
+				parser->step = STEP_BODY_ASIS;
+				if (parser->content_read >= parser->content_length) {
+					rc.status = HPRC_SUCCESS;
+					return rc;
+				}
+				continue;
+			case STEP_HEADERS_R0:
+				if (d == '\r')
+					parser->step = STEP_HEADERS_N0;
+				else
+					g_string_append_c (parser->buf, d);
+				++ rc.consumed;
+				continue;
+			case STEP_HEADERS_N0:
+				if (d != '\n')
+					goto error;
+				parser->step = STEP_SEP_R0;
+				++ rc.consumed;
+				continue;
+			case STEP_BODY_ASIS:
+				max = available - rc.consumed;
+				if (max > (parser->content_length - parser->content_read))
+					max = parser->content_length - parser->content_read;
+				g_byte_array_append (parser->rq->body, data + rc.consumed, max);
+				rc.consumed += max;
+				parser->content_read += max;
+				if (parser->content_read >= parser->content_length) {
+					rc.status = HPRC_SUCCESS;
+					return rc;
+				}
+				continue;
+		}
+	}
+	return rc;
+error:
+	rc.status = HPRC_ERROR;
+	return rc;
+}
+
+static GSList *
+_old_explore (struct trie_node_s **tab, gchar **needles,
+		const struct path_matching_s *current)
+{
+	GSList *matches = NULL;
+
+	struct path_matching_s * copy (void) {
+		struct path_matching_s *m = SLICE_NEW0 (struct path_matching_s);
+		m->last = *tab;
+		m->vars = current->vars ? g_strdupv (current->vars) : g_malloc0 (sizeof(gchar*));
+		return m;
+	}
+	void drop (struct path_matching_s *m) {
+		g_strfreev (m->vars);
+		SLICE_FREE (struct path_matching_s, m);
+	}
+	void step (struct path_matching_s *m) {
+		if (!needles[1]) {
+			if (!(*tab)->u)
+				drop (m);
+			else
+				matches = g_slist_prepend (matches, m);
+		} else {
+			GSList *local = _old_explore ((*tab)->next, needles+1, m);
+			drop (m);
+			if (local)
+				matches = metautils_gslist_precat (matches, local);
+		}
+	}
+
+	for (; *tab ;++tab) {
+		if ((*tab)->word) {
+			if (0 != strcmp (*needles, (*tab)->word))
+				continue;
+			step (copy ());
+		} else {
+			struct path_matching_s *m = copy ();
+			m->vars = oio_strv_append (m->vars,
+					g_strdup_printf ("%s=%s", (*tab)->var, *needles));
+			step (m);
+		}
+	}
+	return matches;
+}
+
+static struct path_matching_s **
+_old_match (const gchar *method, const gchar *path)
+{
+	gsize lp = strlen(path), lm = strlen(method);
+	gchar *key = g_alloca (lp + 2 + lm + 1);
+	gchar *pk = key;
+
+	int slash = 1;
+	for (const gchar *p = path; *p ;++p) {
+		if (slash && *p == '/')
+			continue;
+		slash = 0;
+		*(pk++) = *p;
+	}
+	if (*(pk-1) != '/')
+		*(pk++) = '/';
+	*(pk++) = '#';
+	for (const gchar *p = method; *p ;++p) {
+		if (*p != '/')
+			*(pk++) = *p;
+	}
+	*pk = '\0';
+
+	gchar **tokens = g_strsplit (key, "/", -1);
+	for (gchar **p=tokens; *p ;++p)
+		oio_str_reuse (p, g_uri_unescape_string (*p, NULL));
+
+	struct path_matching_s nomatch = {NULL, NULL};
+	GSList *l = _old_explore (path_parser->roots, tokens, &nomatch);
+	struct path_matching_s **result = g_malloc0 (
+			(1 + g_slist_length (l)) * sizeof(struct path_matching_s*));
+	struct path_matching_s **p = result;
+	for (GSList *l0 = l; l0 ;l0 = l0->next)
+		*(p++) = l0->data;
+	g_slist_free (l);
+	g_strfreev (tokens);
+	return result;
+}
+
+static gint
+_run_old (const GString *in)
+{
+	struct request_s rq;
+	struct old_parser_s parser = {STEP_FIRST_R0, g_string_sized_new (1024), 0, -1, &rq};
+	gint count = 0;
+
+	_request_init (&rq);
+	for (gsize off = 0; off < in->len ;) {
+		const gsize len = MIN((gsize)opt_slab, in->len - off);
+		const guint8 *data = (guint8*) in->str + off;
+		off += len;
+		for (gsize done = 0; done < len ;) {
+			struct http_parsing_result_s rc = _old_parse (&parser, data + done, len - done);
+			done += rc.consumed;
+			if (rc.status == HPRC_ERROR)
+				g_error ("Parsing error");
+			if (rc.status == HPRC_SUCCESS) {
+				g_byte_array_append (rq.body, (guint8*)"", 1);
+				_request_handle (&rq, _old_match);
+				_request_clean (&rq);
+				_request_init (&rq);
+				parser.step = STEP_FIRST_R0;
+				parser.content_read = 0;
+				parser.content_length = -1;
+				++ count;
+			}
+		}
+	}
+	_request_clean (&rq);
+	g_string_free (parser.buf, TRUE);
+	return count;
+}
+
+/* The current implementation ---------------------------------------------- */
+
+static struct path_matching_s **
+_new_match (const gchar *method, const gchar *path)
+{
+	return path_parser_match_request (path_parser, method, path);
+}
+
+static gint
+_run_new (const GString *in)
+{
+	struct request_s rq;
+	gint count = 0;
+
+	void command_provider (const gchar *c, gsize cl, const gchar *s, gsize sl,
+			const gchar *v, gsize vl) {
+		rq.cmd = g_strndup (c, cl);
+		rq.req_uri = g_strndup (s, sl);
+		rq.version = g_strndup (v, vl);
+	}
+	void header_provider (const gchar *k, gsize kl, const gchar *v, gsize vl) {
+		g_tree_replace (rq.headers, g_ascii_strdown (k, kl), g_strndup (v, vl));
+	}
+	void body_provider (const guint8 *data, gsize data_len) {
+		g_byte_array_append (rq.body, data, data_len);
+	}
+
+	struct http_parser_s *parser = http_parser_create ();
+	parser->command_provider = command_provider;
+	parser->header_provider = header_provider;
+	parser->body_provider = body_provider;
+
+	_request_init (&rq);
+	for (gsize off = 0; off < in->len ;) {
+		const gsize len = MIN((gsize)opt_slab, in->len - off);
+		const guint8 *data = (guint8*) in->str + off;
+		off += len;
+		for (gsize done = 0; done < len ;) {
+			struct http_parsing_result_s rc = http_parse (parser, data + done, len - done);
+			done += rc.consumed;
+			if (rc.status == HPRC_ERROR)
+				g_error ("Parsing error");
+			if (rc.status == HPRC_SUCCESS) {
+				g_byte_array_append (rq.body, (guint8*)"", 1);
+				_request_handle (&rq, _new_match);
+				_request_clean (&rq);
+				_request_init (&rq);
+				http_parser_reset (parser);
+				++ count;
+			}
+		}
+	}
+	_request_clean (&rq);
+	http_parser_destroy (parser);
+	return count;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void
+_generate (GString *g)
+{
+	static const char * const targets[] = {
+		"GET /v3.0/OPENIO/container/show?acct=ACCT&ref=JFS",
+		"GET /v3.0/OPENIO/container/list?acct=ACCT&ref=JFS&max=1000&prefix=dir%2F",
+		"GET /v3.0/OPENIO/content/show?acct=ACCT&ref=JFS&path=dir%2Fcontent%20name.bin",
+		"POST /v3.0/OPENIO/content/prepare?acct=ACCT&ref=JFS&path=plop",
+		"POST /v3.0/OPENIO/container/set_properties?acct=ACCT&ref=JFS",
+		"GET /v3.0/OPENIO/conscience/list?type=rawx",
+		"POST /v3.0/OPENIO/reference/link?acct=ACCT&ref=JFS&type=meta2",
+		"GET /v3.0/OPENIO/lb/choose?pool=rawx&size=3",
+		"GET /v3.0/status",
+	};
+
+	for (gint i = 0; i < opt_requests ;++i) {
+		const char *t = targets[i % G_N_ELEMENTS(targets)];
+		g_string_append (g, t);
+		g_string_append (g, " HTTP/1.1\r\n"
+				"Host: 127.0.0.1:6000\r\n"
+				"User-Agent: oio-sds/3.0\r\n"
+				"Accept: */*\r\n"
+				"Connection: Keep-Alive\r\n");
+		g_string_append_printf (g, "X-oio-req-id: %032X\r\n", i);
+		if (t[0] == 'P') {
+			gchar body[64];
+			gint len = g_snprintf (body, sizeof(body), "{\"size\":%d}", i);
+			g_string_append (g, "Content-Type: application/json\r\n");
+			g_string_append_printf (g, "Content-Length: %d\r\n\r\n%s", len, body);
+		} else {
+			g_string_append (g, "\r\n");
+		}
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	GError *err = NULL;
+	GOptionContext *ctx = g_option_context_new ("- HTTP parsing benchmark");
+	g_option_context_add_main_entries (ctx, entries, NULL);
+	if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+		g_printerr ("%s\n", err->message);
+		return 1;
+	}
+	g_option_context_free (ctx);
+	opt_requests = MAX(1, opt_requests);
+	opt_rounds = MAX(1, opt_rounds);
+	opt_slab = MAX(1, opt_slab);
+
+	path_parser = path_parser_init ();
+	for (gint i = 0; routes[i] ;++i) {
+		gchar *descr = g_strconcat (PROXYD_PREFIX, routes[i], NULL);
+		path_parser_configure (path_parser, descr, GINT_TO_POINTER(i));
+		g_free (descr);
+	}
+
+	GString *in = g_string_sized_new (256 * opt_requests);
+	_generate (in);
+
+	GString *s0 = g_string_sized_new (64 * opt_requests);
+	GString *s1 = g_string_sized_new (64 * opt_requests);
+	gint64 t0 = 0, t1 = 0;
+	for (gint round = 0; round < opt_rounds ;++round) {
+		gint64 start;
+
+		summary = s0;
+		g_string_set_size (summary, 0);
+		start = g_get_monotonic_time ();
+		if (_run_old (in) != opt_requests)
+			g_error ("Requests lost");
+		t0 += g_get_monotonic_time () - start;
+
+		summary = s1;
+		g_string_set_size (summary, 0);
+		start = g_get_monotonic_time ();
+		if (_run_new (in) != opt_requests)
+			g_error ("Requests lost");
+		t1 += g_get_monotonic_time () - start;
+	}
+
+	if (strcmp (s0->str, s1->str)) {
+		g_printerr ("Outputs differ\n");
+		return 1;
+	}
+
+	const gdouble total = (gdouble) opt_requests * opt_rounds;
+	g_print ("%d requests x %d rounds, %"G_GSIZE_FORMAT" bytes, pieces of %d\n",
+			opt_requests, opt_rounds, in->len, opt_slab);
+	g_print ("old %8.3f s %10.0f req/s\n", t0 / 1e6, total / (t0 / 1e6));
+	g_print ("new %8.3f s %10.0f req/s\n", t1 / 1e6, total / (t1 / 1e6));
+
+	g_string_free (in, TRUE);
+	g_string_free (s0, TRUE);
+	g_string_free (s1, TRUE);
+	path_parser_clean (path_parser);
+	return 0;
+}
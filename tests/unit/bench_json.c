@@ -0,0 +1,147 @@
+/*
+OpenIO SDS core library
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+/* Compares the encoding of a listing of <records> aliases-like records,
+ * with g_string_append_printf() as the proxy used to do and with the
+ * oio_json_append_*() writer. Both outputs are checked to be identical. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include <core/oiojson.h>
+#include <metautils/lib/metautils.h>
+
+static gint opt_records = 10000;
+static gint opt_rounds = 20;
+
+static GOptionEntry entries[] = {
+	{"records", 'n', 0, G_OPTION_ARG_INT, &opt_records,
+		"Number of records per listing", "N"},
+	{"rounds", 'r', 0, G_OPTION_ARG_INT, &opt_rounds,
+		"Number of listings encoded", "N"},
+	{NULL, 0, 0, 0, NULL, NULL, NULL}
+};
+
+struct record_s
+{
+	gchar name[64];
+	gint64 version;
+	gint64 ctime;
+	gint64 size;
+	gboolean deleted;
+	guint8 hash[16];
+};
+
+static void
+_encode_printf (GString *g, const struct record_s *r)
+{
+	gchar hash[33];
+	oio_str_bin2hex (r->hash, sizeof(r->hash), hash, sizeof(hash));
+	g_string_append_printf (g,
+			"{\"name\":\"%s\",\"ver\":%"G_GINT64_FORMAT
+			",\"ctime\":%"G_GINT64_FORMAT",\"deleted\":%s"
+			",\"hash\":\"%s\",\"size\":%"G_GINT64_FORMAT"}",
+			r->name, r->version, r->ctime, r->deleted ? "true" : "false",
+			hash, r->size);
+}
+
+static void
+_encode_writer (GString *g, const struct record_s *r)
+{
+	g_string_append_c (g, '{');
+	OIO_JSON_KEY(g, "name");
+	oio_json_append_string (g, r->name);
+	OIO_JSON_NEXT_KEY(g, "ver");
+	oio_json_append_int (g, r->version);
+	OIO_JSON_NEXT_KEY(g, "ctime");
+	oio_json_append_int (g, r->ctime);
+	OIO_JSON_NEXT_KEY(g, "deleted");
+	oio_json_append_bool (g, r->deleted);
+	OIO_JSON_NEXT_KEY(g, "hash");
+	oio_json_append_hex (g, r->hash, sizeof(r->hash));
+	OIO_JSON_NEXT_KEY(g, "size");
+	oio_json_append_int (g, r->size);
+	g_string_append_c (g, '}');
+}
+
+static gint64
+_run (void (*encode) (GString*, const struct record_s*),
+		const struct record_s *records, GString *g)
+{
+	gint64 start = g_get_monotonic_time ();
+	for (gint round = 0; round < opt_rounds ;++round) {
+		g_string_set_size (g, 0);
+		g_string_append_c (g, '[');
+		for (gint i = 0; i < opt_records ;++i) {
+			if (i)
+				g_string_append_c (g, ',');
+			encode (g, records + i);
+		}
+		g_string_append_c (g, ']');
+	}
+	return g_get_monotonic_time () - start;
+}
+
+int
+main (int argc, char **argv)
+{
+	GError *err = NULL;
+	GOptionContext *ctx = g_option_context_new ("- JSON encoding benchmark");
+	g_option_context_add_main_entries (ctx, entries, NULL);
+	if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+		g_printerr ("%s\n", err->message);
+		return 1;
+	}
+	g_option_context_free (ctx);
+	opt_records = MAX(1, opt_records);
+	opt_rounds = MAX(1, opt_rounds);
+
+	struct record_s *records = g_malloc0 (opt_records * sizeof(*records));
+	for (gint i = 0; i < opt_records ;++i) {
+		struct record_s *r = records + i;
+		g_snprintf (r->name, sizeof(r->name), "dir-%d/sub-%d/content-%d.bin",
+				i % 17, i % 101, i);
+		r->version = r->ctime = 1444444444000000 + i;
+		r->size = ((gint64)i * 7919) % (1 << 30);
+		r->deleted = (i % 13) == 0;
+		for (guint j = 0; j < sizeof(r->hash) ;++j)
+			r->hash[j] = i * 31 + j;
+	}
+
+	GString *g0 = g_string_sized_new (256 * opt_records);
+	GString *g1 = g_string_sized_new (256 * opt_records);
+	gint64 t0 = _run (_encode_printf, records, g0);
+	gint64 t1 = _run (_encode_writer, records, g1);
+
+	if (strcmp (g0->str, g1->str)) {
+		g_printerr ("Outputs differ\n");
+		return 1;
+	}
+
+	const gdouble mb = (gdouble)(g0->len * opt_rounds) / (1024.0 * 1024.0);
+	g_print ("%d records x %d rounds, %"G_GSIZE_FORMAT" bytes per listing\n",
+			opt_records, opt_rounds, g0->len);
+	g_print ("printf %8.3f s %8.1f MiB/s\n", t0 / 1e6, mb / (t0 / 1e6));
+	g_print ("writer %8.3f s %8.1f MiB/s\n", t1 / 1e6, mb / (t1 / 1e6));
+
+	g_string_free (g0, TRUE);
+	g_string_free (g1, TRUE);
+	g_free (records);
+	return 0;
+}
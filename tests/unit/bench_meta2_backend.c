@@ -0,0 +1,400 @@
+/*
+OpenIO SDS meta2v2
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Measures the throughput of the meta2 backend, on a local repository
+ * (no replication, no election). Each container is filled with
+ * <contents> aliases of <depth> versions each, then the aliases are read,
+ * listed, purged down to one version, and deleted. The latency of each
+ * operation is kept to report percentiles. */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <metautils/lib/metautils.h>
+#include <metautils/lib/common_main.h>
+#include <meta2v2/meta2_macros.h>
+#include <meta2v2/meta2_utils.h>
+#include <meta2v2/meta2_backend_internals.h>
+#include <meta2v2/meta2v2_remote.h>
+#include <meta2v2/generic.h>
+#include <meta2v2/meta2_bean.h>
+#include <meta2v2/autogen.h>
+#include <resolver/hc_resolver.h>
+
+static gint opt_containers = 1;
+static gint opt_contents = 1000;
+static gint opt_depth = 1;
+static gint opt_page = 1000;
+static gchar *opt_basedir = NULL;
+
+static GOptionEntry entries[] = {
+	{"containers", 'c', 0, G_OPTION_ARG_INT, &opt_containers,
+		"Number of containers to fill", "N"},
+	{"contents", 'n', 0, G_OPTION_ARG_INT, &opt_contents,
+		"Number of aliases per container", "N"},
+	{"depth", 'd', 0, G_OPTION_ARG_INT, &opt_depth,
+		"Number of versions per alias", "N"},
+	{"page", 'p', 0, G_OPTION_ARG_INT, &opt_page,
+		"Number of aliases per listing page", "N"},
+	{"basedir", 'b', 0, G_OPTION_ARG_FILENAME, &opt_basedir,
+		"Where to create the repository (default: a temporary directory)", "DIR"},
+	{NULL, 0, 0, 0, NULL, NULL, NULL}
+};
+
+/* The versions are timestamps, and two puts of the same alias in the same
+ * microsecond would collide. */
+static gint64 last_real = 0;
+
+static gint64
+_get_real (void)
+{
+	gint64 now = g_get_real_time();
+	last_real = MAX(last_real + 1, now);
+	return last_real;
+}
+
+enum bench_op_e { OP_PUT, OP_GET, OP_LIST, OP_PURGE, OP_DELETE, OP_MAX };
+
+static const char * const op_names[OP_MAX] = {
+	"put", "get", "list", "purge", "delete"
+};
+
+struct bench_stat_s
+{
+	GArray *latencies; /* gint64, in microseconds */
+	gint64 total;
+};
+
+static struct bench_stat_s stats[OP_MAX];
+
+#define TIMED(Op,Expr) do { \
+	gint64 _pre = g_get_monotonic_time(); \
+	GError *_err = (Expr); \
+	gint64 _lat = g_get_monotonic_time() - _pre; \
+	if (_err) { \
+		g_printerr("%s failed: (%d) %s\n", op_names[Op], _err->code, \
+				_err->message); \
+		exit(1); \
+	} \
+	g_array_append_val(stats[Op].latencies, _lat); \
+	stats[Op].total += _lat; \
+} while (0)
+
+static gint
+_cmp_gint64 (gconstpointer p0, gconstpointer p1)
+{
+	return CMP(*(const gint64*)p0, *(const gint64*)p1);
+}
+
+static gint64
+_percentile (GArray *sorted, guint pct)
+{
+	if (!sorted->len)
+		return 0;
+	guint i = (sorted->len * pct) / 100;
+	return g_array_index(sorted, gint64, MIN(i, sorted->len - 1));
+}
+
+static void
+_report (void)
+{
+	g_print("%-8s %10s %12s %10s %10s %10s %10s\n",
+			"op", "count", "ops/s", "p50(us)", "p90(us)", "p99(us)", "max(us)");
+	for (guint op = 0; op < OP_MAX; ++op) {
+		GArray *lat = stats[op].latencies;
+		g_array_sort(lat, _cmp_gint64);
+		gdouble rate = stats[op].total > 0
+			? (lat->len * (gdouble)G_TIME_SPAN_SECOND) / stats[op].total : 0.0;
+		g_print("%-8s %10u %12.1f %10"G_GINT64_FORMAT" %10"G_GINT64_FORMAT
+				" %10"G_GINT64_FORMAT" %10"G_GINT64_FORMAT"\n",
+				op_names[op], lat->len, rate,
+				_percentile(lat, 50), _percentile(lat, 90),
+				_percentile(lat, 99), _percentile(lat, 100));
+	}
+}
+
+static struct namespace_info_s *
+_init_nsinfo(const gchar *ns, gint64 maxvers)
+{
+	gchar str[32];
+	struct namespace_info_s *nsinfo = g_malloc0 (sizeof(*nsinfo));
+	namespace_info_init (nsinfo);
+	nsinfo->chunk_size = 1024 * 1024;
+	g_strlcpy (nsinfo->name, ns, sizeof(nsinfo->name));
+
+	g_snprintf (str, sizeof(str), "%"G_GINT64_FORMAT, maxvers);
+	g_hash_table_insert(nsinfo->options, g_strdup("meta2_max_versions"),
+			metautils_gba_from_string(str));
+	g_hash_table_insert(nsinfo->storage_policy, g_strdup("classic"),
+			metautils_gba_from_string("DUMMY:DUPONETWO:NONE"));
+	g_hash_table_insert(nsinfo->data_security, g_strdup("DUPONETWO"),
+			metautils_gba_from_string("DUP:distance=1|nb_copy=2"));
+	return nsinfo;
+}
+
+static struct grid_lbpool_s *
+_init_lb(const gchar *ns)
+{
+	static const gchar *urls[] = {
+		"127.0.0.1:1025", "127.0.0.1:1026", "127.0.0.1:1027",
+		"127.0.0.1:1028", NULL
+	};
+	const gchar **purl = urls;
+	gboolean provide(struct service_info_s **p_si) {
+		if (!*purl)
+			return FALSE;
+		struct service_info_s *si = g_malloc0(sizeof(*si));
+		g_strlcpy(si->ns_name, ns, sizeof(si->ns_name));
+		g_strlcpy(si->type, NAME_SRVTYPE_RAWX, sizeof(si->type));
+		si->score.timestamp = oio_ext_real_time() / G_TIME_SPAN_SECOND;
+		si->score.value = 100;
+		grid_string_to_addrinfo(*(purl++), &(si->addr));
+		*p_si = si;
+		return TRUE;
+	}
+
+	struct grid_lbpool_s *glp = grid_lbpool_create(ns);
+	grid_lbpool_configure_string(glp, "rawx", "RR");
+	grid_lbpool_reload(glp, "rawx", provide);
+	return glp;
+}
+
+static void
+_on_bean (gpointer u, gpointer bean)
+{
+	(void) u;
+	_bean_clean(bean);
+}
+
+static GError *
+_put (struct meta2_backend_s *m2, struct oio_url_s *url)
+{
+	GSList *beans = NULL;
+	void _collect(gpointer u, gpointer bean) {
+		(void) u;
+		beans = g_slist_prepend(beans, bean);
+	}
+	/* The generation of the beans is not what we measure */
+	GError *err = meta2_backend_generate_beans(m2, url, 1024, NULL, FALSE,
+			_collect, NULL);
+	if (!err)
+		TIMED(OP_PUT, meta2_backend_put_alias(m2, url, beans, NULL, NULL));
+	_bean_cleanl2(beans);
+	return err;
+}
+
+static GError *
+_list (struct meta2_backend_s *m2, struct oio_url_s *url)
+{
+	gchar *marker = NULL;
+	gboolean truncated = TRUE;
+	while (truncated) {
+		guint count = 0;
+		void _on_alias(gpointer u, gpointer bean) {
+			(void) u;
+			if (DESCR(bean) == &descr_struct_ALIASES) {
+				count ++;
+				oio_str_replace(&marker, ALIASES_get_alias(bean)->str);
+			}
+			_bean_clean(bean);
+		}
+		struct list_params_s lp = {0};
+		lp.maxkeys = opt_page;
+		lp.marker_start = marker;
+		TIMED(OP_LIST, meta2_backend_list_aliases(m2, url, &lp, NULL,
+				_on_alias, NULL, NULL, NULL));
+		truncated = (count >= (guint)opt_page);
+	}
+	oio_str_clean(&marker);
+	return NULL;
+}
+
+static void
+_bench_container (struct meta2_backend_s *m2, const gchar *ns, guint idx)
+{
+	gchar *strurl = g_strdup_printf("/%s/bench/container-%u-%d", ns, idx,
+			getpid());
+	struct oio_url_s *url = oio_url_init(strurl);
+	g_free(strurl);
+
+	struct m2v2_create_params_s params = {NULL, NULL, NULL, TRUE};
+	GError *err = meta2_backend_create_container(m2, url, &params);
+	if (err) {
+		g_printerr("create failed: (%d) %s\n", err->code, err->message);
+		exit(1);
+	}
+
+	GPtrArray *urls = g_ptr_array_new_with_free_func(
+			(GDestroyNotify)oio_url_clean);
+	for (gint i = 0; i < opt_contents; ++i) {
+		gchar path[64];
+		g_snprintf(path, sizeof(path), "content-%08d", i);
+		struct oio_url_s *u = oio_url_dup(url);
+		oio_url_set(u, OIOURL_PATH, path);
+		g_ptr_array_add(urls, u);
+	}
+
+	/* The versions are added round after round, as a real client would */
+	for (gint v = 0; v < opt_depth; ++v) {
+		for (guint i = 0; i < urls->len; ++i) {
+			if (NULL != (err = _put(m2, urls->pdata[i]))) {
+				g_printerr("generate failed: (%d) %s\n", err->code, err->message);
+				exit(1);
+			}
+		}
+	}
+
+	for (guint i = 0; i < urls->len; ++i)
+		TIMED(OP_GET, meta2_backend_get_alias(m2, urls->pdata[i],
+				M2V2_FLAG_NOPROPS, _on_bean, NULL));
+
+	_list(m2, url);
+
+	/* Keep only the latest version of each alias */
+	struct namespace_info_s *nsinfo = _init_nsinfo(ns, 1);
+	meta2_backend_configure_nsinfo(m2, nsinfo);
+	namespace_info_free(nsinfo);
+	TIMED(OP_PURGE, meta2_backend_purge_container(m2, url));
+
+	for (guint i = 0; i < urls->len; ++i)
+		TIMED(OP_DELETE, meta2_backend_delete_alias(m2, urls->pdata[i],
+				NULL, NULL));
+
+	/* Back to unlimited versions for the next container */
+	nsinfo = _init_nsinfo(ns, -1);
+	meta2_backend_configure_nsinfo(m2, nsinfo);
+	namespace_info_free(nsinfo);
+
+	err = meta2_backend_destroy_container(m2, url,
+			M2V2_DESTROY_FORCE|M2V2_DESTROY_FLUSH);
+	if (err) {
+		g_printerr("destroy failed: (%d) %s\n", err->code, err->message);
+		g_clear_error(&err);
+	}
+	g_ptr_array_free(urls, TRUE);
+	oio_url_pclean(&url);
+}
+
+/* Removes <path> and all it contains, without following the links */
+static void
+_rmtree(const gchar *path)
+{
+	if (g_file_test(path, G_FILE_TEST_IS_DIR)
+			&& !g_file_test(path, G_FILE_TEST_IS_SYMLINK)) {
+		GDir *dir = g_dir_open(path, 0, NULL);
+		if (dir) {
+			const gchar *name;
+			while (NULL != (name = g_dir_read_name(dir))) {
+				gchar *sub = g_build_filename(path, name, NULL);
+				_rmtree(sub);
+				g_free(sub);
+			}
+			g_dir_close(dir);
+		}
+	}
+	if (0 != g_remove(path))
+		g_printerr("Failed to remove [%s]: %s\n", path, g_strerror(errno));
+}
+
+/* The temporary directory is ours, the one given by the user is not */
+static void
+_basedir_clean(gchar *basedir)
+{
+	if (!opt_basedir)
+		_rmtree(basedir);
+	g_free(basedir);
+}
+
+int
+main(int argc, char **argv)
+{
+	HC_PROC_INIT(argv, GRID_LOGLVL_WARN);
+	oio_time_real = _get_real;
+
+	GError *err = NULL;
+	GOptionContext *ctx = g_option_context_new("- meta2 backend benchmark");
+	g_option_context_add_main_entries(ctx, entries, NULL);
+	if (!g_option_context_parse(ctx, &argc, &argv, &err)) {
+		g_printerr("%s\n", err->message);
+		return 2;
+	}
+	g_option_context_free(ctx);
+	if (opt_containers <= 0 || opt_contents <= 0 || opt_depth <= 0
+			|| opt_page <= 0) {
+		g_printerr("Invalid parameters\n");
+		return 2;
+	}
+
+	const gchar *ns = "NS";
+	gchar *basedir = opt_basedir
+		? g_strdup(opt_basedir)
+		: g_dir_make_tmp("oio-bench-m2-XXXXXX", NULL);
+	if (!basedir) {
+		g_printerr("Failed to create a temporary directory\n");
+		return 1;
+	}
+
+	struct sqlx_repo_config_s cfg = {0};
+	cfg.flags = SQLX_REPO_DELETEON;
+	cfg.sync_solo = SQLX_SYNC_OFF;
+	cfg.sync_repli = SQLX_SYNC_OFF;
+	struct sqlx_repository_s *repository = NULL;
+	if (NULL != (err = sqlx_repository_init(basedir, &cfg, &repository))) {
+		g_printerr("repository: (%d) %s\n", err->code, err->message);
+		_basedir_clean(basedir);
+		return 1;
+	}
+
+	struct grid_lbpool_s *glp = _init_lb(ns);
+	struct hc_resolver_s *resolver = hc_resolver_create1(
+			oio_ext_monotonic_time() / G_TIME_SPAN_SECOND);
+	struct meta2_backend_s *m2 = NULL;
+	if (NULL != (err = meta2_backend_init(&m2, repository, ns, glp, resolver))) {
+		g_printerr("backend: (%d) %s\n", err->code, err->message);
+		sqlx_repository_clean(repository);
+		hc_resolver_destroy(resolver);
+		grid_lbpool_destroy(glp);
+		_basedir_clean(basedir);
+		return 1;
+	}
+	struct namespace_info_s *nsinfo = _init_nsinfo(ns, -1);
+	meta2_backend_configure_nsinfo(m2, nsinfo);
+	namespace_info_free(nsinfo);
+
+	for (guint op = 0; op < OP_MAX; ++op)
+		stats[op].latencies = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+	g_print("containers=%d contents=%d depth=%d page=%d base=%s\n",
+			opt_containers, opt_contents, opt_depth, opt_page, basedir);
+	for (gint i = 0; i < opt_containers; ++i)
+		_bench_container(m2, ns, i);
+	_report();
+
+	for (guint op = 0; op < OP_MAX; ++op)
+		g_array_free(stats[op].latencies, TRUE);
+	meta2_backend_clean(m2);
+	sqlx_repository_clean(repository);
+	hc_resolver_destroy(resolver);
+	grid_lbpool_destroy(glp);
+	_basedir_clean(basedir);
+	return 0;
+}
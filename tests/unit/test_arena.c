@@ -0,0 +1,271 @@
+/*
+OpenIO SDS unit tests
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <metautils/lib/metautils.h>
+#include <metautils/lib/metacomm.h>
+#include <metautils/lib/Message.h>
+
+/* Count the allocations of the whole process, for the benchmark */
+static gboolean counting = FALSE;
+static guint64 allocations = 0;
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *
+malloc(size_t size)
+{
+	if (counting)
+		++ allocations;
+	return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+	if (counting)
+		++ allocations;
+	return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+	if (counting)
+		++ allocations;
+	return __libc_realloc(ptr, size);
+}
+#endif
+
+static MESSAGE
+_request(guint nb_fields, gsize body_len)
+{
+	MESSAGE m = metautils_message_create_named("REQ_M2_PUT");
+	for (guint i = 0; i < nb_fields ;++i) {
+		gchar k[32], v[64];
+		g_snprintf(k, sizeof(k), "field-%u", i);
+		g_snprintf(v, sizeof(v), "value-%u-%"G_GINT64_FORMAT, i,
+				g_get_monotonic_time());
+		metautils_message_add_field_str(m, k, v);
+	}
+	if (body_len) {
+		GByteArray *body = g_byte_array_sized_new(body_len);
+		g_byte_array_set_size(body, body_len);
+		oio_str_randomize(body->data, body->len);
+		metautils_message_add_body_unref(m, body);
+	}
+	return m;
+}
+
+static void
+_check_same(MESSAGE m0, MESSAGE m1)
+{
+	gsize l0 = 0, l1 = 0;
+	void *b0 = metautils_message_get_NAME(m0, &l0);
+	void *b1 = metautils_message_get_NAME(m1, &l1);
+	g_assert_cmpuint(l0, ==, l1);
+	g_assert(!memcmp(b0, b1, l0));
+
+	b0 = metautils_message_get_ID(m0, &l0);
+	b1 = metautils_message_get_ID(m1, &l1);
+	g_assert_cmpuint(l0, ==, l1);
+	g_assert(!memcmp(b0, b1, l0));
+
+	b0 = metautils_message_get_BODY(m0, &l0);
+	b1 = metautils_message_get_BODY(m1, &l1);
+	g_assert_cmpuint(l0, ==, l1);
+	g_assert(!l0 || !memcmp(b0, b1, l0));
+
+	gchar **names = metautils_message_get_field_names(m0);
+	for (gchar **pn = names; *pn ;++pn) {
+		b0 = metautils_message_get_field(m0, *pn, &l0);
+		b1 = metautils_message_get_field(m1, *pn, &l1);
+		g_assert_cmpuint(l0, ==, l1);
+		g_assert(!memcmp(b0, b1, l0));
+	}
+	g_strfreev(names);
+}
+
+static MESSAGE
+_roundtrip(MESSAGE m)
+{
+	GError *err = NULL;
+	GByteArray *gba = message_marshall_gba(m, &err);
+	g_assert_no_error(err);
+	MESSAGE m1 = message_unmarshall(gba->data, gba->len, &err);
+	g_assert_no_error(err);
+	g_assert(m1 != NULL);
+	g_byte_array_unref(gba);
+	_check_same(m, m1);
+	return m1;
+}
+
+static void
+test_alloc(void)
+{
+	struct oio_arena_s *arena = oio_arena_create(1024);
+	guint8 *ptrs[1000];
+	for (guint i = 0; i < G_N_ELEMENTS(ptrs) ;++i) {
+		const gsize len = 1 + (i % 50);
+		ptrs[i] = oio_arena_alloc(arena, len);
+		g_assert(0 == ((guintptr)ptrs[i]) % (2 * sizeof(void*)));
+		memset(ptrs[i], i & 0xFF, len);
+	}
+	g_assert_cmpuint(oio_arena_count_blocks(arena), >, 1);
+
+	/* a big allocation gets its own block */
+	guint blocks = oio_arena_count_blocks(arena);
+	guint8 *big = oio_arena_alloc0(arena, 64 * 1024);
+	for (guint i = 0; i < 64 * 1024 ;++i)
+		g_assert(big[i] == 0);
+	g_assert_cmpuint(oio_arena_count_blocks(arena), ==, blocks + 1);
+
+	for (guint i = 0; i < G_N_ELEMENTS(ptrs) ;++i) {
+		for (gsize j = 0; j < 1 + (i % 50) ;++j)
+			g_assert(ptrs[i][j] == (i & 0xFF));
+	}
+
+	gchar *s = oio_arena_memdup0(arena, "plop", 4);
+	g_assert_cmpstr(s, ==, "plop");
+	oio_arena_destroy(arena);
+}
+
+static void
+test_message(void)
+{
+	static const gsize bodies[] = {0, 1, 127, 128, 256, 65536, 1024*1024};
+	for (guint i = 0; i < G_N_ELEMENTS(bodies) ;++i) {
+		MESSAGE m0 = _request(i * 5, bodies[i]);
+		MESSAGE m1 = _roundtrip(m0);
+
+		/* decoded messages stay mutable */
+		for (guint j = 0; j < 20 ;++j) {
+			gchar k[32];
+			g_snprintf(k, sizeof(k), "extra-%u", j);
+			metautils_message_add_field_str(m0, k, k);
+			metautils_message_add_field_str(m1, k, k);
+		}
+		metautils_message_set_NAME(m0, "REQ_OTHER", 9);
+		metautils_message_set_NAME(m1, "REQ_OTHER", 9);
+		MESSAGE m2 = _roundtrip(m1);
+		_check_same(m0, m2);
+
+		metautils_message_destroy(m2);
+		metautils_message_destroy(m1);
+		metautils_message_destroy(m0);
+	}
+}
+
+static void
+test_message_ber(void)
+{
+	MESSAGE m0 = _request(8, 512);
+	GByteArray *der = message_marshall_gba(m0, NULL);
+	g_assert(der != NULL);
+
+	/* An indefinite length is valid BER, but not DER: the message must
+	 * still be decoded, by asn1c. The outer length is short enough
+	 * to be written in 2 or 3 bytes. */
+	const guint8 *p = der->data + 4;
+	gsize skip = (p[1] & 0x80) ? 2 + (p[1] & 0x7F) : 2;
+	GByteArray *ber = g_byte_array_new();
+	guint8 hdr[] = {0, 0, 0, 0, 0x30, 0x80}, eoc[] = {0, 0};
+	g_byte_array_append(ber, hdr, sizeof(hdr));
+	g_byte_array_append(ber, p + skip, der->len - 4 - skip);
+	g_byte_array_append(ber, eoc, sizeof(eoc));
+	guint32 u32 = g_htonl(ber->len - 4);
+	memcpy(ber->data, &u32, 4);
+
+	GError *err = NULL;
+	MESSAGE m1 = message_unmarshall(ber->data, ber->len, &err);
+	g_assert_no_error(err);
+	_check_same(m0, m1);
+	metautils_message_destroy(m1);
+
+	/* Then a truncated message fails in both decoders */
+	u32 = g_htonl(der->len - 4 - 16);
+	memcpy(der->data, &u32, 4);
+	m1 = message_unmarshall(der->data, der->len - 16, &err);
+	g_assert(m1 == NULL);
+	g_assert(err != NULL);
+	g_clear_error(&err);
+
+	g_byte_array_unref(ber);
+	g_byte_array_unref(der);
+	metautils_message_destroy(m0);
+}
+
+static void
+test_bench(void)
+{
+	if (!g_test_perf())
+		return;
+
+	const guint rounds = 10000;
+	MESSAGE m = _request(12, 2048);
+	GByteArray *gba = message_marshall_gba(m, NULL);
+	metautils_message_destroy(m);
+
+	void _run(const char *tag, void (*decode) (void)) {
+		allocations = 0;
+		counting = TRUE;
+		gint64 pre = g_get_monotonic_time();
+		for (guint i = 0; i < rounds ;++i)
+			decode();
+		gint64 spent = g_get_monotonic_time() - pre;
+		counting = FALSE;
+		g_test_minimized_result(spent / (gdouble) rounds,
+				"%s: %.2f us/msg, %.1f allocations/msg", tag,
+				spent / (gdouble) rounds, allocations / (gdouble) rounds);
+	}
+
+	void _asn1c(void) {
+		Message_t *asn = NULL;
+		asn_codec_ctx_t ctx = {0};
+		ctx.max_stack_size = ASN1C_MAX_STACK;
+		asn_dec_rval_t rc = ber_decode(&ctx, &asn_DEF_Message, (void**)&asn,
+				gba->data + 4, gba->len - 4);
+		g_assert(rc.code == RC_OK);
+		ASN_STRUCT_FREE(asn_DEF_Message, asn);
+	}
+	void _arena(void) {
+		MESSAGE decoded = message_unmarshall(gba->data, gba->len, NULL);
+		g_assert(decoded != NULL);
+		metautils_message_destroy(decoded);
+	}
+
+	_run("asn1c", _asn1c);
+	_run("arena", _arena);
+	g_byte_array_unref(gba);
+}
+
+int
+main(int argc, char **argv)
+{
+	HC_TEST_INIT(argc,argv);
+	g_test_add_func("/metautils/arena/alloc", test_alloc);
+	g_test_add_func("/metautils/arena/message", test_message);
+	g_test_add_func("/metautils/arena/message/ber", test_message_ber);
+	g_test_add_func("/metautils/arena/bench", test_bench);
+	return g_test_run();
+}
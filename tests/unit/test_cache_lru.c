@@ -16,7 +16,10 @@ You should have received a copy of the GNU Lesser General Public
 License along with this library.
 */
 
+#include <unistd.h>
+
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <core/oio_core.h>
 #include <metautils/lib/lrutree.h>
 
@@ -59,6 +62,64 @@ test_cache_cycle_multilayer (void)
 	oio_cache_destroy (c);
 }
 
+static gchar *
+_shm_path (void)
+{
+	gchar *path = g_strdup_printf ("%s/test-cache-shm-%d-%"G_GINT64_FORMAT,
+			g_get_tmp_dir (), getpid (), g_get_monotonic_time ());
+	g_unlink (path);
+	return path;
+}
+
+static void
+test_cache_cycle_shm (void)
+{
+	gchar *path = _shm_path ();
+	struct oio_cache_s *c = oio_cache_make_shm (path, 64, 0);
+	g_assert_nonnull (c);
+	test_cache_cycle (c);
+	oio_cache_destroy (c);
+	g_unlink (path);
+	g_free (path);
+}
+
+static void
+test_cache_shm_shared (void)
+{
+	gchar *path = _shm_path ();
+	struct oio_cache_s *c0 = oio_cache_make_shm (path, 64, 0);
+	struct oio_cache_s *c1 = oio_cache_make_shm (path, 64, 0);
+	g_assert_nonnull (c0);
+	g_assert_nonnull (c1);
+
+	/* what is written through a handle is seen by the other */
+	g_assert_cmpint (OIO_CACHE_OK, ==, oio_cache_put (c0, "k", "v"));
+	test_found (c1, "k", "v");
+	g_assert_cmpint (OIO_CACHE_OK, ==, oio_cache_del (c1, "k"));
+	test_not_found (c0, "k");
+
+	/* too large, refused */
+	gchar *big = g_strnfill (1024, 'x');
+	g_assert_cmpint (OIO_CACHE_FAIL, ==, oio_cache_put (c0, "big", big));
+	g_free (big);
+
+	/* full, the oldest are evicted but the newest remain */
+	for (guint i = 0; i < 1024; ++i) {
+		gchar k[32];
+		g_snprintf (k, sizeof(k), "k%u", i);
+		g_assert_cmpint (OIO_CACHE_OK, ==, oio_cache_put (c0, k, k));
+	}
+	test_found (c1, "k1023", "k1023");
+
+	/* another geometry is refused */
+	g_assert_null (oio_cache_make_shm (path, 128, 0));
+
+	oio_cache_destroy (c0);
+	oio_cache_destroy (c1);
+	g_unlink (path);
+	g_free (path);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -66,6 +127,8 @@ main (int argc, char **argv)
 	g_test_add_func("/cache/cycle/noop", test_cache_cycle_noop);
 	g_test_add_func("/cache/cycle/lru", test_cache_cycle_lru);
 	g_test_add_func("/cache/cycle/multilayer", test_cache_cycle_multilayer);
+	g_test_add_func("/cache/cycle/shm", test_cache_cycle_shm);
+	g_test_add_func("/cache/shm/shared", test_cache_shm_shared);
 	return g_test_run();
 }
 
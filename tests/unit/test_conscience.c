@@ -0,0 +1,200 @@
+/*
+OpenIO SDS cluster
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <string.h>
+
+#include <metautils/lib/metautils.h>
+#include <cluster/conscience/conscience.h>
+#include <cluster/conscience/conscience_srvtype.h>
+#include <cluster/conscience/conscience_srv.h>
+
+#define NS "NS"
+#define SRVTYPE "rawx"
+#define NB_THREADS 4
+
+static struct service_info_s *
+_build_si(guint i)
+{
+	gchar url[64];
+	struct service_info_s *si = g_malloc0(sizeof(*si));
+	g_strlcpy(si->ns_name, NS, sizeof(si->ns_name));
+	g_strlcpy(si->type, SRVTYPE, sizeof(si->type));
+	g_snprintf(url, sizeof(url), "127.0.0.1:%u", 1024 + i);
+	g_assert(grid_string_to_addrinfo(url, &si->addr));
+	si->score.value = SCORE_UNSET;
+	si->tags = g_ptr_array_new();
+	service_tag_set_value_i64(service_info_ensure_tag(si->tags, "stat.cpu"), i);
+	return si;
+}
+
+static struct conscience_srvtype_s *
+_init_srvtype(struct conscience_s *cs, guint nb)
+{
+	struct conscience_srvtype_s *srvtype =
+		conscience_get_srvtype(cs, NULL, SRVTYPE, MODE_AUTOCREATE);
+	g_assert(srvtype != NULL);
+	conscience_srvtype_init(srvtype);
+	for (guint i = 0; i < nb ;++i) {
+		GError *err = NULL;
+		struct service_info_s *si = _build_si(i);
+		g_assert(conscience_srvtype_refresh(srvtype, &err, si, FALSE));
+		g_assert_no_error(err);
+		service_info_clean(si);
+	}
+	return srvtype;
+}
+
+static guint
+_count_fresh_ring(struct conscience_srvtype_s *srvtype)
+{
+	guint count = 0;
+	struct conscience_srv_s *beacon = &(srvtype->services_ring);
+	for (struct conscience_srv_s *srv = beacon->fresh_next;
+			srv != beacon; srv = srv->fresh_next) {
+		g_assert(srv->fresh_next->fresh_prev == srv);
+		count ++;
+	}
+	return count;
+}
+
+static gboolean
+_count_cb(struct conscience_srv_s *srv, gpointer u)
+{
+	(void) srv;
+	++ *((guint*)u);
+	return TRUE;
+}
+
+static void
+test_expire_incremental(void)
+{
+	const guint nb = 100, nb_fresh = 10;
+	struct conscience_s *cs = conscience_create_named(NS, NULL);
+	struct conscience_srvtype_s *srvtype = _init_srvtype(cs, nb);
+	g_assert_cmpuint(nb, ==, _count_fresh_ring(srvtype));
+
+	/* Age all the services, then refresh a few and lock another */
+	const time_t old = oio_ext_real_time () / G_TIME_SPAN_SECOND
+		- 2 * srvtype->score_expiration;
+	struct conscience_srv_s *beacon = &(srvtype->services_ring);
+	for (struct conscience_srv_s *srv = beacon->next; srv != beacon;
+			srv = srv->next)
+		srv->time_last_refresh = srv->score.timestamp = old;
+	for (guint i = 0; i < nb_fresh ;++i) {
+		struct service_info_s *si = _build_si(i);
+		g_assert(conscience_srvtype_refresh(srvtype, NULL, si, FALSE));
+		service_info_clean(si);
+	}
+	struct service_info_s *si = _build_si(nb - 1);
+	struct conscience_srv_s *locked =
+		conscience_srvtype_get_srv(srvtype, (struct conscience_srvid_s*)&(si->addr));
+	service_info_clean(si);
+	g_assert(locked != NULL);
+	locked->locked = TRUE;
+
+	/* The expiration runs by batches, it stops at the fresh services */
+	guint removed = 0;
+	g_assert_cmpint(32, ==, conscience_srvtype_remove_expired(srvtype, NULL,
+				32, _count_cb, &removed));
+	g_assert_cmpint(32, ==, conscience_srvtype_remove_expired(srvtype, NULL,
+				32, _count_cb, &removed));
+	g_assert_cmpint(25, ==, conscience_srvtype_remove_expired(srvtype, NULL,
+				32, _count_cb, &removed));
+	g_assert_cmpint(0, ==, conscience_srvtype_remove_expired(srvtype, NULL,
+				0, _count_cb, &removed));
+	g_assert_cmpuint(89, ==, removed);
+
+	g_assert_cmpuint(nb_fresh + 1, ==, conscience_srvtype_count_srv(srvtype, TRUE));
+	g_assert_cmpuint(nb_fresh + 1, ==, conscience_srvtype_count_srv(srvtype, FALSE));
+	g_assert_cmpuint(nb_fresh + 1, ==, _count_fresh_ring(srvtype));
+	/* The locked service has been rescheduled ahead */
+	g_assert(locked == beacon->fresh_next);
+
+	conscience_destroy(cs);
+}
+
+struct refresher_s
+{
+	struct conscience_s *cs;
+	guint first, nb, rounds;
+};
+
+static gpointer
+_refresher(struct refresher_s *r)
+{
+	for (guint round = 0; round < r->rounds ;++round) {
+		for (guint i = r->first; i < r->first + r->nb ;++i) {
+			struct service_info_s *si = _build_si(i);
+			struct conscience_srvtype_s *srvtype = conscience_get_locked_srvtype(
+					r->cs, NULL, SRVTYPE, MODE_STRICT, 'r');
+			g_assert(srvtype != NULL);
+			struct conscience_srv_s *srv =
+				conscience_srvtype_get_srv(srvtype, (struct conscience_srvid_s*)&(si->addr));
+			g_assert(srv != NULL);
+			g_mutex_lock(&(srv->lock));
+			g_assert(conscience_srvtype_refresh(srvtype, NULL, si, FALSE));
+			g_mutex_unlock(&(srv->lock));
+			conscience_release_locked_srvtype(srvtype);
+			service_info_clean(si);
+		}
+	}
+	return r;
+}
+
+static void
+test_refresh_concurrent(void)
+{
+	const guint nb = 64;
+	struct conscience_s *cs = conscience_create_named(NS, NULL);
+	struct conscience_srvtype_s *srvtype = _init_srvtype(cs, NB_THREADS * nb);
+
+	GThread *th[NB_THREADS];
+	struct refresher_s r[NB_THREADS];
+	for (guint i = 0; i < NB_THREADS ;++i) {
+		r[i].cs = cs;
+		r[i].first = i * nb;
+		r[i].nb = nb;
+		r[i].rounds = 100;
+		th[i] = g_thread_new("refresh", (GThreadFunc)_refresher, r + i);
+	}
+
+	/* The listings run meanwhile, under the reader lock too */
+	for (guint i = 0; i < 100 ;++i) {
+		guint count = 0;
+		gchar *types[] = {SRVTYPE, NULL};
+		g_assert(conscience_run_srvtypes(cs, NULL, SRVTYPE_FLAG_LOCK_ENABLE,
+					types, _count_cb, &count));
+		g_assert_cmpuint(NB_THREADS * nb, ==, count);
+	}
+
+	for (guint i = 0; i < NB_THREADS ;++i)
+		g_thread_join(th[i]);
+
+	g_assert_cmpuint(NB_THREADS * nb, ==, _count_fresh_ring(srvtype));
+	g_assert_cmpuint(NB_THREADS * nb, ==, conscience_srvtype_count_srv(srvtype, FALSE));
+	conscience_destroy(cs);
+}
+
+int
+main(int argc, char **argv)
+{
+	HC_TEST_INIT(argc,argv);
+	g_test_add_func("/cluster/conscience/expire", test_expire_incremental);
+	g_test_add_func("/cluster/conscience/refresh", test_refresh_concurrent);
+	return g_test_run();
+}
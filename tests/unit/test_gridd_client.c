@@ -20,6 +20,9 @@ License along with this library.
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 
 #include <metautils/lib/metautils.h>
 
@@ -153,6 +156,242 @@ test_loop_on_ignored_start_error(void)
 	test_on_urlv(bad_urls, test);
 }
 
+/* A minimal gridd service that replies OK to each request, counting the
+ * connections it accepts, and closing each one after its first reply when
+ * <close_after> is set. When <silent> is set, it never replies. Each
+ * connection is served by its own thread. */
+struct fake_server_s
+{
+	int fd;
+	gchar url[STRLEN_ADDRINFO];
+	gboolean close_after;
+	gboolean silent;
+	volatile gint accepted;
+	volatile gint closed;
+	GThread *th;
+	GPtrArray *workers;
+};
+
+struct fake_cnx_s
+{
+	struct fake_server_s *srv;
+	int fd;
+};
+
+static gboolean
+_read_full(int fd, guint8 *buf, gsize len)
+{
+	for (gsize total = 0; total < len ;) {
+		ssize_t r = read(fd, buf + total, len - total);
+		if (r <= 0)
+			return FALSE;
+		total += r;
+	}
+	return TRUE;
+}
+
+static gpointer
+_fake_server_serve(struct fake_cnx_s *fc)
+{
+	struct fake_server_s *srv = fc->srv;
+	const int cnx = fc->fd;
+	g_free(fc);
+
+	guint32 size = 0;
+	while (_read_full(cnx, (guint8*)&size, 4)) {
+		GByteArray *req = g_byte_array_sized_new(4 + g_ntohl(size));
+		g_byte_array_append(req, (guint8*)&size, 4);
+		g_byte_array_set_size(req, 4 + g_ntohl(size));
+		if (!_read_full(cnx, req->data + 4, req->len - 4)) {
+			g_byte_array_free(req, TRUE);
+			break;
+		}
+		MESSAGE request = message_unmarshall(req->data, req->len, NULL);
+		g_byte_array_free(req, TRUE);
+		g_assert(request != NULL);
+		if (srv->silent) {
+			metautils_message_destroy(request);
+			continue;
+		}
+		GByteArray *rep = message_marshall_gba_and_clean(
+				metaXServer_reply_simple(request, CODE_FINAL_OK, "OK"));
+		metautils_message_destroy(request);
+		ssize_t w = write(cnx, rep->data, rep->len);
+		g_assert_cmpint(w, ==, rep->len);
+		g_byte_array_free(rep, TRUE);
+		if (srv->close_after)
+			break;
+	}
+	close(cnx);
+	g_atomic_int_inc(&srv->closed);
+	return NULL;
+}
+
+static gpointer
+_fake_server_run(struct fake_server_s *srv)
+{
+	int cnx;
+	while (0 <= (cnx = accept(srv->fd, NULL, NULL))) {
+		g_atomic_int_inc(&srv->accepted);
+		struct fake_cnx_s *fc = g_malloc0(sizeof(*fc));
+		fc->srv = srv;
+		fc->fd = cnx;
+		g_ptr_array_add(srv->workers,
+				g_thread_new("cnx", (GThreadFunc)_fake_server_serve, fc));
+	}
+	return NULL;
+}
+
+static void
+_fake_server_start(struct fake_server_s *srv, gboolean close_after,
+		gboolean silent)
+{
+	struct sockaddr_in sin = {0};
+	socklen_t sinlen = sizeof(sin);
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	memset(srv, 0, sizeof(*srv));
+	srv->close_after = close_after;
+	srv->silent = silent;
+	srv->workers = g_ptr_array_new();
+	srv->fd = socket(AF_INET, SOCK_STREAM, 0);
+	g_assert(srv->fd >= 0);
+	g_assert(0 == bind(srv->fd, (struct sockaddr*)&sin, sizeof(sin)));
+	g_assert(0 == listen(srv->fd, 16));
+	g_assert(0 == getsockname(srv->fd, (struct sockaddr*)&sin, &sinlen));
+	g_snprintf(srv->url, sizeof(srv->url), "127.0.0.1:%u", ntohs(sin.sin_port));
+	srv->th = g_thread_new("fake", (GThreadFunc)_fake_server_run, srv);
+}
+
+static void
+_fake_server_stop(struct fake_server_s *srv)
+{
+	gridd_client_cnx_flush();
+	shutdown(srv->fd, SHUT_RDWR);
+	g_thread_join(srv->th);
+	close(srv->fd);
+	for (guint i = 0; i < srv->workers->len ;++i)
+		g_thread_join(srv->workers->pdata[i]);
+	g_ptr_array_free(srv->workers, TRUE);
+}
+
+static void
+_ping(struct fake_server_s *srv)
+{
+	GByteArray *req = message_marshall_gba_and_clean(
+			metautils_message_create_named("REQ_PING"));
+	struct gridd_client_s *client = gridd_client_create(srv->url, req, NULL, NULL);
+	g_assert(client != NULL);
+	GError *err = gridd_client_run(client);
+	g_assert_no_error(err);
+	gridd_client_free(client);
+	g_byte_array_unref(req);
+}
+
+static void
+test_cnx_reuse(void)
+{
+	struct fake_server_s srv;
+	struct gridd_client_cnx_stats_s before = {0}, after = {0};
+
+	_fake_server_start(&srv, FALSE, FALSE);
+	gridd_client_cnx_stats(&before);
+	for (guint i = 0; i < 16 ;++i)
+		_ping(&srv);
+	gridd_client_cnx_stats(&after);
+
+	g_assert_cmpint(g_atomic_int_get(&srv.accepted), ==, 1);
+	g_assert_cmpuint(after.connected - before.connected, ==, 1);
+	g_assert_cmpuint(after.reused - before.reused, ==, 15);
+	g_assert_cmpuint(after.idle, ==, 1);
+	_fake_server_stop(&srv);
+}
+
+static void
+test_cnx_dead(void)
+{
+	struct fake_server_s srv;
+	struct gridd_client_cnx_stats_s before = {0}, after = {0};
+
+	_fake_server_start(&srv, TRUE, FALSE);
+	gridd_client_cnx_stats(&before);
+	for (guint i = 0; i < 4 ;++i) {
+		_ping(&srv);
+		/* Closed by the service, the next request must not reuse it */
+		while (g_atomic_int_get(&srv.closed) <= (gint)i)
+			g_usleep(1000);
+	}
+	gridd_client_cnx_stats(&after);
+
+	g_assert_cmpint(g_atomic_int_get(&srv.accepted), ==, 4);
+	g_assert_cmpuint(after.connected - before.connected, ==, 4);
+	g_assert_cmpuint(after.reused - before.reused, ==, 0);
+	g_assert_cmpuint(after.dropped - before.dropped, ==, 3);
+	_fake_server_stop(&srv);
+}
+
+static void
+test_async_many(void)
+{
+	struct fake_server_s srv;
+	volatile gint done = 0, failed = 0;
+	const gint total = 64;
+
+	void _done(gpointer u, GError *err) {
+		(void) u;
+		if (err)
+			g_atomic_int_inc(&failed);
+		g_atomic_int_inc(&done);
+	}
+
+	_fake_server_start(&srv, FALSE, FALSE);
+	GByteArray *req = message_marshall_gba_and_clean(
+			metautils_message_create_named("REQ_PING"));
+
+	struct gridd_client_pool_s *pool = gridd_client_pool_shared();
+	for (gint i = 0; i < total ;++i)
+		gridd_client_pool_submit(pool, srv.url, req, 5.0, NULL, NULL, _done, NULL);
+	const gint64 deadline = oio_ext_monotonic_time() + 10 * G_TIME_SPAN_SECOND;
+	while (g_atomic_int_get(&done) < total
+			&& oio_ext_monotonic_time() < deadline)
+		g_usleep(1000);
+	g_assert_cmpint(g_atomic_int_get(&done), ==, total);
+	g_assert_cmpint(g_atomic_int_get(&failed), ==, 0);
+
+	/* The blocking variant, on several targets at once */
+	gchar *targets[] = {srv.url, srv.url, srv.url, srv.url, NULL};
+	GError *errv[4] = {NULL};
+	gridd_client_pool_exec_many(targets, req, 5.0, NULL, NULL, errv);
+	for (guint i = 0; i < 4 ;++i)
+		g_assert_no_error(errv[i]);
+
+	g_byte_array_unref(req);
+	_fake_server_stop(&srv);
+}
+
+static void
+test_async_timeout(void)
+{
+	struct fake_server_s srv;
+	_fake_server_start(&srv, FALSE, TRUE);
+	GByteArray *req = message_marshall_gba_and_clean(
+			metautils_message_create_named("REQ_PING"));
+
+	const gint64 start = oio_ext_monotonic_time();
+	GError *err = gridd_client_pool_exec(srv.url, req, 0.5, NULL, NULL);
+	g_assert(err != NULL);
+	g_assert_cmpint(err->code, ==, ERRCODE_READ_TIMEOUT);
+	/* expired on time, not at the next whole second */
+	const gint64 elapsed = oio_ext_monotonic_time() - start;
+	g_assert_cmpint(elapsed, >=, 500 * G_TIME_SPAN_MILLISECOND);
+	g_assert_cmpint(elapsed, <, 900 * G_TIME_SPAN_MILLISECOND);
+	g_clear_error(&err);
+
+	g_byte_array_unref(req);
+	_fake_server_stop(&srv);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -165,6 +404,14 @@ main(int argc, char **argv)
 			test_failed_start_on_ignored_connect_error);
 	g_test_add_func("/metautils/gridd_client/ignored_connect_loop",
 			test_loop_on_ignored_start_error);
+	g_test_add_func("/metautils/gridd_client/cnx/reuse",
+			test_cnx_reuse);
+	g_test_add_func("/metautils/gridd_client/cnx/dead",
+			test_cnx_dead);
+	g_test_add_func("/metautils/gridd_client/async/many",
+			test_async_many);
+	g_test_add_func("/metautils/gridd_client/async/timeout",
+			test_async_timeout);
 	return g_test_run();
 }
 
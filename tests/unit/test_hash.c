@@ -0,0 +1,115 @@
+/*
+OpenIO SDS core library
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <string.h>
+
+#include <glib.h>
+#include <core/oiohash.h>
+#include <metautils/lib/metautils.h>
+
+struct vector_s
+{
+	enum oio_hash_algo_e algo;
+	const char *input;
+	const char *hex;
+};
+
+static const struct vector_s vectors[] = {
+	{OIO_HASH_MD5, "", "D41D8CD98F00B204E9800998ECF8427E"},
+	{OIO_HASH_MD5, "abc", "900150983CD24FB0D6963F7D28E17F72"},
+	{OIO_HASH_SHA256, "abc",
+		"BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD"},
+	{OIO_HASH_XXH64, "", "EF46DB3751D8E999"},
+	{OIO_HASH_XXH64, "abc", "44BC2CF5AD770999"},
+	{OIO_HASH_XXH64, "Nobody inspects the spammish repetition", "FBCEA83C8A378BF1"},
+	{OIO_HASH_MAX, NULL, NULL}
+};
+
+static void
+test_vectors (void)
+{
+	for (const struct vector_s *v = vectors; v->input ;++v) {
+		gchar *hex = oio_hash_compute_for_data (v->algo, v->input, strlen(v->input));
+		g_assert_cmpstr (hex, ==, v->hex);
+		g_assert_cmpuint (strlen(hex), ==, 2 * oio_hash_algo_length (v->algo));
+		g_free (hex);
+	}
+}
+
+/* Whatever the way the data is cut, the digest is the same */
+static void
+test_streaming (void)
+{
+	guint8 buf[4096];
+	for (guint i=0; i<sizeof(buf) ;++i)
+		buf[i] = i * 7;
+
+	for (enum oio_hash_algo_e algo = 0; algo < OIO_HASH_MAX ;++algo) {
+		gchar *expected = oio_hash_compute_for_data (algo, buf, sizeof(buf));
+		for (gsize step = 1; step < 100 ;step += 3) {
+			struct oio_hash_s *h = oio_hash_new (algo);
+			for (gsize off = 0; off < sizeof(buf) ;off += step)
+				oio_hash_update (h, buf + off, MIN(step, sizeof(buf) - off));
+			g_assert_cmpstr (oio_hash_get_string (h), ==, expected);
+			oio_hash_free (h);
+		}
+		g_free (expected);
+	}
+}
+
+static void
+test_copy (void)
+{
+	for (enum oio_hash_algo_e algo = 0; algo < OIO_HASH_MAX ;++algo) {
+		struct oio_hash_s *h = oio_hash_new (algo);
+		oio_hash_update (h, "ab", 2);
+		struct oio_hash_s *copy = oio_hash_copy (h);
+		oio_hash_update (h, "c", 1);
+		oio_hash_update (copy, "c", 1);
+		g_assert_cmpstr (oio_hash_get_string (h), ==, oio_hash_get_string (copy));
+		oio_hash_free (h);
+		oio_hash_free (copy);
+	}
+}
+
+static void
+test_chunk_method (void)
+{
+	g_assert_cmpint (OIO_HASH_MD5, ==, oio_hash_algo_of_chunk_method (NULL));
+	g_assert_cmpint (OIO_HASH_MD5, ==, oio_hash_algo_of_chunk_method ("bytes"));
+	g_assert_cmpint (OIO_HASH_MD5, ==, oio_hash_algo_of_chunk_method ("plain/bytes"));
+	g_assert_cmpint (OIO_HASH_XXH64, ==,
+			oio_hash_algo_of_chunk_method ("plain/bytes?hash=xxh64"));
+	g_assert_cmpint (OIO_HASH_SHA256, ==,
+			oio_hash_algo_of_chunk_method ("plain/rain?algo=liber8tion&k=6&m=2&hash=sha256"));
+	g_assert_cmpint (OIO_HASH_MD5, ==,
+			oio_hash_algo_of_chunk_method ("plain/rain?algo=liber8tion&k=6&m=2"));
+	g_assert_cmpint (OIO_HASH_MD5, ==,
+			oio_hash_algo_of_chunk_method ("plain/bytes?hash=crc1"));
+}
+
+int
+main (int argc, char **argv)
+{
+	HC_TEST_INIT(argc,argv);
+	g_test_add_func("/core/hash/vectors", test_vectors);
+	g_test_add_func("/core/hash/streaming", test_streaming);
+	g_test_add_func("/core/hash/copy", test_copy);
+	g_test_add_func("/core/hash/chunk_method", test_chunk_method);
+	return g_test_run();
+}
@@ -0,0 +1,316 @@
+/*
+OpenIO SDS unit tests
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+
+#include <metautils/lib/metautils.h>
+#include <resolver/hc_resolver_internals.h>
+
+#include "../../resolver/hc_resolver.c"
+
+#define NS "NS"
+#define EPOCH (1400000000 * G_TIME_SPAN_SECOND)
+
+static volatile gint64 CLOCK = 0;
+
+static gint64 _get_monotonic (void) { return CLOCK; }
+static gint64 _get_real (void) { return EPOCH + CLOCK; }
+
+/* The fake meta0: two meta1, one holding the even prefixes, the other the
+ * odd ones. Moving <port> changes the mapping. */
+static guint fetches = 0;
+static gboolean fetch_fails = FALSE;
+static guint port = 6000;
+
+static struct meta0_info_s *
+_m0i (guint p, guint parity)
+{
+	struct meta0_info_s *m0i = g_malloc0 (sizeof (struct meta0_info_s));
+	gchar *str = g_strdup_printf ("127.0.0.1:%u", p);
+	g_assert (grid_string_to_addrinfo (str, &m0i->addr));
+	g_free (str);
+
+	m0i->prefixes_size = HC_RESOLVER_M1MAP_SLOTS;
+	m0i->prefixes = g_malloc0 (m0i->prefixes_size);
+	guint8 *d = m0i->prefixes;
+	for (guint i = 0; i < HC_RESOLVER_M1MAP_SLOTS ;++i) {
+		const guint16 idx = i;
+		if (idx % 2 == parity) {
+			memcpy (d, &idx, 2);
+			d += 2;
+		}
+	}
+	return m0i;
+}
+
+static GError *
+_fetch (struct hc_resolver_s *r, const char *ns, GSList **out)
+{
+	(void) r;
+	g_assert_cmpstr (ns, ==, NS);
+	++ fetches;
+	if (fetch_fails)
+		return NEWERROR (CODE_NETWORK_ERROR, "No META0 answered");
+	*out = g_slist_prepend (*out, _m0i (port, 0));
+	*out = g_slist_prepend (*out, _m0i (port + 1, 1));
+	return NULL;
+}
+
+static struct hc_resolver_s *
+_resolver (void)
+{
+	CLOCK = 1000 * G_TIME_SPAN_SECOND;
+	fetches = 0;
+	fetch_fails = FALSE;
+	port = 6000;
+
+	struct hc_resolver_s *r = hc_resolver_create1 (oio_ext_monotonic_seconds ());
+	r->m1map_fetch = _fetch;
+	return r;
+}
+
+static struct oio_url_s *
+_url (const char *ns, guint8 b0, guint8 b1)
+{
+	guint8 id[32] = {0};
+	id[0] = b0, id[1] = b1;
+	struct oio_url_s *u = oio_url_empty ();
+	oio_url_set (u, OIOURL_NS, ns);
+	oio_url_set_id (u, id);
+	return u;
+}
+
+/* The meta1 expected for the prefix of <u> */
+static gchar *
+_expected (struct oio_url_s *u)
+{
+	guint16 idx;
+	memcpy (&idx, oio_url_get_id (u), 2);
+	return g_strdup_printf ("1|%s|127.0.0.1:%u|", NAME_SRVTYPE_META1,
+			port + (idx % 2));
+}
+
+static void
+_check_lookup (struct hc_resolver_s *r, guint8 b0, guint8 b1)
+{
+	struct oio_url_s *u = _url (NS, b0, b1);
+	const char * const *m1v = _m1map_get (r, u);
+	g_assert (m1v != NULL);
+	g_assert_cmpuint (oio_strv_length (m1v), ==, 1);
+	gchar *expected = _expected (u);
+	g_assert_cmpstr (m1v[0], ==, expected);
+	g_free (expected);
+	oio_url_clean (u);
+}
+
+static void
+test_m1map_lookup (void)
+{
+	struct hc_resolver_s *r = _resolver ();
+
+	_check_lookup (r, 0x00, 0x00);
+	_check_lookup (r, 0x00, 0x01);
+	_check_lookup (r, 0x01, 0x00);
+	_check_lookup (r, 0xFF, 0xFF);
+	_check_lookup (r, 0x12, 0x34);
+	g_assert_cmpuint (fetches, ==, 1);
+
+	/* both sets are interned, all the prefixes are assigned */
+	struct hc_resolver_stats_s s = {0};
+	hc_resolver_info (r, &s);
+	g_assert_cmpuint (s.m1map.sets, ==, 2);
+	g_assert_cmpuint (s.m1map.assigned, ==, HC_RESOLVER_M1MAP_SLOTS);
+	g_assert_cmpint (s.m1map.loaded, ==, oio_ext_real_seconds ());
+
+	/* the map belongs to one namespace */
+	struct oio_url_s *u = _url ("OTHER", 0, 0);
+	g_assert (_m1map_get (r, u) == NULL);
+	oio_url_clean (u);
+
+	/* without cache, no map */
+	hc_resolver_configure (r, HC_RESOLVER_NOCACHE);
+	u = _url (NS, 0, 0);
+	g_assert (_m1map_get (r, u) == NULL);
+	oio_url_clean (u);
+	g_assert_cmpuint (fetches, ==, 1);
+
+	hc_resolver_destroy (r);
+}
+
+static void
+test_m1map_reload (void)
+{
+	struct hc_resolver_s *r = _resolver ();
+	_check_lookup (r, 0, 0);
+	struct hc_m1map_s *first = r->m1map;
+	g_assert (first != NULL);
+	g_assert_cmpuint (fetches, ==, 1);
+
+	/* a moved prefix asks for a reload, not before the period elapsed */
+	struct oio_url_s *u = _url (NS, 0, 0);
+	hc_decache_prefix (r, u);
+	oio_url_clean (u);
+	_check_lookup (r, 0, 0);
+	g_assert_cmpuint (fetches, ==, 1);
+
+	/* the same mapping keeps the same map */
+	CLOCK += HC_RESOLVER_M1MAP_PERIOD;
+	_check_lookup (r, 0, 0);
+	g_assert_cmpuint (fetches, ==, 2);
+	g_assert (r->m1map == first);
+	g_assert (r->m1map_retired == NULL);
+	g_assert_cmpint (r->m1map_stale, ==, 0);
+
+	/* a new mapping replaces it, the old map is kept for a while */
+	u = _url (NS, 0, 0);
+	hc_decache_prefix (r, u);
+	oio_url_clean (u);
+	CLOCK += HC_RESOLVER_M1MAP_PERIOD;
+	port = 7000;
+	_check_lookup (r, 0, 0);
+	_check_lookup (r, 0, 1);
+	g_assert_cmpuint (fetches, ==, 3);
+	g_assert (r->m1map != first);
+	g_assert_cmpuint (g_slist_length (r->m1map_retired), ==, 1);
+
+	hc_resolver_expire (r);
+	g_assert_cmpuint (g_slist_length (r->m1map_retired), ==, 1);
+	CLOCK += HC_RESOLVER_M1MAP_GRACE + 1;
+	hc_resolver_expire (r);
+	g_assert (r->m1map_retired == NULL);
+
+	/* a failed load keeps the current map */
+	u = _url (NS, 0, 0);
+	hc_decache_prefix (r, u);
+	oio_url_clean (u);
+	fetch_fails = TRUE;
+	port = 8000;
+	CLOCK += HC_RESOLVER_M1MAP_PERIOD;
+	u = _url (NS, 0, 0);
+	const char * const *m1v = _m1map_get (r, u);
+	oio_url_clean (u);
+	g_assert (m1v != NULL);
+	g_assert_cmpstr (m1v[0], ==, "1|" NAME_SRVTYPE_META1 "|127.0.0.1:7000|");
+	g_assert_cmpuint (fetches, ==, 4);
+	g_assert_cmpint (r->m1map_stale, ==, 1);
+
+	/* a flush drops the map, the next resolution loads a new one */
+	fetch_fails = FALSE;
+	hc_resolver_flush_csm0 (r);
+	g_assert (r->m1map == NULL);
+	_check_lookup (r, 0, 0);
+	g_assert_cmpuint (fetches, ==, 5);
+
+	hc_resolver_destroy (r);
+}
+
+static void
+test_m1map_decache (void)
+{
+	struct hc_resolver_s *r = _resolver ();
+	_check_lookup (r, 0, 0);
+	struct hc_m1map_s *first = r->m1map;
+	g_assert_cmpuint (fetches, ==, 1);
+
+	/* forgetting a reference, e.g. once deleted, keeps the map */
+	struct oio_url_s *u = _url (NS, 0, 0);
+	hc_decache_reference (r, u);
+	oio_url_clean (u);
+	g_assert_cmpint (r->m1map_stale, ==, 0);
+
+	CLOCK += HC_RESOLVER_M1MAP_PERIOD;
+	_check_lookup (r, 0, 0);
+	g_assert_cmpuint (fetches, ==, 1);
+	g_assert (r->m1map == first);
+
+	hc_resolver_destroy (r);
+}
+
+static void
+test_m1map_failure (void)
+{
+	struct hc_resolver_s *r = _resolver ();
+	fetch_fails = TRUE;
+
+	/* no map, the prefixes are resolved on their own, and the meta0 is
+	 * not queried again before the period */
+	struct oio_url_s *u = _url (NS, 0, 0);
+	g_assert (_m1map_get (r, u) == NULL);
+	g_assert (_m1map_get (r, u) == NULL);
+	oio_url_clean (u);
+	g_assert_cmpuint (fetches, ==, 1);
+	g_assert (!r->m1map_loading);
+
+	struct hc_resolver_stats_s s = {0};
+	hc_resolver_info (r, &s);
+	g_assert_cmpint (s.m1map.loaded, ==, 0);
+
+	fetch_fails = FALSE;
+	CLOCK += HC_RESOLVER_M1MAP_PERIOD;
+	_check_lookup (r, 0, 0);
+	g_assert_cmpuint (fetches, ==, 2);
+
+	hc_resolver_destroy (r);
+}
+
+static void
+test_m1map_expiry (void)
+{
+	struct hc_resolver_s *r = _resolver ();
+	r->csm0.ttl = 60;
+
+	_check_lookup (r, 0, 0);
+	const gint64 loaded = oio_ext_real_seconds ();
+	g_assert_cmpuint (fetches, ==, 1);
+
+	CLOCK += 30 * G_TIME_SPAN_SECOND;
+	hc_resolver_expire (r);
+	_check_lookup (r, 0, 0);
+	g_assert_cmpuint (fetches, ==, 1);
+
+	/* the status tells when the map was loaded, in wall-clock time */
+	struct hc_resolver_stats_s s = {0};
+	hc_resolver_info (r, &s);
+	g_assert_cmpint (s.m1map.loaded, ==, loaded);
+
+	CLOCK += 31 * G_TIME_SPAN_SECOND;
+	hc_resolver_expire (r);
+	g_assert_cmpint (r->m1map_stale, ==, 1);
+	_check_lookup (r, 0, 0);
+	g_assert_cmpuint (fetches, ==, 2);
+	g_assert_cmpint (r->m1map_stale, ==, 0);
+
+	hc_resolver_info (r, &s);
+	g_assert_cmpint (s.m1map.loaded, ==, loaded + 61);
+
+	hc_resolver_destroy (r);
+}
+
+int
+main (int argc, char **argv)
+{
+	HC_TEST_INIT(argc,argv);
+	oio_time_monotonic = _get_monotonic;
+	oio_time_real = _get_real;
+	g_test_add_func("/resolver/m1map/lookup", test_m1map_lookup);
+	g_test_add_func("/resolver/m1map/reload", test_m1map_reload);
+	g_test_add_func("/resolver/m1map/decache", test_m1map_decache);
+	g_test_add_func("/resolver/m1map/failure", test_m1map_failure);
+	g_test_add_func("/resolver/m1map/expiry", test_m1map_expiry);
+	return g_test_run();
+}
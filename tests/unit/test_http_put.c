@@ -0,0 +1,298 @@
+/*
+OpenIO SDS core library
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <glib.h>
+
+#include <core/oio_core.h>
+#include <core/http_put.h>
+
+#define BUFSIZE (64 * 1024)
+
+static guint8 zeroes[BUFSIZE];
+
+/* A stand-in for a rawx: it reads the PUT requests then replies "201",
+ * after <delay> microseconds. When <stall> is set, it never reads the body
+ * and never replies. Each connection is served by its own thread. */
+struct fake_rawx_s
+{
+	int fd;
+	gchar url[64];
+	gint64 delay;
+	gboolean stall;
+	volatile gint stopping;
+	GThread *th;
+	GPtrArray *workers;
+};
+
+struct fake_cnx_s
+{
+	struct fake_rawx_s *srv;
+	int fd;
+};
+
+static gint64
+_read_headers(int fd, gsize *extra)
+{
+	gchar buf[8192];
+	gsize len = 0;
+	gint64 clen = -1;
+
+	while (len < sizeof(buf) - 1) {
+		ssize_t r = read(fd, buf + len, sizeof(buf) - 1 - len);
+		if (r <= 0)
+			return -1;
+		len += r;
+		buf[len] = 0;
+		gchar *end = strstr(buf, "\r\n\r\n");
+		if (!end)
+			continue;
+		*extra = len - ((end + 4) - buf);
+		*end = 0;
+		gchar **lines = g_strsplit(buf, "\r\n", -1);
+		for (gchar **l = lines; *l ;++l) {
+			if (!g_ascii_strncasecmp(*l, "Content-Length:", 15))
+				clen = g_ascii_strtoll(*l + 15, NULL, 10);
+		}
+		g_strfreev(lines);
+		return clen;
+	}
+	return -1;
+}
+
+static gpointer
+_fake_rawx_serve(struct fake_cnx_s *fc)
+{
+	struct fake_rawx_s *srv = fc->srv;
+	const int cnx = fc->fd;
+	g_free(fc);
+
+	gsize extra = 0;
+	gint64 clen = _read_headers(cnx, &extra);
+
+	if (srv->stall) {
+		while (!g_atomic_int_get(&srv->stopping))
+			g_usleep(10 * G_TIME_SPAN_MILLISECOND);
+	} else if (clen >= 0) {
+		guint8 buf[BUFSIZE];
+		for (gint64 total = extra; total < clen ;) {
+			ssize_t r = read(cnx, buf, sizeof(buf));
+			if (r <= 0)
+				break;
+			total += r;
+		}
+		if (srv->delay > 0)
+			g_usleep(srv->delay);
+		static const char rep[] = "HTTP/1.1 201 Created\r\n"
+			"Content-Length: 0\r\nConnection: close\r\n\r\n";
+		ssize_t w = write(cnx, rep, sizeof(rep) - 1);
+		(void) w;
+	}
+	close(cnx);
+	return NULL;
+}
+
+static gpointer
+_fake_rawx_run(struct fake_rawx_s *srv)
+{
+	int cnx;
+	while (0 <= (cnx = accept(srv->fd, NULL, NULL))) {
+		struct fake_cnx_s *fc = g_malloc0(sizeof(*fc));
+		fc->srv = srv;
+		fc->fd = cnx;
+		g_ptr_array_add(srv->workers,
+				g_thread_new("cnx", (GThreadFunc)_fake_rawx_serve, fc));
+	}
+	return NULL;
+}
+
+static void
+_fake_rawx_start(struct fake_rawx_s *srv, gint64 delay, gboolean stall)
+{
+	struct sockaddr_in sin = {0};
+	socklen_t sinlen = sizeof(sin);
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	memset(srv, 0, sizeof(*srv));
+	srv->delay = delay;
+	srv->stall = stall;
+	srv->workers = g_ptr_array_new();
+	srv->fd = socket(AF_INET, SOCK_STREAM, 0);
+	g_assert(srv->fd >= 0);
+	g_assert(0 == bind(srv->fd, (struct sockaddr*)&sin, sizeof(sin)));
+	g_assert(0 == listen(srv->fd, 64));
+	g_assert(0 == getsockname(srv->fd, (struct sockaddr*)&sin, &sinlen));
+	g_snprintf(srv->url, sizeof(srv->url), "http://127.0.0.1:%u/chunk",
+			ntohs(sin.sin_port));
+	srv->th = g_thread_new("fake", (GThreadFunc)_fake_rawx_run, srv);
+}
+
+static void
+_fake_rawx_stop(struct fake_rawx_s *srv)
+{
+	g_atomic_int_set(&srv->stopping, 1);
+	shutdown(srv->fd, SHUT_RDWR);
+	g_thread_join(srv->th);
+	close(srv->fd);
+	for (guint i = 0; i < srv->workers->len ;++i)
+		g_thread_join(srv->workers->pdata[i]);
+	g_ptr_array_free(srv->workers, TRUE);
+}
+
+static void
+_feed(struct http_put_s *put, gsize size)
+{
+	for (gsize total = 0; total < size ;) {
+		gsize len = MIN(BUFSIZE, size - total);
+		http_put_feed(put, g_bytes_new_static(zeroes, len));
+		total += len;
+	}
+}
+
+static void
+_run(struct http_put_s *put)
+{
+	while (!http_put_done(put)) {
+		GError *err = http_put_step(put);
+		g_assert_no_error(err);
+	}
+}
+
+static void
+test_all_replicas(void)
+{
+	struct fake_rawx_s fast, slow;
+	_fake_rawx_start(&fast, 0, FALSE);
+	_fake_rawx_start(&slow, 200 * G_TIME_SPAN_MILLISECOND, FALSE);
+
+	const gsize size = 4 * 1024 * 1024;
+	struct http_put_s *put = http_put_create(size, size);
+	http_put_add_dest(put, fast.url, GINT_TO_POINTER(1));
+	http_put_add_dest(put, slow.url, GINT_TO_POINTER(2));
+	_feed(put, size);
+	_run(put);
+
+	/* Without quorum, the slow replica is waited for */
+	g_assert_cmpuint(0, ==, http_put_get_failure_number(put));
+	g_assert_cmpuint(201, ==, http_put_get_http_code(put, GINT_TO_POINTER(1)));
+	g_assert_cmpuint(201, ==, http_put_get_http_code(put, GINT_TO_POINTER(2)));
+	http_put_destroy(put);
+
+	_fake_rawx_stop(&fast);
+	_fake_rawx_stop(&slow);
+}
+
+static void
+test_quorum_straggler(void)
+{
+	struct fake_rawx_s fast0, fast1, stalled;
+	_fake_rawx_start(&fast0, 0, FALSE);
+	_fake_rawx_start(&fast1, 0, FALSE);
+	_fake_rawx_start(&stalled, 0, TRUE);
+
+	/* Far more than what the socket buffers of the stalled replica may
+	 * hold, so that it falls behind the window */
+	const gsize size = 64 * 1024 * 1024;
+	struct http_put_s *put = http_put_create(size, size);
+	http_put_set_quorum(put, 2, 100 * G_TIME_SPAN_MILLISECOND);
+	http_put_set_max_lag(put, 8);
+	http_put_add_dest(put, fast0.url, GINT_TO_POINTER(1));
+	http_put_add_dest(put, fast1.url, GINT_TO_POINTER(2));
+	http_put_add_dest(put, stalled.url, GINT_TO_POINTER(3));
+	_feed(put, size);
+	_run(put);
+
+	g_assert_cmpuint(1, ==, http_put_get_failure_number(put));
+	g_assert_cmpuint(1, ==, http_put_get_straggler_number(put));
+	g_assert_cmpuint(201, ==, http_put_get_http_code(put, GINT_TO_POINTER(1)));
+	g_assert_cmpuint(201, ==, http_put_get_http_code(put, GINT_TO_POINTER(2)));
+	g_assert_cmpuint(0, ==, http_put_get_http_code(put, GINT_TO_POINTER(3)));
+	g_assert_cmpuint(0, ==, http_put_queued_bytes(put));
+	http_put_destroy(put);
+
+	_fake_rawx_stop(&fast0);
+	_fake_rawx_stop(&fast1);
+	_fake_rawx_stop(&stalled);
+}
+
+static void
+test_parallel_throughput(void)
+{
+	const guint nb = 8;
+	const gsize size = 1024 * 1024;
+	struct fake_rawx_s srv;
+	_fake_rawx_start(&srv, 50 * G_TIME_SPAN_MILLISECOND, FALSE);
+
+	/* One upload after the other, as the metachunks used to be */
+	gint64 pre = g_get_monotonic_time();
+	for (guint i = 0; i < nb ;++i) {
+		struct http_put_s *put = http_put_create(size, size);
+		http_put_add_dest(put, srv.url, GINT_TO_POINTER(1));
+		_feed(put, size);
+		_run(put);
+		g_assert_cmpuint(0, ==, http_put_get_failure_number(put));
+		http_put_destroy(put);
+	}
+	gint64 sequential = g_get_monotonic_time() - pre;
+
+	/* All at once, in the same I/O loop */
+	pre = g_get_monotonic_time();
+	struct http_put_s *puts[nb + 1];
+	for (guint i = 0; i < nb ;++i) {
+		puts[i] = http_put_create_sibling(i ? puts[0] : NULL, size, size);
+		http_put_add_dest(puts[i], srv.url, GINT_TO_POINTER(1));
+		_feed(puts[i], size);
+	}
+	puts[nb] = NULL;
+	for (gboolean done = FALSE; !done ;) {
+		GError *err = http_put_step_many(puts);
+		g_assert_no_error(err);
+		done = TRUE;
+		for (guint i = 0; i < nb ;++i)
+			done &= http_put_done(puts[i]);
+	}
+	for (guint i = 0; i < nb ;++i) {
+		g_assert_cmpuint(0, ==, http_put_get_failure_number(puts[i]));
+		http_put_destroy(puts[i]);
+	}
+	gint64 parallel = g_get_monotonic_time() - pre;
+
+	g_test_message("%u x %"G_GSIZE_FORMAT" bytes: sequential %.1f MiB/s,"
+			" parallel %.1f MiB/s", nb, size,
+			(nb * size) / (sequential / (gdouble)G_TIME_SPAN_SECOND) / (1024*1024),
+			(nb * size) / (parallel / (gdouble)G_TIME_SPAN_SECOND) / (1024*1024));
+	g_assert_cmpint(parallel * 2, <, sequential);
+
+	_fake_rawx_stop(&srv);
+}
+
+int
+main(int argc, char **argv)
+{
+	HC_TEST_INIT(argc,argv);
+	g_test_add_func("/core/http_put/all_replicas", test_all_replicas);
+	g_test_add_func("/core/http_put/quorum", test_quorum_straggler);
+	g_test_add_func("/core/http_put/parallel", test_parallel_throughput);
+	return g_test_run();
+}
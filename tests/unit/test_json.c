@@ -0,0 +1,386 @@
+/*
+OpenIO SDS core library
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <string.h>
+
+#include <glib.h>
+#include <core/oiojson.h>
+#include <metautils/lib/metautils.h>
+
+struct escape_s
+{
+	const char *input;
+	const char *output;
+};
+
+static const struct escape_s escapes[] = {
+	{"", "\"\""},
+	{"plop", "\"plop\""},
+	{"a\"b", "\"a\\\"b\""},
+	{"a\\b", "\"a\\\\b\""},
+	{"\b\f\n\r\t", "\"\\b\\f\\n\\r\\t\""},
+	{"\x01\x1F", "\"\\u0001\\u001f\""},
+	{"\x7F/", "\"\x7F/\""},
+	{"\xC3\xA9t\xC3\xA9", "\"\xC3\xA9t\xC3\xA9\""},
+	/* the specials are in and across the 8-bytes words */
+	{"0123456\"89abcdef", "\"0123456\\\"89abcdef\""},
+	{"01234567\"9abcdef\\", "\"01234567\\\"9abcdef\\\\\""},
+	{"\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\n", "\"\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\\n\""},
+	{NULL, NULL}
+};
+
+static void
+test_escape (void)
+{
+	for (const struct escape_s *e = escapes; e->input ;++e) {
+		GString *g = g_string_new ("");
+		oio_json_append_string (g, e->input);
+		g_assert_cmpstr (g->str, ==, e->output);
+		g_string_free (g, TRUE);
+	}
+}
+
+/* Every byte, at every offset of a long string */
+static void
+test_escape_positions (void)
+{
+	for (guint c = 1; c < 256 ;++c) {
+		gchar buf[32];
+		for (guint pos = 0; pos < sizeof(buf) ;++pos) {
+			memset (buf, 'x', sizeof(buf));
+			buf[pos] = c;
+			GString *g = g_string_new ("");
+			oio_json_append_escaped (g, buf, sizeof(buf));
+			const gboolean special = c < 0x20 || c == '"' || c == '\\';
+			if (!special) {
+				g_assert_cmpuint (g->len, ==, sizeof(buf));
+				g_assert (!memcmp (g->str, buf, sizeof(buf)));
+			} else {
+				g_assert_cmpuint (g->len, >, sizeof(buf));
+				g_assert_cmpint (g->str[pos], ==, '\\');
+			}
+			g_string_free (g, TRUE);
+		}
+	}
+}
+
+static void
+test_null (void)
+{
+	GString *g = g_string_new ("");
+	oio_json_append_string (g, NULL);
+	g_string_append_c (g, ',');
+	oio_json_append_stringn (g, NULL, 4);
+	g_string_append_c (g, ',');
+	oio_json_append_hex (g, NULL, 4);
+	g_assert_cmpstr (g->str, ==, "null,null,null");
+	g_string_free (g, TRUE);
+}
+
+static void
+test_int (void)
+{
+	static const gint64 values[] = {
+		0, 1, -1, 9, 10, 99, 100, 101, 999, 1000, -1000, 123456789,
+		G_MAXINT32, G_MININT32, G_MAXINT64, G_MININT64, G_MAXINT64 - 1,
+		G_MININT64 + 1,
+	};
+	for (guint i=0; i<G_N_ELEMENTS(values) ;++i) {
+		GString *g = g_string_new ("");
+		oio_json_append_int (g, values[i]);
+		gchar *expected = g_strdup_printf ("%"G_GINT64_FORMAT, values[i]);
+		g_assert_cmpstr (g->str, ==, expected);
+		g_free (expected);
+		g_string_free (g, TRUE);
+	}
+	for (gint64 v = -100000; v < 100000 ;v += 7) {
+		GString *g = g_string_new ("");
+		oio_json_append_int (g, v);
+		gchar *expected = g_strdup_printf ("%"G_GINT64_FORMAT, v);
+		g_assert_cmpstr (g->str, ==, expected);
+		g_free (expected);
+		g_string_free (g, TRUE);
+	}
+}
+
+static void
+test_hex (void)
+{
+	guint8 bin[33];
+	for (guint i=0; i<sizeof(bin) ;++i)
+		bin[i] = i * 13;
+	for (gsize len = 0; len <= sizeof(bin) ;++len) {
+		gchar hex[2 * sizeof(bin) + 1];
+		oio_str_bin2hex (bin, len, hex, sizeof(hex));
+		gchar *expected = g_strdup_printf ("[\"%s\"]", hex);
+		GString *g = g_string_new ("[");
+		oio_json_append_hex (g, bin, len);
+		g_string_append_c (g, ']');
+		g_assert_cmpstr (g->str, ==, expected);
+		g_assert_cmpuint (g->len, ==, strlen (g->str));
+		g_free (expected);
+		g_string_free (g, TRUE);
+	}
+}
+
+/* The writer produces what the former printf() did, for ordinary values */
+static void
+test_compat (void)
+{
+	const gint64 size = 1234567, mtime = 1444444444;
+	GString *g = g_string_new ("{");
+	OIO_JSON_KEY(g, "name");
+	oio_json_append_string (g, "a/b.txt");
+	OIO_JSON_NEXT_KEY(g, "size");
+	oio_json_append_int (g, size);
+	OIO_JSON_NEXT_KEY(g, "deleted");
+	oio_json_append_bool (g, FALSE);
+	OIO_JSON_NEXT_KEY(g, "policy");
+	oio_json_append_string (g, NULL);
+	OIO_JSON_NEXT_KEY(g, "mtime");
+	oio_json_append_int (g, mtime);
+	g_string_append_c (g, '}');
+
+	gchar *expected = g_strdup_printf (
+			"{\"name\":\"%s\",\"size\":%"G_GINT64_FORMAT",\"deleted\":%s"
+			",\"policy\":null,\"mtime\":%"G_GINT64_FORMAT"}",
+			"a/b.txt", size, "false", mtime);
+	g_assert_cmpstr (g->str, ==, expected);
+	g_free (expected);
+	g_string_free (g, TRUE);
+}
+
+/* Streaming parser -------------------------------------------------------- */
+
+static GError *
+_trace_event (gpointer u, enum oio_json_event_e evt, enum oio_json_type_e type,
+		const gchar *text, gsize len)
+{
+	GString *trace = u;
+	g_string_append_printf (trace, "%d:%d:", evt, type);
+	if (text)
+		oio_json_append_escaped (trace, text, len);
+	g_string_append_c (trace, '|');
+	return NULL;
+}
+
+/* Feeds <in> by slices of <step> bytes, the trace of the events is kept in
+ * <trace>, that may be NULL */
+static gboolean
+_parse (const char *in, gsize len, gsize step, GString *trace)
+{
+	GString *t = trace ? trace : g_string_new ("");
+	struct oio_json_parser_s *p = oio_json_parser_create (_trace_event, t);
+	GError *err = NULL;
+	for (gsize off = 0; !err && off < len ;off += step)
+		err = oio_json_parser_feed (p, in + off, MIN(step, len - off));
+	if (!err)
+		err = oio_json_parser_end (p);
+	oio_json_parser_destroy (p);
+	if (!trace)
+		g_string_free (t, TRUE);
+	if (!err)
+		return TRUE;
+	g_assert_cmpint (err->code, ==, CODE_BAD_REQUEST);
+	g_clear_error (&err);
+	return FALSE;
+}
+
+static const char * const valid_docs[] = {
+	"0", "-0", "123", "1.5e+3", "-12.0E-1", "true", "null", "\"\"",
+	"[]", "{}", " [ ] ", "[1,2,{\"a\":[true,false,null]}]",
+	"{\"a\" : \"\\u00e9\\ud83d\\ude00\\n\\/\"}",
+	"{\"a\":{\"a\":{\"a\":{}}},\"b\":[[[]]]}",
+	NULL
+};
+
+static const char * const invalid_docs[] = {
+	"", " ", "01", "-", "+1", ".5", "1.", "1e", "1e+", "[1,]", "[,1]",
+	"{\"a\":1,}", "{1:2}", "{\"a\"}", "{\"a\" 1}", "[}", "{]", "[1 2]",
+	"\"abc", "tru", "nulll", "True", "\"\\x\"", "\"\\u12\"", "\"\\ud800\"",
+	"\"\\udc00\"", "\"\\ud800\\u0041\"", "\"a\nb\"", "[] []", "[", "]",
+	"{\"a\":1}}", "'a'", "[1]x",
+	NULL
+};
+
+static void
+test_parser_vectors (void)
+{
+	for (const char * const *pdoc = valid_docs; *pdoc ;++pdoc) {
+		const gsize len = strlen (*pdoc);
+		GString *expected = g_string_new ("");
+		g_assert (_parse (*pdoc, len, len + 1, expected));
+		/* the events do not depend on the way the input is cut */
+		for (gsize step = 1; step < len ;++step) {
+			GString *trace = g_string_new ("");
+			g_assert (_parse (*pdoc, len, step, trace));
+			g_assert_cmpstr (trace->str, ==, expected->str);
+			g_string_free (trace, TRUE);
+		}
+		g_string_free (expected, TRUE);
+	}
+	for (const char * const *pdoc = invalid_docs; *pdoc ;++pdoc) {
+		const gsize len = strlen (*pdoc);
+		for (gsize step = 1; step <= len + 1 ;++step)
+			g_assert (!_parse (*pdoc, len, step, NULL));
+	}
+}
+
+static void
+test_parser_values (void)
+{
+	GString *trace = g_string_new ("");
+	const char *doc = "{\"k\\\"\":[1,-2.5,\"\\u00e9\\t\",false]}";
+	g_assert (_parse (doc, strlen(doc), 3, trace));
+	g_assert_cmpstr (trace->str, ==,
+			"0:5:|2:4:k\\\"|0:6:|3:2:1|3:3:-2.5|3:4:\xC3\xA9\\t|3:1:false|1:6:|1:5:|");
+	g_string_free (trace, TRUE);
+}
+
+static void
+test_parser_depth (void)
+{
+	gchar doc[2 * (OIO_JSON_MAX_DEPTH + 1)];
+	for (guint depth = OIO_JSON_MAX_DEPTH; depth <= OIO_JSON_MAX_DEPTH + 1 ;++depth) {
+		memset (doc, '[', depth);
+		memset (doc + depth, ']', depth);
+		g_assert (BOOL(depth <= OIO_JSON_MAX_DEPTH) == _parse (doc, 2 * depth, 7, NULL));
+	}
+}
+
+/* Random documents made of JSON tokens, most are invalid. Whatever the
+ * input, the parser must neither crash nor depend on the slicing. */
+static void
+test_parser_fuzz (void)
+{
+	static const char * const tokens[] = {
+		"[", "]", "{", "}", ":", ",", "\"", "\"k\"", "\"\\", "\\u", "d83d",
+		"0", "-", "12", ".", "e", "+", "true", "fal", "null", " ", "\n",
+		"\x01", "\xC3\xA9",
+	};
+	GString *doc = g_string_new ("");
+	for (guint round = 0; round < 20000 ;++round) {
+		g_string_set_size (doc, 0);
+		const guint count = g_test_rand_int_range (0, 24);
+		for (guint i = 0; i < count ;++i)
+			g_string_append (doc,
+					tokens[g_test_rand_int_range (0, G_N_ELEMENTS(tokens))]);
+
+		GString *t0 = g_string_new (""), *t1 = g_string_new ("");
+		gboolean ok0 = _parse (doc->str, doc->len, doc->len + 1, t0);
+		gboolean ok1 = _parse (doc->str, doc->len,
+				g_test_rand_int_range (1, 5), t1);
+		g_assert (ok0 == ok1);
+		if (ok0)
+			g_assert_cmpstr (t0->str, ==, t1->str);
+		g_string_free (t0, TRUE);
+		g_string_free (t1, TRUE);
+	}
+	g_string_free (doc, TRUE);
+}
+
+/* Arrays of records ------------------------------------------------------- */
+
+static GError *
+_trace_record (gpointer u, const struct oio_json_record_s *r)
+{
+	GString *trace = u;
+	const gchar *a = NULL, *b = NULL;
+	struct oio_json_record_mapping_s m[] = {
+		{"a", &a, OIO_JSON_TYPE_INT,    1},
+		{"b", &b, OIO_JSON_TYPE_STRING, 0},
+		{NULL, NULL, 0, 0}
+	};
+	GError *err = oio_json_record_extract (r, m);
+	if (err) {
+		g_string_append_printf (trace, "[%s]", err->message);
+		g_clear_error (&err);
+	} else {
+		g_string_append_printf (trace, "%s/%s", a, b ? b : "-");
+	}
+	g_string_append_c (trace, '|');
+	return NULL;
+}
+
+static void
+test_records (void)
+{
+	const char *doc = "["
+		"{\"a\":1,\"b\":\"x\"},"
+		"{\"a\":2,\"a\":3,\"c\":{\"a\":[1,{}]},\"b\":null},"
+		"{\"a\":\"s\"},"
+		"[1,[2]],"
+		"5,"
+		"{},"
+		"{\"z\":[[],{\"a\":1}],\"a\":-7}"
+		"]";
+	const gsize len = strlen (doc);
+
+	for (gsize step = 1; step <= len ;++step) {
+		GString *trace = g_string_new ("");
+		struct oio_json_records_s *rr = oio_json_records_create (_trace_record, trace);
+		GError *err = NULL;
+		for (gsize off = 0; !err && off < len ;off += step)
+			err = oio_json_records_feed (rr, doc + off, MIN(step, len - off));
+		if (!err)
+			err = oio_json_records_end (rr);
+		g_assert_no_error (err);
+		oio_json_records_destroy (rr);
+		g_assert_cmpstr (trace->str, ==,
+				"1/x|3/-|[Invalid type for field [a]]|[Not an object]|"
+				"[Not an object]|[Missing field [a]]|-7/-|");
+		g_string_free (trace, TRUE);
+	}
+}
+
+static void
+test_records_not_array (void)
+{
+	static const char * const docs[] = { "{}", "1", "\"[\"", "[1", NULL };
+	for (const char * const *pdoc = docs; *pdoc ;++pdoc) {
+		GString *trace = g_string_new ("");
+		struct oio_json_records_s *rr = oio_json_records_create (_trace_record, trace);
+		GError *err = oio_json_records_feed (rr, *pdoc, strlen(*pdoc));
+		if (!err)
+			err = oio_json_records_end (rr);
+		g_assert (err != NULL);
+		g_assert_cmpint (err->code, ==, CODE_BAD_REQUEST);
+		g_clear_error (&err);
+		oio_json_records_destroy (rr);
+		g_string_free (trace, TRUE);
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	HC_TEST_INIT(argc,argv);
+	g_test_add_func("/core/json/escape", test_escape);
+	g_test_add_func("/core/json/escape_positions", test_escape_positions);
+	g_test_add_func("/core/json/null", test_null);
+	g_test_add_func("/core/json/int", test_int);
+	g_test_add_func("/core/json/hex", test_hex);
+	g_test_add_func("/core/json/compat", test_compat);
+	g_test_add_func("/core/json/parser/vectors", test_parser_vectors);
+	g_test_add_func("/core/json/parser/values", test_parser_values);
+	g_test_add_func("/core/json/parser/depth", test_parser_depth);
+	g_test_add_func("/core/json/parser/fuzz", test_parser_fuzz);
+	g_test_add_func("/core/json/records", test_records);
+	g_test_add_func("/core/json/records/not_array", test_records_not_array);
+	return g_test_run();
+}
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <meta2v2/meta2_backend_internals.h>
 #include <meta2v2/meta2v2_remote.h>
 #include <meta2v2/generic.h>
+#include <meta2v2/meta2_bean.h>
 #include <meta2v2/autogen.h>
 #include <resolver/hc_resolver.h>
 
@@ -145,7 +146,7 @@ check_list_count(struct meta2_backend_s *m2, struct oio_url_s *url,
 	struct list_params_s lp = {0};
 	lp.flag_allversion = ~0;
 
-	err = meta2_backend_list_aliases(m2, url, &lp, NULL, _count, NULL, NULL);
+	err = meta2_backend_list_aliases(m2, url, &lp, NULL, _count, NULL, NULL, NULL);
 	g_assert_no_error(err);
 	GRID_DEBUG("TEST list_aliases counter=%u expected=%u", counter, expected);
 	g_assert(counter == expected);
@@ -913,6 +914,309 @@ test_content_dedup (void)
 	_container_wraper_allversions("NS", test);
 }
 
+static void
+test_content_list_headers(void)
+{
+	void test(struct meta2_backend_s *m2, struct oio_url_s *url, gint64 maxver) {
+		(void) maxver;
+		GError *err;
+		GPtrArray *headers = g_ptr_array_new();
+
+		/* A few contents, some of them deleted, i.e. with several versions
+		 * sharing the same header when versioning is enabled */
+		for (guint i = 0; i < 7 ;++i) {
+			struct oio_url_s *u = oio_url_dup(url);
+			gchar path[32];
+			g_snprintf(path, sizeof(path), "content-%u", i);
+			oio_url_set(u, OIOURL_PATH, path);
+
+			CLOCK ++;
+			GSList *beans = _create_alias(m2, u, NULL);
+			err = meta2_backend_put_alias(m2, u, beans, NULL, NULL);
+			g_assert_no_error(err);
+			_bean_cleanl2(beans);
+			if (i % 3 == 0) {
+				CLOCK ++;
+				err = meta2_backend_delete_alias(m2, u, NULL, NULL);
+				g_assert_no_error(err);
+			}
+
+			GPtrArray *tmp = g_ptr_array_new();
+			err = meta2_backend_get_alias(m2, u, M2V2_FLAG_ALLVERSION,
+					_bean_buffer_cb, tmp);
+			if (err) {
+				g_clear_error(&err);
+			}
+			for (guint j = 0; j < tmp->len ;++j) {
+				if (DESCR(tmp->pdata[j]) == &descr_struct_CONTENTS_HEADERS) {
+					g_ptr_array_add(headers, tmp->pdata[j]);
+					tmp->pdata[j] = NULL;
+				}
+			}
+			_bean_cleanv2(tmp);
+			oio_url_pclean(&u);
+		}
+
+		gpointer _header_of(struct bean_ALIASES_s *alias) {
+			for (guint i = 0; i < headers->len ;++i) {
+				if (metautils_gba_equal(ALIASES_get_content(alias),
+							CONTENTS_HEADERS_get_id(headers->pdata[i])))
+					return headers->pdata[i];
+			}
+			return NULL;
+		}
+
+		void _check(gboolean allversion, gint64 maxkeys) {
+			GPtrArray *aliases = g_ptr_array_new();
+			GPtrArray *listed = g_ptr_array_new();
+			struct list_params_s lp = {0};
+			lp.flag_allversion = allversion;
+			lp.maxkeys = maxkeys;
+
+			err = meta2_backend_list_aliases(m2, url, &lp, NULL,
+					_bean_buffer_cb, NULL, aliases, NULL);
+			g_assert_no_error(err);
+			lp.flag_headers = 1;
+			err = meta2_backend_list_aliases(m2, url, &lp, NULL,
+					_bean_buffer_cb, NULL, listed, NULL);
+			g_assert_no_error(err);
+
+			/* Each alias comes right after its header, as it did when the
+			 * headers were loaded one by one */
+			guint j = 0;
+			for (guint i = 0; i < aliases->len ;++i) {
+				gpointer header = _header_of(aliases->pdata[i]);
+				g_assert(header != NULL);
+				g_assert_cmpuint(j + 2, <=, listed->len);
+				GString *s0 = _bean_debug(NULL, header);
+				GString *s1 = _bean_debug(NULL, listed->pdata[j++]);
+				g_assert_cmpstr(s0->str, ==, s1->str);
+				g_string_free(s0, TRUE);
+				g_string_free(s1, TRUE);
+				s0 = _bean_debug(NULL, aliases->pdata[i]);
+				s1 = _bean_debug(NULL, listed->pdata[j++]);
+				g_assert_cmpstr(s0->str, ==, s1->str);
+				g_string_free(s0, TRUE);
+				g_string_free(s1, TRUE);
+			}
+			g_assert_cmpuint(j, ==, listed->len);
+
+			_bean_cleanv2(listed);
+			_bean_cleanv2(aliases);
+		}
+
+		_check(FALSE, 0);
+		_check(TRUE, 0);
+		_check(FALSE, 3);
+		_check(TRUE, 3);
+		_bean_cleanv2(headers);
+	}
+	_container_wraper_allversions("NS", test);
+}
+
+static void
+test_content_list_delimiter(void)
+{
+	void test(struct meta2_backend_s *m2, struct oio_url_s *url, gint64 maxver) {
+		(void) maxver;
+		void _put(const gchar **names) {
+			for (const gchar **pn = names; *pn ;++pn) {
+				struct oio_url_s *u = oio_url_dup(url);
+				oio_url_set(u, OIOURL_PATH, *pn);
+				CLOCK ++;
+				GSList *beans = _create_alias(m2, u, NULL);
+				GError *err = meta2_backend_put_alias(m2, u, beans, NULL, NULL);
+				g_assert_no_error(err);
+				_bean_cleanl2(beans);
+				oio_url_pclean(&u);
+			}
+		}
+		static const gchar *names[] = {
+			"a/1", "a/2", "a/b/3", "a/b/4", "a0", "b", "c/1", "c/d/2", "d", NULL
+		};
+		_put(names);
+		gchar delimiter = '/';
+
+		/* The common prefixes are told apart with a trailing '*' */
+		void _check(const char *prefix, const char *marker, gint64 max,
+				const char *expected) {
+			GString *out = g_string_new("");
+			void _on_bean(gpointer u, gpointer bean) {
+				(void) u;
+				if (DESCR(bean) == &descr_struct_ALIASES)
+					g_string_append_printf(out, "%s%s", out->len ? "," : "",
+							ALIASES_get_alias(bean)->str);
+				_bean_clean(bean);
+			}
+			void _on_prefix(gpointer u, const gchar *p) {
+				(void) u;
+				g_string_append_printf(out, "%s%s*", out->len ? "," : "", p);
+			}
+			struct list_params_s lp = {0};
+			lp.delimiter = delimiter;
+			lp.prefix = prefix;
+			lp.marker_start = marker;
+			lp.maxkeys = max;
+			GError *err = meta2_backend_list_aliases(m2, url, &lp, NULL,
+					_on_bean, _on_prefix, NULL, NULL);
+			g_assert_no_error(err);
+			g_assert_cmpstr(out->str, ==, expected);
+			g_string_free(out, TRUE);
+		}
+
+		_check(NULL, NULL, 0, "a/*,a0,b,c/*,d");
+		_check("a/", NULL, 0, "a/1,a/2,a/b/*");
+		_check("a/b/", NULL, 0, "a/b/3,a/b/4");
+		_check("c", NULL, 0, "c/*");
+		_check(NULL, NULL, 2, "a/*,a0");
+		_check(NULL, "a0", 2, "b,c/*");
+		_check(NULL, "a/", 0, "a0,b,c/*,d");
+		_check(NULL, "a/2", 0, "a0,b,c/*,d");
+		_check("a/", "a/1", 2, "a/2,a/b/*");
+		_check("a/", "a/b/", 0, "");
+
+		/* Beyond a common prefix ending with a delimiter >= 0x7F, that
+		 * cannot be incremented, the next names must not be skipped */
+		static const gchar *others[] = {
+			"e\x7F" "1", "e\x7F" "2", "e\xC3\xA9", "f", NULL
+		};
+		_put(others);
+		delimiter = '\x7F';
+		_check("e", NULL, 0, "e\x7F*,e\xC3\xA9");
+		_check("e", "e\x7F" "1", 0, "e\xC3\xA9");
+		_check("e", NULL, 1, "e\x7F*");
+	}
+	_container_wraper_allversions("NS", test);
+}
+
+static void
+test_content_put_many(void)
+{
+	void test(struct meta2_backend_s *m2, struct oio_url_s *url, gint64 maxver) {
+		(void) maxver;
+		static const gchar *names[] = {"a", "b", "c", NULL};
+		GPtrArray *items = g_ptr_array_new_with_free_func(
+				(GDestroyNotify)meta2_batch_item_free);
+		for (const gchar **pn = names; *pn ;++pn) {
+			struct meta2_batch_item_s *item = g_malloc0(sizeof(*item));
+			item->url = oio_url_dup(url);
+			oio_url_set(item->url, OIOURL_PATH, *pn);
+			/* "b" comes without bean, it fails alone */
+			if (strcmp(*pn, "b"))
+				item->beans = _create_alias(m2, item->url, NULL);
+			g_ptr_array_add(items, item);
+		}
+
+		CLOCK ++;
+		GError *err = meta2_backend_put_aliases(m2, url, items);
+		g_assert_no_error(err);
+		for (guint i=0; i<items->len ;i++) {
+			struct meta2_batch_item_s *item = items->pdata[i];
+			if (i == 1) {
+				g_assert_error(item->err, GQ(), CODE_BAD_REQUEST);
+				g_assert_null(item->added);
+			} else {
+				g_assert_no_error(item->err);
+				g_assert_nonnull(item->added);
+			}
+		}
+		g_ptr_array_free(items, TRUE);
+		check_list_count(m2, url, 2);
+
+		/* Now delete them, "b" is still missing */
+		items = g_ptr_array_new_with_free_func(
+				(GDestroyNotify)meta2_batch_item_free);
+		for (const gchar **pn = names; *pn ;++pn) {
+			struct meta2_batch_item_s *item = g_malloc0(sizeof(*item));
+			item->url = oio_url_dup(url);
+			oio_url_set(item->url, OIOURL_PATH, *pn);
+			g_ptr_array_add(items, item);
+		}
+		CLOCK ++;
+		err = meta2_backend_delete_aliases(m2, url, items);
+		g_assert_no_error(err);
+		for (guint i=0; i<items->len ;i++) {
+			struct meta2_batch_item_s *item = items->pdata[i];
+			if (i == 1) {
+				g_assert_error(item->err, GQ(), CODE_CONTENT_NOTFOUND);
+			} else {
+				g_assert_no_error(item->err);
+				g_assert_nonnull(item->deleted);
+			}
+		}
+		g_ptr_array_free(items, TRUE);
+	}
+	_container_wraper_allversions("NS", test);
+}
+
+static void
+test_beans_marshall(void)
+{
+	/* around the boundaries of the INTEGER encodings */
+	static const gint64 values[] = {
+		0, 1, 127, 128, 255, 256, 32767, 32768, -1, -128, -129,
+		G_MAXINT32, G_MININT32, G_MAXINT64, G_MININT64
+	};
+	const guint max = G_N_ELEMENTS(values);
+	struct oio_url_s *url = oio_url_empty();
+	oio_url_set(url, OIOURL_PATH, "content");
+
+	GSList *beans = NULL;
+	for (guint i = 0; i < max ;++i) {
+		const gint64 v = values[i], w = values[max - 1 - i];
+
+		struct bean_ALIASES_s *a = _bean_create(&descr_struct_ALIASES);
+		ALIASES_set2_alias(a, "content");
+		ALIASES_set_version(a, v);
+		ALIASES_set2_content(a, (guint8*)"0123", 4);
+		ALIASES_set_deleted(a, i % 2);
+		ALIASES_set_ctime(a, w);
+		ALIASES_set_mtime(a, v);
+		beans = g_slist_prepend(beans, a);
+
+		struct bean_CONTENTS_HEADERS_s *h = _bean_create(&descr_struct_CONTENTS_HEADERS);
+		CONTENTS_HEADERS_set2_id(h, (guint8*)"0123", 4);
+		if (i % 2)
+			CONTENTS_HEADERS_set2_hash(h, (guint8*)"0123456789ABCDEF", 16);
+		CONTENTS_HEADERS_set_size(h, v);
+		CONTENTS_HEADERS_set_ctime(h, w);
+		CONTENTS_HEADERS_set_mtime(h, v);
+		CONTENTS_HEADERS_set2_chunk_method(h, "plain/nb_copy=3");
+		CONTENTS_HEADERS_set2_mime_type(h, "application/octet-stream");
+		if (i % 3)
+			CONTENTS_HEADERS_set2_policy(h, "THREECOPIES");
+		beans = g_slist_prepend(beans, h);
+
+		struct bean_CHUNKS_s *c = _bean_create(&descr_struct_CHUNKS);
+		CHUNKS_set2_id(c, "http://127.0.0.1:6000/0123456789ABCDEF");
+		CHUNKS_set2_hash(c, (guint8*)"0123456789ABCDEF", 16);
+		CHUNKS_set_size(c, w);
+		CHUNKS_set_ctime(c, v);
+		CHUNKS_set2_content(c, (guint8*)"0123", 4);
+		CHUNKS_set2_position(c, "0");
+		beans = g_slist_prepend(beans, c);
+
+		beans = g_slist_concat(_props_generate(url, v, 2), beans);
+	}
+
+	GByteArray *gba = bean_sequence_marshall(beans);
+	g_assert(gba != NULL);
+	GSList *decoded = g_slist_reverse(bean_sequence_unmarshall(gba->data, gba->len));
+	g_assert_cmpuint(g_slist_length(decoded), ==, g_slist_length(beans));
+	for (GSList *l0 = beans, *l1 = decoded; l0 && l1 ;l0 = l0->next, l1 = l1->next) {
+		GString *s0 = _bean_debug(NULL, l0->data);
+		GString *s1 = _bean_debug(NULL, l1->data);
+		g_assert_cmpstr(s0->str, ==, s1->str);
+		g_string_free(s0, TRUE);
+		g_string_free(s1, TRUE);
+	}
+
+	g_byte_array_unref(gba);
+	_bean_cleanl2(decoded);
+	_bean_cleanl2(beans);
+	oio_url_pclean(&url);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -922,6 +1226,8 @@ main(int argc, char **argv)
 	oio_time_real = _get_real;
 	container_counter = random();
 
+	g_test_add_func("/meta2v2/beans/marshall",
+			test_beans_marshall);
 	g_test_add_func("/meta2v2/backend/init_strange_ns",
 			test_backend_strange_ns);
 	g_test_add_func("/meta2v2/backend/create_destroy",
@@ -948,6 +1254,12 @@ main(int argc, char **argv)
 			test_content_append_not_found);
 	g_test_add_func("/meta2v2/backend/content/dedup",
 			test_content_dedup);
+	g_test_add_func("/meta2v2/backend/content/list_headers",
+			test_content_list_headers);
+	g_test_add_func("/meta2v2/backend/content/list_delimiter",
+			test_content_list_delimiter);
+	g_test_add_func("/meta2v2/backend/content/put_many",
+			test_content_put_many);
 
 	return g_test_run();
 }
@@ -0,0 +1,283 @@
+/*
+OpenIO SDS meta2v2
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* The beans decoded from a stream of records must be those decoded from a
+ * json-c tree, and the same inputs must be rejected. The inputs are random
+ * arrays of beans, some of them broken on purpose. */
+
+#include <string.h>
+#include <glib.h>
+
+#include <metautils/lib/metautils.h>
+#include <meta2v2/generic.h>
+#include <meta2v2/autogen.h>
+#include <meta2v2/meta2_utils_json.h>
+
+static const char * const wrong_values[] = {
+	"null", "true", "0", "-2.5", "1e3", "\"\"", "\"plop\"", "\"ABC\"",
+	"\"0123456789ABCDEF0123456789ABCDEF\"", "[]", "[1,\"a\"]", "{}",
+	"{\"type\":\"alias\"}",
+};
+
+static void
+_append_hex (GString *g, guint bytes)
+{
+	g_string_append_c (g, '"');
+	for (guint i = 0; i < bytes ;++i)
+		g_string_append_printf (g, "%02X", g_test_rand_int_range (0, 256));
+	g_string_append_c (g, '"');
+}
+
+static void
+_append_text (GString *g)
+{
+	static const char * const pieces[] = {
+		"a", "dir/", "content", "\"", "\\", "\t", "\xC3\xA9", " ", "0",
+	};
+	GString *s = g_string_new ("");
+	for (gint i = g_test_rand_int_range (1, 8); i > 0 ;--i)
+		g_string_append (s, pieces[g_test_rand_int_range (0, G_N_ELEMENTS(pieces))]);
+	oio_json_append_string (g, s->str);
+	g_string_free (s, TRUE);
+}
+
+static void
+_append_int (GString *g)
+{
+	oio_json_append_int (g, g_test_rand_int_range (-10, 1000000));
+}
+
+/* Appends one member, valid or not */
+static void
+_append_member (GString *g, const char *name, gboolean valid)
+{
+	oio_json_append_string (g, name);
+	g_string_append_c (g, ':');
+
+	if (!valid) {
+		g_string_append (g,
+				wrong_values[g_test_rand_int_range (0, G_N_ELEMENTS(wrong_values))]);
+	} else if (!strcmp (name, "type")) {
+		static const char * const types[] = {
+			"\"alias\"", "\"header\"", "\"chunk\"", "\"CHUNK\"", "\"bogus\"",
+		};
+		g_string_append (g, types[g_test_rand_int_range (0, G_N_ELEMENTS(types))]);
+	} else if (!strcmp (name, "header") || !strcmp (name, "content")) {
+		_append_hex (g, g_test_rand_int_range (0, 3) ? 8 : 0);
+	} else if (!strcmp (name, "hash")) {
+		_append_hex (g, g_test_rand_int_range (0, 5) ? 16 : 20);
+	} else if (!strcmp (name, "id")) {
+		if (g_test_rand_bit ())
+			_append_hex (g, 8);
+		else
+			_append_text (g);
+	} else if (!strcmp (name, "deleted")) {
+		oio_json_append_bool (g, g_test_rand_bit ());
+	} else if (!strcmp (name, "ver") || !strcmp (name, "size")
+			|| !strcmp (name, "ctime") || !strcmp (name, "mtime")) {
+		_append_int (g);
+	} else {
+		_append_text (g);
+	}
+}
+
+static void
+_append_bean (GString *g)
+{
+	static const char * const alias[] = {
+		"name", "ver", "header", "ctime", "mtime", "deleted", NULL
+	};
+	static const char * const header[] = {
+		"id", "hash", "size", "ctime", "mtime", "chunk-method", "mime-type", NULL
+	};
+	static const char * const chunk[] = {
+		"id", "hash", "size", "ctime", "content", "pos", NULL
+	};
+	static const char * const * const kinds[] = { alias, header, chunk };
+
+	switch (g_test_rand_int_range (0, 20)) {
+		case 0:
+			g_string_append (g, "42");
+			return;
+		case 1:
+			g_string_append (g, "[{\"type\":\"chunk\"}]");
+			return;
+	}
+
+	const char * const *names = kinds[g_test_rand_int_range (0, 3)];
+	const gint count = g_strv_length ((gchar**) names);
+	/* at most one member is broken, missing or duplicated */
+	const gint broken = g_test_rand_int_range (-count, count);
+	const gint missing = g_test_rand_int_range (-3 * count, count);
+	const gint twice = g_test_rand_int_range (-3 * count, count);
+
+	g_string_append_c (g, '{');
+	_append_member (g, "type", TRUE);
+	for (gint i = 0; i < count ;++i) {
+		if (i == missing)
+			continue;
+		g_string_append_c (g, ',');
+		_append_member (g, names[i], i != broken);
+		if (i == twice) {
+			g_string_append_c (g, ',');
+			_append_member (g, names[i], g_test_rand_bit ());
+		}
+	}
+	if (g_test_rand_bit ()) {
+		g_string_append (g, ",\"extra\":");
+		g_string_append (g,
+				wrong_values[g_test_rand_int_range (0, G_N_ELEMENTS(wrong_values))]);
+	}
+	g_string_append_c (g, '}');
+}
+
+/* The chunks without a ctime are stamped with the current time, that may
+ * change between both loadings */
+static gchar *
+_dump (GSList *beans)
+{
+	GString *g = g_string_new ("");
+	for (GSList *l = beans; l ;l = l->next) {
+		if (DESCR(l->data) == &descr_struct_CHUNKS
+				&& CHUNKS_get_ctime (l->data) > 1000000000)
+			CHUNKS_set_ctime (l->data, 0);
+		_bean_debug (g, l->data);
+		g_string_append_c (g, '\n');
+	}
+	return g_string_free (g, FALSE);
+}
+
+static GError *
+_load_tree (const char *doc, GSList **out)
+{
+	struct json_object *j = json_tokener_parse (doc);
+	if (!j)
+		return NEWERROR(CODE_BAD_REQUEST, "Invalid JSON");
+	GError *err = m2v2_json_load_setof_xbean (j, out);
+	json_object_put (j);
+	return err;
+}
+
+static GError *
+_load_stream (const char *doc, gsize step, GSList **out)
+{
+	const gsize len = strlen (doc);
+	struct m2v2_json_xbeans_parser_s *p = m2v2_json_xbeans_parser_create ();
+	GError *err = NULL;
+	for (gsize off = 0; !err && off < len ;off += step)
+		err = m2v2_json_xbeans_parser_feed (p, doc + off, MIN(step, len - off));
+	if (!err)
+		err = m2v2_json_xbeans_parser_end (p, out);
+	m2v2_json_xbeans_parser_destroy (p);
+	return err;
+}
+
+static void
+test_stream_vs_tree (void)
+{
+	guint accepted = 0;
+	for (guint round = 0; round < 2000 ;++round) {
+		GString *doc = g_string_new ("[");
+		for (gint i = g_test_rand_int_range (0, 6); i > 0 ;--i) {
+			if (doc->len > 1)
+				g_string_append_c (doc, ',');
+			_append_bean (doc);
+		}
+		g_string_append_c (doc, ']');
+
+		GSList *l0 = NULL, *l1 = NULL;
+		GError *e0 = _load_tree (doc->str, &l0);
+		GError *e1 = _load_stream (doc->str, g_test_rand_int_range (1, 64), &l1);
+		if (BOOL(e0) != BOOL(e1))
+			g_error ("Disagreement on [%s]: tree=%s stream=%s", doc->str,
+					e0 ? e0->message : "ok", e1 ? e1->message : "ok");
+
+		if (!e0) {
+			gchar *s0 = _dump (l0), *s1 = _dump (l1);
+			g_assert_cmpstr (s0, ==, s1);
+			g_free (s0);
+			g_free (s1);
+			++ accepted;
+		} else {
+			g_assert_cmpint (e1->code, ==, CODE_BAD_REQUEST);
+		}
+
+		g_clear_error (&e0);
+		g_clear_error (&e1);
+		_bean_cleanl2 (l0);
+		_bean_cleanl2 (l1);
+		g_string_free (doc, TRUE);
+	}
+	/* the generator must not only produce broken inputs */
+	g_assert_cmpuint (accepted, >, 0);
+}
+
+/* Whatever the bytes, no crash, no leak and a clear verdict */
+static void
+test_stream_garbage (void)
+{
+	GString *doc = g_string_new ("");
+	for (guint round = 0; round < 2000 ;++round) {
+		g_string_assign (doc, "[");
+		_append_bean (doc);
+		g_string_append_c (doc, ']');
+		for (gint i = g_test_rand_int_range (0, 4); i > 0 ;--i)
+			doc->str[g_test_rand_int_range (0, doc->len)] =
+				"[]{},:\"\\0a"[g_test_rand_int_range (0, 10)];
+		g_string_truncate (doc, g_test_rand_int_range (0, doc->len + 1));
+
+		GSList *l = NULL;
+		GError *err = _load_stream (doc->str, g_test_rand_int_range (1, 16), &l);
+		if (err)
+			g_assert_cmpint (err->code, ==, CODE_BAD_REQUEST);
+		g_clear_error (&err);
+		_bean_cleanl2 (l);
+	}
+	g_string_free (doc, TRUE);
+}
+
+static void
+test_stream_order (void)
+{
+	const char *doc = "["
+		"{\"type\":\"alias\",\"name\":\"a\",\"ver\":1,\"header\":\"00\"},"
+		"{\"type\":\"header\",\"id\":\"00\",\"hash\":\"0123456789ABCDEF0123456789ABCDEF\","
+			"\"size\":0,\"chunk-method\":\"plain/bytes\",\"mime-type\":\"o/o\"},"
+		"{\"type\":\"chunk\",\"id\":\"http://127.0.0.1:6000/0\",\"hash\":\"00\","
+			"\"size\":0,\"ctime\":1,\"content\":\"00\",\"pos\":\"0\"}"
+		"]";
+	GSList *beans = NULL;
+	GError *err = m2v2_json_parse_setof_xbean (doc, strlen(doc), &beans);
+	g_assert_no_error (err);
+	g_assert_cmpuint (g_slist_length (beans), ==, 3);
+	g_assert (DESCR(beans->data) == &descr_struct_ALIASES);
+	g_assert (DESCR(beans->next->data) == &descr_struct_CONTENTS_HEADERS);
+	g_assert (DESCR(beans->next->next->data) == &descr_struct_CHUNKS);
+	g_assert_cmpstr (ALIASES_get_alias (beans->data)->str, ==, "a");
+	_bean_cleanl2 (beans);
+}
+
+int
+main (int argc, char **argv)
+{
+	HC_TEST_INIT(argc,argv);
+	g_test_add_func("/meta2/json/stream/order", test_stream_order);
+	g_test_add_func("/meta2/json/stream/tree", test_stream_vs_tree);
+	g_test_add_func("/meta2/json/stream/garbage", test_stream_garbage);
+	return g_test_run();
+}
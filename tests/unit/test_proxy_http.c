@@ -0,0 +1,308 @@
+/*
+OpenIO SDS proxy
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include <glib.h>
+#include <metautils/lib/metautils.h>
+#include <proxy/http_parser.h>
+#include <proxy/path_parser.h>
+
+/* What the parser notified, one line per event. The body may come in
+ * several pieces, it is notified once the request is complete. */
+static GString *events = NULL;
+static GString *body = NULL;
+
+static void
+_on_command (const gchar *c, gsize cl, const gchar *u, gsize ul,
+		const gchar *v, gsize vl)
+{
+	g_string_append_printf (events, "CMD %.*s|%.*s|%.*s\n",
+			(int)cl, c, (int)ul, u, (int)vl, v);
+}
+
+static void
+_on_header (const gchar *n, gsize nl, const gchar *v, gsize vl)
+{
+	g_string_append_printf (events, "HDR %.*s|%.*s\n", (int)nl, n, (int)vl, v);
+}
+
+static void
+_on_body (const guint8 *d, gsize l)
+{
+	g_string_append_len (body, (const gchar*)d, l);
+}
+
+/* Feeds <in> by pieces of <step> bytes at most, and returns the number of
+ * requests parsed, or -1 at the first error. */
+static gint
+_parse (const gchar *in, gsize step)
+{
+	struct http_parser_s *p = http_parser_create ();
+	p->command_provider = _on_command;
+	p->header_provider = _on_header;
+	p->body_provider = _on_body;
+
+	gint count = 0;
+	const gsize len = strlen (in);
+	g_string_set_size (body, 0);
+	for (gsize off = 0; off < len ;) {
+		const gchar *piece = in + off;
+		const gsize piece_len = MIN(step, len - off);
+		off += piece_len;
+		for (gsize done = 0; done < piece_len ;) {
+			struct http_parsing_result_s rc = http_parse (p,
+					(const guint8*)piece + done, piece_len - done);
+			done += rc.consumed;
+			if (rc.status == HPRC_ERROR) {
+				http_parser_destroy (p);
+				return -1;
+			}
+			if (rc.status == HPRC_SUCCESS) {
+				if (body->len)
+					g_string_append_printf (events, "BODY %s\n", body->str);
+				g_string_append (events, "END\n");
+				g_string_set_size (body, 0);
+				http_parser_reset (p);
+				++ count;
+			}
+		}
+	}
+
+	http_parser_destroy (p);
+	return count;
+}
+
+static void
+test_http_simple (void)
+{
+	g_string_set_size (events, 0);
+	gint count = _parse ("PUT /v3.0/NS/content/create?acct=a&ref=r HTTP/1.1\r\n"
+			"Host: 127.0.0.1\r\n"
+			"content-length:3\r\n"
+			"X-oio-req-id:  plop \t\r\n"
+			"Empty:\r\n"
+			"\r\n"
+			"abc", 1000);
+	g_assert_cmpint (count, ==, 1);
+	g_assert_cmpstr (events->str, ==,
+			"CMD PUT|/v3.0/NS/content/create?acct=a&ref=r|HTTP/1.1\n"
+			"HDR Host|127.0.0.1\n"
+			"HDR content-length|3\n"
+			"HDR X-oio-req-id|plop\n"
+			"HDR Empty|\n"
+			"BODY abc\n"
+			"END\n");
+}
+
+static void
+test_http_pipelined (void)
+{
+	const char *in =
+		"GET /v3.0/NS/conscience/info HTTP/1.1\r\n"
+		"Connection: Keep-Alive\r\n"
+		"\r\n"
+		"POST /v3.0/NS/container/create HTTP/1.1\r\n"
+		"Content-Length: 2\r\n"
+		"\r\n"
+		"{}"
+		/* some clients add a CRLF after a body */
+		"\r\n"
+		"POST /v3.0/NS/container/destroy HTTP/1.1\r\n"
+		"Content-Length: 0\r\n"
+		"\r\n";
+
+	g_string_set_size (events, 0);
+	g_assert_cmpint (_parse (in, strlen(in)), ==, 3);
+	gchar *expected = g_strdup (events->str);
+
+	/* whatever the pieces, the same events */
+	for (gsize step = 1; step < strlen(in) ;++step) {
+		g_string_set_size (events, 0);
+		g_assert_cmpint (_parse (in, step), ==, 3);
+		g_assert_cmpstr (events->str, ==, expected);
+	}
+	g_free (expected);
+}
+
+static void
+test_http_errors (void)
+{
+	static const char * const bad[] = {
+		"GET\r\n\r\n",
+		"GET /\r\n\r\n",
+		"GET  HTTP/1.1\r\n\r\n",
+		"GET / \r\n\r\n",
+		" / HTTP/1.1\r\n\r\n",
+		"GET / HTTP/1.1\nHost: x\r\n\r\n",
+		"GET / HTTP/1.1\r\nHost\r\n\r\n",
+		"GET / HTTP/1.1\r\n: x\r\n\r\n",
+		"GET / HTTP/1.1\r\nHost : x\r\n\r\n",
+		"GET / HTTP/1.1\r\nA: b\r\n folded\r\n\r\n",
+		"GET / HTTP/1.1\r\nContent-Length: -1\r\n\r\n",
+		"GET / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n",
+		"GET / HTTP/1.1\r\nContent-Length:\r\n\r\n",
+		"GET / HTTP/1.1\r\nContent-Length: 1234567890123456789\r\n\r\n",
+		"GET / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\nab",
+		"GET / HTTP/1.1\r\nContent-Length: 1\r\ncontent-length: 1\r\n\r\na",
+		"GET / HTTP/1.1\r\nContent-Length: 1, 1\r\n\r\na",
+		"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n",
+		"POST / HTTP/1.1\r\nContent-Length: 5\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n",
+		"POST / HTTP/1.1\r\ntransfer-encoding: identity\r\n\r\n",
+		NULL
+	};
+	for (const char * const *p = bad; *p ;++p) {
+		g_string_set_size (events, 0);
+		g_assert_cmpint (_parse (*p, 1000), ==, -1);
+		g_string_set_size (events, 0);
+		g_assert_cmpint (_parse (*p, 1), ==, -1);
+	}
+
+	/* a head never ending */
+	GString *in = g_string_new ("GET / HTTP/1.1\r\n");
+	while (in->len <= HTTP_HEAD_MAXLEN)
+		g_string_append (in, "X-Plop: plop\r\n");
+	g_string_set_size (events, 0);
+	g_assert_cmpint (_parse (in->str, 4096), ==, -1);
+	g_string_set_size (events, 0);
+	g_assert_cmpint (_parse (in->str, in->len), ==, -1);
+	g_string_free (in, TRUE);
+}
+
+static void
+test_http_incomplete (void)
+{
+	g_string_set_size (events, 0);
+	g_assert_cmpint (_parse ("GET / HTTP/1.1\r\nHost: x\r\n", 7), ==, 0);
+	g_assert_cmpint (_parse ("POST / HTTP/1.1\r\nContent-Length: 4\r\n\r\nabc", 7), ==, 0);
+	g_assert_cmpint (_parse ("\r\n\r\n", 1), ==, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int h_info, h_show, h_create, h_any;
+
+static struct path_parser_s *
+_routes (void)
+{
+	struct path_parser_s *pp = path_parser_init ();
+	path_parser_configure (pp, "v3.0/$NS/conscience/info/#GET", &h_info);
+	path_parser_configure (pp, "v3.0/$NS/container/show/#GET", &h_show);
+	path_parser_configure (pp, "v3.0/$NS/container/create/#POST", &h_create);
+	path_parser_configure (pp, "v3.0/$NS/$ANY/$ACTION/#GET", &h_any);
+	return pp;
+}
+
+static void
+_check_match (struct path_parser_s *pp, const char *method, const char *path,
+		gpointer expected, const char *ns)
+{
+	struct path_matching_s **m = path_parser_match_request (pp, method, path);
+	g_assert (m != NULL);
+	if (!expected) {
+		g_assert (*m == NULL);
+	} else {
+		/* the wildcard route may match too */
+		struct path_matching_s **p = m;
+		while (*p && (*p)->last->u != expected)
+			++ p;
+		g_assert (*p != NULL);
+		g_assert_cmpstr (path_matching_get_variable (*p, "NS"), ==, ns);
+	}
+	path_matching_cleanv (m);
+}
+
+static void
+test_path_match (void)
+{
+	struct path_parser_s *pp = _routes ();
+	_check_match (pp, "GET", "/v3.0/NS/conscience/info", &h_info, "NS");
+	_check_match (pp, "GET", "///v3.0/NS/conscience/info/", &h_info, "NS");
+	_check_match (pp, "POST", "/v3.0/OPENIO/container/create", &h_create, "OPENIO");
+	_check_match (pp, "PO/ST", "/v3.0/OPENIO/container/create", &h_create, "OPENIO");
+	_check_match (pp, "DELETE", "/v3.0/NS/container/create", NULL, NULL);
+	_check_match (pp, "GET", "/v3.0/NS/container", NULL, NULL);
+	_check_match (pp, "GET", "/v3.0/NS/container/show/x", NULL, NULL);
+	_check_match (pp, "GET", "/v3.0//conscience/info", &h_info, "");
+	_check_match (pp, "GET", "", NULL, NULL);
+	_check_match (pp, "GET", "/", NULL, NULL);
+
+	/* the tokens are unescaped after the split */
+	_check_match (pp, "GET", "/v3.0/N%2fS/conscience/info", &h_info, "N/S");
+	_check_match (pp, "GET", "/v3.0/%4e%53/conscience/info", &h_info, "NS");
+	_check_match (pp, "GET", "/v3.0/NS/conscience/inf%6F", &h_info, "NS");
+	_check_match (pp, "GET", "/v3.0/NS/conscience/info%", NULL, NULL);
+	_check_match (pp, "GET", "/v3.0/NS/conscience/info%4", NULL, NULL);
+	_check_match (pp, "GET", "/v3.0/NS%zz/conscience/info", NULL, NULL);
+	_check_match (pp, "GET", "/v3.0/NS%00/conscience/info", NULL, NULL);
+
+	/* too long */
+	GString *path = g_string_new ("/v3.0/NS/conscience/info");
+	while (path->len <= PROXYD_PATH_MAXLEN)
+		g_string_prepend (path, "/");
+	_check_match (pp, "GET", path->str, NULL, NULL);
+	g_string_free (path, TRUE);
+
+	path_parser_clean (pp);
+}
+
+static void
+test_path_variables (void)
+{
+	struct path_parser_s *pp = _routes ();
+
+	/* both the explicit route and the wildcards match, the last
+	 * configured comes first */
+	struct path_matching_s **m = path_parser_match_request (pp,
+			"GET", "/v3.0/NS/container/show");
+	g_assert_cmpuint (g_strv_length ((gchar**)m), ==, 2);
+	g_assert (m[0]->last->u == &h_any);
+	g_assert (m[1]->last->u == &h_show);
+	for (struct path_matching_s **p = m; *p ;++p) {
+		g_assert_cmpstr (path_matching_get_variable (*p, "NS"), ==, "NS");
+		if ((*p)->last->u == &h_any) {
+			g_assert_cmpuint (g_strv_length ((*p)->vars), ==, 3);
+			g_assert_cmpstr ((*p)->vars[0], ==, "NS=NS");
+			g_assert_cmpstr ((*p)->vars[1], ==, "ANY=container");
+			g_assert_cmpstr ((*p)->vars[2], ==, "ACTION=show");
+		} else {
+			g_assert_cmpuint (g_strv_length ((*p)->vars), ==, 1);
+		}
+	}
+	path_matching_cleanv (m);
+
+	path_parser_clean (pp);
+}
+
+int
+main (int argc, char **argv)
+{
+	HC_TEST_INIT(argc,argv);
+	events = g_string_new ("");
+	body = g_string_new ("");
+	g_test_add_func("/proxy/http/simple", test_http_simple);
+	g_test_add_func("/proxy/http/pipelined", test_http_pipelined);
+	g_test_add_func("/proxy/http/errors", test_http_errors);
+	g_test_add_func("/proxy/http/incomplete", test_http_incomplete);
+	g_test_add_func("/proxy/path/match", test_path_match);
+	g_test_add_func("/proxy/path/variables", test_path_variables);
+	int rc = g_test_run();
+	g_string_free (events, TRUE);
+	g_string_free (body, TRUE);
+	return rc;
+}
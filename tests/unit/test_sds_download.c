@@ -0,0 +1,982 @@
+/*
+OpenIO SDS core library
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "../../core/sds.c"
+
+#define NS "NS"
+#define CHUNK_SIZE (64 * 1024)
+#define CONTENT_SIZE (2 * CHUNK_SIZE + 40000)
+
+static guint8 content[CONTENT_SIZE];
+
+/* A stand-in for both the proxy and the rawx. The proxy only knows how to
+ * show the content, made of the chunks of <chunks>. Each chunk is served
+ * after <delay> microseconds, honoring the Range header, unless it is
+ * lost. Each connection is served by its own thread. */
+struct fake_chunk_s
+{
+	gchar pos[16];
+	const guint8 *data;
+	gsize size;
+	gboolean lost;
+};
+
+struct fake_sds_s
+{
+	int fd;
+	guint port;
+	gchar proxy[32];
+	const char *chunk_method;
+	struct fake_chunk_s chunks[16];
+	guint nb_chunks;
+	gint64 delay;
+
+	volatile gint requests;
+	volatile gint running;
+	volatile gint max_running;
+	GThread *th;
+	GPtrArray *workers;
+};
+
+struct fake_cnx_s
+{
+	struct fake_sds_s *srv;
+	int fd;
+};
+
+static void
+_fake_add_chunk (struct fake_sds_s *srv, const char *pos,
+		const guint8 *data, gsize size)
+{
+	g_assert_cmpuint (srv->nb_chunks, <, G_N_ELEMENTS(srv->chunks));
+	struct fake_chunk_s *c = srv->chunks + (srv->nb_chunks ++);
+	g_strlcpy (c->pos, pos, sizeof(c->pos));
+	c->data = data;
+	c->size = size;
+	c->lost = FALSE;
+}
+
+/* Reads the head of a request, and returns its path and the bounds of its
+ * Range (-1 when absent) */
+static gboolean
+_read_request (int fd, gchar **path, gint64 *start, gint64 *end)
+{
+	gchar buf[8192];
+	gsize len = 0;
+
+	*start = *end = -1;
+	while (len < sizeof(buf) - 1) {
+		ssize_t r = read (fd, buf + len, sizeof(buf) - 1 - len);
+		if (r <= 0)
+			return FALSE;
+		len += r;
+		buf[len] = 0;
+		gchar *eoh = strstr (buf, "\r\n\r\n");
+		if (!eoh)
+			continue;
+		*eoh = 0;
+		gchar **lines = g_strsplit (buf, "\r\n", -1);
+		gchar **cmd = g_strsplit (lines[0], " ", 3);
+		if (g_strv_length (cmd) == 3)
+			*path = g_strdup (cmd[1]);
+		g_strfreev (cmd);
+		for (gchar **l = lines + 1; *l ;++l) {
+			if (!g_ascii_strncasecmp (*l, "Range: bytes=", 13)) {
+				gchar *p = *l + 13;
+				*start = g_ascii_strtoll (p, &p, 10);
+				if (*p == '-')
+					*end = g_ascii_strtoll (p + 1, NULL, 10);
+			}
+		}
+		g_strfreev (lines);
+		return *path != NULL;
+	}
+	return FALSE;
+}
+
+static void
+_reply (int fd, int code, const char *headers, const void *body, gsize len)
+{
+	gchar *head = g_strdup_printf ("HTTP/1.1 %d X\r\n"
+			"Content-Length: %"G_GSIZE_FORMAT"\r\n"
+			"Connection: close\r\n%s\r\n", code, len, headers ? headers : "");
+	ssize_t w = write (fd, head, strlen (head));
+	g_free (head);
+	for (gsize total = 0; w >= 0 && total < len ;) {
+		w = write (fd, (const guint8*)body + total, len - total);
+		if (w > 0)
+			total += w;
+	}
+}
+
+static void
+_serve_show (struct fake_sds_s *srv, int fd)
+{
+	GString *body = g_string_new ("[");
+	for (guint i = 0; i < srv->nb_chunks ;++i) {
+		if (i)
+			g_string_append_c (body, ',');
+		g_string_append_printf (body, "{\"url\":\"http://127.0.0.1:%u/chunk/%u\","
+				"\"pos\":\"%s\",\"size\":%"G_GSIZE_FORMAT","
+				"\"hash\":\"00000000000000000000000000000000\"}",
+				srv->port, i, srv->chunks[i].pos, srv->chunks[i].size);
+	}
+	g_string_append_c (body, ']');
+	gchar *headers = g_strdup_printf (
+			"X-oio-content-meta-chunk-method: %s\r\n", srv->chunk_method);
+	_reply (fd, 200, headers, body->str, body->len);
+	g_free (headers);
+	g_string_free (body, TRUE);
+}
+
+static void
+_serve_chunk (struct fake_sds_s *srv, int fd, guint i, gint64 start,
+		gint64 end)
+{
+	g_atomic_int_inc (&srv->requests);
+	gint running = g_atomic_int_add (&srv->running, 1) + 1;
+	for (gint max = g_atomic_int_get (&srv->max_running); running > max ;
+			max = g_atomic_int_get (&srv->max_running)) {
+		if (g_atomic_int_compare_and_exchange (&srv->max_running, max, running))
+			break;
+	}
+	if (srv->delay > 0)
+		g_usleep (srv->delay);
+
+	struct fake_chunk_s *c = i < srv->nb_chunks ? srv->chunks + i : NULL;
+	if (!c) {
+		_reply (fd, 404, NULL, NULL, 0);
+	} else if (c->lost) {
+		_reply (fd, 500, NULL, NULL, 0);
+	} else {
+		if (start < 0)
+			start = 0, end = c->size - 1;
+		end = MIN(end, (gint64)c->size - 1);
+		if (start > end)
+			_reply (fd, 416, NULL, NULL, 0);
+		else
+			_reply (fd, 206, NULL, c->data + start, end - start + 1);
+	}
+	g_atomic_int_add (&srv->running, -1);
+}
+
+static gpointer
+_fake_serve (struct fake_cnx_s *fc)
+{
+	struct fake_sds_s *srv = fc->srv;
+	const int cnx = fc->fd;
+	g_free (fc);
+
+	gchar *path = NULL;
+	gint64 start, end;
+	if (_read_request (cnx, &path, &start, &end)) {
+		if (g_str_has_prefix (path, "/chunk/"))
+			_serve_chunk (srv, cnx, atoi (path + 7), start, end);
+		else if (strstr (path, "/content/show?"))
+			_serve_show (srv, cnx);
+		else
+			_reply (cnx, 404, NULL, NULL, 0);
+	}
+	g_free (path);
+	close (cnx);
+	return NULL;
+}
+
+static gpointer
+_fake_run (struct fake_sds_s *srv)
+{
+	int cnx;
+	while (0 <= (cnx = accept (srv->fd, NULL, NULL))) {
+		struct fake_cnx_s *fc = g_malloc0 (sizeof(*fc));
+		fc->srv = srv;
+		fc->fd = cnx;
+		g_ptr_array_add (srv->workers,
+				g_thread_new ("cnx", (GThreadFunc)_fake_serve, fc));
+	}
+	return NULL;
+}
+
+/* The configuration only tells where the proxy is */
+struct fake_cfg_s
+{
+	struct oio_cfg_handle_vtable_s *vtable;
+	gchar *proxy;
+};
+
+static void
+_cfg_clean (struct oio_cfg_handle_s *self)
+{
+	g_free (((struct fake_cfg_s*)self)->proxy);
+	g_free (self);
+}
+
+static gchar **
+_cfg_namespaces (struct oio_cfg_handle_s *self)
+{
+	(void) self;
+	return g_strsplit (NS, ",", -1);
+}
+
+static gchar *
+_cfg_get (struct oio_cfg_handle_s *self, const char *ns, const char *k)
+{
+	if (!ns || !k || strcmp (ns, NS) || strcmp (k, OIO_CFG_PROXY))
+		return NULL;
+	return g_strdup (((struct fake_cfg_s*)self)->proxy);
+}
+
+static struct oio_cfg_handle_vtable_s vtable_cfg = {
+	_cfg_clean, _cfg_namespaces, _cfg_get
+};
+
+static struct oio_cfg_handle_s *cfg = NULL;
+
+static void
+_fake_start (struct fake_sds_s *srv, gint64 delay)
+{
+	struct sockaddr_in sin = {0};
+	socklen_t sinlen = sizeof(sin);
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	memset (srv, 0, sizeof(*srv));
+	srv->delay = delay;
+	srv->chunk_method = "plain/bytes";
+	srv->workers = g_ptr_array_new ();
+	srv->fd = socket (AF_INET, SOCK_STREAM, 0);
+	g_assert (srv->fd >= 0);
+	g_assert (0 == bind (srv->fd, (struct sockaddr*)&sin, sizeof(sin)));
+	g_assert (0 == listen (srv->fd, 64));
+	g_assert (0 == getsockname (srv->fd, (struct sockaddr*)&sin, &sinlen));
+	srv->port = ntohs (sin.sin_port);
+	g_snprintf (srv->proxy, sizeof(srv->proxy), "127.0.0.1:%u", srv->port);
+	srv->th = g_thread_new ("fake", (GThreadFunc)_fake_run, srv);
+
+	struct fake_cfg_s *c = g_malloc0 (sizeof(*c));
+	c->vtable = &vtable_cfg;
+	c->proxy = g_strdup (srv->proxy);
+	cfg = (struct oio_cfg_handle_s*) c;
+	oio_cfg_set_handle (cfg);
+}
+
+/* The content is replicated, one chunk per metachunk */
+static void
+_fake_start_replicated (struct fake_sds_s *srv, gint64 delay)
+{
+	_fake_start (srv, delay);
+	_fake_add_chunk (srv, "0", content, CHUNK_SIZE);
+	_fake_add_chunk (srv, "1", content + CHUNK_SIZE, CHUNK_SIZE);
+	_fake_add_chunk (srv, "2", content + 2 * CHUNK_SIZE,
+			CONTENT_SIZE - 2 * CHUNK_SIZE);
+}
+
+static void
+_fake_stop (struct fake_sds_s *srv)
+{
+	oio_cfg_set_handle (NULL);
+	oio_cfg_handle_clean (cfg);
+	cfg = NULL;
+
+	shutdown (srv->fd, SHUT_RDWR);
+	g_thread_join (srv->th);
+	close (srv->fd);
+	for (guint i = 0; i < srv->workers->len ;++i)
+		g_thread_join (srv->workers->pdata[i]);
+	g_ptr_array_free (srv->workers, TRUE);
+}
+
+static struct oio_sds_s *
+_sds (int parallelism, int readahead)
+{
+	struct oio_sds_s *sds = NULL;
+	g_assert_no_error ((GError*) oio_sds_init (&sds, NS));
+	g_assert_cmpint (0, ==, oio_sds_configure (sds,
+				OIOSDS_CFG_DOWNLOAD_PARALLELISM, &parallelism, sizeof(int)));
+	g_assert_cmpint (0, ==, oio_sds_configure (sds,
+				OIOSDS_CFG_READAHEAD, &readahead, sizeof(int)));
+	return sds;
+}
+
+static struct oio_url_s *
+_url (void)
+{
+	struct oio_url_s *url = oio_url_empty ();
+	oio_url_set (url, OIOURL_NS, NS);
+	oio_url_set (url, OIOURL_ACCOUNT, "ACCT");
+	oio_url_set (url, OIOURL_USER, "JFS");
+	oio_url_set (url, OIOURL_PATH, "plop");
+	return url;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void
+test_build_jobs (void)
+{
+	struct fake_sds_s srv;
+	_fake_start_replicated (&srv, 0);
+	struct oio_sds_s *sds = _sds (1, 0);
+	struct oio_url_s *url = _url ();
+
+	GSList *chunks = NULL;
+	struct metachunk_s **metachunks = NULL;
+	g_assert_no_error (_download_load (sds, url, &chunks, &metachunks));
+	g_assert_cmpuint (_metachunks_total_size (metachunks), ==, CONTENT_SIZE);
+
+	/* the ranges are cut at the boundaries of the metachunks, and their
+	 * data follow each other in the destination */
+	struct oio_sds_dl_range_s r0 = {100, CHUNK_SIZE};
+	struct oio_sds_dl_range_s r1 = {2 * CHUNK_SIZE + 10, 20};
+	struct oio_sds_dl_range_s r2 = {0, CONTENT_SIZE};
+	struct oio_sds_dl_range_s *ranges[] = {&r0, &r1, &r2, NULL};
+	GArray *jobs = _build_jobs (metachunks, ranges);
+	static const struct _dl_job_s expected[] = {
+		{{100, CHUNK_SIZE - 100}, 0},
+		{{CHUNK_SIZE, 100}, CHUNK_SIZE - 100},
+		{{2 * CHUNK_SIZE + 10, 20}, CHUNK_SIZE},
+		{{0, CHUNK_SIZE}, CHUNK_SIZE + 20},
+		{{CHUNK_SIZE, CHUNK_SIZE}, 2 * CHUNK_SIZE + 20},
+		{{2 * CHUNK_SIZE, CONTENT_SIZE - 2 * CHUNK_SIZE}, 3 * CHUNK_SIZE + 20},
+	};
+	g_assert_cmpuint (jobs->len, ==, G_N_ELEMENTS(expected));
+	for (guint i = 0; i < jobs->len ;++i) {
+		struct _dl_job_s *job = &g_array_index (jobs, struct _dl_job_s, i);
+		g_assert_cmpuint (job->range.offset, ==, expected[i].range.offset);
+		g_assert_cmpuint (job->range.size, ==, expected[i].range.size);
+		g_assert_cmpuint (job->out_offset, ==, expected[i].out_offset);
+	}
+	g_array_free (jobs, TRUE);
+
+	_metachunk_cleanv (metachunks);
+	g_slist_free_full (chunks, g_free);
+	oio_url_pclean (&url);
+	oio_sds_pfree (&sds);
+	_fake_stop (&srv);
+}
+
+/* Runs the jobs of the whole content, into a buffer */
+static GError *
+_run_all_jobs (struct oio_sds_s *sds, guint8 *out)
+{
+	struct oio_url_s *url = _url ();
+	GSList *chunks = NULL;
+	struct metachunk_s **metachunks = NULL;
+	g_assert_no_error (_download_load (sds, url, &chunks, &metachunks));
+
+	struct oio_sds_dl_range_s all = {0, CONTENT_SIZE};
+	struct oio_sds_dl_range_s *ranges[] = {&all, NULL};
+	struct _dl_jobs_s ctx = {
+		.sds = sds, .metachunks = metachunks,
+		.jobs = _build_jobs (metachunks, ranges),
+		.fd = -1, .base = out, .next = 0, .err = NULL,
+	};
+	g_mutex_init (&ctx.lock);
+	GError *err = _run_jobs (&ctx);
+	g_mutex_clear (&ctx.lock);
+	g_array_free (ctx.jobs, TRUE);
+
+	_metachunk_cleanv (metachunks);
+	g_slist_free_full (chunks, g_free);
+	oio_url_pclean (&url);
+	return err;
+}
+
+static void
+test_run_jobs (void)
+{
+	struct fake_sds_s srv;
+	_fake_start_replicated (&srv, 50 * G_TIME_SPAN_MILLISECOND);
+	guint8 *out = g_malloc0 (CONTENT_SIZE);
+
+	/* one job after the other */
+	struct oio_sds_s *sds = _sds (1, 0);
+	g_assert_no_error (_run_all_jobs (sds, out));
+	g_assert (0 == memcmp (out, content, CONTENT_SIZE));
+	g_assert_cmpint (g_atomic_int_get (&srv.max_running), ==, 1);
+	oio_sds_pfree (&sds);
+
+	/* all at once, no more threads than jobs */
+	memset (out, 0, CONTENT_SIZE);
+	sds = _sds (8, 0);
+	g_assert_no_error (_run_all_jobs (sds, out));
+	g_assert (0 == memcmp (out, content, CONTENT_SIZE));
+	g_assert_cmpint (g_atomic_int_get (&srv.max_running), >, 1);
+	g_assert_cmpint (g_atomic_int_get (&srv.max_running), <=, 3);
+
+	/* the first failure is reported, once all the threads are gone */
+	srv.chunks[1].lost = TRUE;
+	GError *err = _run_all_jobs (sds, out);
+	g_assert_nonnull (err);
+	g_clear_error (&err);
+	oio_sds_pfree (&sds);
+
+	g_free (out);
+	_fake_stop (&srv);
+}
+
+static void
+_check_positioned (int parallelism)
+{
+	struct fake_sds_s srv;
+	_fake_start_replicated (&srv, 0);
+	struct oio_sds_s *sds = _sds (parallelism, 0);
+	struct oio_url_s *url = _url ();
+	guint8 *out = g_malloc0 (CONTENT_SIZE);
+
+	/* no range, the buffer is filled */
+	size_t out_size = 0;
+	struct oio_sds_dl_src_s src = {.url = url, .ranges = NULL};
+	g_assert_no_error (_download_positioned (sds, &src, CONTENT_SIZE - 1,
+				-1, out, &out_size));
+	g_assert_cmpuint (out_size, ==, CONTENT_SIZE - 1);
+	g_assert (0 == memcmp (out, content, CONTENT_SIZE - 1));
+
+	/* several ranges, across the metachunks, end to end in the buffer */
+	struct oio_sds_dl_range_s r0 = {CHUNK_SIZE - 10, CHUNK_SIZE + 20};
+	struct oio_sds_dl_range_s r1 = {7, 3};
+	struct oio_sds_dl_range_s *ranges[] = {&r0, &r1, NULL};
+	memset (out, 0, CONTENT_SIZE);
+	struct oio_sds_dl_dst_s dst = {
+		.out_size = 0,
+		.type = OIO_DL_DST_BUFFER,
+		.data = { .buffer = {.ptr = out, .length = CONTENT_SIZE} },
+	};
+	src.ranges = ranges;
+	g_assert_no_error ((GError*) oio_sds_download (sds, &src, &dst));
+	g_assert_cmpuint (dst.out_size, ==, r0.size + r1.size);
+	g_assert (0 == memcmp (out, content + r0.offset, r0.size));
+	g_assert (0 == memcmp (out + r0.size, content + r1.offset, r1.size));
+
+	/* a range out of the content */
+	struct oio_sds_dl_range_s r2 = {CONTENT_SIZE, 1};
+	struct oio_sds_dl_range_s *bad[] = {&r2, NULL};
+	src.ranges = bad;
+	GError *err = (GError*) oio_sds_download (sds, &src, &dst);
+	g_assert_nonnull (err);
+	g_assert_cmpint (err->code, ==, CODE_BAD_REQUEST);
+	g_clear_error (&err);
+
+	/* the whole content into a file */
+	gchar *dir = g_dir_make_tmp ("oio-test-dl-XXXXXX", NULL);
+	g_assert_nonnull (dir);
+	gchar *path = g_build_filename (dir, "content", NULL);
+	g_assert_no_error ((GError*) oio_sds_download_to_file (sds, url, path));
+	gchar *data = NULL;
+	gsize len = 0;
+	g_assert (g_file_get_contents (path, &data, &len, NULL));
+	g_assert_cmpuint (len, ==, CONTENT_SIZE);
+	g_assert (0 == memcmp (data, content, CONTENT_SIZE));
+	g_free (data);
+	g_remove (path);
+	g_rmdir (dir);
+	g_free (path);
+	g_free (dir);
+
+	g_free (out);
+	oio_url_pclean (&url);
+	oio_sds_pfree (&sds);
+	_fake_stop (&srv);
+}
+
+static void
+test_positioned_sequential (void)
+{
+	_check_positioned (1);
+}
+
+static void
+test_positioned_parallel (void)
+{
+	_check_positioned (4);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void
+_check_reader (int readahead, gsize piece)
+{
+	struct fake_sds_s srv;
+	_fake_start_replicated (&srv, 0);
+	struct oio_sds_s *sds = _sds (1, readahead);
+	struct oio_url_s *url = _url ();
+
+	struct oio_sds_reader_s *r = NULL;
+	g_assert_no_error ((GError*) oio_sds_reader_open (sds, url, &r));
+	g_assert_cmpuint (oio_sds_reader_get_size (r), ==, CONTENT_SIZE);
+
+	guint8 *out = g_malloc0 (CONTENT_SIZE + piece);
+	gsize total = 0;
+	for (;;) {
+		size_t len = 0;
+		g_assert_no_error ((GError*) oio_sds_reader_read (r, out + total,
+					piece, &len));
+		if (!len)
+			break;
+		g_assert_cmpuint (len, <=, piece);
+		total += len;
+	}
+	g_assert_cmpuint (total, ==, CONTENT_SIZE);
+	g_assert (0 == memcmp (out, content, CONTENT_SIZE));
+
+	/* a positioned read does not move the position */
+	size_t len = 0;
+	g_assert_no_error ((GError*) oio_sds_reader_pread (r, out, 10,
+				CHUNK_SIZE - 5, &len));
+	g_assert_cmpuint (len, ==, 10);
+	g_assert (0 == memcmp (out, content + CHUNK_SIZE - 5, 10));
+	g_assert_no_error ((GError*) oio_sds_reader_read (r, out, piece, &len));
+	g_assert_cmpuint (len, ==, 0);
+
+	/* past the end */
+	g_assert_no_error ((GError*) oio_sds_reader_pread (r, out, 10,
+				CONTENT_SIZE, &len));
+	g_assert_cmpuint (len, ==, 0);
+	g_assert_no_error ((GError*) oio_sds_reader_pread (r, out, 10,
+				CONTENT_SIZE - 4, &len));
+	g_assert_cmpuint (len, ==, 4);
+
+	oio_sds_reader_close (r);
+	g_free (out);
+	oio_url_pclean (&url);
+	oio_sds_pfree (&sds);
+	_fake_stop (&srv);
+}
+
+static void
+test_reader_read (void)
+{
+	_check_reader (0, 10000);
+	_check_reader (0, CONTENT_SIZE);
+}
+
+static void
+test_reader_readahead (void)
+{
+	/* more, less and as much as a read */
+	_check_reader (30000, 10000);
+	_check_reader (7000, 10000);
+	_check_reader (10000, 10000);
+}
+
+/* The readahead is fetched while the caller works on the previous piece,
+ * the next read then sends no request. */
+static void
+test_reader_readahead_latency (void)
+{
+	const gint64 delay = 100 * G_TIME_SPAN_MILLISECOND;
+	const gsize piece = 16 * 1024;
+	struct fake_sds_s srv;
+	_fake_start_replicated (&srv, delay);
+	struct oio_url_s *url = _url ();
+	guint8 *buf = g_malloc (piece);
+
+	for (int readahead = 0; readahead <= (int)piece ; readahead += piece) {
+		struct oio_sds_s *sds = _sds (1, readahead);
+		struct oio_sds_reader_s *r = NULL;
+		g_assert_no_error ((GError*) oio_sds_reader_open (sds, url, &r));
+
+		size_t len = 0;
+		g_assert_no_error ((GError*) oio_sds_reader_read (r, buf, piece, &len));
+		g_assert_cmpuint (len, ==, piece);
+		if (readahead) {
+			g_assert_nonnull (r->ahead.data);
+			g_assert_cmpuint (r->ahead.offset, ==, piece);
+		}
+		_reader_ahead_join (r);
+
+		/* no readahead of the piece after, to count the requests of the
+		 * read alone */
+		sds->readahead = 0;
+		const gint before = g_atomic_int_get (&srv.requests);
+		gint64 pre = g_get_monotonic_time ();
+		g_assert_no_error ((GError*) oio_sds_reader_read (r, buf, piece, &len));
+		gint64 elapsed = g_get_monotonic_time () - pre;
+		g_assert_cmpuint (len, ==, piece);
+		g_assert (0 == memcmp (buf, content + piece, piece));
+		if (readahead) {
+			g_assert_cmpint (g_atomic_int_get (&srv.requests), ==, before);
+			g_assert_cmpint (elapsed, <, delay);
+		} else {
+			g_assert_cmpint (g_atomic_int_get (&srv.requests), ==, before + 1);
+			g_assert_cmpint (elapsed, >=, delay);
+		}
+
+		oio_sds_reader_close (r);
+		oio_sds_pfree (&sds);
+	}
+
+	g_free (buf);
+	oio_url_pclean (&url);
+	_fake_stop (&srv);
+}
+
+struct pread_ctx_s
+{
+	struct oio_sds_reader_s *r;
+	guint seed;
+};
+
+static gpointer
+_pread_worker (struct pread_ctx_s *ctx)
+{
+	GRand *rand = g_rand_new_with_seed (ctx->seed);
+	guint8 *buf = g_malloc (CHUNK_SIZE);
+	for (int i = 0; i < 16 ;++i) {
+		const gsize offset = g_rand_int_range (rand, 0, CONTENT_SIZE);
+		const gsize len = g_rand_int_range (rand, 1, CHUNK_SIZE);
+		size_t out_len = 0;
+		g_assert_no_error ((GError*) oio_sds_reader_pread (ctx->r, buf, len,
+					offset, &out_len));
+		g_assert_cmpuint (out_len, ==, MIN(len, CONTENT_SIZE - offset));
+		g_assert (0 == memcmp (buf, content + offset, out_len));
+	}
+	g_free (buf);
+	g_rand_free (rand);
+	return ctx;
+}
+
+static void
+test_reader_pread_concurrent (void)
+{
+	struct fake_sds_s srv;
+	_fake_start_replicated (&srv, 20 * G_TIME_SPAN_MILLISECOND);
+	struct oio_sds_s *sds = _sds (1, 8192);
+	struct oio_url_s *url = _url ();
+
+	struct oio_sds_reader_s *r = NULL;
+	g_assert_no_error ((GError*) oio_sds_reader_open (sds, url, &r));
+
+	/* a sequential read starts a readahead that runs meanwhile */
+	guint8 first[100];
+	size_t len = 0;
+	g_assert_no_error ((GError*) oio_sds_reader_read (r, first, sizeof(first), &len));
+	g_assert_cmpuint (len, ==, sizeof(first));
+
+	struct pread_ctx_s ctx[4];
+	GThread *th[4];
+	for (guint i = 0; i < G_N_ELEMENTS(th) ;++i) {
+		ctx[i].r = r;
+		ctx[i].seed = i + 1;
+		th[i] = g_thread_new ("pread", (GThreadFunc)_pread_worker, ctx + i);
+	}
+	for (guint i = 0; i < G_N_ELEMENTS(th) ;++i)
+		g_thread_join (th[i]);
+	g_assert_cmpint (g_atomic_int_get (&srv.max_running), >, 1);
+
+	/* the position did not move */
+	g_assert_no_error ((GError*) oio_sds_reader_read (r, first, sizeof(first), &len));
+	g_assert_cmpuint (len, ==, sizeof(first));
+	g_assert (0 == memcmp (first, content + sizeof(first), sizeof(first)));
+
+	oio_sds_reader_close (r);
+	oio_url_pclean (&url);
+	oio_sds_pfree (&sds);
+	_fake_stop (&srv);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void
+test_ec_params (void)
+{
+	struct ec_params_s params;
+	g_assert_no_error (_ec_params_load ("plain/rain?algo=liber8tion&k=6&m=2",
+				&params));
+	g_assert_cmpuint (params.k, ==, 6);
+	g_assert_cmpuint (params.m, ==, 2);
+	g_assert_cmpstr (params.algo, ==, "liber8tion");
+
+	static const char * const bad[] = {
+		"plain/rain",
+		"plain/rain?",
+		"plain/rain?algo=liber8tion&k=6",
+		"plain/rain?algo=liber8tion&m=2",
+		"plain/rain?algo=liber8tion&k=2&m=3",
+		"plain/rain?algo=liber8tion&k=0&m=0",
+		"plain/rain?algo=liber8tion&k=256&m=2",
+		"plain/rain?algo=liber8tion&k=x&m=2",
+		"plain/rain?k=6&m=2",
+		"plain/rain?algo=&k=6&m=2",
+		NULL
+	};
+	GError *err = _ec_params_load (NULL, &params);
+	g_assert_nonnull (err);
+	g_clear_error (&err);
+	for (const char * const *p = bad; *p ;++p) {
+		err = _ec_params_load (*p, &params);
+		g_assert_nonnull (err);
+		g_assert_cmpint (err->code, ==, CODE_BAD_REQUEST);
+		g_assert_cmpuint (params.k, ==, 0);
+		g_assert_cmpstr (params.algo, ==, "");
+		g_clear_error (&err);
+	}
+}
+
+#ifdef HAVE_LIBRAIN
+#define EC_K 4
+#define EC_M 2
+#define EC_METHOD "plain/rain?algo=liber8tion&k=4&m=2"
+
+static gsize
+_fragment_size (const struct rain_encoding_s *enc, gsize size, guint intra,
+		gboolean parity)
+{
+	struct chunk_s c;
+	memset (&c, 0, sizeof(c));
+	c.position.ec = 1;
+	c.position.parity = BOOL(parity);
+	c.position.intra = intra;
+	return _ec_fragment_size (enc, size, &c);
+}
+
+static void
+test_ec_fragment_size (void)
+{
+	struct ec_params_s params;
+	g_assert_no_error (_ec_params_load (EC_METHOD, &params));
+
+	static const gsize sizes[] = {1, 1000, 4096, CHUNK_SIZE, CONTENT_SIZE};
+	for (guint s = 0; s < G_N_ELEMENTS(sizes) ;++s) {
+		struct rain_encoding_s enc;
+		g_assert_no_error (_ec_encoding_init (&enc, sizes[s], &params));
+
+		/* the data fragments cover the stripe, only the last ones may
+		 * be short or empty */
+		gsize total = 0;
+		for (guint i = 0; i < EC_K ;++i) {
+			const gsize size = _fragment_size (&enc, sizes[s], i, FALSE);
+			g_assert_cmpuint (size, <=, enc.block_size);
+			if (size < (gsize)enc.block_size)
+				g_assert_cmpuint (total + size, ==, sizes[s]);
+			total += size;
+		}
+		g_assert_cmpuint (total, ==, sizes[s]);
+
+		/* the parity fragments are whole blocks */
+		for (guint i = 0; i < EC_M ;++i)
+			g_assert_cmpuint (_fragment_size (&enc, sizes[s], i, TRUE), ==,
+					enc.block_size);
+	}
+}
+
+/* The whole content is one EC metachunk, encoded as at the upload. The
+ * fragments are served from <data> and <coding>. */
+static void
+_fake_start_ec (struct fake_sds_s *srv, gint64 delay, guint8 **data,
+		guint8 ***coding)
+{
+	_fake_start (srv, delay);
+	srv->chunk_method = EC_METHOD;
+
+	struct ec_params_s params;
+	struct rain_encoding_s enc;
+	g_assert_no_error (_ec_params_load (EC_METHOD, &params));
+	g_assert_no_error (_ec_encoding_init (&enc, CONTENT_SIZE, &params));
+	*data = g_malloc0 (enc.data_size);
+	memcpy (*data, content, CONTENT_SIZE);
+	*coding = g_malloc0 (EC_M * sizeof(guint8*));
+	g_assert (rain_encode (*data, enc.data_size, &enc, &rain_env, *coding));
+
+	gchar pos[16];
+	for (guint i = 0; i < EC_K ;++i) {
+		g_snprintf (pos, sizeof(pos), "0.%u", i);
+		_fake_add_chunk (srv, pos, *data + (gsize)i * enc.block_size,
+				_fragment_size (&enc, CONTENT_SIZE, i, FALSE));
+	}
+	for (guint i = 0; i < EC_M ;++i) {
+		g_snprintf (pos, sizeof(pos), "0.p%u", i);
+		_fake_add_chunk (srv, pos, (*coding)[i], enc.block_size);
+	}
+}
+
+static void
+_fake_stop_ec (struct fake_sds_s *srv, guint8 *data, guint8 **coding)
+{
+	_fake_stop (srv);
+	for (guint i = 0; i < EC_M ;++i)
+		g_free (coding[i]);
+	g_free (coding);
+	g_free (data);
+}
+
+/* Downloads the whole content into a buffer, then checks it */
+static GError *
+_download_ec (struct oio_sds_s *sds)
+{
+	struct oio_url_s *url = _url ();
+	guint8 *out = g_malloc0 (CONTENT_SIZE);
+	struct oio_sds_dl_src_s src = {.url = url, .ranges = NULL};
+	struct oio_sds_dl_dst_s dst = {
+		.out_size = 0,
+		.type = OIO_DL_DST_BUFFER,
+		.data = { .buffer = {.ptr = out, .length = CONTENT_SIZE} },
+	};
+	GError *err = (GError*) oio_sds_download (sds, &src, &dst);
+	if (!err) {
+		g_assert_cmpuint (dst.out_size, ==, CONTENT_SIZE);
+		g_assert (0 == memcmp (out, content, CONTENT_SIZE));
+	}
+	g_free (out);
+	oio_url_pclean (&url);
+	return err;
+}
+
+static void
+test_ec_roundtrip (void)
+{
+	struct fake_sds_s srv;
+	guint8 *data = NULL, **coding = NULL;
+	_fake_start_ec (&srv, 0, &data, &coding);
+	struct oio_sds_s *sds = _sds (1, 0);
+
+	/* straight from the data fragments */
+	g_assert_no_error (_download_ec (sds));
+
+	/* a data fragment lost, the stripe is rebuilt */
+	srv.chunks[1].lost = TRUE;
+	g_assert_no_error (_download_ec (sds));
+
+	/* a range starting before the lost fragment */
+	struct oio_sds_reader_s *r = NULL;
+	struct oio_url_s *url = _url ();
+	g_assert_no_error ((GError*) oio_sds_reader_open (sds, url, &r));
+	guint8 buf[64];
+	size_t len = 0;
+	const gsize offset = srv.chunks[0].size - 10;
+	g_assert_no_error ((GError*) oio_sds_reader_pread (r, buf, sizeof(buf),
+				offset, &len));
+	g_assert_cmpuint (len, ==, sizeof(buf));
+	g_assert (0 == memcmp (buf, content + offset, sizeof(buf)));
+	oio_sds_reader_close (r);
+	oio_url_pclean (&url);
+
+	/* as many fragments lost as parity fragments */
+	srv.chunks[EC_K].lost = TRUE;
+	g_assert_no_error (_download_ec (sds));
+
+	/* one more */
+	srv.chunks[0].lost = TRUE;
+	GError *err = _download_ec (sds);
+	g_assert_nonnull (err);
+	g_clear_error (&err);
+
+	oio_sds_pfree (&sds);
+	_fake_stop_ec (&srv, data, coding);
+}
+
+/* The fragments are fetched by no more threads than the parallelism */
+static void
+test_ec_rebuild_parallelism (void)
+{
+	struct fake_sds_s srv;
+	guint8 *data = NULL, **coding = NULL;
+	_fake_start_ec (&srv, 50 * G_TIME_SPAN_MILLISECOND, &data, &coding);
+	srv.chunks[0].lost = TRUE;
+
+	for (int parallelism = 1; parallelism <= 3 ; parallelism += 2) {
+		struct oio_sds_s *sds = _sds (parallelism, 0);
+		g_atomic_int_set (&srv.max_running, 0);
+		g_assert_no_error (_download_ec (sds));
+		const gint max = g_atomic_int_get (&srv.max_running);
+		g_assert_cmpint (max, <=, parallelism);
+		if (parallelism > 1)
+			g_assert_cmpint (max, >, 1);
+		oio_sds_pfree (&sds);
+	}
+
+	_fake_stop_ec (&srv, data, coding);
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+static void
+test_batch_statuses (void)
+{
+	struct oio_error_s *errors[3] = {NULL, NULL, NULL};
+
+	GString *reply = g_string_new ("["
+			"{\"status\":200,\"message\":\"OK\"},"
+			"{\"status\":420,\"message\":\"Content not found\"},"
+			"{\"status\":500,\"message\":\"Failed\"}]");
+	GError *err = _batch_load_statuses (reply, 3, errors);
+	g_assert_no_error (err);
+	g_assert_null (errors[0]);
+	g_assert_cmpint (oio_error_code (errors[1]), ==, CODE_CONTENT_NOTFOUND);
+	g_assert_cmpint (oio_error_code (errors[2]), ==, 500);
+	for (guint i = 0; i < 3 ;++i)
+		oio_error_pfree (errors + i);
+	g_string_free (reply, TRUE);
+
+	/* a malformed status fails the whole batch, without any status left */
+	reply = g_string_new ("["
+			"{\"status\":500,\"message\":\"Failed\"},"
+			"{\"status\":500},"
+			"{\"status\":500,\"message\":\"Failed\"}]");
+	err = _batch_load_statuses (reply, 3, errors);
+	g_assert_nonnull (err);
+	g_clear_error (&err);
+	for (guint i = 0; i < 3 ;++i)
+		g_assert_null (errors[i]);
+	g_string_free (reply, TRUE);
+
+	/* so does a missing status */
+	reply = g_string_new ("[{\"status\":500,\"message\":\"Failed\"}]");
+	err = _batch_load_statuses (reply, 3, errors);
+	g_assert_nonnull (err);
+	g_clear_error (&err);
+	g_assert_null (errors[0]);
+	g_string_free (reply, TRUE);
+}
+
+int
+main (int argc, char **argv)
+{
+	HC_TEST_INIT(argc,argv);
+	oio_sds_no_shuffle = 1;
+	for (guint i = 0; i < CONTENT_SIZE ;++i)
+		content[i] = (i * 7 + i / 251) & 0xFF;
+	g_test_add_func("/core/sds/download/jobs/build", test_build_jobs);
+	g_test_add_func("/core/sds/download/jobs/run", test_run_jobs);
+	g_test_add_func("/core/sds/download/positioned/sequential",
+			test_positioned_sequential);
+	g_test_add_func("/core/sds/download/positioned/parallel",
+			test_positioned_parallel);
+	g_test_add_func("/core/sds/reader/read", test_reader_read);
+	g_test_add_func("/core/sds/reader/readahead", test_reader_readahead);
+	g_test_add_func("/core/sds/reader/readahead_latency",
+			test_reader_readahead_latency);
+	g_test_add_func("/core/sds/reader/pread", test_reader_pread_concurrent);
+	g_test_add_func("/core/sds/batch/statuses", test_batch_statuses);
+	g_test_add_func("/core/sds/ec/params", test_ec_params);
+#ifdef HAVE_LIBRAIN
+	g_test_add_func("/core/sds/ec/fragment_size", test_ec_fragment_size);
+	g_test_add_func("/core/sds/ec/roundtrip", test_ec_roundtrip);
+	g_test_add_func("/core/sds/ec/rebuild", test_ec_rebuild_parallelism);
+#endif
+	return g_test_run();
+}
@@ -0,0 +1,171 @@
+/*
+OpenIO SDS server
+Copyright (C) 2015 OpenIO, original work as part of OpenIO Software Defined Storage
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3.0 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.
+*/
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "metautils/lib/metautils.h"
+#include "metautils/lib/metacomm.h"
+#include "server/slab.h"
+#include <glib.h>
+
+static MESSAGE
+_reply (void)
+{
+	MESSAGE m = metautils_message_create_named ("REQ_TEST");
+	metautils_message_add_field_str (m, "MSG", "OK");
+	metautils_message_add_field_strint64 (m, "STATUS", 200);
+	return m;
+}
+
+static GByteArray *
+_random_body (gsize len)
+{
+	GByteArray *gba = g_byte_array_sized_new (len);
+	g_byte_array_set_size (gba, len);
+	for (gsize i = 0; i < len; ++i)
+		gba->data[i] = g_random_int_range (0, 256);
+	return gba;
+}
+
+static GByteArray *
+_encode_copy (GByteArray *body)
+{
+	MESSAGE m = _reply ();
+	metautils_message_add_body_unref (m, g_byte_array_ref (body));
+	return message_marshall_gba_and_clean (m);
+}
+
+static GByteArray *
+_encode_envelope (GByteArray *body)
+{
+	MESSAGE m = _reply ();
+	GError *err = NULL;
+	GByteArray *gba = message_marshall_gba_envelope (m, body->len, &err);
+	g_assert_no_error (err);
+	metautils_message_destroy (m);
+	g_byte_array_append (gba, body->data, body->len);
+	return gba;
+}
+
+static void
+test_envelope (void)
+{
+	static const gsize sizes[] = {
+		1, 127, 128, 255, 256, 65535, 65536, 1024*1024, 0
+	};
+	for (const gsize *ps = sizes; *ps; ++ps) {
+		GByteArray *body = _random_body (*ps);
+		GByteArray *copy = _encode_copy (body);
+		GByteArray *sg = _encode_envelope (body);
+
+		g_assert_cmpuint (copy->len, ==, sg->len);
+		g_assert (0 == memcmp (copy->data, sg->data, sg->len));
+
+		GError *err = NULL;
+		MESSAGE m = message_unmarshall (sg->data, sg->len, &err);
+		g_assert_no_error (err);
+		gsize blen = 0;
+		void *b = metautils_message_get_BODY (m, &blen);
+		g_assert_cmpuint (blen, ==, body->len);
+		g_assert (0 == memcmp (b, body->data, blen));
+		metautils_message_destroy (m);
+
+		g_byte_array_unref (sg);
+		g_byte_array_unref (copy);
+		g_byte_array_unref (body);
+	}
+}
+
+static void
+test_writev (void)
+{
+	int fd[2];
+	g_assert (0 == socketpair (AF_UNIX, SOCK_STREAM, 0, fd));
+
+	GByteArray *expected = g_byte_array_new ();
+	struct data_slab_sequence_s dss = {NULL, NULL};
+	/* More slabs than a single writev() may gather */
+	for (guint i = 0; i < 64; ++i) {
+		GByteArray *gba = _random_body (1 + g_random_int_range (0, 64));
+		g_byte_array_append (expected, gba->data, gba->len);
+		if (i % 2)
+			data_slab_sequence_append (&dss, data_slab_make_gba (gba));
+		else {
+			data_slab_sequence_append (&dss, data_slab_make_gba_ref (gba));
+			g_byte_array_unref (gba);
+		}
+	}
+
+	while (data_slab_sequence_has_data (&dss))
+		g_assert (data_slab_sequence_send (&dss, fd[0]));
+	data_slab_sequence_clean_data (&dss);
+	close (fd[0]);
+
+	GByteArray *got = g_byte_array_new ();
+	guint8 buf[1024];
+	for (;;) {
+		ssize_t r = read (fd[1], buf, sizeof(buf));
+		g_assert (r >= 0);
+		if (!r)
+			break;
+		g_byte_array_append (got, buf, r);
+	}
+	close (fd[1]);
+
+	g_assert_cmpuint (got->len, ==, expected->len);
+	g_assert (0 == memcmp (got->data, expected->data, got->len));
+	g_byte_array_unref (got);
+	g_byte_array_unref (expected);
+}
+
+static void
+test_bench (void)
+{
+	if (!g_test_perf ())
+		return;
+
+	const guint rounds = 256;
+	GByteArray *body = _random_body (4 * 1024 * 1024);
+
+	void _run (const char *tag, GByteArray* (*encode) (GByteArray*)) {
+		gint64 pre = g_get_monotonic_time ();
+		for (guint i = 0; i < rounds; ++i)
+			g_byte_array_unref (encode (body));
+		gint64 spent = g_get_monotonic_time () - pre;
+		g_test_minimized_result (spent / (gdouble) rounds,
+				"%s: %.1f us/reply", tag, spent / (gdouble) rounds);
+	}
+
+	/* The envelope path copies the body once here, only to mimic the send
+	 * that happens in the server. The server itself sends it in place. */
+	_run ("copy", _encode_copy);
+	_run ("envelope", _encode_envelope);
+	g_byte_array_unref (body);
+}
+
+int
+main (int argc, char **argv)
+{
+	HC_TEST_INIT(argc,argv);
+	g_test_add_func("/server/slab/envelope", test_envelope);
+	g_test_add_func("/server/slab/writev", test_writev);
+	g_test_add_func("/server/slab/bench", test_bench);
+	return g_test_run();
+}
@@ -103,12 +103,99 @@ test_init (void)
 		_round_init ();
 }
 
+static void
+_open_close(sqlx_cache_t *cache, const char *name)
+{
+	hashstr_t *hn = NULL;
+	HASHSTR_ALLOCA(hn, name);
+
+	gint id = -1;
+	GError *err = sqlx_cache_open_and_lock_base(cache, hn, &id);
+	g_assert_no_error (err);
+	if (!sqlx_cache_get_handle(cache, id))
+		sqlx_cache_set_handle(cache, id, GINT_TO_POINTER(1));
+	err = sqlx_cache_unlock_and_close_base(cache, id, FALSE);
+	g_assert_no_error (err);
+}
+
+static void
+test_scan (void)
+{
+	sqlx_cache_t *cache = sqlx_cache_init();
+	g_assert(cache != NULL);
+	sqlx_cache_set_close_hook(cache, sqlite_close);
+	sqlx_cache_set_max_bases(cache, 16);
+
+	/* A base used twice becomes protected */
+	_open_close(cache, name0);
+	_open_close(cache, name0);
+
+	/* ... and survives a scan through many bases used once */
+	for (guint i = 0; i < 100; ++i) {
+		gchar name[32];
+		g_snprintf(name, sizeof(name), "scan-%u", i);
+		_open_close(cache, name);
+	}
+
+	struct cache_counts_s c0 = sqlx_cache_count(cache);
+	_open_close(cache, name0);
+	struct cache_counts_s c1 = sqlx_cache_count(cache);
+
+	g_assert_cmpuint(c0.misses, ==, 101);
+	g_assert_cmpuint(c1.misses, ==, c0.misses);
+	g_assert_cmpuint(c1.hits, ==, c0.hits + 1);
+	g_assert_cmpuint(c1.hot, ==, 1);
+	g_assert_cmpuint(c0.evicted.rejected + c0.evicted.pressure, >, 0);
+
+	sqlx_cache_expire_all(cache);
+	sqlx_cache_clean(cache);
+}
+
+static gint64
+_fake_size (gpointer handle)
+{
+	(void) handle;
+	return 1000;
+}
+
+static void
+test_memory (void)
+{
+	sqlx_cache_t *cache = sqlx_cache_init();
+	g_assert(cache != NULL);
+	sqlx_cache_set_close_hook(cache, sqlite_close);
+	sqlx_cache_set_size_hook(cache, _fake_size);
+	sqlx_cache_set_max_memory(cache, 2500);
+
+	for (guint i = 0; i < 5; ++i) {
+		gchar name[32];
+		g_snprintf(name, sizeof(name), "mem-%u", i);
+		/* twice, so that the handle is known at the release */
+		_open_close(cache, name);
+		_open_close(cache, name);
+	}
+
+	struct cache_counts_s c = sqlx_cache_count(cache);
+	g_assert_cmpint(c.mem_used, >, 2500);
+
+	sqlx_cache_expire(cache, 0, G_TIME_SPAN_SECOND);
+	c = sqlx_cache_count(cache);
+	g_assert_cmpint(c.mem_used, <=, 2500);
+	g_assert_cmpuint(c.evicted.memory, >, 0);
+	g_assert_cmpuint(c.cold + c.hot, ==, 2);
+
+	sqlx_cache_expire_all(cache);
+	sqlx_cache_clean(cache);
+}
+
 int
 main(int argc, char ** argv)
 {
 	HC_TEST_INIT(argc, argv);
 	g_test_add_func("/sqliterepo/cache/init", test_init);
 	g_test_add_func("/sqliterepo/cache/lock", test_lock);
+	g_test_add_func("/sqliterepo/cache/scan", test_scan);
+	g_test_add_func("/sqliterepo/cache/memory", test_memory);
 	return g_test_run();
 }
 
@@ -19,6 +19,7 @@ License along with this library.
 
 #include <unistd.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <metautils/lib/metautils.h>
 
@@ -26,6 +27,9 @@ License along with this library.
 #include <sqliterepo/sqlx_remote.h>
 #include <sqliterepo/cache.h>
 #include <sqliterepo/internals.h>
+#include <sqliterepo/pagediff.h>
+#include <sqliterepo/sqlx_compress.h>
+#include <sqliterepo/restoration.h>
 
 #define SCHEMA \
 	"CREATE TABLE IF NOT EXISTS admin (k TEXT PRIMARY KEY, v NOT NULL);" \
@@ -41,6 +45,11 @@ static const gchar name[] =
 		"0123456789ABCDEF"
 		"0123456789ABCDEF"
 		"0123456789ABCDEF";
+static const gchar name_peer[] =
+		"FEDCBA9876543210"
+		"FEDCBA9876543210"
+		"FEDCBA9876543210"
+		"FEDCBA9876543210";
 
 static void
 _locator (gpointer u, const struct sqlx_name_s *n, GString *file_name)
@@ -130,12 +139,230 @@ test_open_close (void)
 		_round_open_close ();
 }
 
+static void
+_populate (struct sqlx_sqlite3_s *sq3, int first, int count)
+{
+	int rc = sqlite3_exec (sq3->db, "BEGIN", NULL, NULL, NULL);
+	g_assert_cmpint (rc, ==, SQLITE_OK);
+	for (int i=first; i<first+count ;i++) {
+		gchar *sql = g_strdup_printf (
+				"INSERT INTO content (path,size) VALUES ('%08d-%0128d',%d)",
+				i, i, i);
+		rc = sqlite3_exec (sq3->db, sql, NULL, NULL, NULL);
+		g_assert_cmpint (rc, ==, SQLITE_OK);
+		g_free (sql);
+	}
+	rc = sqlite3_exec (sq3->db, "COMMIT", NULL, NULL, NULL);
+	g_assert_cmpint (rc, ==, SQLITE_OK);
+}
+
+static gint64
+_count (struct sqlx_sqlite3_s *sq3)
+{
+	sqlite3_stmt *stmt = NULL;
+	int rc = sqlite3_prepare_v2 (sq3->db, "SELECT COUNT(*) FROM content", -1,
+			&stmt, NULL);
+	g_assert_cmpint (rc, ==, SQLITE_OK);
+	rc = sqlite3_step (stmt);
+	g_assert_cmpint (rc, ==, SQLITE_ROW);
+	gint64 count = sqlite3_column_int64 (stmt, 0);
+	sqlite3_finalize (stmt);
+	return count;
+}
+
+static void
+test_diff (void)
+{
+	sqlx_repository_t *repo = NULL;
+	struct sqlx_sqlite3_s *master = NULL, *slave = NULL;
+	struct restore_ctx_s *ctx = NULL;
+	GByteArray *sums = NULL, *full = NULL;
+	guint64 diff_bytes = 0;
+	GError *err;
+
+	GError *_apply (GByteArray *block, gint64 remaining, gpointer arg) {
+		(void) remaining, (void) arg;
+		diff_bytes += block->len;
+		GError *e = pagediff_apply (ctx->fd, block->data, block->len);
+		g_byte_array_free (block, TRUE);
+		return e;
+	}
+
+	err = sqlx_repository_init("/tmp", NULL, &repo);
+	g_assert_no_error (err);
+	err = sqlx_repository_configure_type(repo, type, SCHEMA);
+	g_assert_no_error (err);
+	sqlx_repository_set_locator (repo, _locator, NULL);
+
+	struct sqlx_name_s n0 = { .base = name, .type = type, .ns = nsname, };
+	struct sqlx_name_s n1 = { .base = name_peer, .type = type, .ns = nsname, };
+	err = sqlx_repository_open_and_lock(repo, &n0, SQLX_OPEN_LOCAL, &master, NULL);
+	g_assert_no_error (err);
+	err = sqlx_repository_open_and_lock(repo, &n1, SQLX_OPEN_LOCAL, &slave, NULL);
+	g_assert_no_error (err);
+
+	/* A slave far behind must be resync'ed with a full dump */
+	err = restore_ctx_create ("/tmp/test-sqliterepo-diff.XXXXXX", &ctx);
+	g_assert_no_error (err);
+	err = sqlx_repository_dump_base_path (slave, ctx->path);
+	g_assert_no_error (err);
+	err = pagesums_compute (ctx->fd, SQLX_DIFF_PAGES_PER_RANGE, &sums);
+	g_assert_no_error (err);
+	restore_ctx_clear (&ctx);
+
+	_populate (master, 0, 20000);
+
+	err = sqlx_repository_dump_base_diff (master, sums->data, sums->len,
+			SQLX_DUMP_CHUNK_SIZE, _apply, NULL);
+	g_assert_nonnull (err);
+	g_assert_cmpint (err->code, ==, CODE_PIPEFROM);
+	g_clear_error (&err);
+	g_byte_array_free (sums, TRUE);
+	sums = NULL;
+
+	/* A slave a few pages behind only receives these pages */
+	err = sqlx_repository_backup_base (master, slave);
+	g_assert_no_error (err);
+	_populate (master, 20000, 10);
+	g_assert_cmpint (_count (master), ==, 20010);
+	g_assert_cmpint (_count (slave), ==, 20000);
+
+	err = restore_ctx_create ("/tmp/test-sqliterepo-diff.XXXXXX", &ctx);
+	g_assert_no_error (err);
+	err = sqlx_repository_dump_base_path (slave, ctx->path);
+	g_assert_no_error (err);
+	err = pagesums_compute (ctx->fd, SQLX_DIFF_PAGES_PER_RANGE, &sums);
+	g_assert_no_error (err);
+
+	err = sqlx_repository_dump_base_diff (master, sums->data, sums->len,
+			SQLX_DUMP_CHUNK_SIZE, _apply, NULL);
+	g_assert_no_error (err);
+	err = sqlx_repository_dump_base_gba (master, &full);
+	g_assert_no_error (err);
+	GRID_DEBUG("diff: %u+%"G_GUINT64_FORMAT" bytes, full: %u bytes",
+			sums->len, diff_bytes, full->len);
+	g_assert_cmpuint (sums->len + diff_bytes, <, full->len / 4);
+
+	err = sqlx_repository_restore_from_file (slave, ctx->path);
+	g_assert_no_error (err);
+	g_assert_cmpint (_count (slave), ==, 20010);
+
+	restore_ctx_clear (&ctx);
+	g_byte_array_free (sums, TRUE);
+	g_byte_array_free (full, TRUE);
+	err = sqlx_repository_unlock_and_close(slave);
+	g_assert_no_error (err);
+	err = sqlx_repository_unlock_and_close(master);
+	g_assert_no_error (err);
+	sqlx_repository_clean(repo);
+}
+
+static void
+_round_dump_restore (void)
+{
+	sqlx_repository_t *repo = NULL;
+	struct sqlx_sqlite3_s *master = NULL, *slave = NULL;
+	GByteArray *dump = NULL;
+	GError *err;
+
+	err = sqlx_repository_init("/tmp", NULL, &repo);
+	g_assert_no_error (err);
+	err = sqlx_repository_configure_type(repo, type, SCHEMA);
+	g_assert_no_error (err);
+	sqlx_repository_set_locator (repo, _locator, NULL);
+
+	struct sqlx_name_s n0 = { .base = name, .type = type, .ns = nsname, };
+	struct sqlx_name_s n1 = { .base = name_peer, .type = type, .ns = nsname, };
+	err = sqlx_repository_open_and_lock(repo, &n0, SQLX_OPEN_LOCAL, &master, NULL);
+	g_assert_no_error (err);
+	err = sqlx_repository_open_and_lock(repo, &n1, SQLX_OPEN_LOCAL, &slave, NULL);
+	g_assert_no_error (err);
+
+	_populate (master, 0, 1000);
+	err = sqlx_repository_dump_base_gba (master, &dump);
+	g_assert_no_error (err);
+	g_assert_nonnull (dump);
+	err = sqlx_repository_restore_base (slave, dump->data, dump->len);
+	g_assert_no_error (err);
+	g_assert_cmpint (_count (slave), ==, 1000);
+	g_byte_array_free (dump, TRUE);
+
+	err = sqlx_repository_unlock_and_close(slave);
+	g_assert_no_error (err);
+	err = sqlx_repository_unlock_and_close(master);
+	g_assert_no_error (err);
+	sqlx_repository_clean(repo);
+}
+
+static void
+test_dump_restore (void)
+{
+	const gint64 max = oio_sqlx_dump_max_memory;
+	/* in memory */
+	_round_dump_restore ();
+	/* through temporary files */
+	oio_sqlx_dump_max_memory = 1;
+	_round_dump_restore ();
+	oio_sqlx_dump_max_memory = max;
+}
+
+static void
+_round_wire(const guint8 *raw, gsize len)
+{
+	GByteArray *decoded = NULL;
+	GByteArray *encoded = sqlx_compress_encode(raw, len);
+	GError *err = sqlx_compress_decode(encoded->data, encoded->len, &decoded);
+	g_assert_no_error (err);
+	g_assert_cmpuint (decoded->len, ==, len);
+	g_assert_true (0 == memcmp(decoded->data, raw, len));
+	g_byte_array_free (decoded, TRUE);
+
+	/* Any altered byte must be detected */
+	if (len > 0) {
+		encoded->data[encoded->len - 1] ^= 0x5A;
+		decoded = NULL;
+		err = sqlx_compress_decode(encoded->data, encoded->len, &decoded);
+		g_assert_nonnull (err);
+		g_assert_cmpint (err->code, ==, CODE_BAD_REQUEST);
+		g_assert_null (decoded);
+		g_clear_error (&err);
+
+		/* and a truncated payload too */
+		err = sqlx_compress_decode(encoded->data, encoded->len - 1, &decoded);
+		g_assert_nonnull (err);
+		g_clear_error (&err);
+	}
+	g_byte_array_free (encoded, TRUE);
+}
+
+static void
+test_wire (void)
+{
+	/* compressible, on several blocks */
+	const gsize len = 3 * SQLX_COMPRESS_BLOCK + 17;
+	guint8 *raw = g_malloc0 (len);
+	for (gsize i = 0; i < len; i += 64)
+		raw[i] = i % 251;
+	_round_wire (raw, len);
+
+	/* not compressible, stored as is */
+	for (gsize i = 0; i < len; ++i)
+		raw[i] = g_random_int_range (0, 256);
+	_round_wire (raw, len);
+
+	_round_wire (raw, 0);
+	g_free (raw);
+}
+
 int
 main(int argc, char **argv)
 {
 	HC_TEST_INIT(argc,argv);
 	g_test_add_func("/sqliterepo/init", test_init);
 	g_test_add_func("/sqliterepo/open", test_open_close);
+	g_test_add_func("/sqliterepo/dump", test_dump_restore);
+	g_test_add_func("/sqliterepo/diff", test_diff);
+	g_test_add_func("/sqliterepo/wire", test_wire);
 	return g_test_run();
 }
 
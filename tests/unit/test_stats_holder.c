@@ -19,6 +19,7 @@ License along with this library.
 
 #include "metautils/lib/metautils.h"
 #include "server/stats_holder.h"
+#include "server/network_server.h"
 #include <glib.h>
 
 #undef GQ
@@ -42,11 +43,98 @@ test_rrd (void)
 		_round_rrd ();
 }
 
+static void
+test_histogram (void)
+{
+	guint prev = 0;
+	for (guint64 v=0; v < (1ULL<<40) ;v += 1 + v/7) {
+		const guint b = grid_histogram_bucket(v);
+		g_assert_cmpuint(b, >=, prev);
+		g_assert_cmpuint(b, <, GRID_HISTOGRAM_BUCKETS);
+		const guint64 hi = grid_histogram_value(b);
+		g_assert_cmpuint(hi, >=, v);
+		g_assert_cmpuint(hi - v, <=, v / 8);
+		prev = b;
+	}
+
+	/* the overflow bucket is only for the values beyond the range */
+	const guint64 top = (1ULL<<40) - 1;
+	g_assert_cmpuint(grid_histogram_bucket(top), ==, GRID_HISTOGRAM_BUCKETS - 2);
+	g_assert_cmpuint(grid_histogram_value(grid_histogram_bucket(top)), ==, top);
+	g_assert_cmpuint(grid_histogram_bucket(1ULL<<40), ==, GRID_HISTOGRAM_BUCKETS - 1);
+	g_assert_cmpuint(grid_histogram_bucket(G_MAXUINT64), ==, GRID_HISTOGRAM_BUCKETS - 1);
+	g_assert_cmpuint(grid_histogram_value(GRID_HISTOGRAM_BUCKETS - 1), ==, G_MAXUINT64);
+
+	guint64 buckets[GRID_HISTOGRAM_BUCKETS] = {0};
+	g_assert_cmpuint(grid_histogram_quantile(buckets, 0.5), ==, 0);
+	for (guint64 v=1; v<=1000 ;++v)
+		buckets[grid_histogram_bucket(v)] ++;
+	const guint64 p50 = grid_histogram_quantile(buckets, 0.5);
+	const guint64 p99 = grid_histogram_quantile(buckets, 0.99);
+	g_assert_cmpuint(p50, >=, 500);
+	g_assert_cmpuint(p50, <=, 500 + 500/8);
+	g_assert_cmpuint(p99, >=, 990);
+	g_assert_cmpuint(p99, <=, 990 + 990/8);
+}
+
+static guint64
+_stat_get (GArray *stats, const char *name)
+{
+	const GQuark which = g_quark_from_string(name);
+	for (guint i=0; i<stats->len ;++i) {
+		struct server_stat_s *st = &g_array_index(stats, struct server_stat_s, i);
+		if (st->which == which)
+			return st->value;
+	}
+	g_assert_not_reached();
+	return 0;
+}
+
+static void
+test_request_stats (void)
+{
+	struct network_server_s *srv = network_server_init();
+	const GQuark gq_count = g_quark_from_static_string("counter req.hits.TEST");
+	const GQuark gq_time = g_quark_from_static_string("counter req.time.TEST");
+
+	gpointer _run (gpointer p) {
+		for (guint i=1; i<=1000 ;++i)
+			network_server_stat_request(p, gq_count, gq_time, i);
+		return NULL;
+	}
+
+	/* more threads than blocks at once, so that some are reused */
+	for (guint round=0; round<2 ;++round) {
+		GThread *th[4];
+		for (guint i=0; i<4 ;++i)
+			th[i] = g_thread_new("stats", _run, srv);
+		for (guint i=0; i<4 ;++i)
+			g_thread_join(th[i]);
+	}
+
+	GArray *stats = network_server_stat_getall(srv);
+	g_assert_cmpuint(_stat_get(stats, "counter req.hits.TEST"), ==, 8000);
+	g_assert_cmpuint(_stat_get(stats, "counter req.time.TEST"), ==, 8 * 500500);
+	g_assert_cmpuint(_stat_get(stats, "counter req.hits"), >=, 8000);
+	const guint64 p50 = _stat_get(stats, "gauge req.time.TEST.p50");
+	const guint64 p999 = _stat_get(stats, "gauge req.time.TEST.p999");
+	g_assert_cmpuint(p50, >=, 500);
+	g_assert_cmpuint(p50, <=, 500 + 500/8);
+	g_assert_cmpuint(p999, >=, 999);
+	g_array_free(stats, TRUE);
+
+	g_assert_cmpuint(network_server_stat_getone(srv, gq_count), ==, 8000);
+
+	network_server_clean(srv);
+}
+
 int
 main (int argc, char **argv)
 {
 	HC_TEST_INIT(argc,argv);
 	g_test_add_func("/server/rrd", test_rrd);
+	g_test_add_func("/server/histogram", test_histogram);
+	g_test_add_func("/server/requests", test_request_stats);
 	return g_test_run();
 }
 
@@ -33,14 +33,18 @@ _init_ns (struct namespace_info_s *ni)
 					"\"dupli3\":\"NONE:DUPLI3:NONE\","
 					"\"classic\":\"NONE:DUPONETWO:NONE\","
 					"\"polcheck\":\"NONE:DUPONETHREE:SIMCOMP\","
-					"\"secure\":\"NONE:DUP_SECURE:NONE\""
+					"\"secure\":\"NONE:DUP_SECURE:NONE\","
+					"\"fast\":\"NONE:DUPFAST:NONE\","
+					"\"rainfast\":\"NONE:RAINFAST:NONE\""
 				"},"
 				"\"data_security\":{"
 					"\"DUPLI3\":\"DUP:distance=0|nb_copy=3\","
 					"\"RAIN32\":\"RAIN:distance=0|k=3|m=2\","
 					"\"DUPONETWO\":\"DUP:distance=1|nb_copy=2\","
 					"\"DUPONETHREE\":\"DUP:distance=1|nb_copy=3\","
-					"\"DUP_SECURE\":\"DUP:distance=4|nb_copy=2\""
+					"\"DUP_SECURE\":\"DUP:distance=4|nb_copy=2\","
+					"\"DUPFAST\":\"DUP:distance=1|nb_copy=2|hash=xxh64\","
+					"\"RAINFAST\":\"RAIN:distance=0|k=3|m=2|algo=liber8tion|hash=sha256\""
 				"},"
 				"\"data_treatments\":{"
 					"\"SIMCOMP\":\"COMP:algo=ZLIB|blocksize=262144\""
@@ -112,6 +116,32 @@ test_stgclass_with_fallback ()
 	namespace_info_clear(&ni);
 }
 
+static void
+_check_chunk_method (struct namespace_info_s *ni, const char *pol,
+		const char *expected)
+{
+	struct storage_policy_s *sp = storage_policy_init(ni, pol);
+	g_assert(sp != NULL);
+	GString *method = storage_policy_to_chunk_method(sp);
+	g_assert_cmpstr(method->str, ==, expected);
+	g_string_free(method, TRUE);
+	storage_policy_clean(sp);
+}
+
+static void
+test_chunk_method_hash ()
+{
+	struct namespace_info_s ni;
+	_init_ns(&ni);
+
+	_check_chunk_method(&ni, "classic", "plain/bytes");
+	_check_chunk_method(&ni, "fast", "plain/bytes?hash=xxh64");
+	_check_chunk_method(&ni, "rainfast",
+			"plain/rain?algo=liber8tion&k=3&m=2&hash=sha256");
+
+	namespace_info_clear(&ni);
+}
+
 #if 0
 static void
 test_datasec ()
@@ -133,6 +163,7 @@ main(int argc, char **argv)
 	g_test_add_func("/metautils/stgclass/not_found", test_stgclass_not_found);
 	g_test_add_func("/metautils/stgclass/with_fallback", test_stgclass_with_fallback);
 	g_test_add_func("/metautils/stgclass/no_fallback", test_stgclass_no_fallback);
+	g_test_add_func("/metautils/stgpol/chunk_method", test_chunk_method_hash);
 #if 0
 	g_test_add_func("/metautils/datasec", test_datasec);
 	g_test_add_func("/metautils/stgpol", test_stgpol);
@@ -364,40 +364,10 @@ path=${RUNDIR}/agent.sock
 """
 
 template_conscience = """
-[General]
-to_op=1000
-to_cnx=1000
-
-flag.NOLINGER=true
-flag.SHUTDOWN=false
-flag.KEEPALIVE=false
-flag.QUICKACK=false
-
 [Server.conscience]
-min_workers=2
-min_spare_workers=2
-max_spare_workers=10
-max_workers=10
 listen=${IP}:${PORT}
-plugins=conscience,stats,ping,fallback
-
-[Service]
-namespace=${NS}
-type=conscience
-register=false
-load_ns_info=false
-
-[Plugin.ping]
-path=${LIBDIR}/grid/msg_ping.so
-
-[Plugin.stats]
-path=${LIBDIR}/grid/msg_stats.so
-
-[Plugin.fallback]
-path=${LIBDIR}/grid/msg_fallback.so
 
 [Plugin.conscience]
-path=${LIBDIR}/grid/msg_conscience.so
 param_namespace=${NS}
 param_chunk_size=${CHUNK_SIZE}
 
@@ -515,7 +485,7 @@ group=${NS},localhost,conscience,${IP}:${PORT}
 on_die=respawn
 enabled=true
 start_at_boot=true
-command=${EXE_PREFIX}-daemon -q -s OIO,${NS},conscience ${CFGDIR}/${NS}-conscience.conf
+command=${EXE_PREFIX}-conscience -q -s OIO,${NS},conscience ${CFGDIR}/${NS}-conscience.conf
 
 [service.${NS}-event-agent]
 group=${NS},localhost,event